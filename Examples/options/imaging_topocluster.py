@@ -4,7 +4,7 @@ from Gaudi.Configuration import *
 from GaudiKernel import SystemOfUnits as units
 
 from GaudiKernel.DataObjectHandleBase import DataObjectHandleBase
-from Configurables import ApplicationMgr, EICDataSvc, PodioOutput, GeoSvc
+from Configurables import ApplicationMgr, EICDataSvc, PodioOutput, GeoSvc, RandomSvc
 
 from Configurables import PodioInput
 from Configurables import Jug__Base__InputCopier_dd4pod__Geant4ParticleCollection_dd4pod__Geant4ParticleCollection_ as MCCopier
@@ -81,7 +81,7 @@ ApplicationMgr(
     TopAlg=[podioinput, copier, calcopier, imcaldigi, imcalreco, imcalcluster, clusterreco, out],
     EvtSel='NONE',
     EvtMax=kwargs['nev'],
-    ExtSvc=[podioevent],
+    ExtSvc=[podioevent, RandomSvc("RandomSvc", seed=1)],
     OutputLevel=DEBUG
 )
 
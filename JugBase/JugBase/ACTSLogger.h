@@ -4,95 +4,103 @@
 #ifndef RECTRACKER_ACTSLOGGER_H
 #define RECTRACKER_ACTSLOGGER_H
 
+#include <memory>
+#include <string>
+
 #include <Acts/Utilities/Logger.hpp>
-#include <GaudiKernel/ServiceHandle.h>
 #include <GaudiKernel/IMessageSvc.h>
-#include <GaudiKernel/MsgStream.h>
 
-/** Filter
- *
- * \ingroup base
- */
-class GaudiFilterPolicy : public Acts::Logging::OutputFilterPolicy {
-public:
-  GaudiFilterPolicy(IMessageSvc* owner) : m_owner(owner) {}
+namespace Jug {
 
-  bool doPrint(const Acts::Logging::Level& lvl) const {
-    
-    MSG::Level l = MSG::VERBOSE;
+  /// Gaudi message level of an ACTS logging level
+  inline MSG::Level gaudiLevel(Acts::Logging::Level lvl) {
     switch (lvl) {
     case Acts::Logging::VERBOSE:
-      l = MSG::VERBOSE;
-      break;
+      return MSG::VERBOSE;
     case Acts::Logging::DEBUG:
-      l = MSG::DEBUG;
-      break;
+      return MSG::DEBUG;
     case Acts::Logging::INFO:
-      l = MSG::INFO;
-      break;
+      return MSG::INFO;
     case Acts::Logging::WARNING:
-      l = MSG::WARNING;
-      break;
+      return MSG::WARNING;
     case Acts::Logging::ERROR:
-      l = MSG::ERROR;
-      break;
+      return MSG::ERROR;
     case Acts::Logging::FATAL:
-      l = MSG::FATAL;
-      break;
-     case Acts::Logging::MAX:
-      l = MSG::VERBOSE;
-      break;
+      return MSG::FATAL;
+    default:
+      return MSG::VERBOSE;
     }
+  }
 
-    return l >= m_owner->outputLevel();
+  /// ACTS logging level of a Gaudi message level
+  inline Acts::Logging::Level actsLevel(MSG::Level lvl) {
+    switch (lvl) {
+    case MSG::NIL:
+    case MSG::VERBOSE:
+      return Acts::Logging::VERBOSE;
+    case MSG::DEBUG:
+      return Acts::Logging::DEBUG;
+    case MSG::INFO:
+      return Acts::Logging::INFO;
+    case MSG::WARNING:
+      return Acts::Logging::WARNING;
+    case MSG::ERROR:
+      return Acts::Logging::ERROR;
+    default:
+      return Acts::Logging::FATAL;
+    }
   }
 
+} // namespace Jug
+
+/** Filter
+ *
+ *  Compares with the output level of the owner, fixed at the construction of the logger, so that
+ *  the messages below it are dropped by the ACTS logging macros before they are formatted.
+ *
+ * \ingroup base
+ */
+class GaudiFilterPolicy : public Acts::Logging::OutputFilterPolicy {
+public:
+  GaudiFilterPolicy(MSG::Level threshold) : m_threshold(threshold) {}
+
+  bool doPrint(const Acts::Logging::Level& lvl) const { return Jug::gaudiLevel(lvl) >= m_threshold; }
+
 private:
-  IMessageSvc* m_owner;
+  MSG::Level m_threshold;
 };
 
+/** Print
+ *
+ *  Reports the message formatted by ACTS to the message service under the name of the owner,
+ *  directly instead of through a MsgStream (shared by the threads, and formatting it once more).
+ *
+ * \ingroup base
+ */
 class GaudiPrintPolicy : public Acts::Logging::OutputPrintPolicy {
 public:
-  GaudiPrintPolicy(IMessageSvc* owner) : m_messenger(owner) {}
+  GaudiPrintPolicy(IMessageSvc* owner, std::string name = "") : m_owner(owner), m_name(std::move(name)) {}
 
-  void setName(std::string name) {
-    m_name = name;
-
-  }
+  void setName(std::string name) { m_name = std::move(name); }
 
   void flush(const Acts::Logging::Level& lvl, const std::string& input) {
-    MSG::Level l = MSG::VERBOSE;
-    switch (lvl) {
-    case Acts::Logging::VERBOSE:
-      l = MSG::VERBOSE;
-      break;
-    case Acts::Logging::DEBUG:
-      l = MSG::DEBUG;
-      break;
-    case Acts::Logging::INFO:
-      l = MSG::INFO;
-      break;
-    case Acts::Logging::WARNING:
-      l = MSG::WARNING;
-      break;
-    case Acts::Logging::ERROR:
-      l = MSG::ERROR;
-      break;
-    case Acts::Logging::FATAL:
-      l = MSG::FATAL;
-      break;
-     case Acts::Logging::MAX:
-      l = MSG::VERBOSE;
-      break;
-    }
-
-    m_messenger << l << m_name << "\t" << input << endmsg;
+    m_owner->reportMessage(m_name, Jug::gaudiLevel(lvl), input);
   }
 
 private:
   IMessageSvc* m_owner;
-  MsgStream m_messenger;
   std::string m_name;
 };
 
+namespace Jug {
+
+  /** ACTS logger of a Gaudi component, to be made once (in initialize) and kept.
+   *
+   *  The messages are reported to msgSvc under name, those below level (the output level of the
+   *  component) are not formatted.
+   */
+  std::unique_ptr<const Acts::Logger> makeActsLogger(const std::string& name, IMessageSvc* msgSvc, MSG::Level level);
+
+} // namespace Jug
+
 #endif  // RECTRACKER_ACTSLOGGER_H
@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_ACTS_COARSEMATERIALDECORATOR_HPP
+#define JUGBASE_ACTS_COARSEMATERIALDECORATOR_HPP
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include "Acts/Material/IMaterialDecorator.hpp"
+#include "Acts/Material/ISurfaceMaterial.hpp"
+
+namespace Jug::Base {
+
+  /** Material decorator that rebins the surface material of another decorator (the material map)
+   *
+   *  The binned surface material of the map is merged into at most bins[0] x bins[1] bins over the
+   *  same range (equidistant binnings only, the others are kept), each coarse bin the average of its
+   *  bins: the mean thickness, and the material of the same radiation and interaction lengths per
+   *  thickness. A binning of 1 x 1 makes homogeneous material of the surface. The volume material
+   *  is kept. Fewer bins make the material lookups of the propagation cheaper and the material
+   *  updates of the fits follow the coarse structure only.
+   */
+  class CoarseMaterialDecorator : public Acts::IMaterialDecorator {
+  public:
+    CoarseMaterialDecorator(std::shared_ptr<const Acts::IMaterialDecorator> decorator, std::array<size_t, 2> bins)
+        : m_decorator(std::move(decorator)), m_bins(bins) {}
+
+    void decorate(Acts::Surface& surface) const final;
+
+    void decorate(Acts::TrackingVolume& volume) const final { m_decorator->decorate(volume); }
+
+    /// Surface material of at most bins[0] x bins[1] bins, the material itself if it is not rebinned
+    std::shared_ptr<const Acts::ISurfaceMaterial>
+    coarsen(const std::shared_ptr<const Acts::ISurfaceMaterial>& material) const;
+
+  private:
+    std::shared_ptr<const Acts::IMaterialDecorator> m_decorator;
+    std::array<size_t, 2> m_bins;
+  };
+
+} // namespace Jug::Base
+
+#endif
@@ -1,28 +1,204 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_ALGORITHM_H
+#define JUGBASE_ALGORITHM_H
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "JugBase/Validation.h"
+
+namespace dd4hep {
+  class Detector;
+}
+
 namespace Jug {
 
-  class Algorithm {
-  private:
-    std::string m_name;
+  /// Collections read by an algorithm, passed to execute as a tuple of const references
+  template <class... T> struct Input {
+    using type = std::tuple<const T&...>;
+    static constexpr size_t size = sizeof...(T);
+  };
+  /// Collections made by an algorithm, returned by execute as a tuple of values
+  template <class... T> struct Output {
+    using type = std::tuple<T...>;
+    static constexpr size_t size = sizeof...(T);
+  };
+
+  /// Per-event information given by the framework
+  struct AlgorithmContext {
+    uint64_t event{0};
+    /// Key of the random number streams of the algorithm in the event (Jug::Base::Random::Stream)
+    uint64_t randomKey{0};
+  };
+
+  enum class LogLevel { kDebug = 0, kInfo, kWarning, kError };
 
-    static std::function<std::ostream&()> m_info;
-    static std::function<std::ostream&()> m_error;
+  /// Message of an algorithm, sent to its sink when complete (a trailing newline is dropped)
+  class LogMessage {
+  public:
+    using Sink = std::function<void(LogLevel, const std::string&)>;
+
+    LogMessage(const Sink* sink, LogLevel level) : m_sink(sink), m_level(level) {}
+    LogMessage(const LogMessage&) = delete;
+    LogMessage& operator=(const LogMessage&) = delete;
+    ~LogMessage() {
+      if (m_sink == nullptr) {
+        return;
+      }
+      auto msg = m_stream.str();
+      if (!msg.empty() && msg.back() == '\n') {
+        msg.pop_back();
+      }
+      (*m_sink)(m_level, msg);
+    }
 
-    static void SetInfo(std::function<std::ostream&()> info) {
-      m_info = info;
+    template <class T> LogMessage& operator<<(const T& value) {
+      if (m_sink != nullptr) {
+        m_stream << value;
+      }
+      return *this;
     }
-    static void SetError(std::function<std::ostream&()> error) {
-      m_error = error;
+    LogMessage& operator<<(std::ostream& (*manip)(std::ostream&)) {
+      if (m_sink != nullptr) {
+        m_stream << manip;
+      }
+      return *this;
     }
 
+  private:
+    const Sink* m_sink;
+    LogLevel m_level;
+    std::ostringstream m_stream;
+  };
+
+  /** Framework-independent algorithm.
+   *
+   *  Holds the name, the names of the input and output collections, the properties (registered
+   *  by Jug::Property, by reference, for the framework to set them before initialize) and the
+   *  logging of an algorithm. Messages go to std::cout and std::cerr until the framework sets a
+   *  sink. The algorithms keep no per-event state, see Jug::Algorithm.
+   */
+  class AlgorithmBase {
   public:
-    Algorithm(const std::string& name)
-    : m_name ( name ) {
+    /// Types of the properties that a framework can set
+    using PropertyRef =
+        std::variant<bool*, int*, unsigned int*, uint64_t*, double*, std::string*, std::vector<int>*,
+                     std::vector<double>*, std::vector<std::string>*, std::vector<std::pair<double, double>>*>;
+
+    AlgorithmBase(std::string name, std::vector<std::string> inputNames, std::vector<std::string> outputNames)
+        : m_name(std::move(name)), m_inputNames(std::move(inputNames)), m_outputNames(std::move(outputNames)) {
+      m_sink = [this](LogLevel level, const std::string& msg) {
+        (level >= LogLevel::kWarning ? std::cerr : std::cout) << m_name << ": " << msg << std::endl;
+      };
     }
+    // the properties are registered by address
+    AlgorithmBase(const AlgorithmBase&) = delete;
+    AlgorithmBase& operator=(const AlgorithmBase&) = delete;
+    virtual ~AlgorithmBase() = default;
+
+    const std::string& name() const { return m_name; }
+    const std::vector<std::string>& inputNames() const { return m_inputNames; }
+    const std::vector<std::string>& outputNames() const { return m_outputNames; }
+    /// Name of the random streams of the algorithm, shared by the algorithms that draw the same numbers
+    virtual const std::string& randomName() const { return m_name; }
+
+    const std::map<std::string, PropertyRef>& properties() const { return m_properties; }
+    void registerProperty(const std::string& name, PropertyRef value) { m_properties[name] = value; }
+
+    void setLogSink(LogMessage::Sink sink) { m_sink = std::move(sink); }
+    void setLogLevel(LogLevel level) { m_level = level; }
+
+    /// Setup after the properties are set, the detector is nullptr without geometry
+    virtual bool initialize(const dd4hep::Detector* /* detector */) { return true; }
 
   protected:
-    static std::ostream& info() { return m_info(); };
-    static std::ostream& error() { return m_error(); };
+    bool msgLevel(LogLevel level) const { return level >= m_level; }
+    LogMessage debug() const { return log(LogLevel::kDebug); }
+    LogMessage info() const { return log(LogLevel::kInfo); }
+    LogMessage warning() const { return log(LogLevel::kWarning); }
+    LogMessage error() const { return log(LogLevel::kError); }
+
+  private:
+    LogMessage log(LogLevel level) const { return {msgLevel(level) ? &m_sink : nullptr, level}; }
+
+    std::string m_name;
+    std::vector<std::string> m_inputNames;
+    std::vector<std::string> m_outputNames;
+    std::map<std::string, PropertyRef> m_properties;
+    LogMessage::Sink m_sink;
+    LogLevel m_level{LogLevel::kInfo};
+  };
+
+  /** Framework-independent algorithm with typed inputs and outputs.
+   *
+   *  execute is const and reentrant: it reads the inputs of one event and returns its outputs by
+   *  value, so that any framework (or a benchmark) can run it on several events concurrently.
+   *  Random numbers are drawn from the streams of context.randomKey, set usesRandom for the
+   *  framework to provide them. Jug::AlgorithmAdaptor runs an algorithm in Gaudi.
+   *
+   *  An algorithm with an optimized execute can keep the former implementation as its reference
+   *  (hasReference and executeReference, with the same random streams), and compare the outputs
+   *  of both, by default the sizes of the collections. The frameworks run the reference in their
+   *  validation mode only, and report the mismatches.
+   */
+  template <class InputType, class OutputType> class Algorithm : public AlgorithmBase {
+  public:
+    using InputTypes  = InputType;
+    using OutputTypes = OutputType;
+    using Input       = typename InputType::type;
+    using Output      = typename OutputType::type;
 
+    /// The algorithm draws random numbers from the streams of the context
+    static constexpr bool usesRandom = false;
+
+    Algorithm(std::string name, const std::array<std::string, InputType::size>& inputNames,
+              const std::array<std::string, OutputType::size>& outputNames)
+        : AlgorithmBase(std::move(name), {inputNames.begin(), inputNames.end()},
+                        {outputNames.begin(), outputNames.end()}) {}
+
+    virtual Output execute(const Input& input, const AlgorithmContext& context) const = 0;
+
+    /// The algorithm has a reference implementation for the validation of execute
+    virtual bool hasReference() const { return false; }
+    virtual Output executeReference(const Input& input, const AlgorithmContext& context) const {
+      return execute(input, context);
+    }
+    /// Compare the outputs of the reference and of execute
+    virtual void compare(const Output& reference, const Output& optimized, ValidationReport& report) const {
+      compareSizes(reference, optimized, report, std::make_index_sequence<OutputType::size>{});
+    }
+
+  private:
+    template <class T, class = void> struct HasSize : std::false_type {};
+    template <class T> struct HasSize<T, std::void_t<decltype(std::declval<const T&>().size())>> : std::true_type {};
+
+    template <size_t... I>
+    void compareSizes(const Output& reference, const Output& optimized, ValidationReport& report,
+                      std::index_sequence<I...> /* outputs */) const {
+      (
+          [&] {
+            using T = std::tuple_element_t<I, Output>;
+            if constexpr (HasSize<T>::value) {
+              report.collection(outputNames()[I]);
+              report.size(std::get<I>(reference).size(), std::get<I>(optimized).size());
+            }
+          }(),
+          ...);
+    }
   };
 
 } // namespace Jug
+
+#endif
@@ -0,0 +1,232 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_ALGORITHMADAPTOR_H
+#define JUGBASE_ALGORITHMADAPTOR_H
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "Gaudi/Accumulators.h"
+#include "Gaudi/Algorithm.h"
+#include "Gaudi/Property.h"
+#include "GaudiKernel/GaudiException.h"
+#include "GaudiKernel/IRndmEngine.h"
+#include "GaudiKernel/IRndmGenSvc.h"
+
+#include "JugBase/Algorithm.h"
+#include "JugBase/DataHandle.h"
+#include "JugBase/IGeoSvc.h"
+#include "JugBase/IRandomSvc.h"
+#include "JugBase/Utilities/Philox.h"
+#include "JugBase/Validation.h"
+
+namespace Jug {
+
+template <class Algo, class In = typename Algo::InputTypes, class Out = typename Algo::OutputTypes>
+class AlgorithmAdaptor;
+
+/** Gaudi algorithm running a framework-independent Jug::Algorithm.
+ *
+ *  The properties of the algorithm are declared as Gaudi properties (by reference, so that the
+ *  job options set them directly), its inputs and outputs as DataHandles with the names of the
+ *  algorithm as keys and default locations, and its messages go to the MsgStream. The detector
+ *  of GeoSvc is given to initialize if the service exists, and the event key of RandomSvc to
+ *  execute for the algorithms that use random numbers. The outputs returned by execute are
+ *  moved into the store. The jobs that only configure the seeds of RndmGenSvc (the service of
+ *  the algorithms before the port) keep them: RandomSvc is then seeded from its engine. The
+ *  DataHandles keep no per-event state, so that the events of all slots run concurrently.
+ *  Components that give the algorithm more than its properties (e.g. the
+ *  tables of services) derive from the adaptor and override setup.
+ *
+ *  With validationMode, the reference implementation of an algorithm that has one also runs on
+ *  every event, and its outputs are compared with those of execute (within the validation
+ *  tolerances); the mismatches are reported as warnings and counted. Only execute runs without.
+ *
+ *      DECLARE_COMPONENT_WITH_ID(Jug::AlgorithmAdaptor<Jug::Digi::CalorimeterHitDigi>,
+ *                                "Jug::Digi::CalorimeterHitDigi")
+ *
+ * \ingroup base
+ */
+template <class Algo, class... In, class... Out>
+class AlgorithmAdaptor<Algo, Input<In...>, Output<Out...>> : public Gaudi::Algorithm {
+public:
+  AlgorithmAdaptor(const std::string& name, ISvcLocator* svcLoc)
+      : Gaudi::Algorithm(name, svcLoc)
+      , m_algo(name)
+      , m_inputs{makeHandles<In...>(m_algo.inputNames(), Gaudi::DataHandle::Reader, std::index_sequence_for<In...>{})}
+      , m_outputs{makeHandles<Out...>(m_algo.outputNames(), Gaudi::DataHandle::Writer,
+                                      std::index_sequence_for<Out...>{})} {
+    for (const auto& [key, value] : m_algo.properties()) {
+      std::visit([this, &key = key](auto* ref) { declareProperty(key, *ref); }, value);
+    }
+  }
+
+  StatusCode initialize() override {
+    if (Gaudi::Algorithm::initialize().isFailure()) {
+      return StatusCode::FAILURE;
+    }
+    m_algo.setLogSink([this](LogLevel level, const std::string& msg) {
+      switch (level) {
+      case LogLevel::kDebug:
+        debug() << msg << endmsg;
+        break;
+      case LogLevel::kInfo:
+        info() << msg << endmsg;
+        break;
+      case LogLevel::kWarning:
+        warning() << msg << endmsg;
+        break;
+      default:
+        error() << msg << endmsg;
+        break;
+      }
+    });
+    m_algo.setLogLevel(msgLevel(MSG::DEBUG) ? LogLevel::kDebug : LogLevel::kInfo);
+
+    const dd4hep::Detector* detector = nullptr;
+    SmartIF<IGeoSvc> geoSvc          = service(m_geoSvcName, false);
+    if (geoSvc) {
+      detector = geoSvc->detector();
+    }
+    if constexpr (Algo::usesRandom) {
+      seedFromRndmGenSvc();
+      m_randomSvc = service(m_randomSvcName);
+      if (!m_randomSvc) {
+        error() << "Unable to locate Random Service. "
+                << "Make sure you have RandomSvc in the configuration." << endmsg;
+        return StatusCode::FAILURE;
+      }
+    }
+    if (setup(m_algo).isFailure()) {
+      return StatusCode::FAILURE;
+    }
+    if (m_validationMode.value()) {
+      if (m_algo.hasReference()) {
+        info() << "Validation mode: the reference implementation runs on every event" << endmsg;
+      } else {
+        warning() << "Validation mode without a reference implementation, nothing to validate" << endmsg;
+      }
+    }
+    return m_algo.initialize(detector) ? StatusCode::SUCCESS : StatusCode::FAILURE;
+  }
+
+  StatusCode execute(const EventContext& ctx) const final {
+    return transform(ctx, std::index_sequence_for<In...>{}, std::index_sequence_for<Out...>{});
+  }
+
+  const Algo& algorithm() const { return m_algo; }
+
+protected:
+  /// Setup of the algorithm beyond its properties, before its initialize
+  virtual StatusCode setup(Algo& /* algo */) { return StatusCode::SUCCESS; }
+
+private:
+  /// Seed of RandomSvc from the engine of RndmGenSvc, for the jobs that configure RndmGenSvc
+  /// and not RandomSvc; set before the first use makes RandomSvc
+  void seedFromRndmGenSvc() {
+    if (SmartIF<IRandomSvc> existing = service(m_randomSvcName, false); existing) {
+      return;
+    }
+    auto& options         = serviceLocator()->getOptsSvc();
+    const std::string key = m_randomSvcName.value() + ".seed";
+    if (options.isSet(key)) {
+      return;
+    }
+    const auto items   = options.items();
+    const bool rndmGen = std::any_of(items.begin(), items.end(),
+                                     [](const auto& item) { return std::get<0>(item).rfind("RndmGenSvc.", 0) == 0; });
+    if (!rndmGen) {
+      return;
+    }
+    SmartIF<IRndmGenSvc> rndmGenSvc = service("RndmGenSvc");
+    std::vector<long> seeds;
+    if (!rndmGenSvc || !rndmGenSvc->engine() || rndmGenSvc->engine()->seeds(seeds).isFailure() || seeds.empty()) {
+      warning() << "No seeds from RndmGenSvc, " << m_randomSvcName.value() << " keeps its default seed" << endmsg;
+      return;
+    }
+    uint64_t seed = 0;
+    for (const long s : seeds) {
+      seed = Jug::Base::Random::mix64(seed ^ static_cast<uint64_t>(s));
+    }
+    options.set(key, std::to_string(seed));
+    info() << m_randomSvcName.value() << " is not configured, seeded from the RndmGenSvc seeds (" << seed << ")"
+           << endmsg;
+  }
+
+  template <typename... T, size_t... I>
+  std::tuple<std::unique_ptr<DataHandle<T>>...> makeHandles(const std::vector<std::string>& keys,
+                                                            Gaudi::DataHandle::Mode mode, std::index_sequence<I...>) {
+    std::tuple<std::unique_ptr<DataHandle<T>>...> handles{std::make_unique<DataHandle<T>>(keys[I], mode, this)...};
+    (declareProperty(keys[I], *std::get<I>(handles), ""), ...);
+    return handles;
+  }
+
+  template <size_t... I, size_t... O>
+  StatusCode transform(const EventContext& ctx, std::index_sequence<I...> /* inputs */,
+                       std::index_sequence<O...> /* outputs */) const {
+    try {
+      AlgorithmContext context;
+      context.event = ctx.evt();
+      if constexpr (Algo::usesRandom) {
+        context.randomKey = m_randomSvc->eventKey(m_algo.randomName(), context.event);
+      }
+      const typename Algo::Input in{*std::get<I>(m_inputs)->get()...};
+      auto out = m_algo.execute(in, context);
+      if (m_validationMode.value() && m_algo.hasReference()) {
+        validate(in, context, out);
+      }
+      (std::get<O>(m_outputs)->put(new Out(std::move(std::get<O>(out)))), ...);
+    } catch (const GaudiException& e) {
+      error() << "Error during execute: " << e.message() << endmsg;
+      return e.code();
+    } catch (const std::exception& e) {
+      error() << "Error during execute: " << e.what() << endmsg;
+      return StatusCode::FAILURE;
+    }
+    return StatusCode::SUCCESS;
+  }
+
+  void validate(const typename Algo::Input& in, const AlgorithmContext& context,
+                const typename Algo::Output& out) const {
+    const auto reference = m_algo.executeReference(in, context);
+    ValidationReport report({m_validationAbsTolerance.value(), m_validationRelTolerance.value()},
+                            m_validationMaxMessages.value());
+    m_algo.compare(reference, out, report);
+    ++m_validatedCounter;
+    if (!report.ok()) {
+      ++m_mismatchCounter;
+      warning() << "Event " << context.event << ": " << report.mismatches()
+                << " mismatches with the reference implementation" << endmsg;
+      for (const auto& msg : report.messages()) {
+        warning() << "  " << msg << endmsg;
+      }
+    }
+  }
+
+  Gaudi::Property<std::string> m_geoSvcName{this, "geoServiceName", "GeoSvc"};
+  Gaudi::Property<std::string> m_randomSvcName{this, "randomServiceName", "RandomSvc"};
+
+  Gaudi::Property<bool> m_validationMode{this, "validationMode", false,
+                                         "Run the reference implementation too and compare the outputs"};
+  Gaudi::Property<double> m_validationAbsTolerance{this, "validationAbsoluteTolerance", 0.};
+  Gaudi::Property<double> m_validationRelTolerance{this, "validationRelativeTolerance", 0.};
+  Gaudi::Property<unsigned int> m_validationMaxMessages{this, "validationMaxMessages", 10,
+                                                        "Mismatches described per event"};
+  mutable Gaudi::Accumulators::Counter<> m_validatedCounter{this, "Validated events"};
+  mutable Gaudi::Accumulators::Counter<> m_mismatchCounter{this, "Events with mismatches"};
+
+  Algo m_algo;
+  std::tuple<std::unique_ptr<DataHandle<In>>...> m_inputs;
+  std::tuple<std::unique_ptr<DataHandle<Out>>...> m_outputs;
+  SmartIF<IRandomSvc> m_randomSvc;
+};
+
+} // namespace Jug
+
+#endif
@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#pragma once
+
+#include <memory>
+#include <variant>
+
+#include "Acts/MagneticField/ConstantBField.hpp"
+#include "Acts/MagneticField/MagneticFieldProvider.hpp"
+
+#include "JugBase/BField/DD4hepBField.h"
+#include "JugBase/BField/GridBField.h"
+
+namespace Jug::BField {
+
+  /** The magnetic field models of GeoSvc: the full DD4hep field, a field map sampled from it on an
+   *  (x,y,z) or (r,z) grid, or a constant field.
+   *
+   * \ingroup magnets
+   * \ingroup magsvc
+   */
+  using BFieldVariant = std::variant<std::shared_ptr<const DD4hepBField>, std::shared_ptr<const GridBField>,
+                                     std::shared_ptr<const Acts::ConstantBField>>;
+
+  /// The field model as a field provider for ACTS
+  inline std::shared_ptr<const Acts::MagneticFieldProvider> fieldProvider(const BFieldVariant& field)
+  {
+    return std::visit([](const auto& f) -> std::shared_ptr<const Acts::MagneticFieldProvider> { return f; }, field);
+  }
+
+} // namespace Jug::BField
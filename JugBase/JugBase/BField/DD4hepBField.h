@@ -8,8 +8,6 @@
 
 #pragma once
 
-#include <variant>
-
 #include "Acts/Definitions/Algebra.hpp"
 #include "Acts/MagneticField/MagneticFieldContext.hpp"
 #include "Acts/MagneticField/MagneticFieldProvider.hpp"
@@ -79,8 +77,4 @@ namespace Jug::BField {
                                                  Acts::MagneticFieldProvider::Cache& cache) const override;
   };
 
-  using BFieldVariant = std::variant<std::shared_ptr<const DD4hepBField>>;
-
-
-
 } // namespace Jug::BField
@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#pragma once
+
+#include <memory>
+
+#include "Acts/MagneticField/MagneticFieldProvider.hpp"
+
+// genfit
+#include "AbsBField.h"
+
+namespace Jug::BField {
+
+  /** The ACTS magnetic field of GeoSvc for genfit, so that both use the same field model.
+   *
+   *  genfit uses TGeo units, positions in cm and the field in kGauss. Positions where the field is
+   *  not available give a zero field.
+   *
+   *  @note the field cache is shared by the calls, like the genfit field manager this is not thread-safe
+   *
+   * \ingroup magnets
+   * \ingroup magsvc
+   */
+  class GenFitBField final : public genfit::AbsBField {
+  public:
+    explicit GenFitBField(std::shared_ptr<const Acts::MagneticFieldProvider> field);
+
+    /** Get the magneticField [kGauss] at position [cm].
+     */
+    TVector3 get(const TVector3& position) const override;
+
+    /** Get the magneticField [kGauss] at position [cm].
+     */
+    void get(const double& posX, const double& posY, const double& posZ, double& Bx, double& By,
+             double& Bz) const override;
+
+  private:
+    std::shared_ptr<const Acts::MagneticFieldProvider> m_field;
+    mutable Acts::MagneticFieldProvider::Cache m_cache;
+  };
+
+} // namespace Jug::BField
@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Acts/Definitions/Algebra.hpp"
+#include "Acts/MagneticField/MagneticFieldContext.hpp"
+#include "Acts/MagneticField/MagneticFieldProvider.hpp"
+#include "Acts/Utilities/Result.hpp"
+
+namespace Jug::BField {
+
+  /** Magnetic field interpolated on a grid sampled once from another field (e.g. the DD4hep field).
+   *
+   *  The field is sampled on an (x,y,z) grid with trilinear interpolation, or for axially symmetric
+   *  fields on an (r,z) grid (the field at phi = 0, rotated to the position) with bilinear
+   *  interpolation. The cache holds the corner values of the last grid cell, so that the lookups of
+   *  a stepper that stays in a cell do not touch the grid. Outside of the grid the source field is
+   *  used.
+   *
+   * \ingroup magnets
+   * \ingroup magsvc
+   */
+  class GridBField final : public Acts::MagneticFieldProvider {
+  public:
+    enum class Symmetry { XYZ, RZ };
+
+    struct Config {
+      Symmetry symmetry{Symmetry::XYZ};
+      /// Grid extent (mm): |x|, |y| < xyMax (r < xyMax for RZ) and zMin < z < zMax
+      double xyMax{2000.};
+      double zMin{-5000.};
+      double zMax{5000.};
+      /// Grid spacing (mm) in x and y (r for RZ), and in z
+      double xyStep{25.};
+      double zStep{25.};
+    };
+
+    struct Cache {
+      Cache(const Acts::MagneticFieldContext& /*mcfg*/) {}
+
+      /// source field cache, for the positions outside of the grid
+      std::unique_ptr<Acts::MagneticFieldProvider::Cache> source;
+      /// lower grid indices of the cached cell, none cached if index[0] < 0
+      std::array<std::ptrdiff_t, 3> index{-1, -1, -1};
+      /// corner values of the cell, 3 per corner indexed by the bits (x|r, y, z)
+      std::array<float, 24> corners;
+    };
+
+    GridBField(std::shared_ptr<const Acts::MagneticFieldProvider> source, const Config& cfg);
+
+    Acts::MagneticFieldProvider::Cache makeCache(const Acts::MagneticFieldContext& mctx) const override
+    {
+      return Acts::MagneticFieldProvider::Cache::make<Cache>(mctx);
+    }
+
+    /**  retrieve magnetic field value.
+     *
+     *  @param [in] position global position
+     *  @param [in] cache Cache object of the grid cell
+     *  @return magnetic field vector
+     */
+    Acts::Result<Acts::Vector3> getField(const Acts::Vector3& position, Acts::MagneticFieldProvider::Cache& cache) const override;
+
+    /** @brief retrieve magnetic field value & its gradient
+     *
+     * @param [in]  position   global position
+     * @param [out] derivative gradient of the interpolated field, derivative(i, j) = dB_i/dx_j
+     * @param [in] cache Cache object of the grid cell
+     * @return magnetic field vector
+     *
+     * @note outside of the grid, the derivative is set to 0
+     */
+    Acts::Result<Acts::Vector3> getFieldGradient(const Acts::Vector3& position, Acts::ActsMatrix<3, 3>& derivative,
+                                                 Acts::MagneticFieldProvider::Cache& cache) const override;
+
+    /// Largest field magnitude on the grid points
+    double maxField() const { return m_maxField; }
+
+    /// Largest deviation |B_grid - B_source| at random positions in the grid
+    double maxDeviation(size_t samples, uint32_t seed = 1) const;
+
+    const Config& config() const { return m_cfg; }
+    /// Number of grid points
+    size_t size() const { return m_values.size() / 3; }
+
+  private:
+    /// Grid point values in the order (i, j, k) with k the fastest, in (Bx, By, Bz) or (Br, Bphi, Bz)
+    Acts::Vector3 value(std::ptrdiff_t i, std::ptrdiff_t j, std::ptrdiff_t k) const;
+    /// Interpolate in the cell of the grid coordinates, optionally with the gradient along the grid axes
+    Acts::Vector3 interpolate(const std::array<double, 3>& u, Cache& cache, Acts::ActsMatrix<3, 3>* gradient) const;
+    /// Grid coordinates of a position, false if outside of the grid
+    bool toGrid(const Acts::Vector3& position, std::array<double, 3>& u) const;
+    Cache& gridCache(Acts::MagneticFieldProvider::Cache& cache) const;
+    Acts::Result<Acts::Vector3> sourceField(const Acts::Vector3& position, Cache& cache) const;
+
+    std::shared_ptr<const Acts::MagneticFieldProvider> m_source;
+    Config m_cfg;
+    /// lower edge, spacing and number of points per grid axis ((x, y, z) or (r, -, z))
+    std::array<double, 3> m_min;
+    std::array<double, 3> m_step;
+    std::array<std::ptrdiff_t, 3> m_n;
+    std::vector<float> m_values;
+    double m_maxField{0.};
+  };
+
+} // namespace Jug::BField
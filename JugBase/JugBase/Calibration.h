@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_CALIBRATION_H
+#define JUGBASE_CALIBRATION_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "JugBase/CellIDDecoder.h"
+
+namespace dd4hep {
+  class Detector;
+}
+
+namespace Jug::Base {
+
+  /** Per-channel calibration constants of a readout, for each interval of validity (IOV).
+   *
+   *  The channels are numbered densely from the channel fields of the cellIDs, over the ranges of
+   *  the field values in the file, and the constants of an IOV are arrays by channel, so that the
+   *  constants of the hits of an event are gathered in array loops with no map lookups. The
+   *  channels without constants (and the cellIDs outside of the ranges) get the fallback values of
+   *  the algorithm. The tables are immutable once read: table() is lock-free.
+   *
+   *  File format (text, # for comments):
+   *
+   *      readout   EcalBarrelHits
+   *      channel   module layer                  # channel fields of the cellIDs
+   *      constants pedestalMean pedestalSigma    # constant names
+   *      iov 0 1000                              # runs [0, 1000), "-" for no upper bound
+   *      1 1  400.2 3.1                          # channel field values, then the constants
+   *      ...
+   *      iov 1000 -
+   *      ...
+   */
+  class Calibration {
+  public:
+    using Channel                    = uint32_t;
+    static constexpr uint64_t kNoEnd = std::numeric_limits<uint64_t>::max();
+
+    /// Constants of an IOV [since, until), NaN for the channels without constants
+    struct Table {
+      uint64_t since{0};
+      uint64_t until{kNoEnd};
+      // [constant][channel], with the channel of the missing channels last
+      std::vector<std::vector<float>> constants;
+
+      bool contains(uint64_t run) const { return since <= run && run < until; }
+
+      /// Values of a constant (column index, -1 for none) for the channels, fallback if missing
+      void values(int column, const std::vector<Channel>& channels, float fallback, std::vector<float>& out) const;
+    };
+
+    /// Read a calibration file, throws std::runtime_error for invalid files and unknown readouts or fields
+    static std::unique_ptr<Calibration> read(const std::string& filename, const dd4hep::Detector& detector);
+
+    const std::string& readout() const { return m_readout; }
+    const std::vector<std::string>& constants() const { return m_constants; }
+    /// Column of a constant, -1 if not in the calibration
+    int column(const std::string& name) const;
+    size_t size() const { return m_tables.size(); }
+
+    /// Number of channels, the channel of the cellIDs without constants is channels()
+    Channel channels() const { return m_nchannels; }
+    /// Channels of the cellIDs
+    void channels(const std::vector<uint64_t>& cellIDs, std::vector<Channel>& out) const;
+
+    /// Constants of the IOV of a run, nullptr if there are none
+    const Table* table(uint64_t run) const;
+
+  private:
+    struct Field {
+      CellIDField field;
+      int64_t min;
+      uint64_t extent;
+      uint64_t stride;
+    };
+
+    std::string m_readout;
+    std::vector<Field> m_fields;
+    std::vector<std::string> m_constants;
+    Channel m_nchannels{0};
+    // sorted by since, not overlapping
+    std::vector<Table> m_tables;
+    // IOV of the last lookup
+    mutable std::atomic<size_t> m_last{0};
+  };
+
+} // namespace Jug::Base
+
+#endif
@@ -0,0 +1,138 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Jug::Base {
+
+  /** Sampled calorimeter waveforms, one per channel, in a flat buffer.
+   *
+   *  Channel c has the cellID cellID[c] and the ADC samples samples[c * nSamples] to
+   *  samples[(c + 1) * nSamples - 1], taken at startTime + s * samplingPeriod (ns). The channels
+   *  are in increasing cellID order, and all of them have the same number of samples so that the
+   *  producers and the consumers can process the buffer as a whole.
+   */
+  struct CalorimeterWaveforms {
+    std::vector<uint64_t> cellID;
+    std::vector<int32_t> samples;
+    size_t nSamples{0};
+    double samplingPeriod{0.}; // ns
+    double startTime{0.};      // ns
+
+    size_t size() const { return cellID.size(); }
+    bool empty() const { return cellID.empty(); }
+    const int32_t* channel(size_t c) const { return samples.data() + c * nSamples; }
+    int32_t* channel(size_t c) { return samples.data() + c * nSamples; }
+  };
+
+  /** Pulse shape of the calorimeter electronics, tabulated at the ADC clock.
+   *
+   *  The shape is normalized to a peak of 1 and tabulated at oversampling phases of the sampling
+   *  period: row p holds the shape at (k + p / oversampling) * samplingPeriod for the samples k of
+   *  its support, so that a pulse starting anywhere between two clock ticks is added to a
+   *  waveform as one contiguous multiply-add over a row. Shapes:
+   *   - "crrc": CR-RC^n semi-Gaussian, (t / (n tau))^n exp(n - t / tau), peak at n tau
+   *   - "gaussian": Gaussian of width tau, peak at 4 tau
+   */
+  class PulseShape {
+  public:
+    PulseShape() = default;
+    /// Times in ns, an empty shape (valid() false) for an unknown type or invalid parameters
+    PulseShape(const std::string& type, double tau, unsigned order, double samplingPeriod, size_t oversampling,
+               size_t maxSamples) {
+      if (tau <= 0. || samplingPeriod <= 0. || oversampling == 0 || maxSamples == 0 ||
+          (type != "crrc" && type != "gaussian")) {
+        return;
+      }
+      const double n = std::max(order, 1U);
+      auto shape     = [&](double t) {
+        if (type == "gaussian") {
+          const double x = (t - 4. * tau) / tau;
+          return std::exp(-0.5 * x * x);
+        }
+        return (t <= 0.) ? 0. : std::pow(t / (n * tau), n) * std::exp(n - t / tau);
+      };
+      const double peak = (type == "gaussian") ? 4. * tau : n * tau;
+      // support until the tail is below kTail of the peak
+      size_t length = 1;
+      while (length < maxSamples && (length * samplingPeriod <= peak || shape(length * samplingPeriod) >= kTail)) {
+        ++length;
+      }
+      m_length       = length;
+      m_oversampling = oversampling;
+      m_period       = samplingPeriod;
+      m_peakTime     = peak;
+      m_table.resize(oversampling * length);
+      for (size_t p = 0; p < oversampling; ++p) {
+        for (size_t k = 0; k < length; ++k) {
+          m_table[p * length + k] = static_cast<float>(shape((k + static_cast<double>(p) / oversampling) * m_period));
+        }
+      }
+    }
+
+    bool valid() const { return !m_table.empty(); }
+    /// Number of samples of the support
+    size_t length() const { return m_length; }
+    size_t oversampling() const { return m_oversampling; }
+    /// Sampling period of the table (ns)
+    double samplingPeriod() const { return m_period; }
+    /// Time of the peak after the start of the pulse (ns)
+    double peakTime() const { return m_peakTime; }
+    /// Shape at phase p, sample k of the support
+    const float* row(size_t p) const { return m_table.data() + p * m_length; }
+    /// Shape at a time after the start of the pulse (ns), at the nearest tabulated phase
+    float operator()(double t) const {
+      if (t < 0.) {
+        return 0.F;
+      }
+      const auto i   = static_cast<size_t>(std::lround(t / m_period * m_oversampling));
+      const size_t k = i / m_oversampling;
+      return (k < m_length) ? row(i % m_oversampling)[k] : 0.F;
+    }
+
+    /** Add amplitude * shape of a pulse starting at time t0 to a waveform.
+     *
+     *  The waveform has nSamples samples from startTime, every samplingPeriod of the shape. The
+     *  pulse is placed at the nearest tabulated phase, samples before t0 are left unchanged.
+     */
+    void add(float* waveform, size_t nSamples, double startTime, double t0, float amplitude) const {
+      // first sample at or after the start of the pulse, and its phase after the start
+      const double ticks = (t0 - startTime) / m_period;
+      const double first = std::max(std::ceil(ticks), 0.);
+      if (first >= static_cast<double>(nSamples)) {
+        return;
+      }
+      const auto s0 = static_cast<size_t>(first);
+      auto i        = static_cast<size_t>(std::lround((first - ticks) * m_oversampling));
+      // the phase rounds up to a full period: one sample later in the shape
+      const size_t k0 = i / m_oversampling;
+      i %= m_oversampling;
+      if (k0 >= m_length) {
+        return;
+      }
+      const float* shape = row(i) + k0;
+      const size_t n     = std::min(nSamples - s0, m_length - k0);
+      float* out         = waveform + s0;
+      for (size_t k = 0; k < n; ++k) {
+        out[k] += amplitude * shape[k];
+      }
+    }
+
+  private:
+    static constexpr double kTail = 1e-4;
+
+    std::vector<float> m_table;
+    size_t m_length{0};
+    size_t m_oversampling{1};
+    double m_period{1.};
+    double m_peakTime{0.};
+  };
+
+} // namespace Jug::Base
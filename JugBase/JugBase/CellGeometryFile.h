@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_CELLGEOMETRYFILE_H
+#define JUGBASE_CELLGEOMETRYFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace dd4hep {
+  class Detector;
+  class DetElement;
+  namespace rec {
+    class CellIDPositionConverter;
+  }
+} // namespace dd4hep
+
+namespace Jug::Base {
+
+  /** Precomputed cell geometry tables of a detector description, memory-mapped from a binary file.
+   *
+   *  The file holds, per readout, the global position and full size of the cells sorted by cellID, so
+   *  that jobs can look the cells up without TGeo navigation. The tables are only valid for the
+   *  geometry they were made with, identified by the geometry hash in the file header.
+   *
+   *  File layout (native byte order): header {magic, version, number of tables, geometry hash}, the
+   *  table directory, the readout names, then the Record arrays of the tables (8-byte aligned).
+   */
+  class CellGeometryFile {
+  public:
+    /// Cell record, lengths in DD4hep units
+    struct Record {
+      uint64_t cellID;
+      double global[3];
+      double dimension[3];
+    };
+
+    /// Records of a readout, sorted by cellID
+    struct Table {
+      const Record* begin{nullptr};
+      const Record* end{nullptr};
+
+      size_t size() const { return end - begin; }
+      /// nullptr if the cell is not in the table
+      const Record* find(uint64_t cellID) const;
+    };
+
+    CellGeometryFile() = default;
+    ~CellGeometryFile();
+    CellGeometryFile(const CellGeometryFile&) = delete;
+    CellGeometryFile& operator=(const CellGeometryFile&) = delete;
+
+    /// Map a table file, false if it cannot be read or is not a valid table file
+    bool open(const std::string& filename);
+    void close();
+
+    uint64_t geometryHash() const { return m_geometryHash; }
+    /// nullptr if the readout is not in the file
+    const Table* table(const std::string& readout) const;
+    const std::map<std::string, Table>& tables() const { return m_tables; }
+
+    /// Write the tables of a geometry, the records do not need to be sorted
+    static bool write(const std::string& filename, uint64_t geometryHash,
+                      std::map<std::string, std::vector<Record>> tables);
+
+    /// Record of a cell from DD4hep (dimension 0 if not available), local is the DetElement of the cell
+    static Record record(const dd4hep::rec::CellIDPositionConverter& converter, const dd4hep::DetElement& local,
+                         uint64_t cellID);
+
+  private:
+    void* m_data{nullptr};
+    size_t m_size{0};
+    uint64_t m_geometryHash{0};
+    std::map<std::string, Table> m_tables;
+  };
+
+  /** Hash of a detector description, for the validity of precomputed geometry tables.
+   *
+   *  Covers the contents of the compact files, the constants, and the ID specifications and
+   *  segmentations of the readouts.
+   */
+  uint64_t geometryHash(const dd4hep::Detector& detector, const std::vector<std::string>& compactFiles);
+
+  /// Hash of the contents of a file (e.g. a material map) for the caches made from it, 0 if it cannot be read
+  uint64_t fileHash(const std::string& filename);
+
+} // namespace Jug::Base
+
+#endif // JUGBASE_CELLGEOMETRYFILE_H
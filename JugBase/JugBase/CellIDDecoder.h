@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_CELLIDDECODER_H
+#define JUGBASE_CELLIDDECODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dd4hep {
+  class Detector;
+  namespace DDSegmentation {
+    class BitFieldCoder;
+  }
+} // namespace dd4hep
+
+namespace Jug::Base {
+
+  /** Field of a cellID, compiled to fixed shifts.
+   *
+   *  The value is the field shifted to the top bits and back, arithmetically for the signed fields
+   *  so that the sign is extended: no branches and no lookups, the same for every field.
+   */
+  struct CellIDField {
+    std::string name;
+    uint64_t mask{0};
+    uint32_t offset{0};
+    uint32_t width{0};
+    bool isSigned{false};
+    // shifts of the field to the top bits and back
+    uint32_t lshift{0};
+    uint32_t rshift{0};
+
+    int64_t value(uint64_t cellID) const {
+      const uint64_t top = cellID << lshift;
+      return isSigned ? static_cast<int64_t>(top) >> rshift : static_cast<int64_t>(top >> rshift);
+    }
+    /// Range of the values (fields narrower than 64 bits)
+    int64_t minValue() const { return isSigned ? -(int64_t{1} << (width - 1)) : 0; }
+    int64_t maxValue() const { return isSigned ? (int64_t{1} << (width - 1)) - 1 : (int64_t{1} << width) - 1; }
+    /// Bits of the value in the field
+    uint64_t encode(int64_t value) const { return (static_cast<uint64_t>(value) << offset) & mask; }
+    /// cellID with the field set to value
+    uint64_t set(uint64_t cellID, int64_t value) const { return (cellID & ~mask) | encode(value); }
+  };
+
+  /** Decoder of the cellIDs of a readout, with the fields compiled at initialization.
+   *
+   *  Replaces the DD4hep BitFieldCoder in the per-hit loops: the field lookups by name are done
+   *  once, and the values are plain shifts of the compiled fields, also for whole arrays of cellIDs
+   *  in a single pass (that the compiler vectorizes). The decoders of a readout are shared by the
+   *  algorithms through readout().
+   */
+  class CellIDDecoder {
+  public:
+    explicit CellIDDecoder(const dd4hep::DDSegmentation::BitFieldCoder& coder);
+
+    /// Shared decoder of a readout of the detector, throws for unknown readouts
+    static std::shared_ptr<const CellIDDecoder> readout(const dd4hep::Detector& detector, const std::string& name);
+
+    size_t size() const { return m_fields.size(); }
+    const CellIDField& operator[](size_t index) const { return m_fields[index]; }
+    /// Index of a field, throws std::out_of_range for unknown fields
+    size_t index(const std::string& name) const;
+    const CellIDField& field(const std::string& name) const { return m_fields[index(name)]; }
+
+    /// Mask of the fields
+    uint64_t mask(const std::vector<std::string>& names) const;
+    /// Bits of the field values, the other fields 0
+    uint64_t encode(const std::vector<std::pair<std::string, int>>& values) const;
+
+    /// Values of a field for n cellIDs
+    template <typename T> static void values(const CellIDField& field, const uint64_t* cellIDs, size_t n, T* out) {
+      const uint32_t lshift = field.lshift;
+      const uint32_t rshift = field.rshift;
+      if (field.isSigned) {
+        for (size_t i = 0; i < n; ++i) {
+          out[i] = static_cast<T>(static_cast<int64_t>(cellIDs[i] << lshift) >> rshift);
+        }
+      } else {
+        for (size_t i = 0; i < n; ++i) {
+          out[i] = static_cast<T>((cellIDs[i] << lshift) >> rshift);
+        }
+      }
+    }
+    template <typename T>
+    static void values(const CellIDField& field, const std::vector<uint64_t>& cellIDs, std::vector<T>& out) {
+      out.resize(cellIDs.size());
+      values(field, cellIDs.data(), cellIDs.size(), out.data());
+    }
+
+  private:
+    std::vector<CellIDField> m_fields;
+  };
+
+} // namespace Jug::Base
+
+#endif
@@ -0,0 +1,45 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_COLLECTIONBYTES_H
+#define JUGBASE_COLLECTIONBYTES_H
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <podio/CollectionBase.h>
+
+class TVirtualCollectionProxy;
+
+namespace Jug::Base {
+
+  /** Bytes of the buffers of podio collections (from getBuffers).
+   *
+   *  The objects not copied to the buffers yet (before prepareForWrite) are counted as their data.
+   *  The collection proxies of the buffers are cached by element type: not thread-safe, one
+   *  instance per thread.
+   */
+  class CollectionBytes {
+  public:
+    /// Called once for each element type without a dictionary, whose buffers are not counted
+    using UnknownType = std::function<void(const std::string&)>;
+
+    explicit CollectionBytes(UnknownType unknown = {});
+    ~CollectionBytes();
+
+    size_t operator()(podio::CollectionBase* coll);
+
+  private:
+    /// Collection proxy of the vector buffers of the element type, nullptr if unknown
+    TVirtualCollectionProxy* proxy(const std::string& elementType);
+
+    UnknownType m_unknown;
+    std::unordered_map<std::string, std::unique_ptr<TVirtualCollectionProxy>> m_proxies;
+  };
+
+} // namespace Jug::Base
+
+#endif
@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_COLLECTIONKEYS_H
+#define JUGBASE_COLLECTIONKEYS_H
+
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Jug::Base {
+
+  /** Collection names interned to dense integer keys.
+   *
+   *  The keys index the flat event store of PodioDataSvc, and are the same for all the event slots
+   *  that share the table. A name is interned once (e.g. on the first access of a data handle),
+   *  the lookups of the events are then array accesses by key. Thread-safe.
+   */
+  class CollectionKeys {
+  public:
+    static constexpr uint32_t kNoKey = std::numeric_limits<uint32_t>::max();
+
+    /// Key of the name, interned on the first use
+    uint32_t key(std::string_view name) {
+      if (const uint32_t k = find(name); k != kNoKey) {
+        return k;
+      }
+      std::unique_lock<std::shared_mutex> lock(m_mutex);
+      auto [it, inserted] = m_keys.emplace(std::string(name), static_cast<uint32_t>(m_names.size()));
+      if (inserted) {
+        m_names.push_back(&it->first);
+      }
+      return it->second;
+    }
+    /// Key of the name, kNoKey if not interned
+    uint32_t find(std::string_view name) const {
+      std::shared_lock<std::shared_mutex> lock(m_mutex);
+      auto it = m_keys.find(std::string(name));
+      return (it != m_keys.end()) ? it->second : kNoKey;
+    }
+    /// Name of a key
+    const std::string& name(uint32_t key) const {
+      std::shared_lock<std::shared_mutex> lock(m_mutex);
+      return *m_names[key];
+    }
+    size_t size() const {
+      std::shared_lock<std::shared_mutex> lock(m_mutex);
+      return m_names.size();
+    }
+
+  private:
+    mutable std::shared_mutex m_mutex;
+    std::unordered_map<std::string, uint32_t> m_keys;
+    // names by key, the nodes of the map are stable
+    std::deque<const std::string*> m_names;
+  };
+
+} // namespace Jug::Base
+
+#endif
@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_CONFIGSNAPSHOT_H
+#define JUGBASE_CONFIGSNAPSHOT_H
+
+#include <map>
+#include <string>
+
+class ISvcLocator;
+
+namespace Jug::Base {
+
+  /// Resolved options of a job by name (Component.property), values in job options syntax
+  using ConfigSnapshot = std::map<std::string, std::string>;
+
+  /** Snapshot of the resolved configuration of a job.
+   *
+   *  Every option of the job options service (the properties of the created components and the
+   *  options set for the others) and the properties of the default components that are not in the
+   *  job options service (ApplicationMgr, MessageSvc, NTupleSvc), except the options of the job
+   *  options themselves. Sorted by name, so that the same configuration gives the same snapshot.
+   */
+  ConfigSnapshot configSnapshot(ISvcLocator& svcLocator);
+
+  /// Value of a property in job options syntax: the literals (numbers, booleans, quoted strings,
+  /// lists, dictionaries) as they are, the other values as quoted strings
+  std::string optionsValue(const std::string& value);
+
+  /// Write the snapshot as a job options (.opts) file, that Gaudi.exe runs without Python.
+  /// False if the file cannot be written.
+  bool writeConfigSnapshot(const std::string& filename, const ConfigSnapshot& snapshot);
+
+} // namespace Jug::Base
+
+#endif
@@ -5,6 +5,7 @@
 #define JUGBASE_DATAHANDLE_H
 
 #include "JugBase/DataWrapper.h"
+#include "JugBase/Instrumentation.h"
 #include "JugBase/PodioDataSvc.h"
 
 #include <GaudiKernel/AlgTool.h>
@@ -16,7 +17,10 @@
 
 #include <TTree.h>
 
+#include <algorithm>
+#include <atomic>
 #include <type_traits>
+#include <utility>
 
 namespace Jug {
 using VecULong    = std::vector<unsigned long>;
@@ -57,12 +61,55 @@ public:
   * Create and register object in transient store
   */
   T* createAndPut();
+  /**
+  * Create and register object in transient store, with capacity for at least sizeHint elements
+  * (or the largest size of the previous events if the data service remembers it)
+  */
+  T* createAndPut(size_t sizeHint);
 
 private:
+  void put(T* object, bool owner);
+  /// Retrieve from the store, bypassing the cache
+  const T* retrieve();
+  /// Key of the handle in the flat store of the data service (interned on the first use)
+  uint32_t flatKey(PodioDataSvc* pds) {
+    uint32_t key = m_flatKey.load(std::memory_order_relaxed);
+    if (UNLIKELY(key == Jug::Base::CollectionKeys::kNoKey)) {
+      // the stores of the slots share their keys
+      key = pds->collectionKey(DataObjectHandle<DataWrapper<T>>::fullKey().key());
+      m_flatKey.store(key, std::memory_order_relaxed);
+    }
+    return key;
+  }
+  /// Create a podio collection for createAndPut
+  T* createCollection();
+  /// Count the objects read by the instrumented algorithm
+  static void record(const T* data) {
+    if constexpr (std::is_convertible_v<T*, podio::CollectionBase*>) {
+      if (auto* rec = Jug::Base::currentExecuteRecord(); UNLIKELY(rec != nullptr)) {
+        rec->inputObjects += data->size();
+      }
+    }
+  }
+
   ServiceHandle<IDataProviderSvc> m_eds;
-  bool m_isGoodType{false};
-  bool m_isCollection{false};
-  T* m_dataPtr;
+  /// result of the type check on the first retrieval, the same for all events and slots
+  std::atomic<bool> m_isGoodType{false};
+  std::atomic<bool> m_isCollection{false};
+  std::atomic<uint32_t> m_flatKey{Jug::Base::CollectionKeys::kNoKey};
+  /// single-store PodioDataSvc of the handle, resolved on the first retrieval (nullptr for the
+  /// whiteboard of the event slots)
+  std::atomic<PodioDataSvc*> m_cacheSvc{nullptr};
+  std::atomic<bool> m_cacheResolved{false};
+  /// object retrieved in the current event, valid while the store generation is unchanged. Only
+  /// written with a single-store PodioDataSvc, which has one event in flight: with the event
+  /// slots of PodioHiveWhiteBoard, the events in flight share the handle and no per-event state
+  /// is kept in it (the objects are in the store of the slot of each event)
+  uint64_t m_cacheGeneration{0};
+  const T* m_cachePtr{nullptr};
+  /// branch of the output tree for the non-collection types, single-store PodioDataSvc only
+  bool m_hasBranch{false};
+  T* m_dataPtr{nullptr};
 };
 
 template <typename T>
@@ -102,12 +149,14 @@ DataHandle<T>::DataHandle(const std::string& descriptor, Gaudi::DataHandle::Mode
        // and have to append a char indicating type (see TTree documentation)
        // therefore  space needs to be allocated for the integer 
        m_dataPtr = new T();
+       m_hasBranch = true;
        TTree* tree = pds->eventDataTree();
        tree->Branch(descriptor.c_str(),  m_dataPtr, (descriptor + "/I").c_str());
     } else if constexpr (std::is_floating_point_v<T>) {
        // case 3: T is some floating point type
        // similar case 2, distinguish floats and doubles by size
        m_dataPtr = new T();
+       m_hasBranch = true;
        TTree* tree = pds->eventDataTree();
        if (sizeof(T) > 4) {
          tree->Branch(descriptor.c_str(),  m_dataPtr, (descriptor + "/D").c_str());
@@ -118,6 +167,7 @@ DataHandle<T>::DataHandle(const std::string& descriptor, Gaudi::DataHandle::Mode
        // case 4: T is any other type (for which exists a root dictionary,
        // otherwise i/o will fail)
        // this includes std::vectors of ints, floats
+       m_hasBranch = true;
        TTree* tree = pds->eventDataTree();
        tree->Branch(descriptor.c_str(),  &m_dataPtr);
       }
@@ -131,26 +181,63 @@ DataHandle<T>::DataHandle(const std::string& descriptor, Gaudi::DataHandle::Mode
  * object. Then finally set the handle as Read.
  * If this is not the first time we cast and the cast worked, just use the
  * static cast: we do not need the checks of the dynamic cast for every access!
+ * The retrieved pointer is kept until the PodioDataSvc is cleared, so repeated
+ * calls in the same event do not look up the store again.
  */
 template <typename T>
 const T* DataHandle<T>::get() {
+  // repeated retrievals in the same event
+  if (m_cachePtr != nullptr && m_cacheSvc.load(std::memory_order_relaxed)->generation() == m_cacheGeneration) {
+    record(m_cachePtr);
+    return m_cachePtr;
+  }
+  const T* data = retrieve();
+  record(data);
+  if (UNLIKELY(!m_cacheResolved.load(std::memory_order_acquire))) {
+    // the whiteboard of a multi-slot store is not cached, the handle is shared between slots;
+    // concurrent first retrievals store the same result
+    m_cacheSvc.store(dynamic_cast<PodioDataSvc*>(m_eds.get()), std::memory_order_relaxed);
+    m_cacheResolved.store(true, std::memory_order_release);
+  }
+  if (PodioDataSvc* svc = m_cacheSvc.load(std::memory_order_relaxed); svc != nullptr) {
+    m_cachePtr        = data;
+    m_cacheGeneration = svc->generation();
+  }
+  return data;
+}
+
+template <typename T>
+const T* DataHandle<T>::retrieve() {
   DataObject* dataObjectp = nullptr;
-  auto sc = m_eds->retrieveObject(DataObjectHandle<DataWrapper<T>>::fullKey().key(), dataObjectp);
+  // by key in the flat store, then by path (e.g. lazy collections not read yet)
+  if (PodioDataSvc* pds = PodioDataSvc::fromEventSvc(m_eds.get()); pds != nullptr && pds->flatStore()) {
+    auto lock   = pds->lockStore();
+    dataObjectp = pds->flatObject(flatKey(pds));
+  }
+  if (dataObjectp == nullptr &&
+      m_eds->retrieveObject(DataObjectHandle<DataWrapper<T>>::fullKey().key(), dataObjectp).isFailure()) {
+    dataObjectp = nullptr;
+  }
 
-  if (LIKELY(sc.isSuccess())) {
-    if (UNLIKELY(!m_isGoodType && !m_isCollection)) {
-      // only do this once (if both are false after this, we throw exception)
-      m_isGoodType = nullptr != dynamic_cast<DataWrapper<T>*>(dataObjectp);
-      if (!m_isGoodType) {
+  if (LIKELY(dataObjectp != nullptr)) {
+    bool isGoodType   = m_isGoodType.load(std::memory_order_relaxed);
+    bool isCollection = m_isCollection.load(std::memory_order_relaxed);
+    if (UNLIKELY(!isGoodType && !isCollection)) {
+      // only do this once (if both are false after this, we throw exception),
+      // concurrent first retrievals store the same result
+      isGoodType = nullptr != dynamic_cast<DataWrapper<T>*>(dataObjectp);
+      if (!isGoodType) {
         auto tmp = dynamic_cast<DataWrapper<podio::CollectionBase>*>(dataObjectp);
         if (tmp != nullptr) {
-          m_isCollection = nullptr != dynamic_cast<T*>(tmp->collectionBase());
+          isCollection = nullptr != dynamic_cast<T*>(tmp->collectionBase());
         }
       }
+      m_isGoodType.store(isGoodType, std::memory_order_relaxed);
+      m_isCollection.store(isCollection, std::memory_order_relaxed);
     }
-    if (LIKELY(m_isGoodType)) {
+    if (LIKELY(isGoodType)) {
       return static_cast<DataWrapper<T>*>(dataObjectp)->getData();
-    } else if (m_isCollection) {
+    } else if (isCollection) {
       // The reader does not know the specific type of the collection. So we need a reinterpret_cast if the handle was
       // created by the reader.
       DataWrapper<podio::CollectionBase>* tmp = static_cast<DataWrapper<podio::CollectionBase>*>(dataObjectp);
@@ -168,26 +255,100 @@ const T* DataHandle<T>::get() {
 //---------------------------------------------------------------------------
 template <typename T>
 void DataHandle<T>::put(T* objectp) {
+  put(objectp, true);
+}
+
+template <typename T>
+void DataHandle<T>::put(T* objectp, bool owner) {
   std::unique_ptr<DataWrapper<T>> dw = std::make_unique<DataWrapper<T>>();
   // in case T is of primitive type, we must not change the pointer address
-  // (see comments in ctor) instead copy the value of T into allocated memory
-  if constexpr (std::is_integral_v<T> || std::is_floating_point_v<T>) {
-    *m_dataPtr = *objectp;
-  } else {
-    m_dataPtr = objectp;
+  // (see comments in ctor) instead copy the value of T into allocated memory.
+  // Only for the branch of a single-store PodioDataSvc, the handle is shared by the event slots
+  if (m_hasBranch) {
+    if constexpr (std::is_integral_v<T> || std::is_floating_point_v<T>) {
+      *m_dataPtr = *objectp;
+    } else {
+      m_dataPtr = objectp;
+    }
+  }
+  dw->setData(objectp, owner);
+  if (PodioDataSvc* pds = PodioDataSvc::fromEventSvc(m_eds.get()); pds != nullptr && pds->flatStore()) {
+    if (pds->registerCollection(flatKey(pds), dw.get()).isFailure()) {
+      throw GaudiException("Could not register " + DataObjectHandle<DataWrapper<T>>::pythonRepr(),
+                           "failed to put product", StatusCode::FAILURE);
+    }
+    // owned by the store
+    dw.release();
+    return;
   }
-  dw->setData(objectp);
   DataObjectHandle<DataWrapper<T>>::put(std::move(dw));
 
 }
 //---------------------------------------------------------------------------
+namespace Jug::Base::detail {
+template <typename T, typename = void> struct has_reserve : std::false_type {};
+template <typename T>
+struct has_reserve<T, std::void_t<decltype(std::declval<T&>().reserve(size_t{}))>> : std::true_type {};
+} // namespace Jug::Base::detail
+
 /**
  * Create the collection, put it in the DataObjectHandle and return the
  * pointer to the data. Call this function if you create a collection and
  * want to save it.
+ * Collections are reused from previous events if the data service recycles
+ * them, or created in its event arena if that is enabled, and destroyed with
+ * the arena when the store is cleared. Both are per event slot.
  */
 template <typename T>
 T* DataHandle<T>::createAndPut() {
+  return createAndPut(0);
+}
+
+/**
+ * Create and put the collection as createAndPut(), reserving the larger of the
+ * hint (e.g. the size of the input it is made from) and the largest size the
+ * collection had in the previous events of the slot, if the data service
+ * remembers it (adaptiveReserve). Only for types that can reserve.
+ */
+template <typename T>
+T* DataHandle<T>::createAndPut(size_t sizeHint) {
+  T* objectp = nullptr;
+  if constexpr (std::is_convertible_v<T*, podio::CollectionBase*>) {
+    objectp = createCollection();
+    if (auto* rec = Jug::Base::currentExecuteRecord(); UNLIKELY(rec != nullptr)) {
+      rec->outputs.push_back(objectp);
+    }
+  } else {
+    objectp = new T();
+    this->put(objectp);
+  }
+  if constexpr (Jug::Base::detail::has_reserve<T>::value) {
+    if (PodioDataSvc* pds = PodioDataSvc::fromEventSvc(m_eds.get()); pds != nullptr && pds->adaptiveReserve()) {
+      sizeHint = std::max(sizeHint, pds->capacityHint(DataObjectHandle<DataWrapper<T>>::fullKey().key()));
+    }
+    if (sizeHint > 0) {
+      objectp->reserve(sizeHint);
+    }
+  }
+  return objectp;
+}
+
+template <typename T>
+T* DataHandle<T>::createCollection() {
+  PodioDataSvc* pds = PodioDataSvc::fromEventSvc(m_eds.get());
+  if (pds != nullptr && pds->recycleCollections()) {
+    T* objectp = pds->template recycledCollection<T>(DataObjectHandle<DataWrapper<T>>::fullKey().key());
+    this->put(objectp, false);
+    return objectp;
+  }
+  if (pds != nullptr && pds->eventArena() != nullptr) {
+    T* objectp = [pds] {
+      auto lock = pds->lockStore();
+      return pds->eventArena()->template create<T>();
+    }();
+    this->put(objectp, false);
+    return objectp;
+  }
   T* objectp = new T();
   this->put(objectp);
   return objectp;
@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_DATAHANDLEARRAY_H
+#define JUGBASE_DATAHANDLEARRAY_H
+
+#include <Gaudi/Property.h>
+#include <GaudiKernel/IDataHandleHolder.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "JugBase/DataHandle.h"
+
+namespace Jug::Base {
+
+  /** Data handles for a configurable list of collection names.
+   *
+   *  The handles are (re)made whenever the names property is set, i.e. as soon as the job options
+   *  are applied and before initialize, so that they are declared to the owner like its other
+   *  handles and the scheduler knows the inputs of the algorithm (instead of handles made in
+   *  initialize by hand). The handles are owned by the array, get resolves all of them at once
+   *  into a buffer kept between the events. The handles are DataHandle<T> unless another handle
+   *  type is given, e.g. DataObjectHandle<DataObject> for inputs of any type. The handles are
+   *  inputs unless made with the Writer mode, for outputs put one by one.
+   */
+  template <typename T, typename HANDLE = DataHandle<T>> class DataHandleArray {
+  public:
+    template <typename OWNER>
+    DataHandleArray(OWNER* owner, const std::string& name, const std::string& doc,
+                    Gaudi::DataHandle::Mode mode = Gaudi::DataHandle::Reader)
+        : m_owner(owner), m_mode(mode), m_keys{owner, name, {}, doc} {
+      m_keys.declareUpdateHandler([this](Gaudi::Details::PropertyBase& /* p */) { update(); });
+    }
+    DataHandleArray(const DataHandleArray&) = delete;
+    DataHandleArray& operator=(const DataHandleArray&) = delete;
+
+    size_t size() const { return m_handles.size(); }
+    bool empty() const { return m_handles.empty(); }
+    HANDLE& operator[](size_t i) { return *m_handles[i]; }
+    const std::vector<std::string>& keys() const { return m_keys.value(); }
+
+    /// Collections of all the handles for the current event, in the order of the keys
+    const std::vector<const T*>& get() {
+      m_collections.resize(m_handles.size());
+      for (size_t i = 0; i < m_handles.size(); ++i) {
+        m_collections[i] = m_handles[i]->get();
+      }
+      return m_collections;
+    }
+
+    /// Sum of the sizes of the collections returned by the last get
+    size_t totalSize() const {
+      size_t n = 0;
+      for (const auto* collection : m_collections) {
+        n += collection->size();
+      }
+      return n;
+    }
+
+  private:
+    void update() {
+      for (auto& handle : m_handles) {
+        m_owner->renounce(*handle);
+      }
+      m_handles.clear();
+      for (const auto& key : m_keys.value()) {
+        m_handles.push_back(std::make_unique<HANDLE>(key, m_mode, m_owner));
+      }
+    }
+
+    IDataHandleHolder* m_owner;
+    Gaudi::DataHandle::Mode m_mode;
+    Gaudi::Property<std::vector<std::string>> m_keys;
+    std::vector<std::unique_ptr<HANDLE>> m_handles;
+    std::vector<const T*> m_collections;
+  };
+
+} // namespace Jug::Base
+
+#endif
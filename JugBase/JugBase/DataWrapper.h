@@ -29,21 +29,26 @@ public:
 template <class T>
 class GAUDI_API DataWrapper : public DataWrapperBase {
 public:
-  DataWrapper() : DataWrapperBase(), m_data(nullptr){};
+  DataWrapper() : DataWrapperBase(), m_data(nullptr), m_owner(true){};
   virtual ~DataWrapper();
 
   const T* getData() { return m_data; }
-  void setData(T* data) { m_data = data; }
+  /// the wrapper deletes the data unless it is owned elsewhere (e.g. by the event arena)
+  void setData(T* data, bool owner = true) {
+    m_data  = data;
+    m_owner = owner;
+  }
   /// try to cast to collectionBase; may return nullptr;
   virtual podio::CollectionBase* collectionBase();
 
 private:
   T* m_data;
+  bool m_owner;
 };
 
 template <class T>
 DataWrapper<T>::~DataWrapper() {
-  if (m_data != nullptr) delete m_data;
+  if (m_owner && m_data != nullptr) delete m_data;
 }
 
 template <class T>
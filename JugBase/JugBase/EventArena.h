@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_EVENTARENA_H
+#define JUGBASE_EVENTARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/** Event-scoped memory arena.
+ *
+ * Objects are bump-allocated from a list of memory blocks and destroyed all at once by reset(),
+ * which keeps the blocks (and the bookkeeping capacity) for the next event. After the first
+ * events, creating the same set of objects again does not allocate from the heap.
+ *
+ * \ingroup base
+ */
+class EventArena {
+public:
+  explicit EventArena(std::size_t blockSize = 1 << 16) : m_blockSize(blockSize) {}
+  ~EventArena();
+
+  EventArena(const EventArena&)            = delete;
+  EventArena& operator=(const EventArena&) = delete;
+
+  /// Construct an object in the arena, it is destroyed by the next reset()
+  template <typename T, typename... Args> T* create(Args&&... args) {
+    void* mem = allocate(sizeof(T), alignof(T));
+    T* obj    = new (mem) T(std::forward<Args>(args)...);
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      m_destructors.emplace_back(obj, [](void* p) { static_cast<T*>(p)->~T(); });
+    }
+    return obj;
+  }
+
+  /// Raw memory from the arena, valid until the next reset()
+  void* allocate(std::size_t size, std::size_t alignment);
+
+  /// Destroy all objects in reverse order of creation and rewind, the memory blocks are kept
+  void reset();
+
+  /// Number of objects currently alive in the arena
+  std::size_t objects() const { return m_destructors.size(); }
+  /// Total size of the memory blocks
+  std::size_t capacity() const;
+
+private:
+  struct Block {
+    std::unique_ptr<std::byte[]> data;
+    std::size_t size;
+  };
+
+  std::size_t m_blockSize;
+  std::vector<Block> m_blocks;
+  // current block and offset in it
+  std::size_t m_block{0};
+  std::size_t m_offset{0};
+  std::vector<std::pair<void*, void (*)(void*)>> m_destructors;
+};
+
+#endif
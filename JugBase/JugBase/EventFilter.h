@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_EVENTFILTER_H
+#define JUGBASE_EVENTFILTER_H
+
+#include <GaudiKernel/EventContext.h>
+#include <GaudiKernel/IAlgExecStateSvc.h>
+#include <GaudiKernel/IAlgManager.h>
+#include <GaudiKernel/IAlgorithm.h>
+#include <GaudiKernel/ISvcLocator.h>
+#include <GaudiKernel/MsgStream.h>
+#include <GaudiKernel/SmartIF.h>
+#include <GaudiKernel/StatusCode.h>
+
+#include <string>
+#include <vector>
+
+namespace Jug::Base {
+
+  /** Mark the current event as rejected by the algorithm.
+   *
+   *  The decision is the filter decision of the algorithm (filterPassed false), so that the
+   *  sequences with ShortCircuit stop the processing of the event after it, and the outputs
+   *  configured with the algorithm in requireFilters do not write it. The event is not an error:
+   *  returns SUCCESS, to be returned by execute.
+   */
+  template <typename ALG> StatusCode rejectEvent(const ALG& alg, const char* reason) {
+    if (alg.msgLevel(MSG::DEBUG)) {
+      alg.debug() << "Event rejected: " << reason << endmsg;
+    }
+    alg.setFilterPassed(false);
+    return StatusCode::SUCCESS;
+  }
+
+  /** Filter decisions of a list of algorithms, for the outputs.
+   *
+   *  The algorithms are found by name at initialize, an event passes if all of them accepted it
+   *  (no algorithm accepts all the events).
+   */
+  class FilterDecisions {
+  public:
+    /// False with the reason in error if an algorithm or the execution state service is not found
+    bool configure(ISvcLocator* svcLoc, const std::vector<std::string>& names, std::string& error) {
+      m_algorithms.clear();
+      if (names.empty()) {
+        return true;
+      }
+      m_stateSvc = svcLoc->service("AlgExecStateSvc");
+      SmartIF<IAlgManager> algManager(svcLoc);
+      if (!m_stateSvc || !algManager) {
+        error = "cannot get the AlgExecStateSvc and the algorithm manager";
+        return false;
+      }
+      for (const auto& name : names) {
+        SmartIF<IAlgorithm> alg = algManager->algorithm(name, false);
+        if (!alg) {
+          error = "unknown filter algorithm " + name;
+          return false;
+        }
+        m_algorithms.push_back(alg);
+      }
+      return true;
+    }
+
+    bool passed(const EventContext& ctx) const {
+      for (const auto& alg : m_algorithms) {
+        if (!m_stateSvc->algExecState(alg.get(), ctx).filterPassed()) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+  private:
+    SmartIF<IAlgExecStateSvc> m_stateSvc;
+    std::vector<SmartIF<IAlgorithm>> m_algorithms;
+  };
+
+} // namespace Jug::Base
+
+#endif
@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_EVENTPARAMETER_H
+#define JUGBASE_EVENTPARAMETER_H
+
+#include <Gaudi/Property.h>
+#include <GaudiKernel/GaudiException.h>
+#include <GaudiKernel/IDataProviderSvc.h>
+
+#include <stdexcept>
+#include <string>
+
+#include "JugBase/EventParameters.h"
+#include "JugBase/PodioDataSvc.h"
+
+namespace Jug::Base {
+
+  /** Scalar output of an algorithm (e.g. a count or a summary value of the event).
+   *
+   *  Replaces a DataHandle of a primitive type, which allocates and registers a wrapper in the event
+   *  store for each event: the value is set in the EventParameters block of the store, and written
+   *  as a leaf of the EventParameters branch. The name of the parameter is a property of the
+   *  algorithm, and is declared at initialize.
+   *
+   *      EventParameter<int> m_nProtoTracks{this, "nProtoTracks", "nProtoTracks", "number of proto tracks"};
+   *      ...
+   *      m_nProtoTracks.initialize(evtSvc());   // in initialize
+   *      m_nProtoTracks.set(n);                 // in execute
+   */
+  template <typename T> class EventParameter {
+  public:
+    template <typename OWNER>
+    EventParameter(OWNER* owner, const std::string& property, const std::string& name, const std::string& doc)
+        : m_name{owner, property, name, doc} {}
+
+    /// Declare the parameter in the event store, throws GaudiException if not possible
+    void initialize(IDataProviderSvc* evtSvc) {
+      m_evtSvc         = evtSvc;
+      PodioDataSvc* pds = PodioDataSvc::fromEventSvc(evtSvc);
+      if (pds == nullptr) {
+        throw GaudiException("Event parameter " + m_name.value() + " needs a PodioDataSvc", "EventParameter",
+                             StatusCode::FAILURE);
+      }
+      try {
+        m_index = pds->eventParameters().declare(m_name.value(), EventParameters::typeOf<T>());
+      } catch (const std::logic_error& e) {
+        throw GaudiException(e.what(), "EventParameter", StatusCode::FAILURE);
+      }
+    }
+
+    /// Value of the current event
+    void set(T value) { PodioDataSvc::fromEventSvc(m_evtSvc)->eventParameters().template set<T>(m_index, value); }
+    T get() const { return PodioDataSvc::fromEventSvc(m_evtSvc)->eventParameters().template get<T>(m_index); }
+
+    const std::string& name() const { return m_name.value(); }
+
+  private:
+    Gaudi::Property<std::string> m_name;
+    IDataProviderSvc* m_evtSvc{nullptr};
+    size_t m_index{0};
+  };
+
+} // namespace Jug::Base
+
+#endif
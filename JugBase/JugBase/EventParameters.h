@@ -0,0 +1,130 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_EVENTPARAMETERS_H
+#define JUGBASE_EVENTPARAMETERS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace Jug::Base {
+
+  /** Scalar values of an event (e.g. the number of proto-tracks), in one fixed block.
+   *
+   *  The parameters are declared by name at initialize, which fixes their index in the block, and
+   *  are set and read by index in the events: no allocation and no registration in the event store.
+   *  The block is written by PodioOutput as one branch of leaves ("EventParameters"), in the order
+   *  of declaration. The layout is shared by the stores of the event slots, the values are per store
+   *  and reset to zero when the store is cleared. Integers are stored as int64, floating-point values
+   *  as double.
+   */
+  class EventParameters {
+  public:
+    enum class Type { Int, Double };
+
+    union Value {
+      int64_t i;
+      double d;
+    };
+
+    template <typename T> static constexpr Type typeOf() {
+      static_assert(std::is_arithmetic_v<T>, "event parameters are integer or floating-point values");
+      return std::is_floating_point_v<T> ? Type::Double : Type::Int;
+    }
+
+    /// Index of a parameter, the same for the same name and type.
+    /// Throws std::logic_error for another type, an invalid name, or after the layout is frozen.
+    size_t declare(const std::string& name, Type type) {
+      auto& layout = *m_layout;
+      for (size_t i = 0; i < layout.names.size(); ++i) {
+        if (layout.names[i] == name) {
+          if (layout.types[i] != type) {
+            throw std::logic_error("event parameter " + name + " is declared with different types");
+          }
+          return i;
+        }
+      }
+      if (layout.frozen) {
+        throw std::logic_error("event parameter " + name + " declared after the output branch was created");
+      }
+      if (name.empty() || name.find_first_of(":/[] ") != std::string::npos) {
+        throw std::logic_error("invalid event parameter name '" + name + "'");
+      }
+      layout.names.push_back(name);
+      layout.types.push_back(type);
+      return layout.names.size() - 1;
+    }
+
+    template <typename T> void set(size_t index, T value) {
+      Value& v = at(index);
+      if constexpr (std::is_floating_point_v<T>) {
+        v.d = value;
+      } else {
+        v.i = static_cast<int64_t>(value);
+      }
+    }
+    template <typename T> T get(size_t index) {
+      const Value& v = at(index);
+      if constexpr (std::is_floating_point_v<T>) {
+        return static_cast<T>(v.d);
+      } else {
+        return static_cast<T>(v.i);
+      }
+    }
+
+    /// Reset all the values to zero
+    void clear() {
+      m_values.assign(m_layout->names.size(), Value{0});
+    }
+
+    size_t size() const { return m_layout->names.size(); }
+    bool empty() const { return m_layout->names.empty(); }
+    /// ROOT leaf list of the block, e.g. "nProtoTracks/L:vertexZ/D"
+    std::string leafList() const {
+      std::string leaves;
+      for (size_t i = 0; i < m_layout->names.size(); ++i) {
+        leaves += (i > 0 ? ":" : "") + m_layout->names[i] + (m_layout->types[i] == Type::Int ? "/L" : "/D");
+      }
+      return leaves;
+    }
+    /// No declarations after the output branch is created
+    void freeze() { m_layout->frozen = true; }
+    /// Values in the order of the leaf list
+    Value* data() {
+      m_values.resize(m_layout->names.size(), Value{0});
+      return m_values.data();
+    }
+
+    /// Share the layout of another block (e.g. of the first event slot)
+    void shareLayout(const EventParameters& other) {
+      m_layout = other.m_layout;
+      clear();
+    }
+
+  private:
+    struct Layout {
+      std::vector<std::string> names;
+      std::vector<Type> types;
+      bool frozen{false};
+    };
+
+    Value& at(size_t index) {
+      if (index >= m_values.size()) {
+        // first event of the store
+        m_values.resize(m_layout->names.size(), Value{0});
+      }
+      return m_values[index];
+    }
+
+    std::shared_ptr<Layout> m_layout{std::make_shared<Layout>()};
+    std::vector<Value> m_values;
+  };
+
+} // namespace Jug::Base
+
+#endif
@@ -8,14 +8,17 @@
 
 #pragma once
 
-#include "JugTrack/Utilities/GroupBy.hpp"
-#include "JugTrack/Utilities/Range.hpp"
+#include "JugBase/Utilities/GroupBy.hpp"
+#include "JugBase/Utilities/Range.hpp"
 #include "Acts/Geometry/GeometryIdentifier.hpp"
 #include "Acts/Surfaces/Surface.hpp"
 
 #include <algorithm>
+#include <cassert>
 #include <cstddef>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include <boost/container/flat_map.hpp>
 #include <boost/container/flat_set.hpp>
@@ -185,4 +188,104 @@ struct GeometryIdMultisetAccessor {
   }
 };
 
-}  // namespace FW
+/// Store elements that know their geometry id contiguously, for the per-surface lookups of the tracking.
+///
+/// @tparam T type to be stored, must be compatible with `CompareGeometryId`
+///
+/// The elements are kept sorted by geometry id, and the index range of each
+/// geometry id is kept in a hash table: `equal_range` is a table lookup and
+/// `nth` an array access. Appending the elements in geometry order, as the
+/// source linkers do, only extends the table; out of order insertions are kept
+/// sorted with the order of insertion among equal ids, and rebuild the table.
+template <typename T>
+class GeometryIdFlatMultiset {
+public:
+  using value_type     = T;
+  using size_type      = std::size_t;
+  using const_iterator = typename std::vector<T>::const_iterator;
+  using iterator       = const_iterator;
+
+  void reserve(size_type n) { m_elements.reserve(n); }
+  size_type size() const { return m_elements.size(); }
+  bool empty() const { return m_elements.empty(); }
+
+  const_iterator begin() const { return m_elements.begin(); }
+  const_iterator end() const { return m_elements.end(); }
+  /// Element by index in geometry order, end() if out of range
+  const_iterator nth(size_type n) const { return (n < size()) ? begin() + n : end(); }
+
+  /// Insert after the elements with the same geometry id, the hint is ignored
+  const_iterator emplace_hint(const_iterator /* hint */, const T& value) {
+    const auto id = detail::GeometryIdGetter()(value).value();
+    if (m_elements.empty() || !(id < detail::GeometryIdGetter()(m_elements.back()).value())) {
+      m_elements.push_back(value);
+      auto& range = m_ranges.try_emplace(id, size() - 1, size() - 1).first->second;
+      range.second = size();
+      return end() - 1;
+    }
+    const auto it = std::upper_bound(m_elements.begin(), m_elements.end(), value, detail::CompareGeometryId{});
+    const auto n  = it - m_elements.begin();
+    m_elements.insert(it, value);
+    rebuild();
+    return begin() + n;
+  }
+  /// Insert a range of elements, sorted once after appending them
+  template <typename InputIt>
+  void insert(InputIt first, InputIt last) {
+    const auto n = size();
+    m_elements.insert(m_elements.end(), first, last);
+    if (!std::is_sorted(m_elements.begin(), m_elements.end(), detail::CompareGeometryId{})) {
+      const auto mid = m_elements.begin() + n;
+      std::stable_sort(mid, m_elements.end(), detail::CompareGeometryId{});
+      std::inplace_merge(m_elements.begin(), mid, m_elements.end(), detail::CompareGeometryId{});
+    }
+    rebuild();
+  }
+
+  /// Elements with the geometry id
+  std::pair<const_iterator, const_iterator> equal_range(Acts::GeometryIdentifier geoId) const {
+    const auto it = m_ranges.find(geoId.value());
+    if (it == m_ranges.end()) {
+      return {end(), end()};
+    }
+    return {begin() + it->second.first, begin() + it->second.second};
+  }
+
+private:
+  void rebuild() {
+    m_ranges.clear();
+    for (size_type i = 0; i < size();) {
+      const auto id = detail::GeometryIdGetter()(m_elements[i]).value();
+      size_type j   = i + 1;
+      while (j < size() && detail::GeometryIdGetter()(m_elements[j]).value() == id) {
+        ++j;
+      }
+      m_ranges.emplace(id, std::make_pair(i, j));
+      i = j;
+    }
+  }
+
+  std::vector<T> m_elements;
+  /// [begin, end) indices of the elements of each geometry id
+  std::unordered_map<Acts::GeometryIdentifier::Value, std::pair<size_type, size_type>> m_ranges;
+};
+
+/// The accessor for the GeometryIdFlatMultiset container, with O(1) surface lookups
+template <typename T>
+struct GeometryIdFlatMultisetAccessor {
+  using Container = GeometryIdFlatMultiset<T>;
+  using Key       = Acts::GeometryIdentifier;
+  using Value     = typename GeometryIdFlatMultiset<T>::value_type;
+  using Iterator  = typename GeometryIdFlatMultiset<T>::const_iterator;
+
+  // pointer to the container
+  const Container* container = nullptr;
+
+  // get the range of elements with requested geoId
+  std::pair<Iterator, Iterator> range(const Acts::Surface& surface) const {
+    assert(container != nullptr);
+    return container->equal_range(surface.geometryId());
+  }
+};
+
+}  // namespace Jug
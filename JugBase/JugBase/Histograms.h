@@ -0,0 +1,161 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_HISTOGRAMS_H
+#define JUGBASE_HISTOGRAMS_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Jug::Base {
+
+  /// Fixed binning: bin 0 is the underflow, bins 1 to n are [min, max), bin n + 1 the overflow
+  struct FixedBins {
+    unsigned nbins{1};
+    double min{0};
+    double max{1};
+
+    FixedBins() = default;
+    FixedBins(unsigned n, double lo, double hi) : nbins(std::max(n, 1U)), min(lo), max(hi), m_scale(nbins / (hi - lo)) {}
+
+    size_t size() const { return nbins + 2; }
+    double width() const { return (max - min) / nbins; }
+    double center(size_t bin) const { return min + (static_cast<double>(bin) - 0.5) * width(); }
+    size_t bin(double x) const {
+      if (!(x >= min)) {
+        // NaN in the underflow
+        return 0;
+      }
+      if (x >= max) {
+        return nbins + 1;
+      }
+      return std::min<size_t>(static_cast<size_t>((x - min) * m_scale), nbins - 1) + 1;
+    }
+
+  private:
+    double m_scale{1};
+  };
+
+  /** Plain-array histogram, e.g. the scratch histogram of an algorithm in an event.
+   *
+   *  Not thread-safe, and no ROOT object: filling is an index computation and an addition.
+   */
+  class Hist1D {
+  public:
+    Hist1D() = default;
+    Hist1D(unsigned nbins, double min, double max) : m_bins(nbins, min, max), m_counts(m_bins.size(), 0.) {}
+
+    const FixedBins& bins() const { return m_bins; }
+    void fill(double x, double w = 1.) { m_counts[m_bins.bin(x)] += w; }
+    double content(size_t bin) const { return m_counts[bin]; }
+    void setContent(size_t bin, double value) { m_counts[bin] = value; }
+    const std::vector<double>& contents() const { return m_counts; }
+    void clear() { std::fill(m_counts.begin(), m_counts.end(), 0.); }
+
+    /// First bin of the largest content of bins 1 to n (as TH1::GetMaximumBin)
+    size_t maximumBin() const {
+      return static_cast<size_t>(std::max_element(m_counts.begin() + 1, m_counts.end() - 1) - m_counts.begin());
+    }
+    double maximum() const { return m_counts[maximumBin()]; }
+
+    void add(const Hist1D& other) {
+      for (size_t i = 0; i < m_counts.size() && i < other.m_counts.size(); ++i) {
+        m_counts[i] += other.m_counts[i];
+      }
+    }
+
+  private:
+    FixedBins m_bins;
+    std::vector<double> m_counts;
+  };
+
+  /** Monitoring histogram, filled from any thread without locks.
+   *
+   *  Each thread fills a buffer of its own (registered on its first fill, under a lock), with
+   *  relaxed atomic loads and stores by its only writer: no contention and no read-modify-write,
+   *  while merged() can sum the buffers at any time, e.g. periodically for online monitoring.
+   *  Booked with IMonitorHistSvc, which owns the histograms and writes them.
+   */
+  class MonitorHist {
+  public:
+    MonitorHist(std::string name, std::string title, unsigned nbins, double min, double max)
+        : m_name(std::move(name)), m_title(std::move(title)), m_bins(nbins, min, max), m_id(nextId()) {}
+    MonitorHist(const MonitorHist&)            = delete;
+    MonitorHist& operator=(const MonitorHist&) = delete;
+
+    const std::string& name() const { return m_name; }
+    const std::string& title() const { return m_title; }
+    const FixedBins& bins() const { return m_bins; }
+
+    void fill(double x, double w = 1.) {
+      Buffer& buffer = threadBuffer();
+      auto& count    = buffer.counts[m_bins.bin(x)];
+      count.store(count.load(std::memory_order_relaxed) + w, std::memory_order_relaxed);
+      buffer.entries.store(buffer.entries.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    /// Sum of the buffers of the threads, as a plain-array histogram
+    Hist1D merged(uint64_t* entries = nullptr) const {
+      Hist1D sum(m_bins.nbins, m_bins.min, m_bins.max);
+      uint64_t n = 0;
+      std::lock_guard<std::mutex> lock(m_mutex);
+      for (const auto& buffer : m_buffers) {
+        for (size_t i = 0; i < m_bins.size(); ++i) {
+          sum.setContent(i, sum.content(i) + buffer->counts[i].load(std::memory_order_relaxed));
+        }
+        n += buffer->entries.load(std::memory_order_relaxed);
+      }
+      if (entries != nullptr) {
+        *entries = n;
+      }
+      return sum;
+    }
+
+  private:
+    struct Buffer {
+      explicit Buffer(size_t n) : counts(new std::atomic<double>[n]) {
+        for (size_t i = 0; i < n; ++i) {
+          counts[i].store(0., std::memory_order_relaxed);
+        }
+      }
+      std::unique_ptr<std::atomic<double>[]> counts;
+      std::atomic<uint64_t> entries{0};
+    };
+
+    // ids are never reused, so that the buffer pointers of the threads stay unique
+    static size_t nextId() {
+      static std::atomic<size_t> id{0};
+      return id.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Buffer& threadBuffer() {
+      thread_local std::vector<Buffer*> buffers;
+      if (m_id >= buffers.size()) {
+        buffers.resize(m_id + 1, nullptr);
+      }
+      Buffer*& buffer = buffers[m_id];
+      if (buffer == nullptr) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        buffer = m_buffers.emplace_back(std::make_unique<Buffer>(m_bins.size())).get();
+      }
+      return *buffer;
+    }
+
+    std::string m_name;
+    std::string m_title;
+    FixedBins m_bins;
+    size_t m_id;
+    mutable std::mutex m_mutex;
+    std::vector<std::unique_ptr<Buffer>> m_buffers;
+  };
+
+} // namespace Jug::Base
+
+#endif
@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef ICALIBRATIONSVC_H
+#define ICALIBRATIONSVC_H
+
+#include <GaudiKernel/IService.h>
+
+#include <cstdint>
+#include <string>
+
+#include "JugBase/Calibration.h"
+
+/** Calibration constants service interface.
+ *
+ *  The calibrations are looked up by name in initialize, and the constants of the events by the
+ *  run of the events in execute (Jug::Base::Calibration::table, lock-free).
+ *
+ * \ingroup base
+ */
+class GAUDI_API ICalibrationSvc : virtual public IService {
+public:
+  /// InterfaceID
+  DeclareInterfaceID(ICalibrationSvc, 1, 0);
+
+  /// Calibration of a name, nullptr if it is not configured or cannot be read
+  virtual const Jug::Base::Calibration* calibration(const std::string& name) = 0;
+
+  /// Run of the events, for the IOV of their constants
+  virtual uint64_t run() const = 0;
+
+  virtual ~ICalibrationSvc() {}
+};
+
+#endif // ICALIBRATIONSVC_H
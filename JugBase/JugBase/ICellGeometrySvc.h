@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef ICELLGEOMETRYSVC_H
+#define ICELLGEOMETRYSVC_H
+
+#include <GaudiKernel/IService.h>
+
+#include "DD4hep/Objects.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Jug::Base {
+
+  /// Geometry of a readout cell, lengths in DD4hep units
+  struct CellGeometry {
+    /// Cell position, global and in the local frame of the table
+    dd4hep::Position global;
+    dd4hep::Position local;
+    /// Full size of the cell (segmentation cell or bounding box of the volume)
+    std::array<double, 3> dimension{0., 0., 0.};
+    /// Layer and sector fields of the cellID, -1 if not requested
+    int32_t layer{-1};
+    int32_t sector{-1};
+  };
+
+  /** Readout and local frame of a cell geometry table.
+   *
+   *  The local frame is the DetElement localDetElement if given, otherwise the DetElement of the
+   *  cellID restricted to the localDetFields (all fields if empty). The readout is needed for the
+   *  local fields and for the layer and sector fields.
+   */
+  struct CellGeometrySpec {
+    std::string readout;
+    std::string localDetElement;
+    std::vector<std::string> localDetFields;
+    std::string layerField;
+    std::string sectorField;
+
+    /// Tables with the same key are shared
+    std::string key() const {
+      std::string k = readout + '|' + localDetElement + '|';
+      for (const auto& f : localDetFields) {
+        k += f + ',';
+      }
+      return k + '|' + layerField + '|' + sectorField;
+    }
+  };
+
+  /** cellID -> cell geometry lookup table.
+   *
+   *  The geometry of a cell is the same in every event, the table is filled once per cell so that
+   *  the DD4hep/TGeo lookups are not repeated for every hit. Lookups are thread-safe.
+   */
+  class CellGeometryTable {
+  public:
+    using CellID = uint64_t;
+
+    virtual ~CellGeometryTable() = default;
+
+    /// Geometry of a cell, the reference stays valid for the lifetime of the table
+    virtual const CellGeometry& geometry(CellID cellID) const = 0;
+
+    /// Geometry of several cells, looked up together (a single lock for the cells already in the table)
+    virtual void geometry(const std::vector<CellID>& cellIDs, std::vector<const CellGeometry*>& geometries) const = 0;
+  };
+
+} // namespace Jug::Base
+
+/** Cell geometry service interface.
+ *
+ * \ingroup base
+ * \ingroup geosvc
+ */
+class GAUDI_API ICellGeometrySvc : virtual public IService {
+public:
+  /// InterfaceID
+  DeclareInterfaceID(ICellGeometrySvc, 1, 0);
+
+  /// Geometry table of a readout and local frame, nullptr if they do not exist in the geometry
+  virtual const Jug::Base::CellGeometryTable* geometryTable(const Jug::Base::CellGeometrySpec& spec) = 0;
+
+  virtual ~ICellGeometrySvc() {}
+};
+
+#endif // ICELLGEOMETRYSVC_H
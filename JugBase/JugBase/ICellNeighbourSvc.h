@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef ICELLNEIGHBOURSVC_H
+#define ICELLNEIGHBOURSVC_H
+
+#include <GaudiKernel/IService.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Jug::Base {
+
+  /** Neighbour lookup table of the cells in one readout.
+   *
+   *  The neighbours of a cell are the cells that are adjacent to it in the readout segmentation,
+   *  returned sorted by cellID.
+   */
+  class CellNeighbourTable {
+  public:
+    using CellID     = uint64_t;
+    using Neighbours = std::vector<CellID>;
+
+    virtual ~CellNeighbourTable() = default;
+
+    /// Neighbours of a cell, the reference stays valid for the lifetime of the table
+    virtual const Neighbours& neighbours(CellID cellID) const = 0;
+
+    bool isNeighbour(CellID cellID, CellID other) const {
+      const auto& nbs = neighbours(cellID);
+      return std::binary_search(nbs.begin(), nbs.end(), other);
+    }
+  };
+
+} // namespace Jug::Base
+
+/** Cell neighbour service interface.
+ *
+ * \ingroup base
+ * \ingroup geosvc
+ */
+class GAUDI_API ICellNeighbourSvc : virtual public IService {
+public:
+  /// InterfaceID
+  DeclareInterfaceID(ICellNeighbourSvc, 1, 0);
+
+  /// Neighbour table of a readout, nullptr if the readout does not exist
+  virtual const Jug::Base::CellNeighbourTable* neighbourTable(const std::string& readout) = 0;
+
+  virtual ~ICellNeighbourSvc() {}
+};
+
+#endif // ICELLNEIGHBOURSVC_H
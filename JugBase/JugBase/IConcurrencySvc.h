@@ -0,0 +1,37 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef ICONCURRENCYSVC_H
+#define ICONCURRENCYSVC_H
+
+#include <GaudiKernel/IService.h>
+
+#include <cstddef>
+#include <functional>
+
+/** Intra-event parallelism interface.
+ *
+ *  The parallel algorithms (CKF, seeding, fitting, clustering, ...) run their tasks in the one
+ *  task arena of the service instead of arenas of their own, so that with several events in
+ *  flight the job never asks for more threads than the arena has. The tasks of a call may run
+ *  in any order and thread; the caller stores their results by task index.
+ *
+ *  With an instrumentation auditor (AlgorithmStatsAuditor), the parallel time and the time the
+ *  tasks kept the threads busy are recorded for the calling algorithm: its parallel efficiency.
+ *
+ * \ingroup base
+ */
+class GAUDI_API IConcurrencySvc : virtual public IService {
+public:
+  /// InterfaceID
+  DeclareInterfaceID(IConcurrencySvc, 1, 0);
+  virtual ~IConcurrencySvc() {}
+
+  /// Maximum number of threads of the arena
+  virtual int concurrency() const = 0;
+
+  /// Run task(0), ..., task(ntasks - 1) in the arena and wait for them
+  virtual void parallelFor(size_t ntasks, const std::function<void(size_t)>& task) = 0;
+};
+
+#endif // ICONCURRENCYSVC_H
@@ -26,6 +26,11 @@ namespace genfit {
   class DetPlane;
 }
 
+namespace Jug::Base {
+  class CellGeometryFile;
+  class SurfaceIndex;
+}
+
 /** Geometry service interface.
  *
  * \ingroup base
@@ -53,6 +58,13 @@ public:
   /// Genfit DetPlane map
   virtual std::map<int64_t, std::shared_ptr<genfit::DetPlane>> getDetPlaneMap() const = 0;
   virtual std::map< int64_t, dd4hep::rec::Surface* > getDD4hepSurfaceMap() const =0;
+  /// ACTS, DD4hep and genfit surfaces by cellID
+  virtual const Jug::Base::SurfaceIndex& surfaceIndex() const = 0;
+
+  /// Hash of the detector description, identifies the geometry of precomputed tables
+  virtual uint64_t geometryHash() const = 0;
+  /// Precomputed cell geometry tables for this geometry, nullptr if none were loaded
+  virtual const Jug::Base::CellGeometryFile* cellGeometryFile() const = 0;
 
   //virtual std::map< int64_t, dd4hep::rec::Surface* > getDetPlaneMap() const = 0 ;
 
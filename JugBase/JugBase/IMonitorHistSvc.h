@@ -0,0 +1,33 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef IMONITORHISTSVC_H
+#define IMONITORHISTSVC_H
+
+#include <GaudiKernel/IService.h>
+
+#include <string>
+
+#include "JugBase/Histograms.h"
+
+/** Monitoring histogram interface.
+ *
+ *  Histograms of fixed binning that the algorithms book at initialize and fill in their hot
+ *  loops from any thread, without locks and without ROOT objects in the event loop (see
+ *  Jug::Base::MonitorHist). The service merges the buffers of the threads when it writes them.
+ *
+ * \ingroup base
+ */
+class GAUDI_API IMonitorHistSvc : virtual public IService {
+public:
+  /// InterfaceID
+  DeclareInterfaceID(IMonitorHistSvc, 1, 0);
+  virtual ~IMonitorHistSvc() {}
+
+  /// Histogram of a name (e.g. algorithm/quantity), booked on the first call; the service owns
+  /// it, nullptr if the name is booked with another binning
+  virtual Jug::Base::MonitorHist* book(const std::string& name, const std::string& title, unsigned nbins, double min,
+                                       double max) = 0;
+};
+
+#endif // IMONITORHISTSVC_H
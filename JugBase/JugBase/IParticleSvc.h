@@ -5,7 +5,7 @@
 #define IParticleSvc_H
 
 #include <GaudiKernel/IService.h>
-#include <unordered_map>
+#include <map>
 
 namespace Jug::Base {
 
@@ -30,11 +30,13 @@ public:
 
 public:
   /// InterfaceID
-  DeclareInterfaceID(IParticleSvc, 1, 0);
+  DeclareInterfaceID(IParticleSvc, 2, 0);
   virtual ~IParticleSvc() {}
 
-  virtual ParticleMap particleMap() const = 0;
-  virtual Particle    particle(int pdg) const = 0;
+  /// All particles by PDG code, owned by the service
+  virtual const ParticleMap& particleMap() const = 0;
+  /// Particle of a PDG code, the unknown particle (PDG code 0) if not in the table
+  virtual const Particle&    particle(int pdg) const = 0;
 };
 
 #endif  // IParticleSvc_H
@@ -0,0 +1,37 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef IRandomSvc_H
+#define IRandomSvc_H
+
+#include <GaudiKernel/IService.h>
+
+#include <cstdint>
+#include <string_view>
+
+#include "JugBase/Utilities/Philox.h"
+
+/** Reproducible random number interface.
+ *
+ *  The random numbers are counter-based (Jug::Base::Random::Philox4x32): a stream is a pure
+ *  function of (seed, run, event, algorithm, id), with no shared state, so that the events and
+ *  the hits of an event can be processed in any order or thread with bit-identical results.
+ *  An algorithm takes the key of the event once per execute and opens one stream per cell,
+ *  using the numbers of a stream in the order of its hits.
+ *
+ * \ingroup base
+ */
+class GAUDI_API IRandomSvc : virtual public IService {
+public:
+  /// InterfaceID
+  DeclareInterfaceID(IRandomSvc, 1, 0);
+  virtual ~IRandomSvc() {}
+
+  /// Key of the streams of an algorithm in an event
+  virtual uint64_t eventKey(std::string_view algorithm, uint64_t event) const = 0;
+
+  /// Stream of an id (e.g. a cellID) for an event key
+  Jug::Base::Random::Stream stream(uint64_t eventKey, uint64_t id) const { return {eventKey, id}; }
+};
+
+#endif // IRandomSvc_H
@@ -8,13 +8,14 @@
 
 #pragma once
 
-#include "JugTrack/GeometryContainers.hpp"
-#include "JugTrack/Index.hpp"
+#include "JugBase/GeometryContainers.hpp"
+#include "JugBase/Index.hpp"
 
 #include "Acts/EventData/SourceLink.hpp"
 #include "Acts/Surfaces/Surface.hpp"
 
 #include <cassert>
+#include <vector>
 
 namespace Jug {
 
@@ -53,18 +54,27 @@ namespace Jug {
     friend constexpr bool operator!=(const IndexSourceLink& lhs, const IndexSourceLink& rhs) { return not(lhs == rhs); }
   };
 
+  /// Storage of the index source links of an event.
+  ///
+  /// The source link container and the measurements reference the links in
+  /// the storage, so it is reserved for all the hits of the event before the
+  /// links are added and must not reallocate afterwards. The links are
+  /// contiguous, in the order of the hits.
+  using IndexSourceLinkStorage = std::vector<IndexSourceLink>;
+
   /// Container of index source links.
   ///
   /// Since the source links provide a `.geometryId()` accessor, they can be
-  /// stored in an ordered geometry container.
+  /// stored in an ordered geometry container, contiguous for the per-surface
+  /// lookups of the track finding.
   using IndexSourceLinkContainer =
-    GeometryIdMultiset<std::reference_wrapper<const IndexSourceLink>>;
+    GeometryIdFlatMultiset<std::reference_wrapper<const IndexSourceLink>>;
 
   /// Accessor for the above source link container
   ///
   /// It wraps up a few lookup methods to be used in the Combinatorial Kalman
   /// Filter
   using IndexSourceLinkAccessor =
-    GeometryIdMultisetAccessor<std::reference_wrapper<const IndexSourceLink>>;
+    GeometryIdFlatMultisetAccessor<std::reference_wrapper<const IndexSourceLink>>;
 
 } // namespace Jug
@@ -0,0 +1,133 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_INPUTPIPELINE_H
+#define JUGBASE_INPUTPIPELINE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <podio/CollectionBase.h>
+
+#include "JugBase/CollectionBytes.h"
+#include "JugBase/PackedCellIDs.h"
+
+class TTree;
+
+namespace Jug::Base {
+
+  /// Add the branches of the collections (with their relations name#N and vector members name_N)
+  /// to the read cache of the tree, returns the number of branches
+  size_t cacheCollectionBranches(TTree& tree, const std::vector<std::string>& collectionNames);
+
+  /** Reads and unpacks the next events of the input on a background thread.
+   *
+   *  The events are read into buffers of their own (a podio reader and event store on the same
+   *  files), up to depth events ahead of the current one, so that the decompression and the
+   *  unpacking (prepareAfterRead) of the next events overlap with the reconstruction of the current
+   *  one. The collections of the current event are taken from its buffer (the caller owns them),
+   *  next() gives the buffer back to the background thread. With maxBytes, the thread stops reading
+   *  ahead while the unpacked events waiting to be processed take more bytes (at least one event is
+   *  always read ahead). The packed cellIDs of the collections (PodioOutput cellIDPacking) are
+   *  unpacked with them.
+   *
+   *  The current event is used by one thread at a time (the event loop, or with the lock of a shared
+   *  input).
+   */
+  class InputPipeline {
+  public:
+    /// Entries first, first + stride, ... of the input, count entries, or the entries of a list
+    struct Range {
+      long long first{0};
+      long long stride{1};
+      long long count{0};
+      /// Entries to read in this order (count and stride are ignored), the range if empty
+      std::vector<long long> entries;
+
+      long long size() const { return entries.empty() ? count : static_cast<long long>(entries.size()); }
+      long long entry(long long i) const { return entries.empty() ? first + i * stride : entries[i]; }
+    };
+    struct Settings {
+      std::vector<std::string> filenames;
+      /// Collections that are read ahead, the others are read when they are taken
+      std::vector<std::string> collections;
+      Range range;
+      /// Number of events read ahead of the current one
+      unsigned depth{1};
+      /// Bytes of the events read ahead, no limit if 0
+      size_t maxBytes{0};
+      /// Read cache size of the readers, ROOT default if negative, off if 0
+      long long readCacheSize{-1};
+    };
+
+    InputPipeline() = default;
+    ~InputPipeline();
+
+    InputPipeline(const InputPipeline&)            = delete;
+    InputPipeline& operator=(const InputPipeline&) = delete;
+
+    /// Open the readers and start the background thread, false with the reason in error if the
+    /// input cannot be read
+    bool start(const Settings& settings, std::string& error);
+    /// Stop the background thread, the events not processed are deleted
+    void stop();
+
+    /// Collection of the current event (waits until it is read), owned by the caller from then on.
+    /// The collections that are not read ahead are read on this thread. nullptr if not in the input
+    /// or past the end of the range.
+    podio::CollectionBase* take(int collectionID);
+    /// Done with the current event, its buffer reads the next events
+    void next();
+
+    /// Events read, the time the event loop waited for them, and the peak bytes read ahead
+    long long events() const { return m_consumed; }
+    double waitSeconds() const { return m_waitSeconds; }
+    size_t peakBytes() const { return m_peakBytes; }
+
+  private:
+    struct Buffer;
+
+    /// Read the events of the range into the free buffers
+    void readLoop();
+    /// Read the collections of an entry into the buffer
+    void read(Buffer& buffer, long long entry);
+    /// Unpack a collection of the entry of the buffer, false if its packed cellIDs do not match
+    static bool unpack(Buffer& buffer, const std::string& name, podio::CollectionBase& collection);
+    /// Delete the collections of the buffer that were not taken and clear its caches
+    static void release(Buffer& buffer);
+    /// Wait for the next event, nullptr at the end of the range
+    Buffer* current();
+
+    Settings m_settings;
+    std::vector<std::unique_ptr<Buffer>> m_buffers;
+    /// Collection IDs and names of the collections read ahead
+    std::vector<int> m_collectionIDs;
+    std::vector<std::string> m_collectionNames;
+    /// Buffer sizes, only used on the background thread
+    CollectionBytes m_collectionBytes;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::deque<Buffer*> m_free;
+    std::deque<Buffer*> m_ready;
+    Buffer* m_current{nullptr};
+    /// Events read ahead, and the bytes of the ready events
+    long long m_read{0};
+    size_t m_readyBytes{0};
+    bool m_stop{false};
+    std::thread m_thread;
+
+    long long m_consumed{0};
+    double m_waitSeconds{0};
+    size_t m_peakBytes{0};
+  };
+
+} // namespace Jug::Base
+
+#endif
@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_INSTRUMENTATION_H
+#define JUGBASE_INSTRUMENTATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace podio {
+class CollectionBase;
+}
+
+namespace Jug::Base {
+
+/** Data accessed by the algorithm being executed on this thread.
+ *
+ *  Filled by DataHandle while an instrumentation auditor (AlgorithmStatsAuditor) has a record
+ *  installed for the calling thread, nothing is recorded otherwise.
+ *
+ * \ingroup base
+ */
+struct ExecuteRecord {
+  /// Number of objects in the collections read
+  size_t inputObjects{0};
+  /// Collections created, their sizes are taken after the execution
+  std::vector<const podio::CollectionBase*> outputs;
+  /// Wall time of the parallel sections (IConcurrencySvc), the time their tasks kept threads
+  /// busy, and the thread time they could have used (wall time times the threads usable)
+  double parallelWall{0};
+  double parallelBusy{0};
+  double parallelCapacity{0};
+
+  void clear() {
+    inputObjects = 0;
+    outputs.clear();
+    parallelWall     = 0;
+    parallelBusy     = 0;
+    parallelCapacity = 0;
+  }
+};
+
+/// Record of the algorithm executed on this thread, nullptr if not instrumented
+ExecuteRecord*& currentExecuteRecord();
+
+/** Heap allocation counters of the calling thread.
+ *
+ *  Counted by the operator new of libJugAllocCounter.so while enabled, when the job preloads it
+ *  (LD_PRELOAD=libJugAllocCounter.so); JugBase itself keeps the default allocator, and without the
+ *  library the counters are not available and stay at zero.
+ *
+ * \ingroup base
+ */
+struct AllocationCounter {
+  /// Whether libJugAllocCounter.so is preloaded
+  static bool available();
+  static void enable(bool on);
+  static bool enabled();
+  /// Bytes and number of allocations on this thread since it started
+  static uint64_t bytes();
+  static uint64_t count();
+};
+
+} // namespace Jug::Base
+
+#endif
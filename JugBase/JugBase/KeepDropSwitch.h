@@ -4,8 +4,8 @@
 #ifndef EXAMPLES_KEEPDROPSWITCH_H
 #define EXAMPLES_KEEPDROPSWITCH_H
 
-#include <map>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 std::vector<std::string> split(const std::string& s, char delim);
@@ -21,14 +21,26 @@ public:
   enum Cmd { KEEP, DROP, UNKNOWN };
   typedef std::vector<std::string> CommandLines;
   KeepDropSwitch() {}
-  explicit KeepDropSwitch(const CommandLines& cmds) { m_commandlines = cmds; }
+  /// Parses the command lines, throws std::invalid_argument if one is malformed
+  explicit KeepDropSwitch(const CommandLines& cmds);
   bool isOn(const std::string& astring) const;
 
 private:
+  /// Parsed command line, with the pattern classified for matching
+  struct Rule {
+    enum Kind { LITERAL, PREFIX, GLOB };
+    Cmd cmd;
+    Kind kind;
+    // without the trailing '*' for PREFIX
+    std::string pattern;
+    bool matches(const std::string& astring) const;
+  };
+
   bool getFlag(const std::string& astring) const;
   Cmd extractCommand(const std::string cmdLine) const;
   CommandLines m_commandlines;
-  mutable std::map<std::string, bool> m_cache;
+  std::vector<Rule> m_rules;
+  mutable std::unordered_map<std::string, bool> m_cache;
 };
 
 #endif
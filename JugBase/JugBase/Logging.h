@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_LOGGING_H
+#define JUGBASE_LOGGING_H
+
+#include <GaudiKernel/Kernel.h>
+#include <GaudiKernel/MsgStream.h>
+
+/** Debug and verbose messages of the Gaudi components, built only when their level is enabled.
+ *
+ *  The arguments are streamed into the message, e.g.
+ *
+ *    JUG_DEBUG("cell " << volman.lookupDetElement(id).path() << " with " << n << " hits");
+ *
+ *  and are not evaluated at all when the level of the component is higher, so that the messages
+ *  can be left in the loops of the events. The verbose messages are compiled out of the release
+ *  builds (NDEBUG). JugBase/scripts/check_debug_logging.py reports the debug() and verbose()
+ *  streams in loops that are neither in these macros nor guarded by msgLevel.
+ */
+#define JUG_LOG_IF_(level, stream, args)                                                                           \
+  do {                                                                                                             \
+    if (UNLIKELY(msgLevel(level))) {                                                                               \
+      stream() << args << endmsg;                                                                                  \
+    }                                                                                                              \
+  } while (false)
+
+#define JUG_DEBUG(args) JUG_LOG_IF_(MSG::DEBUG, debug, args)
+
+#ifdef NDEBUG
+#define JUG_VERBOSE(args)                                                                                          \
+  do {                                                                                                             \
+  } while (false)
+#else
+#define JUG_VERBOSE(args) JUG_LOG_IF_(MSG::VERBOSE, verbose, args)
+#endif
+
+#endif // JUGBASE_LOGGING_H
@@ -0,0 +1,29 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_OUTPUTMERGER_H
+#define JUGBASE_OUTPUTMERGER_H
+
+#include <string>
+#include <vector>
+
+namespace Jug::Base {
+
+  /** Merge of the output files of PodioOutput (e.g. of the shards of an input) into one file.
+   *
+   *  The event trees are fast-cloned: the compressed baskets are copied as they are, without
+   *  decompressing and recompressing them. The inputs must have the same collection IDs and types
+   *  (the same output configuration), since the references between the objects hold the collection
+   *  IDs. The metadata (collection IDs and types, job options) and the collection metadata are taken
+   *  from the first input, the run metadata of all the inputs are merged. The output has the
+   *  compression settings of the first input.
+   *
+   *  Returns false and the reason in error if the inputs cannot be merged, the number of merged
+   *  events in nEvents otherwise.
+   */
+  bool mergeOutputs(const std::string& output, const std::vector<std::string>& inputs, long long& nEvents,
+                    std::string& error);
+
+} // namespace Jug::Base
+
+#endif
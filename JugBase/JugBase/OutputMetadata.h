@@ -0,0 +1,33 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_OUTPUTMETADATA_H
+#define JUGBASE_OUTPUTMETADATA_H
+
+#include <string>
+#include <vector>
+
+class ISvcLocator;
+class PodioDataSvc;
+class TTree;
+
+namespace Jug::Base {
+
+  /** Job configuration as stored in the metadata of the output files (gaudiConfigOptions).
+   *
+   *  One `Component.property = "value";` line per option of the job options service, then one
+   *  string per default component that is not in it (ApplicationMgr, MessageSvc, NTupleSvc) with
+   *  its properties. Quotes are added to all values, also to ints, lists, dicts and bools, for
+   *  which they are removed in postprocessing.
+   */
+  std::vector<std::string> outputConfigOptions(ISvcLocator& svcLocator);
+
+  /// Fill the metadata trees of an output file at the end of the job: the job configuration and the
+  /// collection IDs in metadata, the collection and run metadata of the store in col_metadata and
+  /// run_metadata. The trees are written with their file.
+  void fillOutputMetadata(ISvcLocator& svcLocator, PodioDataSvc& podioDataSvc, TTree& metadata, TTree& colMD,
+                          TTree& runMD);
+
+} // namespace Jug::Base
+
+#endif
@@ -0,0 +1,160 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_PACKEDCELLIDS_H
+#define JUGBASE_PACKEDCELLIDS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <podio/CollectionBase.h>
+
+class TBranch;
+class TChain;
+class TVirtualCollectionProxy;
+
+namespace Jug::Base {
+
+  /** Sorted, delta-encoded cellIDs of the raw hit collections.
+   *
+   *  The elements of a data buffer (vector of e.g. RawCalorimeterHitData, with a 64-bit cellID at
+   *  offset in elements of stride bytes) are sorted by cellID, the cellIDs are written as the
+   *  LEB128 varints of their differences to the previous one into a blob (the branch name_cellIDs
+   *  of the collection name) and zeroed in the elements, which then compress to almost nothing.
+   *  Unpacking writes them back. Sorting changes the order of the elements: the OneToOne reference
+   *  vectors of the collection (one ObjectID per element) are permuted with them, but the
+   *  collections whose elements are referenced by others (e.g. by associations) must not be packed.
+   */
+  namespace PackedCellIDs {
+
+    inline std::string branchName(const std::string& collName) { return collName + "_cellIDs"; }
+
+    /// Reorder the n elements of stride bytes, element i becomes element order[i]
+    inline void permute(const std::vector<uint32_t>& order, char* first, size_t stride, std::vector<char>& scratch) {
+      const size_t n = order.size();
+      scratch.resize(n * stride);
+      for (size_t i = 0; i < n; ++i) {
+        std::memcpy(scratch.data() + i * stride, first + order[i] * stride, stride);
+      }
+      if (n > 0) {
+        std::memcpy(first, scratch.data(), n * stride);
+      }
+    }
+
+    /// Sort the n elements by cellID and pack their cellIDs into the blob, with the order of the sort
+    /// (element i was element order[i]) to permute the buffers indexed by element alike
+    inline void pack(char* first, size_t n, size_t stride, size_t offset, std::vector<uint8_t>& blob,
+                     std::vector<uint32_t>& order, std::vector<char>& scratch) {
+      blob.clear();
+      order.resize(n);
+      if (n == 0) {
+        return;
+      }
+      auto cellID = [&](size_t i) {
+        uint64_t id = 0;
+        std::memcpy(&id, first + i * stride + offset, sizeof(id));
+        return id;
+      };
+      std::iota(order.begin(), order.end(), 0);
+      std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return cellID(a) < cellID(b); });
+      permute(order, first, stride, scratch);
+
+      uint64_t previous   = 0;
+      const uint64_t zero = 0;
+      for (size_t i = 0; i < n; ++i) {
+        const uint64_t id = cellID(i);
+        uint64_t delta    = id - previous;
+        previous          = id;
+        while (delta >= 0x80) {
+          blob.push_back(static_cast<uint8_t>(delta | 0x80));
+          delta >>= 7;
+        }
+        blob.push_back(static_cast<uint8_t>(delta));
+        std::memcpy(first + i * stride + offset, &zero, sizeof(zero));
+      }
+    }
+
+    /// Write the cellIDs of the blob back into the n elements, false if the blob does not have n
+    inline bool unpack(const std::vector<uint8_t>& blob, char* first, size_t n, size_t stride, size_t offset) {
+      uint64_t previous = 0;
+      size_t pos        = 0;
+      for (size_t i = 0; i < n; ++i) {
+        uint64_t delta = 0;
+        unsigned shift = 0;
+        bool last      = false;
+        while (!last) {
+          if (pos >= blob.size() || shift >= 64) {
+            return false;
+          }
+          const uint8_t byte = blob[pos++];
+          delta |= static_cast<uint64_t>(byte & 0x7F) << shift;
+          shift += 7;
+          last = (byte & 0x80) == 0;
+        }
+        previous += delta;
+        std::memcpy(first + i * stride + offset, &previous, sizeof(previous));
+      }
+      return pos == blob.size();
+    }
+
+  } // namespace PackedCellIDs
+
+  /// Elements of the data buffer of a collection type with a 64-bit cellID member, from its dictionary
+  class CellIDLayout {
+  public:
+    /// Layout of the data type (e.g. edm4hep::RawCalorimeterHitData), invalid without cellID
+    explicit CellIDLayout(const std::string& dataType);
+    ~CellIDLayout();
+    CellIDLayout(const CellIDLayout&)            = delete;
+    CellIDLayout& operator=(const CellIDLayout&) = delete;
+
+    bool valid() const { return m_proxy != nullptr; }
+    size_t offset() const { return m_offset; }
+    /// Number of the index ranges (name_begin) of the data type, of its OneToMany relations and vector members
+    size_t ranges() const { return m_ranges; }
+
+    /// First element, number and stride of the elements of the data buffer of a collection
+    char* elements(void* dataBuffer, size_t& n, size_t& stride) const;
+
+  private:
+    std::unique_ptr<TVirtualCollectionProxy> m_proxy;
+    size_t m_offset{0};
+    size_t m_ranges{0};
+  };
+
+  /// Unpacks the packed cellIDs of the collections read from a chain
+  class PackedCellIDReader {
+  public:
+    PackedCellIDReader();
+    ~PackedCellIDReader();
+    PackedCellIDReader(const PackedCellIDReader&)            = delete;
+    PackedCellIDReader& operator=(const PackedCellIDReader&) = delete;
+
+    /** Unpack the cellIDs of a collection read from entry of the chain, before prepareAfterRead.
+     *
+     *  Nothing is done for the collections without packed cellIDs, false if the packed cellIDs
+     *  do not match the collection.
+     */
+    bool unpack(TChain& chain, long long entry, const std::string& collName, podio::CollectionBase& collection);
+
+  private:
+    struct Branch {
+      int treeNumber{-1};
+      TBranch* branch{nullptr};
+    };
+    std::unordered_map<std::string, Branch> m_branches;
+    std::unordered_map<std::string, std::unique_ptr<CellIDLayout>> m_layouts;
+    std::vector<uint8_t> m_blob;
+    std::vector<uint8_t>* m_blobAddress{&m_blob};
+  };
+
+} // namespace Jug::Base
+
+#endif
@@ -0,0 +1,339 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_PIPELINE_H
+#define JUGBASE_PIPELINE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "JugBase/Algorithm.h"
+#include "JugBase/Utilities/Philox.h"
+
+namespace Jug {
+
+  /// Collections of an event given to a pipeline, by name. The caller keeps them alive during process.
+  class EventInputs {
+  public:
+    template <class T> void set(const std::string& name, const T& collection) {
+      m_collections.insert_or_assign(name, std::make_pair(std::type_index(typeid(T)), &collection));
+    }
+    /// Collection of the name and type, nullptr if none
+    template <class T> const T* get(const std::string& name) const {
+      auto it = m_collections.find(name);
+      if (it == m_collections.end() || it->second.first != std::type_index(typeid(T))) {
+        return nullptr;
+      }
+      return static_cast<const T*>(it->second.second);
+    }
+    void clear() { m_collections.clear(); }
+
+  private:
+    std::unordered_map<std::string, std::pair<std::type_index, const void*>> m_collections;
+  };
+
+  /** Collections made by the algorithms of a pipeline in an event, by name.
+   *
+   *  The slots are made once by Pipeline::makeOutputs and reused for every event processed with
+   *  them, the collections of an event replace those of the previous one.
+   */
+  class EventOutputs {
+  public:
+    /// Collection of the name and type, throws std::out_of_range if none
+    template <class T> const T& get(const std::string& name) const { return slot<T>(find(name)).value; }
+    /// Move the collection out of its slot, which is refilled by the next event
+    template <class T> T take(const std::string& name) { return std::move(slot<T>(find(name)).value); }
+    bool contains(const std::string& name) const { return m_index.count(name) != 0; }
+    const std::vector<std::string>& names() const { return m_names; }
+
+  private:
+    friend class Pipeline;
+
+    struct SlotBase {
+      virtual ~SlotBase() = default;
+      virtual std::type_index type() const = 0;
+    };
+    template <class T> struct Slot : SlotBase {
+      T value;
+      std::type_index type() const override { return std::type_index(typeid(T)); }
+    };
+
+    template <class T> size_t add(const std::string& name) {
+      m_index.emplace(name, m_slots.size());
+      m_names.push_back(name);
+      m_slots.push_back(std::make_unique<Slot<T>>());
+      return m_slots.size() - 1;
+    }
+    size_t find(const std::string& name) const {
+      auto it = m_index.find(name);
+      if (it == m_index.end()) {
+        throw std::out_of_range("No output collection " + name);
+      }
+      return it->second;
+    }
+    template <class T> Slot<T>& slot(size_t index) const {
+      if (m_slots[index]->type() != std::type_index(typeid(T))) {
+        throw std::invalid_argument("Output collection " + m_names[index] + " is not of type " + typeid(T).name());
+      }
+      return static_cast<Slot<T>&>(*m_slots[index]);
+    }
+
+    std::unordered_map<std::string, size_t> m_index;
+    std::vector<std::string> m_names;
+    std::vector<std::unique_ptr<SlotBase>> m_slots;
+  };
+
+  /** Chain of framework-independent algorithms run on events in memory, without Gaudi.
+   *
+   *  The algorithms are added in the order they run, with their properties and the names of their
+   *  input and output collections (the input and output names of the algorithm by default). An
+   *  input is the output of an earlier algorithm, or else taken from the EventInputs of the caller.
+   *  After initialize, process runs the chain on the caller's thread, filling the preallocated
+   *  slots of an EventOutputs. process is const: threads with an EventOutputs each can process
+   *  events concurrently with one pipeline.
+   *
+   *  The random numbers are those of RandomSvc with the same seed and run, so that the pipeline
+   *  reproduces the Gaudi job event by event.
+   *
+   *      Jug::Pipeline pipeline;
+   *      pipeline.add<Jug::Digi::CalorimeterHitDigi>("EcalDigi", {{"pedestalSigma", 2.0}},
+   *                                                  {{"inputHitCollection", "EcalHits"}});
+   *      if (std::string err; !pipeline.initialize(detector, err)) { ... }
+   *      auto outputs = pipeline.makeOutputs();
+   *      pipeline.process(inputs, outputs, eventNumber);
+   */
+  class Pipeline {
+  public:
+    /// Values of the properties, as the types of AlgorithmBase::PropertyRef
+    using PropertyValue = std::variant<bool, int, unsigned int, uint64_t, double, std::string, std::vector<int>,
+                                       std::vector<double>, std::vector<std::string>,
+                                       std::vector<std::pair<double, double>>>;
+    using Properties  = std::map<std::string, PropertyValue>;
+    /// Collection names of the inputs and outputs of an algorithm, by their names in the algorithm
+    using Collections = std::map<std::string, std::string>;
+
+    struct Settings {
+      /// Seed and run of the random numbers, as for RandomSvc
+      uint64_t seed{1};
+      uint64_t run{0};
+      LogLevel logLevel{LogLevel::kInfo};
+      /// Sink of the messages of the algorithms, std::cout and std::cerr if empty
+      LogMessage::Sink logSink;
+    };
+
+    Pipeline() = default;
+    explicit Pipeline(Settings settings) : m_settings(std::move(settings)) {}
+    Pipeline(const Pipeline&)            = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    /// Add an algorithm, throws std::invalid_argument for an unknown property or a value of another type
+    template <class Algo> Algo& add(const std::string& name, const Properties& properties = {},
+                                    const Collections& collections = {}) {
+      auto stage  = std::make_unique<Stage<Algo>>(name);
+      Algo& algo  = stage->algo;
+      for (const auto& [key, value] : properties) {
+        setProperty(algo, key, value);
+      }
+      for (const auto& key : algo.inputNames()) {
+        stage->inputs.push_back(collectionName(collections, key));
+      }
+      for (const auto& key : algo.outputNames()) {
+        stage->outputs.push_back(collectionName(collections, key));
+      }
+      m_stages.push_back(std::move(stage));
+      return algo;
+    }
+
+    /// Initialize the algorithms and connect the collections, false with the reason in error
+    bool initialize(const dd4hep::Detector* detector, std::string& error) {
+      m_jobKey = Base::Random::job_key(m_settings.seed, m_settings.run);
+      std::unordered_map<std::string, std::pair<size_t, std::type_index>> produced;
+      m_nSlots = 0;
+      for (auto& stage : m_stages) {
+        auto& algo = stage->base();
+        if (m_settings.logSink) {
+          algo.setLogSink(m_settings.logSink);
+        }
+        algo.setLogLevel(m_settings.logLevel);
+        if (!stage->connect(produced, m_nSlots, error)) {
+          error = algo.name() + ": " + error;
+          return false;
+        }
+        if (!algo.initialize(detector)) {
+          error = algo.name() + ": initialization failed";
+          return false;
+        }
+      }
+      m_initialized = true;
+      return true;
+    }
+
+    /// Slots for the outputs of all the algorithms, reused for every event
+    EventOutputs makeOutputs() const {
+      EventOutputs outputs;
+      for (const auto& stage : m_stages) {
+        stage->addSlots(outputs);
+      }
+      return outputs;
+    }
+
+    /// Run the algorithms on an event, throws std::invalid_argument for a missing input and the
+    /// exceptions of the algorithms
+    void process(const EventInputs& inputs, EventOutputs& outputs, uint64_t event = 0) const {
+      if (!m_initialized || outputs.m_slots.size() != m_nSlots) {
+        throw std::logic_error("Pipeline not initialized, or outputs not made by makeOutputs");
+      }
+      for (const auto& stage : m_stages) {
+        AlgorithmContext context;
+        context.event     = event;
+        context.randomKey = Base::Random::event_key(m_jobKey, stage->base().randomName(), event);
+        stage->run(inputs, outputs, context);
+      }
+    }
+    EventOutputs process(const EventInputs& inputs, uint64_t event = 0) const {
+      auto outputs = makeOutputs();
+      process(inputs, outputs, event);
+      return outputs;
+    }
+
+    size_t size() const { return m_stages.size(); }
+
+  private:
+    struct StageBase {
+      virtual ~StageBase() = default;
+      virtual AlgorithmBase& base() = 0;
+      virtual const AlgorithmBase& base() const = 0;
+      /// Resolve the inputs to the outputs of the earlier stages, and number the outputs
+      virtual bool connect(std::unordered_map<std::string, std::pair<size_t, std::type_index>>& produced,
+                           size_t& nSlots, std::string& error) = 0;
+      virtual void addSlots(EventOutputs& outputs) const = 0;
+      virtual void run(const EventInputs& inputs, EventOutputs& outputs, const AlgorithmContext& context) const = 0;
+
+      std::vector<std::string> inputs;
+      std::vector<std::string> outputs;
+    };
+
+    template <class Algo, class In = typename Algo::InputTypes, class Out = typename Algo::OutputTypes>
+    struct Stage;
+
+    template <class Algo, class... In, class... Out>
+    struct Stage<Algo, Input<In...>, Output<Out...>> : StageBase {
+      explicit Stage(const std::string& name) : algo(name) {}
+
+      AlgorithmBase& base() override { return algo; }
+      const AlgorithmBase& base() const override { return algo; }
+
+      bool connect(std::unordered_map<std::string, std::pair<size_t, std::type_index>>& produced, size_t& nSlots,
+                   std::string& error) override {
+        const std::type_index inputTypes[]  = {std::type_index(typeid(In))..., std::type_index(typeid(void))};
+        const std::type_index outputTypes[] = {std::type_index(typeid(Out))..., std::type_index(typeid(void))};
+        inputSlots.assign(inputs.size(), kExternal);
+        for (size_t i = 0; i < inputs.size(); ++i) {
+          auto it = produced.find(inputs[i]);
+          if (it == produced.end()) {
+            continue;
+          }
+          if (it->second.second != inputTypes[i]) {
+            error = "input " + inputs[i] + " is made with another type";
+            return false;
+          }
+          inputSlots[i] = it->second.first;
+        }
+        outputSlots.clear();
+        for (size_t o = 0; o < outputs.size(); ++o) {
+          if (!produced.emplace(outputs[o], std::make_pair(nSlots, outputTypes[o])).second) {
+            error = "output " + outputs[o] + " is already made by another algorithm";
+            return false;
+          }
+          outputSlots.push_back(nSlots++);
+        }
+        return true;
+      }
+
+      void addSlots(EventOutputs& eventOutputs) const override {
+        size_t o = 0;
+        (eventOutputs.add<Out>(outputs[o++]), ...);
+      }
+
+      void run(const EventInputs& eventInputs, EventOutputs& eventOutputs,
+               const AlgorithmContext& context) const override {
+        runImpl(eventInputs, eventOutputs, context, std::index_sequence_for<In...>{},
+                std::index_sequence_for<Out...>{});
+      }
+
+      template <size_t... I, size_t... O>
+      void runImpl(const EventInputs& eventInputs, EventOutputs& eventOutputs, const AlgorithmContext& context,
+                   std::index_sequence<I...> /* inputs */, std::index_sequence<O...> /* outputs */) const {
+        const typename Algo::Input in{input<In>(eventInputs, eventOutputs, I)...};
+        auto out = algo.execute(in, context);
+        ((eventOutputs.template slot<Out>(outputSlots[O]).value = std::move(std::get<O>(out))), ...);
+      }
+
+      template <class T>
+      const T& input(const EventInputs& eventInputs, const EventOutputs& eventOutputs, size_t i) const {
+        if (inputSlots[i] != kExternal) {
+          return eventOutputs.template slot<T>(inputSlots[i]).value;
+        }
+        const T* collection = eventInputs.get<T>(inputs[i]);
+        if (collection == nullptr) {
+          throw std::invalid_argument(algo.name() + ": missing input " + inputs[i]);
+        }
+        return *collection;
+      }
+
+      static constexpr size_t kExternal = static_cast<size_t>(-1);
+      Algo algo;
+      std::vector<size_t> inputSlots;
+      std::vector<size_t> outputSlots;
+    };
+
+    static std::string collectionName(const Collections& collections, const std::string& key) {
+      auto it = collections.find(key);
+      return (it != collections.end()) ? it->second : key;
+    }
+
+    static void setProperty(AlgorithmBase& algo, const std::string& key, const PropertyValue& value) {
+      auto it = algo.properties().find(key);
+      if (it == algo.properties().end()) {
+        throw std::invalid_argument(algo.name() + ": unknown property " + key);
+      }
+      std::visit(
+          [&](auto* ref) {
+            using T = std::remove_pointer_t<decltype(ref)>;
+            if (const auto* typed = std::get_if<T>(&value); typed != nullptr) {
+              *ref = *typed;
+            } else if (const auto* number = std::get_if<int>(&value);
+                       number != nullptr && std::is_arithmetic_v<T> && !std::is_same_v<T, bool>) {
+              // integer literals for the other numeric types
+              if constexpr (std::is_arithmetic_v<T>) {
+                *ref = static_cast<T>(*number);
+              }
+            } else {
+              throw std::invalid_argument(algo.name() + ": wrong type for property " + key);
+            }
+          },
+          it->second);
+    }
+
+    Settings m_settings;
+    std::vector<std::unique_ptr<StageBase>> m_stages;
+    uint64_t m_jobKey{0};
+    size_t m_nSlots{0};
+    bool m_initialized{false};
+  };
+
+} // namespace Jug
+
+#endif
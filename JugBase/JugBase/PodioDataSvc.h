@@ -5,6 +5,7 @@
 #define JUGBASE_PODIODATASVC_H
 
 #include <GaudiKernel/DataSvc.h>
+#include <GaudiKernel/IAlgContextSvc.h>
 #include <GaudiKernel/IConversionSvc.h>
 // PODIO
 #include <podio/CollectionBase.h>
@@ -12,8 +13,24 @@
 #include <podio/EventStore.h>
 #include <podio/ROOTReader.h>
 
+#include "JugBase/CollectionBytes.h"
+#include "JugBase/CollectionKeys.h"
+#include "JugBase/EventParameters.h"
+#include "JugBase/InputPipeline.h"
+#include "JugBase/EventArena.h"
+#include "JugBase/KeepDropSwitch.h"
+#include "JugBase/PackedCellIDs.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
 #include <utility>
 // Forward declarations
+class DataWrapperBase;
+class EventContext;
+class TChain;
 
 /** @class PodioEvtSvc EvtDataSvc.h
  *
@@ -24,6 +41,8 @@
  *  \ingroup base
  */
 class PodioDataSvc : public DataSvc {
+  friend class PodioHiveWhiteBoard;
+
 public:
   typedef std::vector<std::pair<std::string, podio::CollectionBase*>> CollRegistry;
 
@@ -32,6 +51,7 @@ public:
    *  - registers input filenames  
    */
   virtual StatusCode initialize() override;
+  virtual StatusCode start() override;
   virtual StatusCode reinitialize() override;
   virtual StatusCode finalize() override;
   virtual StatusCode clearStore() override;
@@ -42,6 +62,12 @@ public:
   /// Standard Destructor
   virtual ~PodioDataSvc();
 
+  /// The podio store behind an event data service: the service itself, or the store of the
+  /// current event slot of a PodioHiveWhiteBoard. nullptr for other services.
+  static PodioDataSvc* fromEventSvc(IDataProviderSvc* svc);
+  /// The podio store of the slot of an event, whatever slot the calling thread selected
+  static PodioDataSvc* fromEventSvc(IDataProviderSvc* svc, const EventContext& ctx);
+
   // Use DataSvc functionality except where we override
   using DataSvc::registerObject;
   /// Overriding standard behaviour of evt service
@@ -49,24 +75,150 @@ public:
   virtual StatusCode registerObject(std::string_view parentPath,
                                     std::string_view fullPath,
                                     DataObject* pObject) override final;
+  using DataSvc::retrieveObject;
+  /// Reads a lazy collection from the input on its first retrieval
+  virtual StatusCode retrieveObject(IRegistry* pDirectory, std::string_view path, DataObject*& pObject) override;
+  using DataSvc::findObject;
+  virtual StatusCode findObject(IRegistry* pDirectory, std::string_view path, DataObject*& pObject) override;
+  virtual StatusCode findObject(std::string_view fullPath, DataObject*& pObject) override;
+  using DataSvc::unregisterObject;
+  virtual StatusCode unregisterObject(std::string_view fullPath) override;
+
+  /// Key of a collection (by name or path in the store), the same for the stores that share the input
+  uint32_t collectionKey(std::string_view path) { return m_keys->key(shortName(path)); }
+  /// Collections of the event by key instead of by path in the Gaudi registry. Set by option flatStore
+  bool flatStore() const { return m_flatStore; }
+  /// Collection of the event with the key in the flat store, nullptr if none (or not read yet)
+  DataObject* flatObject(uint32_t key) const { return (key < m_flatObjects.size()) ? m_flatObjects[key] : nullptr; }
+  /// Register the collection of a data handle by key, the store owns the wrapper
+  StatusCode registerCollection(uint32_t key, DataWrapperBase* wrapper);
+  /// Scalar values of the event, written as one branch by PodioOutput (see Jug::Base::EventParameter)
+  Jug::Base::EventParameters& eventParameters() { return m_eventParameters; }
 
   StatusCode readCollection(const std::string& collectionName, int collectionID);
+  /// Register a collection read from another file (e.g. a stage cache) as a collection of the
+  /// input, prepared after read with the collection ID of the job; the store owns it
+  StatusCode putReadCollection(const std::string& collectionName, podio::CollectionBase* collection);
+  /// Register a collection that is read from the input only when it is first retrieved in the event
+  void registerLazyCollection(const std::string& collectionName, int collectionID);
+  /// Read the lazy collections of the event that are kept by the switch (e.g. for writing them)
+  StatusCode readLazyCollections(const KeepDropSwitch& keep);
 
   virtual const CollRegistry& getCollections() const { return m_collections; }
   virtual const CollRegistry& getReadCollections() const { return m_readCollections; }
   podio::EventStore& getProvider() { return m_provider; }
   virtual podio::CollectionIDTable* getCollectionIDs() { return m_collectionIDs; }
 
+  /// Shard of the event range that is read, and the number of shards
+  unsigned shard() const { return m_shard; }
+  unsigned numShards() const { return m_nShards; }
+  /// Whether events are read from input files
+  bool readsInput() const { return !m_filenames.empty() && !m_filenames[0].empty(); }
+  /// Input files of the job
+  const std::vector<std::string>& inputFiles() const { return m_filenames; }
+
+  /// Read shard worker of numWorkers of the shard of the job (in a forked worker, the input is
+  /// reopened), or no events in the parent of the workers (worker -1)
+  StatusCode selectWorker(int worker, unsigned numWorkers);
+  /// Stop the run before its first event if the event range is empty (endOfRead stops it after
+  /// the last event of the others)
+  StatusCode stopOnEmptyRange();
+  /// Forked worker reading the events, -1 in the parent and without workers
+  int worker() const { return m_worker; }
+  unsigned numWorkers() const { return m_numWorkers; }
+  bool forkParent() const { return m_numWorkers > 1 && m_worker < 0; }
+
+  /// Whether the input reader is shared with the stores of other event slots
+  bool sharedInput() const { return m_sharedMutex != nullptr; }
+  /// Lock held while the collections of an event are read from a shared input (no-op otherwise)
+  std::unique_lock<std::mutex> lockInput() {
+    return (m_sharedMutex != nullptr) ? std::unique_lock<std::mutex>(*m_sharedMutex) : std::unique_lock<std::mutex>();
+  }
+
+  /// Lock serializing the store accesses of the algorithms of the event that run concurrently
+  /// (intra-event scheduling with a PodioHiveWhiteBoard), no-op for a sequential store
+  std::unique_lock<std::recursive_mutex> lockStore() {
+    return m_concurrentAccess ? std::unique_lock<std::recursive_mutex>(m_storeMutex)
+                              : std::unique_lock<std::recursive_mutex>();
+  }
+
   /// Set the collection IDs (if reading a file)
   void setCollectionIDs(podio::CollectionIDTable* collectionIds);
-  /// Resets caches of reader and event store, increases event counter
+  /// Resets caches of reader and event store, increases event counter.
+  /// Deferred to the clearing of the store while lazy collections may still be read.
   void endOfRead();
 
 
   TTree* eventDataTree() {return m_eventDataTree;}
 
+  /// Add an output stream (PodioOutput) writing the events, returns its index. The first stream
+  /// writes eventDataTree, the others trees of their own.
+  unsigned addOutputStream() { return m_inputSvc->m_outputStreams++; }
+  unsigned outputStreams() const { return m_inputSvc->m_outputStreams; }
+  /// Prepare the collections of the event for writing, once for all the output streams
+  void prepareForWrite();
+
+  /// Counter incremented whenever the store is cleared, objects retrieved with the same value are still valid
+  uint64_t generation() const { return m_generation; }
+
+  /// Restrict the read cache of the input to the branches of these collections
+  void setCachedCollections(const std::vector<std::string>& collectionNames);
+
+  /// Arena for the collections created during the event, nullptr if disabled
+  EventArena* eventArena() { return m_useEventArena ? &m_eventArena : nullptr; }
+
+  /// Whether the collections created during the event are kept and reused in the next events
+  bool recycleCollections() const { return m_recycleCollections; }
+  /// Collection kept across events for the given key, created on first use.
+  /// Its content is cleared with the store, its reserved capacity is kept.
+  template <typename T> T* recycledCollection(const std::string& key) {
+    auto lock  = lockStore();
+    auto& coll = m_recycledCollections[key];
+    T* typed   = dynamic_cast<T*>(coll.get());
+    if (typed == nullptr) {
+      auto created = std::make_unique<T>();
+      typed        = created.get();
+      coll         = std::move(created);
+    }
+    return typed;
+  }
+
+  /// Whether the collections are created with the capacity they needed in the previous events
+  bool adaptiveReserve() const { return m_adaptiveReserve; }
+  /// Largest size of the collection with this name (or data handle key) in the previous events, 0 if unknown
+  size_t capacityHint(std::string_view key) const;
+
+  /// Bytes of the buffers of the collections of the current event
+  size_t eventBytes();
+  /// Whether the collections of the current event fit in maxEventBytes (always if 0), warns otherwise
+  bool withinMemoryBudget();
 
 private:
+  /// Name of a collection from its path in the store
+  static std::string_view shortName(std::string_view path) {
+    const size_t pos = path.find_last_of('/');
+    return (pos == std::string_view::npos) ? path : path.substr(pos + 1);
+  }
+  /// Set the collection ID of a registered collection and add it to the collections of the event
+  void addCollection(uint32_t key, DataWrapperBase* wrapper);
+  /// Collection ID of a key, added to the collection ID table on the first use
+  int collectionID(uint32_t key);
+  /// Add an object to the flat store, which owns it until the store is cleared
+  StatusCode registerFlat(uint32_t key, DataObject* object);
+  /// Pipeline reading the input ahead, started on the first call; nullptr without readAhead or if it
+  /// cannot be started
+  Jug::Base::InputPipeline* inputPipeline();
+  /// Open the input files and apply the read cache settings and the event range
+  StatusCode openInput();
+  /// Apply the event range and shard selection to the reader
+  StatusCode selectEventRange();
+  /// Entries of the chain of eventList and eventListFile, sorted and without duplicates
+  StatusCode resolveEventList(std::vector<long long>& entries);
+  /// Read the input through the store of another slot and share its collection IDs
+  void shareInput(PodioDataSvc* input, std::mutex* mutex);
+  /// Update the peaks with the collections of the event, before the store is cleared
+  void accountMemory();
+  void reportMemory() const;
 
   // eventDataTree
   TTree* m_eventDataTree;
@@ -76,8 +228,27 @@ private:
   podio::EventStore m_provider;
   /// Counter of the event number
   int m_eventNum{0};
+  /// Number of times the store was cleared
+  uint64_t m_generation{0};
   /// Number of events in the file / to process
   int m_eventMax{-1};
+  /// Entry of the current event in the input chain and the step to the next one
+  long long m_eventEntry{0};
+  long long m_eventStride{1};
+  /// Entries of the event list read by the shard, in order, empty without event list
+  std::vector<long long> m_eventEntries;
+  /// Chain of the reader, nullptr if not found
+  TChain* m_inputChain{nullptr};
+  /// Unpacking of the packed cellIDs of the input collections (PodioOutput cellIDPacking)
+  Jug::Base::PackedCellIDReader m_packedCellIDs;
+  /// Collections of the read cache, applied again when the input is reopened
+  std::vector<std::string> m_cachedCollections;
+  /// Forked worker and the number of workers (selectWorker)
+  int m_worker{-1};
+  unsigned m_numWorkers{1};
+  /// Events read and unpacked ahead on a background thread (readAhead)
+  std::unique_ptr<Jug::Base::InputPipeline> m_pipeline;
+  bool m_pipelineFailed{false};
 
 
   SmartIF<IConversionSvc> m_cnvSvc;
@@ -86,6 +257,44 @@ private:
   std::vector<std::pair<std::string, podio::CollectionBase*>> m_collections;
   std::vector<std::pair<std::string, podio::CollectionBase*>> m_readCollections;
   podio::CollectionIDTable* m_collectionIDs;
+  bool m_ownsCollectionIDs{true};
+  /// Interned collection names, shared with the stores that share the input
+  std::shared_ptr<Jug::Base::CollectionKeys> m_keys{std::make_shared<Jug::Base::CollectionKeys>()};
+  /// Collection IDs by key, -1 if not known yet
+  std::vector<int> m_keyCollectionIDs;
+  /// Flat store: the objects of the event by key, and the keys of the registered objects
+  std::vector<DataObject*> m_flatObjects;
+  std::vector<uint32_t> m_flatKeys;
+  /// Scalar values of the event, the layout is shared with the stores that share the input
+  Jug::Base::EventParameters m_eventParameters;
+  /// Store reading the input (this one unless shared) and the lock of the shared input and IDs
+  PodioDataSvc* m_inputSvc{this};
+  std::mutex* m_sharedMutex{nullptr};
+  /// Whether several algorithms of the event may access the store at the same time, and its lock
+  bool m_concurrentAccess{false};
+  std::recursive_mutex m_storeMutex;
+  /// Collections created in the event, reset when the store is cleared
+  EventArena m_eventArena;
+  /// Collections reused across events, by data handle key
+  std::unordered_map<std::string, std::unique_ptr<podio::CollectionBase>> m_recycledCollections;
+  /// Running maximum of the sizes of the created collections, by name, updated when the store is cleared
+  std::unordered_map<std::string, size_t> m_capacityHints;
+  /// Largest bytes of a collection, of the collections of an algorithm and of an event
+  std::unordered_map<std::string, size_t> m_collectionPeaks;
+  std::unordered_map<std::string, size_t> m_algorithmPeaks;
+  size_t m_eventPeak{0};
+  /// Algorithm that registered each of m_collections, for the accounting
+  std::vector<std::string> m_producers;
+  SmartIF<IAlgContextSvc> m_algContextSvc;
+  /// Bytes of the buffers of the collections, for the accounting and the memory budget
+  Jug::Base::CollectionBytes m_collectionBytes;
+  /// Collections of the event not read yet, by name, and whether the end of the read is deferred
+  std::unordered_map<std::string, int> m_lazyCollections;
+  bool m_lazyEndOfRead{false};
+  /// Output streams of the job, and the collections of the event already prepared for writing
+  unsigned m_outputStreams{0};
+  size_t m_preparedCollections{0};
+  size_t m_preparedReadCollections{0};
 
 protected:
   /// ROOT file name the input is read from. Set by option filename
@@ -94,5 +303,39 @@ protected:
   /// Jump to nth events at the beginning. Set by option FirstEventEntry
   /// This option is helpful when we want to debug an event in the middle of a file
   unsigned m_1stEvtEntry{0};
+  /// End (exclusive) of the event range, end of the input if negative. Set by option LastEventEntry
+  long long m_lastEvtEntry{-1};
+  /// Events to read instead of the event range, as entries of the input ('<entry>') or of one of its
+  /// files ('<file index or name>:<entry>'). Set by options eventList and eventListFile (one per line)
+  std::vector<std::string> m_eventList;
+  std::string m_eventListFile;
+  /// Read only shard m_shard of m_nShards of the event range. Set by options Shard and NumShards
+  unsigned m_shard{0};
+  unsigned m_nShards{1};
+  /// Shards of every n-th event instead of contiguous blocks. Set by option InterleavedShards
+  bool m_interleavedShards{false};
+  /// Create the event collections in an arena that is reused across events. Set by option useEventArena
+  bool m_useEventArena{false};
+  /// Keep the event collections and reuse them in the next events. Set by option recycleCollections
+  bool m_recycleCollections{false};
+  /// Reserve the largest size of the previous events when creating a collection. Set by option adaptiveReserve
+  bool m_adaptiveReserve{false};
+  /// Keep the collections of the event in the flat store by key, not in the Gaudi registry. Set by option flatStore
+  bool m_flatStore{false};
+  /// Size of the TTreeCache of the input in bytes, ROOT default if negative, off if 0. Set by option readCacheSize
+  long long m_readCacheSize{-1};
+  /// Number of entries of the cache learning phase, ROOT default if 0. Set by option readCacheLearnEntries
+  int m_readCacheLearnEntries{0};
+  /// Prefetch the cached baskets asynchronously. Set by option asyncPrefetching
+  bool m_asyncPrefetching{false};
+  /// Number of events read and unpacked ahead on a background thread, off if 0. Set by option readAhead
+  unsigned m_readAhead{0};
+  /// Bytes of the unpacked events read ahead, no limit if 0. Set by option readAheadMaxBytes
+  long long m_readAheadMaxBytes{0};
+  /// Report the peak bytes per collection and per algorithm at finalize. Set by option memoryAccounting
+  bool m_memoryAccounting{false};
+  /// Events with collections of more bytes are not written (with a warning), no limit if 0.
+  /// Set by option maxEventBytes
+  long long m_maxEventBytes{0};
 };
 #endif  
@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_PODIOHIVEWHITEBOARD_H
+#define JUGBASE_PODIOHIVEWHITEBOARD_H
+
+#include <GaudiKernel/IDataManagerSvc.h>
+#include <GaudiKernel/IDataProviderSvc.h>
+#include <GaudiKernel/IHiveWhiteBoard.h>
+#include <GaudiKernel/Service.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+class PodioDataSvc;
+
+/** Multi-slot event store for the Gaudi Hive scheduler.
+ *
+ *  Holds one PodioDataSvc per event slot and forwards the data store interfaces to the slot
+ *  selected on the calling thread (selectStore), in the same way as the Gaudi HiveWhiteBoard.
+ *  The input files are opened by the first slot only: all slots read their events from its
+ *  reader, one event at a time, and share its collection ID table, so that the output can be
+ *  written from any slot. Lazy collection reading is not available with more than one slot.
+ *  The accesses to the store of a slot are serialized (PodioDataSvc::lockStore), so that the
+ *  scheduler can run the independent algorithms of an event (e.g. the calorimeter, tracking and
+ *  PID chains) at the same time.
+ *
+ *  Configure it as the EventDataSvc, e.g. PodioHiveWhiteBoard("EventDataSvc", EventSlots=4).
+ *
+ * \ingroup base
+ */
+class PodioHiveWhiteBoard : public extends<Service, IDataProviderSvc, IDataManagerSvc, IHiveWhiteBoard> {
+public:
+  using extends::extends;
+
+  StatusCode initialize() override;
+  StatusCode start() override;
+  StatusCode finalize() override;
+
+  /// The store of the slot selected on this thread
+  PodioDataSvc* currentStore();
+  /// The store of a slot, nullptr for slots that do not exist
+  PodioDataSvc* store(size_t slot);
+
+  // IHiveWhiteBoard
+  StatusCode selectStore(size_t partition) override;
+  StatusCode clearStore(size_t partition) override;
+  StatusCode setNumberOfStores(size_t slots) override;
+  size_t getNumberOfStores() const override { return m_slots.value(); }
+  size_t allocateStore(int evtnumber) override;
+  StatusCode freeStore(size_t partition) override;
+  size_t getPartitionNumber(int eventnumber) const override;
+  size_t freeSlots() override;
+  bool exists(const DataObjID& id) override;
+
+  // IDataManagerSvc
+  CLID rootCLID() const override;
+  const std::string& rootName() const override;
+  StatusCode registerAddress(std::string_view fullPath, IOpaqueAddress* pAddress) override;
+  StatusCode registerAddress(DataObject* parentObj, std::string_view objectPath, IOpaqueAddress* pAddress) override;
+  StatusCode registerAddress(IRegistry* parentObj, std::string_view objectPath, IOpaqueAddress* pAddress) override;
+  StatusCode unregisterAddress(std::string_view fullPath) override;
+  StatusCode unregisterAddress(DataObject* pParent, std::string_view objPath) override;
+  StatusCode unregisterAddress(IRegistry* pParent, std::string_view objPath) override;
+  StatusCode objectLeaves(const DataObject* pObject, std::vector<IRegistry*>& refLeaves) override;
+  StatusCode objectLeaves(const IRegistry* pObject, std::vector<IRegistry*>& refLeaves) override;
+  StatusCode objectParent(const DataObject* pObject, IRegistry*& refpParent) override;
+  StatusCode objectParent(const IRegistry* pObject, IRegistry*& refpParent) override;
+  StatusCode clearSubTree(std::string_view sub_path) override;
+  StatusCode clearSubTree(DataObject* pObject) override;
+  StatusCode clearStore() override;
+  StatusCode traverseSubTree(std::string_view sub_path, IDataStoreAgent* pAgent) override;
+  StatusCode traverseSubTree(DataObject* pObject, IDataStoreAgent* pAgent) override;
+  StatusCode traverseTree(IDataStoreAgent* pAgent) override;
+  StatusCode setRoot(std::string root_name, DataObject* pObject) override;
+  StatusCode setRoot(std::string root_path, IOpaqueAddress* pRootAddr) override;
+  StatusCode setDataLoader(IConversionSvc* svc, IDataProviderSvc* dpsvc = nullptr) override;
+
+  // IDataProviderSvc
+  using IDataProviderSvc::findObject;
+  using IDataProviderSvc::linkObject;
+  using IDataProviderSvc::registerObject;
+  using IDataProviderSvc::retrieveObject;
+  using IDataProviderSvc::unlinkObject;
+  using IDataProviderSvc::unregisterObject;
+  using IDataProviderSvc::updateObject;
+  StatusCode registerObject(std::string_view parentPath, std::string_view objectPath, DataObject* pObject) override;
+  StatusCode registerObject(DataObject* parentObj, std::string_view objectPath, DataObject* pObject) override;
+  StatusCode unregisterObject(std::string_view fullPath) override;
+  StatusCode unregisterObject(DataObject* pObject) override;
+  StatusCode unregisterObject(DataObject* pParent, std::string_view objectPath) override;
+  StatusCode retrieveObject(IRegistry* pDirectory, std::string_view path, DataObject*& pObject) override;
+  StatusCode findObject(IRegistry* pDirectory, std::string_view path, DataObject*& pObject) override;
+  StatusCode findObject(std::string_view fullPath, DataObject*& pObject) override;
+  StatusCode updateObject(IRegistry* pDirectory) override;
+  StatusCode updateObject(DataObject* toUpdate) override;
+  StatusCode addPreLoadItem(const DataStoreItem& item) override;
+  StatusCode removePreLoadItem(const DataStoreItem& item) override;
+  StatusCode resetPreLoad() override;
+  StatusCode preLoad() override;
+  StatusCode linkObject(IRegistry* from, std::string_view objPath, DataObject* toObj) override;
+  StatusCode linkObject(std::string_view fullPath, DataObject* toObj) override;
+  StatusCode unlinkObject(IRegistry* from, std::string_view objPath) override;
+  StatusCode unlinkObject(DataObject* fromObj, std::string_view objPath) override;
+  StatusCode unlinkObject(std::string_view fullPath) override;
+
+private:
+  struct Partition {
+    PodioDataSvc* store{nullptr};
+    int eventNumber{-1};
+  };
+
+  Gaudi::Property<size_t> m_slots{this, "EventSlots", 1, "Number of event slots"};
+  /// Input and store options, as for EICDataSvc
+  Gaudi::Property<std::vector<std::string>> m_filenames{this, "inputs", {}, "Names of the files to read"};
+  Gaudi::Property<std::string> m_filename{this, "input", "", "Name of the file to read"};
+  Gaudi::Property<unsigned> m_firstEntry{this, "FirstEventEntry", 0, "First entry of the event range"};
+  Gaudi::Property<long long> m_lastEntry{this, "LastEventEntry", -1,
+                                         "End (exclusive) of the event range, end of input if negative"};
+  Gaudi::Property<std::vector<std::string>> m_eventList{
+      this, "eventList", {}, "Entries to read instead of the event range, '<entry>' or '<file index or name>:<entry>'"};
+  Gaudi::Property<std::string> m_eventListFile{this, "eventListFile", "",
+                                               "File with the entries of eventList, one per line"};
+  Gaudi::Property<long long> m_readCacheSize{this, "readCacheSize", -1,
+                                             "Size of the input TTreeCache in bytes, ROOT default if negative"};
+  Gaudi::Property<unsigned> m_readAhead{this, "readAhead", 0,
+                                       "Number of events read and unpacked ahead on a background thread, off if 0"};
+  Gaudi::Property<long long> m_readAheadMaxBytes{this, "readAheadMaxBytes", 0,
+                                                 "Bytes of the unpacked events read ahead, no limit if 0"};
+  Gaudi::Property<bool> m_useEventArena{this, "useEventArena", false,
+                                        "Create the event collections in a reused arena"};
+  Gaudi::Property<bool> m_recycleCollections{this, "recycleCollections", false,
+                                             "Keep the event collections and their capacity for the next events"};
+  Gaudi::Property<bool> m_adaptiveReserve{this, "adaptiveReserve", false,
+                                          "Reserve the largest size of the previous events when creating a collection"};
+  Gaudi::Property<bool> m_flatStore{this, "flatStore", false,
+                                    "Keep the event collections in a flat store by key instead of the Gaudi registry"};
+  Gaudi::Property<bool> m_memoryAccounting{
+      this, "memoryAccounting", false,
+      "Report the peak bytes of the collections per collection and per algorithm at finalize"};
+  Gaudi::Property<long long> m_maxEventBytes{this, "maxEventBytes", 0,
+                                             "Events with collections of more bytes are not written, no limit if 0"};
+
+  std::vector<Partition> m_partitions;
+  /// Guards the slot allocation
+  mutable std::mutex m_slotMutex;
+  /// Guards the reader and collection ID table shared by the slots
+  std::mutex m_inputMutex;
+};
+
+#endif
@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_PROFILING_H
+#define JUGBASE_PROFILING_H
+
+#include <string>
+
+#if defined(JUGGLER_HAVE_ITT) || defined(JUGGLER_HAVE_NVTX) || defined(JUGGLER_HAVE_SDT)
+#define JUGGLER_HAVE_PROFILING 1
+#endif
+
+namespace Jug::Base {
+
+  /** Named region of the profiler annotations.
+   *
+   *  The regions are VTune task regions (JUGGLER_ENABLE_ITT), NVTX ranges for Nsight Systems
+   *  (JUGGLER_ENABLE_NVTX) and region_begin/region_end static probes of the juggler provider
+   *  for perf and SystemTap (JUGGLER_ENABLE_SDT), in the "juggler" domain. The names are
+   *  registered with the profilers once, when the region is made. Without any of the profilers
+   *  in the build the regions are empty and their scopes compile to nothing.
+   *
+   *  The regions are the algorithm executions (ProfilingAuditor) and the stages within the
+   *  algorithms (JUG_PROFILE_REGION).
+   *
+   * \ingroup base
+   */
+  class ProfileRegion {
+  public:
+#if defined(JUGGLER_HAVE_PROFILING)
+    explicit ProfileRegion(std::string name);
+
+    void begin() const;
+    void end() const;
+
+    const std::string& name() const { return m_name; }
+
+  private:
+    std::string m_name;
+    // string handles of the profilers
+    void* m_itt{nullptr};
+    void* m_nvtx{nullptr};
+#else
+    explicit ProfileRegion(const std::string& /* name */) {}
+
+    void begin() const {}
+    void end() const {}
+#endif
+  };
+
+  /// Region for the lifetime of the scope
+  class ProfileScope {
+  public:
+    explicit ProfileScope(const ProfileRegion& region) : m_region(region) { m_region.begin(); }
+    ~ProfileScope() { m_region.end(); }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+  private:
+    const ProfileRegion& m_region;
+  };
+
+  /// True if the build has profiler annotations
+  constexpr bool profilingEnabled() {
+#if defined(JUGGLER_HAVE_PROFILING)
+    return true;
+#else
+    return false;
+#endif
+  }
+
+} // namespace Jug::Base
+
+#define JUG_PROFILE_CONCAT_(a, b) a##b
+#define JUG_PROFILE_CONCAT(a, b) JUG_PROFILE_CONCAT_(a, b)
+
+/** Profiler region of a stage of an algorithm, until the end of the enclosing scope.
+ *
+ *      JUG_PROFILE_REGION("CKFTracking/findTracks");
+ *
+ *  Expands to nothing without profiler annotations in the build.
+ */
+#if defined(JUGGLER_HAVE_PROFILING)
+#define JUG_PROFILE_REGION(name)                                                                                       \
+  static const Jug::Base::ProfileRegion JUG_PROFILE_CONCAT(jug_profile_region_, __LINE__){name};                       \
+  const Jug::Base::ProfileScope JUG_PROFILE_CONCAT(jug_profile_scope_, __LINE__){                                      \
+      JUG_PROFILE_CONCAT(jug_profile_region_, __LINE__)}
+#else
+#define JUG_PROFILE_REGION(name)
+#endif
+
+#endif
@@ -1,23 +1,43 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_PROPERTY_H
+#define JUGBASE_PROPERTY_H
+
+#include <string>
+#include <utility>
+
 namespace Jug {
 
+  /** Framework-independent property of a Jug::Algorithm.
+   *
+   *  Registered by reference with its owner on construction, so that the framework can set it by
+   *  name before the algorithm is initialized. The type has to be one of
+   *  AlgorithmBase::PropertyRef.
+   */
   template <class TYPE>
   class Property {
   public:
-    using StorageType = TYPE;
-    using ValueType = typename std::remove_reference<StorageType>::type;
-
-  private:
-    StorageType m_value;
+    using ValueType = TYPE;
 
-  public:
     template <class OWNER>
-    Property(OWNER* /* owner */, std::string /* name */, TYPE&& value)
-    : m_value( std::forward<TYPE>( value ) ) {
+    Property(OWNER* owner, std::string name, TYPE value)
+    : m_name( std::move( name ) ), m_value( std::move( value ) ) {
+      owner->registerProperty( m_name, &m_value );
     }
+    Property(const Property&) = delete;
+    Property& operator=(const Property&) = delete;
 
-    const ValueType& value() const { return *this; }
-    ValueType&       value() { return const_cast<ValueType&>( (const ValueType&)*this ); }
+    const std::string& name() const { return m_name; }
+    const ValueType& value() const { return m_value; }
+    ValueType&       value() { return m_value; }
+    operator const ValueType&() const { return m_value; }
 
+  private:
+    std::string m_name;
+    ValueType   m_value;
   };
 
 } // namespace Jug
+
+#endif
@@ -0,0 +1,189 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_SIMHITFILE_H
+#define JUGBASE_SIMHITFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace Jug::Base {
+
+  /** Simulated hit collections in a flat, uncompressed columnar file, memory-mapped for reading.
+   *
+   *  For repeated digitization and reconstruction passes over the same simulation sample: the hits
+   *  are read from the page cache without ROOT decompression or unpacking. The SimCalorimeterHit
+   *  and SimTrackerHit members are kept as in the background pools of JugDigi, the relations to the
+   *  MC particles are not kept.
+   *
+   *  File layout (native byte order): header {magic, version, number of collections, number of
+   *  blocks, number of events, directory offset}, the blocks, then the directory (collections and
+   *  block index). A block holds the columns of eventsPerBlock consecutive events, per collection:
+   *  the hit offsets of the events (number of events + 1), then the hit columns, and for
+   *  calorimeters the contribution offsets of the hits (number of hits + 1) and the contribution
+   *  columns. Each column is 8-byte aligned, the offsets count from the start of the block.
+   */
+  class SimHitFile {
+  public:
+    enum class Kind : uint32_t { Calorimeter = 0, Tracker = 1 };
+
+    struct Vector3f {
+      float x, y, z;
+    };
+    struct Vector3d {
+      double x, y, z;
+    };
+
+    /// Calorimeter hits of an event, pointers into the mapping. The contributions of hit i are
+    /// [contributionBegin[i], contributionBegin[i + 1]) of the contribution columns.
+    struct CalorimeterHits {
+      size_t size{0};
+      const uint64_t* cellID{nullptr};
+      const float* energy{nullptr};
+      const Vector3f* position{nullptr};
+      const uint32_t* contributionBegin{nullptr};
+      const int32_t* pdg{nullptr};
+      const float* contributionEnergy{nullptr};
+      const float* time{nullptr};
+      const Vector3f* stepPosition{nullptr};
+    };
+
+    /// Tracker hits of an event, pointers into the mapping
+    struct TrackerHits {
+      size_t size{0};
+      const uint64_t* cellID{nullptr};
+      const float* eDep{nullptr};
+      const float* time{nullptr};
+      const float* pathLength{nullptr};
+      const int32_t* quality{nullptr};
+      const Vector3d* position{nullptr};
+      const Vector3f* momentum{nullptr};
+    };
+
+    struct Collection {
+      std::string name;
+      Kind kind;
+    };
+
+    /// Hits and contributions of a collection in a block
+    struct Extent {
+      uint64_t offset;
+      uint64_t nhits;
+      uint64_t ncontributions;
+    };
+
+    SimHitFile() = default;
+    ~SimHitFile();
+    SimHitFile(const SimHitFile&) = delete;
+    SimHitFile& operator=(const SimHitFile&) = delete;
+
+    /// Map a hit file, false if it cannot be read or is not a valid hit file
+    bool open(const std::string& filename);
+    void close();
+
+    uint64_t entries() const { return m_entries; }
+    const std::vector<Collection>& collections() const { return m_collections; }
+    /// Index of a collection, -1 if it is not in the file
+    int collection(const std::string& name) const;
+
+    /// Hits of a collection in an event, false if the event is not in the file or the kind differs
+    bool calorimeterHits(size_t collection, uint64_t event, CalorimeterHits& hits) const;
+    bool trackerHits(size_t collection, uint64_t event, TrackerHits& hits) const;
+
+    /// Ask the kernel to read the blocks of the events [first, last) ahead
+    void prefetch(uint64_t first, uint64_t last) const;
+
+    /** Writer of a hit file, one event at a time.
+     *
+     *  The columns of a block are kept in memory until eventsPerBlock events are added, the
+     *  directory is written by close.
+     */
+    class Writer {
+    public:
+      struct CalorimeterHit {
+        uint64_t cellID;
+        float energy;
+        Vector3f position;
+      };
+      struct Contribution {
+        int32_t pdg;
+        float energy;
+        float time;
+        Vector3f stepPosition;
+      };
+      struct TrackerHit {
+        uint64_t cellID;
+        float eDep;
+        float time;
+        float pathLength;
+        int32_t quality;
+        Vector3d position;
+        Vector3f momentum;
+      };
+
+      Writer() = default;
+      ~Writer();
+      Writer(const Writer&) = delete;
+      Writer& operator=(const Writer&) = delete;
+
+      bool open(const std::string& filename, const std::vector<Collection>& collections,
+                uint32_t eventsPerBlock = 1000);
+      /// Add a hit of the current event, the contributions that follow belong to it
+      void add(size_t collection, const CalorimeterHit& hit);
+      void add(size_t collection, const Contribution& contribution);
+      void add(size_t collection, const TrackerHit& hit);
+      /// End the current event, the block is written once full
+      bool endEvent();
+      /// Write the last block and the directory, false if the file could not be written
+      bool close();
+
+    private:
+      struct Columns {
+        std::vector<uint32_t> hitBegin{0};
+        std::vector<uint64_t> cellID;
+        std::vector<float> energy;
+        std::vector<Vector3f> position;
+        std::vector<uint32_t> contributionBegin{0};
+        std::vector<int32_t> pdg;
+        std::vector<float> contributionEnergy;
+        std::vector<float> time;
+        std::vector<Vector3f> stepPosition;
+        std::vector<float> pathLength;
+        std::vector<int32_t> quality;
+        std::vector<Vector3d> trackerPosition;
+        std::vector<Vector3f> momentum;
+      };
+      bool writeBlock();
+
+      std::ofstream m_os;
+      std::vector<Collection> m_collections;
+      uint32_t m_eventsPerBlock{1000};
+      uint64_t m_entries{0};
+      uint32_t m_blockEvents{0};
+      std::vector<Columns> m_columns;
+      /// First event of the blocks and the extents of their collections
+      std::vector<uint64_t> m_blockFirst;
+      std::vector<Extent> m_extents;
+    };
+
+  private:
+    /// Columns of a collection in the block of an event, the event in the block and the number of
+    /// events of the block, nullptr if the event is not in the file
+    const char* block(uint64_t event, size_t collection, const Extent*& extent, uint64_t& local,
+                      uint64_t& nevents) const;
+
+    void* m_data{nullptr};
+    size_t m_size{0};
+    uint64_t m_entries{0};
+    std::vector<Collection> m_collections;
+    const uint64_t* m_blockFirst{nullptr};
+    const Extent* m_extents{nullptr};
+    uint64_t m_nblocks{0};
+  };
+
+} // namespace Jug::Base
+
+#endif // JUGBASE_SIMHITFILE_H
@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_SURFACEINDEX_H
+#define JUGBASE_SURFACEINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace dd4hep::rec {
+  class Surface;
+}
+
+namespace Acts {
+  class Surface;
+}
+
+namespace genfit {
+  class DetPlane;
+}
+
+namespace Jug::Base {
+
+  /** Tracking surfaces of the sensitive volumes, looked up directly by the cellID of a hit.
+   *
+   *  The volume ID of a cell is its cellID masked with the volume bits of its readout, so the
+   *  entries are grouped by that mask, each group sorted by volume ID. A lookup masks the cellID and
+   *  searches the groups, without the volume manager walk of CellIDPositionConverter::findContext.
+   *  The masks all include the system field, so that a cellID can only match in its own detector.
+   */
+  class SurfaceIndex {
+  public:
+    struct Entry {
+      uint64_t volumeID{0};
+      /// nullptr if the volume has no surface of that kind
+      const Acts::Surface* surface{nullptr};
+      dd4hep::rec::Surface* dd4hepSurface{nullptr};
+      std::shared_ptr<genfit::DetPlane> detPlane;
+    };
+
+    /// Entry of a volume to fill in, mask selects the volume bits of the cellIDs of the volume
+    Entry& insert(uint64_t volumeID, uint64_t mask);
+    /// Make the inserted entries available to find
+    void build();
+
+    /// nullptr if the cell is not in a volume of the index
+    const Entry* find(uint64_t cellID) const;
+    size_t size() const;
+
+  private:
+    struct Group {
+      uint64_t mask;
+      std::vector<Entry> entries;
+    };
+    std::vector<Group> m_groups;
+    std::map<uint64_t, std::map<uint64_t, Entry>> m_inserted;
+  };
+
+} // namespace Jug::Base
+
+#endif // JUGBASE_SURFACEINDEX_H
@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_TENSOR_H
+#define JUGBASE_TENSOR_H
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Jug {
+
+/** Dense float tensor for the inputs of the ML algorithms.
+ *
+ *  Row-major values in one contiguous buffer aligned to kAlignment bytes, so that an inference
+ *  front-end can take data() as is. The last dimension is the list of features, named by
+ *  features(). Put in the event store through DataHandle<Jug::Tensor>, it is transient only.
+ *
+ * \ingroup base
+ */
+class Tensor {
+public:
+  static constexpr std::size_t kAlignment = 64;
+
+  template <typename T> struct AlignedAllocator {
+    using value_type = T;
+    AlignedAllocator() = default;
+    template <typename U> AlignedAllocator(const AlignedAllocator<U>& /* other */) {}
+    T* allocate(std::size_t n) {
+      return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{kAlignment}));
+    }
+    void deallocate(T* p, std::size_t /* n */) { ::operator delete(p, std::align_val_t{kAlignment}); }
+    template <typename U> bool operator==(const AlignedAllocator<U>& /* other */) const { return true; }
+    template <typename U> bool operator!=(const AlignedAllocator<U>& /* other */) const { return false; }
+  };
+
+  Tensor() = default;
+  Tensor(std::vector<std::size_t> shape, std::vector<std::string> features)
+      : m_shape(std::move(shape)), m_features(std::move(features)), m_data(count(m_shape), 0.f) {}
+
+  const std::vector<std::size_t>& shape() const { return m_shape; }
+  const std::vector<std::string>& features() const { return m_features; }
+  std::size_t size() const { return m_data.size(); }
+
+  float* data() { return m_data.data(); }
+  const float* data() const { return m_data.data(); }
+  float& operator[](std::size_t i) { return m_data[i]; }
+  float operator[](std::size_t i) const { return m_data[i]; }
+
+  /// Change the shape and set all the values to 0, the buffer is reused if large enough
+  void reset(std::vector<std::size_t> shape) {
+    m_shape = std::move(shape);
+    m_data.assign(count(m_shape), 0.f);
+  }
+
+private:
+  static std::size_t count(const std::vector<std::size_t>& shape) {
+    return std::accumulate(shape.begin(), shape.end(), std::size_t{1}, std::multiplies<>());
+  }
+
+  std::vector<std::size_t> m_shape;
+  std::vector<std::string> m_features;
+  std::vector<float, AlignedAllocator<float>> m_data;
+};
+
+} // namespace Jug
+
+#endif
@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_TRANSFORMER_H
+#define JUGBASE_TRANSFORMER_H
+
+#include <array>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#include "Gaudi/Algorithm.h"
+#include "GaudiKernel/GaudiException.h"
+
+#include "JugBase/DataHandle.h"
+
+namespace Jug {
+
+template <typename Inputs, typename Outputs> class MultiTransformer;
+
+/** Reentrant transformer of podio collections.
+ *
+ *  Counterpart of Gaudi::Functional::MultiTransformer for the collections of PodioDataSvc: the
+ *  inputs and outputs are accessed through DataHandles (declared as properties with the given
+ *  key names and default locations), and the const call operator is run for every event. The
+ *  outputs are created in the store and filled in place, as podio collections are not moved.
+ *  The algorithm keeps no per-event state, and its DataHandles keep none with the event slots of
+ *  PodioHiveWhiteBoard (the objects of an event are in the store of its slot), so it can be executed
+ *  concurrently on several events.
+ *
+ * \ingroup base
+ */
+template <typename... In, typename... Out>
+class MultiTransformer<std::tuple<In...>, std::tuple<Out...>> : public Gaudi::Algorithm {
+public:
+  using KeyValue = std::pair<std::string, std::string>;
+
+  MultiTransformer(const std::string& name, ISvcLocator* svcLoc, const std::array<KeyValue, sizeof...(In)>& inputs,
+                   const std::array<KeyValue, sizeof...(Out)>& outputs)
+      : Gaudi::Algorithm(name, svcLoc)
+      , m_inputs{makeHandles<In...>(inputs, Gaudi::DataHandle::Reader, std::index_sequence_for<In...>{})}
+      , m_outputs{makeHandles<Out...>(outputs, Gaudi::DataHandle::Writer, std::index_sequence_for<Out...>{})} {}
+
+  /// Fill the outputs from the inputs of the event
+  virtual void operator()(const In&... in, Out&... out) const = 0;
+
+  StatusCode execute(const EventContext& /* ctx */) const final {
+    return transform(std::index_sequence_for<In...>{}, std::index_sequence_for<Out...>{});
+  }
+
+private:
+  template <typename... T, size_t... I>
+  std::tuple<std::unique_ptr<DataHandle<T>>...> makeHandles(const std::array<KeyValue, sizeof...(T)>& keys,
+                                                            Gaudi::DataHandle::Mode mode, std::index_sequence<I...>) {
+    std::tuple<std::unique_ptr<DataHandle<T>>...> handles{
+        std::make_unique<DataHandle<T>>(keys[I].second, mode, this)...};
+    (declareProperty(keys[I].first, *std::get<I>(handles), ""), ...);
+    return handles;
+  }
+
+  template <size_t... I, size_t... O>
+  StatusCode transform(std::index_sequence<I...> /* inputs */, std::index_sequence<O...> /* outputs */) const {
+    try {
+      // braced initialization, so the outputs are registered in the order of the signature
+      const std::tuple<const In*...> in{std::get<I>(m_inputs)->get()...};
+      const std::tuple<Out*...> out{std::get<O>(m_outputs)->createAndPut()...};
+      (*this)(*std::get<I>(in)..., *std::get<O>(out)...);
+    } catch (const GaudiException& e) {
+      error() << "Error during transform: " << e.message() << endmsg;
+      return e.code();
+    }
+    return StatusCode::SUCCESS;
+  }
+
+  std::tuple<std::unique_ptr<DataHandle<In>>...> m_inputs;
+  std::tuple<std::unique_ptr<DataHandle<Out>>...> m_outputs;
+};
+
+/// Reentrant transformer with a single output
+template <typename Out, typename... In> using Transformer = MultiTransformer<std::tuple<In...>, std::tuple<Out>>;
+
+} // namespace Jug
+
+#endif
@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_TRUTHPARTICLEINDEX_H
+#define JUGBASE_TRUTHPARTICLEINDEX_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+namespace Jug {
+
+  /** Derived quantities and selections of the MCParticles of an event, built once per event.
+   *
+   *  The columns are by MCParticle index; the charge is that of the PDG code (ParticleSvc), as
+   *  DD4hep leaves the charge of the MCParticles at zero. The selections are lists of MCParticle
+   *  indices in increasing order: the primaries (generator status 0, for the particle guns, or
+   *  1), the charged primaries, the stable final state (status 1) and the beams (status 4). For
+   *  the events of a batch, range gives the part of a list in the particles of an event.
+   */
+  struct TruthParticleIndex {
+    std::vector<double> p;
+    std::vector<double> pt;
+    std::vector<double> eta;
+    std::vector<double> phi;
+    std::vector<double> theta;
+    std::vector<float> charge;
+    std::vector<int32_t> pdg;
+    std::vector<int32_t> status;
+
+    std::vector<uint32_t> primaries;
+    std::vector<uint32_t> chargedPrimaries;
+    std::vector<uint32_t> finalState;
+    std::vector<uint32_t> beams;
+
+    size_t size() const { return p.size(); }
+
+    void clear() {
+      for (auto* column : {&p, &pt, &eta, &phi, &theta}) {
+        column->clear();
+      }
+      charge.clear();
+      pdg.clear();
+      status.clear();
+      for (auto* list : {&primaries, &chargedPrimaries, &finalState, &beams}) {
+        list->clear();
+      }
+    }
+
+    /// Part of a list of the particles [first, last)
+    static std::pair<const uint32_t*, const uint32_t*> range(const std::vector<uint32_t>& list, size_t first,
+                                                             size_t last) {
+      const auto* begin = std::lower_bound(list.data(), list.data() + list.size(), first);
+      const auto* end   = std::lower_bound(begin, list.data() + list.size(), last);
+      return {begin, end};
+    }
+
+    /// First particle of a list in [first, last) with one of the PDG codes, -1 if none
+    int64_t findFirst(const std::vector<uint32_t>& list, std::initializer_list<int32_t> pdgs, size_t first,
+                      size_t last) const {
+      const auto [begin, end] = range(list, first, last);
+      for (const auto* it = begin; it != end; ++it) {
+        if (std::find(pdgs.begin(), pdgs.end(), pdg[*it]) != pdgs.end()) {
+          return *it;
+        }
+      }
+      return -1;
+    }
+  };
+
+} // namespace Jug
+
+#endif
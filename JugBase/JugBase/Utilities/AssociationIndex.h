@@ -0,0 +1,33 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#pragma once
+
+#include <cstdint>
+
+#include "podio/ObjectID.h"
+
+#include "JugBase/Utilities/FlatIndexMap.h"
+
+namespace Jug::Base {
+
+  /// Key of a podio object, unique across the collections of an event
+  inline uint64_t object_key(const podio::ObjectID& id) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(id.collectionID)) << 32) | static_cast<uint32_t>(id.index);
+  }
+
+  /** Index of the associations by the object of their getRec(), the first association of an object.
+   *
+   *  Replaces the scan of all associations for every object: index.find(object_key(obj.getObjectID()))
+   *  is the position of its association in the collection, FlatIndexMap::kEmpty if there is none.
+   */
+  template <typename Associations> FlatIndexMap association_index(const Associations& associations) {
+    FlatIndexMap index(associations.size());
+    uint32_t i = 0;
+    for (const auto& assoc : associations) {
+      index.emplace(object_key(assoc.getRec().getObjectID()), i++);
+    }
+    return index;
+  }
+
+} // namespace Jug::Base
@@ -41,17 +41,47 @@ namespace Jug::Base::Beam {
     return c;
   }
 
+  /// In the particles [first, last) of the collection, e.g. one event of a batch
+  template<class collection>
+  auto find_first_with_status_pdg(
+      const collection& parts,
+      const std::set<int32_t>& status,
+      const std::set<int32_t>& pdg,
+      size_t first,
+      size_t last) {
+    std::vector<decltype(parts[0])> c;
+    for (size_t i = first; i < last; ++i) {
+      const auto p = parts[i];
+      if (status.count(p.getGeneratorStatus()) > 0 &&
+          pdg.count(p.getPDG()) > 0) {
+        c.push_back(p);
+        break;
+      }
+    }
+    return c;
+  }
+
   inline auto find_first_beam_electron(const edm4hep::MCParticleCollection& mcparts) {
     return find_first_with_status_pdg(mcparts, {4}, {11});
   }
+  inline auto find_first_beam_electron(const edm4hep::MCParticleCollection& mcparts, size_t first, size_t last) {
+    return find_first_with_status_pdg(mcparts, {4}, {11}, first, last);
+  }
 
   inline auto find_first_beam_hadron(const edm4hep::MCParticleCollection& mcparts) {
     return find_first_with_status_pdg(mcparts, {4}, {2212, 2112});
   }
+  inline auto find_first_beam_hadron(const edm4hep::MCParticleCollection& mcparts, size_t first, size_t last) {
+    return find_first_with_status_pdg(mcparts, {4}, {2212, 2112}, first, last);
+  }
 
   inline auto find_first_scattered_electron(const edm4hep::MCParticleCollection& mcparts) {
     return find_first_with_status_pdg(mcparts, {1}, {11});
   }
+  inline auto find_first_scattered_electron(const edm4hep::MCParticleCollection& mcparts, size_t first,
+                                            size_t last) {
+    return find_first_with_status_pdg(mcparts, {1}, {11}, first, last);
+  }
 
   inline auto find_first_scattered_electron(const eicd::ReconstructedParticleCollection& rcparts) {
     return find_first_with_pdg(rcparts, {11});
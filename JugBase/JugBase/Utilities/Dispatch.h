@@ -0,0 +1,125 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <string_view>
+
+/** Runtime selection of the instruction set of the vectorized kernels.
+ *
+ *  The production builds target a baseline instruction set that runs on all the grid sites. A
+ *  hot kernel is written once as an inline body (JUG_KERNEL_BODY) and compiled with
+ *  JUG_DISPATCH_KERNEL for the baseline, AVX2 and AVX-512 in the same library; the calls go to
+ *  the variant of the active level. The active level is the best one of the CPU, unless it is
+ *  lowered with select (e.g. by CPUDispatchSvc, to compare the levels or work around a problem).
+ *  Other architectures than x86-64 have the baseline only.
+ *
+ *  The levels give the same results bit for bit: the code using JugBase is compiled with
+ *  -ffp-contract=off (a public compile option of JugBase), so that the AVX2 and AVX-512 variants
+ *  do not contract multiplications and additions into FMA instructions that the baseline lacks.
+ */
+namespace Jug::Base::Dispatch {
+
+  enum class Level : int { baseline = 0, avx2 = 1, avx512 = 2 };
+
+  inline const char* name(Level level) {
+    switch (level) {
+    case Level::avx512:
+      return "avx512";
+    case Level::avx2:
+      return "avx2";
+    default:
+      return "baseline";
+    }
+  }
+
+  inline std::optional<Level> parse(std::string_view name) {
+    if (name == "baseline") {
+      return Level::baseline;
+    }
+    if (name == "avx2") {
+      return Level::avx2;
+    }
+    if (name == "avx512") {
+      return Level::avx512;
+    }
+    return std::nullopt;
+  }
+
+  /// Best level of the CPU running the job
+  inline Level detected() {
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    static const Level level = [] {
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl") &&
+          __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512dq")) {
+        return Level::avx512;
+      }
+      if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return Level::avx2;
+      }
+      return Level::baseline;
+    }();
+    return level;
+#else
+    return Level::baseline;
+#endif
+  }
+
+  namespace detail {
+    inline std::atomic<int>& active() {
+      static std::atomic<int> level{static_cast<int>(detected())};
+      return level;
+    }
+  } // namespace detail
+
+  /// Level of the kernels
+  inline Level active() { return static_cast<Level>(detail::active().load(std::memory_order_relaxed)); }
+
+  /// Use the kernels of a level, at most the detected one, and return the level used
+  inline Level select(Level level) {
+    const Level used = static_cast<int>(level) <= static_cast<int>(detected()) ? level : detected();
+    detail::active().store(static_cast<int>(used), std::memory_order_relaxed);
+    return used;
+  }
+
+} // namespace Jug::Base::Dispatch
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define JUG_DISPATCH_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define JUG_DISPATCH_TARGET_AVX512 __attribute__((target("avx512f,avx512vl,avx512bw,avx512dq,avx2,fma")))
+#else
+#define JUG_DISPATCH_TARGET_AVX2
+#define JUG_DISPATCH_TARGET_AVX512
+#endif
+
+/// Body of a kernel, inlined into (and compiled for) each level of JUG_DISPATCH_KERNEL
+#if defined(__GNUC__) || defined(__clang__)
+#define JUG_KERNEL_BODY inline __attribute__((always_inline))
+#else
+#define JUG_KERNEL_BODY inline
+#endif
+
+/** Kernel kernel(params) of the body kernel_body(args), for each level, calling the active one.
+ *
+ *    JUG_KERNEL_BODY void scale_body(float* x, float a, size_t n) { for (...) x[i] *= a; }
+ *    JUG_DISPATCH_KERNEL(scale, (float* x, float a, size_t n), (x, a, n))
+ */
+#define JUG_DISPATCH_KERNEL(kernel, params, args)                                                                      \
+  JUG_DISPATCH_TARGET_AVX512 inline void kernel##_avx512 params { kernel##_body args; }                              \
+  JUG_DISPATCH_TARGET_AVX2 inline void kernel##_avx2 params { kernel##_body args; }                                  \
+  inline void kernel##_baseline params { kernel##_body args; }                                                         \
+  inline void kernel params {                                                                                          \
+    switch (::Jug::Base::Dispatch::active()) {                                                                         \
+    case ::Jug::Base::Dispatch::Level::avx512:                                                                         \
+      kernel##_avx512 args;                                                                                            \
+      return;                                                                                                          \
+    case ::Jug::Base::Dispatch::Level::avx2:                                                                           \
+      kernel##_avx2 args;                                                                                              \
+      return;                                                                                                          \
+    default:                                                                                                           \
+      kernel##_baseline args;                                                                                          \
+    }                                                                                                                  \
+  }
@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace Jug::Base {
+
+  /** Events of the input concatenated in the collections of one framework event.
+   *
+   *  In the batched mode of the fast simulation chain, one framework event holds the objects of
+   *  several input events, so that the per-event overhead of the framework (store, handles, output)
+   *  is paid once per batch. The objects of event e of the batch are [begin[e], begin[e + 1]) of
+   *  the collection, the event is entry firstEntry + e of the input. Each batched collection has
+   *  its own EventBatch, stored next to it.
+   */
+  struct EventBatch {
+    uint64_t firstEntry{0};
+    std::vector<uint32_t> begin{0};
+
+    size_t size() const { return begin.size() - 1; }
+    std::pair<size_t, size_t> range(size_t event) const { return {begin[event], begin[event + 1]}; }
+    /// End the current event at end objects of the collection
+    void add(size_t end) { begin.push_back(static_cast<uint32_t>(end)); }
+    void clear(uint64_t first) {
+      firstEntry = first;
+      begin.assign(1, 0);
+    }
+
+    /// Flat form, to be stored in the event as a vector of unsigned longs
+    std::vector<unsigned long> encode() const {
+      std::vector<unsigned long> values{firstEntry};
+      values.insert(values.end(), begin.begin(), begin.end());
+      return values;
+    }
+    /// Batch of the flat form, false if it is not one
+    static bool decode(const std::vector<unsigned long>& values, EventBatch& batch) {
+      if (values.size() < 2 || values[1] != 0) {
+        return false;
+      }
+      batch.firstEntry = values[0];
+      batch.begin.assign(values.begin() + 1, values.end());
+      return true;
+    }
+  };
+
+} // namespace Jug::Base
@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace Jug::Base {
+
+  /** Open-addressing map of 64-bit keys (e.g. cellIDs) to 32-bit indices, with linear probing.
+   *
+   *  Meant to be made per event with the largest number of keys (e.g. the number of hits), so
+   *  that the table is allocated once and never rehashed; it grows if more keys are inserted.
+   */
+  class FlatIndexMap {
+  public:
+    static constexpr uint32_t kEmpty = std::numeric_limits<uint32_t>::max();
+
+    explicit FlatIndexMap(size_t maxKeys = 0) { reserve(maxKeys); }
+
+    size_t size() const { return m_size; }
+
+    /// Table for maxKeys keys at a load factor of at most 1/2
+    void reserve(size_t maxKeys) {
+      size_t capacity = 16;
+      while (capacity < 2 * maxKeys) {
+        capacity *= 2;
+      }
+      if (capacity > m_keys.size()) {
+        rehash(capacity);
+      }
+    }
+
+    /// Index of the key, and if it was inserted with the given index
+    std::pair<uint32_t, bool> emplace(uint64_t key, uint32_t index) {
+      if (2 * (m_size + 1) > m_keys.size()) {
+        rehash(2 * m_keys.size());
+      }
+      for (size_t slot = bucket(key);; slot = (slot + 1) & m_mask) {
+        if (m_values[slot] == kEmpty) {
+          m_keys[slot]   = key;
+          m_values[slot] = index;
+          ++m_size;
+          return {index, true};
+        }
+        if (m_keys[slot] == key) {
+          return {m_values[slot], false};
+        }
+      }
+    }
+
+    /// Index of the key, kEmpty if absent
+    uint32_t find(uint64_t key) const {
+      for (size_t slot = bucket(key);; slot = (slot + 1) & m_mask) {
+        if (m_values[slot] == kEmpty || m_keys[slot] == key) {
+          return m_values[slot];
+        }
+      }
+    }
+
+  private:
+    // Fibonacci hashing, the high bits of the product depend on all the key bits
+    size_t bucket(uint64_t key) const { return static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> m_shift); }
+
+    void rehash(size_t capacity) {
+      std::vector<uint64_t> keys(capacity);
+      std::vector<uint32_t> values(capacity, kEmpty);
+      keys.swap(m_keys);
+      values.swap(m_values);
+      m_mask  = capacity - 1;
+      m_shift = 64;
+      for (size_t c = capacity; c > 1; c /= 2) {
+        --m_shift;
+      }
+      m_size = 0;
+      for (size_t slot = 0; slot < values.size(); ++slot) {
+        if (values[slot] != kEmpty) {
+          emplace(keys[slot], values[slot]);
+        }
+      }
+    }
+
+    std::vector<uint64_t> m_keys;
+    std::vector<uint32_t> m_values;
+    size_t m_mask{0};
+    int m_shift{64};
+    size_t m_size{0};
+  };
+
+} // namespace Jug::Base
@@ -11,8 +11,15 @@
 #include "JugBase/Utilities/Range.hpp"
 
 #include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <iterator>
+#include <type_traits>
 #include <utility>
+#include <vector>
+
+#include <tbb/parallel_for.h>
 
 namespace Jug {
 
@@ -138,4 +145,145 @@ auto makeGroupBy(const Container& container, KeyGetter keyGetter)
   return {std::begin(container), std::end(container), std::move(keyGetter)};
 }
 
+namespace detail {
+
+/// Order preserving unsigned representation of an integral key.
+template <typename Key>
+constexpr uint64_t radixKey(Key key) {
+  static_assert(std::is_integral_v<Key>, "radix sort needs integral keys");
+  if constexpr (std::is_signed_v<Key>) {
+    return static_cast<uint64_t>(static_cast<int64_t>(key)) ^ (uint64_t(1) << 63);
+  } else {
+    return static_cast<uint64_t>(key);
+  }
+}
+
+/// Number of elements from which the radix sort runs in parallel.
+constexpr size_t kParallelSortMin = size_t(1) << 16;
+
+/// Stable LSD radix sort of (key, index) pairs by key.
+///
+/// Only the bytes in which some keys differ take a pass. From kParallelSortMin
+/// elements, the histograms and the scatter of a pass run with TBB over blocks
+/// of the input, and the blocks are scattered in order to keep the sort stable.
+template <typename Key>
+void radixSort(std::vector<std::pair<Key, uint32_t>>& items) {
+  const size_t n = items.size();
+  if (n < 2) {
+    return;
+  }
+  uint64_t differ = 0;
+  const uint64_t first = radixKey(items[0].first);
+  for (size_t i = 1; i < n; ++i) {
+    differ |= radixKey(items[i].first) ^ first;
+  }
+
+  const size_t nblocks =
+      (n < kParallelSortMin) ? 1 : std::min<size_t>(64, n / (kParallelSortMin / 4));
+  const size_t blockSize = (n + nblocks - 1) / nblocks;
+  auto forBlocks = [nblocks](const auto& f) {
+    if (nblocks == 1) {
+      f(0);
+    } else {
+      tbb::parallel_for(size_t(0), nblocks, f);
+    }
+  };
+
+  std::vector<std::pair<Key, uint32_t>> tmp(n);
+  std::vector<std::array<uint32_t, 256>> offset(nblocks);
+  for (int shift = 0; shift < 64; shift += 8) {
+    if (((differ >> shift) & 0xFF) == 0) {
+      continue;
+    }
+    forBlocks([&](size_t b) {
+      auto& count = offset[b];
+      count.fill(0);
+      const size_t end = std::min(n, (b + 1) * blockSize);
+      for (size_t i = b * blockSize; i < end; ++i) {
+        ++count[(radixKey(items[i].first) >> shift) & 0xFF];
+      }
+    });
+    // the bucket of a byte value starts after the smaller values, and after the
+    // same value in the previous blocks
+    uint32_t sum = 0;
+    for (size_t d = 0; d < 256; ++d) {
+      for (size_t b = 0; b < nblocks; ++b) {
+        const uint32_t c = offset[b][d];
+        offset[b][d] = sum;
+        sum += c;
+      }
+    }
+    forBlocks([&](size_t b) {
+      auto& dst = offset[b];
+      const size_t end = std::min(n, (b + 1) * blockSize);
+      for (size_t i = b * blockSize; i < end; ++i) {
+        tmp[dst[(radixKey(items[i].first) >> shift) & 0xFF]++] = items[i];
+      }
+    });
+    items.swap(tmp);
+  }
+}
+
+}  // namespace detail
+
+/// Elements of a container grouped by key, as a permutation of their indices.
+///
+/// The (key, index) pairs of the elements are sorted stably by key, so that the
+/// groups come in increasing key order with their elements in input order, and
+/// are iterated with GroupBy:
+///
+///     for (auto&& [key, items] : sort_and_group(hits, [](const auto& h) {
+///            return h.getCellID(); })) {
+///         for (const auto& [k, index] : items) {
+///             ... hits[index] ...
+///         }
+///     }
+///
+template <typename Key>
+class SortedGroups {
+ public:
+  using Item = std::pair<Key, uint32_t>;
+  using Iterator = typename std::vector<Item>::const_iterator;
+  struct KeyOf {
+    constexpr Key operator()(const Item& item) const { return item.first; }
+  };
+  using Groups = GroupBy<Iterator, KeyOf>;
+
+  explicit SortedGroups(std::vector<Item> items)
+      : m_items(std::move(items)), m_groups(m_items.begin(), m_items.end()) {}
+  // the groups refer to the items
+  SortedGroups(SortedGroups&& other) noexcept
+      : m_items(std::move(other.m_items)),
+        m_groups(m_items.begin(), m_items.end()) {}
+  SortedGroups(const SortedGroups&) = delete;
+  SortedGroups& operator=(const SortedGroups&) = delete;
+  SortedGroups& operator=(SortedGroups&&) = delete;
+
+  /// The sorted (key, index) pairs
+  const std::vector<Item>& items() const { return m_items; }
+  auto begin() const { return m_groups.begin(); }
+  auto end() const { return m_groups.end(); }
+  bool empty() const { return m_items.empty(); }
+
+ private:
+  std::vector<Item> m_items;
+  Groups m_groups;
+};
+
+/// Group the elements of a container by an integral key projection.
+///
+/// The keys are sorted with a radix sort, in parallel for large containers.
+template <typename Container, typename Projection>
+auto sort_and_group(const Container& container, Projection projection) {
+  using Key = std::decay_t<decltype(projection(*std::begin(container)))>;
+  std::vector<std::pair<Key, uint32_t>> items;
+  items.reserve(std::size(container));
+  uint32_t index = 0;
+  for (const auto& element : container) {
+    items.emplace_back(projection(element), index++);
+  }
+  detail::radixSort(items);
+  return SortedGroups<Key>(std::move(items));
+}
+
 }  // namespace Jug
@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "JugBase/Utilities/GroupBy.hpp"
+
+namespace Jug::Base {
+
+  /** Elements grouped by a 64-bit key (e.g. a masked cellID), in flat arrays.
+   *
+   *  The element indices are sorted by key, stably so that the elements of a group keep their
+   *  input order, and group g is index[begin[g]] ... index[begin[g + 1] - 1], in increasing key
+   *  order. Made by group_by_key without an allocation per group.
+   */
+  struct KeyGroups {
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> index;
+    std::vector<uint32_t> begin;
+
+    size_t size() const { return begin.empty() ? 0 : begin.size() - 1; }
+    uint64_t key(size_t g) const { return keys[begin[g]]; }
+    /// Number of elements in group g
+    uint32_t count(size_t g) const { return begin[g + 1] - begin[g]; }
+  };
+
+  /// Group the elements by key with the radix sort of sort_and_group
+  inline KeyGroups group_by_key(const std::vector<uint64_t>& keys) {
+    KeyGroups groups;
+    const size_t n = keys.size();
+    std::vector<std::pair<uint64_t, uint32_t>> items(n);
+    for (size_t i = 0; i < n; ++i) {
+      items[i] = {keys[i], static_cast<uint32_t>(i)};
+    }
+    Jug::detail::radixSort(items);
+
+    groups.keys.resize(n);
+    groups.index.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+      groups.keys[i]  = items[i].first;
+      groups.index[i] = items[i].second;
+      if (i == 0 || items[i].first != items[i - 1].first) {
+        groups.begin.push_back(static_cast<uint32_t>(i));
+      }
+    }
+    if (n > 0) {
+      groups.begin.push_back(static_cast<uint32_t>(n));
+    }
+    return groups;
+  }
+
+} // namespace Jug::Base
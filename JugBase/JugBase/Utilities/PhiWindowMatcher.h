@@ -0,0 +1,151 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+namespace Jug::Base {
+
+  /** Closest-energy matching of objects (e.g. clusters) to candidates within phi, z and energy tolerances.
+   *
+   *  The phi, z and energy of the candidates are added once per event and sorted by phi, so that a
+   *  match only looks at the candidates in its phi window (wrapped around +-pi). A candidate is
+   *  accepted within the tolerances that are positive: |dphi| and |dz| below the phi and z
+   *  tolerances, and |dE| / E below the relative energy tolerance, with E the (positive) energy of
+   *  the candidate. The match is the accepted candidate with the closest energy, the first added
+   *  for equal differences; matched candidates can be consumed so that they are not matched again.
+   */
+  class PhiWindowMatcher {
+  public:
+    static constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+
+    struct Tolerances {
+      double phi{-1};
+      double z{-1};
+      double energyRel{-1};
+    };
+
+    /// Remove the candidates, the buffers are kept
+    void clear() {
+      m_phi.clear();
+      m_z.clear();
+      m_energy.clear();
+      m_consumed.clear();
+      m_order.clear();
+      m_sortedPhi.clear();
+      m_sorted = true;
+    }
+
+    void reserve(size_t n) {
+      m_phi.reserve(n);
+      m_z.reserve(n);
+      m_energy.reserve(n);
+      m_consumed.reserve(n);
+    }
+
+    /// Add a candidate, the candidates are numbered in order
+    void add(double phi, double z, double energy) {
+      m_phi.push_back(phi);
+      m_z.push_back(z);
+      m_energy.push_back(energy);
+      m_consumed.push_back(0);
+      m_sorted = false;
+    }
+
+    size_t size() const { return m_phi.size(); }
+
+    void consume(uint32_t candidate) { m_consumed[candidate] = 1; }
+    bool consumed(uint32_t candidate) const { return m_consumed[candidate] != 0; }
+
+    /// Best candidate that is not consumed, kNone if there is none within the tolerances
+    uint32_t match(double phi, double z, double energy, const Tolerances& tolerances) {
+      if (!m_sorted) {
+        sort();
+      }
+      uint32_t best     = kNone;
+      double best_delta = std::numeric_limits<double>::max();
+      auto test         = [&](size_t k) {
+        const uint32_t c = m_order[k];
+        if (m_consumed[c] != 0) {
+          return;
+        }
+        const double ec = m_energy[c];
+        if ((tolerances.energyRel > 0 && (ec <= 0 || std::abs((energy - ec) / ec) > tolerances.energyRel)) ||
+            (tolerances.z > 0 && std::abs(z - m_z[c]) > tolerances.z) ||
+            (tolerances.phi > 0 && delta_phi(phi, m_phi[c]) > tolerances.phi)) {
+          return;
+        }
+        const double delta = std::abs(energy - ec);
+        if (delta < best_delta || (delta == best_delta && c < best)) {
+          best_delta = delta;
+          best       = c;
+        }
+      };
+
+      const size_t n = m_order.size();
+      if (!(tolerances.phi > 0) || tolerances.phi >= M_PI) {
+        for (size_t k = 0; k < n; ++k) {
+          test(k);
+        }
+        return best;
+      }
+      // the window [phi - tolerance, phi + tolerance], in two parts if it wraps around
+      const double lo = wrap(phi - tolerances.phi);
+      const double hi = wrap(phi + tolerances.phi);
+      auto scan       = [&](double from, double to) {
+        for (size_t k = lower(from); k < n && m_sortedPhi[k] <= to; ++k) {
+          test(k);
+        }
+      };
+      if (lo <= hi) {
+        scan(lo, hi);
+      } else {
+        scan(-M_PI, hi);
+        scan(lo, M_PI);
+      }
+      return best;
+    }
+
+    /// |phi1 - phi2| in [0, pi]
+    static double delta_phi(double phi1, double phi2) {
+      const double d = std::abs(wrap(phi1) - wrap(phi2));
+      return (d > M_PI) ? 2. * M_PI - d : d;
+    }
+
+  private:
+    static double wrap(double phi) { return std::remainder(phi, 2. * M_PI); }
+
+    void sort() {
+      m_order.resize(m_phi.size());
+      std::iota(m_order.begin(), m_order.end(), 0);
+      std::sort(m_order.begin(), m_order.end(), [this](uint32_t a, uint32_t b) {
+        return wrap(m_phi[a]) < wrap(m_phi[b]) || (wrap(m_phi[a]) == wrap(m_phi[b]) && a < b);
+      });
+      m_sortedPhi.resize(m_order.size());
+      for (size_t k = 0; k < m_order.size(); ++k) {
+        m_sortedPhi[k] = wrap(m_phi[m_order[k]]);
+      }
+      m_sorted = true;
+    }
+
+    size_t lower(double phi) const {
+      return std::lower_bound(m_sortedPhi.begin(), m_sortedPhi.end(), phi) - m_sortedPhi.begin();
+    }
+
+    std::vector<double> m_phi;
+    std::vector<double> m_z;
+    std::vector<double> m_energy;
+    std::vector<char> m_consumed;
+    std::vector<uint32_t> m_order;
+    std::vector<double> m_sortedPhi;
+    bool m_sorted{true};
+  };
+
+} // namespace Jug::Base
@@ -0,0 +1,160 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace Jug::Base::Random {
+
+  /** Philox4x32-10 counter-based generator (Salmon et al., SC'11).
+   *
+   *  The output is a pure function of a 128-bit counter and a 64-bit key, so that a block of
+   *  random numbers can be generated for any (key, counter) without state, in any order and on
+   *  any thread, and the blocks of an array are independent iterations of one loop.
+   */
+  struct Philox4x32 {
+    using Counter = std::array<uint32_t, 4>;
+    using Key     = std::array<uint32_t, 2>;
+
+    static constexpr uint32_t kMul0  = 0xD2511F53;
+    static constexpr uint32_t kMul1  = 0xCD9E8D57;
+    static constexpr uint32_t kWeyl0 = 0x9E3779B9;
+    static constexpr uint32_t kWeyl1 = 0xBB67AE85;
+
+    static constexpr Counter round(const Counter& c, const Key& k) {
+      const uint64_t p0 = static_cast<uint64_t>(kMul0) * c[0];
+      const uint64_t p1 = static_cast<uint64_t>(kMul1) * c[2];
+      return {static_cast<uint32_t>(p1 >> 32) ^ c[1] ^ k[0], static_cast<uint32_t>(p1),
+              static_cast<uint32_t>(p0 >> 32) ^ c[3] ^ k[1], static_cast<uint32_t>(p0)};
+    }
+
+    /// Four random 32-bit words of a counter and key
+    static constexpr Counter generate(Counter c, Key k) {
+      for (int r = 0; r < 9; ++r) {
+        c = round(c, k);
+        k[0] += kWeyl0;
+        k[1] += kWeyl1;
+      }
+      return round(c, k);
+    }
+  };
+
+  /** Fill n standard normal variates of a (seed, stream), in blocks of four from one Philox draw.
+   *
+   *  Variate i is always the same for the same seed and stream, whatever n is, so a consumer
+   *  that assigns fixed slots of the buffer to its hits is reproducible per event. Streams
+   *  separate the consumers of the same seed (e.g. the detectors of an event).
+   */
+  inline void fill_normal(uint64_t seed, uint64_t stream, double* out, size_t n) {
+    constexpr double kTwoPi = 6.283185307179586;
+    // (x + 0.5) / 2^32, in (0, 1)
+    constexpr double kScale = 1. / 4294967296.;
+    const Philox4x32::Key key{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)};
+    for (size_t block = 0; block * 4 < n; ++block) {
+      const auto w = Philox4x32::generate(
+          {static_cast<uint32_t>(block), static_cast<uint32_t>(static_cast<uint64_t>(block) >> 32),
+           static_cast<uint32_t>(stream), static_cast<uint32_t>(stream >> 32)},
+          key);
+      // Box-Muller on the two pairs of uniforms
+      double z[4];
+      for (int pair = 0; pair < 2; ++pair) {
+        const double u1 = (w[2 * pair] + 0.5) * kScale;
+        const double u2 = (w[2 * pair + 1] + 0.5) * kScale;
+        const double r  = std::sqrt(-2. * std::log(u1));
+        z[2 * pair]     = r * std::cos(kTwoPi * u2);
+        z[2 * pair + 1] = r * std::sin(kTwoPi * u2);
+      }
+      for (size_t j = 0; j < 4 && block * 4 + j < n; ++j) {
+        out[block * 4 + j] = z[j];
+      }
+    }
+  }
+
+  /// Fill n uniform variates in (0, 1) of a (seed, stream), with the same slots as fill_normal
+  inline void fill_uniform(uint64_t seed, uint64_t stream, double* out, size_t n) {
+    constexpr double kScale = 1. / 4294967296.;
+    const Philox4x32::Key key{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)};
+    for (size_t block = 0; block * 4 < n; ++block) {
+      const auto w = Philox4x32::generate(
+          {static_cast<uint32_t>(block), static_cast<uint32_t>(static_cast<uint64_t>(block) >> 32),
+           static_cast<uint32_t>(stream), static_cast<uint32_t>(stream >> 32)},
+          key);
+      for (size_t j = 0; j < 4 && block * 4 + j < n; ++j) {
+        out[block * 4 + j] = (w[j] + 0.5) * kScale;
+      }
+    }
+  }
+
+  inline std::vector<double> normal_buffer(uint64_t seed, uint64_t stream, size_t n) {
+    std::vector<double> buffer(n);
+    fill_normal(seed, stream, buffer.data(), n);
+    return buffer;
+  }
+
+  /// splitmix64 finalizer, to derive independent keys from correlated inputs
+  constexpr uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+  }
+
+  /// FNV-1a hash of a name (e.g. an algorithm name)
+  constexpr uint64_t hash_name(std::string_view name) {
+    uint64_t h = 0xCBF29CE484222325ULL;
+    for (const char c : name) {
+      h = (h ^ static_cast<unsigned char>(c)) * 0x100000001B3ULL;
+    }
+    return h;
+  }
+
+  /// Key of a job, from the seed and the run number
+  constexpr uint64_t job_key(uint64_t seed, uint64_t run) { return mix64(mix64(seed) ^ run); }
+
+  /// Key of the streams of an algorithm in an event (RandomSvc::eventKey)
+  constexpr uint64_t event_key(uint64_t jobKey, std::string_view algorithm, uint64_t event) {
+    return mix64(mix64(jobKey ^ hash_name(algorithm)) ^ event);
+  }
+
+  /** Sequential random numbers of one (key, id), e.g. of a cell in an event.
+   *
+   *  The n-th number of a stream only depends on its key, its id and n, so the streams of
+   *  the cells of an event can be used in any order or thread with identical results.
+   */
+  class Stream {
+  public:
+    Stream(uint64_t key, uint64_t id)
+        : m_key{static_cast<uint32_t>(key), static_cast<uint32_t>(key >> 32)}, m_id(id) {}
+
+    uint32_t next() {
+      if (m_used == 4) {
+        m_words = Philox4x32::generate(
+            {m_block++, 0, static_cast<uint32_t>(m_id), static_cast<uint32_t>(m_id >> 32)}, m_key);
+        m_used = 0;
+      }
+      return m_words[m_used++];
+    }
+    /// Uniform in (0, 1)
+    double uniform() { return (next() + 0.5) / 4294967296.; }
+    /// Standard normal, Box-Muller on two uniforms
+    double normal() {
+      const double u1 = uniform();
+      const double u2 = uniform();
+      return std::sqrt(-2. * std::log(u1)) * std::cos(6.283185307179586 * u2);
+    }
+
+  private:
+    Philox4x32::Key m_key;
+    uint64_t m_id;
+    uint32_t m_block{0};
+    Philox4x32::Counter m_words{};
+    int m_used{4};
+  };
+
+} // namespace Jug::Base::Random
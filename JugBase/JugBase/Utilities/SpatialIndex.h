@@ -0,0 +1,343 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "JugBase/Utilities/FlatIndexMap.h"
+
+namespace Jug::Base {
+
+  /** Coordinates of N points in D dimensions, as D contiguous arrays (structure of arrays).
+   *
+   *  A dimension with a positive period is periodic (e.g. phi with 2 pi): the distance along it is
+   *  the shortest one around the circle, the coordinates may be in any range.
+   */
+  template <size_t D, typename T = double> struct SpatialPoints {
+    std::array<const T*, D> coords{};
+    size_t size{0};
+    std::array<double, D> period{};
+
+    double coord(size_t i, size_t d) const { return static_cast<double>(coords[d][i]); }
+
+    /// Difference along a dimension, the shortest one for periodic dimensions
+    double delta(double a, double b, size_t d) const {
+      double diff = a - b;
+      if (period[d] > 0.) {
+        diff = std::remainder(diff, period[d]);
+      }
+      return diff;
+    }
+
+    double distance2(const std::array<double, D>& point, size_t i) const {
+      double d2 = 0.;
+      for (size_t d = 0; d < D; ++d) {
+        const double diff = delta(point[d], coord(i, d), d);
+        d2 += diff * diff;
+      }
+      return d2;
+    }
+
+    std::array<double, D> point(size_t i) const {
+      std::array<double, D> p;
+      for (size_t d = 0; d < D; ++d) {
+        p[d] = coord(i, d);
+      }
+      return p;
+    }
+  };
+
+  /** Cell list for fixed-radius neighbour queries.
+   *
+   *  The points are binned in cells of cellSize (per dimension, made a divisor of the period for
+   *  periodic dimensions) and sorted by cell, the occupied cells are found by hash of their cell
+   *  coordinates. A query visits the cells within the radius and tests the distance of their
+   *  points, so that the cost is that of the local density for radii of about the cell size.
+   *  Built once per event.
+   */
+  template <size_t D, typename T = double> class CellList {
+  public:
+    void build(const SpatialPoints<D, T>& points, const std::array<double, D>& cellSize) {
+      m_points = points;
+      for (size_t d = 0; d < D; ++d) {
+        m_bins[d]     = 0;
+        m_cellSize[d] = cellSize[d];
+        if (points.period[d] > 0.) {
+          m_bins[d]     = std::max<int64_t>(1, static_cast<int64_t>(std::floor(points.period[d] / cellSize[d])));
+          m_cellSize[d] = points.period[d] / m_bins[d];
+        }
+      }
+      const size_t n = points.size;
+      m_keys.resize(n);
+      for (size_t i = 0; i < n; ++i) {
+        m_keys[i] = key(cell(points.point(i)));
+      }
+      m_order.resize(n);
+      std::iota(m_order.begin(), m_order.end(), 0);
+      std::sort(m_order.begin(), m_order.end(), [this](uint32_t a, uint32_t b) {
+        return m_keys[a] < m_keys[b] || (m_keys[a] == m_keys[b] && a < b);
+      });
+      m_cells = FlatIndexMap(n);
+      m_cellBegin.clear();
+      for (size_t k = 0; k < n; ++k) {
+        if (k == 0 || m_keys[m_order[k]] != m_keys[m_order[k - 1]]) {
+          m_cells.emplace(m_keys[m_order[k]], m_cellBegin.size());
+          m_cellBegin.push_back(k);
+        }
+      }
+      m_cellBegin.push_back(n);
+    }
+
+    /// Call f(index, distance2) for the points within radius of point
+    template <typename F> void forEachWithin(const std::array<double, D>& point, double radius, F&& f) const {
+      const double r2         = radius * radius;
+      const auto center       = cell(point);
+      std::array<int64_t, D> lo;
+      std::array<int64_t, D> count;
+      for (size_t d = 0; d < D; ++d) {
+        const auto range = static_cast<int64_t>(std::ceil(radius / m_cellSize[d]));
+        lo[d]            = center[d] - range;
+        count[d]         = 2 * range + 1;
+        // every cell around the circle at most once
+        if (m_bins[d] > 0 && count[d] > m_bins[d]) {
+          count[d] = m_bins[d];
+        }
+      }
+      std::array<int64_t, D> offset{};
+      while (true) {
+        std::array<int64_t, D> c;
+        for (size_t d = 0; d < D; ++d) {
+          c[d] = lo[d] + offset[d];
+        }
+        const auto slot = m_cells.find(key(c));
+        if (slot != FlatIndexMap::kEmpty) {
+          for (uint32_t k = m_cellBegin[slot]; k < m_cellBegin[slot + 1]; ++k) {
+            const uint32_t i = m_order[k];
+            const double d2 = m_points.distance2(point, i);
+            if (d2 <= r2) {
+              f(i, d2);
+            }
+          }
+        }
+        size_t d = 0;
+        for (; d < D; ++d) {
+          if (++offset[d] < count[d]) {
+            break;
+          }
+          offset[d] = 0;
+        }
+        if (d == D) {
+          break;
+        }
+      }
+    }
+
+    /// Indices of the points within radius of point, in increasing index order
+    void within(const std::array<double, D>& point, double radius, std::vector<uint32_t>& indices) const {
+      indices.clear();
+      forEachWithin(point, radius, [&indices](uint32_t i, double /* d2 */) { indices.push_back(i); });
+      std::sort(indices.begin(), indices.end());
+    }
+
+  private:
+    std::array<int64_t, D> cell(const std::array<double, D>& p) const {
+      std::array<int64_t, D> c;
+      for (size_t d = 0; d < D; ++d) {
+        c[d] = static_cast<int64_t>(std::floor(p[d] / m_cellSize[d]));
+      }
+      return c;
+    }
+
+    // cell coordinates packed in 64 / D bits each, unique within 2^(64 / D) cells per dimension
+    uint64_t key(std::array<int64_t, D> c) const {
+      constexpr size_t bits    = 64 / D;
+      constexpr uint64_t mask  = (bits >= 64) ? ~uint64_t{0} : (uint64_t{1} << bits) - 1;
+      constexpr uint64_t shift = uint64_t{1} << (bits - 1);
+      uint64_t k               = 0;
+      for (size_t d = 0; d < D; ++d) {
+        if (m_bins[d] > 0) {
+          c[d] = ((c[d] % m_bins[d]) + m_bins[d]) % m_bins[d];
+        }
+        k = (bits >= 64 ? 0 : (k << bits)) | ((static_cast<uint64_t>(c[d]) + shift) & mask);
+      }
+      return k;
+    }
+
+    SpatialPoints<D, T> m_points;
+    std::array<double, D> m_cellSize{};
+    std::array<int64_t, D> m_bins{};
+    std::vector<uint64_t> m_keys;
+    std::vector<uint32_t> m_order;
+    std::vector<uint32_t> m_cellBegin;
+    FlatIndexMap m_cells;
+  };
+
+  /** Static k-d tree for k-nearest-neighbour and radius queries.
+   *
+   *  Balanced tree of median splits along the dimension of largest extent, with up to leafSize
+   *  points per leaf; every node keeps the bounding box of its points so that the subtrees are
+   *  pruned with the distance to the box, which also holds around periodic dimensions (the box of
+   *  a node is then not wrapped, its distance is). Built once per event.
+   */
+  template <size_t D, typename T = double> class KDTree {
+  public:
+    explicit KDTree(size_t leafSize = 8) : m_leafSize(std::max<size_t>(1, leafSize)) {}
+
+    void build(const SpatialPoints<D, T>& points) {
+      m_points = points;
+      m_order.resize(points.size);
+      std::iota(m_order.begin(), m_order.end(), 0);
+      m_nodes.clear();
+      if (points.size > 0) {
+        m_nodes.reserve(2 * points.size / m_leafSize + 1);
+        buildNode(0, points.size);
+      }
+    }
+
+    /// The k nearest points, sorted by increasing distance (then index), fewer if there are fewer points
+    void nearest(const std::array<double, D>& point, size_t k, std::vector<std::pair<double, uint32_t>>& result) const {
+      result.clear();
+      if (k == 0 || m_nodes.empty()) {
+        return;
+      }
+      // max-heap of the best candidates
+      auto visit = [&](uint32_t i, double d2) {
+        const std::pair<double, uint32_t> candidate{d2, i};
+        if (result.size() < k) {
+          result.push_back(candidate);
+          std::push_heap(result.begin(), result.end());
+        } else if (candidate < result.front()) {
+          std::pop_heap(result.begin(), result.end());
+          result.back() = candidate;
+          std::push_heap(result.begin(), result.end());
+        }
+      };
+      auto bound = [&]() {
+        return result.size() < k ? std::numeric_limits<double>::infinity() : result.front().first;
+      };
+      search(0, point, visit, bound);
+      std::sort_heap(result.begin(), result.end());
+    }
+
+    /// Call f(index, distance2) for the points within radius of point
+    template <typename F> void forEachWithin(const std::array<double, D>& point, double radius, F&& f) const {
+      if (m_nodes.empty()) {
+        return;
+      }
+      const double r2 = radius * radius;
+      search(
+          0, point,
+          [&](uint32_t i, double d2) {
+            if (d2 <= r2) {
+              f(i, d2);
+            }
+          },
+          [r2]() { return r2; });
+    }
+
+  private:
+    struct Node {
+      std::array<double, D> lo;
+      std::array<double, D> hi;
+      uint32_t begin;
+      uint32_t end;
+      // children, none for leaves
+      uint32_t left{0};
+      uint32_t right{0};
+    };
+
+    uint32_t buildNode(size_t begin, size_t end) {
+      const auto index = static_cast<uint32_t>(m_nodes.size());
+      m_nodes.push_back({});
+      Node node;
+      node.begin = begin;
+      node.end   = end;
+      node.lo.fill(std::numeric_limits<double>::infinity());
+      node.hi.fill(-std::numeric_limits<double>::infinity());
+      for (size_t k = begin; k < end; ++k) {
+        for (size_t d = 0; d < D; ++d) {
+          const double x = m_points.coord(m_order[k], d);
+          node.lo[d]     = std::min(node.lo[d], x);
+          node.hi[d]     = std::max(node.hi[d], x);
+        }
+      }
+      if (end - begin > m_leafSize) {
+        size_t axis = 0;
+        for (size_t d = 1; d < D; ++d) {
+          if (node.hi[d] - node.lo[d] > node.hi[axis] - node.lo[axis]) {
+            axis = d;
+          }
+        }
+        const size_t mid = begin + (end - begin) / 2;
+        std::nth_element(m_order.begin() + begin, m_order.begin() + mid, m_order.begin() + end,
+                         [this, axis](uint32_t a, uint32_t b) {
+                           return m_points.coord(a, axis) < m_points.coord(b, axis);
+                         });
+        node.left  = buildNode(begin, mid);
+        node.right = buildNode(mid, end);
+      }
+      m_nodes[index] = node;
+      return index;
+    }
+
+    // squared distance of a point to the box of a node
+    double boxDistance2(const Node& node, const std::array<double, D>& p) const {
+      double d2 = 0.;
+      for (size_t d = 0; d < D; ++d) {
+        double diff = 0.;
+        if (m_points.period[d] > 0.) {
+          // the point or one of its images in the box, otherwise the closest edge around the circle
+          const double period = m_points.period[d];
+          const double width  = node.hi[d] - node.lo[d];
+          const double shift  = p[d] - node.lo[d] - std::floor((p[d] - node.lo[d]) / period) * period;
+          if (shift > width) {
+            diff = std::min(shift - width, period - shift);
+          }
+        } else if (p[d] < node.lo[d]) {
+          diff = node.lo[d] - p[d];
+        } else if (p[d] > node.hi[d]) {
+          diff = p[d] - node.hi[d];
+        }
+        d2 += diff * diff;
+      }
+      return d2;
+    }
+
+    template <typename Visit, typename Bound>
+    void search(uint32_t index, const std::array<double, D>& point, Visit&& visit, const Bound& bound) const {
+      const Node& node = m_nodes[index];
+      if (node.left == 0) {
+        for (uint32_t k = node.begin; k < node.end; ++k) {
+          visit(m_order[k], m_points.distance2(point, m_order[k]));
+        }
+        return;
+      }
+      // the closer child first
+      const double dl = boxDistance2(m_nodes[node.left], point);
+      const double dr = boxDistance2(m_nodes[node.right], point);
+      const auto first  = dl <= dr ? node.left : node.right;
+      const auto second = dl <= dr ? node.right : node.left;
+      if (std::min(dl, dr) <= bound()) {
+        search(first, point, visit, bound);
+      }
+      if (std::max(dl, dr) <= bound()) {
+        search(second, point, visit, bound);
+      }
+    }
+
+    size_t m_leafSize;
+    SpatialPoints<D, T> m_points;
+    std::vector<uint32_t> m_order;
+    std::vector<Node> m_nodes;
+  };
+
+} // namespace Jug::Base
@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace Jug::Base {
+
+  /// Whether two hit times are within the window, always true for a window <= 0 (no time selection)
+  inline bool inTimeWindow(double t1, double t2, double window) {
+    return window <= 0. || std::abs(t1 - t2) <= window;
+  }
+
+  /// Range [tmin, tmax] of the times within the window around t, all the times for a window <= 0
+  inline std::pair<double, double> timeWindowRange(double t, double window) {
+    if (window <= 0.) {
+      return {-std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity()};
+    }
+    return {t - window, t + window};
+  }
+
+  /** Time-ordered secondary index of the hits of a collection.
+   *
+   *  The hits stay in their order, the index holds their indices sorted by time, so that the hits
+   *  in a time window are found by binary search without scanning the others, and the hits are
+   *  split in groups separated by gaps in time (e.g. for seeding each group independently).
+   */
+  class TimeIndex {
+  public:
+    /// Index of n hits, time(i) is the time of hit i
+    template <typename Time> void build(size_t n, Time&& time) {
+      m_order.resize(n);
+      std::iota(m_order.begin(), m_order.end(), 0);
+      m_times.resize(n);
+      for (size_t i = 0; i < n; ++i) {
+        m_times[i] = time(i);
+      }
+      std::stable_sort(m_order.begin(), m_order.end(), [this](size_t a, size_t b) { return m_times[a] < m_times[b]; });
+      m_sorted.resize(n);
+      for (size_t k = 0; k < n; ++k) {
+        m_sorted[k] = m_times[m_order[k]];
+      }
+    }
+
+    size_t size() const { return m_order.size(); }
+    /// Hit indices in time order
+    const std::vector<size_t>& order() const { return m_order; }
+
+    /// Call visit(i) for the hits i with |time - t| <= window, in time order
+    template <typename Visitor> void forEachInWindow(double t, double window, Visitor&& visit) const {
+      const auto [tmin, tmax] = timeWindowRange(t, window);
+      auto it = std::lower_bound(m_sorted.begin(), m_sorted.end(), tmin);
+      for (; it != m_sorted.end() && *it <= tmax; ++it) {
+        visit(m_order[it - m_sorted.begin()]);
+      }
+    }
+
+    /** Groups of hits in time order, as ranges [first, last) of order().
+     *
+     *  A group ends where the next hit is more than gap later than the previous one, a single
+     *  group without time selection (gap <= 0).
+     */
+    std::vector<std::pair<size_t, size_t>> groups(double gap) const {
+      std::vector<std::pair<size_t, size_t>> ranges;
+      if (m_order.empty()) {
+        return ranges;
+      }
+      size_t first = 0;
+      for (size_t k = 1; k < m_sorted.size(); ++k) {
+        if (gap > 0. && m_sorted[k] - m_sorted[k - 1] > gap) {
+          ranges.emplace_back(first, k);
+          first = k;
+        }
+      }
+      ranges.emplace_back(first, m_sorted.size());
+      return ranges;
+    }
+
+  private:
+    std::vector<size_t> m_order;
+    std::vector<double> m_times;
+    std::vector<double> m_sorted;
+  };
+
+  /** Hits binned by a 64-bit key (e.g. a packed cell of a neighbour search grid), sorted by time in
+   *  each bin.
+   *
+   *  The candidates of a bin within a time window are found by binary search on (key, time), so
+   *  that the out-of-time hits of the bin are skipped without being visited.
+   */
+  class TimeSortedBins {
+  public:
+    void clear() { m_entries.clear(); }
+    void reserve(size_t n) { m_entries.reserve(n); }
+    void add(uint64_t key, double time, size_t index) { m_entries.push_back({key, time, index}); }
+    /// Sort the entries once they are all added
+    void sort() {
+      std::sort(m_entries.begin(), m_entries.end(), [](const Entry& a, const Entry& b) {
+        return (a.key != b.key) ? a.key < b.key : (a.time != b.time) ? a.time < b.time : a.index < b.index;
+      });
+    }
+
+    /// Call func(index) for the hits of the bin with a time in [tmin, tmax]
+    template <typename Func> void forEach(uint64_t key, double tmin, double tmax, Func&& func) const {
+      auto it = std::lower_bound(m_entries.begin(), m_entries.end(), std::make_pair(key, tmin),
+                                 [](const Entry& e, const std::pair<uint64_t, double>& k) {
+                                   return (e.key != k.first) ? e.key < k.first : e.time < k.second;
+                                 });
+      for (; it != m_entries.end() && it->key == key && it->time <= tmax; ++it) {
+        func(it->index);
+      }
+    }
+
+  private:
+    struct Entry {
+      uint64_t key;
+      double time;
+      size_t index;
+    };
+    std::vector<Entry> m_entries;
+  };
+
+} // namespace Jug::Base
@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace Jug::Base {
+
+  /** Time slice of a time frame of the streaming readout.
+   *
+   *  The hits of the slice are those in [begin, end), the consecutive slices overlap so that the
+   *  objects near a boundary are reconstructed whole in one of them. Each slice owns the objects
+   *  in its core [coreBegin, coreEnd), the middle of the overlaps, so that the cores of the slices
+   *  of a frame tile the time axis and every object is kept in exactly one slice.
+   */
+  struct TimeSlice {
+    uint64_t frame{0};
+    uint32_t index{0};
+    uint32_t count{1};
+    double begin{0};
+    double end{0};
+    double coreBegin{-std::numeric_limits<double>::infinity()};
+    double coreEnd{std::numeric_limits<double>::infinity()};
+
+    bool owns(double time) const { return time >= coreBegin && time < coreEnd; }
+
+    /// Flat form, to be stored in the event as a vector of doubles
+    std::vector<double> encode() const {
+      return {static_cast<double>(frame), static_cast<double>(index), static_cast<double>(count), begin, end,
+              coreBegin, coreEnd};
+    }
+    /// Slice of the flat form, false if it is not one
+    static bool decode(const std::vector<double>& values, TimeSlice& slice) {
+      if (values.size() != 7) {
+        return false;
+      }
+      slice = {static_cast<uint64_t>(values[0]), static_cast<uint32_t>(values[1]), static_cast<uint32_t>(values[2]),
+               values[3], values[4], values[5], values[6]};
+      return true;
+    }
+  };
+
+  /** Slices of length with the given overlap covering the hits of a frame in [tmin, tmax].
+   *
+   *  The first core starts at -inf and the last one ends at +inf, a frame always has at least one
+   *  slice (also without hits). The overlap has to be shorter than the length.
+   */
+  inline std::vector<TimeSlice> makeTimeSlices(uint64_t frame, double tmin, double tmax, double length,
+                                               double overlap) {
+    std::vector<TimeSlice> slices;
+    const double step = length - overlap;
+    for (uint32_t k = 0;; ++k) {
+      TimeSlice slice;
+      slice.frame = frame;
+      slice.index = k;
+      slice.begin = tmin + k * step;
+      slice.end   = slice.begin + length;
+      if (k > 0) {
+        slice.coreBegin       = slice.begin + 0.5 * overlap;
+        slices.back().coreEnd = slice.coreBegin;
+      }
+      slices.push_back(slice);
+      if (slice.end > tmax) {
+        break;
+      }
+    }
+    for (auto& slice : slices) {
+      slice.count = static_cast<uint32_t>(slices.size());
+    }
+    return slices;
+  }
+
+  /// Range [first, last) of the sorted times in the slice
+  inline std::pair<size_t, size_t> sliceRange(const std::vector<double>& sortedTimes, const TimeSlice& slice) {
+    const auto first = std::lower_bound(sortedTimes.begin(), sortedTimes.end(), slice.begin);
+    const auto last  = std::lower_bound(first, sortedTimes.end(), slice.end);
+    return {static_cast<size_t>(first - sortedTimes.begin()), static_cast<size_t>(last - sortedTimes.begin())};
+  }
+
+} // namespace Jug::Base
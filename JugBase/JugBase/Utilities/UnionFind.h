@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+namespace Jug::Base {
+
+  /** Union-find of the elements 0 ... n-1, with path halving.
+   *
+   *  A root is always linked to the smaller root, so that the root of a set is its first element:
+   *  the sets come out in the order of their first element, whatever the order of the unions.
+   *  Its buffer is kept by reset, to be reused between the events.
+   */
+  class UnionFind {
+  public:
+    void reset(size_t n) {
+      m_parent.resize(n);
+      std::iota(m_parent.begin(), m_parent.end(), 0U);
+    }
+    /// Add an element in a set of its own, returns its index
+    uint32_t add() {
+      const auto i = static_cast<uint32_t>(m_parent.size());
+      m_parent.push_back(i);
+      return i;
+    }
+    size_t size() const { return m_parent.size(); }
+
+    uint32_t find(uint32_t i) {
+      while (m_parent[i] != i) {
+        m_parent[i] = m_parent[m_parent[i]];
+        i           = m_parent[i];
+      }
+      return i;
+    }
+    void unite(uint32_t i, uint32_t j) {
+      i = find(i);
+      j = find(j);
+      if (i != j) {
+        m_parent[std::max(i, j)] = std::min(i, j);
+      }
+    }
+
+  private:
+    std::vector<uint32_t> m_parent;
+  };
+
+} // namespace Jug::Base
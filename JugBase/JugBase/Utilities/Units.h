@@ -0,0 +1,17 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#pragma once
+
+namespace Jug::Units {
+
+  /// Units of the job options (Gaudi::Units, i.e. CLHEP: MeV, mm, ns), for the framework-independent
+  /// algorithms whose properties keep the values of their Gaudi versions
+  constexpr double MeV = 1.;
+  constexpr double eV  = 1.e-6 * MeV;
+  constexpr double keV = 1.e-3 * MeV;
+  constexpr double GeV = 1.e+3 * MeV;
+  constexpr double mm  = 1.;
+  constexpr double ns  = 1.;
+
+} // namespace Jug::Units
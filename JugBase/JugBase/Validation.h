@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_VALIDATION_H
+#define JUGBASE_VALIDATION_H
+
+#include <cmath>
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace Jug {
+
+  /// Tolerance of the floating point values of the validation, |a - b| <= absolute + relative * |a|
+  struct ValidationTolerance {
+    double absolute{0.};
+    double relative{0.};
+  };
+
+  /** Mismatches of the outputs of the optimized and the reference paths of an algorithm.
+   *
+   *  The outputs are compared collection by collection (collection() names the current one),
+   *  their sizes and then the fields of their elements, the integers exactly and the floating
+   *  point values within the tolerance. The first maxMessages mismatches are described, all of
+   *  them are counted.
+   */
+  class ValidationReport {
+  public:
+    explicit ValidationReport(ValidationTolerance tolerance = {}, size_t maxMessages = 10)
+        : m_tolerance(tolerance), m_maxMessages(maxMessages) {}
+
+    void collection(const std::string& name) { m_collection = name; }
+
+    /// Compare the sizes of the collections, false on a mismatch
+    bool size(size_t reference, size_t optimized) {
+      if (reference == optimized) {
+        return true;
+      }
+      mismatch() << "size " << optimized << " instead of " << reference;
+      return false;
+    }
+
+    /// Compare a field of element index
+    template <typename T> void value(size_t index, const char* field, T reference, T optimized) {
+      bool same = true;
+      if constexpr (std::is_floating_point_v<T>) {
+        const double r = reference;
+        const double o = optimized;
+        same = (std::isnan(r) && std::isnan(o)) ||
+               std::abs(o - r) <= m_tolerance.absolute + m_tolerance.relative * std::abs(r);
+      } else {
+        same = (reference == optimized);
+      }
+      if (!same) {
+        mismatch() << "[" << index << "]." << field << " = " << optimized << " instead of " << reference;
+      }
+    }
+
+    size_t mismatches() const { return m_mismatches; }
+    bool ok() const { return m_mismatches == 0; }
+    const std::vector<std::string>& messages() const { return m_messages; }
+
+  private:
+    /// Stream of the description of a mismatch, discarded after maxMessages
+    class Message {
+    public:
+      Message(std::vector<std::string>* messages, const std::string& collection) : m_messages(messages) {
+        if (m_messages != nullptr) {
+          m_stream << collection << ": ";
+        }
+      }
+      Message(const Message&)            = delete;
+      Message& operator=(const Message&) = delete;
+      ~Message() {
+        if (m_messages != nullptr) {
+          m_messages->push_back(m_stream.str());
+        }
+      }
+      template <typename T> Message& operator<<(const T& value) {
+        if (m_messages != nullptr) {
+          m_stream << value;
+        }
+        return *this;
+      }
+
+    private:
+      std::vector<std::string>* m_messages;
+      std::ostringstream m_stream;
+    };
+
+    Message mismatch() {
+      ++m_mismatches;
+      return {(m_messages.size() < m_maxMessages) ? &m_messages : nullptr, m_collection};
+    }
+
+    ValidationTolerance m_tolerance;
+    size_t m_maxMessages;
+    std::string m_collection;
+    size_t m_mismatches{0};
+    std::vector<std::string> m_messages;
+  };
+
+} // namespace Jug
+
+#endif
@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: LGPL-3.0-or-later
+# Copyright (C) 2022 Wouter Deconinck
+
+"""Check that the debug and verbose messages in loops are only built when their level is enabled.
+
+A debug() or verbose() stream in a for or while loop has to be in a JUG_DEBUG/JUG_VERBOSE macro
+(JugBase/Logging.h) or in a block guarded by msgLevel, otherwise its arguments are evaluated for
+every iteration also when the messages are dropped. Messages outside of loops are not checked.
+
+    check_debug_logging.py [--all] [paths ...]
+
+Prints the unguarded messages as file:line and exits with 1 if there are any. With --all, the
+messages outside of loops are reported too.
+"""
+
+import argparse
+import pathlib
+import re
+import sys
+
+STREAM = re.compile(r'\b(debug|verbose)\(\)\s*<<')
+LOOP = re.compile(r'^\s*(}\s*)?(for|while|do)\b')
+# msgLevel, or a flag with the level cached before the loop (if (debugHits))
+GUARD = re.compile(r'msgLevel\s*\(|\bif\s*\(\s*(m_)?(debug|verbose)\w*\s*\)')
+SOURCES = ('.cpp', '.h', '.hpp', '.cxx')
+DEFAULT_PATHS = ('JugBase', 'JugDigi', 'JugFast', 'JugPID', 'JugReco', 'JugTrack')
+
+
+def strip(line):
+    """Line without comments and string literals"""
+    line = re.sub(r'"(\\.|[^"\\])*"', '""', line)
+    line = re.sub(r"'(\\.|[^'\\])*'", "''", line)
+    return line.split('//')[0]
+
+
+def check(path, all_messages):
+    """Unguarded messages of a file, as (line number, line)"""
+    found = []
+    # headers of the enclosing blocks, the statement before a block opens it
+    blocks = []
+    statement = ''
+    parens = 0
+    in_comment = False
+    previous = ''
+    for number, raw in enumerate(path.read_text(errors='replace').splitlines(), 1):
+        line = raw
+        if in_comment:
+            if '*/' not in line:
+                continue
+            line = line.split('*/', 1)[1]
+            in_comment = False
+        line = re.sub(r'/\*.*?\*/', '', line)
+        if '/*' in line:
+            line = line.split('/*', 1)[0]
+            in_comment = True
+        line = strip(line)
+        if line.lstrip().startswith('#'):
+            continue
+
+        if STREAM.search(line):
+            guarded = any(GUARD.search(header) for header in blocks) or GUARD.search(statement + line) \
+                or GUARD.search(previous)
+            in_loop = any(LOOP.search(header) for header in blocks)
+            if not guarded and (in_loop or all_messages):
+                found.append((number, raw.strip()))
+
+        for char in line:
+            if char == '{':
+                blocks.append(statement)
+                statement = ''
+                parens = 0
+            elif char == '}':
+                if blocks:
+                    blocks.pop()
+                statement = ''
+            elif char == ';' and parens == 0:
+                statement = ''
+            else:
+                parens += {'(': 1, ')': -1}.get(char, 0)
+                statement += char
+        if line.strip():
+            # a guard without braces applies to the next statement
+            previous = line if not line.rstrip().endswith(';') or GUARD.search(line) is None else ''
+    return found
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--all', action='store_true', help='also report the messages outside of loops')
+    parser.add_argument('paths', nargs='*', help='files or directories (the packages by default)')
+    args = parser.parse_args()
+
+    root = pathlib.Path(__file__).resolve().parents[2]
+    paths = [pathlib.Path(p) for p in args.paths] or [root / p for p in DEFAULT_PATHS]
+    files = []
+    for path in paths:
+        files += sorted(f for f in path.rglob('*') if f.suffix in SOURCES) if path.is_dir() else [path]
+
+    count = 0
+    for f in files:
+        for number, line in check(f, args.all):
+            print(f'{f}:{number}: unguarded message: {line}')
+            count += 1
+    if count:
+        print(f'{count} unguarded messages, use JUG_DEBUG/JUG_VERBOSE (JugBase/Logging.h) or a msgLevel guard',
+              file=sys.stderr)
+    return 1 if count else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
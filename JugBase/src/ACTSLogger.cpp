@@ -3,18 +3,20 @@
 
 #include "JugBase/ACTSLogger.h"
 #include "GaudiKernel/IMessageSvc.h"
-#include "GaudiKernel/IMessageSvc.h"
-#include "GaudiKernel/MsgStream.h"
+#include "GaudiKernel/ServiceHandle.h"
+
+namespace Jug {
+std::unique_ptr<const Acts::Logger> makeActsLogger(const std::string& name, IMessageSvc* msgSvc, MSG::Level level) {
+  return std::make_unique<Acts::Logger>(std::make_unique<GaudiPrintPolicy>(msgSvc, name),
+                                        std::make_unique<GaudiFilterPolicy>(level));
+}
+} // namespace Jug
 
 namespace Acts {
 std::unique_ptr<const Logger> getDefaultLogger(const std::string& name, const Logging::Level& lvl, std::ostream* /* unused */) {
-  using namespace Logging;
-  //ServiceHandle<IMessageSvc>* msgSvc = new ServiceHandle<IMessageSvc>("MessageSvc", name);
+  // the level of the source of the logger only, the others keep theirs
   ServiceHandle<IMessageSvc> msgSvc("MessageSvc", name);
-  msgSvc->setOutputLevel(lvl + 1);
-  auto printPol = std::make_unique<GaudiPrintPolicy>(&(*msgSvc));
-  printPol->setName(name);
-  return std::make_unique<Acts::Logger>(std::move(printPol),
-                                        std::make_unique<GaudiFilterPolicy>(&(*msgSvc)));
+  msgSvc->setOutputLevel(name, Jug::gaudiLevel(lvl));
+  return Jug::makeActsLogger(name, &(*msgSvc), Jug::gaudiLevel(lvl));
 }
 }
@@ -0,0 +1,193 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "JugBase/Calibration.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace Jug::Base {
+
+namespace {
+  struct Row {
+    size_t iov;
+    std::vector<int64_t> fields;
+    std::vector<float> constants;
+  };
+
+  std::runtime_error invalid(const std::string& filename, size_t lineNumber, const std::string& what) {
+    return std::runtime_error(filename + " line " + std::to_string(lineNumber) + ": " + what);
+  }
+} // namespace
+
+void Calibration::Table::values(int column, const std::vector<Channel>& channels, float fallback,
+                                std::vector<float>& out) const {
+  out.resize(channels.size());
+  if (column < 0) {
+    std::fill(out.begin(), out.end(), fallback);
+    return;
+  }
+  const float* constant = constants[column].data();
+  for (size_t i = 0; i < channels.size(); ++i) {
+    const float value = constant[channels[i]];
+    out[i]            = std::isnan(value) ? fallback : value;
+  }
+}
+
+std::unique_ptr<Calibration> Calibration::read(const std::string& filename, const dd4hep::Detector& detector) {
+  std::ifstream is(filename);
+  if (!is) {
+    throw std::runtime_error("cannot open " + filename);
+  }
+  auto calibration = std::make_unique<Calibration>();
+  std::shared_ptr<const CellIDDecoder> decoder;
+  std::vector<Row> rows;
+
+  std::string line;
+  for (size_t lineNumber = 1; std::getline(is, line); ++lineNumber) {
+    line = line.substr(0, line.find('#'));
+    std::istringstream words(line);
+    std::string keyword;
+    if (!(words >> keyword)) {
+      continue;
+    }
+    if (keyword == "readout") {
+      if (!(words >> calibration->m_readout)) {
+        throw invalid(filename, lineNumber, "no readout");
+      }
+      decoder = CellIDDecoder::readout(detector, calibration->m_readout);
+    } else if (keyword == "channel") {
+      if (decoder == nullptr) {
+        throw invalid(filename, lineNumber, "channel fields before the readout");
+      }
+      for (std::string name; words >> name;) {
+        calibration->m_fields.push_back({decoder->field(name), 0, 0, 0});
+      }
+    } else if (keyword == "constants") {
+      for (std::string name; words >> name;) {
+        calibration->m_constants.push_back(name);
+      }
+    } else if (keyword == "iov") {
+      Table table;
+      std::string until;
+      if (!(words >> table.since >> until)) {
+        throw invalid(filename, lineNumber, "invalid IOV");
+      }
+      table.until = (until == "-") ? kNoEnd : std::stoull(until);
+      if (table.until <= table.since) {
+        throw invalid(filename, lineNumber, "empty IOV");
+      }
+      calibration->m_tables.push_back(std::move(table));
+    } else {
+      if (calibration->m_fields.empty() || calibration->m_constants.empty() || calibration->m_tables.empty()) {
+        throw invalid(filename, lineNumber, "constants before the channel fields, constant names or IOV");
+      }
+      Row row{calibration->m_tables.size() - 1, std::vector<int64_t>(calibration->m_fields.size()),
+              std::vector<float>(calibration->m_constants.size())};
+      std::istringstream values(line);
+      for (auto& value : row.fields) {
+        values >> value;
+      }
+      for (auto& value : row.constants) {
+        values >> value;
+      }
+      if (!values) {
+        throw invalid(filename, lineNumber, "invalid constants");
+      }
+      rows.push_back(std::move(row));
+    }
+  }
+  if (calibration->m_fields.empty() || calibration->m_constants.empty() || calibration->m_tables.empty()) {
+    throw std::runtime_error(filename + ": no channel fields, constant names or IOV");
+  }
+
+  // dense channels over the ranges of the field values
+  uint64_t nchannels = 1;
+  for (size_t k = calibration->m_fields.size(); k-- > 0;) {
+    auto& field = calibration->m_fields[k];
+    int64_t min = std::numeric_limits<int64_t>::max();
+    int64_t max = std::numeric_limits<int64_t>::min();
+    for (const auto& row : rows) {
+      min = std::min(min, row.fields[k]);
+      max = std::max(max, row.fields[k]);
+    }
+    field.min    = rows.empty() ? 0 : min;
+    field.extent = rows.empty() ? 1 : static_cast<uint64_t>(max - min) + 1;
+    field.stride = nchannels;
+    nchannels *= field.extent;
+    if (nchannels >= std::numeric_limits<Channel>::max()) {
+      throw std::runtime_error(filename + ": too many channels for the ranges of the channel fields");
+    }
+  }
+  calibration->m_nchannels = static_cast<Channel>(nchannels);
+
+  for (auto& table : calibration->m_tables) {
+    table.constants.assign(calibration->m_constants.size(),
+                           std::vector<float>(nchannels + 1, std::numeric_limits<float>::quiet_NaN()));
+  }
+  for (const auto& row : rows) {
+    uint64_t channel = 0;
+    for (size_t k = 0; k < row.fields.size(); ++k) {
+      const auto& field = calibration->m_fields[k];
+      channel += static_cast<uint64_t>(row.fields[k] - field.min) * field.stride;
+    }
+    auto& table = calibration->m_tables[row.iov];
+    for (size_t c = 0; c < row.constants.size(); ++c) {
+      table.constants[c][channel] = row.constants[c];
+    }
+  }
+
+  auto& tables = calibration->m_tables;
+  std::sort(tables.begin(), tables.end(), [](const Table& a, const Table& b) { return a.since < b.since; });
+  for (size_t i = 1; i < tables.size(); ++i) {
+    if (tables[i].since < tables[i - 1].until) {
+      throw std::runtime_error(filename + ": overlapping IOVs starting at " + std::to_string(tables[i].since));
+    }
+  }
+  return calibration;
+}
+
+int Calibration::column(const std::string& name) const {
+  const auto it = std::find(m_constants.begin(), m_constants.end(), name);
+  return (it == m_constants.end()) ? -1 : static_cast<int>(it - m_constants.begin());
+}
+
+void Calibration::channels(const std::vector<uint64_t>& cellIDs, std::vector<Channel>& out) const {
+  const size_t n = cellIDs.size();
+  std::vector<uint64_t> channels(n, 0);
+  std::vector<uint8_t> outside(n, 0);
+  std::vector<int64_t> values;
+  // field by field, in array loops
+  for (const auto& field : m_fields) {
+    CellIDDecoder::values(field.field, cellIDs, values);
+    for (size_t i = 0; i < n; ++i) {
+      const auto offset = static_cast<uint64_t>(values[i] - field.min);
+      outside[i] |= static_cast<uint8_t>(offset >= field.extent);
+      channels[i] += offset * field.stride;
+    }
+  }
+  out.resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    out[i] = (outside[i] != 0) ? m_nchannels : static_cast<Channel>(channels[i]);
+  }
+}
+
+const Calibration::Table* Calibration::table(uint64_t run) const {
+  const size_t last = m_last.load(std::memory_order_relaxed);
+  if (last < m_tables.size() && m_tables[last].contains(run)) {
+    return &m_tables[last];
+  }
+  // last IOV starting at or before the run
+  auto it = std::upper_bound(m_tables.begin(), m_tables.end(), run,
+                             [](uint64_t r, const Table& table) { return r < table.since; });
+  if (it == m_tables.begin() || !(--it)->contains(run)) {
+    return nullptr;
+  }
+  m_last.store(it - m_tables.begin(), std::memory_order_relaxed);
+  return &*it;
+}
+
+} // namespace Jug::Base
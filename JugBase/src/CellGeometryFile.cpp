@@ -0,0 +1,243 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "JugBase/CellGeometryFile.h"
+
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <iterator>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "DD4hep/Detector.h"
+#include "DD4hep/Readout.h"
+#include "DDRec/CellIDPositionConverter.h"
+#include "DDSegmentation/Segmentation.h"
+
+namespace {
+constexpr uint64_t kFileMagic   = 0x474c4c454347554a; // "JUGCELLG"
+constexpr uint32_t kFileVersion = 1;
+
+struct FileHeader {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t ntables;
+  uint64_t geometryHash;
+};
+
+struct DirectoryEntry {
+  uint64_t nameOffset;
+  uint64_t nameLength;
+  uint64_t recordsOffset;
+  uint64_t nrecords;
+};
+
+constexpr uint64_t align8(uint64_t offset) { return (offset + 7) & ~uint64_t(7); }
+
+template <typename T> void write_value(std::ostream& os, const T& value) {
+  os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// FNV-1a
+class Hash {
+public:
+  void add(const void* data, size_t size) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+      m_value = (m_value ^ bytes[i]) * 0x100000001b3ULL;
+    }
+  }
+  // with the terminating null, so that consecutive strings are not ambiguous
+  void add(const std::string& s) { add(s.c_str(), s.size() + 1); }
+  uint64_t value() const { return m_value; }
+
+private:
+  uint64_t m_value{0xcbf29ce484222325ULL};
+};
+
+std::string readFile(const std::string& filename) {
+  std::ifstream is(filename, std::ios::binary);
+  return {std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>()};
+}
+} // namespace
+
+namespace Jug::Base {
+
+const CellGeometryFile::Record* CellGeometryFile::Table::find(uint64_t cellID) const {
+  const auto* it = std::lower_bound(begin, end, cellID, [](const Record& r, uint64_t id) { return r.cellID < id; });
+  return (it != end && it->cellID == cellID) ? it : nullptr;
+}
+
+CellGeometryFile::~CellGeometryFile() { close(); }
+
+void CellGeometryFile::close() {
+  if (m_data != nullptr) {
+    munmap(m_data, m_size);
+  }
+  m_data         = nullptr;
+  m_size         = 0;
+  m_geometryHash = 0;
+  m_tables.clear();
+}
+
+bool CellGeometryFile::open(const std::string& filename) {
+  close();
+  const int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st {};
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(FileHeader)) {
+    ::close(fd);
+    return false;
+  }
+  m_size = st.st_size;
+  m_data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // the mapping stays valid after the file is closed
+  ::close(fd);
+  if (m_data == MAP_FAILED) {
+    m_data = nullptr;
+    m_size = 0;
+    return false;
+  }
+
+  const auto* base   = static_cast<const char*>(m_data);
+  const auto* header = reinterpret_cast<const FileHeader*>(base);
+  if (header->magic != kFileMagic || header->version != kFileVersion ||
+      sizeof(FileHeader) + header->ntables * sizeof(DirectoryEntry) > m_size) {
+    close();
+    return false;
+  }
+  const auto* directory = reinterpret_cast<const DirectoryEntry*>(base + sizeof(FileHeader));
+  for (uint32_t t = 0; t < header->ntables; ++t) {
+    const auto& entry = directory[t];
+    if (entry.nameOffset + entry.nameLength > m_size || entry.recordsOffset % alignof(Record) != 0 ||
+        entry.recordsOffset + entry.nrecords * sizeof(Record) > m_size) {
+      close();
+      return false;
+    }
+    const auto* records = reinterpret_cast<const Record*>(base + entry.recordsOffset);
+    m_tables.emplace(std::string(base + entry.nameOffset, entry.nameLength),
+                     Table{records, records + entry.nrecords});
+  }
+  m_geometryHash = header->geometryHash;
+  return true;
+}
+
+const CellGeometryFile::Table* CellGeometryFile::table(const std::string& readout) const {
+  auto it = m_tables.find(readout);
+  return (it != m_tables.end()) ? &it->second : nullptr;
+}
+
+bool CellGeometryFile::write(const std::string& filename, uint64_t geometryHash,
+                             std::map<std::string, std::vector<Record>> tables) {
+  std::vector<DirectoryEntry> directory;
+  uint64_t offset = sizeof(FileHeader) + tables.size() * sizeof(DirectoryEntry);
+  for (const auto& [readout, records] : tables) {
+    directory.push_back({offset, readout.size(), 0, 0});
+    offset += readout.size();
+  }
+  const uint64_t names_end = offset;
+  offset                   = align8(offset);
+  size_t t                 = 0;
+  for (auto& [readout, records] : tables) {
+    std::sort(records.begin(), records.end(), [](const Record& a, const Record& b) { return a.cellID < b.cellID; });
+    records.erase(std::unique(records.begin(), records.end(),
+                              [](const Record& a, const Record& b) { return a.cellID == b.cellID; }),
+                  records.end());
+    directory[t].recordsOffset = offset;
+    directory[t].nrecords      = records.size();
+    offset += records.size() * sizeof(Record);
+    ++t;
+  }
+
+  std::ofstream os(filename, std::ios::binary | std::ios::trunc);
+  if (!os) {
+    return false;
+  }
+  write_value(os, FileHeader{kFileMagic, kFileVersion, static_cast<uint32_t>(tables.size()), geometryHash});
+  for (const auto& entry : directory) {
+    write_value(os, entry);
+  }
+  for (const auto& [readout, records] : tables) {
+    os.write(readout.data(), readout.size());
+  }
+  const char padding[8] = {};
+  os.write(padding, align8(names_end) - names_end);
+  for (const auto& [readout, records] : tables) {
+    os.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(Record));
+  }
+  return static_cast<bool>(os);
+}
+
+CellGeometryFile::Record CellGeometryFile::record(const dd4hep::rec::CellIDPositionConverter& converter,
+                                                  const dd4hep::DetElement& local, uint64_t cellID) {
+  Record rec{cellID, {0., 0., 0.}, {0., 0., 0.}};
+  const auto gpos = converter.position(cellID);
+  rec.global[0]   = gpos.x();
+  rec.global[1]   = gpos.y();
+  rec.global[2]   = gpos.z();
+
+  // the tracker readouts may not provide cell dimensions, they are left at 0
+  std::vector<double> cdim;
+  try {
+    if (converter.findReadout(local).segmentation().type() != "NoSegmentation") {
+      // segmentation dimensions
+      cdim = converter.cellDimensions(cellID);
+    } else {
+      // bounding box instead of the actual solid, so the dimensions are always in x, y, z (full size)
+      cdim = converter.findContext(cellID)->volumePlacement().volume().boundingBox().dimensions();
+      for (auto& d : cdim) {
+        d *= 2;
+      }
+    }
+  } catch (const std::exception&) {
+    cdim.clear();
+  }
+  for (size_t i = 0; i < std::min<size_t>(cdim.size(), 3); ++i) {
+    rec.dimension[i] = cdim[i];
+  }
+  return rec;
+}
+
+uint64_t geometryHash(const dd4hep::Detector& detector, const std::vector<std::string>& compactFiles) {
+  Hash hash;
+  for (const auto& filename : compactFiles) {
+    hash.add(readFile(filename));
+  }
+  // the constants also cover the included files
+  for (const auto& [name, constant] : detector.constants()) {
+    hash.add(name);
+    hash.add(constant->GetTitle());
+  }
+  for (const auto& [name, readout] : detector.readouts()) {
+    hash.add(name);
+    dd4hep::Readout ro(readout);
+    hash.add(ro.idSpec().fieldDescription());
+    auto segmentation = ro.segmentation();
+    if (!segmentation.isValid()) {
+      continue;
+    }
+    hash.add(segmentation.type());
+    for (const auto* parameter : segmentation.segmentation()->parameters()) {
+      hash.add(parameter->name());
+      hash.add(parameter->value());
+    }
+  }
+  return hash.value();
+}
+
+uint64_t fileHash(const std::string& filename) {
+  if (!std::ifstream(filename)) {
+    return 0;
+  }
+  Hash hash;
+  hash.add(readFile(filename));
+  return hash.value();
+}
+
+} // namespace Jug::Base
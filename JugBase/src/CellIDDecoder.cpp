@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "JugBase/CellIDDecoder.h"
+
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+
+#include "DD4hep/Detector.h"
+#include "DD4hep/Readout.h"
+#include "DDSegmentation/BitFieldCoder.h"
+
+namespace Jug::Base {
+
+CellIDDecoder::CellIDDecoder(const dd4hep::DDSegmentation::BitFieldCoder& coder) {
+  m_fields.reserve(coder.size());
+  for (size_t i = 0; i < coder.size(); ++i) {
+    const auto& element = coder[i];
+    CellIDField field;
+    field.name     = element.name();
+    field.mask     = element.mask();
+    field.offset   = element.offset();
+    field.width    = element.width();
+    field.isSigned = element.isSigned();
+    field.lshift   = 64 - field.offset - field.width;
+    field.rshift   = 64 - field.width;
+    m_fields.push_back(std::move(field));
+  }
+}
+
+std::shared_ptr<const CellIDDecoder> CellIDDecoder::readout(const dd4hep::Detector& detector,
+                                                            const std::string& name) {
+  static std::mutex mutex;
+  static std::map<std::tuple<const dd4hep::Detector*, std::string>, std::shared_ptr<const CellIDDecoder>> decoders;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  const auto key = std::make_tuple(&detector, name);
+  auto it        = decoders.find(key);
+  if (it != decoders.end()) {
+    return it->second;
+  }
+  // throws for unknown readouts
+  const auto* coder = detector.readout(name).idSpec().decoder();
+  if (coder == nullptr) {
+    throw std::runtime_error("no ID decoder for readout " + name);
+  }
+  return decoders.emplace(key, std::make_shared<const CellIDDecoder>(*coder)).first->second;
+}
+
+size_t CellIDDecoder::index(const std::string& name) const {
+  for (size_t i = 0; i < m_fields.size(); ++i) {
+    if (m_fields[i].name == name) {
+      return i;
+    }
+  }
+  throw std::out_of_range("unknown cellID field " + name);
+}
+
+uint64_t CellIDDecoder::mask(const std::vector<std::string>& names) const {
+  uint64_t m = 0;
+  for (const auto& name : names) {
+    m |= field(name).mask;
+  }
+  return m;
+}
+
+uint64_t CellIDDecoder::encode(const std::vector<std::pair<std::string, int>>& values) const {
+  uint64_t id = 0;
+  for (const auto& [name, value] : values) {
+    id |= field(name).encode(value);
+  }
+  return id;
+}
+
+} // namespace Jug::Base
@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "JugBase/Acts/CoarseMaterialDecorator.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include "Acts/Material/BinnedSurfaceMaterial.hpp"
+#include "Acts/Material/HomogeneousSurfaceMaterial.hpp"
+#include "Acts/Material/Material.hpp"
+#include "Acts/Material/MaterialSlab.hpp"
+#include "Acts/Surfaces/Surface.hpp"
+#include "Acts/Utilities/BinUtility.hpp"
+
+namespace Jug::Base {
+
+namespace {
+  /// Average of material slabs side by side, the vacuum slabs included
+  class SlabAverage {
+  public:
+    void add(const Acts::MaterialSlab& slab) {
+      ++m_n;
+      const auto& material = slab.material();
+      if (!material || slab.thickness() <= 0) {
+        return;
+      }
+      const double t    = slab.thickness();
+      const double mass = material.massDensity() * t;
+      m_thickness += t;
+      m_tOverX0 += t / material.X0();
+      m_tOverL0 += t / material.L0();
+      m_mass += mass;
+      m_arMass += material.Ar() * mass;
+      m_zMass += material.Z() * mass;
+    }
+
+    Acts::MaterialSlab slab() const {
+      if (m_n == 0 || m_tOverX0 <= 0 || m_tOverL0 <= 0 || m_mass <= 0) {
+        return {};
+      }
+      const auto material = Acts::Material::fromMassDensity(m_thickness / m_tOverX0, m_thickness / m_tOverL0,
+                                                            m_arMass / m_mass, m_zMass / m_mass, m_mass / m_thickness);
+      return {material, static_cast<float>(m_thickness / m_n)};
+    }
+
+  private:
+    size_t m_n{0};
+    double m_thickness{0};
+    double m_tOverX0{0};
+    double m_tOverL0{0};
+    double m_mass{0};
+    double m_arMass{0};
+    double m_zMass{0};
+  };
+} // namespace
+
+void CoarseMaterialDecorator::decorate(Acts::Surface& surface) const {
+  m_decorator->decorate(surface);
+  const auto& material = surface.surfaceMaterialSharedPtr();
+  if (material != nullptr) {
+    surface.assignSurfaceMaterial(coarsen(material));
+  }
+}
+
+std::shared_ptr<const Acts::ISurfaceMaterial>
+CoarseMaterialDecorator::coarsen(const std::shared_ptr<const Acts::ISurfaceMaterial>& material) const {
+  const auto* binned = dynamic_cast<const Acts::BinnedSurfaceMaterial*>(material.get());
+  if (binned == nullptr) {
+    return material;
+  }
+  const auto& binUtility = binned->binUtility();
+  const auto& binning    = binUtility.binningData();
+  const auto& full       = binned->fullMaterial();
+  if (binning.empty() || full.empty() ||
+      std::any_of(binning.begin(), binning.end(), [](const auto& bd) { return bd.type != Acts::equidistant; })) {
+    return material;
+  }
+
+  // fine and coarse bins of the (at most two) dimensions, the material matrix is [bin1][bin0]
+  const size_t fine0   = full.front().size();
+  const size_t fine1   = full.size();
+  const size_t coarse0 = std::min(fine0, std::max<size_t>(m_bins[0], 1));
+  const size_t coarse1 = std::min(fine1, std::max<size_t>(m_bins[1], 1));
+  if (coarse0 == fine0 && coarse1 == fine1) {
+    return material;
+  }
+  std::vector<std::vector<SlabAverage>> averages(coarse1, std::vector<SlabAverage>(coarse0));
+  for (size_t i1 = 0; i1 < fine1; ++i1) {
+    for (size_t i0 = 0; i0 < fine0; ++i0) {
+      averages[i1 * coarse1 / fine1][i0 * coarse0 / fine0].add(full[i1][i0]);
+    }
+  }
+
+  if (coarse0 == 1 && coarse1 == 1) {
+    return std::make_shared<const Acts::HomogeneousSurfaceMaterial>(averages[0][0].slab(), binned->splitFactor(),
+                                                                    binned->mappingType());
+  }
+  Acts::MaterialSlabMatrix coarse(coarse1, Acts::MaterialSlabVector(coarse0));
+  for (size_t i1 = 0; i1 < coarse1; ++i1) {
+    for (size_t i0 = 0; i0 < coarse0; ++i0) {
+      coarse[i1][i0] = averages[i1][i0].slab();
+    }
+  }
+  Acts::BinUtility coarseBinUtility(binUtility.transform());
+  for (size_t dim = 0; dim < binning.size(); ++dim) {
+    const auto& bd = binning[dim];
+    coarseBinUtility += Acts::BinUtility(dim == 0 ? coarse0 : coarse1, bd.min, bd.max, bd.option, bd.binvalue);
+  }
+  return std::make_shared<const Acts::BinnedSurfaceMaterial>(coarseBinUtility, std::move(coarse),
+                                                             binned->splitFactor(), binned->mappingType());
+}
+
+} // namespace Jug::Base
@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "JugBase/CollectionBytes.h"
+
+#include <algorithm>
+
+#include "podio/ObjectID.h"
+
+#include "TClass.h"
+#include "TVirtualCollectionProxy.h"
+
+namespace Jug::Base {
+
+CollectionBytes::CollectionBytes(UnknownType unknown) : m_unknown(std::move(unknown)) {}
+
+CollectionBytes::~CollectionBytes() = default;
+
+TVirtualCollectionProxy* CollectionBytes::proxy(const std::string& elementType) {
+  auto it = m_proxies.find(elementType);
+  if (it == m_proxies.end()) {
+    // a proxy of our own, the one of the class is shared with the other instances
+    TClass* cls = TClass::GetClass(("vector<" + elementType + ">").c_str());
+    std::unique_ptr<TVirtualCollectionProxy> proxy;
+    if (cls != nullptr && cls->GetCollectionProxy() != nullptr) {
+      proxy.reset(cls->GetCollectionProxy()->Generate());
+    } else if (m_unknown) {
+      m_unknown(elementType);
+    }
+    it = m_proxies.emplace(elementType, std::move(proxy)).first;
+  }
+  return it->second.get();
+}
+
+size_t CollectionBytes::operator()(podio::CollectionBase* coll) {
+  auto buffers = coll->getBuffers();
+  size_t bytes = 0;
+  if (auto* dataProxy = proxy(coll->getValueTypeName() + "Data"); dataProxy != nullptr) {
+    size_t size = 0;
+    if (buffers.data != nullptr) {
+      TVirtualCollectionProxy::TPushPop helper(dataProxy, *static_cast<void**>(buffers.data));
+      size = dataProxy->Size();
+    }
+    // the data buffer is only filled from the objects by prepareForWrite
+    bytes += std::max(size, coll->size()) * dataProxy->GetIncrement();
+  }
+  if (buffers.references != nullptr) {
+    for (const auto& ref : *buffers.references) {
+      bytes += ref->size() * sizeof(podio::ObjectID);
+    }
+  }
+  if (buffers.vectorMembers != nullptr) {
+    for (const auto& [elementType, address] : *buffers.vectorMembers) {
+      if (auto* vectorProxy = proxy(elementType); vectorProxy != nullptr) {
+        TVirtualCollectionProxy::TPushPop helper(vectorProxy, *static_cast<void**>(address));
+        bytes += vectorProxy->Size() * vectorProxy->GetIncrement();
+      }
+    }
+  }
+  return bytes;
+}
+
+} // namespace Jug::Base
@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "JugBase/ConfigSnapshot.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <tuple>
+
+#include "Gaudi/Interfaces/IOptionsSvc.h"
+#include "GaudiKernel/IProperty.h"
+#include "GaudiKernel/ISvcLocator.h"
+#include "GaudiKernel/SmartIF.h"
+
+namespace Jug::Base {
+
+namespace {
+  // the options of the job options are those of the job that wrote the snapshot
+  bool isJobOptionsOption(const std::string& name) { return name.rfind("ApplicationMgr.JobOptions", 0) == 0; }
+
+  bool isNumber(const std::string& value) {
+    if (value.empty()) {
+      return false;
+    }
+    char* end = nullptr;
+    std::strtod(value.c_str(), &end);
+    return end == value.c_str() + value.size();
+  }
+} // namespace
+
+ConfigSnapshot configSnapshot(ISvcLocator& svcLocator) {
+  ConfigSnapshot snapshot;
+  for (const auto& [name, value] : svcLocator.getOptsSvc().items()) {
+    if (!isJobOptionsOption(name)) {
+      snapshot[name] = optionsValue(value);
+    }
+  }
+  // some default components are not captured by the job options service
+  for (const auto* component : {"ApplicationMgr", "MessageSvc", "NTupleSvc"}) {
+    SmartIF<IProperty> props(svcLocator.service(component, false));
+    if (!props) {
+      continue;
+    }
+    for (const auto* property : props->getProperties()) {
+      const std::string name = std::string(component) + "." + property->name();
+      if (!isJobOptionsOption(name)) {
+        snapshot.emplace(name, optionsValue(property->toString()));
+      }
+    }
+  }
+  return snapshot;
+}
+
+std::string optionsValue(const std::string& value) {
+  if (value == "True" || value == "False" || value == "true" || value == "false" || isNumber(value)) {
+    return value;
+  }
+  // quoted strings, lists and dictionaries (the property representations)
+  if (value.size() >= 2) {
+    const char first = value.front();
+    const char last  = value.back();
+    if (((first == '"' || first == '\'') && last == first) || (first == '[' && last == ']') ||
+        (first == '{' && last == '}') || (first == '(' && last == ')')) {
+      return value;
+    }
+  }
+  std::string quoted = "\"";
+  for (const char c : value) {
+    if (c == '"' || c == '\\') {
+      quoted += '\\';
+    }
+    quoted += c;
+  }
+  return quoted + "\"";
+}
+
+bool writeConfigSnapshot(const std::string& filename, const ConfigSnapshot& snapshot) {
+  std::ofstream os(filename);
+  os << "// Resolved configuration snapshot, run with: Gaudi.exe " << filename << "\n";
+  for (const auto& [name, value] : snapshot) {
+    os << name << " = " << value << ";\n";
+  }
+  return static_cast<bool>(os);
+}
+
+} // namespace Jug::Base
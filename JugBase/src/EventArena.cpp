@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "JugBase/EventArena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+EventArena::~EventArena() { reset(); }
+
+void* EventArena::allocate(std::size_t size, std::size_t alignment) {
+  while (m_block < m_blocks.size()) {
+    auto& block        = m_blocks[m_block];
+    const auto base    = reinterpret_cast<std::uintptr_t>(block.data.get());
+    const auto aligned = (base + m_offset + alignment - 1) & ~(alignment - 1);
+    if (aligned + size <= base + block.size) {
+      m_offset = aligned - base + size;
+      return reinterpret_cast<void*>(aligned);
+    }
+    // try the next block
+    ++m_block;
+    m_offset = 0;
+  }
+  // no block left with enough space, oversized requests get a block of their own
+  const std::size_t blockSize = std::max(m_blockSize, size + alignment);
+  m_blocks.push_back({std::make_unique<std::byte[]>(blockSize), blockSize});
+  m_block  = m_blocks.size() - 1;
+  m_offset = 0;
+  return allocate(size, alignment);
+}
+
+void EventArena::reset() {
+  for (auto it = m_destructors.rbegin(); it != m_destructors.rend(); ++it) {
+    it->second(it->first);
+  }
+  m_destructors.clear();
+  m_block  = 0;
+  m_offset = 0;
+}
+
+std::size_t EventArena::capacity() const {
+  std::size_t total = 0;
+  for (const auto& block : m_blocks) {
+    total += block.size;
+  }
+  return total;
+}
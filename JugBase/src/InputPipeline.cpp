@@ -0,0 +1,254 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "JugBase/InputPipeline.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <unordered_map>
+
+#include "podio/EventStore.h"
+#include "podio/ROOTReader.h"
+
+#include "TChain.h"
+#include "TROOT.h"
+
+namespace Jug::Base {
+
+size_t cacheCollectionBranches(TTree& tree, const std::vector<std::string>& collectionNames) {
+  // the branch of a collection, its relations (name#N) and vector members (name_N)
+  auto isCollectionBranch = [](const std::string& branch, const std::string& name) {
+    if (branch.compare(0, name.size(), name) != 0) {
+      return false;
+    }
+    if (branch.size() == name.size()) {
+      return true;
+    }
+    const char sep = branch[name.size()];
+    if ((sep != '#' && sep != '_') || branch.size() == name.size() + 1) {
+      return false;
+    }
+    for (size_t i = name.size() + 1; i < branch.size(); ++i) {
+      if (std::isdigit(static_cast<unsigned char>(branch[i])) == 0) {
+        return false;
+      }
+    }
+    return true;
+  };
+  size_t nBranches = 0;
+  for (const auto* obj : *tree.GetListOfBranches()) {
+    const std::string branch = obj->GetName();
+    for (const auto& name : collectionNames) {
+      if (isCollectionBranch(branch, name)) {
+        tree.AddBranchToCache(branch.c_str(), true);
+        ++nBranches;
+        break;
+      }
+    }
+  }
+  // the cached branches are known, no need to learn them
+  tree.StopCacheLearningPhase();
+  return nBranches;
+}
+
+/// Reader and event store of the events read ahead, on the same files as the input
+struct InputPipeline::Buffer {
+  podio::ROOTReader reader;
+  podio::EventStore store;
+  /// Chain of the reader (nullptr if not found) and its entry, for the packed cellIDs
+  TChain* chain{nullptr};
+  long long entry{0};
+  PackedCellIDReader packedCellIDs;
+  /// Collections read ahead and not taken yet, by collection ID
+  std::unordered_map<int, podio::CollectionBase*> collections;
+  size_t bytes{0};
+};
+
+InputPipeline::~InputPipeline() { stop(); }
+
+bool InputPipeline::start(const Settings& settings, std::string& error) {
+  m_settings = settings;
+  // the background thread reads while the algorithms use ROOT
+  ROOT::EnableThreadSafety();
+  for (unsigned i = 0; i <= settings.depth; ++i) {
+    auto buffer = std::make_unique<Buffer>();
+    buffer->reader.openFiles(settings.filenames);
+    buffer->store.setReader(&buffer->reader);
+    auto* idTable = buffer->reader.getCollectionIDTable();
+    if (idTable == nullptr) {
+      error = "cannot read the collection IDs of the input";
+      return false;
+    }
+    // podio::ROOTReader does not expose its chain, the last one registered in the list of data sets
+    auto* chain = dynamic_cast<TChain*>(gROOT->GetListOfDataSets()->Last());
+    if (chain != nullptr && std::string(chain->GetName()) == "events") {
+      buffer->chain = chain;
+      if (settings.readCacheSize >= 0) {
+        chain->SetCacheSize(settings.readCacheSize);
+      }
+      if (chain->GetCacheSize() > 0) {
+        chain->LoadTree(settings.range.first);
+        cacheCollectionBranches(*chain, settings.collections);
+      }
+    }
+    if (i == 0) {
+      for (const auto& name : settings.collections) {
+        if (idTable->present(name)) {
+          m_collectionIDs.push_back(idTable->collectionID(name));
+          m_collectionNames.push_back(name);
+        }
+      }
+    }
+    m_free.push_back(buffer.get());
+    m_buffers.push_back(std::move(buffer));
+  }
+  m_stop = false;
+  m_thread = std::thread(&InputPipeline::readLoop, this);
+  return true;
+}
+
+void InputPipeline::stop() {
+  if (m_thread.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_cond.notify_all();
+    m_thread.join();
+  }
+  for (auto& buffer : m_buffers) {
+    release(*buffer);
+    buffer->reader.closeFiles();
+  }
+  m_buffers.clear();
+  m_free.clear();
+  m_ready.clear();
+  m_current = nullptr;
+}
+
+void InputPipeline::readLoop() {
+  const auto& range = m_settings.range;
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true) {
+    m_cond.wait(lock, [&] {
+      const bool withinBytes = (m_settings.maxBytes == 0 || m_ready.empty() || m_readyBytes < m_settings.maxBytes);
+      return m_stop || m_read >= range.size() || (!m_free.empty() && withinBytes);
+    });
+    if (m_stop || m_read >= range.size()) {
+      return;
+    }
+    Buffer* buffer = m_free.front();
+    m_free.pop_front();
+    const long long entry = range.entry(m_read);
+    ++m_read;
+    lock.unlock();
+
+    // the cleanup of the processed event is also done on this thread
+    release(*buffer);
+    read(*buffer, entry);
+
+    lock.lock();
+    m_ready.push_back(buffer);
+    m_readyBytes += buffer->bytes;
+    m_peakBytes = std::max(m_peakBytes, m_readyBytes);
+    m_cond.notify_all();
+  }
+}
+
+bool InputPipeline::unpack(Buffer& buffer, const std::string& name, podio::CollectionBase& collection) {
+  // subset collections are not unpacked, as in PodioDataSvc::readCollection
+  if (collection.isSubsetCollection()) {
+    return true;
+  }
+  if (buffer.chain != nullptr && !buffer.packedCellIDs.unpack(*buffer.chain, buffer.entry, name, collection)) {
+    return false;
+  }
+  collection.prepareAfterRead();
+  return true;
+}
+
+void InputPipeline::read(Buffer& buffer, long long entry) {
+  buffer.reader.goToEvent(entry);
+  buffer.entry = entry;
+  for (size_t i = 0; i < m_collectionIDs.size(); ++i) {
+    const int id                      = m_collectionIDs[i];
+    podio::CollectionBase* collection = nullptr;
+    if (!buffer.store.get(id, collection) || collection == nullptr) {
+      continue;
+    }
+    // not taken from the buffer, and not found when it is taken
+    if (!unpack(buffer, m_collectionNames[i], *collection)) {
+      continue;
+    }
+    buffer.collections.emplace(id, collection);
+    buffer.bytes += m_collectionBytes(collection);
+  }
+}
+
+void InputPipeline::release(Buffer& buffer) {
+  for (auto& [id, collection] : buffer.collections) {
+    delete collection;
+  }
+  buffer.collections.clear();
+  buffer.bytes = 0;
+  buffer.store.clearCaches();
+}
+
+InputPipeline::Buffer* InputPipeline::current() {
+  if (m_current != nullptr) {
+    return m_current;
+  }
+  std::unique_lock<std::mutex> lock(m_mutex);
+  if (m_consumed >= m_settings.range.size() || !m_thread.joinable()) {
+    return nullptr;
+  }
+  if (m_ready.empty()) {
+    const auto waitStart = std::chrono::steady_clock::now();
+    m_cond.wait(lock, [this] { return m_stop || !m_ready.empty(); });
+    m_waitSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - waitStart).count();
+  }
+  if (m_ready.empty()) {
+    return nullptr;
+  }
+  m_current = m_ready.front();
+  m_ready.pop_front();
+  m_readyBytes -= m_current->bytes;
+  // below the byte limit again
+  m_cond.notify_all();
+  return m_current;
+}
+
+podio::CollectionBase* InputPipeline::take(int collectionID) {
+  Buffer* buffer = current();
+  if (buffer == nullptr) {
+    return nullptr;
+  }
+  auto it = buffer->collections.find(collectionID);
+  if (it != buffer->collections.end()) {
+    podio::CollectionBase* collection = it->second;
+    buffer->collections.erase(it);
+    return collection;
+  }
+  // not read ahead, the reader of the buffer is still on the entry of the event
+  podio::CollectionBase* collection = nullptr;
+  if (!buffer->store.get(collectionID, collection) || collection == nullptr) {
+    return nullptr;
+  }
+  const auto name = buffer->reader.getCollectionIDTable()->name(collectionID);
+  return unpack(*buffer, name, *collection) ? collection : nullptr;
+}
+
+void InputPipeline::next() {
+  Buffer* buffer = current();
+  if (buffer == nullptr) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_current = nullptr;
+  m_free.push_back(buffer);
+  ++m_consumed;
+  m_cond.notify_all();
+}
+
+} // namespace Jug::Base
@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "JugBase/Instrumentation.h"
+
+#include <dlfcn.h>
+
+namespace {
+thread_local Jug::Base::ExecuteRecord* s_record = nullptr;
+
+/// Counters of libJugAllocCounter.so, all null if it is not preloaded
+struct AllocCounterLib {
+  void (*enable)(bool) = nullptr;
+  bool (*enabled)()    = nullptr;
+  uint64_t (*bytes)()  = nullptr;
+  uint64_t (*count)()  = nullptr;
+
+  AllocCounterLib() {
+    enable  = reinterpret_cast<void (*)(bool)>(dlsym(RTLD_DEFAULT, "jug_alloc_counter_enable"));
+    enabled = reinterpret_cast<bool (*)()>(dlsym(RTLD_DEFAULT, "jug_alloc_counter_enabled"));
+    bytes   = reinterpret_cast<uint64_t (*)()>(dlsym(RTLD_DEFAULT, "jug_alloc_counter_bytes"));
+    count   = reinterpret_cast<uint64_t (*)()>(dlsym(RTLD_DEFAULT, "jug_alloc_counter_count"));
+    if (enable == nullptr || enabled == nullptr || bytes == nullptr || count == nullptr) {
+      enable  = nullptr;
+      enabled = nullptr;
+      bytes   = nullptr;
+      count   = nullptr;
+    }
+  }
+};
+
+const AllocCounterLib& allocCounterLib() {
+  static const AllocCounterLib lib;
+  return lib;
+}
+} // namespace
+
+namespace Jug::Base {
+
+ExecuteRecord*& currentExecuteRecord() { return s_record; }
+
+bool AllocationCounter::available() { return allocCounterLib().enable != nullptr; }
+void AllocationCounter::enable(bool on) {
+  if (available()) {
+    allocCounterLib().enable(on);
+  }
+}
+bool AllocationCounter::enabled() { return available() && allocCounterLib().enabled(); }
+uint64_t AllocationCounter::bytes() { return available() ? allocCounterLib().bytes() : 0; }
+uint64_t AllocationCounter::count() { return available() ? allocCounterLib().count() : 0; }
+
+} // namespace Jug::Base
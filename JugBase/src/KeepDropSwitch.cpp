@@ -51,19 +51,8 @@ std::vector<std::string> split(const std::string& s, char delim) {
   return elems;
 }
 
-bool KeepDropSwitch::isOn(const std::string& astring) const {
-  auto im = m_cache.find(astring);
-  if (im != m_cache.end()) {
-    return im->second;
-  } else {
-    bool val = getFlag(astring);
-    m_cache.insert(std::pair<std::string, bool>(astring, val));
-    return val;
-  }
-}
-
-bool KeepDropSwitch::getFlag(const std::string& astring) const {
-  bool flag = true;
+KeepDropSwitch::KeepDropSwitch(const CommandLines& cmds) : m_commandlines(cmds) {
+  m_rules.reserve(cmds.size());
   for (const auto& cmdline : m_commandlines) {
     std::vector<std::string> words = split(cmdline, ' ');
     if (words.size() != 2) {
@@ -85,16 +74,47 @@ bool KeepDropSwitch::getFlag(const std::string& astring) const {
       msg << "should be keep or drop, lower case" << std::endl;
       throw std::invalid_argument(msg.str());
     }
-    bool match = wildcmp(pattern.c_str(), astring.c_str());
-    if (not match) {
-      continue;
-    } else if (theCmd == KEEP) {
-      flag = true;
-    } else {
-      flag = false;
+    Rule rule{theCmd, Rule::GLOB, pattern};
+    const auto wildcard = pattern.find_first_of("*?");
+    if (wildcard == std::string::npos) {
+      rule.kind = Rule::LITERAL;
+    } else if (wildcard == pattern.size() - 1 && pattern.back() == '*') {
+      rule.kind = Rule::PREFIX;
+      rule.pattern.pop_back();
+    }
+    m_rules.push_back(std::move(rule));
+  }
+}
+
+bool KeepDropSwitch::Rule::matches(const std::string& astring) const {
+  switch (kind) {
+  case LITERAL:
+    return astring == pattern;
+  case PREFIX:
+    return astring.compare(0, pattern.size(), pattern) == 0;
+  default:
+    return wildcmp(pattern.c_str(), astring.c_str()) != 0;
+  }
+}
+
+bool KeepDropSwitch::isOn(const std::string& astring) const {
+  auto im = m_cache.find(astring);
+  if (im != m_cache.end()) {
+    return im->second;
+  }
+  bool val = getFlag(astring);
+  m_cache.emplace(astring, val);
+  return val;
+}
+
+bool KeepDropSwitch::getFlag(const std::string& astring) const {
+  // the last matching command decides, everything is kept by default
+  for (auto it = m_rules.rbegin(); it != m_rules.rend(); ++it) {
+    if (it->matches(astring)) {
+      return it->cmd == KEEP;
     }
   }
-  return flag;
+  return true;
 }
 
 KeepDropSwitch::Cmd KeepDropSwitch::extractCommand(const std::string cmdline) const {
@@ -0,0 +1,145 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "JugBase/OutputMerger.h"
+
+#include <map>
+#include <memory>
+#include <tuple>
+
+#include "podio/CollectionIDTable.h"
+#include "podio/GenericParameters.h"
+
+#include "TFile.h"
+#include "TTree.h"
+
+namespace Jug::Base {
+
+namespace {
+
+  using CollectionTypeInfo = std::vector<std::tuple<int, std::string, bool>>;
+  using MetaDataMap        = std::map<int, podio::GenericParameters>;
+
+  /// Collection IDs and types of the metadata tree of a file, false if not found
+  bool collectionInfo(TFile& file, std::vector<std::string>& names, std::vector<int>& ids,
+                      CollectionTypeInfo& types) {
+    auto* tree = file.Get<TTree>("metadata");
+    if (tree == nullptr || tree->GetEntries() < 1) {
+      return false;
+    }
+    podio::CollectionIDTable* table = nullptr;
+    CollectionTypeInfo* info        = nullptr;
+    if (tree->SetBranchAddress("CollectionIDs", &table) < 0 ||
+        tree->SetBranchAddress("CollectionTypeInfo", &info) < 0) {
+      return false;
+    }
+    tree->GetEntry(0);
+    names = table->names();
+    ids   = table->ids();
+    types = *info;
+    tree->ResetBranchAddresses();
+    delete table;
+    delete info;
+    return true;
+  }
+
+  /// Copy all the entries of the tree of the input to the output tree (created from the first input)
+  bool fastCopy(TFile& input, TFile& output, const char* name, TTree*& merged, std::string& error) {
+    auto* tree = input.Get<TTree>(name);
+    if (tree == nullptr) {
+      error = std::string("no ") + name + " tree in " + input.GetName();
+      return false;
+    }
+    output.cd();
+    if (merged == nullptr) {
+      merged = tree->CloneTree(-1, "fast");
+    } else if (merged->CopyEntries(tree, -1, "fast") < 0) {
+      // the baskets are copied without recompression
+      merged = nullptr;
+    }
+    if (merged == nullptr) {
+      error = std::string("cannot copy the ") + name + " tree of " + input.GetName();
+      return false;
+    }
+    return true;
+  }
+
+} // namespace
+
+bool mergeOutputs(const std::string& output, const std::vector<std::string>& inputs, long long& nEvents,
+                  std::string& error) {
+  std::unique_ptr<TFile> out;
+  TTree* events   = nullptr;
+  TTree* eventsMD = nullptr;
+  std::vector<std::string> names;
+  std::vector<int> ids;
+  CollectionTypeInfo types;
+  MetaDataMap runMD;
+  nEvents = 0;
+  for (const auto& input : inputs) {
+    std::unique_ptr<TFile> in(TFile::Open(input.c_str(), "READ"));
+    if (!in || in->IsZombie()) {
+      error = "cannot open " + input;
+      return false;
+    }
+    std::vector<std::string> inNames;
+    std::vector<int> inIds;
+    CollectionTypeInfo inTypes;
+    if (!collectionInfo(*in, inNames, inIds, inTypes)) {
+      error = "no podio metadata in " + input;
+      return false;
+    }
+    if (!out) {
+      names = inNames;
+      ids   = inIds;
+      types = inTypes;
+      out.reset(TFile::Open(output.c_str(), "RECREATE", "data file", in->GetCompressionSettings()));
+      if (!out || out->IsZombie()) {
+        error = "cannot create " + output;
+        return false;
+      }
+      // the metadata and collection metadata of the first input describe the merged file
+      for (const char* name : {"metadata", "col_metadata"}) {
+        TTree* tree = nullptr;
+        if (!fastCopy(*in, *out, name, tree, error)) {
+          return false;
+        }
+      }
+    } else if (inNames != names || inIds != ids || inTypes != types) {
+      error = input + " has other collections or collection IDs than " + inputs.front() +
+              ", the outputs of different configurations cannot be merged";
+      return false;
+    }
+
+    if (!fastCopy(*in, *out, "events", events, error) || !fastCopy(*in, *out, "evt_metadata", eventsMD, error)) {
+      return false;
+    }
+    nEvents += in->Get<TTree>("events")->GetEntries();
+
+    // run metadata of all the inputs, the first one of a run is kept
+    if (auto* tree = in->Get<TTree>("run_metadata"); tree != nullptr && tree->GetEntries() > 0) {
+      MetaDataMap* inRunMD = nullptr;
+      if (tree->SetBranchAddress("runMD", &inRunMD) >= 0) {
+        tree->GetEntry(0);
+        runMD.insert(inRunMD->begin(), inRunMD->end());
+        tree->ResetBranchAddresses();
+      }
+      delete inRunMD;
+    }
+  }
+  if (!out) {
+    error = "no inputs to merge";
+    return false;
+  }
+
+  out->cd();
+  auto* runMDTree = new TTree("run_metadata", "Run metadata tree");
+  auto* runMDPtr  = &runMD;
+  runMDTree->Branch("runMD", "std::map<int,podio::GenericParameters>", &runMDPtr);
+  runMDTree->Fill();
+  out->Write();
+  out->Close();
+  return true;
+}
+
+} // namespace Jug::Base
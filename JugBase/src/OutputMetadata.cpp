@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "JugBase/OutputMetadata.h"
+
+#include <sstream>
+#include <tuple>
+
+#include "Gaudi/Interfaces/IOptionsSvc.h"
+#include "GaudiKernel/IProperty.h"
+#include "GaudiKernel/ISvcLocator.h"
+#include "JugBase/PodioDataSvc.h"
+#include "TTree.h"
+
+namespace Jug::Base {
+
+std::vector<std::string> outputConfigOptions(ISvcLocator& svcLocator) {
+  std::vector<std::string> config_data;
+  for (const auto& per_property : svcLocator.getOptsSvc().items()) {
+    std::stringstream config_stream;
+    // sample output:
+    // HepMCToEDMConverter.genparticles = "GenParticles";
+    config_stream << std::get<0>(per_property) << " = \"" << std::get<1>(per_property) << "\";" << std::endl;
+    config_data.push_back(config_stream.str());
+  }
+  // Some default components are not captured by the job option service
+  // and have to be traversed like this. Note that Gaudi!577 will improve this.
+  for (const auto* name : {"ApplicationMgr", "MessageSvc", "NTupleSvc"}) {
+    std::stringstream config_stream;
+    auto svc = svcLocator.service<IProperty>(name);
+    if (!svc.isValid()) {
+      continue;
+    }
+    for (const auto* property : svc->getProperties()) {
+      config_stream << name << "." << property->name() << " = \"" << property->toString() << "\";" << std::endl;
+    }
+    config_data.push_back(config_stream.str());
+  }
+  return config_data;
+}
+
+void fillOutputMetadata(ISvcLocator& svcLocator, PodioDataSvc& podioDataSvc, TTree& metadata, TTree& colMD,
+                        TTree& runMD) {
+  auto config_data = outputConfigOptions(svcLocator);
+  metadata.Branch("gaudiConfigOptions", &config_data);
+  metadata.Branch("CollectionIDs", podioDataSvc.getCollectionIDs());
+  metadata.Fill();
+  colMD.Branch("colMD", "std::map<int,podio::GenericParameters>", podioDataSvc.getProvider().getColMetaDataMap());
+  colMD.Fill();
+  runMD.Branch("runMD", "std::map<int,podio::GenericParameters>", podioDataSvc.getProvider().getRunMetaDataMap());
+  runMD.Fill();
+}
+
+} // namespace Jug::Base
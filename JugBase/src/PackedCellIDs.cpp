@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "JugBase/PackedCellIDs.h"
+
+#include "TBranch.h"
+#include "TChain.h"
+#include "TClass.h"
+#include "TDataMember.h"
+#include "TList.h"
+#include "TVirtualCollectionProxy.h"
+
+namespace Jug::Base {
+
+CellIDLayout::CellIDLayout(const std::string& dataType) {
+  TClass* cls    = TClass::GetClass(dataType.c_str());
+  TClass* vecCls = TClass::GetClass(("vector<" + dataType + ">").c_str());
+  if (cls == nullptr || vecCls == nullptr || vecCls->GetCollectionProxy() == nullptr) {
+    return;
+  }
+  auto* member = cls->GetDataMember("cellID");
+  if (member == nullptr || !member->IsBasic() || member->IsaPointer() || member->GetArrayDim() != 0 ||
+      member->GetUnitSize() != sizeof(uint64_t)) {
+    return;
+  }
+  m_offset = member->GetOffset();
+  for (auto* obj : *cls->GetListOfDataMembers()) {
+    const std::string name = obj->GetName();
+    if (name.size() > 6 && name.compare(name.size() - 6, 6, "_begin") == 0) {
+      ++m_ranges;
+    }
+  }
+  m_proxy.reset(vecCls->GetCollectionProxy()->Generate());
+}
+
+CellIDLayout::~CellIDLayout() = default;
+
+char* CellIDLayout::elements(void* dataBuffer, size_t& n, size_t& stride) const {
+  // the data buffer of the collection buffers is the address of the vector
+  TVirtualCollectionProxy::TPushPop helper(m_proxy.get(), *static_cast<void**>(dataBuffer));
+  n      = m_proxy->Size();
+  stride = m_proxy->GetIncrement();
+  // the elements of the vector are contiguous
+  return (n > 0) ? static_cast<char*>(m_proxy->At(0)) : nullptr;
+}
+
+PackedCellIDReader::PackedCellIDReader()  = default;
+PackedCellIDReader::~PackedCellIDReader() = default;
+
+bool PackedCellIDReader::unpack(TChain& chain, long long entry, const std::string& collName,
+                                podio::CollectionBase& collection) {
+  const long long local = chain.LoadTree(entry);
+  if (local < 0 || chain.GetTree() == nullptr) {
+    return true;
+  }
+  // the branch of the collection in the current file, nullptr if its cellIDs are not packed
+  auto& cached = m_branches[collName];
+  if (cached.treeNumber != chain.GetTreeNumber()) {
+    cached.treeNumber = chain.GetTreeNumber();
+    cached.branch     = chain.GetTree()->GetBranch(PackedCellIDs::branchName(collName).c_str());
+  }
+  if (cached.branch == nullptr) {
+    return true;
+  }
+  cached.branch->SetAddress(&m_blobAddress);
+  if (cached.branch->GetEntry(local) < 0) {
+    return false;
+  }
+
+  auto buffers = collection.getBuffers();
+  if (buffers.data == nullptr) {
+    return false;
+  }
+  auto& layout = m_layouts[collection.getValueTypeName()];
+  if (!layout) {
+    layout = std::make_unique<CellIDLayout>(collection.getValueTypeName() + "Data");
+  }
+  if (!layout->valid()) {
+    return false;
+  }
+  size_t n      = 0;
+  size_t stride = 0;
+  char* first   = layout->elements(buffers.data, n, stride);
+  return PackedCellIDs::unpack(m_blob, first, n, stride, layout->offset());
+}
+
+} // namespace Jug::Base
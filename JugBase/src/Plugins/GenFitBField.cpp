@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "JugBase/BField/GenFitBField.h"
+
+#include "Acts/Definitions/Units.hpp"
+#include "Acts/MagneticField/MagneticFieldContext.hpp"
+
+namespace Jug::BField {
+
+  GenFitBField::GenFitBField(std::shared_ptr<const Acts::MagneticFieldProvider> field)
+      : m_field(std::move(field)), m_cache(m_field->makeCache(Acts::MagneticFieldContext{}))
+  {
+  }
+
+  TVector3 GenFitBField::get(const TVector3& position) const
+  {
+    double field[3];
+    get(position.X(), position.Y(), position.Z(), field[0], field[1], field[2]);
+    return {field[0], field[1], field[2]};
+  }
+
+  void GenFitBField::get(const double& posX, const double& posY, const double& posZ, double& Bx, double& By,
+                         double& Bz) const
+  {
+    using Acts::UnitConstants::cm;
+    const auto b = m_field->getField({posX * cm, posY * cm, posZ * cm}, m_cache);
+    if (!b.ok()) {
+      Bx = By = Bz = 0.;
+      return;
+    }
+    // 1 T = 10 kGauss
+    const auto field = b.value() * (10. / Acts::UnitConstants::T);
+    Bx               = field.x();
+    By               = field.y();
+    Bz               = field.z();
+  }
+
+} // namespace Jug::BField
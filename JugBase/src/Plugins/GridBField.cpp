@@ -0,0 +1,219 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "JugBase/BField/GridBField.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+namespace Jug::BField {
+
+  GridBField::GridBField(std::shared_ptr<const Acts::MagneticFieldProvider> source, const Config& cfg)
+      : m_source(std::move(source)), m_cfg(cfg)
+  {
+    if (!m_source || cfg.xyMax <= 0. || cfg.zMax <= cfg.zMin || cfg.xyStep <= 0. || cfg.zStep <= 0.) {
+      throw std::invalid_argument("GridBField: invalid source field or grid configuration");
+    }
+    const bool rz = (cfg.symmetry == Symmetry::RZ);
+    // the spacing is adjusted so that the grid ends on the extent
+    const double xyRange = rz ? cfg.xyMax : 2. * cfg.xyMax;
+    const auto nxy       = static_cast<std::ptrdiff_t>(std::ceil(xyRange / cfg.xyStep)) + 1;
+    const auto nz        = static_cast<std::ptrdiff_t>(std::ceil((cfg.zMax - cfg.zMin) / cfg.zStep)) + 1;
+    m_n                  = {nxy, rz ? 1 : nxy, nz};
+    m_min                = {rz ? 0. : -cfg.xyMax, rz ? 0. : -cfg.xyMax, cfg.zMin};
+    m_step               = {xyRange / (nxy - 1), rz ? 0. : xyRange / (nxy - 1), (cfg.zMax - cfg.zMin) / (nz - 1)};
+
+    auto cache = m_source->makeCache(Acts::MagneticFieldContext{});
+    m_values.resize(3 * m_n[0] * m_n[1] * m_n[2]);
+    auto out = m_values.begin();
+    for (std::ptrdiff_t i = 0; i < m_n[0]; ++i) {
+      for (std::ptrdiff_t j = 0; j < m_n[1]; ++j) {
+        for (std::ptrdiff_t k = 0; k < m_n[2]; ++k) {
+          // for RZ the field at phi = 0, where (Bx, By) = (Br, Bphi)
+          const Acts::Vector3 pos(m_min[0] + i * m_step[0], m_min[1] + j * m_step[1], m_min[2] + k * m_step[2]);
+          auto b = m_source->getField(pos, cache);
+          if (!b.ok()) {
+            throw std::runtime_error("GridBField: source field not available in the grid");
+          }
+          const auto& v = b.value();
+          m_maxField    = std::max(m_maxField, v.norm());
+          out           = std::copy(v.data(), v.data() + 3, out);
+        }
+      }
+    }
+  }
+
+  Acts::Vector3 GridBField::value(std::ptrdiff_t i, std::ptrdiff_t j, std::ptrdiff_t k) const
+  {
+    const auto* v = &m_values[3 * ((i * m_n[1] + j) * m_n[2] + k)];
+    return {v[0], v[1], v[2]};
+  }
+
+  GridBField::Cache& GridBField::gridCache(Acts::MagneticFieldProvider::Cache& cache) const
+  {
+    return cache.get<Cache>();
+  }
+
+  bool GridBField::toGrid(const Acts::Vector3& position, std::array<double, 3>& u) const
+  {
+    if (m_cfg.symmetry == Symmetry::RZ) {
+      u = {std::hypot(position.x(), position.y()) / m_step[0], 0., (position.z() - m_min[2]) / m_step[2]};
+    } else {
+      for (size_t a = 0; a < 3; ++a) {
+        u[a] = (position[a] - m_min[a]) / m_step[a];
+      }
+    }
+    for (size_t a = 0; a < 3; ++a) {
+      if (!(u[a] >= 0. && u[a] <= m_n[a] - 1)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  Acts::Vector3 GridBField::interpolate(const std::array<double, 3>& u, Cache& cache,
+                                        Acts::ActsMatrix<3, 3>* gradient) const
+  {
+    std::array<std::ptrdiff_t, 3> index{0, 0, 0};
+    std::array<double, 3> t{0., 0., 0.};
+    for (size_t a = 0; a < 3; ++a) {
+      if (m_n[a] > 1) {
+        index[a] = std::min<std::ptrdiff_t>(static_cast<std::ptrdiff_t>(u[a]), m_n[a] - 2);
+        t[a]     = u[a] - index[a];
+      }
+    }
+    // a flat axis (y for RZ) only has the corners with its bit 0
+    const unsigned flat = (m_n[0] > 1 ? 0U : 1U) | (m_n[1] > 1 ? 0U : 2U) | (m_n[2] > 1 ? 0U : 4U);
+    if (index != cache.index) {
+      for (unsigned c = 0; c < 8; ++c) {
+        if ((c & flat) == 0) {
+          const auto v = value(index[0] + (c & 1), index[1] + ((c >> 1) & 1), index[2] + ((c >> 2) & 1));
+          std::copy(v.data(), v.data() + 3, cache.corners.begin() + 3 * c);
+        }
+      }
+      cache.index = index;
+    }
+
+    Acts::Vector3 b = Acts::Vector3::Zero();
+    if (gradient != nullptr) {
+      gradient->setZero();
+    }
+    for (unsigned c = 0; c < 8; ++c) {
+      if ((c & flat) != 0) {
+        continue;
+      }
+      const Acts::Vector3 corner(cache.corners[3 * c], cache.corners[3 * c + 1], cache.corners[3 * c + 2]);
+      // weights along each axis and their derivatives in t
+      std::array<double, 3> w{1., 1., 1.};
+      std::array<double, 3> dw{0., 0., 0.};
+      for (unsigned a = 0; a < 3; ++a) {
+        if ((flat >> a) & 1) {
+          continue;
+        }
+        const bool upper = (c >> a) & 1;
+        w[a]             = upper ? t[a] : 1. - t[a];
+        dw[a]            = upper ? 1. : -1.;
+      }
+      b += (w[0] * w[1] * w[2]) * corner;
+      if (gradient != nullptr) {
+        for (unsigned a = 0; a < 3; ++a) {
+          if (m_step[a] > 0.) {
+            const double dwa = dw[a] * w[(a + 1) % 3] * w[(a + 2) % 3] / m_step[a];
+            gradient->col(a) += dwa * corner;
+          }
+        }
+      }
+    }
+    return b;
+  }
+
+  Acts::Result<Acts::Vector3> GridBField::sourceField(const Acts::Vector3& position, Cache& cache) const
+  {
+    if (!cache.source) {
+      cache.source = std::make_unique<Acts::MagneticFieldProvider::Cache>(m_source->makeCache(Acts::MagneticFieldContext{}));
+    }
+    return m_source->getField(position, *cache.source);
+  }
+
+  Acts::Result<Acts::Vector3> GridBField::getField(const Acts::Vector3& position,
+                                                   Acts::MagneticFieldProvider::Cache& cache) const
+  {
+    auto& gc = gridCache(cache);
+    std::array<double, 3> u;
+    if (!toGrid(position, u)) {
+      return sourceField(position, gc);
+    }
+    const auto b = interpolate(u, gc, nullptr);
+    if (m_cfg.symmetry == Symmetry::XYZ) {
+      return Acts::Result<Acts::Vector3>::success(b);
+    }
+    // (Br, Bphi, Bz) rotated to the phi of the position
+    const double r = std::hypot(position.x(), position.y());
+    const double c = (r > 0.) ? position.x() / r : 1.;
+    const double s = (r > 0.) ? position.y() / r : 0.;
+    return Acts::Result<Acts::Vector3>::success({b[0] * c - b[1] * s, b[0] * s + b[1] * c, b[2]});
+  }
+
+  Acts::Result<Acts::Vector3> GridBField::getFieldGradient(const Acts::Vector3& position,
+                                                           Acts::ActsMatrix<3, 3>& derivative,
+                                                           Acts::MagneticFieldProvider::Cache& cache) const
+  {
+    auto& gc = gridCache(cache);
+    std::array<double, 3> u;
+    if (!toGrid(position, u)) {
+      derivative.setZero();
+      return sourceField(position, gc);
+    }
+    if (m_cfg.symmetry == Symmetry::XYZ) {
+      return Acts::Result<Acts::Vector3>::success(interpolate(u, gc, &derivative));
+    }
+
+    // (Br, Bphi, Bz) and their r and z derivatives, rotated to the phi of the position
+    Acts::ActsMatrix<3, 3> g;
+    const auto b   = interpolate(u, gc, &g);
+    const double r = std::hypot(position.x(), position.y());
+    const double c = (r > 0.) ? position.x() / r : 1.;
+    const double s = (r > 0.) ? position.y() / r : 0.;
+
+    const double dBr_dr = g(0, 0), dBp_dr = g(1, 0), dBz_dr = g(2, 0);
+    const double dBr_dz = g(0, 2), dBp_dz = g(1, 2), dBz_dz = g(2, 2);
+    // Br/r and Bphi/r, with their limits on the axis
+    const double br_r = (r > 0.) ? b[0] / r : dBr_dr;
+    const double bp_r = (r > 0.) ? b[1] / r : dBp_dr;
+    const double bxr  = dBr_dr * c - dBp_dr * s; // dBx/dr
+    const double byr  = dBr_dr * s + dBp_dr * c; // dBy/dr
+    const double bxp  = -br_r * s - bp_r * c;    // dBx/dphi / r
+    const double byp  = br_r * c - bp_r * s;     // dBy/dphi / r
+    // dr/dx = c, dr/dy = s, r dphi/dx = -s, r dphi/dy = c
+    derivative << bxr * c - bxp * s, bxr * s + bxp * c, dBr_dz * c - dBp_dz * s, //
+        byr * c - byp * s, byr * s + byp * c, dBr_dz * s + dBp_dz * c,           //
+        dBz_dr * c, dBz_dr * s, dBz_dz;
+    return Acts::Result<Acts::Vector3>::success({b[0] * c - b[1] * s, b[0] * s + b[1] * c, b[2]});
+  }
+
+  double GridBField::maxDeviation(size_t samples, uint32_t seed) const
+  {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> xy(-m_cfg.xyMax, m_cfg.xyMax);
+    std::uniform_real_distribution<double> z(m_cfg.zMin, m_cfg.zMax);
+    auto cache       = makeCache(Acts::MagneticFieldContext{});
+    auto sourceCache = m_source->makeCache(Acts::MagneticFieldContext{});
+    double deviation = 0.;
+    for (size_t n = 0; n < samples;) {
+      const Acts::Vector3 pos(xy(gen), xy(gen), z(gen));
+      if (m_cfg.symmetry == Symmetry::RZ && std::hypot(pos.x(), pos.y()) > m_cfg.xyMax) {
+        continue;
+      }
+      const auto b      = getField(pos, cache);
+      const auto bexact = m_source->getField(pos, sourceCache);
+      if (b.ok() && bexact.ok()) {
+        deviation = std::max(deviation, (b.value() - bexact.value()).norm());
+      }
+      ++n;
+    }
+    return deviation;
+  }
+
+} // namespace Jug::BField
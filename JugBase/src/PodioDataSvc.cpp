@@ -2,14 +2,26 @@
 // Copyright (C) 2022 Whitney Armstrong, Wouter Deconinck, Sylvester Joosten
 
 #include "JugBase/PodioDataSvc.h"
+#include "GaudiKernel/EventContext.h"
+#include "GaudiKernel/IAlgorithm.h"
 #include "GaudiKernel/IConversionSvc.h"
 #include "GaudiKernel/IEventProcessor.h"
 #include "GaudiKernel/ISvcLocator.h"
 
 #include "JugBase/DataWrapper.h"
+#include "JugBase/PodioHiveWhiteBoard.h"
 
+#include "TChain.h"
+#include "TEnv.h"
+#include "TROOT.h"
 #include "TTree.h"
 
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <string>
+#include <vector>
+
 /// Service initialization
 StatusCode PodioDataSvc::initialize() {
   // Nothing to do: just call base class initialisation
@@ -19,26 +31,260 @@ StatusCode PodioDataSvc::initialize() {
   // Attach data loader facility
   m_cnvSvc = svc_loc->service("EventPersistencySvc");
   status = setDataLoader(m_cnvSvc);
+  // the algorithm registering a collection is the current one of the context
+  if (m_memoryAccounting) {
+    m_algContextSvc = svc_loc->service("AlgContextSvc");
+  }
 
   if (!m_filename.empty()) {
     m_filenames.push_back(m_filename);
   }
 
-  if (!m_filenames.empty()) {
-    if (!m_filenames[0].empty()) {
-      m_reader.openFiles(m_filenames);
-      m_eventMax = m_reader.getEntries();
-      m_provider.setReader(&m_reader);
-      auto* idTable = m_reader.getCollectionIDTable();
-      setCollectionIDs(idTable);
+  if (readsInput() && openInput().isFailure()) {
+    return StatusCode::FAILURE;
+  }
+  return status;
+}
+
+StatusCode PodioDataSvc::openInput() {
+  // has to be set before the files are opened
+  if (m_asyncPrefetching) {
+    gEnv->SetValue("TFile.AsyncPrefetching", 1);
+  }
+  m_reader.openFiles(m_filenames);
+  m_provider.setReader(&m_reader);
+  auto* idTable = m_reader.getCollectionIDTable();
+  setCollectionIDs(idTable);
+
+  // podio::ROOTReader does not expose its chain, the chain registers itself in the list of data sets
+  m_inputChain = dynamic_cast<TChain*>(gROOT->GetListOfDataSets()->FindObject("events"));
+  if (m_inputChain == nullptr) {
+    warning() << "Input chain not found, the read cache settings are not applied" << endmsg;
+  } else {
+    if (m_readCacheLearnEntries > 0) {
+      m_inputChain->SetCacheLearnEntries(m_readCacheLearnEntries);
+    }
+    if (m_readCacheSize >= 0) {
+      m_inputChain->SetCacheSize(m_readCacheSize);
+    }
+    info() << "Input read cache of " << m_inputChain->GetCacheSize() << " bytes"
+           << (m_asyncPrefetching ? " with asynchronous prefetching" : "") << endmsg;
+  }
+  return selectEventRange();
+}
+
+Jug::Base::InputPipeline* PodioDataSvc::inputPipeline() {
+  if (m_readAhead == 0 || m_pipeline != nullptr || m_pipelineFailed) {
+    return m_pipeline.get();
+  }
+  // started on the first read, after the collections to read are known (and after a fork)
+  const long long remaining = std::max(0LL, static_cast<long long>(m_eventMax) - m_eventNum);
+  Jug::Base::InputPipeline::Settings settings;
+  settings.filenames     = m_filenames;
+  settings.collections   = m_cachedCollections;
+  settings.range         = {m_eventEntry, m_eventStride, remaining};
+  if (!m_eventEntries.empty()) {
+    settings.range.entries.assign(m_eventEntries.begin() + std::min<size_t>(m_eventNum, m_eventEntries.size()),
+                                  m_eventEntries.end());
+  }
+  settings.depth         = m_readAhead;
+  settings.maxBytes      = static_cast<size_t>(std::max(0LL, m_readAheadMaxBytes));
+  settings.readCacheSize = m_readCacheSize;
+  auto pipeline          = std::make_unique<Jug::Base::InputPipeline>();
+  if (std::string err; !pipeline->start(settings, err)) {
+    error() << "Cannot read the input ahead: " << err << endmsg;
+    m_pipelineFailed = true;
+    return nullptr;
+  }
+  info() << "Reading up to " << m_readAhead << " events ahead"
+         << ((m_readAheadMaxBytes > 0) ? " and " + std::to_string(m_readAheadMaxBytes) + " bytes" : "")
+         << " on a background thread" << endmsg;
+  m_pipeline = std::move(pipeline);
+  return m_pipeline.get();
+}
+
+StatusCode PodioDataSvc::start() {
+  if (DataSvc::start().isFailure()) {
+    return StatusCode::FAILURE;
+  }
+  return stopOnEmptyRange();
+}
+
+StatusCode PodioDataSvc::stopOnEmptyRange() {
+  if (m_eventMax != 0) {
+    return StatusCode::SUCCESS;
+  }
+  info() << "No events in the event range, the run stops before the first event" << endmsg;
+  return service<IEventProcessor>("ApplicationMgr")->stopRun();
+}
+
+StatusCode PodioDataSvc::selectWorker(int worker, unsigned numWorkers) {
+  m_worker     = worker;
+  m_numWorkers = numWorkers;
+  if (worker < 0) {
+    // the parent of the workers reads no events
+    m_eventMax = 0;
+    return stopOnEmptyRange();
+  }
+  // the workers split the shard of the job
+  m_shard   = m_shard * numWorkers + static_cast<unsigned>(worker);
+  m_nShards = m_nShards * numWorkers;
+  if (!readsInput()) {
+    return StatusCode::SUCCESS;
+  }
+  // the files opened before the fork share their offsets with the other processes
+  m_reader.closeFiles();
+  m_inputChain = nullptr;
+  if (openInput().isFailure()) {
+    return StatusCode::FAILURE;
+  }
+  setCachedCollections(m_cachedCollections);
+  // a worker without events in its part of the range
+  return stopOnEmptyRange();
+}
 
-      if (m_1stEvtEntry != 0) {
-        m_reader.goToEvent(m_1stEvtEntry);
-        m_eventMax -= m_1stEvtEntry;
+StatusCode PodioDataSvc::selectEventRange() {
+  if (m_nShards == 0 || m_shard >= m_nShards) {
+    error() << "Invalid shard " << m_shard << " of " << m_nShards << endmsg;
+    return StatusCode::FAILURE;
+  }
+  m_eventEntries.clear();
+  if (!m_eventList.empty() || !m_eventListFile.empty()) {
+    std::vector<long long> entries;
+    if (resolveEventList(entries).isFailure()) {
+      return StatusCode::FAILURE;
+    }
+    // the shards split the list as they split the event range
+    const size_t n = entries.size();
+    if (m_interleavedShards) {
+      for (size_t i = m_shard; i < n; i += m_nShards) {
+        m_eventEntries.push_back(entries[i]);
       }
+    } else {
+      const size_t block = (n + m_nShards - 1) / m_nShards;
+      const size_t begin = std::min(n, block * m_shard);
+      m_eventEntries.assign(entries.begin() + begin, entries.begin() + std::min(n, begin + block));
     }
+    m_eventEntry  = m_eventEntries.empty() ? 0 : m_eventEntries.front();
+    m_eventStride = 1;
+    m_eventMax    = static_cast<int>(m_eventEntries.size());
+    if (m_eventEntry != 0) {
+      m_reader.goToEvent(m_eventEntry);
+    }
+    info() << "Reading " << m_eventMax << " events of the event list of " << n << " entries"
+           << ((m_nShards > 1) ? " (shard " + std::to_string(m_shard) + " of " + std::to_string(m_nShards) + ")" : "")
+           << endmsg;
+    if (m_eventMax == 0) {
+      warning() << "No events to read in the event list" << endmsg;
+    }
+    return StatusCode::SUCCESS;
   }
-  return status;
+  // counting the entries of the chain opens all its files, only done without an explicit last entry
+  const long long last = (m_lastEvtEntry >= 0) ? m_lastEvtEntry : static_cast<long long>(m_reader.getEntries());
+  const long long first = m_1stEvtEntry;
+  if (last < first) {
+    error() << "Invalid event range [" << first << ", " << last << ")" << endmsg;
+    return StatusCode::FAILURE;
+  }
+  const long long range = last - first;
+  long long count = 0;
+  if (m_interleavedShards) {
+    // entries first + shard, first + shard + nShards, ...
+    m_eventEntry  = first + m_shard;
+    m_eventStride = m_nShards;
+    count         = (range > m_shard) ? (range - m_shard + m_nShards - 1) / m_nShards : 0;
+  } else {
+    // contiguous blocks, the last shards are shorter if the range does not divide evenly
+    const long long block = (range + m_nShards - 1) / m_nShards;
+    m_eventEntry          = first + std::min(range, block * m_shard);
+    m_eventStride         = 1;
+    count                 = std::min(last, m_eventEntry + block) - m_eventEntry;
+  }
+  m_eventMax = static_cast<int>(count);
+  if (m_eventEntry != 0) {
+    m_reader.goToEvent(m_eventEntry);
+  }
+  info() << "Reading " << m_eventMax << " events from entry " << m_eventEntry
+         << ((m_nShards > 1) ? " (shard " + std::to_string(m_shard) + " of " + std::to_string(m_nShards) + ")" : "")
+         << endmsg;
+  if (m_eventMax == 0) {
+    warning() << "No events to read in the selected range" << endmsg;
+  }
+  return StatusCode::SUCCESS;
+}
+
+StatusCode PodioDataSvc::resolveEventList(std::vector<long long>& entries) {
+  std::vector<std::string> items = m_eventList;
+  if (!m_eventListFile.empty()) {
+    std::ifstream file(m_eventListFile);
+    if (!file) {
+      error() << "Cannot open the event list " << m_eventListFile << endmsg;
+      return StatusCode::FAILURE;
+    }
+    // one entry per line, '#' starts a comment
+    for (std::string line; std::getline(file, line);) {
+      line.erase(std::find(line.begin(), line.end(), '#'), line.end());
+      line.erase(std::remove_if(line.begin(), line.end(), [](unsigned char c) { return std::isspace(c); }),
+                 line.end());
+      if (!line.empty()) {
+        items.push_back(line);
+      }
+    }
+  }
+  auto number = [](const std::string& text, long long& value) {
+    if (text.empty() || text.size() > 18 ||
+        !std::all_of(text.begin(), text.end(), [](unsigned char c) { return std::isdigit(c); })) {
+      return false;
+    }
+    value = std::stoll(text);
+    return true;
+  };
+
+  // the entries of the files are offsets in the chain, known once all its files are opened
+  const long long total = static_cast<long long>(m_reader.getEntries());
+  entries.clear();
+  entries.reserve(items.size());
+  for (const auto& item : items) {
+    // file names may contain ':' (e.g. root://), the entry follows the last one
+    const size_t colon = item.rfind(':');
+    long long entry    = 0;
+    if (!number(item.substr(colon == std::string::npos ? 0 : colon + 1), entry)) {
+      error() << "Invalid entry '" << item << "' in the event list" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    if (colon != std::string::npos) {
+      const std::string fileName = item.substr(0, colon);
+      long long index            = 0;
+      if (!number(fileName, index)) {
+        auto it = std::find(m_filenames.begin(), m_filenames.end(), fileName);
+        index   = (it != m_filenames.end()) ? static_cast<long long>(it - m_filenames.begin()) : -1;
+      }
+      if (m_inputChain == nullptr || index < 0 || index >= m_inputChain->GetNtrees()) {
+        error() << "Unknown input file of '" << item << "' in the event list" << endmsg;
+        return StatusCode::FAILURE;
+      }
+      const Long64_t* offsets = m_inputChain->GetTreeOffset();
+      const long long end     = (index + 1 < m_inputChain->GetNtrees()) ? offsets[index + 1] : total;
+      if (offsets[index] + entry >= end) {
+        error() << "Entry '" << item << "' of the event list is past the end of its file" << endmsg;
+        return StatusCode::FAILURE;
+      }
+      entry += offsets[index];
+    }
+    if (entry >= total) {
+      error() << "Entry '" << item << "' of the event list is past the end of the input" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    entries.push_back(entry);
+  }
+  // in the order of the chain, so that the entries of a basket are read together
+  std::sort(entries.begin(), entries.end());
+  const size_t listed = entries.size();
+  entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+  if (entries.size() != listed) {
+    warning() << listed - entries.size() << " duplicate entries in the event list are read once" << endmsg;
+  }
+  return StatusCode::SUCCESS;
 }
 /// Service reinitialization
 StatusCode PodioDataSvc::reinitialize() {
@@ -47,14 +293,34 @@ StatusCode PodioDataSvc::reinitialize() {
 }
 /// Service finalization
 StatusCode PodioDataSvc::finalize() {
-  m_cnvSvc = nullptr; // release
+  if (m_memoryAccounting) {
+    reportMemory();
+  }
+  if (m_pipeline != nullptr) {
+    m_pipeline->stop();
+    info() << "Read " << m_pipeline->events() << " events ahead, waited " << m_pipeline->waitSeconds()
+           << " s for them, peak " << m_pipeline->peakBytes() << " bytes read ahead" << endmsg;
+    m_pipeline.reset();
+  }
+  m_cnvSvc        = nullptr; // release
+  m_algContextSvc = nullptr;
   DataSvc::finalize().ignore();
+  m_recycledCollections.clear();
   return StatusCode::SUCCESS;
 }
 
 StatusCode PodioDataSvc::clearStore() {
+  if (m_memoryAccounting) {
+    accountMemory();
+  }
+  // invalidates the pointers cached by the data handles
+  ++m_generation;
   for (auto& collNamePair : m_collections) {
     if (collNamePair.second != nullptr) {
+      if (m_adaptiveReserve) {
+        auto& hint = m_capacityHints[collNamePair.first];
+        hint       = std::max(hint, collNamePair.second->size());
+      }
       collNamePair.second->clear();
     }
   }
@@ -64,17 +330,56 @@ StatusCode PodioDataSvc::clearStore() {
     }
   }
   DataSvc::clearStore().ignore();
+  for (const uint32_t key : m_flatKeys) {
+    delete m_flatObjects[key];
+    m_flatObjects[key] = nullptr;
+  }
+  m_flatKeys.clear();
+  m_eventParameters.clear();
   m_collections.clear();
+  m_producers.clear();
   m_readCollections.clear();
+  m_preparedCollections     = 0;
+  m_preparedReadCollections = 0;
+  // the reader stayed on this event for the lazy collections
+  m_lazyCollections.clear();
+  if (m_lazyEndOfRead) {
+    m_lazyEndOfRead = false;
+    endOfRead();
+  }
+  // the wrappers do not own the arena collections, destroy them after the store is cleared
+  m_eventArena.reset();
   return StatusCode::SUCCESS;
 }
 
 void PodioDataSvc::endOfRead() {
+  if (!m_lazyCollections.empty()) {
+    m_lazyEndOfRead = true;
+    return;
+  }
+  if (m_inputSvc != this) {
+    m_inputSvc->endOfRead();
+    return;
+  }
   if (m_eventMax != -1) {
-    m_provider.clearCaches();
-    m_reader.endOfEvent();
-    if (m_eventNum++ > m_eventMax) {
-      info() << "Reached end of file with event " << m_eventMax << endmsg;
+    if (m_pipeline != nullptr) {
+      // the buffer of the event reads the next events
+      m_pipeline->next();
+    } else {
+      m_provider.clearCaches();
+      m_reader.endOfEvent();
+    }
+    long long next = m_eventEntry + m_eventStride;
+    if (static_cast<size_t>(m_eventNum) + 1 < m_eventEntries.size()) {
+      next = m_eventEntries[m_eventNum + 1];
+    }
+    // the reader moved to the following entry, jump over the others
+    if (next != m_eventEntry + 1 && m_pipeline == nullptr) {
+      m_reader.goToEvent(next);
+    }
+    m_eventEntry = next;
+    if (++m_eventNum >= m_eventMax) {
+      info() << "Reached end of the event range with event " << m_eventMax << endmsg;
       IEventProcessor* eventProcessor = nullptr;
       auto ret = service("ApplicationMgr", eventProcessor);
       // FIXME: deal with errors
@@ -84,48 +389,348 @@ void PodioDataSvc::endOfRead() {
   }
 }
 
+void PodioDataSvc::prepareForWrite() {
+  auto lock = lockStore();
+  // the collections read lazily for a later stream are prepared when it writes the event
+  for (; m_preparedCollections < m_collections.size(); ++m_preparedCollections) {
+    if (auto* coll = m_collections[m_preparedCollections].second; coll != nullptr) {
+      coll->prepareForWrite();
+    }
+  }
+  for (; m_preparedReadCollections < m_readCollections.size(); ++m_preparedReadCollections) {
+    if (auto* coll = m_readCollections[m_preparedReadCollections].second; coll != nullptr) {
+      coll->prepareForWrite();
+    }
+  }
+}
+
+void PodioDataSvc::setCachedCollections(const std::vector<std::string>& collectionNames) {
+  m_cachedCollections = collectionNames;
+  if (m_inputChain == nullptr || m_inputChain->GetCacheSize() <= 0) {
+    return;
+  }
+  if (m_inputChain->GetTree() == nullptr) {
+    m_inputChain->LoadTree(m_eventEntry);
+  }
+  const size_t nBranches = Jug::Base::cacheCollectionBranches(*m_inputChain, collectionNames);
+  debug() << "Caching " << nBranches << " input branches" << endmsg;
+}
+
 void PodioDataSvc::setCollectionIDs(podio::CollectionIDTable* collectionIds) {
-  delete m_collectionIDs;
-  m_collectionIDs = collectionIds;
+  if (m_ownsCollectionIDs) {
+    delete m_collectionIDs;
+  }
+  m_collectionIDs     = collectionIds;
+  m_ownsCollectionIDs = true;
+  m_keyCollectionIDs.clear();
+}
+
+void PodioDataSvc::shareInput(PodioDataSvc* input, std::mutex* mutex) {
+  setCollectionIDs(nullptr);
+  m_collectionIDs      = input->m_collectionIDs;
+  m_ownsCollectionIDs  = false;
+  m_keys               = input->m_keys;
+  m_eventParameters.shareLayout(input->m_eventParameters);
+  m_inputSvc           = input;
+  m_sharedMutex        = mutex;
+  input->m_sharedMutex = mutex;
+}
+
+PodioDataSvc* PodioDataSvc::fromEventSvc(IDataProviderSvc* svc) {
+  if (auto* pds = dynamic_cast<PodioDataSvc*>(svc); pds != nullptr) {
+    return pds;
+  }
+  if (auto* wb = dynamic_cast<PodioHiveWhiteBoard*>(svc); wb != nullptr) {
+    return wb->currentStore();
+  }
+  return nullptr;
+}
+
+PodioDataSvc* PodioDataSvc::fromEventSvc(IDataProviderSvc* svc, const EventContext& ctx) {
+  if (auto* wb = dynamic_cast<PodioHiveWhiteBoard*>(svc); wb != nullptr && ctx.valid()) {
+    return wb->store(ctx.slot());
+  }
+  return fromEventSvc(svc);
 }
 
 /// Standard Constructor
 PodioDataSvc::PodioDataSvc(const std::string& name, ISvcLocator* svc)
-: DataSvc(name, svc), m_collectionIDs(new podio::CollectionIDTable()) {
+: DataSvc(name, svc)
+, m_collectionIDs(new podio::CollectionIDTable())
+, m_collectionBytes([this](const std::string& elementType) {
+    warning() << "No dictionary for the buffers of " << elementType << ", not accounted" << endmsg;
+  }) {
   m_eventDataTree = new TTree("events", "Events tree");
 }
 
 /// Standard Destructor
 PodioDataSvc::~PodioDataSvc() {
-  delete m_collectionIDs;
+  if (m_ownsCollectionIDs) {
+    delete m_collectionIDs;
+  }
 }
 
 StatusCode PodioDataSvc::readCollection(const std::string& collectionName, int collectionID) {
   podio::CollectionBase* collection(nullptr);
-  m_provider.get(collectionID, collection);
+  // the lock of a shared input is held by the caller (PodioInput)
+  Jug::Base::InputPipeline* pipeline = m_inputSvc->inputPipeline();
+  if (m_inputSvc->m_readAhead > 0 && pipeline == nullptr) {
+    return StatusCode::FAILURE;
+  }
+  if (pipeline != nullptr) {
+    // read and unpacked ahead
+    collection = pipeline->take(collectionID);
+  } else {
+    m_inputSvc->m_provider.get(collectionID, collection);
+  }
+  if (collection == nullptr) {
+    error() << "Collection " << collectionName << " not found in the input" << endmsg;
+    return StatusCode::FAILURE;
+  }
   if (collection->isSubsetCollection()) {
     return StatusCode::SUCCESS;
   }
-  auto* wrapper = new DataWrapper<podio::CollectionBase>;
-  const int id = m_collectionIDs->add(collectionName);
-  collection->setID(id);
+  auto* wrapper      = new DataWrapper<podio::CollectionBase>;
+  const uint32_t key = collectionKey(collectionName);
+  collection->setID(collectionID(key));
+  if (pipeline == nullptr) {
+    auto* chain = m_inputSvc->m_inputChain;
+    if (chain != nullptr &&
+        !m_inputSvc->m_packedCellIDs.unpack(*chain, m_inputSvc->m_eventEntry, collectionName, *collection)) {
+      error() << "The packed cellIDs of " << collectionName << " do not match the collection" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    collection->prepareAfterRead();
+  }
+  wrapper->setData(collection);
+  m_readCollections.emplace_back(std::make_pair(collectionName, collection));
+  if (m_flatStore) {
+    return registerFlat(key, wrapper);
+  }
+  return DataSvc::registerObject("/Event", "/" + collectionName, wrapper);
+}
+
+StatusCode PodioDataSvc::putReadCollection(const std::string& collectionName, podio::CollectionBase* collection) {
+  // the object IDs of the collection are set with the collection ID of the job
+  auto* wrapper      = new DataWrapper<podio::CollectionBase>;
+  const uint32_t key = collectionKey(collectionName);
+  collection->setID(collectionID(key));
   collection->prepareAfterRead();
   wrapper->setData(collection);
   m_readCollections.emplace_back(std::make_pair(collectionName, collection));
+  if (m_flatStore) {
+    return registerFlat(key, wrapper);
+  }
   return DataSvc::registerObject("/Event", "/" + collectionName, wrapper);
 }
 
+int PodioDataSvc::collectionID(uint32_t key) {
+  if (key >= m_keyCollectionIDs.size()) {
+    m_keyCollectionIDs.resize(m_keys->size(), -1);
+  }
+  int& id = m_keyCollectionIDs[key];
+  if (id < 0) {
+    id = m_collectionIDs->add(m_keys->name(key));
+  }
+  return id;
+}
+
+StatusCode PodioDataSvc::registerFlat(uint32_t key, DataObject* object) {
+  if (key >= m_flatObjects.size()) {
+    m_flatObjects.resize(m_keys->size(), nullptr);
+  }
+  if (m_flatObjects[key] != nullptr) {
+    error() << "Collection " << m_keys->name(key) << " is already in the store" << endmsg;
+    return StatusCode::FAILURE;
+  }
+  m_flatObjects[key] = object;
+  m_flatKeys.push_back(key);
+  return StatusCode::SUCCESS;
+}
+
+void PodioDataSvc::addCollection(uint32_t key, DataWrapperBase* wrapper) {
+  podio::CollectionBase* coll = wrapper->collectionBase();
+  if (coll == nullptr) {
+    return;
+  }
+  // the collection IDs may be shared with the other event slots
+  const int id = [&] {
+    auto lock = lockInput();
+    return collectionID(key);
+  }();
+  coll->setID(id);
+  m_collections.emplace_back(std::make_pair(m_keys->name(key), coll));
+  if (m_memoryAccounting) {
+    const IAlgorithm* alg = m_algContextSvc ? m_algContextSvc->currentAlg() : nullptr;
+    m_producers.push_back((alg != nullptr) ? alg->name() : "unknown");
+  }
+}
+
+StatusCode PodioDataSvc::registerCollection(uint32_t key, DataWrapperBase* wrapper) {
+  auto lock = lockStore();
+  addCollection(key, wrapper);
+  if (m_flatStore) {
+    return registerFlat(key, wrapper);
+  }
+  return DataSvc::registerObject("/Event", "/" + m_keys->name(key), wrapper);
+}
+
+size_t PodioDataSvc::capacityHint(std::string_view key) const {
+  // the collections are registered by their short name
+  const size_t pos = key.find_last_of("/");
+  auto it          = m_capacityHints.find(std::string(key.substr(pos == std::string_view::npos ? 0 : pos + 1)));
+  return (it != m_capacityHints.end()) ? it->second : 0;
+}
+
+void PodioDataSvc::registerLazyCollection(const std::string& collectionName, int collectionID) {
+  m_lazyCollections[collectionName] = collectionID;
+}
+
+StatusCode PodioDataSvc::readLazyCollections(const KeepDropSwitch& keep) {
+  // reading removes the collection from the lazy ones
+  std::vector<std::pair<std::string, int>> toRead;
+  for (const auto& [collName, collID] : m_lazyCollections) {
+    if (keep.isOn(collName)) {
+      toRead.emplace_back(collName, collID);
+    }
+  }
+  for (const auto& [collName, collID] : toRead) {
+    m_lazyCollections.erase(collName);
+    if (readCollection(collName, collID).isFailure()) {
+      return StatusCode::FAILURE;
+    }
+  }
+  return StatusCode::SUCCESS;
+}
+
+StatusCode PodioDataSvc::retrieveObject(IRegistry* pDirectory, std::string_view path, DataObject*& pObject) {
+  auto lock = lockStore();
+  if (!m_lazyCollections.empty()) {
+    const std::string shortPath(shortName(path));
+    auto it = m_lazyCollections.find(shortPath);
+    if (it != m_lazyCollections.end()) {
+      const int collID = it->second;
+      m_lazyCollections.erase(it);
+      debug() << "Reading lazy collection " << shortPath << " with id " << collID << endmsg;
+      if (readCollection(shortPath, collID).isFailure()) {
+        return StatusCode::FAILURE;
+      }
+    }
+  }
+  // the objects in the flat store are found by name, relative to the root
+  if (m_flatStore && pDirectory == nullptr) {
+    if (auto* object = flatObject(m_keys->find(shortName(path))); object != nullptr) {
+      pObject = object;
+      return StatusCode::SUCCESS;
+    }
+  }
+  return DataSvc::retrieveObject(pDirectory, path, pObject);
+}
+
+StatusCode PodioDataSvc::findObject(IRegistry* pDirectory, std::string_view path, DataObject*& pObject) {
+  if (m_flatStore && pDirectory == nullptr) {
+    if (auto* object = flatObject(m_keys->find(shortName(path))); object != nullptr) {
+      pObject = object;
+      return StatusCode::SUCCESS;
+    }
+  }
+  return DataSvc::findObject(pDirectory, path, pObject);
+}
+
+StatusCode PodioDataSvc::findObject(std::string_view fullPath, DataObject*& pObject) {
+  return findObject(nullptr, fullPath, pObject);
+}
+
+StatusCode PodioDataSvc::unregisterObject(std::string_view fullPath) {
+  if (m_flatStore) {
+    const uint32_t key = m_keys->find(shortName(fullPath));
+    if (flatObject(key) != nullptr) {
+      // the caller owns the object again
+      m_flatObjects[key] = nullptr;
+      m_flatKeys.erase(std::find(m_flatKeys.begin(), m_flatKeys.end(), key));
+      return StatusCode::SUCCESS;
+    }
+  }
+  return DataSvc::unregisterObject(fullPath);
+}
+
 StatusCode PodioDataSvc::registerObject(std::string_view parentPath, std::string_view fullPath, DataObject* pObject) {
+  auto lock     = lockStore();
   auto* wrapper = dynamic_cast<DataWrapperBase*>(pObject);
-  if (wrapper != nullptr) {
-    podio::CollectionBase* coll = wrapper->collectionBase();
-    if (coll != nullptr) {
-      const size_t pos = fullPath.find_last_of("/");
-      const std::string shortPath(fullPath.substr(pos + 1, fullPath.length()));
-      const int id = m_collectionIDs->add(shortPath);
-      coll->setID(id);
-      m_collections.emplace_back(std::make_pair(shortPath, coll));
-    }
+  if (wrapper == nullptr) {
+    return DataSvc::registerObject(parentPath, fullPath, pObject);
+  }
+  const uint32_t key = collectionKey(fullPath);
+  addCollection(key, wrapper);
+  if (m_flatStore) {
+    return registerFlat(key, wrapper);
   }
   return DataSvc::registerObject(parentPath, fullPath, pObject);
 }
+
+size_t PodioDataSvc::eventBytes() {
+  size_t bytes = 0;
+  for (const auto* collections : {&m_collections, &m_readCollections}) {
+    for (const auto& [collName, coll] : *collections) {
+      if (coll != nullptr) {
+        bytes += m_collectionBytes(coll);
+      }
+    }
+  }
+  return bytes;
+}
+
+bool PodioDataSvc::withinMemoryBudget() {
+  if (m_maxEventBytes <= 0) {
+    return true;
+  }
+  auto lock          = lockStore();
+  const size_t bytes = eventBytes();
+  if (bytes <= static_cast<size_t>(m_maxEventBytes)) {
+    return true;
+  }
+  warning() << "Collections of the event take " << bytes << " bytes, more than maxEventBytes " << m_maxEventBytes
+            << ", the event is not written" << endmsg;
+  return false;
+}
+
+void PodioDataSvc::accountMemory() {
+  std::unordered_map<std::string, size_t> algorithmBytes;
+  size_t total = 0;
+  auto account = [&](const std::string& collName, podio::CollectionBase* coll, const std::string& producer) {
+    if (coll == nullptr) {
+      return;
+    }
+    const size_t bytes = m_collectionBytes(coll);
+    auto& peak         = m_collectionPeaks[collName];
+    peak               = std::max(peak, bytes);
+    algorithmBytes[producer] += bytes;
+    total += bytes;
+  };
+  for (size_t i = 0; i < m_collections.size(); ++i) {
+    account(m_collections[i].first, m_collections[i].second, m_producers[i]);
+  }
+  for (const auto& [collName, coll] : m_readCollections) {
+    account(collName, coll, "input");
+  }
+  for (const auto& [producer, bytes] : algorithmBytes) {
+    auto& peak = m_algorithmPeaks[producer];
+    peak       = std::max(peak, bytes);
+  }
+  m_eventPeak = std::max(m_eventPeak, total);
+}
+
+void PodioDataSvc::reportMemory() const {
+  auto byBytes = [](const std::unordered_map<std::string, size_t>& peaks) {
+    std::vector<std::pair<std::string, size_t>> sorted(peaks.begin(), peaks.end());
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+    return sorted;
+  };
+  info() << "Peak bytes of the collections of an event: " << m_eventPeak << endmsg;
+  for (const auto& [producer, bytes] : byBytes(m_algorithmPeaks)) {
+    info() << "  peak bytes of algorithm " << producer << ": " << bytes << endmsg;
+  }
+  for (const auto& [collName, bytes] : byBytes(m_collectionPeaks)) {
+    info() << "  peak bytes of collection " << collName << ": " << bytes << endmsg;
+  }
+}
@@ -0,0 +1,328 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "JugBase/PodioHiveWhiteBoard.h"
+#include "JugBase/PodioDataSvc.h"
+
+#include <GaudiKernel/DataObjID.h>
+
+namespace {
+// slot selected on this thread by the scheduler
+thread_local size_t s_current = 0;
+} // namespace
+
+StatusCode PodioHiveWhiteBoard::initialize() {
+  if (Service::initialize().isFailure()) {
+    return StatusCode::FAILURE;
+  }
+  if (m_slots.value() == 0) {
+    error() << "At least one event slot is needed" << endmsg;
+    return StatusCode::FAILURE;
+  }
+  m_partitions.resize(m_slots.value());
+  for (size_t i = 0; i < m_partitions.size(); ++i) {
+    auto* store = new PodioDataSvc(name() + "_" + std::to_string(i), serviceLocator());
+    store->addRef();
+    store->m_useEventArena      = m_useEventArena.value();
+    store->m_recycleCollections = m_recycleCollections.value();
+    store->m_adaptiveReserve    = m_adaptiveReserve.value();
+    store->m_flatStore          = m_flatStore.value();
+    store->m_memoryAccounting   = m_memoryAccounting.value();
+    store->m_maxEventBytes      = m_maxEventBytes.value();
+    // the scheduler may run the independent algorithms of an event at the same time
+    store->m_concurrentAccess = true;
+    // only the first slot opens the input
+    if (i == 0) {
+      store->m_filenames         = m_filenames.value();
+      store->m_filename          = m_filename.value();
+      store->m_1stEvtEntry       = m_firstEntry.value();
+      store->m_lastEvtEntry      = m_lastEntry.value();
+      store->m_eventList         = m_eventList.value();
+      store->m_eventListFile     = m_eventListFile.value();
+      store->m_readCacheSize     = m_readCacheSize.value();
+      store->m_readAhead         = m_readAhead.value();
+      store->m_readAheadMaxBytes = m_readAheadMaxBytes.value();
+    }
+    m_partitions[i].store = store;
+    if (store->sysInitialize().isFailure()) {
+      error() << "Failed to initialize the store of event slot " << i << endmsg;
+      return StatusCode::FAILURE;
+    }
+    if (i > 0) {
+      store->shareInput(m_partitions[0].store, &m_inputMutex);
+    }
+  }
+  info() << "Event store with " << m_partitions.size() << " slots" << endmsg;
+  return StatusCode::SUCCESS;
+}
+
+StatusCode PodioHiveWhiteBoard::start() {
+  if (Service::start().isFailure()) {
+    return StatusCode::FAILURE;
+  }
+  // the stores of the slots are not started by the service manager, the first one reads the input
+  return m_partitions.front().store->stopOnEmptyRange();
+}
+
+StatusCode PodioHiveWhiteBoard::finalize() {
+  // the first slot owns the input and the collection IDs, release it last
+  for (auto it = m_partitions.rbegin(); it != m_partitions.rend(); ++it) {
+    if (it->store != nullptr) {
+      it->store->sysFinalize().ignore();
+      it->store->release();
+      it->store = nullptr;
+    }
+  }
+  m_partitions.clear();
+  return Service::finalize();
+}
+
+PodioDataSvc* PodioHiveWhiteBoard::currentStore() { return store(s_current); }
+
+PodioDataSvc* PodioHiveWhiteBoard::store(size_t slot) {
+  return (slot < m_partitions.size()) ? m_partitions[slot].store : nullptr;
+}
+
+StatusCode PodioHiveWhiteBoard::selectStore(size_t partition) {
+  if (partition >= m_partitions.size()) {
+    return StatusCode::FAILURE;
+  }
+  s_current = partition;
+  return StatusCode::SUCCESS;
+}
+
+StatusCode PodioHiveWhiteBoard::clearStore(size_t partition) {
+  if (partition >= m_partitions.size()) {
+    return StatusCode::FAILURE;
+  }
+  return m_partitions[partition].store->clearStore();
+}
+
+StatusCode PodioHiveWhiteBoard::setNumberOfStores(size_t slots) {
+  if (FSMState() == Gaudi::StateMachine::INITIALIZED || FSMState() == Gaudi::StateMachine::RUNNING) {
+    warning() << "Too late to change the number of slots" << endmsg;
+    return StatusCode::FAILURE;
+  }
+  m_slots = slots;
+  return StatusCode::SUCCESS;
+}
+
+size_t PodioHiveWhiteBoard::allocateStore(int evtnumber) {
+  std::lock_guard<std::mutex> lock(m_slotMutex);
+  for (size_t i = 0; i < m_partitions.size(); ++i) {
+    if (m_partitions[i].eventNumber == -1) {
+      m_partitions[i].eventNumber = evtnumber;
+      return i;
+    }
+  }
+  return static_cast<size_t>(-1);
+}
+
+StatusCode PodioHiveWhiteBoard::freeStore(size_t partition) {
+  std::lock_guard<std::mutex> lock(m_slotMutex);
+  if (partition >= m_partitions.size()) {
+    return StatusCode::FAILURE;
+  }
+  m_partitions[partition].eventNumber = -1;
+  return StatusCode::SUCCESS;
+}
+
+size_t PodioHiveWhiteBoard::getPartitionNumber(int eventnumber) const {
+  std::lock_guard<std::mutex> lock(m_slotMutex);
+  for (size_t i = 0; i < m_partitions.size(); ++i) {
+    if (m_partitions[i].eventNumber == eventnumber) {
+      return i;
+    }
+  }
+  return static_cast<size_t>(-1);
+}
+
+size_t PodioHiveWhiteBoard::freeSlots() {
+  std::lock_guard<std::mutex> lock(m_slotMutex);
+  size_t free = 0;
+  for (const auto& partition : m_partitions) {
+    if (partition.eventNumber == -1) {
+      ++free;
+    }
+  }
+  return free;
+}
+
+bool PodioHiveWhiteBoard::exists(const DataObjID& id) {
+  DataObject* pObject = nullptr;
+  auto* store         = currentStore();
+  auto lock           = store->lockStore();
+  return store->findObject(id.key(), pObject).isSuccess();
+}
+
+//// IDataManagerSvc, forwarded to the current slot //////////////////////
+
+CLID PodioHiveWhiteBoard::rootCLID() const { return m_partitions.front().store->rootCLID(); }
+
+const std::string& PodioHiveWhiteBoard::rootName() const { return m_partitions.front().store->rootName(); }
+
+StatusCode PodioHiveWhiteBoard::registerAddress(std::string_view fullPath, IOpaqueAddress* pAddress) {
+  return currentStore()->registerAddress(fullPath, pAddress);
+}
+
+StatusCode PodioHiveWhiteBoard::registerAddress(DataObject* parentObj, std::string_view objectPath,
+                                                IOpaqueAddress* pAddress) {
+  return currentStore()->registerAddress(parentObj, objectPath, pAddress);
+}
+
+StatusCode PodioHiveWhiteBoard::registerAddress(IRegistry* parentObj, std::string_view objectPath,
+                                                IOpaqueAddress* pAddress) {
+  return currentStore()->registerAddress(parentObj, objectPath, pAddress);
+}
+
+StatusCode PodioHiveWhiteBoard::unregisterAddress(std::string_view fullPath) {
+  return currentStore()->unregisterAddress(fullPath);
+}
+
+StatusCode PodioHiveWhiteBoard::unregisterAddress(DataObject* pParent, std::string_view objPath) {
+  return currentStore()->unregisterAddress(pParent, objPath);
+}
+
+StatusCode PodioHiveWhiteBoard::unregisterAddress(IRegistry* pParent, std::string_view objPath) {
+  return currentStore()->unregisterAddress(pParent, objPath);
+}
+
+StatusCode PodioHiveWhiteBoard::objectLeaves(const DataObject* pObject, std::vector<IRegistry*>& refLeaves) {
+  return currentStore()->objectLeaves(pObject, refLeaves);
+}
+
+StatusCode PodioHiveWhiteBoard::objectLeaves(const IRegistry* pObject, std::vector<IRegistry*>& refLeaves) {
+  return currentStore()->objectLeaves(pObject, refLeaves);
+}
+
+StatusCode PodioHiveWhiteBoard::objectParent(const DataObject* pObject, IRegistry*& refpParent) {
+  return currentStore()->objectParent(pObject, refpParent);
+}
+
+StatusCode PodioHiveWhiteBoard::objectParent(const IRegistry* pObject, IRegistry*& refpParent) {
+  return currentStore()->objectParent(pObject, refpParent);
+}
+
+StatusCode PodioHiveWhiteBoard::clearSubTree(std::string_view sub_path) {
+  return currentStore()->clearSubTree(sub_path);
+}
+
+StatusCode PodioHiveWhiteBoard::clearSubTree(DataObject* pObject) { return currentStore()->clearSubTree(pObject); }
+
+StatusCode PodioHiveWhiteBoard::clearStore() {
+  for (auto& partition : m_partitions) {
+    partition.store->clearStore().ignore();
+  }
+  return StatusCode::SUCCESS;
+}
+
+StatusCode PodioHiveWhiteBoard::traverseSubTree(std::string_view sub_path, IDataStoreAgent* pAgent) {
+  return currentStore()->traverseSubTree(sub_path, pAgent);
+}
+
+StatusCode PodioHiveWhiteBoard::traverseSubTree(DataObject* pObject, IDataStoreAgent* pAgent) {
+  return currentStore()->traverseSubTree(pObject, pAgent);
+}
+
+StatusCode PodioHiveWhiteBoard::traverseTree(IDataStoreAgent* pAgent) { return currentStore()->traverseTree(pAgent); }
+
+StatusCode PodioHiveWhiteBoard::setRoot(std::string root_name, DataObject* pObject) {
+  return currentStore()->setRoot(std::move(root_name), pObject);
+}
+
+StatusCode PodioHiveWhiteBoard::setRoot(std::string root_path, IOpaqueAddress* pRootAddr) {
+  return currentStore()->setRoot(std::move(root_path), pRootAddr);
+}
+
+StatusCode PodioHiveWhiteBoard::setDataLoader(IConversionSvc* svc, IDataProviderSvc* dpsvc) {
+  for (auto& partition : m_partitions) {
+    if (partition.store->setDataLoader(svc, dpsvc).isFailure()) {
+      return StatusCode::FAILURE;
+    }
+  }
+  return StatusCode::SUCCESS;
+}
+
+//// IDataProviderSvc, forwarded to the current slot /////////////////////
+
+StatusCode PodioHiveWhiteBoard::registerObject(std::string_view parentPath, std::string_view objectPath,
+                                               DataObject* pObject) {
+  return currentStore()->registerObject(parentPath, objectPath, pObject);
+}
+
+StatusCode PodioHiveWhiteBoard::registerObject(DataObject* parentObj, std::string_view objectPath,
+                                               DataObject* pObject) {
+  auto* store = currentStore();
+  auto lock   = store->lockStore();
+  return store->registerObject(parentObj, objectPath, pObject);
+}
+
+StatusCode PodioHiveWhiteBoard::unregisterObject(std::string_view fullPath) {
+  auto* store = currentStore();
+  auto lock   = store->lockStore();
+  return store->unregisterObject(fullPath);
+}
+
+StatusCode PodioHiveWhiteBoard::unregisterObject(DataObject* pObject) {
+  auto* store = currentStore();
+  auto lock   = store->lockStore();
+  return store->unregisterObject(pObject);
+}
+
+StatusCode PodioHiveWhiteBoard::unregisterObject(DataObject* pParent, std::string_view objectPath) {
+  auto* store = currentStore();
+  auto lock   = store->lockStore();
+  return store->unregisterObject(pParent, objectPath);
+}
+
+StatusCode PodioHiveWhiteBoard::retrieveObject(IRegistry* pDirectory, std::string_view path, DataObject*& pObject) {
+  return currentStore()->retrieveObject(pDirectory, path, pObject);
+}
+
+StatusCode PodioHiveWhiteBoard::findObject(IRegistry* pDirectory, std::string_view path, DataObject*& pObject) {
+  auto* store = currentStore();
+  auto lock   = store->lockStore();
+  return store->findObject(pDirectory, path, pObject);
+}
+
+StatusCode PodioHiveWhiteBoard::findObject(std::string_view fullPath, DataObject*& pObject) {
+  auto* store = currentStore();
+  auto lock   = store->lockStore();
+  return store->findObject(fullPath, pObject);
+}
+
+StatusCode PodioHiveWhiteBoard::updateObject(IRegistry* pDirectory) { return currentStore()->updateObject(pDirectory); }
+
+StatusCode PodioHiveWhiteBoard::updateObject(DataObject* toUpdate) { return currentStore()->updateObject(toUpdate); }
+
+StatusCode PodioHiveWhiteBoard::addPreLoadItem(const DataStoreItem& item) {
+  return currentStore()->addPreLoadItem(item);
+}
+
+StatusCode PodioHiveWhiteBoard::removePreLoadItem(const DataStoreItem& item) {
+  return currentStore()->removePreLoadItem(item);
+}
+
+StatusCode PodioHiveWhiteBoard::resetPreLoad() { return currentStore()->resetPreLoad(); }
+
+StatusCode PodioHiveWhiteBoard::preLoad() { return currentStore()->preLoad(); }
+
+StatusCode PodioHiveWhiteBoard::linkObject(IRegistry* from, std::string_view objPath, DataObject* toObj) {
+  return currentStore()->linkObject(from, objPath, toObj);
+}
+
+StatusCode PodioHiveWhiteBoard::linkObject(std::string_view fullPath, DataObject* toObj) {
+  return currentStore()->linkObject(fullPath, toObj);
+}
+
+StatusCode PodioHiveWhiteBoard::unlinkObject(IRegistry* from, std::string_view objPath) {
+  return currentStore()->unlinkObject(from, objPath);
+}
+
+StatusCode PodioHiveWhiteBoard::unlinkObject(DataObject* fromObj, std::string_view objPath) {
+  return currentStore()->unlinkObject(fromObj, objPath);
+}
+
+StatusCode PodioHiveWhiteBoard::unlinkObject(std::string_view fullPath) {
+  return currentStore()->unlinkObject(fullPath);
+}
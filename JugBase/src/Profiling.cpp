@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "JugBase/Profiling.h"
+
+#if defined(JUGGLER_HAVE_PROFILING)
+
+#include <utility>
+
+#if defined(JUGGLER_HAVE_ITT)
+#include <ittnotify.h>
+#endif
+#if defined(JUGGLER_HAVE_NVTX)
+#include <nvtx3/nvToolsExt.h>
+#endif
+#if defined(JUGGLER_HAVE_SDT)
+#include <sys/sdt.h>
+#endif
+
+namespace {
+#if defined(JUGGLER_HAVE_ITT)
+__itt_domain* ittDomain() {
+  static __itt_domain* const domain = __itt_domain_create("juggler");
+  return domain;
+}
+#endif
+#if defined(JUGGLER_HAVE_NVTX)
+nvtxDomainHandle_t nvtxDomain() {
+  static const nvtxDomainHandle_t domain = nvtxDomainCreateA("juggler");
+  return domain;
+}
+#endif
+} // namespace
+
+namespace Jug::Base {
+
+ProfileRegion::ProfileRegion(std::string name) : m_name(std::move(name)) {
+#if defined(JUGGLER_HAVE_ITT)
+  m_itt = __itt_string_handle_create(m_name.c_str());
+#endif
+#if defined(JUGGLER_HAVE_NVTX)
+  m_nvtx = nvtxDomainRegisterStringA(nvtxDomain(), m_name.c_str());
+#endif
+}
+
+void ProfileRegion::begin() const {
+#if defined(JUGGLER_HAVE_ITT)
+  __itt_task_begin(ittDomain(), __itt_null, __itt_null, static_cast<__itt_string_handle*>(m_itt));
+#endif
+#if defined(JUGGLER_HAVE_NVTX)
+  nvtxEventAttributes_t attributes{};
+  attributes.version            = NVTX_VERSION;
+  attributes.size               = NVTX_EVENT_ATTRIB_STRUCT_SIZE;
+  attributes.messageType        = NVTX_MESSAGE_TYPE_REGISTERED;
+  attributes.message.registered = static_cast<nvtxStringHandle_t>(m_nvtx);
+  nvtxDomainRangePushEx(nvtxDomain(), &attributes);
+#endif
+#if defined(JUGGLER_HAVE_SDT)
+  DTRACE_PROBE1(juggler, region_begin, m_name.c_str());
+#endif
+}
+
+void ProfileRegion::end() const {
+#if defined(JUGGLER_HAVE_SDT)
+  DTRACE_PROBE1(juggler, region_end, m_name.c_str());
+#endif
+#if defined(JUGGLER_HAVE_NVTX)
+  nvtxDomainRangePop(nvtxDomain());
+#endif
+#if defined(JUGGLER_HAVE_ITT)
+  __itt_task_end(ittDomain());
+#endif
+}
+
+} // namespace Jug::Base
+
+#endif
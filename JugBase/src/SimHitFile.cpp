@@ -0,0 +1,358 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "JugBase/SimHitFile.h"
+
+#include <algorithm>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+constexpr uint64_t kFileMagic   = 0x54484d495347554a; // "JUGSIMHT"
+constexpr uint32_t kFileVersion = 1;
+
+struct FileHeader {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t ncollections;
+  uint64_t nblocks;
+  uint64_t entries;
+  uint64_t directoryOffset;
+};
+
+struct CollectionEntry {
+  uint32_t nameLength;
+  uint32_t kind;
+};
+
+constexpr uint64_t align8(uint64_t offset) { return (offset + 7) & ~uint64_t(7); }
+
+template <typename T> void write_value(std::ostream& os, const T& value) {
+  os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void pad(std::ostream& os) {
+  const char padding[8] = {};
+  const auto pos        = static_cast<uint64_t>(os.tellp());
+  os.write(padding, align8(pos) - pos);
+}
+
+template <typename T> void write_column(std::ostream& os, const std::vector<T>& column) {
+  os.write(reinterpret_cast<const char*>(column.data()), column.size() * sizeof(T));
+  pad(os);
+}
+
+/// Next column of n values of type T in a block, the cursor moves past it
+template <typename T> const T* next_column(const char*& cursor, uint64_t n) {
+  const auto* column = reinterpret_cast<const T*>(cursor);
+  cursor += align8(n * sizeof(T));
+  return column;
+}
+
+/// Bytes of the columns of a collection in a block
+uint64_t extent_bytes(Jug::Base::SimHitFile::Kind kind, uint64_t nevents, uint64_t nhits, uint64_t ncontributions) {
+  using Kind = Jug::Base::SimHitFile::Kind;
+  using V3f  = Jug::Base::SimHitFile::Vector3f;
+  using V3d  = Jug::Base::SimHitFile::Vector3d;
+  uint64_t bytes = align8((nevents + 1) * sizeof(uint32_t)) + align8(nhits * sizeof(uint64_t));
+  if (kind == Kind::Calorimeter) {
+    bytes += align8(nhits * sizeof(float)) + align8(nhits * sizeof(V3f)) + align8((nhits + 1) * sizeof(uint32_t));
+    bytes += 3 * align8(ncontributions * sizeof(float)) + align8(ncontributions * sizeof(V3f));
+  } else {
+    bytes += 4 * align8(nhits * sizeof(float)) + align8(nhits * sizeof(V3d)) + align8(nhits * sizeof(V3f));
+  }
+  return bytes;
+}
+} // namespace
+
+namespace Jug::Base {
+
+SimHitFile::~SimHitFile() { close(); }
+
+void SimHitFile::close() {
+  if (m_data != nullptr) {
+    munmap(m_data, m_size);
+  }
+  m_data       = nullptr;
+  m_size       = 0;
+  m_entries    = 0;
+  m_nblocks    = 0;
+  m_blockFirst = nullptr;
+  m_extents    = nullptr;
+  m_collections.clear();
+}
+
+bool SimHitFile::open(const std::string& filename) {
+  close();
+  const int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st {};
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(FileHeader)) {
+    ::close(fd);
+    return false;
+  }
+  m_size = st.st_size;
+  m_data = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+  // the mapping stays valid after the file is closed
+  ::close(fd);
+  if (m_data == MAP_FAILED) {
+    m_data = nullptr;
+    m_size = 0;
+    return false;
+  }
+
+  const auto* base   = static_cast<const char*>(m_data);
+  const auto* header = reinterpret_cast<const FileHeader*>(base);
+  if (header->magic != kFileMagic || header->version != kFileVersion || header->directoryOffset % 8 != 0 ||
+      header->directoryOffset + header->ncollections * sizeof(CollectionEntry) > m_size) {
+    close();
+    return false;
+  }
+  const auto* entries = reinterpret_cast<const CollectionEntry*>(base + header->directoryOffset);
+  uint64_t offset     = header->directoryOffset + header->ncollections * sizeof(CollectionEntry);
+  for (uint32_t c = 0; c < header->ncollections; ++c) {
+    if (offset + entries[c].nameLength > m_size || entries[c].kind > static_cast<uint32_t>(Kind::Tracker)) {
+      close();
+      return false;
+    }
+    m_collections.push_back({std::string(base + offset, entries[c].nameLength), static_cast<Kind>(entries[c].kind)});
+    offset += entries[c].nameLength;
+  }
+  offset = align8(offset);
+  if (offset + (header->nblocks + 1) * sizeof(uint64_t) + header->nblocks * header->ncollections * sizeof(Extent) >
+      m_size) {
+    close();
+    return false;
+  }
+  m_blockFirst = reinterpret_cast<const uint64_t*>(base + offset);
+  m_extents    = reinterpret_cast<const Extent*>(base + offset + (header->nblocks + 1) * sizeof(uint64_t));
+  m_nblocks    = header->nblocks;
+  m_entries    = header->entries;
+  if (m_blockFirst[m_nblocks] != m_entries) {
+    close();
+    return false;
+  }
+  for (uint64_t b = 0; b < m_nblocks; ++b) {
+    for (size_t c = 0; c < m_collections.size(); ++c) {
+      const auto& extent = m_extents[b * m_collections.size() + c];
+      if (m_blockFirst[b + 1] < m_blockFirst[b] || extent.offset % 8 != 0 ||
+          extent.offset + extent_bytes(m_collections[c].kind, m_blockFirst[b + 1] - m_blockFirst[b], extent.nhits,
+                                       extent.ncontributions) >
+              header->directoryOffset) {
+        close();
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+int SimHitFile::collection(const std::string& name) const {
+  auto it = std::find_if(m_collections.begin(), m_collections.end(),
+                         [&name](const Collection& c) { return c.name == name; });
+  return (it != m_collections.end()) ? static_cast<int>(it - m_collections.begin()) : -1;
+}
+
+const char* SimHitFile::block(uint64_t event, size_t collection, const Extent*& extent, uint64_t& local,
+                              uint64_t& nevents) const {
+  if (event >= m_entries || collection >= m_collections.size()) {
+    return nullptr;
+  }
+  // last block starting at or before the event
+  const auto* it = std::upper_bound(m_blockFirst, m_blockFirst + m_nblocks, event) - 1;
+  const auto b   = static_cast<uint64_t>(it - m_blockFirst);
+  local          = event - it[0];
+  nevents        = it[1] - it[0];
+  extent         = &m_extents[b * m_collections.size() + collection];
+  return static_cast<const char*>(m_data) + extent->offset;
+}
+
+bool SimHitFile::calorimeterHits(size_t collection, uint64_t event, CalorimeterHits& hits) const {
+  const Extent* extent = nullptr;
+  uint64_t local       = 0;
+  uint64_t nevents     = 0;
+  const char* cursor   = block(event, collection, extent, local, nevents);
+  if (cursor == nullptr || m_collections[collection].kind != Kind::Calorimeter) {
+    return false;
+  }
+  const auto* hitBegin   = next_column<uint32_t>(cursor, nevents + 1);
+  const auto n           = extent->nhits;
+  const auto nc          = extent->ncontributions;
+  const auto first       = hitBegin[local];
+  hits.size              = hitBegin[local + 1] - first;
+  hits.cellID            = next_column<uint64_t>(cursor, n) + first;
+  hits.energy            = next_column<float>(cursor, n) + first;
+  hits.position          = next_column<Vector3f>(cursor, n) + first;
+  hits.contributionBegin = next_column<uint32_t>(cursor, n + 1) + first;
+  hits.pdg               = next_column<int32_t>(cursor, nc);
+  hits.contributionEnergy = next_column<float>(cursor, nc);
+  hits.time               = next_column<float>(cursor, nc);
+  hits.stepPosition       = next_column<Vector3f>(cursor, nc);
+  return true;
+}
+
+bool SimHitFile::trackerHits(size_t collection, uint64_t event, TrackerHits& hits) const {
+  const Extent* extent = nullptr;
+  uint64_t local       = 0;
+  uint64_t nevents     = 0;
+  const char* cursor   = block(event, collection, extent, local, nevents);
+  if (cursor == nullptr || m_collections[collection].kind != Kind::Tracker) {
+    return false;
+  }
+  const auto* hitBegin   = next_column<uint32_t>(cursor, nevents + 1);
+  const auto n           = extent->nhits;
+  const auto first       = hitBegin[local];
+  hits.size              = hitBegin[local + 1] - first;
+  hits.cellID            = next_column<uint64_t>(cursor, n) + first;
+  hits.eDep              = next_column<float>(cursor, n) + first;
+  hits.time              = next_column<float>(cursor, n) + first;
+  hits.pathLength        = next_column<float>(cursor, n) + first;
+  hits.quality           = next_column<int32_t>(cursor, n) + first;
+  hits.position          = next_column<Vector3d>(cursor, n) + first;
+  hits.momentum          = next_column<Vector3f>(cursor, n) + first;
+  return true;
+}
+
+void SimHitFile::prefetch(uint64_t first, uint64_t last) const {
+  last = std::min(last, m_entries);
+  if (first >= last || m_collections.empty()) {
+    return;
+  }
+  const Extent* begin = nullptr;
+  const Extent* end   = nullptr;
+  uint64_t local      = 0;
+  uint64_t nevents    = 0;
+  block(first, 0, begin, local, nevents);
+  block(last - 1, m_collections.size() - 1, end, local, nevents);
+  const auto endOffset =
+      end->offset + extent_bytes(m_collections.back().kind, nevents, end->nhits, end->ncontributions);
+  // madvise needs a page-aligned start
+  const auto page  = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+  const auto start = begin->offset / page * page;
+  madvise(static_cast<char*>(m_data) + start, endOffset - start, MADV_WILLNEED);
+}
+
+SimHitFile::Writer::~Writer() {
+  if (m_os.is_open()) {
+    close();
+  }
+}
+
+bool SimHitFile::Writer::open(const std::string& filename, const std::vector<Collection>& collections,
+                              uint32_t eventsPerBlock) {
+  m_os.open(filename, std::ios::binary | std::ios::trunc);
+  m_collections    = collections;
+  m_eventsPerBlock = std::max<uint32_t>(eventsPerBlock, 1);
+  m_entries        = 0;
+  m_blockEvents    = 0;
+  m_columns.assign(collections.size(), Columns());
+  m_blockFirst.clear();
+  m_extents.clear();
+  // the header is written again by close
+  write_value(m_os, FileHeader{});
+  return static_cast<bool>(m_os);
+}
+
+void SimHitFile::Writer::add(size_t collection, const CalorimeterHit& hit) {
+  auto& columns = m_columns[collection];
+  columns.cellID.push_back(hit.cellID);
+  columns.energy.push_back(hit.energy);
+  columns.position.push_back(hit.position);
+  columns.contributionBegin.push_back(columns.contributionBegin.back());
+}
+
+void SimHitFile::Writer::add(size_t collection, const Contribution& contribution) {
+  auto& columns = m_columns[collection];
+  columns.pdg.push_back(contribution.pdg);
+  columns.contributionEnergy.push_back(contribution.energy);
+  columns.time.push_back(contribution.time);
+  columns.stepPosition.push_back(contribution.stepPosition);
+  ++columns.contributionBegin.back();
+}
+
+void SimHitFile::Writer::add(size_t collection, const TrackerHit& hit) {
+  auto& columns = m_columns[collection];
+  columns.cellID.push_back(hit.cellID);
+  columns.energy.push_back(hit.eDep);
+  columns.time.push_back(hit.time);
+  columns.pathLength.push_back(hit.pathLength);
+  columns.quality.push_back(hit.quality);
+  columns.trackerPosition.push_back(hit.position);
+  columns.momentum.push_back(hit.momentum);
+}
+
+bool SimHitFile::Writer::endEvent() {
+  for (auto& columns : m_columns) {
+    columns.hitBegin.push_back(static_cast<uint32_t>(columns.cellID.size()));
+  }
+  ++m_entries;
+  if (++m_blockEvents == m_eventsPerBlock) {
+    return writeBlock();
+  }
+  return static_cast<bool>(m_os);
+}
+
+bool SimHitFile::Writer::writeBlock() {
+  if (m_blockEvents == 0) {
+    return static_cast<bool>(m_os);
+  }
+  m_blockFirst.push_back(m_entries - m_blockEvents);
+  for (size_t c = 0; c < m_collections.size(); ++c) {
+    auto& columns = m_columns[c];
+    m_extents.push_back({static_cast<uint64_t>(m_os.tellp()), columns.cellID.size(), columns.pdg.size()});
+    write_column(m_os, columns.hitBegin);
+    write_column(m_os, columns.cellID);
+    if (m_collections[c].kind == Kind::Calorimeter) {
+      write_column(m_os, columns.energy);
+      write_column(m_os, columns.position);
+      write_column(m_os, columns.contributionBegin);
+      write_column(m_os, columns.pdg);
+      write_column(m_os, columns.contributionEnergy);
+      write_column(m_os, columns.time);
+      write_column(m_os, columns.stepPosition);
+    } else {
+      write_column(m_os, columns.energy);
+      write_column(m_os, columns.time);
+      write_column(m_os, columns.pathLength);
+      write_column(m_os, columns.quality);
+      write_column(m_os, columns.trackerPosition);
+      write_column(m_os, columns.momentum);
+    }
+    columns = Columns();
+  }
+  m_blockEvents = 0;
+  return static_cast<bool>(m_os);
+}
+
+bool SimHitFile::Writer::close() {
+  writeBlock();
+  const auto directoryOffset = static_cast<uint64_t>(m_os.tellp());
+  for (const auto& collection : m_collections) {
+    write_value(m_os, CollectionEntry{static_cast<uint32_t>(collection.name.size()),
+                                      static_cast<uint32_t>(collection.kind)});
+  }
+  for (const auto& collection : m_collections) {
+    m_os.write(collection.name.data(), collection.name.size());
+  }
+  pad(m_os);
+  for (const auto first : m_blockFirst) {
+    write_value(m_os, first);
+  }
+  write_value(m_os, m_entries);
+  for (const auto& extent : m_extents) {
+    write_value(m_os, extent);
+  }
+  m_os.seekp(0);
+  write_value(m_os, FileHeader{kFileMagic, kFileVersion, static_cast<uint32_t>(m_collections.size()),
+                               m_blockFirst.size(), m_entries, directoryOffset});
+  const bool ok = static_cast<bool>(m_os);
+  m_os.close();
+  return ok;
+}
+
+} // namespace Jug::Base
@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "JugBase/SurfaceIndex.h"
+
+#include <algorithm>
+
+namespace Jug::Base {
+
+SurfaceIndex::Entry& SurfaceIndex::insert(uint64_t volumeID, uint64_t mask) {
+  auto& entry    = m_inserted[mask][volumeID];
+  entry.volumeID = volumeID;
+  return entry;
+}
+
+void SurfaceIndex::build() {
+  for (auto& [mask, entries] : m_inserted) {
+    auto group = std::find_if(m_groups.begin(), m_groups.end(), [m = mask](const Group& g) { return g.mask == m; });
+    if (group == m_groups.end()) {
+      group = m_groups.insert(m_groups.end(), {mask, {}});
+    }
+    for (auto& [volumeID, entry] : entries) {
+      group->entries.push_back(std::move(entry));
+    }
+    std::sort(group->entries.begin(), group->entries.end(),
+              [](const Entry& a, const Entry& b) { return a.volumeID < b.volumeID; });
+  }
+  m_inserted.clear();
+  // the largest detectors first, they have most of the hits
+  std::sort(m_groups.begin(), m_groups.end(),
+            [](const Group& a, const Group& b) { return a.entries.size() > b.entries.size(); });
+}
+
+const SurfaceIndex::Entry* SurfaceIndex::find(uint64_t cellID) const {
+  for (const auto& group : m_groups) {
+    const uint64_t volumeID = cellID & group.mask;
+    const auto it           = std::lower_bound(group.entries.begin(), group.entries.end(), volumeID,
+                                               [](const Entry& e, uint64_t id) { return e.volumeID < id; });
+    if (it != group.entries.end() && it->volumeID == volumeID) {
+      return &*it;
+    }
+  }
+  return nullptr;
+}
+
+size_t SurfaceIndex::size() const {
+  size_t n = 0;
+  for (const auto& group : m_groups) {
+    n += group.entries.size();
+  }
+  return n;
+}
+
+} // namespace Jug::Base
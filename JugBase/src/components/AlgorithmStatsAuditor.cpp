@@ -0,0 +1,303 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "fmt/format.h"
+
+#include "Gaudi/Property.h"
+#include "GaudiKernel/Auditor.h"
+
+#include "JugBase/Instrumentation.h"
+#include "podio/CollectionBase.h"
+
+#include "TFile.h"
+#include "TTree.h"
+
+namespace Jug::Base {
+
+/** Per-algorithm timing and allocation statistics.
+ *
+ *  Records for every execute() of every algorithm the wall and CPU time, the heap allocations
+ *  (see AllocationCounter, with libJugAllocCounter.so preloaded), and the number of objects in
+ *  the collections read and created through DataHandles. Times are inclusive of nested
+ *  algorithms (e.g. for sequencers). For the algorithms with parallel sections (IConcurrencySvc),
+ *  the parallel efficiency is the time their tasks kept the threads busy over the thread time of
+ *  the sections.
+ *
+ *  At finalize, a summary with the per-call percentiles is printed and written to the CSV
+ *  and JSON files, if set. With rootFile, a tree with one entry per execute() is written.
+ *  With lowOverhead, only the times are recorded: no percentiles, allocations or data sizes.
+ *
+ *  Enable with ApplicationMgr().AuditAlgorithms = True and
+ *  AuditorSvc().Auditors = ["Jug::Base::AlgorithmStatsAuditor"].
+ *
+ * \ingroup base
+ */
+class AlgorithmStatsAuditor : public Auditor {
+public:
+  using Auditor::after;
+  using Auditor::Auditor;
+  using Auditor::before;
+
+  StatusCode initialize() override {
+    if (Auditor::initialize().isFailure()) {
+      return StatusCode::FAILURE;
+    }
+    if (!m_lowOverhead.value()) {
+      if (AllocationCounter::available()) {
+        AllocationCounter::enable(true);
+      } else {
+        info() << "Allocations not counted, preload libJugAllocCounter.so to count them" << endmsg;
+      }
+    }
+    if (!m_rootFile.value().empty()) {
+      m_file = std::unique_ptr<TFile>(TFile::Open(m_rootFile.value().c_str(), "RECREATE"));
+      if (m_file == nullptr || m_file->IsZombie()) {
+        error() << "Cannot open " << m_rootFile.value() << endmsg;
+        return StatusCode::FAILURE;
+      }
+      m_tree = new TTree("algorithm_stats", "Algorithm execute statistics");
+      m_tree->Branch("algorithm", &m_rowAlgorithm);
+      m_tree->Branch("call", &m_row.call);
+      m_tree->Branch("wall", &m_row.wall);
+      m_tree->Branch("cpu", &m_row.cpu);
+      m_tree->Branch("allocBytes", &m_row.allocBytes);
+      m_tree->Branch("allocCount", &m_row.allocCount);
+      m_tree->Branch("inputObjects", &m_row.inputObjects);
+      m_tree->Branch("outputObjects", &m_row.outputObjects);
+      m_tree->Branch("parallelWall", &m_row.parallelWall);
+      m_tree->Branch("parallelBusy", &m_row.parallelBusy);
+      m_tree->Branch("parallelCapacity", &m_row.parallelCapacity);
+    }
+    return StatusCode::SUCCESS;
+  }
+
+  StatusCode finalize() override {
+    AllocationCounter::enable(false);
+    summarize();
+    if (m_file != nullptr) {
+      m_file->cd();
+      m_tree->Write();
+      m_file->Close();
+      info() << "Algorithm statistics tree written to " << m_rootFile.value() << endmsg;
+    }
+    return Auditor::finalize();
+  }
+
+  void before(StandardEventType evt, const std::string& /* caller */) override {
+    if (evt != IAuditor::Execute) {
+      return;
+    }
+    auto& stack = frames();
+    const size_t depth = s_depth++;
+    if (stack.size() <= depth) {
+      stack.emplace_back();
+    }
+    Frame& frame = stack[depth];
+    if (!m_lowOverhead.value()) {
+      frame.record.clear();
+      frame.parent           = currentExecuteRecord();
+      currentExecuteRecord() = &frame.record;
+      frame.allocBytes       = AllocationCounter::bytes();
+      frame.allocCount       = AllocationCounter::count();
+    }
+    frame.cpu  = threadCpuTime();
+    frame.wall = std::chrono::steady_clock::now();
+  }
+
+  void after(StandardEventType evt, const std::string& caller, const StatusCode& /* sc */) override {
+    if (evt != IAuditor::Execute || s_depth == 0) {
+      return;
+    }
+    const auto wall  = std::chrono::steady_clock::now();
+    const double cpu = threadCpuTime();
+    Frame& frame = frames()[--s_depth];
+
+    Row row;
+    row.wall = std::chrono::duration<double>(wall - frame.wall).count();
+    row.cpu  = cpu - frame.cpu;
+    if (!m_lowOverhead.value()) {
+      currentExecuteRecord() = frame.parent;
+      row.allocBytes   = AllocationCounter::bytes() - frame.allocBytes;
+      row.allocCount   = AllocationCounter::count() - frame.allocCount;
+      row.inputObjects = frame.record.inputObjects;
+      for (const auto* coll : frame.record.outputs) {
+        row.outputObjects += coll->size();
+      }
+      row.parallelWall     = frame.record.parallelWall;
+      row.parallelBusy     = frame.record.parallelBusy;
+      row.parallelCapacity = frame.record.parallelCapacity;
+      // the data of nested algorithms is also accessed by their parent
+      if (frame.parent != nullptr) {
+        frame.parent->inputObjects += frame.record.inputObjects;
+        frame.parent->outputs.insert(frame.parent->outputs.end(), frame.record.outputs.begin(),
+                                     frame.record.outputs.end());
+        frame.parent->parallelWall += frame.record.parallelWall;
+        frame.parent->parallelBusy += frame.record.parallelBusy;
+        frame.parent->parallelCapacity += frame.record.parallelCapacity;
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto& stats = m_stats[caller];
+    row.call    = stats.calls++;
+    stats.wall += row.wall;
+    stats.cpu += row.cpu;
+    stats.allocBytes += row.allocBytes;
+    stats.allocCount += row.allocCount;
+    stats.inputObjects += row.inputObjects;
+    stats.outputObjects += row.outputObjects;
+    stats.parallelWall += row.parallelWall;
+    stats.parallelBusy += row.parallelBusy;
+    stats.parallelCapacity += row.parallelCapacity;
+    if (!m_lowOverhead.value()) {
+      stats.wallSamples.push_back(static_cast<float>(row.wall));
+    }
+    if (m_tree != nullptr) {
+      m_rowAlgorithm = caller;
+      m_row          = row;
+      m_tree->Fill();
+    }
+  }
+
+private:
+  struct Frame {
+    std::chrono::steady_clock::time_point wall;
+    double cpu{0};
+    uint64_t allocBytes{0};
+    uint64_t allocCount{0};
+    ExecuteRecord record;
+    ExecuteRecord* parent{nullptr};
+  };
+  struct Row {
+    uint64_t call{0};
+    double wall{0};
+    double cpu{0};
+    uint64_t allocBytes{0};
+    uint64_t allocCount{0};
+    uint64_t inputObjects{0};
+    uint64_t outputObjects{0};
+    double parallelWall{0};
+    double parallelBusy{0};
+    double parallelCapacity{0};
+  };
+  struct Stats {
+    uint64_t calls{0};
+    double wall{0};
+    double cpu{0};
+    uint64_t allocBytes{0};
+    uint64_t allocCount{0};
+    uint64_t inputObjects{0};
+    uint64_t outputObjects{0};
+    double parallelWall{0};
+    double parallelBusy{0};
+    double parallelCapacity{0};
+    std::vector<float> wallSamples;
+  };
+
+  // frames of the algorithms being executed on this thread, reused between calls
+  static std::vector<Frame>& frames() {
+    static thread_local std::vector<Frame> stack;
+    return stack;
+  }
+  static thread_local size_t s_depth;
+
+  static double threadCpuTime() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) + 1e-9 * static_cast<double>(ts.tv_nsec);
+  }
+
+  static double percentile(std::vector<float>& samples, double fraction) {
+    if (samples.empty()) {
+      return 0.;
+    }
+    const auto n = static_cast<size_t>(fraction * static_cast<double>(samples.size() - 1) + 0.5);
+    std::nth_element(samples.begin(), samples.begin() + n, samples.end());
+    return samples[n];
+  }
+
+  void summarize() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::ofstream csv;
+    std::ofstream json;
+    if (!m_csvFile.value().empty()) {
+      csv.open(m_csvFile.value());
+      csv << "algorithm,calls,wall_total_ms,wall_mean_ms,wall_p50_ms,wall_p90_ms,wall_p99_ms,cpu_total_ms,"
+             "alloc_bytes_per_call,allocs_per_call,input_objects_per_call,output_objects_per_call,parallel_wall_ms,"
+             "parallel_efficiency\n";
+    }
+    if (!m_jsonFile.value().empty()) {
+      json.open(m_jsonFile.value());
+      json << "[";
+    }
+    info() << fmt::format("{:<40} {:>8} {:>10} {:>10} {:>10} {:>10} {:>12} {:>10} {:>8}", "algorithm", "calls",
+                          "mean [ms]", "p50 [ms]", "p99 [ms]", "cpu [ms]", "alloc [B]", "out/call", "par eff")
+           << endmsg;
+    bool first = true;
+    for (auto& [name, stats] : m_stats) {
+      const double calls = std::max<double>(1., static_cast<double>(stats.calls));
+      const double mean  = 1e3 * stats.wall / calls;
+      const double p50   = 1e3 * percentile(stats.wallSamples, 0.50);
+      const double p90   = 1e3 * percentile(stats.wallSamples, 0.90);
+      const double p99   = 1e3 * percentile(stats.wallSamples, 0.99);
+      const double bytes = static_cast<double>(stats.allocBytes) / calls;
+      const double count = static_cast<double>(stats.allocCount) / calls;
+      const double in    = static_cast<double>(stats.inputObjects) / calls;
+      const double out   = static_cast<double>(stats.outputObjects) / calls;
+      // parallel efficiency of the algorithms with parallel sections, 0 for the others
+      const double eff = stats.parallelCapacity > 0 ? stats.parallelBusy / stats.parallelCapacity : 0.;
+      info() << fmt::format("{:<40} {:>8} {:>10.3f} {:>10.3f} {:>10.3f} {:>10.3f} {:>12.0f} {:>10.1f} {:>8}", name,
+                            stats.calls, mean, p50, p99, 1e3 * stats.cpu / calls, bytes, out,
+                            stats.parallelCapacity > 0 ? fmt::format("{:.0f}%", 100 * eff) : std::string("-"))
+             << endmsg;
+      if (csv.is_open()) {
+        csv << fmt::format("{},{},{},{},{},{},{},{},{},{},{},{},{},{}\n", name, stats.calls, 1e3 * stats.wall, mean,
+                           p50, p90, p99, 1e3 * stats.cpu, bytes, count, in, out, 1e3 * stats.parallelWall, eff);
+      }
+      if (json.is_open()) {
+        json << fmt::format("{}\n  {{\"algorithm\": \"{}\", \"calls\": {}, \"wall_total_ms\": {}, \"wall_mean_ms\": {}, "
+                            "\"wall_p50_ms\": {}, \"wall_p90_ms\": {}, \"wall_p99_ms\": {}, \"cpu_total_ms\": {}, "
+                            "\"alloc_bytes_per_call\": {}, \"allocs_per_call\": {}, "
+                            "\"input_objects_per_call\": {}, \"output_objects_per_call\": {}, "
+                            "\"parallel_wall_ms\": {}, \"parallel_efficiency\": {}}}",
+                            first ? "" : ",", name, stats.calls, 1e3 * stats.wall, mean, p50, p90, p99,
+                            1e3 * stats.cpu, bytes, count, in, out, 1e3 * stats.parallelWall, eff);
+      }
+      first = false;
+    }
+    if (json.is_open()) {
+      json << "\n]\n";
+    }
+  }
+
+  Gaudi::Property<bool> m_lowOverhead{
+      this, "lowOverhead", false, "Only record the times (no percentiles, allocations or data sizes)"};
+  Gaudi::Property<std::string> m_csvFile{this, "csvFile", "", "CSV file for the summary, none if empty"};
+  Gaudi::Property<std::string> m_jsonFile{this, "jsonFile", "", "JSON file for the summary, none if empty"};
+  Gaudi::Property<std::string> m_rootFile{this, "rootFile", "",
+                                          "ROOT file for the tree of all execute() calls, none if empty"};
+
+  std::mutex m_mutex;
+  std::map<std::string, Stats> m_stats;
+  std::unique_ptr<TFile> m_file;
+  TTree* m_tree{nullptr};
+  std::string m_rowAlgorithm;
+  Row m_row;
+};
+
+thread_local size_t AlgorithmStatsAuditor::s_depth = 0;
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(AlgorithmStatsAuditor)
+
+} // namespace Jug::Base
@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include <string>
+
+#include "Gaudi/Property.h"
+#include "GaudiKernel/Service.h"
+
+#include "JugBase/Utilities/Dispatch.h"
+
+using namespace Jug::Base::Dispatch;
+
+/** Instruction set of the vectorized kernels (see Dispatch.h).
+ *
+ *  The kernels use the best instruction set of the CPU (level auto), or the one of level:
+ *  baseline, avx2 or avx512, if the CPU has it. The level used is reported at initialize.
+ *
+ * \ingroup base
+ */
+class CPUDispatchSvc : public Service {
+public:
+  using Service::Service;
+
+  StatusCode initialize() override {
+    StatusCode sc = Service::initialize();
+    if (!sc.isSuccess()) {
+      return sc;
+    }
+    Level level = detected();
+    if (m_level.value() != "auto") {
+      const auto requested = parse(m_level.value());
+      if (!requested) {
+        error() << "Unknown level " << m_level.value() << ", use auto, baseline, avx2 or avx512" << endmsg;
+        return StatusCode::FAILURE;
+      }
+      if (static_cast<int>(*requested) > static_cast<int>(detected())) {
+        warning() << "The CPU does not have " << name(*requested) << ", the kernels use " << name(detected())
+                  << endmsg;
+      }
+      level = *requested;
+    }
+    info() << "Vectorized kernels for " << name(select(level)) << " (CPU: " << name(detected()) << ")" << endmsg;
+    return StatusCode::SUCCESS;
+  }
+
+private:
+  Gaudi::Property<std::string> m_level{this, "level", "auto", "Instruction set: auto, baseline, avx2 or avx512"};
+};
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(CPUDispatchSvc)
@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "CalibrationSvc.h"
+
+#include <exception>
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(CalibrationSvc)
+
+CalibrationSvc::CalibrationSvc(const std::string& name, ISvcLocator* svc) : base_class(name, svc) {}
+
+CalibrationSvc::~CalibrationSvc() = default;
+
+StatusCode CalibrationSvc::initialize() {
+  StatusCode sc = Service::initialize();
+  if (!sc.isSuccess()) {
+    return sc;
+  }
+  m_geoSvc = service(m_geoSvcName);
+  if (!m_geoSvc) {
+    error() << "Unable to locate Geometry Service. "
+            << "Make sure you have GeoSvc and SimSvc in the right order in the configuration." << endmsg;
+    return StatusCode::FAILURE;
+  }
+  info() << "CalibrationSvc initialized with " << m_files.value().size() << " calibrations for run "
+         << m_run.value() << endmsg;
+  return StatusCode::SUCCESS;
+}
+
+StatusCode CalibrationSvc::finalize() {
+  m_calibrations.clear();
+  return Service::finalize();
+}
+
+const Jug::Base::Calibration* CalibrationSvc::calibration(const std::string& name) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_calibrations.find(name);
+  if (it != m_calibrations.end()) {
+    return it->second.get();
+  }
+  const auto file = m_files.value().find(name);
+  if (file == m_files.value().end()) {
+    error() << "No calibration file for " << name << " in calibrationFiles" << endmsg;
+    return nullptr;
+  }
+  try {
+    auto calibration = Jug::Base::Calibration::read(file->second, *m_geoSvc->detector());
+    info() << "Calibration " << name << " of readout " << calibration->readout() << ": "
+           << calibration->channels() << " channels, " << calibration->size() << " IOVs from " << file->second
+           << endmsg;
+    if (calibration->table(m_run.value()) == nullptr) {
+      warning() << "Calibration " << name << " has no constants for run " << m_run.value() << endmsg;
+    }
+    return m_calibrations.emplace(name, std::move(calibration)).first->second.get();
+  } catch (const std::exception& e) {
+    error() << "Cannot read the calibration " << name << ": " << e.what() << endmsg;
+    return nullptr;
+  }
+}
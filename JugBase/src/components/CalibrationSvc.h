@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef CALIBRATIONSVC_H
+#define CALIBRATIONSVC_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "Gaudi/Property.h"
+#include "GaudiKernel/Service.h"
+
+#include "JugBase/ICalibrationSvc.h"
+#include "JugBase/IGeoSvc.h"
+
+/** Per-channel calibration constants service.
+ *
+ *  The calibrations are files of per-channel constants for intervals of validity of the runs
+ *  (see Jug::Base::Calibration), configured by name in calibrationFiles and read on their first
+ *  request, with the channel fields of their readout in the geometry of GeoSvc. The events are
+ *  those of runNumber, as for RandomSvc.
+ *
+ * \ingroup base
+ */
+class CalibrationSvc : public extends<Service, ICalibrationSvc> {
+public:
+  CalibrationSvc(const std::string& name, ISvcLocator* svc);
+
+  virtual ~CalibrationSvc();
+
+  virtual StatusCode initialize() final;
+  virtual StatusCode finalize() final;
+
+  virtual const Jug::Base::Calibration* calibration(const std::string& name) override;
+  virtual uint64_t run() const override { return m_run.value(); }
+
+private:
+  Gaudi::Property<std::string> m_geoSvcName{this, "geoServiceName", "GeoSvc"};
+  Gaudi::Property<std::map<std::string, std::string>> m_files{this, "calibrationFiles", {},
+                                                              "Calibration files by calibration name"};
+  Gaudi::Property<uint64_t> m_run{this, "runNumber", 0};
+
+  SmartIF<IGeoSvc> m_geoSvc;
+  std::mutex m_mutex;
+  std::map<std::string, std::unique_ptr<const Jug::Base::Calibration>> m_calibrations;
+};
+
+#endif // CALIBRATIONSVC_H
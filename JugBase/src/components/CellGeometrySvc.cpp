@@ -0,0 +1,192 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "CellGeometrySvc.h"
+
+#include <algorithm>
+#include <exception>
+#include <iterator>
+
+#include "DD4hep/Readout.h"
+
+#include "JugBase/Logging.h"
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(CellGeometrySvc)
+
+DD4hepCellGeometryTable::DD4hepCellGeometryTable(const dd4hep::Detector& detector,
+                                                 std::shared_ptr<const dd4hep::rec::CellIDPositionConverter> converter,
+                                                 const Jug::Base::CellGeometrySpec& spec,
+                                                 const Jug::Base::CellGeometryFile::Table* precomputed)
+    : m_readout(spec.readout)
+    , m_converter(std::move(converter))
+    , m_precomputed(precomputed)
+    , m_volman(detector.volumeManager()) {
+  // throws for unknown readouts, fields and DetElements
+  if (!spec.readout.empty()) {
+    m_decoder = Jug::Base::CellIDDecoder::readout(detector, spec.readout);
+    if (!spec.layerField.empty()) {
+      m_layerIdx = static_cast<int>(m_decoder->index(spec.layerField));
+    }
+    if (!spec.sectorField.empty()) {
+      m_sectorIdx = static_cast<int>(m_decoder->index(spec.sectorField));
+    }
+    if (!spec.localDetFields.empty()) {
+      m_localMask = m_decoder->mask(spec.localDetFields);
+    }
+  }
+  if (!spec.localDetElement.empty()) {
+    m_local = detector.detector(spec.localDetElement);
+  }
+}
+
+Jug::Base::CellGeometry DD4hepCellGeometryTable::compute(CellID cellID) const {
+  const auto local = m_local.isValid() ? m_local : m_volman.lookupDetElement(cellID & m_localMask);
+
+  const auto* precomputed = (m_precomputed != nullptr) ? m_precomputed->find(cellID) : nullptr;
+  if (precomputed == nullptr) {
+    ++m_computed;
+  }
+  const auto rec = (precomputed != nullptr) ? *precomputed
+                                            : Jug::Base::CellGeometryFile::record(*m_converter, local, cellID);
+
+  Jug::Base::CellGeometry geo;
+  geo.global = dd4hep::Position(rec.global[0], rec.global[1], rec.global[2]);
+  geo.local  = local.nominal().worldToLocal(geo.global);
+  std::copy(std::begin(rec.dimension), std::end(rec.dimension), geo.dimension.begin());
+
+  if (m_layerIdx >= 0) {
+    geo.layer = static_cast<int32_t>((*m_decoder)[m_layerIdx].value(cellID));
+  }
+  if (m_sectorIdx >= 0) {
+    geo.sector = static_cast<int32_t>((*m_decoder)[m_sectorIdx].value(cellID));
+  }
+  return geo;
+}
+
+const Jug::Base::CellGeometry& DD4hepCellGeometryTable::insert(CellID cellID) const {
+  // another thread may have added the cell since the shared lock was released
+  auto it = m_table.find(cellID);
+  if (it == m_table.end()) {
+    it = m_table.emplace(cellID, compute(cellID)).first;
+  }
+  return it->second;
+}
+
+const Jug::Base::CellGeometry& DD4hepCellGeometryTable::geometry(CellID cellID) const {
+  {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    auto it = m_table.find(cellID);
+    if (it != m_table.end()) {
+      return it->second;
+    }
+  }
+  std::unique_lock<std::shared_mutex> lock(m_mutex);
+  return insert(cellID);
+}
+
+void DD4hepCellGeometryTable::records(std::vector<Jug::Base::CellGeometryFile::Record>& records) const {
+  std::shared_lock<std::shared_mutex> lock(m_mutex);
+  records.reserve(records.size() + m_table.size());
+  for (const auto& [cellID, geo] : m_table) {
+    records.push_back({cellID,
+                       {geo.global.x(), geo.global.y(), geo.global.z()},
+                       {geo.dimension[0], geo.dimension[1], geo.dimension[2]}});
+  }
+}
+
+void DD4hepCellGeometryTable::geometry(const std::vector<CellID>& cellIDs,
+                                       std::vector<const Jug::Base::CellGeometry*>& geometries) const {
+  geometries.resize(cellIDs.size());
+  bool missing = false;
+  {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    for (size_t i = 0; i < cellIDs.size(); ++i) {
+      auto it       = m_table.find(cellIDs[i]);
+      geometries[i] = (it != m_table.end()) ? &it->second : nullptr;
+      missing |= (geometries[i] == nullptr);
+    }
+  }
+  if (!missing) {
+    return;
+  }
+  std::unique_lock<std::shared_mutex> lock(m_mutex);
+  for (size_t i = 0; i < cellIDs.size(); ++i) {
+    if (geometries[i] == nullptr) {
+      geometries[i] = &insert(cellIDs[i]);
+    }
+  }
+}
+
+CellGeometrySvc::CellGeometrySvc(const std::string& name, ISvcLocator* svc) : base_class(name, svc) {}
+
+CellGeometrySvc::~CellGeometrySvc() = default;
+
+StatusCode CellGeometrySvc::initialize() {
+  StatusCode sc = Service::initialize();
+  if (!sc.isSuccess()) {
+    return sc;
+  }
+  m_geoSvc = service(m_geoSvcName);
+  if (!m_geoSvc) {
+    error() << "Unable to locate Geometry Service. "
+            << "Make sure you have GeoSvc and SimSvc in the right order in the configuration." << endmsg;
+    return StatusCode::FAILURE;
+  }
+  return StatusCode::SUCCESS;
+}
+
+StatusCode CellGeometrySvc::finalize() {
+  size_t computed = 0;
+  for (const auto& [key, table] : m_tables) {
+    JUG_DEBUG("Cell geometry table " << key << " with " << table->size() << " cells, " << table->computed()
+                                     << " not precomputed");
+    computed += table->computed();
+  }
+  if (!m_outputFile.value().empty() && computed > 0) {
+    if (writeTables(m_outputFile.value())) {
+      info() << "Cell geometry tables written to " << m_outputFile.value() << endmsg;
+    } else {
+      warning() << "Failed to write cell geometry tables to " << m_outputFile.value() << endmsg;
+    }
+  }
+  m_tables.clear();
+  return Service::finalize();
+}
+
+const Jug::Base::CellGeometryTable* CellGeometrySvc::geometryTable(const Jug::Base::CellGeometrySpec& spec) {
+  const auto key = spec.key();
+  std::lock_guard<std::mutex> lock(m_tablesMutex);
+  auto it = m_tables.find(key);
+  if (it != m_tables.end()) {
+    return it->second.get();
+  }
+  try {
+    const auto* file        = m_geoSvc->cellGeometryFile();
+    const auto* precomputed = (file != nullptr) ? file->table(spec.readout) : nullptr;
+    auto table = std::make_unique<DD4hepCellGeometryTable>(*m_geoSvc->detector(), m_geoSvc->cellIDPositionConverter(),
+                                                           spec, precomputed);
+    debug() << "Created cell geometry table " << key << endmsg;
+    return m_tables.emplace(key, std::move(table)).first->second.get();
+  } catch (const std::exception& e) {
+    error() << "Cannot create the cell geometry table for readout " << spec.readout << ": " << e.what() << endmsg;
+    return nullptr;
+  }
+}
+
+bool CellGeometrySvc::writeTables(const std::string& filename) const {
+  std::map<std::string, std::vector<Jug::Base::CellGeometryFile::Record>> records;
+  // keep the precomputed cells that were not used in this job
+  if (const auto* file = m_geoSvc->cellGeometryFile(); file != nullptr) {
+    for (const auto& [readout, table] : file->tables()) {
+      records[readout].assign(table.begin, table.end);
+    }
+  }
+  for (const auto& [key, table] : m_tables) {
+    // no precomputed tables without a readout
+    if (!table->readout().empty()) {
+      table->records(records[table->readout()]);
+    }
+  }
+  return Jug::Base::CellGeometryFile::write(filename, m_geoSvc->geometryHash(), std::move(records));
+}
@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef CELLGEOMETRYSVC_H
+#define CELLGEOMETRYSVC_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include "GaudiKernel/Service.h"
+
+#include "DD4hep/Detector.h"
+#include "DD4hep/VolumeManager.h"
+#include "DDRec/CellIDPositionConverter.h"
+
+#include "JugBase/CellGeometryFile.h"
+#include "JugBase/CellIDDecoder.h"
+#include "JugBase/ICellGeometrySvc.h"
+#include "JugBase/IGeoSvc.h"
+
+/** Geometry table of a readout, filled from DD4hep on the first lookup of each cell.
+ *
+ *  DD4hep does not provide an enumeration of the cells of a readout, so the table can only be
+ *  filled lazily. Lookups of cells in the table take a shared lock, new cells an exclusive one.
+ *  The global positions and dimensions of new cells are taken from the precomputed table of the
+ *  readout if it has them, from DD4hep otherwise.
+ */
+class DD4hepCellGeometryTable : public Jug::Base::CellGeometryTable {
+public:
+  DD4hepCellGeometryTable(const dd4hep::Detector& detector,
+                          std::shared_ptr<const dd4hep::rec::CellIDPositionConverter> converter,
+                          const Jug::Base::CellGeometrySpec& spec,
+                          const Jug::Base::CellGeometryFile::Table* precomputed = nullptr);
+
+  const Jug::Base::CellGeometry& geometry(CellID cellID) const override;
+  void geometry(const std::vector<CellID>& cellIDs,
+                std::vector<const Jug::Base::CellGeometry*>& geometries) const override;
+
+  size_t size() const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_table.size();
+  }
+  /// Number of cells that were not in the precomputed table
+  size_t computed() const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_computed;
+  }
+  const std::string& readout() const { return m_readout; }
+  /// Global positions and dimensions of the cells in the table
+  void records(std::vector<Jug::Base::CellGeometryFile::Record>& records) const;
+
+private:
+  Jug::Base::CellGeometry compute(CellID cellID) const;
+  // exclusive lock held by the caller
+  const Jug::Base::CellGeometry& insert(CellID cellID) const;
+
+  std::string m_readout;
+  std::shared_ptr<const dd4hep::rec::CellIDPositionConverter> m_converter;
+  const Jug::Base::CellGeometryFile::Table* m_precomputed;
+  dd4hep::VolumeManager m_volman;
+  // fixed local frame, otherwise looked up with the mask
+  dd4hep::DetElement m_local;
+  uint64_t m_localMask{~uint64_t(0)};
+  // compiled fields of the readout, shared with the algorithms
+  std::shared_ptr<const Jug::Base::CellIDDecoder> m_decoder;
+  int m_layerIdx{-1};
+  int m_sectorIdx{-1};
+
+  mutable std::shared_mutex m_mutex;
+  // node-based map, so that references to the entries stay valid when the table grows
+  mutable std::unordered_map<CellID, Jug::Base::CellGeometry> m_table;
+  mutable size_t m_computed{0};
+};
+
+/** Cell geometry service.
+ *
+ *  Provides cellID -> {global position, local position, dimension, layer, sector} tables for the
+ *  readouts in the geometry of GeoSvc, shared by the hit reconstruction algorithms that use the
+ *  same readout and local frame. The precomputed tables of GeoSvc are used when available, and the
+ *  tables can be written at finalize for the cellGeometryTables option of GeoSvc.
+ *
+ * \ingroup base
+ * \ingroup geosvc
+ */
+class CellGeometrySvc : public extends<Service, ICellGeometrySvc> {
+public:
+  CellGeometrySvc(const std::string& name, ISvcLocator* svc);
+
+  virtual ~CellGeometrySvc();
+
+  virtual StatusCode initialize() final;
+  virtual StatusCode finalize() final;
+
+  virtual const Jug::Base::CellGeometryTable* geometryTable(const Jug::Base::CellGeometrySpec& spec) override;
+
+private:
+  bool writeTables(const std::string& filename) const;
+
+  Gaudi::Property<std::string> m_geoSvcName{this, "geoServiceName", "GeoSvc"};
+  // precomputed tables written at finalize, with the cells of GeoSvc's tables and the cells used in the job
+  Gaudi::Property<std::string> m_outputFile{this, "outputTableFile", "", "Cell geometry tables output file"};
+
+  SmartIF<IGeoSvc> m_geoSvc;
+  std::mutex m_tablesMutex;
+  std::map<std::string, std::unique_ptr<DD4hepCellGeometryTable>> m_tables;
+};
+
+#endif // CELLGEOMETRYSVC_H
@@ -0,0 +1,211 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "CellNeighbourSvc.h"
+
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <string_view>
+
+#include "DDSegmentation/BitFieldCoder.h"
+#include "DDSegmentation/SegmentationParameter.h"
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(CellNeighbourSvc)
+
+namespace {
+// cache file layout: magic, version, number of tables, then per table the readout name, the
+// segmentation fingerprint and the (cellID, number of neighbours, neighbour cellIDs) entries
+constexpr uint64_t kCacheMagic   = 0x4e4c4c454347554a; // "JUGCELLN"
+constexpr uint32_t kCacheVersion = 2;
+
+// FNV-1a, with a separator so that the concatenated strings stay distinct
+void hash_append(uint64_t& h, std::string_view str) {
+  for (const char c : str) {
+    h = (h ^ static_cast<unsigned char>(c)) * 0x100000001B3ULL;
+  }
+  h = (h ^ 0xFFU) * 0x100000001B3ULL;
+}
+
+uint64_t segmentation_fingerprint(const dd4hep::Segmentation& segmentation) {
+  uint64_t h = 0xCBF29CE484222325ULL;
+  if (!segmentation.isValid()) {
+    return h;
+  }
+  hash_append(h, segmentation.type());
+  hash_append(h, segmentation.decoder()->fieldDescription());
+  for (const auto* par : segmentation.parameters()) {
+    hash_append(h, par->name());
+    hash_append(h, par->value());
+  }
+  return h;
+}
+
+template <typename T> void write_value(std::ostream& os, const T& value) {
+  os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+template <typename T> bool read_value(std::istream& is, T& value) {
+  return static_cast<bool>(is.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+} // namespace
+
+SegmentationNeighbourTable::SegmentationNeighbourTable(dd4hep::Segmentation segmentation)
+    : m_segmentation(segmentation), m_fingerprint(segmentation_fingerprint(segmentation)) {}
+
+const SegmentationNeighbourTable::Neighbours& SegmentationNeighbourTable::neighbours(CellID cellID) const {
+  {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    auto it = m_table.find(cellID);
+    if (it != m_table.end()) {
+      return it->second;
+    }
+  }
+  std::set<dd4hep::CellID> nbs;
+  m_segmentation.neighbours(cellID, nbs);
+  std::unique_lock<std::shared_mutex> lock(m_mutex);
+  // another thread may have added the cell in the meantime, emplace keeps its entry
+  const auto [it, inserted] = m_table.emplace(cellID, Neighbours(nbs.begin(), nbs.end()));
+  m_modified                = m_modified || inserted;
+  return it->second;
+}
+
+CellNeighbourSvc::CellNeighbourSvc(const std::string& name, ISvcLocator* svc) : base_class(name, svc) {}
+
+CellNeighbourSvc::~CellNeighbourSvc() = default;
+
+StatusCode CellNeighbourSvc::initialize() {
+  StatusCode sc = Service::initialize();
+  if (!sc.isSuccess()) {
+    return sc;
+  }
+  m_geoSvc = service(m_geoSvcName);
+  if (!m_geoSvc) {
+    error() << "Unable to locate Geometry Service. "
+            << "Make sure you have GeoSvc and SimSvc in the right order in the configuration." << endmsg;
+    return StatusCode::FAILURE;
+  }
+
+  if (!m_cacheFile.value().empty()) {
+    if (readCache(m_cacheFile.value())) {
+      for (const auto& [readout, table] : m_tables) {
+        info() << "Loaded " << table->table().size() << " cells for readout " << readout << " from "
+               << m_cacheFile.value() << endmsg;
+      }
+    } else {
+      info() << "No valid neighbour cache in " << m_cacheFile.value() << ", tables will be built on use" << endmsg;
+    }
+  }
+
+  for (const auto& readout : m_readouts.value()) {
+    if (neighbourTable(readout) == nullptr) {
+      error() << "Unknown readout " << readout << endmsg;
+      return StatusCode::FAILURE;
+    }
+  }
+  return StatusCode::SUCCESS;
+}
+
+StatusCode CellNeighbourSvc::finalize() {
+  const bool modified =
+      std::any_of(m_tables.begin(), m_tables.end(), [](const auto& t) { return t.second->modified(); });
+  if (!m_cacheFile.value().empty() && modified) {
+    if (writeCache(m_cacheFile.value())) {
+      info() << "Neighbour tables written to " << m_cacheFile.value() << endmsg;
+    } else {
+      warning() << "Failed to write neighbour tables to " << m_cacheFile.value() << endmsg;
+    }
+  }
+  m_tables.clear();
+  return Service::finalize();
+}
+
+const Jug::Base::CellNeighbourTable* CellNeighbourSvc::neighbourTable(const std::string& readout) {
+  return findOrCreateTable(readout);
+}
+
+SegmentationNeighbourTable* CellNeighbourSvc::findOrCreateTable(const std::string& readout) {
+  std::lock_guard<std::mutex> lock(m_tablesMutex);
+  auto it = m_tables.find(readout);
+  if (it != m_tables.end()) {
+    return it->second.get();
+  }
+  try {
+    auto segmentation = m_geoSvc->detector()->readout(readout).segmentation();
+    auto table        = std::make_unique<SegmentationNeighbourTable>(segmentation);
+    debug() << "Created neighbour table for readout " << readout << endmsg;
+    return m_tables.emplace(readout, std::move(table)).first->second.get();
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+bool CellNeighbourSvc::readCache(const std::string& filename) {
+  std::ifstream is(filename, std::ios::binary);
+  uint64_t magic   = 0;
+  uint32_t version = 0;
+  uint32_t ntables = 0;
+  if (!is || !read_value(is, magic) || magic != kCacheMagic || !read_value(is, version) ||
+      version != kCacheVersion || !read_value(is, ntables)) {
+    return false;
+  }
+  for (uint32_t t = 0; t < ntables; ++t) {
+    uint32_t nchars = 0;
+    if (!read_value(is, nchars)) {
+      return false;
+    }
+    std::string readout(nchars, '\0');
+    uint64_t fingerprint = 0;
+    uint64_t ncells      = 0;
+    if (!is.read(readout.data(), nchars) || !read_value(is, fingerprint) || !read_value(is, ncells)) {
+      return false;
+    }
+    // readouts that are not in the current geometry, or with another segmentation, are read but
+    // not kept: their tables are rebuilt on use
+    auto* table = findOrCreateTable(readout);
+    if (table == nullptr) {
+      warning() << "Readout " << readout << " in " << filename << " is not in the geometry, ignored" << endmsg;
+    } else if (table->fingerprint() != fingerprint) {
+      info() << "Segmentation of readout " << readout << " changed since " << filename
+             << " was written, its neighbour table will be rebuilt" << endmsg;
+      table = nullptr;
+    }
+    for (uint64_t c = 0; c < ncells; ++c) {
+      uint64_t cellID = 0;
+      uint32_t nnbs   = 0;
+      if (!read_value(is, cellID) || !read_value(is, nnbs)) {
+        return false;
+      }
+      Jug::Base::CellNeighbourTable::Neighbours nbs(nnbs);
+      if (!is.read(reinterpret_cast<char*>(nbs.data()), nnbs * sizeof(uint64_t))) {
+        return false;
+      }
+      if (table != nullptr) {
+        table->insert(cellID, std::move(nbs));
+      }
+    }
+  }
+  return true;
+}
+
+bool CellNeighbourSvc::writeCache(const std::string& filename) const {
+  std::ofstream os(filename, std::ios::binary | std::ios::trunc);
+  if (!os) {
+    return false;
+  }
+  write_value(os, kCacheMagic);
+  write_value(os, kCacheVersion);
+  write_value(os, static_cast<uint32_t>(m_tables.size()));
+  for (const auto& [readout, table] : m_tables) {
+    write_value(os, static_cast<uint32_t>(readout.size()));
+    os.write(readout.data(), readout.size());
+    write_value(os, table->fingerprint());
+    write_value(os, static_cast<uint64_t>(table->table().size()));
+    for (const auto& [cellID, nbs] : table->table()) {
+      write_value(os, cellID);
+      write_value(os, static_cast<uint32_t>(nbs.size()));
+      os.write(reinterpret_cast<const char*>(nbs.data()), nbs.size() * sizeof(uint64_t));
+    }
+  }
+  return static_cast<bool>(os);
+}
@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef CELLNEIGHBOURSVC_H
+#define CELLNEIGHBOURSVC_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include "GaudiKernel/Service.h"
+
+#include "DD4hep/Detector.h"
+
+#include "JugBase/ICellNeighbourSvc.h"
+#include "JugBase/IGeoSvc.h"
+
+/** Neighbour table of a readout, using the neighbours of the DD4hep segmentation.
+ *
+ *  The segmentation is queried once per cell, on the first lookup of that cell (DD4hep does not
+ *  provide an enumeration of the cells of a readout). Tables can be restored from and saved to a
+ *  cache file by the service, so that no segmentation queries are needed in later jobs.
+ *  Note that cells without segmentation (NoSegmentation readouts) have no neighbours.
+ *  The fingerprint of the segmentation (its type, parameters and cellID fields) is stored with the
+ *  table in the cache, so that the tables of a changed segmentation are rebuilt.
+ *  Lookups of cells in the table take a shared lock, new cells an exclusive one, so that the
+ *  algorithms of concurrent chains can share a table.
+ */
+class SegmentationNeighbourTable : public Jug::Base::CellNeighbourTable {
+public:
+  explicit SegmentationNeighbourTable(dd4hep::Segmentation segmentation);
+
+  const Neighbours& neighbours(CellID cellID) const override;
+
+  /// Add the neighbours of a cell, e.g. from a cache file
+  void insert(CellID cellID, Neighbours neighbours) {
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    m_table.insert_or_assign(cellID, std::move(neighbours));
+  }
+  /// The cells of the table, not to be used while other threads look up new cells
+  const std::unordered_map<CellID, Neighbours>& table() const { return m_table; }
+  /// Hash of the segmentation type, parameters and cellID fields
+  uint64_t fingerprint() const { return m_fingerprint; }
+  bool modified() const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_modified;
+  }
+
+private:
+  dd4hep::Segmentation m_segmentation;
+  uint64_t m_fingerprint;
+  mutable std::shared_mutex m_mutex;
+  // node-based map, so that references to the neighbours stay valid when the table grows
+  mutable std::unordered_map<CellID, Neighbours> m_table;
+  mutable bool m_modified{false};
+};
+
+/** Cell neighbour service.
+ *
+ *  Provides cellID -> neighbour cellIDs lookup tables for the readouts in the geometry of GeoSvc,
+ *  so that clustering algorithms do not need to compute the distances between hits to decide
+ *  whether they are adjacent. Tables are filled from the readout segmentation on first use
+ *  (thread-safe), and optionally persisted in the cache file at finalize.
+ *
+ * \ingroup base
+ * \ingroup geosvc
+ */
+class CellNeighbourSvc : public extends<Service, ICellNeighbourSvc> {
+public:
+  CellNeighbourSvc(const std::string& name, ISvcLocator* svc);
+
+  virtual ~CellNeighbourSvc();
+
+  virtual StatusCode initialize() final;
+  virtual StatusCode finalize() final;
+
+  virtual const Jug::Base::CellNeighbourTable* neighbourTable(const std::string& readout) override;
+
+private:
+  SegmentationNeighbourTable* findOrCreateTable(const std::string& readout);
+  bool readCache(const std::string& filename);
+  bool writeCache(const std::string& filename) const;
+
+  Gaudi::Property<std::string> m_geoSvcName{this, "geoServiceName", "GeoSvc"};
+  // binary cache file with the neighbour tables, read at initialize and updated at finalize
+  Gaudi::Property<std::string> m_cacheFile{this, "cacheFile", "", "Neighbour table cache file"};
+  // neighbour tables created at initialize (others are created on request)
+  Gaudi::Property<std::vector<std::string>> m_readouts{this, "readouts", {}, "Readouts to prepare at initialize"};
+
+  SmartIF<IGeoSvc> m_geoSvc;
+  std::mutex m_tablesMutex;
+  std::map<std::string, std::unique_ptr<SegmentationNeighbourTable>> m_tables;
+};
+
+#endif // CELLNEIGHBOURSVC_H
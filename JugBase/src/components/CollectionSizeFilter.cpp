@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include <string>
+
+#include "Gaudi/Property.h"
+#include "GaudiAlg/GaudiAlgorithm.h"
+#include "GaudiKernel/DataObject.h"
+#include "GaudiKernel/DataObjectHandle.h"
+
+#include "JugBase/DataHandleArray.h"
+#include "JugBase/DataWrapper.h"
+#include "JugBase/EventFilter.h"
+
+namespace Jug::Base {
+
+/** Filter on the number of elements of collections.
+ *
+ *  Passes the events where the input collections hold at least minSize elements in total, and
+ *  rejects the others (filter decision), so that a sequence with ShortCircuit placed after it
+ *  (e.g. the track seeding and finding, or the ring clustering) only runs on the events with
+ *  enough inputs. The inputs can be collections of any type.
+ *
+ *  \ingroup base
+ */
+class CollectionSizeFilter : public GaudiAlgorithm {
+private:
+  DataHandleArray<DataObject, DataObjectHandle<DataObject>> m_inputCollections{this, "inputCollections",
+                                                                               "Collections to count"};
+  Gaudi::Property<size_t> m_minSize{this, "minSize", 1, "Minimum total number of elements of the inputs"};
+
+public:
+  CollectionSizeFilter(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {}
+
+  StatusCode initialize() override {
+    if (GaudiAlgorithm::initialize().isFailure()) {
+      return StatusCode::FAILURE;
+    }
+    if (m_inputCollections.empty()) {
+      error() << "No inputCollections to count" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    return StatusCode::SUCCESS;
+  }
+
+  StatusCode execute() override {
+    size_t size = 0;
+    for (const auto* object : m_inputCollections.get()) {
+      // const_cast: collectionBase is not const, the collection is only read
+      auto* wrapper = dynamic_cast<DataWrapperBase*>(const_cast<DataObject*>(object));
+      if (wrapper == nullptr || wrapper->collectionBase() == nullptr) {
+        error() << "Input of " << name() << " is not a collection" << endmsg;
+        return StatusCode::FAILURE;
+      }
+      size += wrapper->collectionBase()->size();
+      if (size >= m_minSize.value()) {
+        return StatusCode::SUCCESS;
+      }
+    }
+    return rejectEvent(*this, "not enough elements in the input collections");
+  }
+};
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(CollectionSizeFilter)
+
+} // namespace Jug::Base
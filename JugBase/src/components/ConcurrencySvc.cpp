@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "ConcurrencySvc.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include <sched.h>
+
+#include <tbb/info.h>
+#include <tbb/parallel_for.h>
+
+#include "JugBase/Instrumentation.h"
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(ConcurrencySvc)
+
+namespace {
+  // affinity of a worker before it was pinned, restored when it leaves the arena
+  thread_local cpu_set_t s_savedAffinity;
+  thread_local bool s_pinned = false;
+} // namespace
+
+ConcurrencySvc::ConcurrencySvc(const std::string& name, ISvcLocator* svc) : base_class(name, svc) {}
+
+ConcurrencySvc::~ConcurrencySvc() = default;
+
+StatusCode ConcurrencySvc::initialize() {
+  StatusCode sc = Service::initialize();
+  if (!sc.isSuccess()) {
+    fatal() << "Error initializing ConcurrencySvc" << endmsg;
+    return sc;
+  }
+  tbb::task_arena::constraints constraints;
+  constraints.set_max_concurrency(m_numThreads.value() > 0 ? m_numThreads.value() : tbb::task_arena::automatic);
+  if (m_numaNode.value() >= 0) {
+    const auto nodes = tbb::info::numa_nodes();
+    if (std::find(nodes.begin(), nodes.end(), m_numaNode.value()) == nodes.end()) {
+      error() << "NUMA node " << m_numaNode.value() << " not found, is TBB built with hwloc (tbbbind)?" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    constraints.set_numa_id(m_numaNode.value());
+  }
+  if (m_threadsPerCore.value() > 0) {
+    constraints.set_max_threads_per_core(m_threadsPerCore.value());
+  }
+  m_arena.initialize(constraints);
+  if (!m_cpuList.value().empty()) {
+    m_pinning = std::make_unique<Pinning>(m_arena, m_cpuList.value());
+    m_pinning->observe(true);
+  }
+  info() << "Shared task arena of " << m_arena.max_concurrency() << " threads"
+         << (m_numaNode.value() >= 0 ? " on NUMA node " + std::to_string(m_numaNode.value()) : std::string())
+         << (m_pinning ? " pinned to " + std::to_string(m_cpuList.value().size()) + " CPUs" : std::string())
+         << endmsg;
+  return StatusCode::SUCCESS;
+}
+
+StatusCode ConcurrencySvc::finalize() {
+  if (m_pinning) {
+    m_pinning->observe(false);
+    m_pinning.reset();
+  }
+  m_arena.terminate();
+  return Service::finalize();
+}
+
+void ConcurrencySvc::parallelFor(size_t ntasks, const std::function<void(size_t)>& task) {
+  if (ntasks == 0) {
+    return;
+  }
+  // the busy time is only taken for the instrumented algorithms
+  auto* record = Jug::Base::currentExecuteRecord();
+  if (record == nullptr) {
+    m_arena.execute([&] { tbb::parallel_for(size_t(0), ntasks, [&](size_t i) { task(i); }); });
+    return;
+  }
+  using clock = std::chrono::steady_clock;
+  std::atomic<int64_t> busy{0};
+  const auto start = clock::now();
+  m_arena.execute([&] {
+    tbb::parallel_for(size_t(0), ntasks, [&](size_t i) {
+      const auto begin = clock::now();
+      task(i);
+      busy.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - begin).count(),
+                     std::memory_order_relaxed);
+    });
+  });
+  const double wall = std::chrono::duration<double>(clock::now() - start).count();
+  const auto usable = std::min<size_t>(ntasks, static_cast<size_t>(m_arena.max_concurrency()));
+  record->parallelWall += wall;
+  record->parallelBusy += 1e-9 * static_cast<double>(busy.load());
+  record->parallelCapacity += wall * static_cast<double>(usable);
+}
+
+void ConcurrencySvc::Pinning::on_scheduler_entry(bool worker) {
+  if (!worker || m_cpus.empty()) {
+    return;
+  }
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(m_cpus[m_next.fetch_add(1, std::memory_order_relaxed) % m_cpus.size()], &cpus);
+  s_pinned = sched_getaffinity(0, sizeof(s_savedAffinity), &s_savedAffinity) == 0 &&
+             sched_setaffinity(0, sizeof(cpus), &cpus) == 0;
+}
+
+void ConcurrencySvc::Pinning::on_scheduler_exit(bool worker) {
+  if (worker && s_pinned) {
+    sched_setaffinity(0, sizeof(s_savedAffinity), &s_savedAffinity);
+    s_pinned = false;
+  }
+}
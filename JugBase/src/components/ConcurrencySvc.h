@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef CONCURRENCYSVC_H
+#define CONCURRENCYSVC_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <tbb/task_arena.h>
+#include <tbb/task_scheduler_observer.h>
+
+#include "Gaudi/Property.h"
+#include "GaudiKernel/Service.h"
+
+#include "JugBase/IConcurrencySvc.h"
+
+/** Shared task arena of the intra-event parallelism.
+ *
+ *  One arena of numThreads threads (0: all) for all the parallel algorithms of the job. With
+ *  Hive, give the arena the cores that the event slots leave free, e.g. 64 cores with 16 event
+ *  threads: numThreads = 48. The arena can be constrained to a NUMA node (numaNode) and to one
+ *  thread per core (threadsPerCore = 1), which needs TBB with hwloc support (tbbbind). With
+ *  cpuList, the worker threads are pinned to these CPUs while they work in the arena.
+ */
+class ConcurrencySvc : public extends<Service, IConcurrencySvc> {
+public:
+  ConcurrencySvc(const std::string& name, ISvcLocator* svc);
+  virtual ~ConcurrencySvc();
+
+  virtual StatusCode initialize() final;
+  virtual StatusCode finalize() final;
+
+  virtual int concurrency() const { return m_arena.max_concurrency(); }
+  virtual void parallelFor(size_t ntasks, const std::function<void(size_t)>& task);
+
+private:
+  /// Pins the worker threads entering the arena to the CPUs, round robin
+  class Pinning : public tbb::task_scheduler_observer {
+  public:
+    Pinning(tbb::task_arena& arena, std::vector<int> cpus)
+        : tbb::task_scheduler_observer(arena), m_cpus(std::move(cpus)) {}
+    void on_scheduler_entry(bool worker) override;
+    void on_scheduler_exit(bool worker) override;
+
+  private:
+    std::vector<int> m_cpus;
+    std::atomic<size_t> m_next{0};
+  };
+
+  Gaudi::Property<int> m_numThreads{this, "numThreads", 0, "Threads of the arena (0: all)"};
+  Gaudi::Property<int> m_numaNode{this, "numaNode", -1, "NUMA node of the arena (-1: any)"};
+  Gaudi::Property<int> m_threadsPerCore{this, "threadsPerCore", -1, "Threads per core (-1: any)"};
+  Gaudi::Property<std::vector<int>> m_cpuList{this, "cpuList", {}, "CPUs the workers are pinned to (none if empty)"};
+
+  tbb::task_arena m_arena;
+  std::unique_ptr<Pinning> m_pinning;
+};
+
+#endif
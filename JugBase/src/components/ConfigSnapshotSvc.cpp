@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "ConfigSnapshotSvc.h"
+
+#include "GaudiKernel/IEventProcessor.h"
+
+#include "JugBase/ConfigSnapshot.h"
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(ConfigSnapshotSvc)
+
+ConfigSnapshotSvc::ConfigSnapshotSvc(const std::string& name, ISvcLocator* svc) : Service(name, svc) {}
+
+ConfigSnapshotSvc::~ConfigSnapshotSvc() = default;
+
+StatusCode ConfigSnapshotSvc::start() {
+  StatusCode sc = Service::start();
+  if (!sc.isSuccess() || m_output.value().empty()) {
+    return sc;
+  }
+  auto snapshot = Jug::Base::configSnapshot(*serviceLocator());
+  // the job started from the snapshot runs instead of writing it
+  snapshot[name() + ".output"]            = "\"\"";
+  snapshot[name() + ".stopAfterSnapshot"] = "False";
+  if (!Jug::Base::writeConfigSnapshot(m_output.value(), snapshot)) {
+    error() << "Cannot write the configuration snapshot " << m_output.value() << endmsg;
+    return StatusCode::FAILURE;
+  }
+  info() << "Wrote the " << snapshot.size() << " options of the configuration to " << m_output.value() << endmsg;
+  if (m_stop.value()) {
+    return service<IEventProcessor>("ApplicationMgr")->stopRun();
+  }
+  return StatusCode::SUCCESS;
+}
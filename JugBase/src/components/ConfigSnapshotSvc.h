@@ -0,0 +1,34 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef CONFIGSNAPSHOTSVC_H
+#define CONFIGSNAPSHOTSVC_H
+
+#include <string>
+
+#include "Gaudi/Property.h"
+#include "GaudiKernel/Service.h"
+
+/** Writes the resolved configuration of the job to a job options file.
+ *
+ *  At start, once all the components are created and configured, the options are written as a
+ *  snapshot (see Jug::Base::configSnapshot) that starts the same job without the Python
+ *  configurables: `Gaudi.exe job.opts`. With stopAfterSnapshot (or EvtMax 0), the job only writes
+ *  the snapshot. The snapshot does not write a snapshot again.
+ *
+ * \ingroup base
+ */
+class ConfigSnapshotSvc : public Service {
+public:
+  ConfigSnapshotSvc(const std::string& name, ISvcLocator* svc);
+
+  virtual ~ConfigSnapshotSvc();
+
+  virtual StatusCode start() final;
+
+private:
+  Gaudi::Property<std::string> m_output{this, "output", "", "Job options file of the snapshot, none if empty"};
+  Gaudi::Property<bool> m_stop{this, "stopAfterSnapshot", false, "Process no events after writing the snapshot"};
+};
+
+#endif // CONFIGSNAPSHOTSVC_H
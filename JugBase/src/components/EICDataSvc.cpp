@@ -12,6 +12,35 @@ DECLARE_COMPONENT(EICDataSvc)
 EICDataSvc::EICDataSvc(const std::string& name, ISvcLocator* svc) : PodioDataSvc(name, svc) {
   declareProperty("inputs", m_filenames = {}, "Names of the files to read");
   declareProperty("input", m_filename = "", "Name of the file to read");
+  declareProperty("FirstEventEntry", m_1stEvtEntry = 0, "First entry of the event range");
+  declareProperty("LastEventEntry", m_lastEvtEntry = -1, "End (exclusive) of the event range, end of input if negative");
+  declareProperty("eventList", m_eventList = {},
+                  "Entries to read instead of the event range, '<entry>' or '<file index or name>:<entry>'");
+  declareProperty("eventListFile", m_eventListFile = "", "File with the entries of eventList, one per line");
+  declareProperty("Shard", m_shard = 0, "Shard of the event range to read");
+  declareProperty("NumShards", m_nShards = 1, "Number of shards the event range is split into");
+  declareProperty("InterleavedShards", m_interleavedShards = false,
+                  "Shards of every n-th event instead of contiguous blocks");
+  declareProperty("useEventArena", m_useEventArena = false, "Create the event collections in a reused arena");
+  declareProperty("recycleCollections", m_recycleCollections = false,
+                  "Keep the event collections and their capacity for the next events");
+  declareProperty("adaptiveReserve", m_adaptiveReserve = false,
+                  "Reserve the largest size of the previous events when creating a collection");
+  declareProperty("flatStore", m_flatStore = false,
+                  "Keep the event collections in a flat store by key instead of the Gaudi registry");
+  declareProperty("readCacheSize", m_readCacheSize = -1,
+                  "Size of the input TTreeCache in bytes, ROOT default if negative, off if 0");
+  declareProperty("readCacheLearnEntries", m_readCacheLearnEntries = 0,
+                  "Number of entries of the TTreeCache learning phase, ROOT default if 0");
+  declareProperty("asyncPrefetching", m_asyncPrefetching = false, "Prefetch the cached input baskets asynchronously");
+  declareProperty("readAhead", m_readAhead = 0,
+                  "Number of events read and unpacked ahead on a background thread, off if 0");
+  declareProperty("readAheadMaxBytes", m_readAheadMaxBytes = 0,
+                  "Bytes of the unpacked events read ahead, no limit if 0 (at least one event is read ahead)");
+  declareProperty("memoryAccounting", m_memoryAccounting = false,
+                  "Report the peak bytes of the collections per collection and per algorithm at finalize");
+  declareProperty("maxEventBytes", m_maxEventBytes = 0,
+                  "Events with collections of more bytes are not written, no limit if 0");
 }
 
 /// Standard Destructor
@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "ForkSvc.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <string_view>
+
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Gaudi/Interfaces/IOptionsSvc.h"
+#include "GaudiKernel/IDataProviderSvc.h"
+
+#include "JugBase/PodioDataSvc.h"
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(ForkSvc)
+
+namespace {
+
+// Writers that open their output before the fork (one file shared by all the processes) or
+// write fixed paths from every worker
+constexpr std::string_view unforkableWriters[] = {"PodioOutputRNTuple", "PodioOutputParquet"};
+
+// Whether an option value (e.g. ApplicationMgr.TopAlg or the Members of a sequencer) lists a
+// component of the type, as 'Type/Name' or 'Type'
+bool listsType(const std::string& value, std::string_view type) {
+  for (size_t pos = value.find(type); pos != std::string::npos; pos = value.find(type, pos + 1)) {
+    const char before = (pos > 0) ? value[pos - 1] : '\0';
+    const char after  = (pos + type.size() < value.size()) ? value[pos + type.size()] : '\0';
+    if ((before == '\'' || before == '"') && (after == '/' || after == before)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace
+
+ForkSvc::ForkSvc(const std::string& name, ISvcLocator* svc) : Service(name, svc) {}
+
+ForkSvc::~ForkSvc() = default;
+
+StatusCode ForkSvc::initialize() {
+  StatusCode sc = Service::initialize();
+  if (!sc.isSuccess()) {
+    return sc;
+  }
+  if (m_workers.value() > 1) {
+    for (const auto& [name, value] : serviceLocator()->getOptsSvc().items()) {
+      for (const auto type : unforkableWriters) {
+        if (listsType(value, type)) {
+          error() << "The forked workers cannot write with " << type << " (in " << name
+                  << "), use PodioOutput" << endmsg;
+          return StatusCode::FAILURE;
+        }
+      }
+    }
+  }
+  info() << "ForkSvc initialized with " << m_workers.value() << " workers" << endmsg;
+  return StatusCode::SUCCESS;
+}
+
+StatusCode ForkSvc::start() {
+  StatusCode sc = Service::start();
+  if (!sc.isSuccess() || m_workers.value() <= 1) {
+    return sc;
+  }
+  const unsigned workers = m_workers.value();
+  // the sequential store, the slots of a PodioHiveWhiteBoard share their reader
+  auto* store = dynamic_cast<PodioDataSvc*>(service<IDataProviderSvc>("EventDataSvc").get());
+  if (store == nullptr || !store->readsInput()) {
+    error() << "The workers need an EICDataSvc reading an input" << endmsg;
+    return StatusCode::FAILURE;
+  }
+  const auto threads = std::distance(std::filesystem::directory_iterator("/proc/self/task"),
+                                     std::filesystem::directory_iterator{});
+  if (threads > 1) {
+    warning() << "Forking a process with " << threads << " threads, only this thread runs in the workers" << endmsg;
+  }
+
+  // the buffered output would be written by every worker
+  std::cout.flush();
+  std::cerr.flush();
+  std::fflush(nullptr);
+  const pid_t parent = getpid();
+  for (unsigned worker = 0; worker < workers; ++worker) {
+    const pid_t pid = fork();
+    if (pid < 0) {
+      error() << "Cannot fork worker " << worker << ": " << std::strerror(errno) << endmsg;
+      for (const pid_t started : m_pids) {
+        kill(started, SIGTERM);
+      }
+      waitForWorkers();
+      return StatusCode::FAILURE;
+    }
+    if (pid == 0) {
+      // terminated with the parent, also if it exited before the signal was set
+      prctl(PR_SET_PDEATHSIG, SIGTERM);
+      if (getppid() != parent) {
+        _exit(EXIT_FAILURE);
+      }
+      m_pids.clear();
+      info() << "Worker " << worker << " of " << workers << " (pid " << getpid() << ")" << endmsg;
+      return store->selectWorker(static_cast<int>(worker), workers);
+    }
+    m_pids.push_back(pid);
+  }
+
+  // the parent processes no events, the outputs are merged at finalize
+  info() << "Forked " << workers << " workers, waiting for them" << endmsg;
+  if (!waitForWorkers()) {
+    error() << "Workers failed, their outputs are not merged" << endmsg;
+    return StatusCode::FAILURE;
+  }
+  // no events in the parent, its store stops the run before the first one
+  return store->selectWorker(-1, workers);
+}
+
+StatusCode ForkSvc::finalize() {
+  // workers left by a failed start
+  waitForWorkers();
+  return Service::finalize();
+}
+
+bool ForkSvc::waitForWorkers() {
+  bool succeeded = true;
+  for (size_t worker = 0; worker < m_pids.size(); ++worker) {
+    int status = 0;
+    while (waitpid(m_pids[worker], &status, 0) < 0 && errno == EINTR) {
+    }
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+      continue;
+    }
+    succeeded = false;
+    if (WIFSIGNALED(status)) {
+      error() << "Worker " << worker << " terminated by signal " << WTERMSIG(status) << endmsg;
+    } else {
+      error() << "Worker " << worker << " failed with exit status " << WEXITSTATUS(status) << endmsg;
+    }
+  }
+  m_pids.clear();
+  return succeeded;
+}
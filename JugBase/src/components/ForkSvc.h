@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef FORKSVC_H
+#define FORKSVC_H
+
+#include <sys/types.h>
+#include <vector>
+
+#include "Gaudi/Property.h"
+#include "GaudiKernel/Service.h"
+
+/** Multi-process mode: forks workers after the initialization.
+ *
+ *  At start, after all the services and algorithms are initialized, the job forks into workers
+ *  that share the pages of the geometry (DD4hep, TGeo, ACTS with the material and the field) and
+ *  of the other initialized state copy-on-write, instead of every process paying the
+ *  initialization and holding its own copy. Every worker reads a shard of the input (of the shard
+ *  of the job, see EICDataSvc Shard and NumShards) from its own reopened input and writes the
+ *  output of that shard (PodioOutput opens its file at start). The parent processes no events: it
+ *  waits for the workers and merges their outputs at finalize, the job fails if a worker fails.
+ *  PodioOutputRNTuple and PodioOutputParquet open their outputs before the fork, or write the same
+ *  paths from every worker: initialize fails if either is configured.
+ *
+ *  For the sequential event loop with EICDataSvc: the process must not have other threads when it
+ *  forks (only the forking thread is copied), e.g. no ROOT implicit multithreading at initialize.
+ *  Workers are terminated when the parent exits.
+ *
+ * \ingroup base
+ */
+class ForkSvc : public Service {
+public:
+  ForkSvc(const std::string& name, ISvcLocator* svc);
+
+  virtual ~ForkSvc();
+
+  virtual StatusCode initialize() final;
+  virtual StatusCode start() final;
+  virtual StatusCode finalize() final;
+
+private:
+  Gaudi::Property<unsigned> m_workers{this, "workers", 0, "Number of forked worker processes, none if 0 or 1"};
+
+  /// Wait for the workers, false if any of them failed
+  bool waitForWorkers();
+
+  std::vector<pid_t> m_pids;
+};
+
+#endif // FORKSVC_H
@@ -8,8 +8,18 @@
 
 #include "DD4hep/Printout.h"
 
+#include <nlohmann/json.hpp>
+
+#include <cstdio>
+#include <sstream>
+#include <unistd.h>
+
 #include "JugBase/ACTSLogger.h"
+#include "JugBase/Acts/CoarseMaterialDecorator.hpp"
 #include "JugBase/Acts/MaterialWiper.hpp"
+#include "JugBase/BField/GenFitBField.h"
+#include "JugBase/Logging.h"
+#include "JugBase/Utilities/Paths.hpp"
 
 #include "Acts/Geometry/TrackingGeometry.hpp"
 #include "Acts/Plugins/DD4hep/ConvertDD4hepDetector.hpp"
@@ -32,6 +42,9 @@
 #include "TGeoMaterialInterface.h"
 #include "PlanarMeasurement.h"
 
+// increased when the cache files change meaning, so that the old ones are not used
+static constexpr int kMaterialsCacheVersion = 1;
+
 static const std::map<int, Acts::Logging::Level> s_msgMap = {
     {MSG::DEBUG, Acts::Logging::DEBUG},
     {MSG::VERBOSE, Acts::Logging::VERBOSE},
@@ -113,29 +126,9 @@ StatusCode GeoSvc::initialize() {
     m_log << MSG::INFO << "DD4Hep geometry SUCCESSFULLY built" << endmsg;
   }
 
-  // Genfit
-  genfit::FieldManager::getInstance()->init(new genfit::ConstField(
-      0., 0., this->centralMagneticField() * 10.0)); // gentfit uses kilo-Gauss
+  // Genfit, the field is set up with the field model below
   genfit::MaterialEffects::getInstance()->init(new genfit::TGeoMaterialInterface());
 
-  // create a list of all surfaces in the detector:
-  dd4hep::rec::SurfaceManager surfMan( *m_dd4hepGeo ) ;
-  debug() << " surface manager " << endmsg;
-  const auto* const sM = surfMan.map("tracker") ;
-  if (sM != nullptr) {
-    debug() << " surface map  size: " << sM->size() << endmsg;
-    // setup  dd4hep surface map
-    //for( dd4hep::rec::SurfaceMap::const_iterator it = sM->begin() ; it != sM->end() ; ++it ){
-    for( const auto& [id, s] :   *sM) {
-      //dd4hep::rec::Surface* surf = s ;
-      m_surfaceMap[ id ] = dynamic_cast<dd4hep::rec::Surface*>(s) ;
-      debug() << " surface : " << *s << endmsg;
-      m_detPlaneMap[id] = std::shared_ptr<genfit::DetPlane>(
-          new genfit::DetPlane({s->origin().x(), s->origin().y(), s->origin().z()}, {s->u().x(), s->u().y(), s->u().z()},
-                               {s->v().x(), s->v().y(), s->v().z()}));
-    }
-  }
-
   // Set ACTS logging level
   auto im = s_msgMap.find(msgLevel());
   if (im != s_msgMap.end()) {
@@ -144,17 +137,196 @@ StatusCode GeoSvc::initialize() {
 
   // Load ACTS materials maps
   if (m_jsonFileName.size() > 0) {
-    m_log << MSG::INFO << "loading materials map from file:  '" << m_jsonFileName << "'" << endmsg;
+    const auto materials = materialsFile();
+    m_log << MSG::INFO << "loading materials map from file:  '" << materials << "'" << endmsg;
     // Set up the converter first
     Acts::MaterialMapJsonConverter::Config jsonGeoConvConfig;
     // Set up the json-based decorator
     m_materialDeco = std::make_shared<const Acts::JsonMaterialDecorator>(
-      jsonGeoConvConfig, m_jsonFileName, m_actsLoggingLevel);
+      jsonGeoConvConfig, materials, m_actsLoggingLevel);
+    if (!m_materialBins.value().empty()) {
+      if (m_materialBins.value().size() != 2) {
+        error() << "materialBins needs the bins of loc0 and loc1" << endmsg;
+        return StatusCode::FAILURE;
+      }
+      m_log << MSG::INFO << "surface material rebinned to " << m_materialBins.value()[0] << " x "
+            << m_materialBins.value()[1] << " bins" << endmsg;
+      m_materialDeco = std::make_shared<const Jug::Base::CoarseMaterialDecorator>(
+          m_materialDeco, std::array<size_t, 2>{m_materialBins.value()[0], m_materialBins.value()[1]});
+    }
   } else {
     m_log << MSG::WARNING << "no ACTS materials map has been loaded" << endmsg;
     m_materialDeco = std::make_shared<const Acts::MaterialWiper>();
   }
 
+  // Load ACTS magnetic field
+  m_magneticField = std::make_shared<const Jug::BField::DD4hepBField>(m_dd4hepGeo);
+  Acts::MagneticFieldContext m_fieldctx{Jug::BField::BFieldVariant(m_magneticField)};
+  auto bCache = m_magneticField->makeCache(m_fieldctx);
+  for (int z : {0, 1000, 2000, 4000}) {
+    auto b = m_magneticField->getField({0.0, 0.0, double(z)}, bCache).value();
+    debug() << "B(z=" << z << " mm) = " << b.transpose()  << " T" << endmsg;
+  }
+  if (buildFieldMap().isFailure()) {
+    return StatusCode::FAILURE;
+  }
+  initGenFitField();
+
+  return StatusCode::SUCCESS;
+}
+
+StatusCode GeoSvc::finalize() { return StatusCode::SUCCESS; }
+
+StatusCode GeoSvc::buildDD4HepGeo() {
+  // we retrieve the the static instance of the DD4HEP::Geometry
+  m_dd4hepGeo = &(dd4hep::Detector::getInstance());
+  m_dd4hepGeo->addExtension<IGeoSvc>(this);
+
+  // load geometry
+  for (auto& filename : m_xmlFileNames) {
+    m_log << MSG::INFO << "loading geometry from file:  '" << filename << "'" << endmsg;
+    m_dd4hepGeo->fromCompact(filename);
+  }
+  m_dd4hepGeo->volumeManager();
+  m_dd4hepGeo->apply("DD4hepVolumeManager", 0, nullptr);
+  m_cellid_converter = std::make_shared<const dd4hep::rec::CellIDPositionConverter>(*m_dd4hepGeo);
+
+  m_geometryHash = Jug::Base::geometryHash(*m_dd4hepGeo, m_xmlFileNames.value());
+  m_log << MSG::DEBUG << "geometry hash " << std::hex << m_geometryHash << std::dec << endmsg;
+  if (!m_cellGeometryFileName.value().empty()) {
+    auto tables = std::make_unique<Jug::Base::CellGeometryFile>();
+    if (!tables->open(m_cellGeometryFileName.value())) {
+      m_log << MSG::WARNING << "no valid cell geometry tables in '" << m_cellGeometryFileName.value() << "'" << endmsg;
+    } else if (tables->geometryHash() != m_geometryHash) {
+      // made for another geometry, the cells would be misplaced
+      m_log << MSG::WARNING << "cell geometry tables in '" << m_cellGeometryFileName.value()
+            << "' are for a different geometry, ignored" << endmsg;
+    } else {
+      for (const auto& [readout, table] : tables->tables()) {
+        m_log << MSG::INFO << "mapped " << table.size() << " cells for readout " << readout << endmsg;
+      }
+      m_cellGeometryFile = std::move(tables);
+    }
+  }
+  return StatusCode::SUCCESS;
+}
+
+StatusCode GeoSvc::buildFieldMap() {
+  using Jug::BField::GridBField;
+  const auto& model = m_fieldModel.value();
+  m_field           = m_magneticField;
+  m_fieldProvider   = m_magneticField;
+  if (model == "dd4hep") {
+    return StatusCode::SUCCESS;
+  }
+  if (model == "constant") {
+    Acts::Vector3 b;
+    if (m_constantField.value().empty()) {
+      auto cache = m_magneticField->makeCache(Acts::MagneticFieldContext{});
+      b          = m_magneticField->getField({0., 0., 0.}, cache).value();
+    } else if (m_constantField.value().size() == 3) {
+      b = {m_constantField.value()[0], m_constantField.value()[1], m_constantField.value()[2]};
+    } else {
+      error() << "constantField needs [Bx, By, Bz]" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    info() << "Constant field B = " << b.transpose() / Acts::UnitConstants::T << " T" << endmsg;
+    m_field         = std::make_shared<const Acts::ConstantBField>(b);
+    m_fieldProvider = Jug::BField::fieldProvider(m_field);
+    return StatusCode::SUCCESS;
+  }
+  if (model != "xyz" && model != "rz") {
+    error() << "Unknown field model " << model << ", expected dd4hep, xyz, rz or constant" << endmsg;
+    return StatusCode::FAILURE;
+  }
+  if (m_fieldMapExtent.value().size() != 3 || m_fieldMapStep.value().size() != 2) {
+    error() << "fieldMapExtent needs [xyMax, zMin, zMax] and fieldMapStep [xy, z]" << endmsg;
+    return StatusCode::FAILURE;
+  }
+  GridBField::Config cfg;
+  cfg.symmetry = (model == "rz") ? GridBField::Symmetry::RZ : GridBField::Symmetry::XYZ;
+  cfg.xyMax    = m_fieldMapExtent.value()[0];
+  cfg.zMin     = m_fieldMapExtent.value()[1];
+  cfg.zMax     = m_fieldMapExtent.value()[2];
+  cfg.xyStep   = m_fieldMapStep.value()[0];
+  cfg.zStep    = m_fieldMapStep.value()[1];
+  try {
+    auto map = std::make_shared<const GridBField>(m_magneticField, cfg);
+    // interpolation error, largest between the grid points
+    const double deviation = map->maxDeviation(m_fieldMapChecks.value());
+    info() << "Field map (" << model << ") with " << map->size() << " points, largest deviation "
+           << deviation / Acts::UnitConstants::T << " T from the DD4hep field (largest field "
+           << map->maxField() / Acts::UnitConstants::T << " T)" << endmsg;
+    if (deviation > m_fieldMapTolerance.value() * map->maxField()) {
+      error() << "Field map deviation above the tolerance of " << m_fieldMapTolerance.value()
+              << ", use a smaller fieldMapStep" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    m_field         = std::move(map);
+    m_fieldProvider = Jug::BField::fieldProvider(m_field);
+  } catch (const std::exception& e) {
+    error() << "Cannot build the field map: " << e.what() << endmsg;
+    return StatusCode::FAILURE;
+  }
+  return StatusCode::SUCCESS;
+}
+
+void GeoSvc::initGenFitField() const {
+  // genfit takes ownership of the field, in kGauss and cm
+  if (std::holds_alternative<std::shared_ptr<const Acts::ConstantBField>>(m_field)) {
+    const auto b = Jug::BField::GenFitBField(m_fieldProvider).get(TVector3(0., 0., 0.));
+    genfit::FieldManager::getInstance()->init(new genfit::ConstField(b.X(), b.Y(), b.Z()));
+  } else {
+    genfit::FieldManager::getInstance()->init(new Jug::BField::GenFitBField(m_fieldProvider));
+  }
+}
+
+double GeoSvc::centralMagneticField() const {
+  auto cache = m_fieldProvider->makeCache(Acts::MagneticFieldContext{});
+  return m_fieldProvider->getField({0., 0., 0.}, cache).value().z();
+}
+
+std::string GeoSvc::materialsFile() const {
+  const std::string& json = m_jsonFileName.value();
+  if (m_materialsCacheDir.value().empty() || json.size() < 5 || json.substr(json.size() - 5) != ".json") {
+    return json;
+  }
+  const auto hash = Jug::Base::fileHash(json);
+  if (hash == 0) {
+    return json;
+  }
+  try {
+    std::ostringstream name;
+    name << "materials-v" << kMaterialsCacheVersion << "-" << std::hex << hash << ".cbor";
+    const auto cbor = Jug::joinPaths(Jug::ensureWritableDirectory(m_materialsCacheDir.value()), name.str());
+    if (std::ifstream(cbor)) {
+      debug() << "cached materials map " << cbor << endmsg;
+      return cbor;
+    }
+    // the binary encoding of the same json, which JsonMaterialDecorator parses much faster
+    nlohmann::json jin;
+    std::ifstream ijson(json);
+    ijson >> jin;
+    const auto bytes = nlohmann::json::to_cbor(jin);
+    // written under a temporary name, so that concurrent jobs never read a partial cache file
+    const auto tmp = cbor + "." + std::to_string(::getpid());
+    std::ofstream os(tmp, std::ios::binary | std::ios::trunc);
+    os.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    os.close();
+    if (!os || std::rename(tmp.c_str(), cbor.c_str()) != 0) {
+      std::remove(tmp.c_str());
+      warning() << "Failed to write the materials map cache " << cbor << endmsg;
+      return json;
+    }
+    info() << "materials map cached in " << cbor << endmsg;
+    return cbor;
+  } catch (const std::exception& e) {
+    warning() << "No materials map cache: " << e.what() << endmsg;
+    return json;
+  }
+}
+
+void GeoSvc::buildTrackingGeometry() const {
   // Convert DD4hep geometry to ACTS
   Acts::BinningType bTypePhi = Acts::equidistant;
   Acts::BinningType bTypeR = Acts::equidistant;
@@ -175,11 +347,17 @@ StatusCode GeoSvc::initialize() {
       sortDetElementsByID,
       m_trackingGeoCtx,
       m_materialDeco);
+  if (m_trackingGeo && !m_surfacesObjFileName.value().empty()) {
+    draw_surfaces(m_trackingGeo, m_trackingGeoCtx, m_surfacesObjFileName.value());
+  }
+}
+
+void GeoSvc::buildSurfaceMap() const {
+  const auto trackingGeo = trackingGeometry();
   // Visit surfaces
-  if (m_trackingGeo) {
-    draw_surfaces(m_trackingGeo, m_trackingGeoCtx, "tracking_geometry.obj");
+  if (trackingGeo) {
     debug() << "visiting all the surfaces  " << endmsg;
-    m_trackingGeo->visitSurfaces([this](const Acts::Surface* surface) {
+    trackingGeo->visitSurfaces([this](const Acts::Surface* surface) {
       // for now we just require a valid surface
       if (surface == nullptr) {
         info() << "no surface??? " << endmsg;
@@ -206,35 +384,41 @@ StatusCode GeoSvc::initialize() {
       this->m_surfaces.insert_or_assign(vol_id, surface);
     });
   }
+}
 
-  // Load ACTS magnetic field
-  m_magneticField = std::make_shared<const Jug::BField::DD4hepBField>(m_dd4hepGeo);
-  Acts::MagneticFieldContext m_fieldctx{Jug::BField::BFieldVariant(m_magneticField)};
-  auto bCache = m_magneticField->makeCache(m_fieldctx);
-  for (int z : {0, 1000, 2000, 4000}) {
-    auto b = m_magneticField->getField({0.0, 0.0, double(z)}, bCache).value();
-    debug() << "B(z=" << z << " mm) = " << b.transpose()  << " T" << endmsg;
+void GeoSvc::buildDD4hepSurfaceMap() const {
+  // create a list of all surfaces in the detector:
+  dd4hep::rec::SurfaceManager surfMan( *m_dd4hepGeo ) ;
+  debug() << " surface manager " << endmsg;
+  const auto* const sM = surfMan.map("tracker") ;
+  if (sM != nullptr) {
+    debug() << " surface map  size: " << sM->size() << endmsg;
+    // setup  dd4hep surface map
+    //for( dd4hep::rec::SurfaceMap::const_iterator it = sM->begin() ; it != sM->end() ; ++it ){
+    for( const auto& [id, s] :   *sM) {
+      //dd4hep::rec::Surface* surf = s ;
+      m_surfaceMap[ id ] = dynamic_cast<dd4hep::rec::Surface*>(s) ;
+      JUG_DEBUG(" surface : " << *s);
+      m_detPlaneMap[id] = std::shared_ptr<genfit::DetPlane>(
+          new genfit::DetPlane({s->origin().x(), s->origin().y(), s->origin().z()}, {s->u().x(), s->u().y(), s->u().z()},
+                               {s->v().x(), s->v().y(), s->v().z()}));
+    }
   }
-
-  return StatusCode::SUCCESS;
 }
 
-StatusCode GeoSvc::finalize() { return StatusCode::SUCCESS; }
-
-StatusCode GeoSvc::buildDD4HepGeo() {
-  // we retrieve the the static instance of the DD4HEP::Geometry
-  m_dd4hepGeo = &(dd4hep::Detector::getInstance());
-  m_dd4hepGeo->addExtension<IGeoSvc>(this);
-
-  // load geometry
-  for (auto& filename : m_xmlFileNames) {
-    m_log << MSG::INFO << "loading geometry from file:  '" << filename << "'" << endmsg;
-    m_dd4hepGeo->fromCompact(filename);
+void GeoSvc::buildSurfaceIndex() const {
+  auto volman = m_dd4hepGeo->volumeManager();
+  for (const auto& [vol_id, surface] : surfaceMap()) {
+    m_surfaceIndex.insert(vol_id, volman.lookupContext(vol_id)->mask).surface = surface;
   }
-  m_dd4hepGeo->volumeManager();
-  m_dd4hepGeo->apply("DD4hepVolumeManager", 0, nullptr);
-  m_cellid_converter = std::make_shared<const dd4hep::rec::CellIDPositionConverter>(*m_dd4hepGeo);
-  return StatusCode::SUCCESS;
+  std::call_once(m_dd4hepSurfacesBuilt, &GeoSvc::buildDD4hepSurfaceMap, this);
+  for (const auto& [vol_id, surface] : m_surfaceMap) {
+    auto& entry         = m_surfaceIndex.insert(vol_id, volman.lookupContext(vol_id)->mask);
+    entry.dd4hepSurface = surface;
+    entry.detPlane      = m_detPlaneMap[vol_id];
+  }
+  m_surfaceIndex.build();
+  debug() << "surface index of " << m_surfaceIndex.size() << " volumes" << endmsg;
 }
 
 dd4hep::Detector* GeoSvc::detector() { return (m_dd4hepGeo); }
@@ -24,6 +24,8 @@
 #include "Acts/Plugins/DD4hep/DD4hepDetectorElement.hpp"
 #include <Acts/Material/IMaterialDecorator.hpp>
 
+#include <mutex>
+
 // Gaudi
 #include "GaudiKernel/MsgStream.h"
 #include "GaudiKernel/Service.h"
@@ -36,7 +38,9 @@
 #include "DDRec/Surface.h"
 #include "DD4hep/DD4hepUnits.h"
 
-#include "JugBase/BField/DD4hepBField.h"
+#include "JugBase/BField/BFieldVariant.h"
+#include "JugBase/CellGeometryFile.h"
+#include "JugBase/SurfaceIndex.h"
 
 
 /** Draw the surfaces and save to obj file.
@@ -57,11 +61,11 @@ private:
    */
   dd4hep::Detector* m_dd4hepGeo = nullptr;
 
-  /// DD4hep surface map
-  std::map< int64_t, dd4hep::rec::Surface* > m_surfaceMap ;
+  /// DD4hep surface map (built on first use)
+  mutable std::map< int64_t, dd4hep::rec::Surface* > m_surfaceMap ;
 
-  /// Genfit DetPlane map
-  std::map< int64_t, std::shared_ptr<genfit::DetPlane> > m_detPlaneMap ;
+  /// Genfit DetPlane map (built on first use)
+  mutable std::map< int64_t, std::shared_ptr<genfit::DetPlane> > m_detPlaneMap ;
 
   /// ACTS Logging Level
   Acts::Logging::Level m_actsLoggingLevel = Acts::Logging::INFO;
@@ -69,14 +73,23 @@ private:
   /// ACTS Tracking Geometry Context
   Acts::GeometryContext m_trackingGeoCtx;
 
-  /// ACTS Tracking Geometry
-  std::shared_ptr<const Acts::TrackingGeometry> m_trackingGeo{nullptr};
+  /// ACTS Tracking Geometry (built on first use)
+  mutable std::shared_ptr<const Acts::TrackingGeometry> m_trackingGeo{nullptr};
 
   /// ACTS Material Decorator
   std::shared_ptr<const Acts::IMaterialDecorator> m_materialDeco{nullptr};
 
-  /// ACTS surface lookup container for hit surfaces that generate smeared hits
-  VolumeSurfaceMap m_surfaces;
+  /// ACTS surface lookup container for hit surfaces that generate smeared hits (built on first use)
+  mutable VolumeSurfaceMap m_surfaces;
+
+  /// All surface kinds by cellID (built on first use)
+  mutable Jug::Base::SurfaceIndex m_surfaceIndex;
+
+  /// The tracking geometry and the surface maps are only built for the jobs that use them
+  mutable std::once_flag m_trackingGeoBuilt;
+  mutable std::once_flag m_surfacesBuilt;
+  mutable std::once_flag m_dd4hepSurfacesBuilt;
+  mutable std::once_flag m_surfaceIndexBuilt;
 
   /** DD4hep CellID tool.
    *  Use to lookup geometry information for a hit with cellid number (int64_t).
@@ -87,6 +100,16 @@ private:
   /// Acts magnetic field
   std::shared_ptr<const Jug::BField::DD4hepBField> m_magneticField = nullptr;
 
+  /// Magnetic field model for the ACTS steppers and genfit
+  Jug::BField::BFieldVariant m_field;
+  std::shared_ptr<const Acts::MagneticFieldProvider> m_fieldProvider = nullptr;
+
+  /// Hash of the detector description
+  uint64_t m_geometryHash = 0;
+
+  /// Memory-mapped cell geometry tables
+  std::unique_ptr<Jug::Base::CellGeometryFile> m_cellGeometryFile{nullptr};
+
   /// XML-files with the detector description
   Gaudi::Property<std::vector<std::string>> m_xmlFileNames{
       this, "detectors", {}, "Detector descriptions XML-files"};
@@ -95,6 +118,40 @@ private:
   Gaudi::Property<std::string> m_jsonFileName{
       this, "materials", "", "Material map JSON-file"};
 
+  /// Directory with the binary (CBOR) conversions of the material maps, shared by the jobs
+  Gaudi::Property<std::string> m_materialsCacheDir{
+      this, "materialsCache", "", "Material map cache directory, not used if empty"};
+
+  /// Coarse material: the surface material of the map rebinned to at most [loc0, loc1] bins, homogeneous with
+  /// [1, 1]; the material of the map as is if empty
+  Gaudi::Property<std::vector<size_t>> m_materialBins{
+      this, "materialBins", {}, "Surface material bins [loc0, loc1], the map binning if empty"};
+
+  /// Magnetic field model: the DD4hep field, a map on an (x,y,z) or (r,z) grid, or constant
+  Gaudi::Property<std::string> m_fieldModel{this, "fieldModel", "dd4hep", "Field model (dd4hep, xyz, rz, constant)"};
+
+  /// Constant field [Bx, By, Bz], the DD4hep field at the origin if empty
+  Gaudi::Property<std::vector<double>> m_constantField{this, "constantField", {}};
+
+  /// Field map grid: extent [xyMax (rMax), zMin, zMax] and spacing [xy (r), z]
+  Gaudi::Property<std::vector<double>> m_fieldMapExtent{
+      this, "fieldMapExtent", {2000. * Acts::UnitConstants::mm, -5000. * Acts::UnitConstants::mm,
+                               5000. * Acts::UnitConstants::mm}};
+  Gaudi::Property<std::vector<double>> m_fieldMapStep{
+      this, "fieldMapStep", {25. * Acts::UnitConstants::mm, 25. * Acts::UnitConstants::mm}};
+
+  /// Field map accuracy check: largest deviation from the DD4hep field, relative to the largest field on the grid
+  Gaudi::Property<double> m_fieldMapTolerance{this, "fieldMapTolerance", 0.01};
+  Gaudi::Property<size_t> m_fieldMapChecks{this, "fieldMapChecks", 1000, "Random positions of the accuracy check"};
+
+  /// OBJ-file with the tracking surfaces, for debugging
+  Gaudi::Property<std::string> m_surfacesObjFileName{
+      this, "surfacesObjFile", "", "Tracking surfaces OBJ-file, not written if empty"};
+
+  /// Binary file with the precomputed cell geometry tables (made with jug_cell_geometry)
+  Gaudi::Property<std::string> m_cellGeometryFileName{
+      this, "cellGeometryTables", "", "Precomputed cell geometry tables file"};
+
   /// Gaudi logging output
   MsgStream m_log;
 
@@ -112,6 +169,24 @@ public:
    */
   StatusCode buildDD4HepGeo();
 
+private:
+  /// Material map file to load, the cached CBOR conversion of the JSON map if available
+  std::string materialsFile() const;
+  /// Set up the field model, sampling the field map if any
+  StatusCode buildFieldMap();
+  /// Initialize the genfit field manager with the field model
+  void initGenFitField() const;
+  /// Convert the DD4hep geometry to the ACTS tracking geometry
+  void buildTrackingGeometry() const;
+  /// Map the ACTS surfaces to the DD4hep volume IDs
+  void buildSurfaceMap() const;
+  /// Collect the DD4hep tracker surfaces and the corresponding genfit planes
+  void buildDD4hepSurfaceMap() const;
+  /// Index the surfaces of both maps by volume ID and mask
+  void buildSurfaceIndex() const;
+
+public:
+
   /** Get the top level DetElement.
    *   DD4hep Geometry
    */
@@ -133,26 +208,54 @@ public:
   virtual dd4hep::Detector* detector() override;
 
   /** Gets the ACTS tracking geometry.
+   *  It is converted from the DD4hep geometry on the first call.
    */
   virtual std::shared_ptr<const Acts::TrackingGeometry> trackingGeometry() const;
 
-  virtual std::shared_ptr<const Acts::MagneticFieldProvider> getFieldProvider() const override { return m_magneticField; }
+  virtual std::shared_ptr<const Acts::MagneticFieldProvider> getFieldProvider() const override { return m_fieldProvider; }
 
-  virtual double centralMagneticField() const
+  /// Bz at the origin of the field model
+  virtual double centralMagneticField() const;
+
+  virtual const VolumeSurfaceMap& surfaceMap() const
   {
-    return m_dd4hepGeo->field().magneticField({0, 0, 0}).z() * (Acts::UnitConstants::T / dd4hep::tesla);
+    std::call_once(m_surfacesBuilt, &GeoSvc::buildSurfaceMap, this);
+    return m_surfaces;
   }
 
-  virtual const VolumeSurfaceMap& surfaceMap() const { return m_surfaces; }
-
   // Note this hsould return a const& but is just copied for the moment to get around genfit's api
-  virtual std::map<int64_t, std::shared_ptr<genfit::DetPlane>> getDetPlaneMap() const { return m_detPlaneMap; }
+  virtual std::map<int64_t, std::shared_ptr<genfit::DetPlane>> getDetPlaneMap() const
+  {
+    std::call_once(m_dd4hepSurfacesBuilt, &GeoSvc::buildDD4hepSurfaceMap, this);
+    return m_detPlaneMap;
+  }
 
-  virtual std::map< int64_t, dd4hep::rec::Surface* > getDD4hepSurfaceMap() const { return m_surfaceMap ;}
+  virtual std::map< int64_t, dd4hep::rec::Surface* > getDD4hepSurfaceMap() const
+  {
+    std::call_once(m_dd4hepSurfacesBuilt, &GeoSvc::buildDD4hepSurfaceMap, this);
+    return m_surfaceMap;
+  }
+
+  /** Get the surfaces of the cell of a hit, without the volume manager lookup.
+   *  The index is built from both surface maps on the first call.
+   */
+  virtual const Jug::Base::SurfaceIndex& surfaceIndex() const override
+  {
+    std::call_once(m_surfaceIndexBuilt, &GeoSvc::buildSurfaceIndex, this);
+    return m_surfaceIndex;
+  }
+
+  virtual uint64_t geometryHash() const override { return m_geometryHash; }
+
+  /** Get the precomputed cell geometry tables.
+   *  They are memory-mapped in init if the cellGeometryTables file was made for this geometry.
+   */
+  virtual const Jug::Base::CellGeometryFile* cellGeometryFile() const override { return m_cellGeometryFile.get(); }
 };
 
 inline std::shared_ptr<const Acts::TrackingGeometry> GeoSvc::trackingGeometry() const
 {
+  std::call_once(m_trackingGeoBuilt, &GeoSvc::buildTrackingGeometry, this);
   return m_trackingGeo;
 }
 
@@ -24,6 +24,10 @@ namespace Jug::Base {
      *
      * Details found here:
      * https://github.com/AIDASoft/podio/issues/103
+     *
+     * With subsetCollection, the output is a subset collection referencing the
+     * input objects instead of a deep copy (the input collection then has to be
+     * kept in the output as well).
      */
     template<typename T_IN, typename T_OUT>
     class InputCopier : public GaudiAlgorithm {
@@ -42,6 +46,9 @@ namespace Jug::Base {
         warning() << "1) Remove the calls to InputCopier from your options file." << endmsg;
         warning() << "2) Add 'keep mcparticles' to the PodioOutput.outputCommands." << endmsg;
         warning() << "3) Update your analysis code to use 'mcparticles' directly." << endmsg;
+        if (m_subsetCollection.value()) {
+          info() << "Output " << m_outputHitCollection.objKey() << " references the input objects" << endmsg;
+        }
         return StatusCode::SUCCESS;
       }
       StatusCode execute() override
@@ -50,6 +57,14 @@ namespace Jug::Base {
         const T_IN* simhits = m_inputHitCollection.get();
         // output collection
         auto* out_parts = m_outputHitCollection.createAndPut();
+        if (m_subsetCollection.value()) {
+          // references only, the objects stay in the input collection
+          out_parts->setSubsetCollection();
+          for (const auto& ahit : *simhits) {
+            out_parts->push_back(ahit);
+          }
+          return StatusCode::SUCCESS;
+        }
         for (const auto& ahit : *simhits) {
           out_parts->push_back(ahit.clone());
         }
@@ -58,6 +73,8 @@ namespace Jug::Base {
 
       DataHandle<T_IN> m_inputHitCollection{"MCParticles", Gaudi::DataHandle::Reader, this};
       DataHandle<T_OUT> m_outputHitCollection{"genparticles", Gaudi::DataHandle::Writer, this};
+      Gaudi::Property<bool> m_subsetCollection{this, "subsetCollection", false,
+                                               "Reference the input objects instead of copying them"};
     };
 
     using CalorimeterColCopier = InputCopier<edm4hep::SimCalorimeterHitCollection, edm4hep::SimCalorimeterHitCollection>;
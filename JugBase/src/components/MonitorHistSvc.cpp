@@ -0,0 +1,164 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "MonitorHistSvc.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "fmt/format.h"
+
+#include "TFile.h"
+#include "TH1D.h"
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(MonitorHistSvc)
+
+using Jug::Base::MonitorHist;
+
+namespace {
+
+// The string escaped for a JSON string literal
+std::string jsonEscaped(const std::string& str) {
+  std::string escaped;
+  escaped.reserve(str.size());
+  for (const char c : str) {
+    switch (c) {
+    case '"':
+      escaped += "\\\"";
+      break;
+    case '\\':
+      escaped += "\\\\";
+      break;
+    case '\n':
+      escaped += "\\n";
+      break;
+    case '\t':
+      escaped += "\\t";
+      break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20) {
+        escaped += fmt::format("\\u{:04x}", static_cast<unsigned>(c));
+      } else {
+        escaped += c;
+      }
+    }
+  }
+  return escaped;
+}
+
+} // namespace
+
+MonitorHistSvc::MonitorHistSvc(const std::string& name, ISvcLocator* svc) : base_class(name, svc) {}
+
+MonitorHistSvc::~MonitorHistSvc() = default;
+
+StatusCode MonitorHistSvc::initialize() {
+  StatusCode sc = Service::initialize();
+  if (!sc.isSuccess()) {
+    fatal() << "Error initializing MonitorHistSvc" << endmsg;
+    return sc;
+  }
+  if (!m_snapshotFile.value().empty()) {
+    if (!(m_snapshotInterval.value() > 0)) {
+      error() << "snapshotInterval must be positive" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    const auto interval = std::chrono::duration<double>(m_snapshotInterval.value());
+    m_snapshots         = std::thread([this, interval] {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      while (!m_stopSnapshots.wait_for(lock, interval, [this] { return m_stop; })) {
+        lock.unlock();
+        writeSnapshot();
+        lock.lock();
+      }
+    });
+  }
+  return StatusCode::SUCCESS;
+}
+
+StatusCode MonitorHistSvc::finalize() {
+  if (m_snapshots.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_stopSnapshots.notify_all();
+    m_snapshots.join();
+    if (!writeSnapshot()) {
+      warning() << "Cannot write the snapshot " << m_snapshotFile.value() << endmsg;
+    }
+  }
+  if (!m_output.value().empty()) {
+    if (!writeROOT()) {
+      error() << "Cannot write the histograms to " << m_output.value() << endmsg;
+      return StatusCode::FAILURE;
+    }
+    info() << "Wrote " << m_hists.size() << " monitoring histograms to " << m_output.value() << endmsg;
+  }
+  m_hists.clear();
+  return Service::finalize();
+}
+
+MonitorHist* MonitorHistSvc::book(const std::string& name, const std::string& title, unsigned nbins, double min,
+                                  double max) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto& hist = m_hists[name];
+  if (!hist) {
+    hist = std::make_unique<MonitorHist>(name, title, nbins, min, max);
+  }
+  const auto& bins = hist->bins();
+  if (bins.nbins != nbins || bins.min != min || bins.max != max) {
+    error() << "Histogram " << name << " is booked with another binning" << endmsg;
+    return nullptr;
+  }
+  return hist.get();
+}
+
+bool MonitorHistSvc::writeSnapshot() {
+  const std::string partial = m_snapshotFile.value() + ".partial";
+  {
+    std::ofstream os(partial);
+    os << "{";
+    bool first = true;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& [name, hist] : m_hists) {
+      uint64_t entries = 0;
+      const auto merged = hist->merged(&entries);
+      const auto& bins  = merged.bins();
+      os << fmt::format("{}\n  \"{}\": {{\"title\": \"{}\", \"nbins\": {}, \"min\": {}, \"max\": {}, \"entries\": {}, "
+                        "\"contents\": [{}]}}",
+                        first ? "" : ",", jsonEscaped(name), jsonEscaped(hist->title()), bins.nbins, bins.min,
+                        bins.max, entries, fmt::join(merged.contents(), ", "));
+      first = false;
+    }
+    os << "\n}\n";
+    if (!os) {
+      return false;
+    }
+  }
+  return std::rename(partial.c_str(), m_snapshotFile.value().c_str()) == 0;
+}
+
+bool MonitorHistSvc::writeROOT() {
+  std::unique_ptr<TFile> file(TFile::Open(m_output.value().c_str(), "RECREATE"));
+  if (file == nullptr || file->IsZombie()) {
+    return false;
+  }
+  for (const auto& [name, hist] : m_hists) {
+    uint64_t entries  = 0;
+    const auto merged = hist->merged(&entries);
+    const auto& bins  = merged.bins();
+    TH1D h(name.c_str(), hist->title().c_str(), bins.nbins, bins.min, bins.max);
+    h.SetDirectory(nullptr);
+    for (size_t i = 0; i < bins.size(); ++i) {
+      h.SetBinContent(i, merged.content(i));
+    }
+    h.SetEntries(static_cast<double>(entries));
+    file->WriteTObject(&h);
+  }
+  file->Close();
+  return true;
+}
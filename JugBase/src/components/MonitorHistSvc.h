@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef MONITORHISTSVC_H
+#define MONITORHISTSVC_H
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "Gaudi/Property.h"
+#include "GaudiKernel/Service.h"
+
+#include "JugBase/IMonitorHistSvc.h"
+
+/** Monitoring histograms, merged from the buffers of the threads.
+ *
+ *  At finalize, the histograms are written as TH1D to the ROOT file output (none if empty). For
+ *  online monitoring, the merged histograms are also written every snapshotInterval seconds to the
+ *  JSON file snapshotFile (replaced atomically), by a thread of the service that reads the buffers
+ *  while the events are processed.
+ */
+class MonitorHistSvc : public extends<Service, IMonitorHistSvc> {
+public:
+  MonitorHistSvc(const std::string& name, ISvcLocator* svc);
+  virtual ~MonitorHistSvc();
+
+  virtual StatusCode initialize() final;
+  virtual StatusCode finalize() final;
+
+  virtual Jug::Base::MonitorHist* book(const std::string& name, const std::string& title, unsigned nbins, double min,
+                                       double max);
+
+private:
+  bool writeSnapshot();
+  bool writeROOT();
+
+  Gaudi::Property<std::string> m_output{this, "output", "", "ROOT file of the histograms, none if empty"};
+  Gaudi::Property<std::string> m_snapshotFile{this, "snapshotFile", "", "JSON file of the periodic snapshots"};
+  Gaudi::Property<double> m_snapshotInterval{this, "snapshotInterval", 60., "Seconds between two snapshots"};
+
+  std::mutex m_mutex;
+  // by name, so that the files are sorted
+  std::map<std::string, std::unique_ptr<Jug::Base::MonitorHist>> m_hists;
+
+  std::thread m_snapshots;
+  std::condition_variable m_stopSnapshots;
+  bool m_stop{false};
+};
+
+#endif
@@ -13,8 +13,9 @@
 /** Simple particle service.
  *
  *  This meant to provide basic particle information for reconstruction purposes.
- *  If particle data is needed, be sure to grab everything you can in an initialization
- *  step. Currently the  returned Particle/ParticleMap are by value.
+ *  The particles are a compile-time table sorted by PDG code, the common codes are looked up
+ *  directly and the others by binary search, so particle(pdg) is cheap enough for the inner
+ *  loops. Unknown codes return the particle with PDG code 0.
  */
 class ParticleSvc : public extends<Service, IParticleSvc> {
 public:
@@ -31,14 +32,8 @@ public:
   virtual StatusCode initialize() final;
   virtual StatusCode finalize() final { return StatusCode::SUCCESS; }
 
-  virtual ParticleMap particleMap() const { return m_particleMap; }
-  virtual Particle particle(int pdg) const {
-    if (m_particleMap.count(pdg) == 0) {
-      // error
-      return m_particleMap.at(0);
-    }
-    return m_particleMap.at(pdg);
-  }
+  virtual const ParticleMap& particleMap() const { return m_particleMap; }
+  virtual const Particle& particle(int pdg) const;
 };
 
 #endif
@@ -7,6 +7,7 @@
 #include "TROOT.h"
 
 #include "JugBase/DataWrapper.h"
+#include "JugBase/Logging.h"
 #include "JugBase/PodioDataSvc.h"
 
 // NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
@@ -21,34 +22,47 @@ StatusCode PodioInput::initialize() {
   }
 
   // check whether we have the PodioDataSvc active
-  m_podioDataSvc = dynamic_cast<PodioDataSvc*>(evtSvc().get());
+  m_podioDataSvc = PodioDataSvc::fromEventSvc(evtSvc().get());
   if (m_podioDataSvc == nullptr) {
     return StatusCode::FAILURE;
   }
 
   auto* idTable = m_podioDataSvc->getCollectionIDs();
   for (auto& name : m_collectionNames) {
-    debug() << "Finding collection " << name << " in collection registry." << endmsg;
+    JUG_DEBUG("Finding collection " << name << " in collection registry.");
     if (!idTable->present(name)) {
       error() << "Requested product " << name << " not found." << endmsg;
       return StatusCode::FAILURE;
     }
     m_collectionIDs.push_back(idTable->collectionID(name));
   }
+  // only the requested collections are read from the input
+  m_podioDataSvc->setCachedCollections(m_collectionNames.value());
   return StatusCode::SUCCESS;
 }
 
 StatusCode PodioInput::execute() {
+  // the store of the current event slot
+  m_podioDataSvc = PodioDataSvc::fromEventSvc(evtSvc().get());
+  // the slots sharing an input read one event at a time
+  auto lock = m_podioDataSvc->lockInput();
+  // a shared reader moves on to the next event, lazy reading would read from the wrong one
+  const bool lazy = m_lazy.value() && !m_podioDataSvc->sharedInput();
   size_t cntr = 0;
   // Re-create the collections from ROOT file
   for (auto& id : m_collectionIDs) {
     const std::string& collName = m_collectionNames.value().at(cntr++);
-    debug() << "Registering collection to read " << collName << " with id " << id << endmsg;
+    JUG_DEBUG("Registering collection to read " << collName << " with id " << id);
+    if (lazy) {
+      m_podioDataSvc->registerLazyCollection(collName, id);
+      continue;
+    }
     if (m_podioDataSvc->readCollection(collName, id).isFailure()) {
       return StatusCode::FAILURE;
     }
   }
-  // Tell data service that we are done with requested collections
+  // Tell data service that we are done with requested collections,
+  // with lazy collections the reader stays on the event until the store is cleared
   m_podioDataSvc->endOfRead();
   return StatusCode::SUCCESS;
 }
@@ -36,6 +36,9 @@ public:
 private:
   /// Name of collections to read. Set by option collections (this is temporary)
   Gaudi::Property<std::vector<std::string>> m_collectionNames{this, "collections", {}, "Places of collections to read"};
+  /// Read the collections only when they are first retrieved in the event (not with several event slots).
+  /// Set by option lazy
+  Gaudi::Property<bool> m_lazy{this, "lazy", false, "Read the collections on their first access"};
   /// Collection IDs (retrieved with CollectionIDTable from ROOT file, using collection names)
   std::vector<int> m_collectionIDs;
   /// Data service: needed to register objects and get collection IDs. Just an observing pointer.
@@ -2,12 +2,116 @@
 // Copyright (C) 2022 Whitney Armstrong, Sylvester Joosten, Wouter Deconinck
 
 #include "PodioOutput.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <system_error>
+
+#include "podio/ObjectID.h"
 #include "podio/podioVersion.h"
 #include "GaudiKernel/ISvcLocator.h"
+#include "GaudiKernel/ThreadLocalContext.h"
+#include "JugBase/Logging.h"
+#include "JugBase/OutputMerger.h"
+#include "JugBase/OutputMetadata.h"
 #include "JugBase/PodioDataSvc.h"
+#include "JugBase/Profiling.h"
+#include "TBranch.h"
+#include "TClass.h"
+#include "TDataMember.h"
+#include "TDataType.h"
 #include "TFile.h"
+#include "TObjArray.h"
+#include "TROOT.h"
+#include "TVirtualCollectionProxy.h"
 #include "rootutils.h"
 
+namespace {
+// Non-negative integer of a whole word, false for any other text (e.g. "32k", "-1" or "")
+bool parseCount(const std::string& word, int& value) {
+  const char* end      = word.data() + word.size();
+  const auto [ptr, ec] = std::from_chars(word.data(), end, value);
+  return ec == std::errc() && ptr == end && value >= 0;
+}
+
+void setBasketSize(TBranch* branch, int basketSize) {
+  branch->SetBasketSize(basketSize);
+  for (auto* sub : *branch->GetListOfBranches()) {
+    setBasketSize(static_cast<TBranch*>(sub), basketSize);
+  }
+}
+
+void setCompressionSettings(TBranch* branch, int compression) {
+  branch->SetCompressionSettings(compression);
+  for (auto* sub : *branch->GetListOfBranches()) {
+    setCompressionSettings(static_cast<TBranch*>(sub), compression);
+  }
+}
+
+// Round v to the nearest float with the given number of mantissa bits (out of 23)
+void roundMantissa(float& v, int mantissaBits) {
+  uint32_t u = 0;
+  std::memcpy(&u, &v, sizeof(u));
+  // infinity and nan are kept
+  constexpr uint32_t exponent = 0x7f800000U;
+  if ((u & exponent) == exponent) {
+    return;
+  }
+  const uint32_t drop    = 23 - mantissaBits;
+  const uint32_t mask    = ~((1U << drop) - 1);
+  const uint32_t rounded = (u + (1U << (drop - 1))) & mask;
+  // rounding the largest values up would give infinity, they are truncated instead
+  u = ((rounded & exponent) == exponent) ? (u & mask) : rounded;
+  std::memcpy(&v, &u, sizeof(v));
+}
+
+// Offsets of the float members of cls (also in its members of class type and arrays) from base
+void floatOffsets(TClass* cls, size_t base, std::vector<size_t>& offsets) {
+  for (auto* obj : *cls->GetListOfDataMembers()) {
+    auto* member = static_cast<TDataMember*>(obj);
+    if (member->IsaPointer() || !member->IsPersistent() || (member->Property() & kIsStatic) != 0) {
+      continue;
+    }
+    size_t count = 1;
+    for (int dim = 0; dim < member->GetArrayDim(); ++dim) {
+      count *= member->GetMaxIndex(dim);
+    }
+    const size_t offset = base + member->GetOffset();
+    if (member->IsBasic()) {
+      if (member->GetDataType() != nullptr && member->GetDataType()->GetType() == kFloat_t) {
+        for (size_t k = 0; k < count; ++k) {
+          offsets.push_back(offset + k * sizeof(float));
+        }
+      }
+    } else if (TClass* memberClass = TClass::GetClass(member->GetTypeName());
+               memberClass != nullptr && memberClass->GetCollectionProxy() == nullptr) {
+      for (size_t k = 0; k < count; ++k) {
+        floatOffsets(memberClass, offset + k * memberClass->Size(), offsets);
+      }
+    }
+  }
+}
+
+// Name of the output of the shard, e.g. out_shard007of128.root for out.root
+std::string shardFilename(const std::string& filename, unsigned shard, unsigned numShards) {
+  const std::string total = std::to_string(numShards);
+  std::string index       = std::to_string(shard);
+  index.insert(0, total.size() - std::min(total.size(), index.size()), '0');
+  const size_t slash = filename.find_last_of('/');
+  size_t dot         = filename.find_last_of('.');
+  if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+    dot = filename.size();
+  }
+  return filename.substr(0, dot) + "_shard" + index + "of" + total + filename.substr(dot);
+}
+
+} // namespace
+
 // NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
 DECLARE_COMPONENT(PodioOutput)
 
@@ -22,56 +126,350 @@ StatusCode PodioOutput::initialize() {
   }
 
   // check whether we have the PodioEvtSvc active
-  m_podioDataSvc = dynamic_cast<PodioDataSvc*>(evtSvc().get());
+  m_podioDataSvc = PodioDataSvc::fromEventSvc(evtSvc().get());
   if (m_podioDataSvc == nullptr) {
     error() << "Failed to get the DataSvc" << endmsg;
     return StatusCode::FAILURE;
   }
 
-  m_file = std::unique_ptr<TFile>(TFile::Open(m_filename.value().c_str(), "RECREATE", "data file"));
+  // file compression and per-collection branch settings
+  m_compression = ROOT::RCompressionSetting::EDefaults::kUseCompiledDefault;
+  if (!m_compressionAlgorithm.value().empty()) {
+    m_compression =
+        podio::root_utils::compressionSettings(m_compressionAlgorithm.value(), m_compressionLevel.value());
+    if (m_compression < 0) {
+      error() << "Unknown compression algorithm " << m_compressionAlgorithm.value() << endmsg;
+      return StatusCode::FAILURE;
+    }
+  } else if (m_compressionLevel.value() >= 0) {
+    m_compression =
+        ROOT::CompressionSettings(ROOT::RCompressionSetting::EAlgorithm::kUseGlobal, m_compressionLevel.value());
+  }
+  for (const auto& line : m_branchSettings.value()) {
+    const auto words = split(line, ' ');
+    BranchSettings settings;
+    bool valid = (words.size() == 2 || words.size() == 4);
+    if (valid) {
+      settings.pattern = words[0];
+      valid            = parseCount(words[1], settings.basketSize);
+      if (valid && words.size() == 4) {
+        int level = 0;
+        valid     = parseCount(words[3], level);
+        if (valid) {
+          settings.compression = podio::root_utils::compressionSettings(words[2], level);
+          valid                = (settings.compression >= 0);
+        }
+      }
+    }
+    if (!valid) {
+      error() << "Malformed branch settings '" << line << "', expected '<pattern> <basketSize> [<algorithm> <level>]'"
+              << endmsg;
+      return StatusCode::FAILURE;
+    }
+    m_parsedBranchSettings.push_back(settings);
+  }
+  for (const auto& line : m_precisionSettings.value()) {
+    const auto words = split(line, ' ');
+    int bits         = -1;
+    if (words.size() != 2 || !parseCount(words[1], bits) || bits > 23) {
+      error() << "Malformed precision settings '" << line << "', expected '<pattern> <mantissaBits>' (0 to 23)"
+              << endmsg;
+      return StatusCode::FAILURE;
+    }
+    m_parsedPrecisionSettings.emplace_back(words[0], bits);
+  }
+  if (m_asyncWrite.value()) {
+    // the writer thread fills the trees and writes the baskets while the event threads use ROOT,
+    // enabled before any tree is made
+    ROOT::EnableThreadSafety();
+  }
+  if (m_implicitMT.value() > 0) {
+    ROOT::EnableImplicitMT(m_implicitMT.value());
+    info() << "Enabled ROOT implicit multithreading with " << m_implicitMT.value() << " threads" << endmsg;
+  }
+  m_switch = KeepDropSwitch(m_outputCommands);
+  if (std::string err; !m_filters.configure(serviceLocator(), m_requireFilters.value(), err)) {
+    error() << err << endmsg;
+    return StatusCode::FAILURE;
+  }
+  return StatusCode::SUCCESS;
+}
+
+StatusCode PodioOutput::start() {
+  if (GaudiAlgorithm::start().isFailure()) {
+    return StatusCode::FAILURE;
+  }
+  const unsigned shard   = m_podioDataSvc->shard();
+  const unsigned total   = m_podioDataSvc->numShards();
+  const unsigned workers = m_podioDataSvc->numWorkers();
+  if (m_podioDataSvc->forkParent()) {
+    // the outputs of the workers (shards shard * workers + worker) are merged at finalize
+    for (unsigned worker = 0; worker < workers; ++worker) {
+      m_workerOutputs.push_back(shardFilename(m_filename.value(), shard * workers + worker, total * workers));
+    }
+  }
+  // the outputs of the shards are merged with jug_merge_outputs, or at finalize for the workers
+  const bool forkWorker = (workers > 1 && m_podioDataSvc->worker() >= 0);
+  if ((m_shardFilenames.value() || forkWorker) && total > 1) {
+    m_filename = shardFilename(m_filename.value(), shard, total);
+    if (!m_filenameRemote.value().empty()) {
+      m_filenameRemote = shardFilename(m_filenameRemote.value(), shard, total);
+    }
+  }
+  if (forkWorker) {
+    // only the merged output is copied
+    m_filenameRemote = "";
+  }
+  if (m_podioDataSvc->forkParent()) {
+    return StatusCode::SUCCESS;
+  }
+  const unsigned stream = m_podioDataSvc->addOutputStream();
+  m_file = std::unique_ptr<TFile>(TFile::Open(m_filename.value().c_str(), "RECREATE", "data file", m_compression));
   // Both trees are written to the ROOT file and owned by it
-  // PodioDataSvc has ownership of EventDataTree
-  m_datatree = m_podioDataSvc->eventDataTree();
+  // PodioDataSvc has ownership of EventDataTree, written by the first output stream with the branches
+  // of the data handles of primitive types
+  if (stream == 0) {
+    m_datatree = m_podioDataSvc->eventDataTree();
+  } else {
+    m_datatree = new TTree("events", "Events tree");
+    info() << "Output stream " << stream << " to " << m_filename.value() << endmsg;
+  }
   m_datatree->SetDirectory(m_file.get());
+  if (m_autoFlush.value() != 0) {
+    m_datatree->SetAutoFlush(m_autoFlush.value());
+  }
   m_metadatatree = new TTree("metadata", "Metadata tree");
   m_runMDtree = new TTree("run_metadata", "Run metadata tree");
   m_evtMDtree = new TTree("evt_metadata", "Event metadata tree");
   m_colMDtree = new TTree("col_metadata", "Collection metadata tree");
 
-  m_evtMDtree->Branch("evtMD", "GenericParameters", m_podioDataSvc->getProvider().eventMetaDataPtr() ) ;
-  m_switch       = KeepDropSwitch(m_outputCommands);
+  // the address is set to the event metadata of the slot of each event
+  m_evtMDBranch = m_evtMDtree->Branch("evtMD", "GenericParameters", m_podioDataSvc->getProvider().eventMetaDataPtr());
+  // the scalar outputs of the algorithms (declared at initialize) in one branch of leaves
+  auto& parameters = m_podioDataSvc->eventParameters();
+  parameters.freeze();
+  if (!parameters.empty()) {
+    m_parametersBranch = m_datatree->Branch("EventParameters", parameters.data(), parameters.leafList().c_str());
+  }
   return StatusCode::SUCCESS;
 }
 
-void PodioOutput::resetBranches(const std::vector<std::pair<std::string, podio::CollectionBase*>>& collections) {
-  for (const auto& [collName, collBuffers] : collections) {
-    auto buffers = collBuffers->getBuffers();
-    auto* data = buffers.data;
-    auto* references = buffers.references;
-    auto* vecmembers = buffers.vectorMembers;
+void PodioOutput::branchAddresses(const podio::CollectionBuffers& buffers, std::vector<const void*>& addresses) {
+  addresses.clear();
+  addresses.push_back(buffers.data);
+  if (buffers.references != nullptr) {
+    for (const auto& ref : *buffers.references) {
+      addresses.push_back(&ref);
+    }
+  }
+  if (buffers.vectorMembers != nullptr) {
+    for (const auto& vm : *buffers.vectorMembers) {
+      addresses.push_back(vm.second);
+    }
+  }
+}
 
+void PodioOutput::configureBranches(const std::string& collName, const std::vector<TBranch*>& branches) const {
+  int basketSize = m_basketSize.value();
+  int compression = -1;
+  for (const auto& settings : m_parsedBranchSettings) {
+    if (wildcmp(settings.pattern.c_str(), collName.c_str()) == 0) {
+      continue;
+    }
+    if (settings.basketSize > 0) {
+      basketSize = settings.basketSize;
+    }
+    if (settings.compression >= 0) {
+      compression = settings.compression;
+    }
+  }
+  for (auto* branch : branches) {
+    if (branch == nullptr) {
+      continue;
+    }
+    if (basketSize > 0) {
+      setBasketSize(branch, basketSize);
+    }
+    if (compression >= 0) {
+      setCompressionSettings(branch, compression);
+    }
+  }
+}
+
+int PodioOutput::mantissaBits(const std::string& collName) {
+  auto it = m_mantissaBits.find(collName);
+  if (it == m_mantissaBits.end()) {
+    int bits = 23;
     if (m_switch.isOn(collName)) {
-      // Reconnect branches and collections
-      m_datatree->SetBranchAddress(collName.c_str(), data);
-      auto* colls = references;
-      if (colls != nullptr) {
-        for (size_t j = 0; j < colls->size(); ++j) {
-          const auto brName = podio::root_utils::refBranch(collName, j);
-          auto* l_branch = m_datatree->GetBranch(brName.c_str());
-          l_branch->SetAddress(&(*colls)[j]);
+      for (const auto& [pattern, settingBits] : m_parsedPrecisionSettings) {
+        if (wildcmp(pattern.c_str(), collName.c_str()) != 0) {
+          bits = settingBits;
         }
       }
-      auto* colls_v = vecmembers;
-      if (colls_v != nullptr) {
-        int j = 0;
-        for (auto& [dataType, add] : (*colls_v)) {
-          const auto brName = podio::root_utils::vecBranch(collName, j);
-          m_datatree->SetBranchAddress(brName.c_str(), add);
-          ++j;
+    }
+    it = m_mantissaBits.emplace(collName, bits).first;
+  }
+  return it->second;
+}
+
+void PodioOutput::reducePrecision(const std::vector<std::pair<std::string, podio::CollectionBase*>>& collections) {
+  if (m_parsedPrecisionSettings.empty()) {
+    return;
+  }
+  for (const auto& [collName, collBuffers] : collections) {
+    const int bits = mantissaBits(collName);
+    if (bits >= 23) {
+      continue;
+    }
+    auto buffers = collBuffers->getBuffers();
+    if (buffers.data != nullptr) {
+      const std::string dataType = collBuffers->getValueTypeName() + "Data";
+      auto layoutIt              = m_floatLayouts.find(dataType);
+      if (layoutIt == m_floatLayouts.end()) {
+        FloatLayout layout;
+        TClass* cls    = TClass::GetClass(dataType.c_str());
+        TClass* vecCls = TClass::GetClass(("vector<" + dataType + ">").c_str());
+        if (cls != nullptr && vecCls != nullptr && vecCls->GetCollectionProxy() != nullptr) {
+          floatOffsets(cls, 0, layout.offsets);
+          layout.proxy.reset(vecCls->GetCollectionProxy()->Generate());
+        } else {
+          warning() << "No dictionary for " << dataType << ", the precision of " << collName << " is not reduced"
+                    << endmsg;
+        }
+        layoutIt = m_floatLayouts.emplace(dataType, std::move(layout)).first;
+      }
+      auto& layout = layoutIt->second;
+      if (layout.proxy && !layout.offsets.empty()) {
+        TVirtualCollectionProxy::TPushPop helper(layout.proxy.get(), *static_cast<void**>(buffers.data));
+        // the elements of the vector are contiguous
+        const size_t n      = layout.proxy->Size();
+        const size_t stride = layout.proxy->GetIncrement();
+        char* first         = (n > 0) ? static_cast<char*>(layout.proxy->At(0)) : nullptr;
+        saveBuffer(first, n * stride);
+        for (size_t i = 0; i < n; ++i) {
+          for (const size_t offset : layout.offsets) {
+            roundMantissa(*reinterpret_cast<float*>(first + i * stride + offset), bits);
+          }
+        }
+      }
+    }
+    if (buffers.vectorMembers != nullptr) {
+      for (const auto& [dataType, address] : *buffers.vectorMembers) {
+        if (dataType == "float") {
+          auto& values = **static_cast<std::vector<float>**>(address);
+          saveBuffer(values.data(), values.size() * sizeof(float));
+          for (float& v : values) {
+            roundMantissa(v, bits);
+          }
+        }
+      }
+    }
+  }
+}
+
+void PodioOutput::createPackedBranch(const std::string& collName, podio::CollectionBase& collection) {
+  const bool packed = std::any_of(m_cellIDPacking.value().begin(), m_cellIDPacking.value().end(),
+                                  [&](const auto& pattern) { return wildcmp(pattern.c_str(), collName.c_str()) != 0; });
+  if (!packed || collection.isSubsetCollection()) {
+    return;
+  }
+  auto branch    = std::make_unique<PackedBranch>();
+  branch->layout = std::make_unique<Jug::Base::CellIDLayout>(collection.getValueTypeName() + "Data");
+  if (!branch->layout->valid()) {
+    warning() << "No 64-bit cellID in " << collection.getValueTypeName() << ", the cellIDs of " << collName
+              << " are not packed" << endmsg;
+    return;
+  }
+  // the reference vectors of the OneToMany relations (with an index range in the elements) come
+  // before those of the OneToOne relations (an ObjectID per element, permuted with the elements)
+  auto buffers          = collection.getBuffers();
+  const size_t nVectors = (buffers.vectorMembers != nullptr) ? buffers.vectorMembers->size() : 0;
+  const size_t nRefs    = (buffers.references != nullptr) ? buffers.references->size() : 0;
+  if (branch->layout->ranges() < nVectors || branch->layout->ranges() - nVectors > nRefs) {
+    warning() << "Cannot tell the OneToOne relations of " << collection.getValueTypeName() << ", the cellIDs of "
+              << collName << " are not packed" << endmsg;
+    return;
+  }
+  branch->firstOneToOne = branch->layout->ranges() - nVectors;
+  branch->address       = &branch->blob;
+  auto* tbranch         = m_datatree->Branch(Jug::Base::PackedCellIDs::branchName(collName).c_str(), &branch->address);
+  configureBranches(collName, {tbranch});
+  m_packedBranches.emplace(collName, std::move(branch));
+}
+
+void PodioOutput::packCellIDs(const std::vector<std::pair<std::string, podio::CollectionBase*>>& collections) {
+  if (m_packedBranches.empty()) {
+    return;
+  }
+  for (const auto& [collName, collBuffers] : collections) {
+    auto it = m_packedBranches.find(collName);
+    if (it == m_packedBranches.end()) {
+      continue;
+    }
+    auto& branch = *it->second;
+    auto buffers = collBuffers->getBuffers();
+    if (buffers.data == nullptr) {
+      branch.blob.clear();
+      continue;
+    }
+    size_t n      = 0;
+    size_t stride = 0;
+    char* first   = branch.layout->elements(buffers.data, n, stride);
+    saveBuffer(first, n * stride);
+    Jug::Base::PackedCellIDs::pack(first, n, stride, branch.layout->offset(), branch.blob, m_packOrder,
+                                   m_packScratch);
+    if (buffers.references == nullptr) {
+      continue;
+    }
+    // prepareForWrite fills an ObjectID per element for every OneToOne relation, also if unset
+    for (size_t j = branch.firstOneToOne; j < buffers.references->size(); ++j) {
+      auto& refs = *(*buffers.references)[j];
+      if (refs.size() != n) {
+        continue;
+      }
+      saveBuffer(refs.data(), n * sizeof(podio::ObjectID));
+      Jug::Base::PackedCellIDs::permute(m_packOrder, reinterpret_cast<char*>(refs.data()), sizeof(podio::ObjectID),
+                                        m_packScratch);
+    }
+  }
+}
+
+void PodioOutput::saveBuffer(void* address, size_t bytes) {
+  if (!m_restoreBuffers || bytes == 0) {
+    return;
+  }
+  if (m_nSaved == m_savedBuffers.size()) {
+    m_savedBuffers.emplace_back();
+  }
+  auto& saved   = m_savedBuffers[m_nSaved++];
+  saved.address = static_cast<char*>(address);
+  saved.bytes.assign(saved.address, saved.address + bytes);
+}
+
+void PodioOutput::restoreBuffers() {
+  // in reverse, a buffer saved twice (rounded, then sorted) gets its original bytes back
+  for (size_t i = m_nSaved; i-- > 0;) {
+    std::memcpy(m_savedBuffers[i].address, m_savedBuffers[i].bytes.data(), m_savedBuffers[i].bytes.size());
+  }
+  m_nSaved = 0;
+}
+
+void PodioOutput::resetBranches(const std::vector<std::pair<std::string, podio::CollectionBase*>>& collections) {
+  for (const auto& [collName, collBuffers] : collections) {
+    auto it = m_bindings.find(collName);
+    if (it != m_bindings.end()) {
+      // only the branches whose buffer moved are reconnected, the buffers of recycled collections
+      // and of the relations and vector members of a collection are often kept
+      auto& binding = it->second;
+      branchAddresses(collBuffers->getBuffers(), m_addresses);
+      const size_t n = std::min(binding.branches.size(), m_addresses.size());
+      for (size_t i = 0; i < n; ++i) {
+        if (binding.addresses[i] != m_addresses[i]) {
+          binding.branches[i]->SetAddress(const_cast<void*>(m_addresses[i]));
+          binding.addresses[i] = m_addresses[i];
         }
       }
     }
-    collBuffers->prepareForWrite();
   }
 }
 
@@ -92,13 +490,14 @@ void PodioOutput::createBranches(const std::vector<std::pair<std::string, podio:
     int isOn = 0;
     if (m_switch.isOn(collName)) {
       isOn = 1;
-      m_datatree->Branch(collName.c_str(), collClassName.c_str(), data);
+      std::vector<TBranch*> branches;
+      branches.push_back(m_datatree->Branch(collName.c_str(), collClassName.c_str(), data));
       // Create branches for collections holding relations
       if (auto* refColls = references) {
         int j = 0;
         for (auto& c : (*refColls)) {
           const auto brName = podio::root_utils::refBranch(collName, j);
-          m_datatree->Branch(brName.c_str(), c.get());
+          branches.push_back(m_datatree->Branch(brName.c_str(), c.get()));
           ++j;
         }
       }
@@ -108,25 +507,50 @@ void PodioOutput::createBranches(const std::vector<std::pair<std::string, podio:
         for (auto& [dataType, add] : (*vminfo)) {
           const std::string typeName = "vector<" + dataType + ">";
           const auto brName          = podio::root_utils::vecBranch(collName, j);
-          m_datatree->Branch(brName.c_str(), typeName.c_str(), add);
+          branches.push_back(m_datatree->Branch(brName.c_str(), typeName.c_str(), add));
           ++j;
         }
       }
+      configureBranches(collName, branches);
+      createPackedBranch(collName, *collBuffers);
+      auto& binding    = m_bindings[collName];
+      binding.branches = std::move(branches);
+      branchAddresses(buffers, binding.addresses);
     }
 
     const auto collID = m_podioDataSvc->getCollectionIDs()->collectionID(collName);
     const auto collType = collBuffers->getValueTypeName() + "Collection";
     collectionInfo->emplace_back(collID, std::move(collType), collBuffers->isSubsetCollection());
 
-    debug() << isOn << " Registering collection " << collClassName << " " << collName.c_str() << " containing type "
-            << className << endmsg;
-    collBuffers->prepareForWrite();
+    JUG_DEBUG(isOn << " Registering collection " << collClassName << " " << collName.c_str() << " containing type "
+                   << className);
   }
 
   m_metadatatree->Branch("CollectionTypeInfo", collectionInfo);
 }
 
 StatusCode PodioOutput::execute() {
+  // events rejected by a required filter are not written, the parent of forked workers writes none
+  const EventContext& ctx = Gaudi::Hive::currentContext();
+  if (!m_file || !m_filters.passed(ctx)) {
+    return StatusCode::SUCCESS;
+  }
+  // the store of the slot of the event, the slots share the collection IDs
+  m_podioDataSvc = PodioDataSvc::fromEventSvc(evtSvc().get(), ctx);
+  // the kept input collections are written even if no algorithm read them
+  if (m_podioDataSvc->readLazyCollections(m_switch).isFailure()) {
+    return StatusCode::FAILURE;
+  }
+  // oversized events are skipped instead of being written
+  if (!m_podioDataSvc->withinMemoryBudget()) {
+    return StatusCode::SUCCESS;
+  }
+  // the collections are prepared once for all the streams, whose changes in place are undone for the others
+  m_podioDataSvc->prepareForWrite();
+  m_restoreBuffers = (m_podioDataSvc->outputStreams() > 1);
+  if (m_writer.joinable()) {
+    return queueEvent();
+  }
   // for now assume identical content for every event
   // register for writing
   if (m_firstEvent) {
@@ -137,14 +561,177 @@ StatusCode PodioOutput::execute() {
     resetBranches(m_podioDataSvc->getReadCollections());
   }
   m_firstEvent = false;
+  reducePrecision(m_podioDataSvc->getCollections());
+  reducePrecision(m_podioDataSvc->getReadCollections());
+  packCellIDs(m_podioDataSvc->getCollections());
+  packCellIDs(m_podioDataSvc->getReadCollections());
   if (msgLevel(MSG::DEBUG)) {
     debug() << "Filling DataTree .." << endmsg;
   }
-  m_datatree->Fill();
-  m_evtMDtree->Fill();
+  if (m_parametersBranch != nullptr) {
+    m_parametersBranch->SetAddress(m_podioDataSvc->eventParameters().data());
+  }
+  m_evtMDBranch->SetAddress(m_podioDataSvc->getProvider().eventMetaDataPtr());
+  {
+    JUG_PROFILE_REGION("PodioOutput/fill");
+    m_datatree->Fill();
+    m_evtMDtree->Fill();
+  }
+  restoreBuffers();
+  // the branches exist after the first event, the following events can be written asynchronously
+  if (m_asyncWrite.value() && !m_firstEvent && m_asyncBranches.empty()) {
+    if (!startWriter()) {
+      warning() << "Asynchronous writing is not possible for this output, writing synchronously" << endmsg;
+      m_asyncWrite = false;
+    }
+  }
   return StatusCode::SUCCESS;
 }
 
+bool PodioOutput::startWriter() {
+  size_t nBranches = 0;
+  bool valid = true;
+  auto setup = [&](const std::string& name, const std::string& className, void* /* buffer */) {
+    AsyncBranch async;
+    async.branch = podio::root_utils::getBranch(m_datatree, name.c_str());
+    async.cls = TClass::GetClass(className.c_str());
+    if (async.branch == nullptr || async.cls == nullptr || async.cls->GetCollectionProxy() == nullptr) {
+      warning() << "Cannot stage branch " << name << " of type " << className << " for asynchronous writing" << endmsg;
+      valid = false;
+      return;
+    }
+    async.proxy.reset(async.cls->GetCollectionProxy()->Generate());
+    m_asyncBranches.push_back(std::move(async));
+    ++nBranches;
+  };
+  podio::root_utils::forEachBranchBuffer(m_switch, m_podioDataSvc->getCollections(), setup);
+  podio::root_utils::forEachBranchBuffer(m_switch, m_podioDataSvc->getReadCollections(), setup);
+  // the event parameters are copied into the slots, other branches (e.g. primitive types from
+  // DataHandle, the packed cellIDs) point to memory of the event thread
+  const size_t nOther = (m_parametersBranch != nullptr) ? 1 : 0;
+  if (!valid || m_evtMDBranch == nullptr ||
+      static_cast<size_t>(m_datatree->GetListOfBranches()->GetEntries()) != nBranches + nOther) {
+    m_asyncBranches.clear();
+    return false;
+  }
+
+  m_slots.resize(std::max(1, m_asyncQueueDepth.value()));
+  for (auto& slot : m_slots) {
+    for (const auto& async : m_asyncBranches) {
+      slot.buffers.push_back(async.cls->New());
+    }
+    m_freeSlots.push_back(&slot);
+  }
+  m_stopWriter = false;
+  m_writer = std::thread(&PodioOutput::writerLoop, this);
+  info() << "Writing " << nBranches << " branches asynchronously with up to " << m_slots.size() << " queued events"
+         << endmsg;
+  return true;
+}
+
+StatusCode PodioOutput::queueEvent() {
+  reducePrecision(m_podioDataSvc->getCollections());
+  reducePrecision(m_podioDataSvc->getReadCollections());
+
+  OutputSlot* slot = nullptr;
+  {
+    std::unique_lock<std::mutex> lock(m_queueMutex);
+    m_queueCond.wait(lock, [this] { return !m_freeSlots.empty(); });
+    slot = m_freeSlots.front();
+    m_freeSlots.pop_front();
+  }
+
+  // copy the event buffers into the slot, the store is cleared before the writer fills the tree
+  size_t i = 0;
+  bool valid = true;
+  auto copy = [&](const std::string& /* name */, const std::string& /* className */, void* buffer) {
+    if (i >= m_asyncBranches.size()) {
+      valid = false;
+      return;
+    }
+    auto* proxy = m_asyncBranches[i].proxy.get();
+    void* staged = slot->buffers[i];
+    size_t n = 0;
+    void* first = nullptr;
+    {
+      TVirtualCollectionProxy::TPushPop source(proxy, buffer);
+      n = proxy->Size();
+      first = (n > 0) ? proxy->At(0) : nullptr;
+    }
+    {
+      TVirtualCollectionProxy::TPushPop target(proxy, staged);
+      proxy->Clear();
+    }
+    if (n > 0) {
+      proxy->Insert(first, staged, n);
+    }
+    ++i;
+  };
+  podio::root_utils::forEachBranchBuffer(m_switch, m_podioDataSvc->getCollections(), copy);
+  podio::root_utils::forEachBranchBuffer(m_switch, m_podioDataSvc->getReadCollections(), copy);
+  restoreBuffers();
+  slot->evtMD = *m_podioDataSvc->getProvider().eventMetaDataPtr();
+  if (m_parametersBranch != nullptr) {
+    auto& parameters = m_podioDataSvc->eventParameters();
+    const auto* values = parameters.data();
+    slot->parameters.assign(values, values + parameters.size());
+  }
+
+  std::lock_guard<std::mutex> lock(m_queueMutex);
+  if (!valid || i != m_asyncBranches.size()) {
+    m_freeSlots.push_back(slot);
+    error() << "Output collections changed after the first event, cannot write asynchronously" << endmsg;
+    return StatusCode::FAILURE;
+  }
+  m_queuedSlots.push_back(slot);
+  m_queueCond.notify_all();
+  return StatusCode::SUCCESS;
+}
+
+void PodioOutput::writerLoop() {
+  std::unique_lock<std::mutex> lock(m_queueMutex);
+  while (true) {
+    m_queueCond.wait(lock, [this] { return m_stopWriter || !m_queuedSlots.empty(); });
+    if (m_queuedSlots.empty()) {
+      // stop requested and all events written
+      return;
+    }
+    OutputSlot* slot = m_queuedSlots.front();
+    m_queuedSlots.pop_front();
+    lock.unlock();
+
+    // only this thread touches the trees while writing asynchronously
+    for (size_t i = 0; i < m_asyncBranches.size(); ++i) {
+      m_asyncBranches[i].branch->SetAddress(&slot->buffers[i]);
+    }
+    m_evtMDBranch->SetAddress(&slot->evtMD);
+    if (m_parametersBranch != nullptr) {
+      m_parametersBranch->SetAddress(slot->parameters.data());
+    }
+    {
+      JUG_PROFILE_REGION("PodioOutput/fill");
+      m_datatree->Fill();
+      m_evtMDtree->Fill();
+    }
+
+    lock.lock();
+    m_freeSlots.push_back(slot);
+    m_queueCond.notify_all();
+  }
+}
+
+void PodioOutput::stopWriter() {
+  if (!m_writer.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    m_stopWriter = true;
+  }
+  m_queueCond.notify_all();
+  m_writer.join();
+}
+
 /** PodioOutput::finalize
  * has to happen after all algorithms that touch the data store finish.
  * Here the job options are retrieved and stored to disk as a branch
@@ -153,53 +740,28 @@ StatusCode PodioOutput::execute() {
  */
 StatusCode PodioOutput::finalize() {
   info() << "Finalizing output algorithm" << endmsg;
+  // write the queued events
+  stopWriter();
   if (GaudiAlgorithm::finalize().isFailure()) {
     return StatusCode::FAILURE;
   }
-  //// prepare job options metadata ///////////////////////
-  // retrieve the configuration of the job
-  // and write it to file as vector of strings
-  debug() << "Preparing job options metadata" << endmsg;
-  std::vector<std::string> config_data;
-  const auto& jobOptionsSvc         = Gaudi::svcLocator()->getOptsSvc();
-  const auto& configured_properties = jobOptionsSvc.items();
-  for (const auto& per_property : configured_properties) {
-    std::stringstream config_stream;
-    // sample output:
-    // HepMCToEDMConverter.genparticles = "GenParticles";
-    // Note that quotes are added to all property values,
-    // which leads to problems with ints, lists, dicts and bools.
-    // For theses types, the quotes must be removed in postprocessing.
-    config_stream << std::get<0>(per_property) << " = \"" << std::get<1>(per_property) << "\";" << std::endl;
-    config_data.push_back(config_stream.str());
-  }
-  // Some default components are not captured by the job option service
-  // and have to be traversed like this. Note that Gaudi!577 will improve this.
-  debug() << "Appending default component metadata" << endmsg;
-  for (const auto* name : {"ApplicationMgr", "MessageSvc", "NTupleSvc"}) {
-    std::stringstream config_stream;
-    auto svc = service<IProperty>(name);
-    if (!svc.isValid()) {
-      continue;
-    }
-    for (const auto* property : svc->getProperties()) {
-      config_stream << name << "." << property->name() << " = \"" << property->toString() << "\";" << std::endl;
-    }
-    config_data.push_back(config_stream.str());
+  if (m_podioDataSvc->forkParent()) {
+    return mergeWorkerOutputs();
   }
   //// finalize trees and file //////////////////////////////
-  debug() << "Finalizing trees and output file" << endmsg;
+  debug() << "Writing the job options and run metadata, finalizing trees and output file" << endmsg;
   m_file->cd();
-  m_metadatatree->Branch("gaudiConfigOptions", &config_data);
-  m_metadatatree->Branch("CollectionIDs", m_podioDataSvc->getCollectionIDs());
-  m_metadatatree->Fill();
-  m_colMDtree->Branch("colMD", "std::map<int,podio::GenericParameters>", m_podioDataSvc->getProvider().getColMetaDataMap() ) ;
-  m_colMDtree->Fill();
-  m_runMDtree->Branch("runMD", "std::map<int,podio::GenericParameters>", m_podioDataSvc->getProvider().getRunMetaDataMap() ) ;
-  m_runMDtree->Fill();
+  Jug::Base::fillOutputMetadata(*serviceLocator(), *m_podioDataSvc, *m_metadatatree, *m_colMDtree, *m_runMDtree);
   m_datatree->Write();
   m_file->Write();
   m_file->Close();
+  // the staged buffers are no longer connected to the trees
+  for (auto& slot : m_slots) {
+    for (size_t i = 0; i < m_asyncBranches.size(); ++i) {
+      m_asyncBranches[i].cls->Destructor(slot.buffers[i]);
+    }
+  }
+  m_slots.clear();
   info() << "Data written to: " << m_filename.value() << endmsg;
   if (!m_filenameRemote.value().empty()) {
     TFile::Cp(m_filename.value().c_str(), m_filenameRemote.value().c_str(), false);
@@ -207,3 +769,22 @@ StatusCode PodioOutput::finalize() {
   }
   return StatusCode::SUCCESS;
 }
+
+StatusCode PodioOutput::mergeWorkerOutputs() {
+  long long nEvents = 0;
+  std::string err;
+  if (!Jug::Base::mergeOutputs(m_filename.value(), m_workerOutputs, nEvents, err)) {
+    error() << "Cannot merge the outputs of the workers: " << err << endmsg;
+    return StatusCode::FAILURE;
+  }
+  for (const auto& filename : m_workerOutputs) {
+    std::remove(filename.c_str());
+  }
+  info() << "Merged " << nEvents << " events of " << m_workerOutputs.size() << " workers into " << m_filename.value()
+         << endmsg;
+  if (!m_filenameRemote.value().empty()) {
+    TFile::Cp(m_filename.value().c_str(), m_filenameRemote.value().c_str(), false);
+    info() << " and copied to: " << m_filenameRemote.value() << endmsg;
+  }
+  return StatusCode::SUCCESS;
+}
@@ -4,17 +4,30 @@
 #ifndef JUGBASE_PODIOOUTPUT_H
 #define JUGBASE_PODIOOUTPUT_H
 
+#include "JugBase/EventFilter.h"
+#include "JugBase/EventParameters.h"
 #include "JugBase/KeepDropSwitch.h"
+#include "JugBase/PackedCellIDs.h"
 #include "GaudiAlg/GaudiAlgorithm.h"
 #include "podio/CollectionBase.h"
+#include "podio/GenericParameters.h"
 
 #include "TTree.h"
 
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 #include <gsl/gsl>
 
 // forward declarations
+class TBranch;
+class TClass;
 class TFile;
+class TVirtualCollectionProxy;
 class PodioDataSvc;
 
 class PodioOutput : public GaudiAlgorithm {
@@ -23,17 +36,67 @@ public:
   /// Constructor.
   PodioOutput(const std::string& name, ISvcLocator* svcLoc);
 
-  /// Initialization of PodioOutput. Acquires the data service, creates trees and root file.
+  /// Initialization of PodioOutput. Acquires the data service and parses the settings.
   virtual StatusCode initialize();
+  /// Creates trees and root file, after the forking of the workers (ForkSvc) that read shards of the input.
+  /// The parent of the workers writes no file. Several instances write several output streams of the same
+  /// events, each with its own file, outputCommands and requireFilters.
+  virtual StatusCode start();
   /// Execute. For the first event creates branches for all collections known to PodioDataSvc and prepares them for
   /// writing. For the following events it reconnects the branches with collections and prepares them for write.
   virtual StatusCode execute();
   /// Finalize. Writes the meta data tree; writes file and cleans up all ROOT-pointers.
+  /// The parent of the workers merges their outputs instead.
   virtual StatusCode finalize();
 
 private:
   void resetBranches(const std::vector<std::pair<std::string, podio::CollectionBase*>>& collections);
   void createBranches(const std::vector<std::pair<std::string, podio::CollectionBase*>>& collections);
+  /// Addresses the branches of a collection are connected to
+  static void branchAddresses(const podio::CollectionBuffers& buffers, std::vector<const void*>& addresses);
+  /// Apply the basket size and compression settings for a collection to its branches
+  void configureBranches(const std::string& collName, const std::vector<TBranch*>& branches) const;
+  /// Round the floats of the buffers of the collections to their mantissa bits, after prepareForWrite
+  void reducePrecision(const std::vector<std::pair<std::string, podio::CollectionBase*>>& collections);
+  /// Mantissa bits of the floats of a collection, 23 (full precision) unless reduced by precisionSettings
+  int mantissaBits(const std::string& collName);
+  /// Create the branch of the packed cellIDs of a kept collection matching cellIDPacking
+  void createPackedBranch(const std::string& collName, podio::CollectionBase& collection);
+  /// Sort the buffers of the packed collections by cellID and pack their cellIDs, after prepareForWrite
+  void packCellIDs(const std::vector<std::pair<std::string, podio::CollectionBase*>>& collections);
+  /// Save the bytes of a buffer changed in place (reducePrecision, packCellIDs) if other streams write the event
+  void saveBuffer(void* address, size_t bytes);
+  /// Restore the saved buffers for the other streams, after the event is filled or staged
+  void restoreBuffers();
+  /// Basket size and compression override for the collections matching a pattern
+  struct BranchSettings {
+    std::string pattern;
+    int basketSize{0};
+    int compression{-1};
+  };
+
+  /// Branch filled by the writer thread
+  struct AsyncBranch {
+    TBranch* branch{nullptr};
+    TClass* cls{nullptr};
+    /// collection proxy used on the event thread to copy the buffers
+    std::unique_ptr<TVirtualCollectionProxy> proxy;
+  };
+  /// Copy of the branch buffers of one event, owned by the writer thread while it is queued
+  struct OutputSlot {
+    std::vector<void*> buffers;
+    podio::GenericParameters evtMD;
+    std::vector<Jug::Base::EventParameters::Value> parameters;
+  };
+  /// Prepare the branches and slots for the writer thread after the first event, false if not possible
+  bool startWriter();
+  /// Copy the buffers of the current event into a free slot and queue it for writing
+  StatusCode queueEvent();
+  void writerLoop();
+  void stopWriter();
+  /// Merge the outputs of the workers into the output file and remove them
+  StatusCode mergeWorkerOutputs();
+
   /// First event or not
   bool m_firstEvent;
   /// Root file name the output is written to
@@ -43,10 +106,78 @@ private:
       this, "outputCommands", {"keep *"}, "A set of commands to declare which collections to keep or drop."};
   Gaudi::Property<std::string> m_filenameRemote{
       this, "filenameRemote", "", "An optional file path to copy the outputfile to."};
+  Gaudi::Property<bool> m_shardFilenames{
+      this, "shardFilenames", false,
+      "Insert the shard of the input (e.g. _shard007of128) before the extension of the file names if sharded."};
+  Gaudi::Property<bool> m_asyncWrite{
+      this, "asyncWrite", false, "Fill the output trees on a writer thread while the next events are processed."};
+  Gaudi::Property<int> m_asyncQueueDepth{
+      this, "asyncQueueDepth", 2, "Maximum number of events waiting for the writer thread."};
+  Gaudi::Property<std::vector<std::string>> m_requireFilters{
+      this, "requireFilters", {}, "Algorithms whose filter decisions must all pass for an event to be written."};
+  /// Output file compression and branch tuning
+  Gaudi::Property<std::string> m_compressionAlgorithm{
+      this, "compressionAlgorithm", "",
+      "Compression algorithm of the output file (zlib, lzma, lz4, zstd), ROOT default if empty."};
+  Gaudi::Property<int> m_compressionLevel{this, "compressionLevel", -1, "Compression level, ROOT default if negative."};
+  Gaudi::Property<unsigned int> m_implicitMT{
+      this, "implicitMT", 0,
+      "Number of threads for ROOT implicit multithreading (parallel basket compression), off if 0."};
+  Gaudi::Property<long long> m_autoFlush{
+      this, "autoFlush", 0,
+      "TTree auto-flush setting (entries if positive, bytes if negative), ROOT default if 0."};
+  Gaudi::Property<int> m_basketSize{this, "basketSize", 0, "Basket size of the collection branches, ROOT default if 0."};
+  Gaudi::Property<std::vector<std::string>> m_branchSettings{
+      this, "branchSettings", {},
+      "Per-collection overrides '<pattern> <basketSize> [<algorithm> <level>]', later lines take precedence."};
+  Gaudi::Property<std::vector<std::string>> m_precisionSettings{
+      this, "precisionSettings", {},
+      "Per-collection float precision '<pattern> <mantissaBits>' (0 to 23), later lines take precedence."};
+  Gaudi::Property<std::vector<std::string>> m_cellIDPacking{
+      this, "cellIDPacking", {},
+      "Collections (patterns) sorted by cellID with the cellIDs delta-encoded in a <name>_cellIDs branch, "
+      "not for collections referenced by others."};
   /// Switch for keeping or dropping outputs
   KeepDropSwitch m_switch;
+  /// Filter decisions of requireFilters
+  Jug::Base::FilterDecisions m_filters;
+  /// Parsed branchSettings
+  std::vector<BranchSettings> m_parsedBranchSettings;
+  /// Parsed precisionSettings, and the mantissa bits of the collections seen
+  std::vector<std::pair<std::string, int>> m_parsedPrecisionSettings;
+  std::unordered_map<std::string, int> m_mantissaBits;
+  /// Offsets of the floats in the data of a type, and the proxy of its vector buffers, by data type
+  struct FloatLayout {
+    std::unique_ptr<TVirtualCollectionProxy> proxy;
+    std::vector<size_t> offsets;
+  };
+  std::unordered_map<std::string, FloatLayout> m_floatLayouts;
+  /// Packed cellIDs of a collection, and the address of the branch
+  struct PackedBranch {
+    std::unique_ptr<Jug::Base::CellIDLayout> layout;
+    std::vector<uint8_t> blob;
+    std::vector<uint8_t>* address{nullptr};
+    /// First reference vector of the OneToOne relations of the collection
+    size_t firstOneToOne{0};
+  };
+  /// Packed collections, by collection name
+  std::unordered_map<std::string, std::unique_ptr<PackedBranch>> m_packedBranches;
+  std::vector<uint32_t> m_packOrder;
+  std::vector<char> m_packScratch;
+  /// Buffers of the event changed in place, restored when other output streams write the event
+  struct SavedBuffer {
+    char* address{nullptr};
+    std::vector<char> bytes;
+  };
+  std::vector<SavedBuffer> m_savedBuffers;
+  size_t m_nSaved{0};
+  bool m_restoreBuffers{false};
   /// Needed for collection ID table
   PodioDataSvc* m_podioDataSvc;
+  /// Compression settings of the file
+  int m_compression{0};
+  /// Outputs of the forked workers, in the parent
+  std::vector<std::string> m_workerOutputs;
   /// The actual ROOT file
   std::unique_ptr<TFile> m_file;
   /// The tree to be filled with collections
@@ -58,6 +189,26 @@ private:
   gsl::owner<TTree*> m_colMDtree;
   /// The stored collections
   std::vector<podio::CollectionBase*> m_storedCollections;
+  /// Branches of a kept collection, in the order of branchAddresses, and the addresses they are connected to
+  struct BranchBinding {
+    std::vector<TBranch*> branches;
+    std::vector<const void*> addresses;
+  };
+  /// Bindings made with the branches, by collection name
+  std::unordered_map<std::string, BranchBinding> m_bindings;
+  std::vector<const void*> m_addresses;
+  /// Asynchronous writing: branches in the order of the collection buffers, the event slots and their queues
+  std::vector<AsyncBranch> m_asyncBranches;
+  TBranch* m_evtMDBranch{nullptr};
+  /// Branch of the event parameters, nullptr if no algorithm declared any
+  TBranch* m_parametersBranch{nullptr};
+  std::vector<OutputSlot> m_slots;
+  std::deque<OutputSlot*> m_freeSlots;
+  std::deque<OutputSlot*> m_queuedSlots;
+  std::mutex m_queueMutex;
+  std::condition_variable m_queueCond;
+  bool m_stopWriter{false};
+  std::thread m_writer;
 };
 
 #endif
@@ -0,0 +1,400 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "PodioOutputParquet.h"
+
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+#include "GaudiKernel/ThreadLocalContext.h"
+#include "JugBase/PodioDataSvc.h"
+#include "rootutils.h"
+
+#include "TClass.h"
+#include "TDataMember.h"
+#include "TDataType.h"
+#include "TVirtualCollectionProxy.h"
+
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <arrow/ipc/writer.h>
+#include <arrow/util/compression.h>
+#include <arrow/util/key_value_metadata.h>
+#include <arrow/util/thread_pool.h>
+#include <parquet/arrow/writer.h>
+#include <parquet/properties.h>
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(PodioOutputParquet)
+
+namespace {
+
+/// Column of the elements of a buffer: a basic member at an offset in the element
+struct Column {
+  std::string name;
+  size_t offset;
+  size_t size;
+  std::shared_ptr<arrow::DataType> type;
+};
+
+/// Arrow type of a basic ROOT type, nullptr if not supported
+std::shared_ptr<arrow::DataType> arrowType(EDataType type) {
+  switch (type) {
+  case kFloat_t:
+  case kFloat16_t:
+    return arrow::float32();
+  case kDouble_t:
+  case kDouble32_t:
+    return arrow::float64();
+  case kChar_t:
+    return arrow::int8();
+  case kUChar_t:
+  case kBool_t:
+    return arrow::uint8();
+  case kShort_t:
+    return arrow::int16();
+  case kUShort_t:
+    return arrow::uint16();
+  case kInt_t:
+    return arrow::int32();
+  case kUInt_t:
+    return arrow::uint32();
+  case kLong_t:
+  case kLong64_t:
+    return arrow::int64();
+  case kULong_t:
+  case kULong64_t:
+    return arrow::uint64();
+  default:
+    return nullptr;
+  }
+}
+
+/// Columns of the basic members of a class, with the members of the member classes as prefix.member
+/// and the elements of the arrays as member[i]. False with the member in unsupported if one is not
+/// a basic type, an enum or a class.
+bool addColumns(TClass& cls, const std::string& prefix, size_t offset, std::vector<Column>& columns,
+                std::string& unsupported) {
+  for (auto* obj : *cls.GetListOfDataMembers()) {
+    auto* member = static_cast<TDataMember*>(obj);
+    if (!member->IsPersistent() || (member->Property() & kIsStatic) != 0) {
+      continue;
+    }
+    // the elements of a std::array are its array member _M_elems
+    const std::string memberName = member->GetName();
+    const std::string name       = (memberName == "_M_elems" && !prefix.empty())
+                                       ? prefix.substr(0, prefix.size() - 1)
+                                       : prefix + memberName;
+    size_t count = 1;
+    for (int dim = 0; dim < member->GetArrayDim(); ++dim) {
+      count *= member->GetMaxIndex(dim);
+    }
+    auto element      = [&](size_t i) { return (count > 1) ? name + "[" + std::to_string(i) + "]" : name; };
+    const size_t base = offset + member->GetOffset();
+    if (member->IsBasic() || member->IsEnum()) {
+      auto type = member->IsEnum() ? arrow::int32()
+                                   : arrowType(static_cast<EDataType>(member->GetDataType()->GetType()));
+      if (type == nullptr) {
+        unsupported = name;
+        return false;
+      }
+      const size_t size = member->GetUnitSize();
+      for (size_t i = 0; i < count; ++i) {
+        columns.push_back({element(i), base + i * size, size, type});
+      }
+    } else if (TClass* memberClass = TClass::GetClass(member->GetTypeName());
+               memberClass != nullptr && memberClass->GetCollectionProxy() == nullptr) {
+      for (size_t i = 0; i < count; ++i) {
+        if (!addColumns(*memberClass, element(i) + ".", base + i * memberClass->Size(), columns, unsupported)) {
+          return false;
+        }
+      }
+    } else {
+      unsupported = name;
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+/// File of the buffers of one branch, and the columns of the events of the current batch
+struct PodioOutputParquet::Table {
+  std::string name;
+  std::unique_ptr<TVirtualCollectionProxy> proxy;
+  /// Bytes between the elements of the buffer
+  size_t stride{0};
+  std::vector<Column> columns;
+  std::shared_ptr<arrow::Schema> schema;
+  /// Event and entry columns, and the bytes of the member columns
+  std::vector<int64_t> events;
+  std::vector<int32_t> entries;
+  std::vector<std::vector<uint8_t>> values;
+  std::shared_ptr<arrow::io::FileOutputStream> file;
+  std::unique_ptr<parquet::arrow::FileWriter> parquet;
+  std::shared_ptr<arrow::ipc::RecordBatchWriter> ipc;
+};
+
+PodioOutputParquet::PodioOutputParquet(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {}
+
+PodioOutputParquet::~PodioOutputParquet() = default;
+
+StatusCode PodioOutputParquet::initialize() {
+  if (GaudiAlgorithm::initialize().isFailure()) {
+    return StatusCode::FAILURE;
+  }
+
+  // check whether we have the PodioEvtSvc active
+  m_podioDataSvc = PodioDataSvc::fromEventSvc(evtSvc().get());
+  if (m_podioDataSvc == nullptr) {
+    error() << "Failed to get the DataSvc" << endmsg;
+    return StatusCode::FAILURE;
+  }
+  if (m_format.value() != "parquet" && m_format.value() != "arrow") {
+    error() << "Unknown format " << m_format.value() << ", expected parquet or arrow" << endmsg;
+    return StatusCode::FAILURE;
+  }
+  if (!arrow::util::Codec::GetCompressionType(m_compression.value()).ok()) {
+    error() << "Unknown compression codec " << m_compression.value() << endmsg;
+    return StatusCode::FAILURE;
+  }
+  if (m_eventsPerRowGroup.value() < 1) {
+    error() << "At least one event per row group is needed" << endmsg;
+    return StatusCode::FAILURE;
+  }
+  if (m_threads.value() > 0) {
+    if (auto status = arrow::SetCpuThreadPoolCapacity(m_threads.value()); !status.ok()) {
+      error() << "Cannot set the Arrow thread pool capacity: " << status.ToString() << endmsg;
+      return StatusCode::FAILURE;
+    }
+  }
+  std::error_code ec;
+  std::filesystem::create_directories(m_directory.value(), ec);
+  if (ec) {
+    error() << "Failed to create " << m_directory.value() << ": " << ec.message() << endmsg;
+    return StatusCode::FAILURE;
+  }
+  m_switch = KeepDropSwitch(m_outputCommands);
+  if (std::string err; !m_filters.configure(serviceLocator(), m_requireFilters.value(), err)) {
+    error() << err << endmsg;
+    return StatusCode::FAILURE;
+  }
+  return StatusCode::SUCCESS;
+}
+
+bool PodioOutputParquet::createTables(const Collections& collections) {
+  const auto codec      = *arrow::util::Codec::GetCompressionType(m_compression.value());
+  const int level       = (m_compressionLevel.value() < 0) ? arrow::util::kUseDefaultCompressionLevel
+                                                           : m_compressionLevel.value();
+  const bool parquet    = (m_format.value() == "parquet");
+  const char* extension = parquet ? ".parquet" : ".arrow";
+  bool valid            = true;
+  podio::root_utils::forEachBranchBuffer(
+      m_switch, collections, [&](const std::string& name, const std::string& className, void* /* buffer */) {
+        if (!valid) {
+          return;
+        }
+        auto table  = std::make_unique<Table>();
+        table->name = name;
+        TClass* cls = TClass::GetClass(className.c_str());
+        if (cls == nullptr || cls->GetCollectionProxy() == nullptr) {
+          error() << "No dictionary for " << className << " of " << name << endmsg;
+          valid = false;
+          return;
+        }
+        table->proxy.reset(cls->GetCollectionProxy()->Generate());
+        if (TClass* value = table->proxy->GetValueClass(); value != nullptr) {
+          table->stride = value->Size();
+          if (std::string member; !addColumns(*value, "", 0, table->columns, member)) {
+            error() << "Cannot flatten member " << member << " of " << value->GetName() << " of " << name << endmsg;
+            valid = false;
+            return;
+          }
+        } else {
+          // vector members of basic types
+          table->stride = table->proxy->GetIncrement();
+          auto type     = arrowType(table->proxy->GetType());
+          if (type == nullptr) {
+            error() << "Cannot write the elements of " << className << " of " << name << endmsg;
+            valid = false;
+            return;
+          }
+          table->columns.push_back({"value", 0, table->stride, type});
+        }
+
+        arrow::FieldVector fields{arrow::field("event", arrow::int64(), false),
+                                  arrow::field("entry", arrow::int32(), false)};
+        for (const auto& column : table->columns) {
+          fields.push_back(arrow::field(column.name, column.type, false));
+        }
+        table->schema = arrow::schema(std::move(fields),
+                                      arrow::key_value_metadata({"podio.branch", "podio.type"}, {name, className}));
+        table->values.resize(table->columns.size());
+
+        const auto path = (std::filesystem::path(m_directory.value()) / (name + extension)).string();
+        auto file       = arrow::io::FileOutputStream::Open(path);
+        if (!file.ok()) {
+          error() << "Failed to open " << path << ": " << file.status().ToString() << endmsg;
+          valid = false;
+          return;
+        }
+        table->file = *file;
+        arrow::Status status;
+        if (parquet) {
+          parquet::WriterProperties::Builder properties;
+          properties.compression(codec);
+          properties.compression_level(level);
+          // the columns of a row group are compressed in parallel
+          auto arrowProperties = parquet::ArrowWriterProperties::Builder().set_use_threads(true)->build();
+          auto writer          = parquet::arrow::FileWriter::Open(*table->schema, arrow::default_memory_pool(),
+                                                         table->file, properties.build(), arrowProperties);
+          status               = writer.status();
+          if (writer.ok()) {
+            table->parquet = std::move(*writer);
+          }
+        } else {
+          auto options        = arrow::ipc::IpcWriteOptions::Defaults();
+          options.use_threads = true;
+          if (codec != arrow::Compression::UNCOMPRESSED) {
+            auto compressor = arrow::util::Codec::Create(codec, level);
+            if (!compressor.ok()) {
+              error() << "Cannot compress Arrow IPC files with " << m_compression.value() << ": "
+                      << compressor.status().ToString() << endmsg;
+              valid = false;
+              return;
+            }
+            options.codec = std::move(*compressor);
+          }
+          auto writer = arrow::ipc::MakeFileWriter(table->file, table->schema, options);
+          status      = writer.status();
+          if (writer.ok()) {
+            table->ipc = *writer;
+          }
+        }
+        if (!status.ok()) {
+          error() << "Failed to create the writer of " << path << ": " << status.ToString() << endmsg;
+          valid = false;
+          return;
+        }
+        debug() << "Writing " << name << " with " << table->columns.size() << " columns to " << path << endmsg;
+        m_tables.push_back(std::move(table));
+      });
+  return valid;
+}
+
+bool PodioOutputParquet::appendTables(const Collections& collections, size_t& table) {
+  m_podioDataSvc->prepareForWrite();
+  bool valid = true;
+  // the buffers are visited in the same order as when the tables were created
+  podio::root_utils::forEachBranchBuffer(
+      m_switch, collections, [&](const std::string& name, const std::string& /* className */, void* buffer) {
+        if (table >= m_tables.size() || m_tables[table]->name != name) {
+          valid = false;
+          return;
+        }
+        auto& t = *m_tables[table++];
+        TVirtualCollectionProxy::TPushPop helper(t.proxy.get(), buffer);
+        const size_t n = t.proxy->Size();
+        if (n == 0) {
+          return;
+        }
+        // the elements of the vector buffers are contiguous
+        const auto* first = static_cast<const uint8_t*>(t.proxy->At(0));
+        t.events.insert(t.events.end(), n, m_events);
+        for (size_t i = 0; i < n; ++i) {
+          t.entries.push_back(static_cast<int32_t>(i));
+        }
+        for (size_t c = 0; c < t.columns.size(); ++c) {
+          const auto& column = t.columns[c];
+          auto& values       = t.values[c];
+          const size_t start = values.size();
+          values.resize(start + n * column.size);
+          for (size_t i = 0; i < n; ++i) {
+            std::memcpy(values.data() + start + i * column.size, first + i * t.stride + column.offset, column.size);
+          }
+        }
+      });
+  return valid;
+}
+
+StatusCode PodioOutputParquet::execute() {
+  // events rejected by a required filter are not written
+  const EventContext& ctx = Gaudi::Hive::currentContext();
+  if (!m_filters.passed(ctx)) {
+    return StatusCode::SUCCESS;
+  }
+  // the store of the slot of the event, the slots share the collection IDs
+  m_podioDataSvc = PodioDataSvc::fromEventSvc(evtSvc().get(), ctx);
+  // the kept input collections are written even if no algorithm read them
+  if (m_podioDataSvc->readLazyCollections(m_switch).isFailure()) {
+    return StatusCode::FAILURE;
+  }
+  // oversized events are skipped instead of being written
+  if (!m_podioDataSvc->withinMemoryBudget()) {
+    return StatusCode::SUCCESS;
+  }
+  // for now assume identical content for every event
+  if (m_firstEvent) {
+    if (!createTables(m_podioDataSvc->getCollections()) || !createTables(m_podioDataSvc->getReadCollections())) {
+      return StatusCode::FAILURE;
+    }
+    m_firstEvent = false;
+  }
+  size_t table = 0;
+  if (!appendTables(m_podioDataSvc->getCollections(), table) ||
+      !appendTables(m_podioDataSvc->getReadCollections(), table) || table != m_tables.size()) {
+    error() << "Output collections changed after the first event" << endmsg;
+    return StatusCode::FAILURE;
+  }
+  ++m_events;
+  if (++m_batchEvents >= m_eventsPerRowGroup.value()) {
+    return writeBatch();
+  }
+  return StatusCode::SUCCESS;
+}
+
+StatusCode PodioOutputParquet::writeBatch() {
+  m_batchEvents = 0;
+  for (auto& table : m_tables) {
+    const auto rows = static_cast<int64_t>(table->events.size());
+    // the columns take over the batched values
+    arrow::ArrayVector arrays{
+        std::make_shared<arrow::Int64Array>(rows, arrow::Buffer::FromVector(std::move(table->events))),
+        std::make_shared<arrow::Int32Array>(rows, arrow::Buffer::FromVector(std::move(table->entries)))};
+    for (size_t c = 0; c < table->columns.size(); ++c) {
+      auto buffer = arrow::Buffer::FromVector(std::move(table->values[c]));
+      arrays.push_back(arrow::MakeArray(arrow::ArrayData::Make(table->columns[c].type, rows, {nullptr, buffer}, 0)));
+      table->values[c].clear();
+    }
+    table->events.clear();
+    table->entries.clear();
+    const auto status = (table->parquet != nullptr)
+                            ? table->parquet->WriteTable(*arrow::Table::Make(table->schema, arrays, rows), rows)
+                            : table->ipc->WriteRecordBatch(*arrow::RecordBatch::Make(table->schema, rows, arrays));
+    if (!status.ok()) {
+      error() << "Failed to write " << table->name << ": " << status.ToString() << endmsg;
+      return StatusCode::FAILURE;
+    }
+  }
+  return StatusCode::SUCCESS;
+}
+
+StatusCode PodioOutputParquet::finalize() {
+  info() << "Finalizing output algorithm" << endmsg;
+  StatusCode sc = (m_batchEvents > 0) ? writeBatch() : StatusCode::SUCCESS;
+  for (auto& table : m_tables) {
+    const auto status = (table->parquet != nullptr) ? table->parquet->Close() : table->ipc->Close();
+    if (!status.ok() || !table->file->Close().ok()) {
+      error() << "Failed to close the file of " << table->name << ": " << status.ToString() << endmsg;
+      sc = StatusCode::FAILURE;
+    }
+  }
+  m_tables.clear();
+  info() << m_events << " events written to " << m_directory.value() << endmsg;
+  if (GaudiAlgorithm::finalize().isFailure()) {
+    return StatusCode::FAILURE;
+  }
+  return sc;
+}
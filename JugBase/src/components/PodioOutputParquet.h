@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_PODIOOUTPUTPARQUET_H
+#define JUGBASE_PODIOOUTPUTPARQUET_H
+
+#include "JugBase/EventFilter.h"
+#include "JugBase/KeepDropSwitch.h"
+#include "GaudiAlg/GaudiAlgorithm.h"
+#include "podio/CollectionBase.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// forward declarations
+class PodioDataSvc;
+
+/** Columnar output of the podio collections, as Parquet files or Arrow IPC files of record batches.
+ *
+ * Writes the collections selected with the same outputCommands as PodioOutput to a directory with one
+ * file per branch of the TTree output: the members of the objects of a collection are flattened into
+ * columns (e.g. position.x), the relations (name#N) and vector members (name_N) are files of their own.
+ * Every row has the event number (the number of the event in this output) and the entry in the
+ * buffer of the event, so that the begin and end members of the objects index the rows of the
+ * relations, and the index of the ObjectIDs of a relation the entries of the related collection.
+ * The events are batched into row groups (record batches) of eventsPerRowGroup events, compressed by
+ * the threads of the Arrow thread pool.
+ *
+ * \ingroup base
+ */
+class PodioOutputParquet : public GaudiAlgorithm {
+
+public:
+  PodioOutputParquet(const std::string& name, ISvcLocator* svcLoc);
+  ~PodioOutputParquet() override;
+
+  /// Initialization. Acquires the data service, creates the output directory.
+  StatusCode initialize() override;
+  /// Execute. For the first event creates the tables from all collections known to PodioDataSvc.
+  /// For every event the buffers are appended to the columns, which are written every eventsPerRowGroup events.
+  StatusCode execute() override;
+  /// Finalize. Writes the last row group and closes the files.
+  StatusCode finalize() override;
+
+private:
+  using Collections = std::vector<std::pair<std::string, podio::CollectionBase*>>;
+  struct Table;
+
+  /// Create the tables of the buffers of the collections, false on failure
+  bool createTables(const Collections& collections);
+  /// Append the buffers of the collections of the event to the tables, starting at the given table index
+  bool appendTables(const Collections& collections, size_t& table);
+  /// Write the columns of the batched events as a row group of every table
+  StatusCode writeBatch();
+
+  /// Directory the files are written to
+  Gaudi::Property<std::string> m_directory{this, "directory", "output.parquet", "Directory of the files to create"};
+  /// Commands which output is to be kept
+  Gaudi::Property<std::vector<std::string>> m_outputCommands{
+      this, "outputCommands", {"keep *"}, "A set of commands to declare which collections to keep or drop."};
+  Gaudi::Property<std::string> m_format{this, "format", "parquet",
+                                        "File format, parquet or arrow (Arrow IPC file of record batches)."};
+  Gaudi::Property<std::string> m_compression{
+      this, "compression", "zstd",
+      "Compression codec (zstd, lz4_frame, snappy, gzip, uncompressed), zstd or lz4_frame for arrow."};
+  Gaudi::Property<int> m_compressionLevel{this, "compressionLevel", -1,
+                                          "Compression level, codec default if negative."};
+  Gaudi::Property<int> m_eventsPerRowGroup{this, "eventsPerRowGroup", 1000,
+                                           "Number of events per row group (record batch)."};
+  Gaudi::Property<int> m_threads{this, "threads", 0,
+                                 "Threads of the Arrow thread pool for the compression, Arrow default if 0."};
+  Gaudi::Property<std::vector<std::string>> m_requireFilters{
+      this, "requireFilters", {}, "Algorithms whose filter decisions must all pass for an event to be written."};
+  /// Switch for keeping or dropping outputs
+  KeepDropSwitch m_switch;
+  /// Filter decisions of requireFilters
+  Jug::Base::FilterDecisions m_filters;
+  /// Needed for collection ID table
+  PodioDataSvc* m_podioDataSvc{nullptr};
+  /// Tables in the order of the collection buffers, created with the first event
+  std::vector<std::unique_ptr<Table>> m_tables;
+  bool m_firstEvent{true};
+  /// Events written, and events in the current batch
+  long long m_events{0};
+  int m_batchEvents{0};
+};
+
+#endif
@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "PodioOutputRNTuple.h"
+
+#include "GaudiKernel/ISvcLocator.h"
+#include "GaudiKernel/ThreadLocalContext.h"
+#include "JugBase/Logging.h"
+#include "JugBase/OutputMetadata.h"
+#include "JugBase/PodioDataSvc.h"
+#include "TBranch.h"
+#include "TFile.h"
+#include "rootutils.h"
+
+#include <ROOT/RField.hxx>
+#include <ROOT/RNTuple.hxx>
+#include <ROOT/RNTupleModel.hxx>
+#include <ROOT/RNTupleOptions.hxx>
+
+using ROOT::Experimental::RNTupleModel;
+using ROOT::Experimental::RNTupleWriteOptions;
+using ROOT::Experimental::RNTupleWriter;
+using ROOT::Experimental::Detail::RFieldBase;
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(PodioOutputRNTuple)
+
+PodioOutputRNTuple::PodioOutputRNTuple(const std::string& name, ISvcLocator* svcLoc)
+    : GaudiAlgorithm(name, svcLoc) {}
+
+StatusCode PodioOutputRNTuple::initialize() {
+  if (GaudiAlgorithm::initialize().isFailure()) {
+    return StatusCode::FAILURE;
+  }
+
+  // check whether we have the PodioEvtSvc active
+  m_podioDataSvc = PodioDataSvc::fromEventSvc(evtSvc().get());
+  if (m_podioDataSvc == nullptr) {
+    error() << "Failed to get the DataSvc" << endmsg;
+    return StatusCode::FAILURE;
+  }
+
+  if (!m_compressionAlgorithm.value().empty()) {
+    m_compression =
+        podio::root_utils::compressionSettings(m_compressionAlgorithm.value(), m_compressionLevel.value());
+    if (m_compression < 0) {
+      error() << "Unknown compression algorithm " << m_compressionAlgorithm.value() << endmsg;
+      return StatusCode::FAILURE;
+    }
+  }
+
+  m_file = std::unique_ptr<TFile>(TFile::Open(m_filename.value().c_str(), "RECREATE", "data file"));
+  if (m_file == nullptr || m_file->IsZombie()) {
+    error() << "Failed to open " << m_filename.value() << endmsg;
+    return StatusCode::FAILURE;
+  }
+  // The metadata trees are written to the ROOT file and owned by it
+  m_metadatatree = new TTree("metadata", "Metadata tree");
+  m_runMDtree    = new TTree("run_metadata", "Run metadata tree");
+  m_evtMDtree    = new TTree("evt_metadata", "Event metadata tree");
+  m_colMDtree    = new TTree("col_metadata", "Collection metadata tree");
+
+  // the address is set to the event metadata of the slot of each event
+  m_evtMDBranch = m_evtMDtree->Branch("evtMD", "GenericParameters", m_podioDataSvc->getProvider().eventMetaDataPtr());
+  m_switch = KeepDropSwitch(m_outputCommands);
+  if (std::string err; !m_filters.configure(serviceLocator(), m_requireFilters.value(), err)) {
+    error() << err << endmsg;
+    return StatusCode::FAILURE;
+  }
+  return StatusCode::SUCCESS;
+}
+
+bool PodioOutputRNTuple::createFields(const Collections& collections, RNTupleModel& model,
+                                      std::vector<std::tuple<int, std::string, bool>>& collectionInfo) {
+  bool valid = true;
+  podio::root_utils::forEachBranchBuffer(
+      m_switch, collections, [&](const std::string& name, const std::string& className, void* /* buffer */) {
+        auto field = RFieldBase::Create(name, className);
+        if (!field) {
+          error() << "Cannot create RNTuple field " << name << " of type " << className << endmsg;
+          valid = false;
+          return;
+        }
+        model.AddField(field.Unwrap());
+        m_fields.push_back(name);
+      });
+
+  for (const auto& [collName, coll] : collections) {
+    const auto collID   = m_podioDataSvc->getCollectionIDs()->collectionID(collName);
+    const auto collType = coll->getValueTypeName() + "Collection";
+    collectionInfo.emplace_back(collID, collType, coll->isSubsetCollection());
+    JUG_DEBUG(m_switch.isOn(collName) << " Registering collection " << collName << " containing type "
+                                      << coll->getValueTypeName());
+  }
+  return valid;
+}
+
+void PodioOutputRNTuple::connectFields(const Collections& collections, size_t& field) {
+  m_podioDataSvc->prepareForWrite();
+  // the buffers are visited in the same order as when the fields were created
+  podio::root_utils::forEachBranchBuffer(
+      m_switch, collections, [&](const std::string& /* name */, const std::string& /* className */, void* buffer) {
+        m_entry->CaptureValueUnsafe(m_fields[field++], buffer);
+      });
+}
+
+StatusCode PodioOutputRNTuple::execute() {
+  // events rejected by a required filter are not written
+  const EventContext& ctx = Gaudi::Hive::currentContext();
+  if (!m_filters.passed(ctx)) {
+    return StatusCode::SUCCESS;
+  }
+  // the store of the slot of the event, the slots share the collection IDs
+  m_podioDataSvc = PodioDataSvc::fromEventSvc(evtSvc().get(), ctx);
+  // the kept input collections are written even if no algorithm read them
+  if (m_podioDataSvc->readLazyCollections(m_switch).isFailure()) {
+    return StatusCode::FAILURE;
+  }
+  // oversized events are skipped instead of being written
+  if (!m_podioDataSvc->withinMemoryBudget()) {
+    return StatusCode::SUCCESS;
+  }
+  // for now assume identical content for every event
+  if (m_firstEvent) {
+    auto model = RNTupleModel::Create();
+    // collectionID, collection type, subset collection
+    auto* collectionInfo = new std::vector<std::tuple<int, std::string, bool>>();
+    if (!createFields(m_podioDataSvc->getCollections(), *model, *collectionInfo) ||
+        !createFields(m_podioDataSvc->getReadCollections(), *model, *collectionInfo)) {
+      delete collectionInfo;
+      return StatusCode::FAILURE;
+    }
+    m_metadatatree->Branch("CollectionTypeInfo", collectionInfo);
+    // other branches of the event data tree (e.g. primitive types from DataHandle) have no collection
+    if (m_podioDataSvc->eventDataTree()->GetListOfBranches()->GetEntries() > 0) {
+      warning() << "Event data that are not podio collections are not written to the RNTuple" << endmsg;
+    }
+
+    RNTupleWriteOptions options;
+    if (m_compression >= 0) {
+      options.SetCompression(m_compression);
+    }
+    m_entry  = model->GetDefaultEntry();
+    m_writer = RNTupleWriter::Append(std::move(model), "events", *m_file, options);
+    m_firstEvent = false;
+  }
+  size_t field = 0;
+  connectFields(m_podioDataSvc->getCollections(), field);
+  connectFields(m_podioDataSvc->getReadCollections(), field);
+  if (msgLevel(MSG::DEBUG)) {
+    debug() << "Filling RNTuple .." << endmsg;
+  }
+  m_writer->Fill();
+  m_evtMDBranch->SetAddress(m_podioDataSvc->getProvider().eventMetaDataPtr());
+  m_evtMDtree->Fill();
+  return StatusCode::SUCCESS;
+}
+
+/** PodioOutputRNTuple::finalize
+ * has to happen after all algorithms that touch the data store finish.
+ * Here the job options are retrieved and stored to disk as a branch
+ * in the metadata tree, as in PodioOutput.
+ *
+ */
+StatusCode PodioOutputRNTuple::finalize() {
+  info() << "Finalizing output algorithm" << endmsg;
+  // commit the last cluster of the RNTuple
+  m_writer.reset();
+  if (GaudiAlgorithm::finalize().isFailure()) {
+    return StatusCode::FAILURE;
+  }
+  //// finalize trees and file //////////////////////////////
+  debug() << "Writing the job options and run metadata, finalizing trees and output file" << endmsg;
+  m_file->cd();
+  Jug::Base::fillOutputMetadata(*serviceLocator(), *m_podioDataSvc, *m_metadatatree, *m_colMDtree, *m_runMDtree);
+  m_file->Write();
+  m_file->Close();
+  info() << "Data written to: " << m_filename.value() << endmsg;
+  if (!m_filenameRemote.value().empty()) {
+    TFile::Cp(m_filename.value().c_str(), m_filenameRemote.value().c_str(), false);
+    info() << " and copied to: " << m_filenameRemote.value() << endmsg;
+  }
+  return StatusCode::SUCCESS;
+}
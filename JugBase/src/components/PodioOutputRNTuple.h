@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBASE_PODIOOUTPUTRNTUPLE_H
+#define JUGBASE_PODIOOUTPUTRNTUPLE_H
+
+#include "JugBase/EventFilter.h"
+#include "JugBase/KeepDropSwitch.h"
+#include "GaudiAlg/GaudiAlgorithm.h"
+#include "podio/CollectionBase.h"
+
+#include "TTree.h"
+
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <gsl/gsl>
+
+// forward declarations
+class TFile;
+class PodioDataSvc;
+namespace ROOT::Experimental {
+class REntry;
+class RNTupleModel;
+class RNTupleWriter;
+} // namespace ROOT::Experimental
+
+/** Output of the podio collections to an RNTuple.
+ *
+ * Writes the same collections as PodioOutput (selected with the same outputCommands) as fields of an
+ * RNTuple "events", one field per branch of the TTree output. The metadata is written to the same
+ * metadata, run_metadata, evt_metadata and col_metadata trees as PodioOutput.
+ *
+ * \ingroup base
+ */
+class PodioOutputRNTuple : public GaudiAlgorithm {
+
+public:
+  /// Constructor.
+  PodioOutputRNTuple(const std::string& name, ISvcLocator* svcLoc);
+
+  /// Initialization. Acquires the data service, creates the metadata trees and root file.
+  virtual StatusCode initialize();
+  /// Execute. For the first event creates the RNTuple model from all collections known to PodioDataSvc.
+  /// For every event the fields are connected to the collection buffers and an entry is filled.
+  virtual StatusCode execute();
+  /// Finalize. Closes the RNTuple, writes the meta data trees and the file.
+  virtual StatusCode finalize();
+
+private:
+  using Collections = std::vector<std::pair<std::string, podio::CollectionBase*>>;
+  /// Create the fields for the collections and record their type info, false on failure
+  bool createFields(const Collections& collections, ROOT::Experimental::RNTupleModel& model,
+                    std::vector<std::tuple<int, std::string, bool>>& collectionInfo);
+  /// Connect the fields to the collection buffers of the event, starting at the given field index
+  void connectFields(const Collections& collections, size_t& field);
+
+  /// First event or not
+  bool m_firstEvent{true};
+  /// Root file name the output is written to
+  Gaudi::Property<std::string> m_filename{this, "filename", "output.root", "Name of the file to create"};
+  /// Commands which output is to be kept
+  Gaudi::Property<std::vector<std::string>> m_outputCommands{
+      this, "outputCommands", {"keep *"}, "A set of commands to declare which collections to keep or drop."};
+  Gaudi::Property<std::string> m_filenameRemote{
+      this, "filenameRemote", "", "An optional file path to copy the outputfile to."};
+  Gaudi::Property<std::string> m_compressionAlgorithm{
+      this, "compressionAlgorithm", "",
+      "Compression algorithm of the output file (zlib, lzma, lz4, zstd), RNTuple default if empty."};
+  Gaudi::Property<int> m_compressionLevel{this, "compressionLevel", -1,
+                                          "Compression level, algorithm default if negative."};
+  Gaudi::Property<std::vector<std::string>> m_requireFilters{
+      this, "requireFilters", {}, "Algorithms whose filter decisions must all pass for an event to be written."};
+  /// Switch for keeping or dropping outputs
+  KeepDropSwitch m_switch;
+  /// Filter decisions of requireFilters
+  Jug::Base::FilterDecisions m_filters;
+  /// Needed for collection ID table
+  PodioDataSvc* m_podioDataSvc{nullptr};
+  /// The actual ROOT file
+  std::unique_ptr<TFile> m_file;
+  /// The writer of the events RNTuple and its entry, created with the first event
+  std::unique_ptr<ROOT::Experimental::RNTupleWriter> m_writer;
+  ROOT::Experimental::REntry* m_entry{nullptr};
+  /// Compression settings of the RNTuple, -1 for the default
+  int m_compression{-1};
+  /// Names of the fields in the order of the collection buffers
+  std::vector<std::string> m_fields;
+  /// The trees to be filled with meta data
+  gsl::owner<TTree*> m_metadatatree{nullptr};
+  gsl::owner<TTree*> m_runMDtree{nullptr};
+  gsl::owner<TTree*> m_evtMDtree{nullptr};
+  gsl::owner<TTree*> m_colMDtree{nullptr};
+  TBranch* m_evtMDBranch{nullptr};
+};
+
+#endif
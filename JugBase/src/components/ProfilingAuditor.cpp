@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Gaudi/Property.h"
+#include "GaudiKernel/Auditor.h"
+
+#include "JugBase/Profiling.h"
+
+namespace Jug::Base {
+
+/** Profiler regions of the algorithm executions.
+ *
+ *  Every execute() of an algorithm is a region named after the algorithm instance (see
+ *  ProfileRegion), nested for the algorithms run by sequencers, so that VTune, Nsight Systems
+ *  and perf attribute the time of the ACTS and DD4hep frames to the algorithms. The stages within
+ *  the algorithms are regions of their own (JUG_PROFILE_REGION). Only algorithms matching one of the
+ *  algorithms prefixes are annotated, if given.
+ *
+ *  Needs a build with JUGGLER_ENABLE_ITT, JUGGLER_ENABLE_NVTX or JUGGLER_ENABLE_SDT, does nothing
+ *  otherwise. Enable with ApplicationMgr().AuditAlgorithms = True and
+ *  AuditorSvc().Auditors = ["Jug::Base::ProfilingAuditor"].
+ *
+ * \ingroup base
+ */
+class ProfilingAuditor : public Auditor {
+public:
+  using Auditor::after;
+  using Auditor::Auditor;
+  using Auditor::before;
+
+  StatusCode initialize() override {
+    if (Auditor::initialize().isFailure()) {
+      return StatusCode::FAILURE;
+    }
+    if (!profilingEnabled()) {
+      warning() << "Built without profiler annotations (JUGGLER_ENABLE_ITT, JUGGLER_ENABLE_NVTX or "
+                   "JUGGLER_ENABLE_SDT), the algorithms are not annotated"
+                << endmsg;
+    }
+    return StatusCode::SUCCESS;
+  }
+
+  void before(StandardEventType evt, const std::string& caller) override {
+    if (!profilingEnabled() || evt != IAuditor::Execute) {
+      return;
+    }
+    const ProfileRegion* r = region(caller);
+    if (r != nullptr) {
+      r->begin();
+    }
+    s_regions.push_back(r);
+  }
+
+  void after(StandardEventType evt, const std::string& /* caller */, const StatusCode& /* sc */) override {
+    if (!profilingEnabled() || evt != IAuditor::Execute || s_regions.empty()) {
+      return;
+    }
+    const ProfileRegion* r = s_regions.back();
+    s_regions.pop_back();
+    if (r != nullptr) {
+      r->end();
+    }
+  }
+
+private:
+  // region of an algorithm, made on its first execution, nullptr if it is not annotated
+  const ProfileRegion* region(const std::string& algorithm) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_regions.find(algorithm);
+    if (it == m_regions.end()) {
+      const auto& prefixes = m_algorithms.value();
+      const bool annotated = prefixes.empty() || std::any_of(prefixes.begin(), prefixes.end(), [&](const auto& p) {
+                               return algorithm.compare(0, p.size(), p) == 0;
+                             });
+      it = m_regions.emplace(algorithm, annotated ? std::make_unique<const ProfileRegion>(algorithm) : nullptr).first;
+    }
+    return it->second.get();
+  }
+
+  Gaudi::Property<std::vector<std::string>> m_algorithms{
+      this, "algorithms", {}, "Prefixes of the names of the annotated algorithms, all if empty"};
+
+  std::mutex m_mutex;
+  std::map<std::string, std::unique_ptr<const ProfileRegion>> m_regions;
+  // regions of the algorithms being executed on this thread
+  static thread_local std::vector<const ProfileRegion*> s_regions;
+};
+
+thread_local std::vector<const ProfileRegion*> ProfilingAuditor::s_regions;
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(ProfilingAuditor)
+
+} // namespace Jug::Base
@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "RandomSvc.h"
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(RandomSvc)
+
+using namespace Jug::Base::Random;
+
+RandomSvc::RandomSvc(const std::string& name, ISvcLocator* svc) : base_class(name, svc) {}
+
+RandomSvc::~RandomSvc() = default;
+
+StatusCode RandomSvc::initialize()
+{
+  StatusCode sc = Service::initialize();
+  if (!sc.isSuccess())
+  {
+    fatal() << "Error initializing RandomSvc" << endmsg;
+    return sc;
+  }
+  m_jobKey = job_key(m_seed.value(), m_run.value());
+  info() << "RandomSvc initialized with seed " << m_seed.value() << " and run " << m_run.value() << endmsg;
+  return StatusCode::SUCCESS;
+}
+
+uint64_t RandomSvc::eventKey(std::string_view algorithm, uint64_t event) const
+{
+  return event_key(m_jobKey, algorithm, event);
+}
@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef RANDOMSVC_H
+#define RANDOMSVC_H
+
+#include "Gaudi/Property.h"
+#include "GaudiKernel/Service.h"
+
+#include "JugBase/IRandomSvc.h"
+
+/** Counter-based random number service.
+ *
+ *  The keys are derived from the seed and run number of the job, the event number and the
+ *  algorithm name, so that the same event is digitized identically in any job that shares the
+ *  seed and run, whatever the number of threads or the order of the events.
+ */
+class RandomSvc : public extends<Service, IRandomSvc> {
+private:
+  Gaudi::Property<uint64_t> m_seed{this, "seed", 1};
+  Gaudi::Property<uint64_t> m_run{this, "runNumber", 0};
+
+  uint64_t m_jobKey{0};
+
+public:
+  RandomSvc(const std::string& name, ISvcLocator* svc);
+
+  virtual ~RandomSvc();
+
+  virtual StatusCode initialize() final;
+  virtual StatusCode finalize() final { return StatusCode::SUCCESS; }
+
+  virtual uint64_t eventKey(std::string_view algorithm, uint64_t event) const;
+};
+
+#endif
@@ -0,0 +1,175 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "Gaudi/Property.h"
+#include "GaudiAlg/GaudiAlgorithm.h"
+#include "GaudiKernel/IEventProcessor.h"
+#include "GaudiKernel/ThreadLocalContext.h"
+
+#include "JugBase/DataHandle.h"
+#include "JugBase/DataHandleArray.h"
+#include "JugBase/SimHitFile.h"
+
+#include "edm4hep/CaloHitContributionCollection.h"
+#include "edm4hep/SimCalorimeterHitCollection.h"
+#include "edm4hep/SimTrackerHitCollection.h"
+
+namespace Jug::Base {
+
+/** Input of simulated hits from a memory-mapped SimHitFile (written by jug_simhit_convert).
+ *
+ *  Replaces PodioInput and the input files of the data service for repeated digitization passes
+ *  over the same sample: the hits of the event are copied from the page cache into the collections,
+ *  without ROOT decompression. The collections have the names of the file unless renamed by the
+ *  output properties, the contributions of a calorimeter collection go to <name>Contributions. The
+ *  relations to the MC particles are not in the file.
+ *
+ *  The event is the event number of the context plus firstEntry, so that the slots read different
+ *  events, and the run stops after the last event of the file (the data service has no input).
+ *
+ *  \ingroup base
+ */
+class SimHitFileInput : public GaudiAlgorithm {
+private:
+  Gaudi::Property<std::string> m_input{this, "input", "", "Simulated hit file (jug_simhit_convert)"};
+  Gaudi::Property<std::vector<std::string>> m_calorimeterNames{
+      this, "calorimeterCollections", {}, "Calorimeter hit collections of the file to read"};
+  DataHandleArray<edm4hep::SimCalorimeterHitCollection> m_calorimeterHits{
+      this, "calorimeterOutputs", "Calorimeter hit collections (the names of the file if empty)",
+      Gaudi::DataHandle::Writer};
+  DataHandleArray<edm4hep::CaloHitContributionCollection> m_contributions{
+      this, "contributionOutputs", "Contribution collections (<name>Contributions if empty)",
+      Gaudi::DataHandle::Writer};
+  Gaudi::Property<std::vector<std::string>> m_trackerNames{
+      this, "trackerCollections", {}, "Tracker hit collections of the file to read"};
+  DataHandleArray<edm4hep::SimTrackerHitCollection> m_trackerHits{
+      this, "trackerOutputs", "Tracker hit collections (the names of the file if empty)", Gaudi::DataHandle::Writer};
+  Gaudi::Property<uint64_t> m_firstEntry{this, "firstEntry", 0, "First event of the file"};
+  Gaudi::Property<uint64_t> m_prefetchEvents{this, "prefetchEvents", 0,
+                                             "Events after the current one read ahead by the kernel, off if 0"};
+
+  SimHitFile m_file;
+  std::vector<size_t> m_calorimeterIndices;
+  std::vector<size_t> m_trackerIndices;
+
+public:
+  SimHitFileInput(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
+    // the outputs default to the names of the file, set before the handles are declared
+    m_calorimeterNames.declareUpdateHandler([this](Gaudi::Details::PropertyBase& /* p */) {
+      if (m_calorimeterHits.empty()) {
+        setProperty("calorimeterOutputs", m_calorimeterNames.value()).ignore();
+      }
+      if (m_contributions.empty()) {
+        std::vector<std::string> contributions;
+        for (const auto& collName : m_calorimeterNames.value()) {
+          contributions.push_back(collName + "Contributions");
+        }
+        setProperty("contributionOutputs", contributions).ignore();
+      }
+    });
+    m_trackerNames.declareUpdateHandler([this](Gaudi::Details::PropertyBase& /* p */) {
+      if (m_trackerHits.empty()) {
+        setProperty("trackerOutputs", m_trackerNames.value()).ignore();
+      }
+    });
+  }
+
+  StatusCode initialize() override {
+    if (GaudiAlgorithm::initialize().isFailure()) {
+      return StatusCode::FAILURE;
+    }
+    if (!m_file.open(m_input.value())) {
+      error() << "Cannot read the simulated hit file " << m_input.value() << endmsg;
+      return StatusCode::FAILURE;
+    }
+    if (m_calorimeterHits.size() != m_calorimeterNames.value().size() ||
+        m_contributions.size() != m_calorimeterNames.value().size() ||
+        m_trackerHits.size() != m_trackerNames.value().size()) {
+      error() << "One output collection is needed for each collection of the file" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    for (const auto& [names, kind, indices] :
+         {std::tuple{&m_calorimeterNames.value(), SimHitFile::Kind::Calorimeter, &m_calorimeterIndices},
+          std::tuple{&m_trackerNames.value(), SimHitFile::Kind::Tracker, &m_trackerIndices}}) {
+      for (const auto& collName : *names) {
+        const int index = m_file.collection(collName);
+        if (index < 0 || m_file.collections()[index].kind != kind) {
+          error() << "Requested product " << collName << " not found in " << m_input.value() << endmsg;
+          return StatusCode::FAILURE;
+        }
+        indices->push_back(index);
+      }
+    }
+    info() << "Reading " << m_file.entries() << " events of " << m_input.value() << endmsg;
+    return StatusCode::SUCCESS;
+  }
+
+  StatusCode execute() override {
+    const uint64_t event = m_firstEntry.value() + Gaudi::Hive::currentContext().evt();
+    if (event >= m_file.entries()) {
+      // events of other slots started before the run stopped
+      setFilterPassed(false);
+      return StatusCode::SUCCESS;
+    }
+    if (m_prefetchEvents.value() > 0) {
+      m_file.prefetch(event + 1, event + 1 + m_prefetchEvents.value());
+    }
+
+    SimHitFile::CalorimeterHits chits;
+    for (size_t i = 0; i < m_calorimeterIndices.size(); ++i) {
+      m_file.calorimeterHits(m_calorimeterIndices[i], event, chits);
+      auto* hits          = m_calorimeterHits[i].createAndPut(chits.size);
+      auto* contributions = m_contributions[i].createAndPut(chits.contributionBegin[chits.size] -
+                                                            chits.contributionBegin[0]);
+      for (size_t h = 0; h < chits.size; ++h) {
+        auto hit = hits->create();
+        hit.setCellID(chits.cellID[h]);
+        hit.setEnergy(chits.energy[h]);
+        hit.setPosition({chits.position[h].x, chits.position[h].y, chits.position[h].z});
+        for (uint32_t c = chits.contributionBegin[h]; c < chits.contributionBegin[h + 1]; ++c) {
+          auto contribution = contributions->create();
+          contribution.setPDG(chits.pdg[c]);
+          contribution.setEnergy(chits.contributionEnergy[c]);
+          contribution.setTime(chits.time[c]);
+          contribution.setStepPosition({chits.stepPosition[c].x, chits.stepPosition[c].y, chits.stepPosition[c].z});
+          hit.addToContributions(contribution);
+        }
+      }
+    }
+    SimHitFile::TrackerHits thits;
+    for (size_t i = 0; i < m_trackerIndices.size(); ++i) {
+      m_file.trackerHits(m_trackerIndices[i], event, thits);
+      auto* hits = m_trackerHits[i].createAndPut(thits.size);
+      for (size_t h = 0; h < thits.size; ++h) {
+        auto hit = hits->create();
+        hit.setCellID(thits.cellID[h]);
+        hit.setEDep(thits.eDep[h]);
+        hit.setTime(thits.time[h]);
+        hit.setPathLength(thits.pathLength[h]);
+        hit.setQuality(thits.quality[h]);
+        hit.setPosition({thits.position[h].x, thits.position[h].y, thits.position[h].z});
+        hit.setMomentum({thits.momentum[h].x, thits.momentum[h].y, thits.momentum[h].z});
+      }
+    }
+
+    if (event + 1 == m_file.entries()) {
+      info() << "Reached the end of " << m_input.value() << " with event " << event << endmsg;
+      return service<IEventProcessor>("ApplicationMgr")->stopRun();
+    }
+    return StatusCode::SUCCESS;
+  }
+
+  StatusCode finalize() override {
+    m_file.close();
+    return GaudiAlgorithm::finalize();
+  }
+};
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(SimHitFileInput)
+
+} // namespace Jug::Base
@@ -0,0 +1,236 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "fmt/format.h"
+
+#include "Gaudi/Interfaces/IOptionsSvc.h"
+#include "Gaudi/Property.h"
+#include "GaudiAlg/GaudiAlgorithm.h"
+#include "GaudiKernel/IAlgManager.h"
+#include "GaudiKernel/IAlgorithm.h"
+#include "GaudiKernel/ToStream.h"
+
+#include "podio/EventStore.h"
+#include "podio/ROOTReader.h"
+
+#include "JugBase/ConfigSnapshot.h"
+#include "JugBase/PodioDataSvc.h"
+
+namespace Jug::Base {
+
+/** Stage cache of intermediate collections, for the re-reconstruction with other downstream settings.
+ *
+ *  The collections (e.g. the raw hits of the digitization) are kept in a side file of the cache
+ *  directory, keyed by a hash of the configuration of the upstream components that produce them
+ *  (algorithms and services, e.g. the digitization, GeoSvc and RandomSvc), of the data service
+ *  (input files and event selection), of the number of events, and of the size and modification
+ *  time of the input files. A later job with the same key reads the collections from the side file
+ *  and skips the upstream algorithms.
+ *
+ *  The side file is written by the PodioOutput writer, that the cache configures (filename and
+ *  outputCommands) on a miss and disables on a hit; the file is renamed to its final name when the
+ *  job finalizes, so that an interrupted job leaves no cache. The StageCache has to come before
+ *  the upstream algorithms and the writer in the TopAlg sequence, and the writer after the upstream
+ *  algorithms. The events are cached in processing order: for jobs of one event slot, without
+ *  shards. The relations of the cached collections to other collections are not kept.
+ *
+ * \ingroup base
+ */
+class StageCache : public GaudiAlgorithm {
+private:
+  Gaudi::Property<std::vector<std::string>> m_collections{this, "collections", {}, "Collections of the cache"};
+  Gaudi::Property<std::vector<std::string>> m_upstream{
+      this, "upstream", {}, "Components the collections depend on, the algorithms are skipped on a hit"};
+  Gaudi::Property<std::string> m_writer{this, "writer", "", "PodioOutput that writes the cache on a miss"};
+  Gaudi::Property<std::string> m_directory{this, "directory", "stage_cache", "Directory of the cache files"};
+  Gaudi::Property<std::string> m_dataSvc{this, "dataSvc", "EventDataSvc", "Data service of the input"};
+  Gaudi::Property<bool> m_refresh{this, "refresh", false, "Run the upstream algorithms and rewrite the cache"};
+
+  PodioDataSvc* m_podioDataSvc{nullptr};
+  std::string m_path;
+  bool m_hit{false};
+  // side file of a hit
+  std::unique_ptr<podio::ROOTReader> m_reader;
+  std::unique_ptr<podio::EventStore> m_store;
+  std::vector<int> m_collectionIDs;
+  uint64_t m_entry{0};
+
+public:
+  StageCache(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {}
+
+  StatusCode initialize() override {
+    if (GaudiAlgorithm::initialize().isFailure()) {
+      return StatusCode::FAILURE;
+    }
+    m_podioDataSvc = PodioDataSvc::fromEventSvc(evtSvc().get());
+    if (m_podioDataSvc == nullptr) {
+      return StatusCode::FAILURE;
+    }
+    if (m_collections.value().empty() || m_upstream.value().empty() || m_writer.value().empty()) {
+      error() << "The stage cache needs collections, upstream components and a writer" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    m_path = fmt::format("{}/{}-{:016x}.root", m_directory.value(), name(), key());
+    m_hit  = !m_refresh.value() && std::filesystem::exists(m_path);
+
+    auto& options = serviceLocator()->getOptsSvc();
+    // the writer only writes the side file, removed on a hit
+    options.set(m_writer.value() + ".filename", optionsValue(partialPath()));
+    if (m_hit) {
+      if (openCache().isFailure()) {
+        return StatusCode::FAILURE;
+      }
+      SmartIF<IAlgManager> algManager(serviceLocator());
+      for (const auto& component : m_upstream.value()) {
+        if (SmartIF<IAlgorithm> algo = algManager->algorithm(component, false); algo) {
+          if (algo->isInitialized()) {
+            error() << "Upstream algorithm " << component << " comes before " << name() << endmsg;
+            return StatusCode::FAILURE;
+          }
+          options.set(component + ".Enable", "False");
+        }
+      }
+      options.set(m_writer.value() + ".Enable", "False");
+      info() << "Stage cache hit, " << fmt::format("{}", fmt::join(m_collections.value(), ", ")) << " from "
+             << m_path << " with " << m_reader->getEntries() << " events" << endmsg;
+      return StatusCode::SUCCESS;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(m_directory.value(), ec);
+    if (ec) {
+      error() << "Cannot create the cache directory " << m_directory.value() << ": " << ec.message() << endmsg;
+      return StatusCode::FAILURE;
+    }
+    std::vector<std::string> commands{"drop *"};
+    for (const auto& collection : m_collections.value()) {
+      commands.push_back("keep " + collection);
+    }
+    options.set(m_writer.value() + ".outputCommands", Gaudi::Utils::toString(commands));
+    // the side file is read back as it is written
+    options.set(m_writer.value() + ".shardFilenames", "False");
+    options.set(m_writer.value() + ".cellIDPacking", "[]");
+    info() << "Stage cache miss, " << fmt::format("{}", fmt::join(m_collections.value(), ", ")) << " written to "
+           << m_path << " by " << m_writer.value() << endmsg;
+    return StatusCode::SUCCESS;
+  }
+
+  StatusCode execute() override {
+    if (!m_hit) {
+      return StatusCode::SUCCESS;
+    }
+    if (m_entry >= m_reader->getEntries()) {
+      error() << "The stage cache " << m_path << " has only " << m_reader->getEntries() << " events" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    m_podioDataSvc = PodioDataSvc::fromEventSvc(evtSvc().get());
+    for (size_t i = 0; i < m_collectionIDs.size(); ++i) {
+      podio::CollectionBase* collection = nullptr;
+      if (!m_store->get(m_collectionIDs[i], collection) || collection == nullptr) {
+        error() << "Collection " << m_collections.value()[i] << " not found in entry " << m_entry << " of "
+                << m_path << endmsg;
+        return StatusCode::FAILURE;
+      }
+      if (m_podioDataSvc->putReadCollection(m_collections.value()[i], collection).isFailure()) {
+        return StatusCode::FAILURE;
+      }
+    }
+    // the store owns the collections of the event, as for the input
+    m_store->clearCaches();
+    m_reader->endOfEvent();
+    ++m_entry;
+    return StatusCode::SUCCESS;
+  }
+
+  StatusCode finalize() override {
+    if (m_path.empty()) {
+      return GaudiAlgorithm::finalize();
+    }
+    // the writer closes the side file first
+    SmartIF<IAlgManager> algManager(serviceLocator());
+    if (SmartIF<IAlgorithm> writer = algManager->algorithm(m_writer.value(), false); writer) {
+      writer->sysFinalize().ignore();
+    }
+    std::error_code ec;
+    if (m_hit) {
+      m_reader->closeFile();
+      std::filesystem::remove(partialPath(), ec);
+    } else {
+      std::filesystem::rename(partialPath(), m_path, ec);
+      if (ec) {
+        warning() << "The stage cache " << m_path << " is not written: " << ec.message() << endmsg;
+      } else {
+        info() << "Stage cache written to " << m_path << endmsg;
+      }
+    }
+    return GaudiAlgorithm::finalize();
+  }
+
+private:
+  std::string partialPath() const { return m_path + ".partial.root"; }
+
+  /// Hash of the upstream configuration and of the input
+  uint64_t key() const {
+    // FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    auto add      = [&hash](const std::string& text) {
+      for (const char c : text) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ULL;
+      }
+      hash ^= 0xff;
+      hash *= 0x100000001b3ULL;
+    };
+    std::vector<std::string> prefixes{m_dataSvc.value() + "."};
+    for (const auto& component : m_upstream.value()) {
+      prefixes.push_back(component + ".");
+    }
+    // the options are sorted by name
+    for (const auto& [option, value] : configSnapshot(*serviceLocator())) {
+      const bool upstream = std::any_of(prefixes.begin(), prefixes.end(),
+                                        [&option = option](const auto& prefix) { return option.rfind(prefix, 0) == 0; });
+      if (upstream || option == "ApplicationMgr.EvtMax") {
+        add(option);
+        add(value);
+      }
+    }
+    for (const auto& file : m_podioDataSvc->inputFiles()) {
+      std::error_code ec;
+      const auto size = std::filesystem::file_size(file, ec);
+      if (!ec) {
+        const auto time = std::filesystem::last_write_time(file, ec);
+        add(fmt::format("{}:{}:{}", file, size, ec ? 0 : time.time_since_epoch().count()));
+      }
+    }
+    return hash;
+  }
+
+  StatusCode openCache() {
+    m_reader = std::make_unique<podio::ROOTReader>();
+    m_reader->openFile(m_path);
+    m_store = std::make_unique<podio::EventStore>();
+    m_store->setReader(m_reader.get());
+    auto* idTable = m_reader->getCollectionIDTable();
+    for (const auto& collection : m_collections.value()) {
+      if (!idTable->present(collection)) {
+        error() << "Collection " << collection << " not in the stage cache " << m_path << endmsg;
+        return StatusCode::FAILURE;
+      }
+      m_collectionIDs.push_back(idTable->collectionID(collection));
+    }
+    return StatusCode::SUCCESS;
+  }
+};
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(StageCache)
+
+} // namespace Jug::Base
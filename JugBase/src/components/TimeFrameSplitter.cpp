@@ -0,0 +1,238 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include <algorithm>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Gaudi/Property.h"
+#include "GaudiAlg/GaudiAlgorithm.h"
+#include "GaudiKernel/PhysicalConstants.h"
+
+#include "JugBase/DataHandle.h"
+#include "JugBase/DataHandleArray.h"
+#include "JugBase/PodioDataSvc.h"
+#include "JugBase/Utilities/TimeSlices.h"
+
+#include "edm4hep/RawCalorimeterHitCollection.h"
+#include "eicd/RawTrackerHitCollection.h"
+
+using namespace Gaudi::Units;
+
+namespace Jug::Base {
+
+namespace {
+
+  /// Hits of a collection of the frame sorted by time, and their times
+  template <typename Collection> class FrameHits {
+  public:
+    void load(const Collection& hits, double timeStep) {
+      std::vector<double> times(hits.size());
+      for (size_t i = 0; i < hits.size(); ++i) {
+        times[i] = hits[i].getTimeStamp() * timeStep;
+      }
+      std::vector<size_t> order(hits.size());
+      std::iota(order.begin(), order.end(), 0);
+      std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return times[a] < times[b]; });
+      m_hits.clear();
+      m_times.clear();
+      m_hits.reserve(hits.size());
+      m_times.reserve(hits.size());
+      for (const size_t i : order) {
+        m_hits.push_back(hits[i].clone());
+        m_times.push_back(times[i]);
+      }
+    }
+
+    const std::vector<double>& times() const { return m_times; }
+
+    /// Copies of the hits in the slice
+    Collection* slice(const TimeSlice& slice) const {
+      auto* out                = new Collection();
+      const auto [first, last] = sliceRange(m_times, slice);
+      for (size_t i = first; i < last; ++i) {
+        out->push_back(m_hits[i].clone());
+      }
+      return out;
+    }
+
+  private:
+    std::vector<decltype(std::declval<const Collection&>()[0].clone())> m_hits;
+    std::vector<double> m_times;
+  };
+
+} // namespace
+
+/** Splitter of the time frames of the streaming readout into overlapping time slices.
+ *
+ *  Reads the raw hit collections of a time frame (instead of PodioInput) and serves one time
+ *  slice per event, so that the existing digitization and reconstruction sequences run on the
+ *  slices unchanged: the hits of each slice are put in the slice collections, with the same
+ *  order as the frame collections, and the slice in timeSliceCollection (TimeSlice::encode).
+ *  The next frame is read once all the slices of the frame are served, the number of events
+ *  is the number of slices. The slices are sliceLength long and overlap by sliceOverlap, the
+ *  objects reconstructed in the overlaps are kept in one slice by TimeSliceDeduplicator.
+ *
+ *  The frames are kept between the events, the splitter runs with one event slot and all the
+ *  events of the input (EvtMax -1), the run stops after the last slice of the last frame.
+ *
+ *  \ingroup base
+ */
+class TimeFrameSplitter : public GaudiAlgorithm {
+private:
+  Gaudi::Property<std::vector<std::string>> m_trackerFrames{
+      this, "trackerFrameCollections", {}, "Raw tracker hit collections of the time frames"};
+  DataHandleArray<eicd::RawTrackerHitCollection> m_trackerSlices{
+      this, "trackerSliceCollections", "Raw tracker hits of the time slices", Gaudi::DataHandle::Writer};
+  Gaudi::Property<std::vector<std::string>> m_calorimeterFrames{
+      this, "calorimeterFrameCollections", {}, "Raw calorimeter hit collections of the time frames"};
+  DataHandleArray<edm4hep::RawCalorimeterHitCollection> m_calorimeterSlices{
+      this, "calorimeterSliceCollections", "Raw calorimeter hits of the time slices", Gaudi::DataHandle::Writer};
+  DataHandle<std::vector<double>> m_timeSlice{"TimeSlice", Gaudi::DataHandle::Writer, this};
+
+  Gaudi::Property<double> m_sliceLength{this, "sliceLength", 1000. * ns, "Length of the time slices"};
+  Gaudi::Property<double> m_sliceOverlap{this, "sliceOverlap", 100. * ns, "Overlap of consecutive slices"};
+  // time steps of the time stamps of the digitization (SiliconTrackerDigi, CalorimeterHitDigi)
+  Gaudi::Property<double> m_trackerTimeStep{this, "trackerTimeStep", 1.e-6 * ns, "Time step of the tracker hits"};
+  Gaudi::Property<double> m_calorimeterTimeStep{this, "calorimeterTimeStep", 0.010 * ns,
+                                                "Time step of the calorimeter hits"};
+
+  PodioDataSvc* m_podioDataSvc{nullptr};
+  std::vector<int> m_trackerIDs;
+  std::vector<int> m_calorimeterIDs;
+  std::vector<FrameHits<eicd::RawTrackerHitCollection>> m_trackerHits;
+  std::vector<FrameHits<edm4hep::RawCalorimeterHitCollection>> m_calorimeterHits;
+  std::vector<TimeSlice> m_slices;
+  size_t m_nextSlice{0};
+  uint64_t m_frame{0};
+
+public:
+  TimeFrameSplitter(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
+    declareProperty("timeSliceCollection", m_timeSlice, "Time slice of the event");
+  }
+
+  StatusCode initialize() override {
+    if (GaudiAlgorithm::initialize().isFailure()) {
+      return StatusCode::FAILURE;
+    }
+    m_podioDataSvc = PodioDataSvc::fromEventSvc(evtSvc().get());
+    if (m_podioDataSvc == nullptr) {
+      error() << "TimeFrameSplitter needs the PodioDataSvc" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    if (m_podioDataSvc->sharedInput()) {
+      error() << "The time frames are split with one event slot" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    if (m_trackerFrames.value().size() != m_trackerSlices.size() ||
+        m_calorimeterFrames.value().size() != m_calorimeterSlices.size()) {
+      error() << "One slice collection is needed for each frame collection" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    if (m_sliceOverlap.value() < 0. || m_sliceOverlap.value() >= m_sliceLength.value()) {
+      error() << "sliceOverlap has to be in [0, sliceLength)" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    auto* idTable = m_podioDataSvc->getCollectionIDs();
+    for (const auto& [names, ids] : {std::pair{&m_trackerFrames.value(), &m_trackerIDs},
+                                     std::pair{&m_calorimeterFrames.value(), &m_calorimeterIDs}}) {
+      for (const auto& collName : *names) {
+        if (!idTable->present(collName)) {
+          error() << "Requested product " << collName << " not found." << endmsg;
+          return StatusCode::FAILURE;
+        }
+        ids->push_back(idTable->collectionID(collName));
+      }
+    }
+    m_trackerHits.resize(m_trackerIDs.size());
+    m_calorimeterHits.resize(m_calorimeterIDs.size());
+    std::vector<std::string> cached = m_trackerFrames.value();
+    cached.insert(cached.end(), m_calorimeterFrames.value().begin(), m_calorimeterFrames.value().end());
+    m_podioDataSvc->setCachedCollections(cached);
+    return StatusCode::SUCCESS;
+  }
+
+  StatusCode execute() override {
+    if (m_nextSlice == m_slices.size() && readFrame().isFailure()) {
+      return StatusCode::FAILURE;
+    }
+    const auto& slice = m_slices[m_nextSlice++];
+    for (size_t i = 0; i < m_trackerHits.size(); ++i) {
+      m_trackerSlices[i].put(m_trackerHits[i].slice(slice));
+    }
+    for (size_t i = 0; i < m_calorimeterHits.size(); ++i) {
+      m_calorimeterSlices[i].put(m_calorimeterHits[i].slice(slice));
+    }
+    m_timeSlice.put(new std::vector<double>(slice.encode()));
+    if (msgLevel(MSG::DEBUG)) {
+      debug() << "Slice " << slice.index << " of " << slice.count << " of frame " << slice.frame << ": ["
+              << slice.begin << ", " << slice.end << ") ns" << endmsg;
+    }
+    // the input moves on to the next frame (and stops after the last one) with its last slice
+    if (m_nextSlice == m_slices.size()) {
+      m_podioDataSvc->endOfRead();
+    }
+    return StatusCode::SUCCESS;
+  }
+
+private:
+  /// Read the hits of the next frame and make its slices
+  StatusCode readFrame() {
+    double tmin = 0.;
+    double tmax = 0.;
+    bool empty  = true;
+    for (size_t i = 0; i < m_trackerIDs.size(); ++i) {
+      if (!readHits(m_trackerFrames.value()[i], m_trackerIDs[i], m_trackerTimeStep.value(), m_trackerHits[i])) {
+        return StatusCode::FAILURE;
+      }
+      timeRange(m_trackerHits[i].times(), tmin, tmax, empty);
+    }
+    for (size_t i = 0; i < m_calorimeterIDs.size(); ++i) {
+      if (!readHits(m_calorimeterFrames.value()[i], m_calorimeterIDs[i], m_calorimeterTimeStep.value(),
+                    m_calorimeterHits[i])) {
+        return StatusCode::FAILURE;
+      }
+      timeRange(m_calorimeterHits[i].times(), tmin, tmax, empty);
+    }
+    m_slices    = makeTimeSlices(m_frame++, tmin, tmax, m_sliceLength.value(), m_sliceOverlap.value());
+    m_nextSlice = 0;
+    if (msgLevel(MSG::DEBUG)) {
+      debug() << "Frame " << m_slices.front().frame << " of [" << tmin << ", " << tmax << "] ns in "
+              << m_slices.size() << " slices" << endmsg;
+    }
+    return StatusCode::SUCCESS;
+  }
+
+  /// Read a frame collection (registered in the event of the first slice) and keep its hits
+  template <typename Collection>
+  bool readHits(const std::string& collName, int id, double timeStep, FrameHits<Collection>& frameHits) {
+    const size_t nRead = m_podioDataSvc->getReadCollections().size();
+    if (m_podioDataSvc->readCollection(collName, id).isFailure()) {
+      return false;
+    }
+    const auto& read = m_podioDataSvc->getReadCollections();
+    const auto* hits = (read.size() > nRead) ? dynamic_cast<const Collection*>(read.back().second) : nullptr;
+    if (hits == nullptr) {
+      error() << collName << " is not a collection of the expected type" << endmsg;
+      return false;
+    }
+    frameHits.load(*hits, timeStep);
+    return true;
+  }
+
+  static void timeRange(const std::vector<double>& times, double& tmin, double& tmax, bool& empty) {
+    if (times.empty()) {
+      return;
+    }
+    tmin  = empty ? times.front() : std::min(tmin, times.front());
+    tmax  = empty ? times.back() : std::max(tmax, times.back());
+    empty = false;
+  }
+};
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(TimeFrameSplitter)
+
+} // namespace Jug::Base
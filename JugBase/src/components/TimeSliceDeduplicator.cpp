@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include <string>
+#include <vector>
+
+#include "Gaudi/Property.h"
+#include "GaudiAlg/GaudiAlgorithm.h"
+
+#include "JugBase/DataHandle.h"
+#include "JugBase/Utilities/TimeSlices.h"
+
+#include "eicd/CalorimeterHitCollection.h"
+#include "eicd/ClusterCollection.h"
+#include "eicd/TrackerHitCollection.h"
+
+namespace Jug::Base {
+
+/** Objects of a time slice owned by the slice.
+ *
+ *  The slices of TimeFrameSplitter overlap, the objects reconstructed in an overlap are found in
+ *  both slices. The output keeps the objects whose time is in the core of the slice of the event,
+ *  so that each object of the frame is kept once over its slices. The output is a subset
+ *  collection referencing the input objects.
+ *
+ *  \ingroup base
+ */
+template <typename Collection> class TimeSliceDeduplicator : public GaudiAlgorithm {
+private:
+  DataHandle<Collection> m_inputCollection{"inputCollection", Gaudi::DataHandle::Reader, this};
+  DataHandle<std::vector<double>> m_timeSlice{"TimeSlice", Gaudi::DataHandle::Reader, this};
+  DataHandle<Collection> m_outputCollection{"outputCollection", Gaudi::DataHandle::Writer, this};
+
+public:
+  TimeSliceDeduplicator(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
+    declareProperty("inputCollection", m_inputCollection, "Objects reconstructed in the slice");
+    declareProperty("timeSliceCollection", m_timeSlice, "Time slice of the event");
+    declareProperty("outputCollection", m_outputCollection, "Objects owned by the slice");
+  }
+
+  StatusCode execute() override {
+    const auto& input = *m_inputCollection.get();
+    TimeSlice slice;
+    if (!TimeSlice::decode(*m_timeSlice.get(), slice)) {
+      error() << "The event has no time slice" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    auto* output = m_outputCollection.createAndPut();
+    output->setSubsetCollection();
+    for (const auto& object : input) {
+      if (slice.owns(object.getTime())) {
+        output->push_back(object);
+      }
+    }
+    if (msgLevel(MSG::DEBUG)) {
+      debug() << output->size() << " of " << input.size() << " objects in the core of slice " << slice.index
+              << " of frame " << slice.frame << endmsg;
+    }
+    return StatusCode::SUCCESS;
+  }
+};
+
+using CalorimeterHitTimeSliceDeduplicator = TimeSliceDeduplicator<eicd::CalorimeterHitCollection>;
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(CalorimeterHitTimeSliceDeduplicator)
+
+using TrackerHitTimeSliceDeduplicator = TimeSliceDeduplicator<eicd::TrackerHitCollection>;
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(TrackerHitTimeSliceDeduplicator)
+
+using ClusterTimeSliceDeduplicator = TimeSliceDeduplicator<eicd::ClusterCollection>;
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(ClusterTimeSliceDeduplicator)
+
+} // namespace Jug::Base
@@ -8,9 +8,11 @@
 #include "podio/CollectionBase.h"
 #include "podio/CollectionBranches.h"
 
+#include "Compression.h"
 #include "TBranch.h"
 #include "TClass.h"
 
+#include <map>
 #include <vector>
 #include <string>
 
@@ -30,6 +32,54 @@ inline std::string vecBranch(const std::string& name, size_t index) {
   return name + "_" + std::to_string(index);
 }
 
+// ROOT compression settings for an algorithm name and level (algorithm default if negative),
+// -1 for an unknown algorithm
+inline int compressionSettings(const std::string& algorithm, int level) {
+  using Algorithm = ROOT::RCompressionSetting::EAlgorithm;
+  using Level     = ROOT::RCompressionSetting::ELevel;
+  // name: {algorithm, default level}
+  static const std::map<std::string, std::pair<Algorithm::EValues, int>> algorithms{
+      {"zlib", {Algorithm::kZLIB, Level::kDefaultZLIB}},
+      {"lzma", {Algorithm::kLZMA, Level::kDefaultLZMA}},
+      {"lz4", {Algorithm::kLZ4, Level::kDefaultLZ4}},
+      {"zstd", {Algorithm::kZSTD, Level::kDefaultZSTD}},
+  };
+  auto it = algorithms.find(algorithm);
+  if (it == algorithms.end()) {
+    return -1;
+  }
+  const auto& [alg, defaultLevel] = it->second;
+  return ROOT::CompressionSettings(alg, (level < 0) ? defaultLevel : level);
+}
+
+// call func(branch name, class name, buffer object) for all branches of the collections kept by sw,
+// in the order they are created by PodioOutput::createBranches
+template <typename Switch, typename Func>
+void forEachBranchBuffer(const Switch& sw,
+                         const std::vector<std::pair<std::string, podio::CollectionBase*>>& collections, Func&& func) {
+  for (const auto& [collName, coll] : collections) {
+    if (!sw.isOn(collName)) {
+      continue;
+    }
+    auto buffers = coll->getBuffers();
+    // data and vector member buffers are passed to the branches as the address of the object pointer
+    func(collName, "vector<" + coll->getValueTypeName() + "Data>", *static_cast<void**>(buffers.data));
+    if (buffers.references != nullptr) {
+      size_t j = 0;
+      for (auto& ref : *buffers.references) {
+        func(refBranch(collName, j), "vector<podio::ObjectID>", static_cast<void*>(ref.get()));
+        ++j;
+      }
+    }
+    if (buffers.vectorMembers != nullptr) {
+      size_t j = 0;
+      for (auto& [dataType, add] : *buffers.vectorMembers) {
+        func(vecBranch(collName, j), "vector<" + dataType + ">", *static_cast<void**>(add));
+        ++j;
+      }
+    }
+  }
+}
 
 inline void setCollectionAddresses(podio::CollectionBase* collection, const CollectionBranches& branches) {
   auto buffers = collection->getBuffers();
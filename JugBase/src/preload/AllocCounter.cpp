@@ -0,0 +1,45 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+// Counting operator new of libJugAllocCounter.so, preloaded (LD_PRELOAD) in the jobs that count
+// the allocations of the algorithms; JugBase finds the counters through the C functions below
+// and keeps the default allocator without it.
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace {
+std::atomic<bool> s_countAllocations{false};
+thread_local uint64_t s_allocBytes = 0;
+thread_local uint64_t s_allocCount = 0;
+
+void* countedAlloc(std::size_t size) {
+  if (s_countAllocations.load(std::memory_order_relaxed)) {
+    s_allocBytes += size;
+    ++s_allocCount;
+  }
+  // malloc(0) may return nullptr, operator new must not
+  void* ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+} // namespace
+
+extern "C" {
+void jug_alloc_counter_enable(bool on) { s_countAllocations.store(on, std::memory_order_relaxed); }
+bool jug_alloc_counter_enabled() { return s_countAllocations.load(std::memory_order_relaxed); }
+uint64_t jug_alloc_counter_bytes() { return s_allocBytes; }
+uint64_t jug_alloc_counter_count() { return s_allocCount; }
+}
+
+// replaceable allocation functions, the aligned and nothrow forms use the default implementation
+void* operator new(std::size_t size) { return countedAlloc(size); }
+void* operator new[](std::size_t size) { return countedAlloc(size); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t /* size */) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t /* size */) noexcept { std::free(ptr); }
@@ -0,0 +1,149 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+/*
+ *  Precomputes the cell geometry tables of the calorimeter readouts, for GeoSvc.cellGeometryTables.
+ *
+ *  DD4hep cannot enumerate the cells of a readout, so the tables hold the cells that are hit in the
+ *  simulation input (collections named after the readouts). Cells that are not in the tables are
+ *  still looked up in DD4hep by the jobs.
+ *
+ *  jug_cell_geometry -o tables.bin -i sim.root [-i ...] [-n events] [-r readout ...] compact.xml [...]
+ */
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "DD4hep/Detector.h"
+#include "DD4hep/Printout.h"
+#include "DD4hep/VolumeManager.h"
+#include "DDRec/CellIDPositionConverter.h"
+
+#include "podio/EventStore.h"
+#include "podio/ROOTReader.h"
+
+#include "edm4hep/SimCalorimeterHitCollection.h"
+
+#include "JugBase/CellGeometryFile.h"
+
+namespace {
+
+void usage(const char* name) {
+  std::cerr << "Usage: " << name
+            << " -o tables.bin -i sim.root [-i ...] [-n events] [-r readout ...] compact.xml [...]\n"
+            << "  -o  output table file\n"
+            << "  -i  simulation file, the cells are taken from the hit collections named after the readouts\n"
+            << "  -n  maximum number of events per file (all by default)\n"
+            << "  -r  readout (all readouts with hits in the input by default)\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  std::string output;
+  std::vector<std::string> inputs;
+  std::vector<std::string> compacts;
+  std::set<std::string> readouts;
+  size_t maxEvents = 0;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if ((arg == "-o" || arg == "-i" || arg == "-n" || arg == "-r") && i + 1 < argc) {
+      const std::string value = argv[++i];
+      if (arg == "-o") {
+        output = value;
+      } else if (arg == "-i") {
+        inputs.push_back(value);
+      } else if (arg == "-n") {
+        maxEvents = std::stoul(value);
+      } else {
+        readouts.insert(value);
+      }
+    } else if (arg == "-h" || arg == "--help") {
+      usage(argv[0]);
+      return EXIT_SUCCESS;
+    } else if (arg[0] == '-') {
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    } else {
+      compacts.push_back(arg);
+    }
+  }
+  if (output.empty() || inputs.empty() || compacts.empty()) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  // same setup as GeoSvc, so that the geometry hash matches
+  dd4hep::setPrintLevel(dd4hep::WARNING);
+  auto& detector = dd4hep::Detector::getInstance();
+  for (const auto& compact : compacts) {
+    detector.fromCompact(compact);
+  }
+  detector.volumeManager();
+  detector.apply("DD4hepVolumeManager", 0, nullptr);
+  const dd4hep::rec::CellIDPositionConverter converter(detector);
+  const auto volman = detector.volumeManager();
+  if (readouts.empty()) {
+    for (const auto& [name, readout] : detector.readouts()) {
+      readouts.insert(name);
+    }
+  }
+
+  std::map<std::string, std::set<uint64_t>> cells;
+  for (const auto& input : inputs) {
+    podio::ROOTReader reader;
+    reader.openFile(input);
+    podio::EventStore store;
+    store.setReader(&reader);
+    std::vector<std::string> present;
+    for (const auto& readout : readouts) {
+      if (reader.getCollectionIDTable()->present(readout)) {
+        present.push_back(readout);
+      }
+    }
+    const size_t entries = (maxEvents > 0) ? std::min<size_t>(reader.getEntries(), maxEvents) : reader.getEntries();
+    for (size_t i = 0; i < entries; ++i) {
+      for (const auto& readout : present) {
+        // tracker collections are skipped
+        const edm4hep::SimCalorimeterHitCollection* hits = nullptr;
+        if (store.get(readout, hits)) {
+          for (const auto& hit : *hits) {
+            cells[readout].insert(hit.getCellID());
+          }
+        }
+      }
+      store.clear();
+      reader.endOfEvent();
+    }
+    reader.closeFile();
+  }
+
+  std::map<std::string, std::vector<Jug::Base::CellGeometryFile::Record>> tables;
+  for (const auto& [readout, cellIDs] : cells) {
+    auto& records = tables[readout];
+    size_t failed = 0;
+    for (const auto cellID : cellIDs) {
+      try {
+        records.push_back(Jug::Base::CellGeometryFile::record(converter, volman.lookupDetElement(cellID), cellID));
+      } catch (const std::exception&) {
+        ++failed;
+      }
+    }
+    std::cout << readout << ": " << records.size() << " cells";
+    if (failed > 0) {
+      std::cout << " (" << failed << " not in the geometry)";
+    }
+    std::cout << '\n';
+  }
+
+  if (!Jug::Base::CellGeometryFile::write(output, Jug::Base::geometryHash(detector, compacts), std::move(tables))) {
+    std::cerr << "Failed to write " << output << '\n';
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+/*
+ *  Merges the output files of PodioOutput (e.g. of the shards of an input) into one file,
+ *  see Jug::Base::mergeOutputs.
+ *
+ *  jug_merge_outputs -o merged.root input.root [...]
+ */
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "JugBase/OutputMerger.h"
+
+namespace {
+
+void usage(const char* name) {
+  std::cerr << "Usage: " << name << " -o merged.root input.root [...]\n"
+            << "  -o  merged output file, with the compression settings of the first input\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  std::string output;
+  std::vector<std::string> inputs;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "-o" && i + 1 < argc) {
+      output = argv[++i];
+    } else if (arg == "-h" || arg == "--help") {
+      usage(argv[0]);
+      return EXIT_SUCCESS;
+    } else if (arg[0] == '-') {
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    } else {
+      inputs.push_back(arg);
+    }
+  }
+  if (output.empty() || inputs.empty()) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  long long nEvents = 0;
+  std::string error;
+  if (!Jug::Base::mergeOutputs(output, inputs, nEvents, error)) {
+    std::cerr << error << '\n';
+    return EXIT_FAILURE;
+  }
+  std::cout << "Merged " << nEvents << " events of " << inputs.size() << " files into " << output << '\n';
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,158 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+/*
+ *  Converts the simulated hit collections of simulation files to a memory-mapped SimHitFile, for
+ *  SimHitFileInput.
+ *
+ *  The collections are SimCalorimeterHit or SimTrackerHit collections, their kind is taken from
+ *  the first event of the first file. The events of the files are written in order.
+ *
+ *  jug_simhit_convert -o hits.bin [-n events] [-b events per block] -c collection [-c ...] sim.root [...]
+ */
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "podio/EventStore.h"
+#include "podio/ROOTReader.h"
+
+#include "edm4hep/SimCalorimeterHitCollection.h"
+#include "edm4hep/SimTrackerHitCollection.h"
+
+#include "JugBase/SimHitFile.h"
+
+using Jug::Base::SimHitFile;
+
+namespace {
+
+void usage(const char* name) {
+  std::cerr << "Usage: " << name
+            << " -o hits.bin [-n events] [-b events] -c collection [-c ...] sim.root [...]\n"
+            << "  -o  output hit file\n"
+            << "  -n  maximum number of events (all by default)\n"
+            << "  -b  events per block (1000 by default)\n"
+            << "  -c  SimCalorimeterHit or SimTrackerHit collection\n";
+}
+
+void add(SimHitFile::Writer& writer, size_t index, const edm4hep::SimCalorimeterHitCollection& hits) {
+  for (const auto& hit : hits) {
+    const auto& pos = hit.getPosition();
+    writer.add(index, SimHitFile::Writer::CalorimeterHit{hit.getCellID(), hit.getEnergy(), {pos.x, pos.y, pos.z}});
+    for (const auto& c : hit.getContributions()) {
+      const auto& step = c.getStepPosition();
+      writer.add(index, SimHitFile::Writer::Contribution{c.getPDG(), c.getEnergy(), c.getTime(),
+                                                         {step.x, step.y, step.z}});
+    }
+  }
+}
+
+void add(SimHitFile::Writer& writer, size_t index, const edm4hep::SimTrackerHitCollection& hits) {
+  for (const auto& hit : hits) {
+    const auto& pos = hit.getPosition();
+    const auto& mom = hit.getMomentum();
+    writer.add(index, SimHitFile::Writer::TrackerHit{hit.getCellID(),
+                                                     hit.getEDep(),
+                                                     hit.getTime(),
+                                                     hit.getPathLength(),
+                                                     hit.getQuality(),
+                                                     {pos.x, pos.y, pos.z},
+                                                     {mom.x, mom.y, mom.z}});
+  }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  std::string output;
+  std::vector<std::string> inputs;
+  std::vector<std::string> names;
+  size_t maxEvents        = 0;
+  uint32_t eventsPerBlock = 1000;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if ((arg == "-o" || arg == "-n" || arg == "-b" || arg == "-c") && i + 1 < argc) {
+      const std::string value = argv[++i];
+      if (arg == "-o") {
+        output = value;
+      } else if (arg == "-n") {
+        maxEvents = std::stoul(value);
+      } else if (arg == "-b") {
+        eventsPerBlock = std::stoul(value);
+      } else {
+        names.push_back(value);
+      }
+    } else if (arg == "-h" || arg == "--help") {
+      usage(argv[0]);
+      return EXIT_SUCCESS;
+    } else if (arg[0] == '-') {
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    } else {
+      inputs.push_back(arg);
+    }
+  }
+  if (output.empty() || inputs.empty() || names.empty()) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  SimHitFile::Writer writer;
+  std::vector<SimHitFile::Collection> collections;
+  size_t events = 0;
+  for (const auto& input : inputs) {
+    podio::ROOTReader reader;
+    reader.openFile(input);
+    podio::EventStore store;
+    store.setReader(&reader);
+    for (size_t i = 0; i < reader.getEntries() && (maxEvents == 0 || events < maxEvents); ++i, ++events) {
+      if (collections.empty()) {
+        for (const auto& name : names) {
+          const edm4hep::SimCalorimeterHitCollection* calorimeter = nullptr;
+          const edm4hep::SimTrackerHitCollection* tracker         = nullptr;
+          if (store.get(name, calorimeter)) {
+            collections.push_back({name, SimHitFile::Kind::Calorimeter});
+          } else if (store.get(name, tracker)) {
+            collections.push_back({name, SimHitFile::Kind::Tracker});
+          } else {
+            std::cerr << name << " is not a simulated hit collection of " << input << '\n';
+            return EXIT_FAILURE;
+          }
+        }
+        if (!writer.open(output, collections, eventsPerBlock)) {
+          std::cerr << "Failed to open " << output << '\n';
+          return EXIT_FAILURE;
+        }
+      }
+      for (size_t c = 0; c < collections.size(); ++c) {
+        // collections missing in an event are empty
+        if (collections[c].kind == SimHitFile::Kind::Calorimeter) {
+          const edm4hep::SimCalorimeterHitCollection* hits = nullptr;
+          if (store.get(collections[c].name, hits)) {
+            add(writer, c, *hits);
+          }
+        } else {
+          const edm4hep::SimTrackerHitCollection* hits = nullptr;
+          if (store.get(collections[c].name, hits)) {
+            add(writer, c, *hits);
+          }
+        }
+      }
+      if (!writer.endEvent()) {
+        std::cerr << "Failed to write " << output << '\n';
+        return EXIT_FAILURE;
+      }
+      store.clear();
+      reader.endOfEvent();
+    }
+    reader.closeFile();
+  }
+
+  if (collections.empty() || !writer.close()) {
+    std::cerr << "Failed to write " << output << '\n';
+    return EXIT_FAILURE;
+  }
+  std::cout << events << " events of " << collections.size() << " collections written to " << output << '\n';
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+/*
+ *  Grouping utilities: sort_and_group (serial and parallel radix sort) and group_by_key against a
+ *  stable sort, and the union-find against the connected components of a breadth-first search.
+ */
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "JugBase/Utilities/GroupBy.hpp"
+#include "JugBase/Utilities/KeyGroups.h"
+#include "JugBase/Utilities/Philox.h"
+#include "JugBase/Utilities/UnionFind.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+  if (!ok) {
+    std::cerr << "FAILED: " << what << std::endl;
+    ++failures;
+  }
+}
+
+/// (key, index) pairs of the keys, stably sorted by key
+template <typename Key> std::vector<std::pair<Key, uint32_t>> stableSorted(const std::vector<Key>& keys) {
+  std::vector<std::pair<Key, uint32_t>> items;
+  for (uint32_t i = 0; i < keys.size(); ++i) {
+    items.emplace_back(keys[i], i);
+  }
+  std::stable_sort(items.begin(), items.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+  return items;
+}
+
+template <typename Key> bool checkSortAndGroup(const std::vector<Key>& keys) {
+  const auto expected = stableSorted(keys);
+  const auto groups   = Jug::sort_and_group(keys, [](Key k) { return k; });
+  if (groups.items() != expected) {
+    return false;
+  }
+  // one group per key, in increasing key order, with all the elements of the key
+  size_t count    = 0;
+  bool first      = true;
+  Key previous    = Key();
+  bool consistent = true;
+  for (auto&& [key, items] : groups) {
+    consistent = consistent && (first || previous < key);
+    for (const auto& [k, index] : items) {
+      consistent = consistent && (k == key) && (keys[index] == key);
+      ++count;
+    }
+    previous = key;
+    first    = false;
+  }
+  return consistent && count == keys.size();
+}
+
+} // namespace
+
+int main() {
+  Jug::Base::Random::Stream rng(2022, 1);
+
+  // signed keys with repeats, below and above the size of the parallel sort
+  for (const size_t n : {size_t(0), size_t(1), size_t(1000), size_t(3) * Jug::detail::kParallelSortMin}) {
+    std::vector<int32_t> keys(n);
+    for (auto& key : keys) {
+      key = static_cast<int32_t>(rng.next() % 2001) - 1000;
+    }
+    check(checkSortAndGroup(keys), "sort_and_group of signed keys is a stable sort by key");
+  }
+  // 64-bit cellIDs differing in high bytes only
+  {
+    std::vector<uint64_t> keys(5000);
+    for (auto& key : keys) {
+      key = (static_cast<uint64_t>(rng.next() % 37) << 48) | 0x1234;
+    }
+    check(checkSortAndGroup(keys), "sort_and_group of 64-bit keys is a stable sort by key");
+
+    const auto groups   = Jug::Base::group_by_key(keys);
+    const auto expected = stableSorted(keys);
+    bool match          = groups.index.size() == keys.size();
+    for (size_t i = 0; match && i < keys.size(); ++i) {
+      match = groups.index[i] == expected[i].second && groups.keys[i] == expected[i].first;
+    }
+    size_t total = 0;
+    for (size_t g = 0; g < groups.size(); ++g) {
+      match = match && groups.count(g) > 0 && (g == 0 || groups.key(g - 1) < groups.key(g));
+      total += groups.count(g);
+    }
+    check(match && total == keys.size(), "group_by_key groups the stably sorted indices by key");
+  }
+
+  // union-find of random edges: the sets are the connected components, with their first element as root
+  {
+    constexpr uint32_t n = 500;
+    std::vector<std::pair<uint32_t, uint32_t>> edges;
+    for (size_t e = 0; e < 300; ++e) {
+      edges.emplace_back(rng.next() % n, rng.next() % n);
+    }
+    std::vector<std::vector<uint32_t>> adjacent(n);
+    for (const auto& [a, b] : edges) {
+      adjacent[a].push_back(b);
+      adjacent[b].push_back(a);
+    }
+    // components of a breadth-first search from the smallest unvisited element
+    std::vector<uint32_t> component(n, n);
+    for (uint32_t seed = 0; seed < n; ++seed) {
+      if (component[seed] != n) {
+        continue;
+      }
+      std::vector<uint32_t> queue{seed};
+      component[seed] = seed;
+      for (size_t next = 0; next < queue.size(); ++next) {
+        for (const auto j : adjacent[queue[next]]) {
+          if (component[j] == n) {
+            component[j] = seed;
+            queue.push_back(j);
+          }
+        }
+      }
+    }
+
+    Jug::Base::UnionFind forward;
+    forward.reset(n);
+    for (const auto& [a, b] : edges) {
+      forward.unite(a, b);
+    }
+    Jug::Base::UnionFind backward;
+    for (uint32_t i = 0; i < n; ++i) {
+      check(backward.add() == i, "add gives the next element");
+    }
+    for (auto it = edges.rbegin(); it != edges.rend(); ++it) {
+      backward.unite(it->second, it->first);
+    }
+    bool match = true;
+    for (uint32_t i = 0; i < n; ++i) {
+      match = match && forward.find(i) == component[i] && backward.find(i) == component[i];
+    }
+    check(match, "union-find roots are the first elements of the connected components, in any union order");
+  }
+
+  if (failures == 0) {
+    std::cout << "Grouping: all checks passed" << std::endl;
+  }
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+/*
+ *  Packed cellIDs: round trip of the elements of a SimTrackerHit data buffer, with the reference
+ *  vector of its OneToOne MCParticle relation permuted with the elements as PodioOutput does.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "edm4hep/SimTrackerHitData.h"
+#include "podio/ObjectID.h"
+
+#include "JugBase/PackedCellIDs.h"
+#include "JugBase/Utilities/Philox.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+  if (!ok) {
+    std::cerr << "FAILED: " << what << std::endl;
+    ++failures;
+  }
+}
+
+using namespace Jug::Base;
+
+void testRoundTrip(size_t n, uint64_t cellIDs) {
+  Random::Stream rng(n, 1);
+  std::vector<edm4hep::SimTrackerHitData> hits(n);
+  std::vector<podio::ObjectID> particles(n);
+  for (size_t i = 0; i < n; ++i) {
+    hits[i].cellID = (rng.next() % cellIDs) << 32;
+    hits[i].EDep   = static_cast<float>(i);
+    // the MCParticle of hit i
+    particles[i] = podio::ObjectID{static_cast<int>(1000 + i), 7};
+  }
+  const auto original = hits;
+
+  std::vector<uint8_t> blob;
+  std::vector<uint32_t> order;
+  std::vector<char> scratch;
+  const size_t stride = sizeof(edm4hep::SimTrackerHitData);
+  const size_t offset = offsetof(edm4hep::SimTrackerHitData, cellID);
+  auto* first         = reinterpret_cast<char*>(hits.data());
+  PackedCellIDs::pack(first, n, stride, offset, blob, order, scratch);
+  PackedCellIDs::permute(order, reinterpret_cast<char*>(particles.data()), sizeof(podio::ObjectID), scratch);
+
+  bool zeroed = true;
+  for (const auto& hit : hits) {
+    zeroed = zeroed && hit.cellID == 0;
+  }
+  check(zeroed, "the packed cellIDs are zeroed in the elements");
+  check(PackedCellIDs::unpack(blob, first, n, stride, offset), "the blob unpacks");
+
+  bool sorted    = true;
+  bool stable    = true;
+  bool elements  = true;
+  bool relations = true;
+  for (size_t i = 0; i < n; ++i) {
+    const auto index = static_cast<size_t>(hits[i].EDep);
+    if (i > 0) {
+      sorted = sorted && hits[i - 1].cellID <= hits[i].cellID;
+      stable = stable && (hits[i - 1].cellID < hits[i].cellID || hits[i - 1].EDep < hits[i].EDep);
+    }
+    elements  = elements && index < n && hits[i].cellID == original[index].cellID;
+    relations = relations && particles[i].index == static_cast<int>(1000 + index) && particles[i].collectionID == 7;
+  }
+  check(sorted, "the elements are sorted by cellID");
+  check(stable, "the elements of the same cellID keep their order");
+  check(elements, "the elements get their own cellIDs back");
+  check(relations, "the elements keep their OneToOne relations");
+
+  if (n > 0) {
+    blob.pop_back();
+    check(!PackedCellIDs::unpack(blob, first, n, stride, offset), "a truncated blob does not unpack");
+  }
+}
+
+} // namespace
+
+int main() {
+  testRoundTrip(0, 1);
+  testRoundTrip(1, 1);
+  testRoundTrip(1000, 50);
+  testRoundTrip(1000, uint64_t{1} << 31);
+  if (failures > 0) {
+    std::cerr << failures << " checks failed" << std::endl;
+    return 1;
+  }
+  std::cout << "PackedCellIDs: all checks passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+/*
+ *  Philox4x32-10 against the known-answer vectors of Random123, and the reproducibility of the
+ *  random numbers derived from it: the same (key, stream) gives the same numbers whatever the
+ *  buffer size or the order in which the streams are used.
+ */
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "JugBase/Utilities/Philox.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+  if (!ok) {
+    std::cerr << "FAILED: " << what << std::endl;
+    ++failures;
+  }
+}
+
+} // namespace
+
+int main() {
+  using Jug::Base::Random::Philox4x32;
+  namespace Random = Jug::Base::Random;
+
+  // Random123 kat_vectors, philox4x32_10
+  check(Philox4x32::generate({0, 0, 0, 0}, {0, 0}) ==
+            Philox4x32::Counter{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8},
+        "Philox4x32-10 of the zero counter and key");
+  check(Philox4x32::generate({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff}) ==
+            Philox4x32::Counter{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd},
+        "Philox4x32-10 of the all-ones counter and key");
+  check(Philox4x32::generate({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0}) ==
+            Philox4x32::Counter{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1},
+        "Philox4x32-10 of the pi digits counter and key");
+
+  // the variates of a slot do not depend on the buffer size
+  const auto normals = Random::normal_buffer(42, 7, 103);
+  const auto prefix  = Random::normal_buffer(42, 7, 10);
+  bool samePrefix    = true;
+  for (size_t i = 0; i < prefix.size(); ++i) {
+    samePrefix = samePrefix && prefix[i] == normals[i];
+  }
+  check(samePrefix, "fill_normal slots are the same for any buffer size");
+  check(Random::normal_buffer(42, 7, 103) == normals, "fill_normal is reproducible");
+  check(Random::normal_buffer(42, 8, 103) != normals, "fill_normal streams differ");
+  check(Random::normal_buffer(43, 7, 103) != normals, "fill_normal seeds differ");
+
+  // moments of the normal and uniform variates
+  const auto many = Random::normal_buffer(1, 0, 100000);
+  double sum      = 0.;
+  double sum2     = 0.;
+  for (const double x : many) {
+    sum += x;
+    sum2 += x * x;
+  }
+  const double mean = sum / many.size();
+  check(std::abs(mean) < 0.02 && std::abs(sum2 / many.size() - mean * mean - 1.) < 0.02,
+        "fill_normal has mean 0 and variance 1");
+  std::vector<double> uniforms(100000);
+  Random::fill_uniform(1, 0, uniforms.data(), uniforms.size());
+  bool inRange = true;
+  sum          = 0.;
+  for (const double u : uniforms) {
+    inRange = inRange && u > 0. && u < 1.;
+    sum += u;
+  }
+  check(inRange && std::abs(sum / uniforms.size() - 0.5) < 0.01, "fill_uniform is in (0, 1) with mean 1/2");
+
+  // streams of the cells of an event, used interleaved or one after the other
+  const uint64_t key = Random::event_key(Random::job_key(1, 0), "CalorimeterHitDigi", 17);
+  std::vector<double> sequential;
+  for (uint64_t cell = 0; cell < 3; ++cell) {
+    Random::Stream stream(key, cell);
+    for (int k = 0; k < 9; ++k) {
+      sequential.push_back(stream.normal());
+    }
+  }
+  std::vector<Random::Stream> streams{{key, 0}, {key, 1}, {key, 2}};
+  std::vector<double> interleaved(sequential.size());
+  for (int k = 0; k < 9; ++k) {
+    for (size_t cell = 0; cell < 3; ++cell) {
+      interleaved[cell * 9 + k] = streams[cell].normal();
+    }
+  }
+  check(interleaved == sequential, "streams are independent of the order in which they are used");
+
+  // event keys separate the events, the algorithms and the jobs
+  check(Random::event_key(Random::job_key(1, 0), "A", 17) != Random::event_key(Random::job_key(1, 0), "A", 18),
+        "event keys of different events differ");
+  check(Random::event_key(Random::job_key(1, 0), "A", 17) != Random::event_key(Random::job_key(1, 0), "B", 17),
+        "event keys of different algorithms differ");
+  check(Random::event_key(Random::job_key(1, 0), "A", 17) != Random::event_key(Random::job_key(2, 0), "A", 17),
+        "event keys of different seeds differ");
+  check(Random::event_key(Random::job_key(1, 0), "A", 17) != Random::event_key(Random::job_key(1, 1), "A", 17),
+        "event keys of different runs differ");
+
+  if (failures == 0) {
+    std::cout << "Philox: all checks passed" << std::endl;
+  }
+  return failures == 0 ? 0 : 1;
+}
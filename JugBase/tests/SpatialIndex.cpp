@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+/*
+ *  Neighbour queries of the spatial index (cell list and k-d tree), compared with a brute-force
+ *  search over the same points, with a periodic dimension (phi) and points around its boundary.
+ */
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include "JugBase/Utilities/Philox.h"
+#include "JugBase/Utilities/SpatialIndex.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+  if (!ok) {
+    std::cerr << "FAILED: " << what << std::endl;
+    ++failures;
+  }
+}
+
+constexpr double kTwoPi = 6.283185307179586;
+
+std::vector<uint32_t> bruteWithin(const Jug::Base::SpatialPoints<2>& points, const std::array<double, 2>& point,
+                                  double radius) {
+  std::vector<uint32_t> indices;
+  for (uint32_t i = 0; i < points.size; ++i) {
+    if (points.distance2(point, i) <= radius * radius) {
+      indices.push_back(i);
+    }
+  }
+  return indices;
+}
+
+} // namespace
+
+int main() {
+  // (eta, phi) of 2000 points, phi in [-pi, pi) so that neighbours wrap around the boundary
+  constexpr size_t n = 2000;
+  std::vector<double> eta(n);
+  std::vector<double> phi(n);
+  Jug::Base::Random::Stream rng(12345, 0);
+  for (size_t i = 0; i < n; ++i) {
+    eta[i] = 4. * rng.uniform() - 2.;
+    phi[i] = kTwoPi * rng.uniform() - kTwoPi / 2;
+  }
+  Jug::Base::SpatialPoints<2> points;
+  points.coords = {eta.data(), phi.data()};
+  points.size   = n;
+  points.period = {0., kTwoPi};
+
+  Jug::Base::CellList<2> cells;
+  cells.build(points, {0.1, 0.1});
+  Jug::Base::KDTree<2> tree(4);
+  tree.build(points);
+
+  bool cellsMatch = true;
+  bool treeMatch  = true;
+  std::vector<uint32_t> found;
+  for (const double radius : {0.05, 0.1, 0.35}) {
+    for (size_t q = 0; q < 200; ++q) {
+      // queries at the points and around the phi boundary
+      const std::array<double, 2> point =
+          (q % 2 == 0) ? points.point(q) : std::array<double, 2>{eta[q], (q % 4 == 1) ? 3.1 : -3.1};
+      const auto expected = bruteWithin(points, point, radius);
+      cells.within(point, radius, found);
+      cellsMatch = cellsMatch && (found == expected);
+      found.clear();
+      tree.forEachWithin(point, radius, [&found](uint32_t i, double /* d2 */) { found.push_back(i); });
+      std::sort(found.begin(), found.end());
+      treeMatch = treeMatch && (found == expected);
+    }
+  }
+  check(cellsMatch, "cell list radius queries match the brute-force search");
+  check(treeMatch, "k-d tree radius queries match the brute-force search");
+
+  // k nearest, by distance then index
+  bool nearestMatch = true;
+  std::vector<std::pair<double, uint32_t>> nearest;
+  for (size_t q = 0; q < 100; ++q) {
+    const std::array<double, 2> point{eta[q] + 0.01, -3.14 + 0.0628 * q};
+    std::vector<std::pair<double, uint32_t>> expected;
+    for (uint32_t i = 0; i < n; ++i) {
+      expected.emplace_back(points.distance2(point, i), i);
+    }
+    std::sort(expected.begin(), expected.end());
+    expected.resize(7);
+    tree.nearest(point, 7, nearest);
+    nearestMatch = nearestMatch && (nearest == expected);
+  }
+  check(nearestMatch, "k-d tree nearest neighbours match the brute-force search");
+
+  // fewer points than asked, and no points
+  Jug::Base::SpatialPoints<2> few = points;
+  few.size                        = 3;
+  Jug::Base::KDTree<2> small;
+  small.build(few);
+  small.nearest({0., 0.}, 5, nearest);
+  check(nearest.size() == 3, "k nearest of fewer points gives all points");
+  Jug::Base::SpatialPoints<2> none = points;
+  none.size                        = 0;
+  Jug::Base::KDTree<2> empty;
+  empty.build(none);
+  empty.nearest({0., 0.}, 5, nearest);
+  check(nearest.empty(), "k nearest of no points is empty");
+  Jug::Base::CellList<2> emptyCells;
+  emptyCells.build(none, {0.1, 0.1});
+  emptyCells.within({0., 0.}, 1., found);
+  check(found.empty(), "radius query of no points is empty");
+
+  if (failures == 0) {
+    std::cout << "SpatialIndex: all checks passed" << std::endl;
+  }
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,7 @@
+# SPDX-License-Identifier: LGPL-3.0-or-later
+# Copyright (C) 2022 Wouter Deconinck
+
+# End-to-end benchmark of the central tracking chain, see chains.py
+from chains import central_tracking, run
+
+run(central_tracking)
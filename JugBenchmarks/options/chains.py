@@ -0,0 +1,209 @@
+# SPDX-License-Identifier: LGPL-3.0-or-later
+# Copyright (C) 2022 Wouter Deconinck
+
+# Reconstruction chains of the end-to-end benchmarks (scripts/run_chain_benchmarks.py).
+#
+# Each chain option file calls run() with the algorithms of its chain, on the reference input of
+# the chain; the job is configured through environment variables set by the runner:
+#   JUG_BENCH_INPUT    simulation input file
+#   JUG_BENCH_NEVENTS  number of events
+#   JUG_BENCH_STATS    JSON file of the per-algorithm statistics (AlgorithmStatsAuditor)
+#   JUG_BENCH_THREADS  intra-event threads of the algorithms that have them
+#   JUG_BENCH_SIMD     instruction set of the vectorized kernels (CPUDispatchSvc level), auto by default
+#   JUG_BENCH_COMPACT  compact file of the detector, DETECTOR_PATH/JUGGLER_DETECTOR.xml by default
+# No output file is written, so that the benchmarks measure the reconstruction only.
+
+import os
+
+from Gaudi.Configuration import *
+from GaudiKernel import SystemOfUnits as units
+
+from Configurables import ApplicationMgr, AuditorSvc, EICDataSvc, GeoSvc, CellGeometrySvc, RandomSvc
+from Configurables import ConcurrencySvc, CPUDispatchSvc
+from Configurables import PodioInput
+from Configurables import Jug__Base__AlgorithmStatsAuditor as AlgorithmStatsAuditor
+
+from Configurables import Jug__Digi__SiliconTrackerDigi as TrackerDigi
+from Configurables import Jug__Digi__CalorimeterHitDigi as CalorimeterHitDigi
+from Configurables import Jug__Digi__PhotoMultiplierDigi as PhotoMultiplierDigi
+from Configurables import Jug__Reco__TrackerHitReconstruction as TrackerHitReconstruction
+from Configurables import Jug__Reco__TrackingHitsCollector2 as TrackingHitsCollector
+from Configurables import Jug__Reco__TrackerSourceLinker as TrackerSourceLinker
+from Configurables import Jug__Reco__TrackParamTruthInit as TrackParamTruthInit
+from Configurables import Jug__Reco__CKFTracking as CKFTracking
+from Configurables import Jug__Reco__ParticlesFromTrackFit as ParticlesFromTrackFit
+from Configurables import Jug__Reco__TrackSurfaceProjector as TrackSurfaceProjector
+from Configurables import Jug__Reco__ImagingPixelReco as ImagingPixelReco
+from Configurables import Jug__Reco__ImagingTopoCluster as ImagingTopoCluster
+from Configurables import Jug__Reco__ImagingClusterReco as ImagingClusterReco
+from Configurables import Jug__Reco__PhotoMultiplierReco as PhotoMultiplierReco
+from Configurables import Jug__Reco__CherenkovTrackPID as CherenkovTrackPID
+from Configurables import Jug__Reco__FarForwardParticles as FarForwardParticles
+
+input_file = os.environ.get("JUG_BENCH_INPUT", "")
+n_events = int(os.environ.get("JUG_BENCH_NEVENTS", "100"))
+stats_file = os.environ.get("JUG_BENCH_STATS", "benchmark_stats.json")
+n_threads = int(os.environ.get("JUG_BENCH_THREADS", "1"))
+simd_level = os.environ.get("JUG_BENCH_SIMD", "auto")
+detector_name = os.environ.get("JUGGLER_DETECTOR", "athena")
+detector_path = os.environ.get("DETECTOR_PATH", ".")
+compact_path = os.environ.get("JUG_BENCH_COMPACT", os.path.join(detector_path, detector_name + ".xml"))
+
+tracker_collections = ["TrackerBarrelHits", "VertexBarrelHits", "TrackerEndcapHits"]
+
+
+def central_tracking():
+    """Silicon tracker digitization, hit reconstruction and CKF tracking with truth seeds"""
+    algs = []
+    reco_collections = []
+    for hits in tracker_collections:
+        algs.append(TrackerDigi(hits + "_digi",
+                                inputHitCollection=hits,
+                                outputHitCollection=hits + "Digi",
+                                timeResolution=8 * units.ns))
+        algs.append(TrackerHitReconstruction(hits + "_reco",
+                                             inputHitCollection=hits + "Digi",
+                                             outputHitCollection=hits + "Reco",
+                                             readoutClass=hits,
+                                             cacheGeometry=True))
+        reco_collections.append(hits + "Reco")
+    algs += [
+        TrackingHitsCollector("trackerhits_collect",
+                              inputTrackingHits=reco_collections,
+                              trackingHits="TrackingHits"),
+        TrackerSourceLinker("trackerhits_sl",
+                            inputHitCollection="TrackingHits",
+                            outputSourceLinks="TrackSourceLinks",
+                            outputMeasurements="TrackMeasurements"),
+        TrackParamTruthInit("truth_trk_init",
+                            inputMCParticles="MCParticles",
+                            outputInitialTrackParameters="InitTrackParams"),
+        CKFTracking("trk_find_alg",
+                    inputSourceLinks="TrackSourceLinks",
+                    inputMeasurements="TrackMeasurements",
+                    inputInitialTrackParameters="InitTrackParams",
+                    outputTrajectories="trajectories",
+                    numThreads=n_threads),
+        ParticlesFromTrackFit("trk_parts",
+                              inputTrajectories="trajectories",
+                              outputParticles="ReconstructedChargedParticles",
+                              outputTrackParameters="outputTrackParameters"),
+    ]
+    return ["MCParticles"] + tracker_collections, algs
+
+
+def imaging_ecal():
+    """Imaging barrel ECal digitization, pixel reconstruction and topological clustering"""
+    algs = [
+        CalorimeterHitDigi("ecal_barrel_digi",
+                           inputHitCollection="EcalBarrelHits",
+                           outputHitCollection="EcalBarrelHitsDigi",
+                           energyResolutions=[0., 0.02, 0.],
+                           dynamicRangeADC=3 * units.MeV,
+                           pedestalSigma=40),
+        ImagingPixelReco("ecal_barrel_reco",
+                         inputHitCollection="EcalBarrelHitsDigi",
+                         outputHitCollection="EcalBarrelHitsReco",
+                         dynamicRangeADC=3 * units.MeV,
+                         pedestalSigma=40,
+                         readoutClass="EcalBarrelHits",
+                         layerField="layer",
+                         sectorField="module"),
+        ImagingTopoCluster("ecal_barrel_cluster",
+                           inputHitCollection="EcalBarrelHitsReco",
+                           outputProtoClusterCollection="EcalBarrelProtoClusters",
+                           localDistXY=[2. * units.mm, 2 * units.mm],
+                           layerDistEtaPhi=[10 * units.mrad, 10 * units.mrad],
+                           neighbourLayersRange=2,
+                           sectorDist=3. * units.cm,
+                           numThreads=n_threads),
+        ImagingClusterReco("ecal_barrel_clreco",
+                           inputProtoClusters="EcalBarrelProtoClusters",
+                           outputClusters="EcalBarrelClusters",
+                           outputLayers="EcalBarrelLayers"),
+    ]
+    return ["MCParticles", "EcalBarrelHits"], algs
+
+
+def rich(with_tracking=True):
+    """dRICH photo-sensor digitization and reconstruction, and the track-based PID"""
+    collections, algs = central_tracking() if with_tracking else (["MCParticles"], [])
+    algs += [
+        PhotoMultiplierDigi("drich_digi",
+                            inputHitCollection="DRICHHits",
+                            outputHitCollection="DRICHRawHits"),
+        PhotoMultiplierReco("drich_reco",
+                            inputHitCollection="DRICHRawHits",
+                            outputHitCollection="DRICHRecHits",
+                            readoutClass="DRICHHits"),
+    ]
+    if with_tracking:
+        algs += [
+            TrackSurfaceProjector("drich_proj",
+                                  inputTrajectories="trajectories",
+                                  outputTrackSegments="DRICHTrackSegments",
+                                  discZ=[1950. * units.mm, 2900. * units.mm],
+                                  discRMin=[100. * units.mm, 100. * units.mm],
+                                  discRMax=[1800. * units.mm, 1800. * units.mm]),
+            CherenkovTrackPID("drich_pid",
+                              inputHitCollection="DRICHRecHits",
+                              inputTrackSegments="DRICHTrackSegments",
+                              outputLikelihoods="DRICHPID",
+                              outputRings="DRICHRings"),
+        ]
+    return collections + ["DRICHHits"], algs
+
+
+def far_forward():
+    """Roman pots digitization, hit reconstruction and far-forward proton reconstruction"""
+    algs = [
+        TrackerDigi("ffi_romanpot_digi",
+                    inputHitCollection="ForwardRomanPotHits",
+                    outputHitCollection="ForwardRomanPotHitsDigi",
+                    timeResolution=8 * units.ns),
+        TrackerHitReconstruction("ffi_romanpot_reco",
+                                 inputHitCollection="ForwardRomanPotHitsDigi",
+                                 outputHitCollection="ForwardRomanPotHitsReco",
+                                 readoutClass="ForwardRomanPotHits",
+                                 cacheGeometry=True),
+        FarForwardParticles("ffi_romanpot_parts",
+                            inputCollection="ForwardRomanPotHitsReco",
+                            outputCollection="ReconstructedFFRomanPotParticles"),
+    ]
+    return ["MCParticles", "ForwardRomanPotHits"], algs
+
+
+def full_chain():
+    """All of the chains above on the same events"""
+    collections, algs = rich(with_tracking=True)
+    for chain in (imaging_ecal, far_forward):
+        chain_collections, chain_algs = chain()
+        collections += [c for c in chain_collections if c not in collections]
+        algs += chain_algs
+    return collections, algs
+
+
+def run(chain):
+    """Configure the job of a chain, with the per-algorithm statistics of the auditor"""
+    collections, algs = chain()
+    services = [
+        GeoSvc("GeoSvc", detectors=[compact_path], OutputLevel=WARNING),
+        CellGeometrySvc("CellGeometrySvc"),
+        RandomSvc("RandomSvc", seed=1),
+        CPUDispatchSvc("CPUDispatchSvc", level=simd_level),
+        EICDataSvc("EventDataSvc", inputs=[input_file], OutputLevel=WARNING),
+    ]
+    if n_threads != 1:
+        # the one arena of the parallel algorithms
+        services.append(ConcurrencySvc("ConcurrencySvc", numThreads=n_threads))
+    podioinput = PodioInput("PodioReader", collections=collections, OutputLevel=WARNING)
+
+    AuditorSvc().Auditors = [AlgorithmStatsAuditor("AlgorithmStatsAuditor", jsonFile=stats_file)]
+    ApplicationMgr(
+        TopAlg=[podioinput] + algs,
+        EvtSel="NONE",
+        EvtMax=n_events,
+        ExtSvc=services,
+        AuditAlgorithms=True,
+        OutputLevel=WARNING,
+    )
@@ -0,0 +1,7 @@
+# SPDX-License-Identifier: LGPL-3.0-or-later
+# Copyright (C) 2022 Wouter Deconinck
+
+# End-to-end benchmark of the full reconstruction chain, see chains.py
+from chains import full_chain, run
+
+run(full_chain)
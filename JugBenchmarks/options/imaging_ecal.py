@@ -0,0 +1,7 @@
+# SPDX-License-Identifier: LGPL-3.0-or-later
+# Copyright (C) 2022 Wouter Deconinck
+
+# End-to-end benchmark of the imaging ECal chain, see chains.py
+from chains import imaging_ecal, run
+
+run(imaging_ecal)
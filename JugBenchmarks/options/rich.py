@@ -0,0 +1,7 @@
+# SPDX-License-Identifier: LGPL-3.0-or-later
+# Copyright (C) 2022 Wouter Deconinck
+
+# End-to-end benchmark of the RICH chain, see chains.py
+from chains import rich, run
+
+run(rich)
@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: LGPL-3.0-or-later
+# Copyright (C) 2022 Wouter Deconinck
+
+"""End-to-end benchmarks of the reconstruction chains.
+
+Runs the chain option files of JugBenchmarks/options with gaudirun on their reference inputs,
+and writes a JSON report per run with, for each chain:
+  - the throughput, in events per second of the job wall time and of the algorithm time only,
+  - the peak resident memory of the job,
+  - the per-algorithm statistics of Jug::Base::AlgorithmStatsAuditor,
+  - the input file and its SHA-256, so that only runs on the same inputs are compared.
+
+The reference input of a chain is <input-dir>/<chain>.edm4hep.root (the full chain uses the
+RICH input, which has the tracker hits too, unless full_chain.edm4hep.root exists). Chains
+without their input are skipped, with exit code 77 if no chain could be run (the CTest skip code).
+"""
+
+import argparse
+import datetime
+import hashlib
+import json
+import os
+import platform
+import subprocess
+import sys
+import tempfile
+import time
+
+CHAINS = ["central_tracking", "imaging_ecal", "rich", "far_forward", "full_chain"]
+OPTIONS_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), os.pardir, "options")
+SKIP_RETURN_CODE = 77
+
+
+def sha256(filename):
+    digest = hashlib.sha256()
+    with open(filename, "rb") as f:
+        for block in iter(lambda: f.read(1 << 20), b""):
+            digest.update(block)
+    return digest.hexdigest()
+
+
+def reference_input(input_dir, chain):
+    candidates = [chain] + (["rich"] if chain == "full_chain" else [])
+    for name in candidates:
+        filename = os.path.join(input_dir, name + ".edm4hep.root")
+        if os.path.isfile(filename):
+            return filename
+    return None
+
+
+def run_chain(args, chain, input_file):
+    with tempfile.TemporaryDirectory(prefix="jug_benchmark_") as workdir:
+        stats_file = os.path.join(workdir, "stats.json")
+        env = dict(os.environ)
+        env["JUG_BENCH_INPUT"] = input_file
+        env["JUG_BENCH_NEVENTS"] = str(args.events)
+        env["JUG_BENCH_STATS"] = stats_file
+        env["JUG_BENCH_THREADS"] = str(args.threads)
+        env["PYTHONPATH"] = os.pathsep.join(filter(None, [os.path.abspath(OPTIONS_DIR), env.get("PYTHONPATH")]))
+        if args.alloc_counter:
+            # the per-algorithm allocations are only counted with the counting operator new preloaded
+            env["LD_PRELOAD"] = os.pathsep.join(filter(None, [os.path.abspath(args.alloc_counter),
+                                                              env.get("LD_PRELOAD")]))
+        command = args.gaudirun.split() + [os.path.join(OPTIONS_DIR, chain + ".py")]
+
+        log_file = os.path.join(args.log_dir, chain + ".log") if args.log_dir else os.devnull
+        with open(log_file, "w") as log:
+            start = time.perf_counter()
+            process = subprocess.Popen(command, env=env, cwd=workdir, stdout=log, stderr=subprocess.STDOUT)
+            # the resource usage of this job only
+            _, status, usage = os.wait4(process.pid, 0)
+            wall = time.perf_counter() - start
+        returncode = os.waitstatus_to_exitcode(status) if hasattr(os, "waitstatus_to_exitcode") else status >> 8
+        process.returncode = returncode
+
+        algorithms = []
+        if os.path.isfile(stats_file):
+            with open(stats_file) as f:
+                algorithms = json.load(f)
+
+    # ru_maxrss is in kB on Linux, in bytes on macOS
+    max_rss_mb = usage.ru_maxrss / (1024. * 1024. if sys.platform == "darwin" else 1024.)
+    # the algorithm time excludes the job initialization and finalization
+    reader = next((a for a in algorithms if a["algorithm"] == "PodioReader"), None)
+    events = reader["calls"] if reader else args.events
+    event_ms = sum(a["wall_total_ms"] for a in algorithms if a["algorithm"] != "PodioReader")
+    return {
+        "chain": chain,
+        "status": "ok" if returncode == 0 else "failed",
+        "returncode": returncode,
+        "input": {"file": os.path.abspath(input_file), "sha256": sha256(input_file)},
+        "events": events,
+        "threads": args.threads,
+        "wall_s": wall,
+        "user_cpu_s": usage.ru_utime,
+        "system_cpu_s": usage.ru_stime,
+        "events_per_s": events / wall if wall > 0 else 0.,
+        "events_per_s_algorithms": 1e3 * events / event_ms if event_ms > 0 else 0.,
+        "max_rss_mb": max_rss_mb,
+        "algorithms": sorted(algorithms, key=lambda a: a["wall_total_ms"], reverse=True),
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--chain", action="append", choices=CHAINS, help="chains to run (default: all)")
+    parser.add_argument("--input-dir", default=os.environ.get("JUG_BENCH_INPUT_DIR", ""),
+                        help="directory of the reference inputs")
+    parser.add_argument("--events", type=int, default=100, help="events per chain")
+    parser.add_argument("--threads", type=int, default=1, help="intra-event threads of the algorithms")
+    parser.add_argument("--repeat", type=int, default=1, help="runs per chain, the fastest is reported")
+    parser.add_argument("--gaudirun", default="gaudirun.py", help="command running an option file")
+    parser.add_argument("--alloc-counter", default="",
+                        help="libJugAllocCounter.so, preloaded to count the allocations of the algorithms")
+    parser.add_argument("--log-dir", default="", help="directory of the job logs (none by default)")
+    parser.add_argument("--output", default="benchmarks.json", help="JSON report")
+    args = parser.parse_args()
+    if args.log_dir:
+        os.makedirs(args.log_dir, exist_ok=True)
+
+    results = []
+    failed = False
+    for chain in args.chain or CHAINS:
+        input_file = reference_input(args.input_dir, chain) if args.input_dir else None
+        if input_file is None:
+            print(f"{chain}: no reference input in '{args.input_dir}', skipped")
+            continue
+        runs = [run_chain(args, chain, input_file) for _ in range(max(args.repeat, 1))]
+        best = min(runs, key=lambda r: (r["status"] != "ok", r["wall_s"]))
+        best["repeats"] = len(runs)
+        results.append(best)
+        failed |= best["status"] != "ok"
+        print(f"{chain}: {best['status']}, {best['events']} events, {best['events_per_s']:.2f} events/s, "
+              f"{best['max_rss_mb']:.0f} MB RSS")
+
+    report = {
+        "date": datetime.datetime.now(datetime.timezone.utc).isoformat(),
+        "host": platform.node(),
+        "machine": platform.machine(),
+        "cpus": os.cpu_count(),
+        "chains": results,
+    }
+    os.makedirs(os.path.dirname(os.path.abspath(args.output)), exist_ok=True)
+    with open(args.output, "w") as f:
+        json.dump(report, f, indent=2)
+
+    if failed:
+        return 1
+    return 0 if results else SKIP_RETURN_CODE
+
+
+if __name__ == "__main__":
+    sys.exit(main())
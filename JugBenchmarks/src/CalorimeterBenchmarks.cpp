@@ -0,0 +1,150 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+/*
+ *  Calorimeter clustering and cluster reconstruction on synthetic hits of scaled multiplicity and
+ *  on overlays of recorded events. The recorded hit collections are set with JUG_BENCH_CALO_HITS
+ *  and JUG_BENCH_IMAGING_HITS.
+ */
+#include <stdexcept>
+
+#include "KernelBenchmark.h"
+
+namespace {
+
+using namespace Jug::Bench;
+using CaloHits = eicd::CalorimeterHitCollection;
+
+IAlgorithm* islandCluster() {
+  return GaudiHarness::instance().algorithm("Jug::Reco::CalorimeterIslandCluster", "BenchIslandCluster",
+                                            {{"inputHitCollection", "'CaloHits'"},
+                                             {"outputProtoClusterCollection", "'CaloProtoClusters'"},
+                                             {"dimScaledLocalDistXY", "[1.8, 1.8]"},
+                                             {"minClusterHitEdep", "0.001"},
+                                             {"minClusterCenterEdep", "0.03"}});
+}
+
+IAlgorithm* imagingTopoCluster() {
+  return GaudiHarness::instance().algorithm("Jug::Reco::ImagingTopoCluster", "BenchImagingTopoCluster",
+                                            {{"inputHitCollection", "'ImagingHits'"},
+                                             {"outputProtoClusterCollection", "'ImagingProtoClusters'"},
+                                             {"localDistXY", "[0.8, 0.8]"},
+                                             {"layerDistEtaPhi", "[0.002, 0.002]"},
+                                             {"minClusterNhits", "5"}});
+}
+
+IAlgorithm* clusterRecoCoG() {
+  return GaudiHarness::instance().algorithm("Jug::Reco::ClusterRecoCoG", "BenchClusterRecoCoG",
+                                            {{"inputProtoClusterCollection", "'CaloProtoClusters'"},
+                                             {"outputClusterCollection", "'CaloClusters'"},
+                                             {"logWeightBase", "4.6"}});
+}
+
+// pixelated layers of an imaging calorimeter
+SyntheticCalorimeter imagingCalorimeter() {
+  SyntheticCalorimeter calo;
+  calo.cellSize       = 0.5;
+  calo.cellsPerSide   = 1000;
+  calo.layers         = 20;
+  calo.layerThickness = 20.;
+  calo.hitsPerShower  = 200;
+  calo.showerWidth    = 4.;
+  calo.showerDepth    = 6.;
+  calo.hitEnergy      = 0.001;
+  return calo;
+}
+
+const RecordedHits<CaloHits>& recordedCalorimeterHits() {
+  static const auto hits = RecordedHits<CaloHits>::read(envOr("JUG_BENCH_CALO_HITS", "EcalEndcapNRecHits"));
+  return hits;
+}
+
+const RecordedHits<CaloHits>& recordedImagingHits() {
+  static const auto hits = RecordedHits<CaloHits>::read(envOr("JUG_BENCH_IMAGING_HITS", "EcalBarrelImagingRecHits"));
+  return hits;
+}
+
+void requireGeometry() {
+  if (!GaudiHarness::instance().hasGeometry()) {
+    throw std::runtime_error("Needs the geometry, set JUG_BENCH_COMPACT");
+  }
+}
+
+void BM_CalorimeterIslandCluster_Synthetic(benchmark::State& state) {
+  guarded(state, [&] {
+    const auto hits = SyntheticCalorimeter{}.generate(state.range(0));
+    timeOnHits(state, "CaloHits", *hits, islandCluster());
+  });
+}
+
+void BM_CalorimeterIslandCluster_Recorded(benchmark::State& state) {
+  guarded(state, [&] {
+    const auto hits = recordedCalorimeterHits().overlay(0, state.range(0));
+    timeOnHits(state, "CaloHits", *hits, islandCluster());
+  });
+}
+
+void BM_ImagingTopoCluster_Synthetic(benchmark::State& state) {
+  guarded(state, [&] {
+    const auto hits = imagingCalorimeter().generate(state.range(0));
+    timeOnHits(state, "ImagingHits", *hits, imagingTopoCluster());
+  });
+}
+
+void BM_ImagingTopoCluster_Recorded(benchmark::State& state) {
+  guarded(state, [&] {
+    const auto hits = recordedImagingHits().overlay(0, state.range(0));
+    timeOnHits(state, "ImagingHits", *hits, imagingTopoCluster());
+  });
+}
+
+// the proto-clusters are made by the island clustering, untimed
+void BM_ClusterRecoCoG_Synthetic(benchmark::State& state) {
+  guarded(state, [&] {
+    requireGeometry();
+    const auto hits = SyntheticCalorimeter{}.generate(state.range(0));
+    timeOnHits(state, "CaloHits", *hits, clusterRecoCoG(), {islandCluster()});
+  });
+}
+
+void BM_ClusterRecoCoG_Recorded(benchmark::State& state) {
+  guarded(state, [&] {
+    requireGeometry();
+    const auto hits = recordedCalorimeterHits().overlay(0, state.range(0));
+    timeOnHits(state, "CaloHits", *hits, clusterRecoCoG(), {islandCluster()});
+  });
+}
+
+} // namespace
+
+// synthetic: number of hits, recorded: number of overlaid events
+BENCHMARK(BM_CalorimeterIslandCluster_Synthetic)
+    ->RangeMultiplier(4)
+    ->Range(64, 64 << 10)
+    ->Complexity()
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_CalorimeterIslandCluster_Recorded)
+    ->RangeMultiplier(2)
+    ->Range(1, 32)
+    ->Complexity()
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ImagingTopoCluster_Synthetic)
+    ->RangeMultiplier(4)
+    ->Range(256, 256 << 10)
+    ->Complexity()
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ImagingTopoCluster_Recorded)
+    ->RangeMultiplier(2)
+    ->Range(1, 32)
+    ->Complexity()
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ClusterRecoCoG_Synthetic)
+    ->RangeMultiplier(4)
+    ->Range(64, 64 << 10)
+    ->Complexity()
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ClusterRecoCoG_Recorded)
+    ->RangeMultiplier(2)
+    ->Range(1, 32)
+    ->Complexity()
+    ->Unit(benchmark::kMicrosecond);
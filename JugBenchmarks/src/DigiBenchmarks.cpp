@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+/*
+ *  Digitization of synthetic simulated hits. The digitization algorithms do not depend on Gaudi,
+ *  they are run directly on the collections with the random key of an event.
+ */
+#include <memory>
+#include <random>
+
+#include <benchmark/benchmark.h>
+
+#include "JugDigi/CalorimeterHitDigi.h"
+#include "JugDigi/PhotoMultiplierDigi.h"
+#include "JugDigi/SiliconTrackerDigi.h"
+
+#include "edm4hep/CaloHitContributionCollection.h"
+#include "edm4hep/MCParticleCollection.h"
+
+namespace {
+
+// simulated hits and the collections of the objects they refer to
+struct SimHits {
+  edm4hep::MCParticleCollection particles;
+  edm4hep::CaloHitContributionCollection contributions;
+  edm4hep::SimCalorimeterHitCollection caloHits;
+  edm4hep::SimTrackerHitCollection trackerHits;
+};
+
+// n hits of each type on 4n cells, with energies of photons (tracker) and showers (calorimeter)
+std::unique_ptr<SimHits> simHits(size_t n, uint64_t seed = 1) {
+  std::mt19937_64 rng(seed);
+  std::uniform_int_distribution<uint64_t> cell(0, 4 * n);
+  std::uniform_real_distribution<double> time(0., 10.);
+  std::exponential_distribution<double> energy(100.);
+  std::uniform_real_distribution<double> photon(2. * Jug::Units::eV, 7. * Jug::Units::eV);
+
+  auto hits     = std::make_unique<SimHits>();
+  auto particle = hits->particles.create();
+  particle.setTime(1.);
+  for (size_t i = 0; i < n; ++i) {
+    auto c = hits->contributions.create();
+    c.setEnergy(energy(rng));
+    c.setTime(time(rng));
+    auto calo = hits->caloHits.create();
+    calo.setCellID(cell(rng));
+    calo.setEnergy(c.getEnergy());
+    calo.addToContributions(c);
+
+    auto tracker = hits->trackerHits.create();
+    tracker.setCellID(cell(rng));
+    tracker.setEDep(photon(rng));
+    tracker.setMCParticle(particle);
+  }
+  return hits;
+}
+
+template <typename Algo, typename Collection>
+void timeDigi(benchmark::State& state, Algo& alg, const Collection& hits) {
+  uint64_t event = 0;
+  for (auto _ : state) {
+    const auto [raw] = alg.execute({hits}, {event, Jug::Base::Random::mix64(event)});
+    benchmark::DoNotOptimize(raw.size());
+    ++event;
+  }
+  const auto n = static_cast<int64_t>(hits.size());
+  state.SetComplexityN(n);
+  state.counters["hits"]    = benchmark::Counter(static_cast<double>(n));
+  state.counters["hitRate"] = benchmark::Counter(static_cast<double>(n), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+void BM_CalorimeterHitDigi(benchmark::State& state) {
+  const auto hits = simHits(state.range(0));
+  Jug::Digi::CalorimeterHitDigi alg("BenchCalorimeterHitDigi");
+  alg.u_eRes.value() = {0.1, 0.01, 0.};
+  if (!alg.initialize(nullptr)) {
+    state.SkipWithError("Cannot initialize CalorimeterHitDigi");
+    return;
+  }
+  timeDigi(state, alg, hits->caloHits);
+}
+
+void BM_SiliconTrackerDigi(benchmark::State& state) {
+  const auto hits = simHits(state.range(0));
+  Jug::Digi::SiliconTrackerDigi alg("BenchSiliconTrackerDigi");
+  alg.initialize(nullptr);
+  timeDigi(state, alg, hits->trackerHits);
+}
+
+void BM_PhotoMultiplierDigi(benchmark::State& state) {
+  const auto hits = simHits(state.range(0));
+  Jug::Digi::PhotoMultiplierDigi alg("BenchPhotoMultiplierDigi");
+  alg.initialize(nullptr);
+  timeDigi(state, alg, hits->trackerHits);
+}
+
+void BM_PhotoMultiplierDigiSorted(benchmark::State& state) {
+  const auto hits = simHits(state.range(0));
+  Jug::Digi::PhotoMultiplierDigi alg("BenchPhotoMultiplierDigiSorted");
+  alg.m_sortedGrouping.value() = true;
+  alg.initialize(nullptr);
+  timeDigi(state, alg, hits->trackerHits);
+}
+
+} // namespace
+
+// number of hits
+BENCHMARK(BM_CalorimeterHitDigi)
+    ->RangeMultiplier(4)
+    ->Range(64, 256 << 10)
+    ->Complexity()
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_SiliconTrackerDigi)
+    ->RangeMultiplier(4)
+    ->Range(64, 256 << 10)
+    ->Complexity()
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_PhotoMultiplierDigi)
+    ->RangeMultiplier(4)
+    ->Range(64, 256 << 10)
+    ->Complexity()
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_PhotoMultiplierDigiSorted)
+    ->RangeMultiplier(4)
+    ->Range(64, 256 << 10)
+    ->Complexity()
+    ->Unit(benchmark::kMicrosecond);
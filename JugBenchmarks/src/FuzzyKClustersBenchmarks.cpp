@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+/*
+ *  Fuzzy k-rings clustering of synthetic Cherenkov rings, the kernel of PhotoRingClusters.
+ *  The kernel does not depend on Gaudi, it is run directly on the hit positions.
+ */
+#include <array>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "FuzzyKClusters.h"
+
+namespace {
+
+// n hits on k rings of 20-50 mm radius, smeared by 1 mm
+Eigen::MatrixXd ringHits(size_t n, int k, uint64_t seed = 1) {
+  std::mt19937_64 rng(seed);
+  std::uniform_real_distribution<double> center(-200., 200.);
+  std::uniform_real_distribution<double> radius(20., 50.);
+  std::uniform_real_distribution<double> angle(0., 2. * M_PI);
+  std::normal_distribution<double> smear(0., 1.);
+
+  std::vector<std::array<double, 3>> rings(k);
+  for (auto& ring : rings) {
+    ring = {center(rng), center(rng), radius(rng)};
+  }
+  Eigen::MatrixXd data(n, 2);
+  for (size_t i = 0; i < n; ++i) {
+    const auto& ring = rings[i % rings.size()];
+    const double phi = angle(rng);
+    data(i, 0)       = ring[0] + (ring[2] + smear(rng)) * std::cos(phi);
+    data(i, 1)       = ring[1] + (ring[2] + smear(rng)) * std::sin(phi);
+  }
+  return data;
+}
+
+void BM_FuzzyKRings(benchmark::State& state, int k) {
+  const auto n      = static_cast<size_t>(state.range(0));
+  const auto data   = ringHits(n, k);
+  double iterations = 0;
+  for (auto _ : state) {
+    fkc::KRings rings;
+    benchmark::DoNotOptimize(rings.Fit(data, k));
+    iterations += rings.NIters();
+  }
+  state.SetComplexityN(static_cast<int64_t>(n));
+  state.counters["hits"]     = benchmark::Counter(static_cast<double>(n));
+  state.counters["fitIters"] = benchmark::Counter(iterations, benchmark::Counter::kAvgIterations);
+}
+
+} // namespace
+
+// number of hits, per number of rings
+BENCHMARK_CAPTURE(BM_FuzzyKRings, TwoRings, 2)
+    ->RangeMultiplier(4)
+    ->Range(64, 16 << 10)
+    ->Complexity()
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_FuzzyKRings, FourRings, 4)
+    ->RangeMultiplier(4)
+    ->Range(64, 16 << 10)
+    ->Complexity()
+    ->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,142 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "GaudiHarness.h"
+
+#include <cstdlib>
+#include <sstream>
+
+#include "Gaudi/Interfaces/IOptionsSvc.h"
+#include "GaudiKernel/Bootstrap.h"
+#include "GaudiKernel/EventContext.h"
+#include "GaudiKernel/IAlgManager.h"
+#include "GaudiKernel/IAppMgrUI.h"
+#include "GaudiKernel/IProperty.h"
+#include "GaudiKernel/ISvcLocator.h"
+#include "GaudiKernel/ThreadLocalContext.h"
+
+namespace {
+
+std::string env(const char* name, const std::string& def = "") {
+  const char* value = std::getenv(name);
+  return (value != nullptr) ? std::string(value) : def;
+}
+
+// Python list of the comma-separated values
+std::string pythonList(const std::string& values) {
+  std::stringstream in(values);
+  std::string out = "[";
+  std::string item;
+  while (std::getline(in, item, ',')) {
+    out += (out.size() > 1 ? ", '" : "'") + item + "'";
+  }
+  return out + "]";
+}
+
+void check(const StatusCode& sc, const std::string& what) {
+  if (sc.isFailure()) {
+    throw std::runtime_error("Failed to " + what);
+  }
+}
+
+} // namespace
+
+namespace Jug::Bench {
+
+namespace {
+std::unique_ptr<GaudiHarness> s_harness;
+} // namespace
+
+GaudiHarness& GaudiHarness::instance() {
+  if (s_harness == nullptr) {
+    s_harness.reset(new GaudiHarness());
+  }
+  return *s_harness;
+}
+
+void GaudiHarness::shutdown() { s_harness.reset(); }
+
+GaudiHarness::GaudiHarness() : m_app{Gaudi::createApplicationMgr()} {
+  const std::string compact = env("JUG_BENCH_COMPACT");
+  m_hasGeometry             = !compact.empty();
+
+  SmartIF<IProperty> props(m_app);
+  SmartIF<IAppMgrUI> appMgr(m_app);
+  if (!props || !appMgr) {
+    throw std::runtime_error("Cannot create the application manager");
+  }
+  check(props->setPropertyRepr("JobOptionsType", "'NONE'"), "disable the job options");
+  check(props->setPropertyRepr("EvtSel", "'NONE'"), "disable the event selector");
+  check(props->setPropertyRepr("EvtMax", "0"), "set the number of events");
+  check(props->setPropertyRepr("OutputLevel", env("JUG_BENCH_OUTPUT_LEVEL", "4")), "set the output level");
+  check(props->setPropertyRepr("ExtSvc", m_hasGeometry ? "['EICDataSvc/EventDataSvc', 'GeoSvc']"
+                                                       : "['EICDataSvc/EventDataSvc']"),
+        "set the services");
+  check(appMgr->configure(), "configure the application manager");
+
+  SmartIF<ISvcLocator> svcLoc(m_app);
+  if (m_hasGeometry) {
+    svcLoc->getOptsSvc().set("GeoSvc.detectors", pythonList(compact));
+  }
+  check(appMgr->initialize(), "initialize the application manager");
+  check(appMgr->start(), "start the application manager");
+
+  m_evtSvc = svcLoc->service("EventDataSvc");
+  m_evtMgr = m_evtSvc;
+  if (!m_evtSvc || !m_evtMgr) {
+    throw std::runtime_error("Cannot locate the event store");
+  }
+}
+
+GaudiHarness::~GaudiHarness() {
+  for (auto& [name, alg] : m_algorithms) {
+    alg->sysStop().ignore();
+    alg->sysFinalize().ignore();
+  }
+  m_algorithms.clear();
+  if (m_event >= 0) {
+    m_evtMgr->clearStore().ignore();
+  }
+  m_evtMgr.reset();
+  m_evtSvc.reset();
+  SmartIF<IAppMgrUI> appMgr(m_app);
+  appMgr->stop().ignore();
+  appMgr->finalize().ignore();
+  appMgr->terminate().ignore();
+}
+
+IAlgorithm* GaudiHarness::algorithm(const std::string& type, const std::string& name, const Properties& properties) {
+  auto it = m_algorithms.find(name);
+  if (it != m_algorithms.end()) {
+    return it->second;
+  }
+  SmartIF<ISvcLocator> svcLoc(m_app);
+  // the properties are set from the options when the algorithm is created
+  auto& opts = svcLoc->getOptsSvc();
+  for (const auto& [key, value] : properties) {
+    opts.set(name + "." + key, value);
+  }
+  SmartIF<IAlgManager> algMgr(m_app);
+  IAlgorithm* alg = nullptr;
+  check(algMgr->createAlgorithm(type, name, alg), "create " + type + "/" + name);
+  check(alg->sysInitialize(), "initialize " + name);
+  check(alg->sysStart(), "start " + name);
+  m_algorithms.emplace(name, alg);
+  return alg;
+}
+
+void GaudiHarness::newEvent() {
+  if (m_event >= 0) {
+    check(m_evtMgr->clearStore(), "clear the event store");
+  }
+  ++m_event;
+  check(m_evtMgr->setRoot("/Event", new DataObject()), "set the event root");
+}
+
+void GaudiHarness::execute(IAlgorithm* alg) {
+  EventContext ctx(m_event, 0);
+  Gaudi::Hive::setCurrentContext(ctx);
+  check(alg->sysExecute(ctx), "execute " + alg->name());
+}
+
+} // namespace Jug::Bench
@@ -0,0 +1,98 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBENCHMARKS_GAUDIHARNESS_H
+#define JUGBENCHMARKS_GAUDIHARNESS_H
+
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "GaudiKernel/DataObject.h"
+#include "GaudiKernel/IAlgorithm.h"
+#include "GaudiKernel/IDataManagerSvc.h"
+#include "GaudiKernel/IDataProviderSvc.h"
+#include "GaudiKernel/IInterface.h"
+#include "GaudiKernel/SmartIF.h"
+
+#include "JugBase/DataWrapper.h"
+
+namespace Jug::Bench {
+
+/** Minimal Gaudi application to run single algorithms outside of a job.
+ *
+ *  There is no event loop and no input: for every benchmark iteration the event store (EICDataSvc)
+ *  is cleared and filled with the prepared collections, and the algorithms are executed directly.
+ *  The algorithms are loaded from the plugin modules, which have to be in LD_LIBRARY_PATH.
+ *
+ *  The environment configures the harness:
+ *    - JUG_BENCH_COMPACT: comma-separated compact files for GeoSvc, needed by the algorithms
+ *      that use the geometry (no GeoSvc if not set)
+ *    - JUG_BENCH_OUTPUT_LEVEL: Gaudi output level, 4 (WARNING) by default
+ *
+ *  Failures are reported as std::runtime_error.
+ */
+class GaudiHarness {
+public:
+  using Properties = std::map<std::string, std::string>;
+
+  /// Application, booted on first use
+  static GaudiHarness& instance();
+  /// Finalize the algorithms and the application, before the static objects are destroyed
+  static void shutdown();
+
+  GaudiHarness(const GaudiHarness&) = delete;
+  GaudiHarness& operator=(const GaudiHarness&) = delete;
+  ~GaudiHarness();
+
+  /// GeoSvc is available
+  bool hasGeometry() const { return m_hasGeometry; }
+
+  /** Algorithm of the given type, created and initialized on first use.
+   *
+   *  The properties are given as their Python representation, e.g. {"inputHitCollection", "'Hits'"}.
+   *  Algorithms are identified by name, the properties are only used when the algorithm is created.
+   */
+  IAlgorithm* algorithm(const std::string& type, const std::string& name, const Properties& properties = {});
+
+  /// Clear the event store and start a new event
+  void newEvent();
+
+  /// Put a collection in the event store of the current event
+  template <typename T> void put(const std::string& name, std::unique_ptr<T> collection) {
+    auto* wrapper = new DataWrapper<T>();
+    wrapper->setData(collection.release());
+    if (m_evtSvc->registerObject("/Event/" + name, wrapper).isFailure()) {
+      throw std::runtime_error("Cannot register " + name + " in the event store");
+    }
+  }
+
+  /// Collection of the current event, nullptr if it does not exist
+  template <typename T> const T* get(const std::string& name) {
+    DataObject* object = nullptr;
+    if (m_evtSvc->retrieveObject("/Event/" + name, object).isFailure()) {
+      return nullptr;
+    }
+    auto* wrapper = dynamic_cast<DataWrapper<T>*>(object);
+    return (wrapper != nullptr) ? wrapper->getData() : nullptr;
+  }
+
+  /// Execute an algorithm on the current event
+  void execute(IAlgorithm* alg);
+
+private:
+  GaudiHarness();
+
+  SmartIF<IInterface> m_app;
+  SmartIF<IDataProviderSvc> m_evtSvc;
+  SmartIF<IDataManagerSvc> m_evtMgr;
+  std::map<std::string, IAlgorithm*> m_algorithms;
+  bool m_hasGeometry{false};
+  long m_event{-1};
+};
+
+} // namespace Jug::Bench
+
+#endif
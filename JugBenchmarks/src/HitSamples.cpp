@@ -0,0 +1,137 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "HitSamples.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+#include "podio/EventStore.h"
+#include "podio/ROOTReader.h"
+
+namespace Jug::Bench {
+
+std::unique_ptr<eicd::CalorimeterHitCollection> SyntheticCalorimeter::generate(size_t n, uint64_t seed) const {
+  // enlarge the calorimeter to keep the occupancy low enough for the showers to be separable
+  size_t side = cellsPerSide;
+  while (static_cast<double>(n) > maxOccupancy * static_cast<double>(side * side * layers)) {
+    side += side / 4 + 1;
+  }
+
+  std::mt19937_64 rng(seed);
+  std::uniform_real_distribution<double> center(0., static_cast<double>(side));
+  std::normal_distribution<double> transverse(0., showerWidth);
+  std::exponential_distribution<double> depth(1. / showerDepth);
+  std::exponential_distribution<double> energy(1. / hitEnergy);
+
+  // energies summed per cell, in the order the cells are hit
+  std::unordered_map<uint64_t, size_t> index;
+  std::vector<std::pair<uint64_t, double>> cells;
+  index.reserve(n);
+  cells.reserve(n);
+  double cx = 0.;
+  double cy = 0.;
+  for (size_t i = 0; cells.size() < n; ++i) {
+    if (i % hitsPerShower == 0) {
+      cx = center(rng);
+      cy = center(rng);
+    }
+    const auto ix = static_cast<int64_t>(std::floor(cx + transverse(rng)));
+    const auto iy = static_cast<int64_t>(std::floor(cy + transverse(rng)));
+    const auto il = (layers == 1) ? 0 : static_cast<int64_t>(depth(rng));
+    if (ix < 0 || iy < 0 || ix >= static_cast<int64_t>(side) || iy >= static_cast<int64_t>(side) ||
+        il >= static_cast<int64_t>(layers)) {
+      continue;
+    }
+    const uint64_t id = (static_cast<uint64_t>(il) << 40) | (static_cast<uint64_t>(iy) << 20) | ix;
+    const auto [it, inserted] = index.emplace(id, cells.size());
+    if (inserted) {
+      cells.emplace_back(id, 0.);
+    }
+    cells[it->second].second += energy(rng);
+  }
+
+  auto hits          = std::make_unique<eicd::CalorimeterHitCollection>();
+  const double half  = 0.5 * static_cast<double>(side);
+  const float width  = cellSize;
+  const float height = layerThickness;
+  for (const auto& [id, edep] : cells) {
+    const auto ix  = static_cast<double>(id & 0xFFFFF);
+    const auto iy  = static_cast<double>((id >> 20) & 0xFFFFF);
+    const auto il  = static_cast<int32_t>(id >> 40);
+    const float x  = (ix + 0.5 - half) * cellSize;
+    const float y  = (iy + 0.5 - half) * cellSize;
+    const float z  = zFront + (il + 0.5) * layerThickness;
+    auto hit       = hits->create();
+    hit.setCellID(id);
+    hit.setEnergy(edep);
+    hit.setPosition({x, y, z});
+    hit.setLocal({x, y, 0.});
+    hit.setDimension({width, width, height});
+    hit.setSector(0);
+    hit.setLayer(il);
+  }
+  return hits;
+}
+
+std::string recordedInput() {
+  const char* file = std::getenv("JUG_BENCH_INPUT");
+  return (file != nullptr) ? std::string(file) : std::string();
+}
+
+template <typename Collection>
+RecordedHits<Collection> RecordedHits<Collection>::read(const std::string& collection, size_t maxEvents) {
+  const std::string file = recordedInput();
+  if (file.empty()) {
+    throw std::runtime_error("No recorded events, set JUG_BENCH_INPUT");
+  }
+  podio::ROOTReader reader;
+  reader.openFile(file);
+  podio::EventStore store;
+  store.setReader(&reader);
+
+  RecordedHits recorded;
+  const size_t entries = std::min<size_t>(reader.getEntries(), maxEvents);
+  for (size_t i = 0; i < entries; ++i) {
+    const Collection* hits = nullptr;
+    if (!store.get(collection, hits)) {
+      throw std::runtime_error("No collection " + collection + " in " + file);
+    }
+    recorded.m_events.push_back(copyOf(*hits));
+    store.clear();
+    reader.endOfEvent();
+  }
+  reader.closeFile();
+  if (recorded.m_events.empty()) {
+    throw std::runtime_error("No events in " + file);
+  }
+  return recorded;
+}
+
+template <typename Collection> double RecordedHits<Collection>::meanHits() const {
+  size_t hits = 0;
+  for (const auto& event : m_events) {
+    hits += event->size();
+  }
+  return m_events.empty() ? 0. : static_cast<double>(hits) / static_cast<double>(m_events.size());
+}
+
+template <typename Collection>
+std::unique_ptr<Collection> RecordedHits<Collection>::overlay(size_t first, size_t count) const {
+  auto hits = std::make_unique<Collection>();
+  for (size_t i = 0; i < count; ++i) {
+    for (const auto& hit : *m_events[(first + i) % m_events.size()]) {
+      hits->push_back(hit.clone());
+    }
+  }
+  return hits;
+}
+
+template class RecordedHits<eicd::CalorimeterHitCollection>;
+template class RecordedHits<eicd::TrackerHitCollection>;
+
+} // namespace Jug::Bench
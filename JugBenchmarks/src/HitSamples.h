@@ -0,0 +1,74 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBENCHMARKS_HITSAMPLES_H
+#define JUGBENCHMARKS_HITSAMPLES_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "eicd/CalorimeterHitCollection.h"
+#include "eicd/TrackerHitCollection.h"
+
+namespace Jug::Bench {
+
+/** Synthetic calorimeter with square cells in one or more layers.
+ *
+ *  Hits are generated as showers of a fixed number of hits, with Gaussian transverse profiles
+ *  and exponential longitudinal profiles, at uniformly distributed positions. The calorimeter is
+ *  enlarged if needed to keep the occupancy below maxOccupancy. Units are GeV and mm.
+ */
+struct SyntheticCalorimeter {
+  double cellSize{20.};
+  size_t cellsPerSide{100};
+  size_t layers{1};
+  double layerThickness{10.};
+  double zFront{3000.};
+  // showers: number of hits, transverse size (in cells), depth (in layers) and energy per hit
+  size_t hitsPerShower{40};
+  double showerWidth{1.5};
+  double showerDepth{4.};
+  double hitEnergy{0.05};
+  double maxOccupancy{0.25};
+
+  /// Collection of n hits (on different cells), reproducible for a seed
+  std::unique_ptr<eicd::CalorimeterHitCollection> generate(size_t n, uint64_t seed = 1) const;
+};
+
+/// File of recorded events (JUG_BENCH_INPUT), empty if not configured
+std::string recordedInput();
+
+/** Hit collections of recorded events, read from the podio file of recordedInput().
+ *
+ *  Instantiated for eicd::CalorimeterHitCollection and eicd::TrackerHitCollection. Higher
+ *  occupancies are obtained by overlaying the hits of several consecutive events.
+ */
+template <typename Collection> class RecordedHits {
+public:
+  /// Read the collection of up to maxEvents events, throws std::runtime_error on failure
+  static RecordedHits read(const std::string& collection, size_t maxEvents = 100);
+
+  size_t events() const { return m_events.size(); }
+  double meanHits() const;
+
+  /// Hits of the events [first, first + count), wrapping around the recorded events
+  std::unique_ptr<Collection> overlay(size_t first, size_t count) const;
+
+private:
+  std::vector<std::unique_ptr<Collection>> m_events;
+};
+
+/// Copy of a hit collection, to put the same hits in the store of every event
+template <typename Collection> std::unique_ptr<Collection> copyOf(const Collection& hits) {
+  auto copy = std::make_unique<Collection>();
+  for (const auto& hit : hits) {
+    copy->push_back(hit.clone());
+  }
+  return copy;
+}
+
+} // namespace Jug::Bench
+
+#endif
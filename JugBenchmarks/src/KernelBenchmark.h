@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGBENCHMARKS_KERNELBENCHMARK_H
+#define JUGBENCHMARKS_KERNELBENCHMARK_H
+
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "GaudiHarness.h"
+#include "HitSamples.h"
+
+namespace Jug::Bench {
+
+/// Value of an environment variable, def if not set
+inline std::string envOr(const char* name, const std::string& def) {
+  const char* value = std::getenv(name);
+  return (value != nullptr) ? std::string(value) : def;
+}
+
+/// Run the body of a benchmark, a failure skips the benchmark with its message
+template <typename Body> void guarded(benchmark::State& state, Body&& body) {
+  try {
+    body();
+  } catch (const std::exception& e) {
+    state.SkipWithError(e.what());
+  }
+}
+
+/** Time an algorithm on a hit collection.
+ *
+ *  For every iteration a copy of the hits is put in a new event as input, and the algorithms of
+ *  `prepare` are run to produce the other inputs; only the execution of `alg` is timed. The
+ *  number of hits is the complexity parameter, for the scaling curves against hit multiplicity.
+ */
+template <typename Collection>
+void timeOnHits(benchmark::State& state, const std::string& input, const Collection& hits, IAlgorithm* alg,
+                const std::vector<IAlgorithm*>& prepare = {}) {
+  auto& gaudi = GaudiHarness::instance();
+  for (auto _ : state) {
+    state.PauseTiming();
+    gaudi.newEvent();
+    gaudi.put(input, copyOf(hits));
+    for (auto* other : prepare) {
+      gaudi.execute(other);
+    }
+    state.ResumeTiming();
+    gaudi.execute(alg);
+  }
+  const auto n = static_cast<int64_t>(hits.size());
+  state.SetComplexityN(n);
+  state.counters["hits"]    = benchmark::Counter(static_cast<double>(n));
+  state.counters["hitRate"] = benchmark::Counter(static_cast<double>(n), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+} // namespace Jug::Bench
+
+#endif
@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+/*
+ *  Neighbour searches of the spatial index library (JugBase/Utilities/SpatialIndex.h) against
+ *  the pairwise loops of the algorithms, on uniform points in (eta, phi) with periodic phi.
+ */
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "JugBase/Utilities/SpatialIndex.h"
+
+namespace {
+
+using Points = Jug::Base::SpatialPoints<2>;
+
+// uniform in eta [-4, 4] and phi [-pi, pi]
+struct EtaPhiSample {
+  std::vector<double> eta;
+  std::vector<double> phi;
+
+  explicit EtaPhiSample(size_t n, uint64_t seed = 1) : eta(n), phi(n) {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> uEta(-4., 4.);
+    std::uniform_real_distribution<double> uPhi(-M_PI, M_PI);
+    for (size_t i = 0; i < n; ++i) {
+      eta[i] = uEta(rng);
+      phi[i] = uPhi(rng);
+    }
+  }
+
+  Points points() const { return {{eta.data(), phi.data()}, eta.size(), {0., 2. * M_PI}}; }
+};
+
+constexpr double kRadius = 0.1;
+
+// neighbours of every point within kRadius, as in the clustering loops
+void BM_RadiusBruteForce(benchmark::State& state) {
+  const EtaPhiSample sample(state.range(0));
+  const auto points = sample.points();
+  for (auto _ : state) {
+    size_t pairs = 0;
+    for (size_t i = 0; i < points.size; ++i) {
+      const auto p = points.point(i);
+      for (size_t j = 0; j < points.size; ++j) {
+        pairs += static_cast<size_t>(points.distance2(p, j) <= kRadius * kRadius);
+      }
+    }
+    benchmark::DoNotOptimize(pairs);
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_RadiusCellList(benchmark::State& state) {
+  const EtaPhiSample sample(state.range(0));
+  const auto points = sample.points();
+  Jug::Base::CellList<2> cells;
+  for (auto _ : state) {
+    cells.build(points, {kRadius, kRadius});
+    size_t pairs = 0;
+    for (size_t i = 0; i < points.size; ++i) {
+      cells.forEachWithin(points.point(i), kRadius, [&pairs](uint32_t /* j */, double /* d2 */) { ++pairs; });
+    }
+    benchmark::DoNotOptimize(pairs);
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_RadiusKDTree(benchmark::State& state) {
+  const EtaPhiSample sample(state.range(0));
+  const auto points = sample.points();
+  Jug::Base::KDTree<2> tree;
+  for (auto _ : state) {
+    tree.build(points);
+    size_t pairs = 0;
+    for (size_t i = 0; i < points.size; ++i) {
+      tree.forEachWithin(points.point(i), kRadius, [&pairs](uint32_t /* j */, double /* d2 */) { ++pairs; });
+    }
+    benchmark::DoNotOptimize(pairs);
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+// nearest point of a second sample for every point, as in the truth and cluster matching
+void BM_NearestBruteForce(benchmark::State& state) {
+  const EtaPhiSample sample(state.range(0));
+  const EtaPhiSample queries(state.range(0), 2);
+  const auto points = sample.points();
+  for (auto _ : state) {
+    for (size_t q = 0; q < queries.eta.size(); ++q) {
+      const std::array<double, 2> p{queries.eta[q], queries.phi[q]};
+      double best = std::numeric_limits<double>::max();
+      for (size_t j = 0; j < points.size; ++j) {
+        best = std::min(best, points.distance2(p, j));
+      }
+      benchmark::DoNotOptimize(best);
+    }
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_NearestKDTree(benchmark::State& state) {
+  const EtaPhiSample sample(state.range(0));
+  const EtaPhiSample queries(state.range(0), 2);
+  const auto points = sample.points();
+  Jug::Base::KDTree<2> tree;
+  std::vector<std::pair<double, uint32_t>> nearest;
+  for (auto _ : state) {
+    tree.build(points);
+    for (size_t q = 0; q < queries.eta.size(); ++q) {
+      tree.nearest({queries.eta[q], queries.phi[q]}, 1, nearest);
+      benchmark::DoNotOptimize(nearest.data());
+    }
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+} // namespace
+
+// number of points, including the index build
+BENCHMARK(BM_RadiusBruteForce)->RangeMultiplier(4)->Range(64, 4 << 10)->Complexity()->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_RadiusCellList)->RangeMultiplier(4)->Range(64, 64 << 10)->Complexity()->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_RadiusKDTree)->RangeMultiplier(4)->Range(64, 64 << 10)->Complexity()->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_NearestBruteForce)->RangeMultiplier(4)->Range(64, 4 << 10)->Complexity()->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_NearestKDTree)->RangeMultiplier(4)->Range(64, 64 << 10)->Complexity()->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,49 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+/*
+ *  Source linking of recorded tracker hits, which need the geometry for their surfaces. The hit
+ *  multiplicity is scaled by overlaying recorded events, the collection is set with
+ *  JUG_BENCH_TRACKER_HITS.
+ */
+#include <stdexcept>
+
+#include "KernelBenchmark.h"
+
+namespace {
+
+using namespace Jug::Bench;
+using TrackerHits = eicd::TrackerHitCollection;
+
+IAlgorithm* trackerSourceLinker() {
+  return GaudiHarness::instance().algorithm("Jug::Reco::TrackerSourceLinker", "BenchTrackerSourceLinker",
+                                            {{"inputHitCollection", "'TrackerHits'"},
+                                             {"sourceLinkStorage", "'TrackerSourceLinkStorage'"},
+                                             {"outputSourceLinks", "'TrackerSourceLinks'"},
+                                             {"outputMeasurements", "'TrackerMeasurements'"},
+                                             {"outputSpacePoints", "'TrackerSpacePoints'"}});
+}
+
+const RecordedHits<TrackerHits>& recordedTrackerHits() {
+  static const auto hits = RecordedHits<TrackerHits>::read(envOr("JUG_BENCH_TRACKER_HITS", "TrackerBarrelRecHits"));
+  return hits;
+}
+
+void BM_TrackerSourceLinker_Recorded(benchmark::State& state) {
+  guarded(state, [&] {
+    if (!GaudiHarness::instance().hasGeometry()) {
+      throw std::runtime_error("Needs the geometry, set JUG_BENCH_COMPACT");
+    }
+    const auto hits = recordedTrackerHits().overlay(0, state.range(0));
+    timeOnHits(state, "TrackerHits", *hits, trackerSourceLinker());
+  });
+}
+
+} // namespace
+
+// number of overlaid events
+BENCHMARK(BM_TrackerSourceLinker_Recorded)
+    ->RangeMultiplier(2)
+    ->Range(1, 64)
+    ->Complexity()
+    ->Unit(benchmark::kMicrosecond);
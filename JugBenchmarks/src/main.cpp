@@ -0,0 +1,18 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include <benchmark/benchmark.h>
+
+#include "GaudiHarness.h"
+
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  // the algorithms and the application are finalized before the plugin libraries are unloaded
+  Jug::Bench::GaudiHarness::shutdown();
+  return 0;
+}
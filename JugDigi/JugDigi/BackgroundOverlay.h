@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGDIGI_BACKGROUNDOVERLAY_H
+#define JUGDIGI_BACKGROUNDOVERLAY_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "podio/EventStore.h"
+#include "podio/ROOTReader.h"
+
+#include "edm4hep/CaloHitContributionCollection.h"
+#include "edm4hep/SimCalorimeterHitCollection.h"
+#include "edm4hep/SimTrackerHitCollection.h"
+
+#include "JugBase/Utilities/Philox.h"
+
+namespace Jug::Digi {
+
+  /// Background event of the pool and time offset [ns] overlaid on a signal event
+  struct BackgroundSample {
+    uint32_t event;
+    double timeOffset;
+  };
+
+  /** Background events overlaid on a signal event.
+   *
+   *  A Poisson number of events of mean `mean`, each a uniform pick in the pool with a uniform time
+   *  offset in [timeMin, timeMax), from the stream (key, stream) of the event. The algorithms that
+   *  use the same key and stream (and pools) overlay the same background events in all the
+   *  collections of an event.
+   */
+  inline void sampleBackground(uint64_t key, uint64_t stream, double mean, size_t poolSize, double timeMin,
+                               double timeMax, std::vector<BackgroundSample>& samples) {
+    samples.clear();
+    if (mean <= 0. || poolSize == 0) {
+      return;
+    }
+    Jug::Base::Random::Stream random(key, stream);
+    size_t count = 0;
+    if (mean < 100.) {
+      // inversion of the cumulative distribution
+      const double u = random.uniform();
+      double p       = std::exp(-mean);
+      double cdf     = p;
+      while (u > cdf && p > 0.) {
+        ++count;
+        p *= mean / count;
+        cdf += p;
+      }
+    } else {
+      count = static_cast<size_t>(std::max(0., std::round(mean + std::sqrt(mean) * random.normal())));
+    }
+    samples.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+      const auto event = std::min(static_cast<size_t>(random.uniform() * poolSize), poolSize - 1);
+      samples.push_back({static_cast<uint32_t>(event), timeMin + (timeMax - timeMin) * random.uniform()});
+    }
+  }
+
+  /** Pool of background calorimeter hits, preloaded in a compact structure of arrays.
+   *
+   *  The hits of event e are [hitBegin[e], hitBegin[e + 1]), the contributions of hit h are
+   *  [contributionBegin[h], contributionBegin[h + 1]). The relations to the background particles
+   *  are not kept.
+   */
+  struct CalorimeterBackgroundPool {
+    std::vector<uint32_t> hitBegin{0};
+    std::vector<uint64_t> cellID;
+    std::vector<float> energy;
+    std::vector<edm4hep::Vector3f> position;
+    std::vector<uint32_t> contributionBegin{0};
+    std::vector<int32_t> pdg;
+    std::vector<float> contributionEnergy;
+    std::vector<float> time;
+    std::vector<edm4hep::Vector3f> stepPosition;
+
+    size_t size() const { return hitBegin.size() - 1; }
+
+    void add(const edm4hep::SimCalorimeterHitCollection& hits) {
+      for (const auto& hit : hits) {
+        cellID.push_back(hit.getCellID());
+        energy.push_back(hit.getEnergy());
+        position.push_back(hit.getPosition());
+        for (const auto& c : hit.getContributions()) {
+          pdg.push_back(c.getPDG());
+          contributionEnergy.push_back(c.getEnergy());
+          time.push_back(c.getTime());
+          stepPosition.push_back(c.getStepPosition());
+        }
+        contributionBegin.push_back(static_cast<uint32_t>(pdg.size()));
+      }
+      hitBegin.push_back(static_cast<uint32_t>(cellID.size()));
+    }
+  };
+
+  /** Pool of background tracker hits, preloaded in a compact structure of arrays.
+   *
+   *  The hits of event e are [hitBegin[e], hitBegin[e + 1]). The relations to the background
+   *  particles are not kept.
+   */
+  struct TrackerBackgroundPool {
+    std::vector<uint32_t> hitBegin{0};
+    std::vector<uint64_t> cellID;
+    std::vector<float> eDep;
+    std::vector<float> time;
+    std::vector<float> pathLength;
+    std::vector<int32_t> quality;
+    std::vector<edm4hep::Vector3d> position;
+    std::vector<edm4hep::Vector3f> momentum;
+
+    size_t size() const { return hitBegin.size() - 1; }
+
+    void add(const edm4hep::SimTrackerHitCollection& hits) {
+      for (const auto& hit : hits) {
+        cellID.push_back(hit.getCellID());
+        eDep.push_back(hit.getEDep());
+        time.push_back(hit.getTime());
+        pathLength.push_back(hit.getPathLength());
+        quality.push_back(hit.getQuality());
+        position.push_back(hit.getPosition());
+        momentum.push_back(hit.getMomentum());
+      }
+      hitBegin.push_back(static_cast<uint32_t>(cellID.size()));
+    }
+  };
+
+  /** Fill the pool with the collection of the first poolSize events of the files.
+   *
+   *  The events without the collection are empty background events. Returns the number of events
+   *  of the pool, fewer than poolSize if the files hold fewer events.
+   */
+  template <typename Collection, typename Pool>
+  size_t loadBackground(const std::vector<std::string>& files, const std::string& collection, size_t poolSize,
+                        Pool& pool) {
+    for (const auto& file : files) {
+      podio::ROOTReader reader;
+      reader.openFile(file);
+      podio::EventStore store;
+      store.setReader(&reader);
+      const bool present = reader.getCollectionIDTable()->present(collection);
+      for (size_t i = 0; i < reader.getEntries() && pool.size() < poolSize; ++i) {
+        const Collection* hits = nullptr;
+        if (present && store.get(collection, hits)) {
+          pool.add(*hits);
+        } else {
+          pool.add(Collection());
+        }
+        store.clear();
+        reader.endOfEvent();
+      }
+      reader.closeFile();
+      if (pool.size() >= poolSize) {
+        break;
+      }
+    }
+    return pool.size();
+  }
+
+} // namespace Jug::Digi
+
+#endif
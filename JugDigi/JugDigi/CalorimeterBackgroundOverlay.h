@@ -0,0 +1,143 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGDIGI_CALORIMETERBACKGROUNDOVERLAY_H
+#define JUGDIGI_CALORIMETERBACKGROUNDOVERLAY_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "JugBase/Algorithm.h"
+#include "JugBase/Property.h"
+#include "JugBase/Utilities/FlatIndexMap.h"
+#include "JugBase/Utilities/Units.h"
+#include "JugDigi/BackgroundOverlay.h"
+
+#include "edm4hep/CaloHitContributionCollection.h"
+#include "edm4hep/SimCalorimeterHitCollection.h"
+
+namespace Jug::Digi {
+
+  /** Overlay of background events on the simulated calorimeter hits.
+   *
+   *  The background hits of the first poolSize events of backgroundFiles are kept in memory at
+   *  initialize. Each signal event gets a Poisson number of background events (meanMultiplicity),
+   *  picked in the pool with a uniform time offset in [timeOffsetMin, timeOffsetMax). The
+   *  background is merged per cell: its energy is added to the signal hit of the cell (or to a new
+   *  hit), with its contributions shifted in time. The signal hits keep their contributions, the
+   *  background contributions have no particle.
+   *
+   *  The background events of a signal event are drawn from the streams of randomName, so that the
+   *  overlays of the detectors with the same randomName and pool overlay the same events.
+   *  Framework-independent, run in Gaudi with Jug::AlgorithmAdaptor.
+   *
+   * \ingroup digi
+   * \ingroup calorimetry
+   */
+  class CalorimeterBackgroundOverlay : public Jug::Algorithm<Jug::Input<edm4hep::SimCalorimeterHitCollection>,
+                                                            Jug::Output<edm4hep::SimCalorimeterHitCollection,
+                                                                        edm4hep::CaloHitContributionCollection>> {
+  public:
+    static constexpr bool usesRandom = true;
+
+    Jug::Property<std::vector<std::string>> m_backgroundFiles{this, "backgroundFiles", {}};
+    Jug::Property<std::string> m_backgroundCollection{this, "backgroundCollection", ""};
+    Jug::Property<unsigned int> m_poolSize{this, "poolSize", 100};
+    Jug::Property<double> m_meanMultiplicity{this, "meanMultiplicity", 1.};
+    Jug::Property<double> m_timeOffsetMin{this, "timeOffsetMin", 0. * Jug::Units::ns};
+    Jug::Property<double> m_timeOffsetMax{this, "timeOffsetMax", 0. * Jug::Units::ns};
+    Jug::Property<std::string> m_randomName{this, "randomStreamName", "BackgroundOverlay"};
+
+    CalorimeterBackgroundOverlay(const std::string& name)
+        : Algorithm(name, {"inputHitCollection"}, {"outputHitCollection", "outputContributionCollection"}) {}
+
+    const std::string& randomName() const override { return m_randomName.value(); }
+
+    bool initialize(const dd4hep::Detector* /* detector */) override {
+      if (m_backgroundFiles.value().empty() || m_backgroundCollection.value().empty()) {
+        error() << "backgroundFiles and backgroundCollection are needed for the overlay" << std::endl;
+        return false;
+      }
+      if (m_timeOffsetMax.value() < m_timeOffsetMin.value()) {
+        error() << "timeOffsetMax is below timeOffsetMin" << std::endl;
+        return false;
+      }
+      try {
+        loadBackground<edm4hep::SimCalorimeterHitCollection>(m_backgroundFiles.value(), m_backgroundCollection.value(),
+                                                             m_poolSize.value(), m_pool);
+      } catch (const std::exception& e) {
+        error() << "Cannot read the background: " << e.what() << std::endl;
+        return false;
+      }
+      if (m_pool.size() == 0) {
+        error() << "No background events in backgroundFiles" << std::endl;
+        return false;
+      }
+      info() << "Background pool of " << m_pool.size() << " events, " << m_pool.cellID.size() << " hits of "
+             << m_backgroundCollection.value() << std::endl;
+      return true;
+    }
+
+    Output execute(const Input& input, const Jug::AlgorithmContext& context) const override {
+      const auto& simhits = std::get<0>(input);
+      std::vector<BackgroundSample> samples;
+      sampleBackground(context.randomKey, 0, m_meanMultiplicity.value(), m_pool.size(), m_timeOffsetMin.value(),
+                       m_timeOffsetMax.value(), samples);
+
+      edm4hep::SimCalorimeterHitCollection hits;
+      edm4hep::CaloHitContributionCollection contributions;
+      size_t nBackground = 0;
+      for (const auto& sample : samples) {
+        nBackground += m_pool.hitBegin[sample.event + 1] - m_pool.hitBegin[sample.event];
+      }
+      // the signal hits first, with their contributions, then the background cells in order
+      Jug::Base::FlatIndexMap cell_index(simhits.size() + nBackground);
+      for (const auto& ahit : simhits) {
+        const auto [icell, inserted] = cell_index.emplace(ahit.getCellID(), static_cast<uint32_t>(hits.size()));
+        if (inserted) {
+          hits.push_back(ahit.clone());
+        } else {
+          // several signal hits in a cell, merged like the background
+          auto hit = hits[icell];
+          hit.setEnergy(hit.getEnergy() + ahit.getEnergy());
+          for (const auto& c : ahit.getContributions()) {
+            hit.addToContributions(c);
+          }
+        }
+      }
+      for (const auto& sample : samples) {
+        for (uint32_t h = m_pool.hitBegin[sample.event]; h < m_pool.hitBegin[sample.event + 1]; ++h) {
+          const auto [icell, inserted] = cell_index.emplace(m_pool.cellID[h], static_cast<uint32_t>(hits.size()));
+          if (inserted) {
+            auto hit = hits.create();
+            hit.setCellID(m_pool.cellID[h]);
+            hit.setEnergy(0.);
+            hit.setPosition(m_pool.position[h]);
+          }
+          auto hit = hits[icell];
+          hit.setEnergy(hit.getEnergy() + m_pool.energy[h]);
+          for (uint32_t c = m_pool.contributionBegin[h]; c < m_pool.contributionBegin[h + 1]; ++c) {
+            auto contribution = contributions.create();
+            contribution.setPDG(m_pool.pdg[c]);
+            contribution.setEnergy(m_pool.contributionEnergy[c]);
+            contribution.setTime(static_cast<float>(m_pool.time[c] + sample.timeOffset));
+            contribution.setStepPosition(m_pool.stepPosition[c]);
+            hit.addToContributions(contribution);
+          }
+        }
+      }
+      if (msgLevel(Jug::LogLevel::kDebug)) {
+        debug() << samples.size() << " background events, " << nBackground << " hits, " << simhits.size()
+                << " signal hits in " << hits.size() << " cells" << std::endl;
+      }
+      return {std::move(hits), std::move(contributions)};
+    }
+
+  private:
+    CalorimeterBackgroundPool m_pool;
+  };
+
+} // namespace Jug::Digi
+
+#endif
@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Chao Peng, Wouter Deconinck, Whitney Armstrong, Sylvester Joosten, Jihee Kim
+
+// Apply Birks Law to correct the energy deposit
+// edm4hep::CaloHitContribution has no step length, the steps are taken from an auxiliary collection
+// of the calorimeter steps (one SimTrackerHit per step, with its cellID, energy deposit, path length
+// and particle), e.g. from a tracker action on the same sensitive volumes
+//
+// Author: Chao Peng
+// Date: 09/29/2021
+
+#ifndef JUGDIGI_CALORIMETERBIRKSCORR_H
+#define JUGDIGI_CALORIMETERBIRKSCORR_H
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "JugBase/Algorithm.h"
+#include "JugBase/Property.h"
+#include "JugBase/Utilities/FlatIndexMap.h"
+#include "JugBase/Utilities/Units.h"
+
+// Event Model related classes
+#include "edm4hep/MCParticle.h"
+#include "edm4hep/SimCalorimeterHitCollection.h"
+#include "edm4hep/SimTrackerHitCollection.h"
+
+namespace Jug::Digi {
+
+  /** Birks' law for the visible energy of calorimeter hits.
+   *
+   *  The energy of the charged steps is corrected as dE / (1 + kB dE/dx), with dx the path length
+   *  of the step, and the neutral steps are kept. The charge is the one of the MCParticle of the
+   *  step (set by the simulation, so that the ions are included), without a particle table lookup.
+   *  The hit energy is scaled by the corrected over the total energy of the steps in its cell, the
+   *  hits without steps keep their energy.
+   */
+  class BirksLaw {
+  public:
+    /// Birks constant in juggler units (mm/GeV)
+    explicit BirksLaw(double kB = 0.) : m_kB(kB) {}
+
+    double corrected(double edep, double length, double charge) const {
+      // some tolerance for precision
+      if (std::abs(charge) <= 1e-5 || length <= 0.) {
+        return edep;
+      }
+      return edep / (1. + edep / length * m_kB);
+    }
+
+    /// Corrected energies of the hits, in order
+    std::vector<double> energies(const edm4hep::SimCalorimeterHitCollection& hits,
+                                 const edm4hep::SimTrackerHitCollection& steps) const {
+      const size_t nhits = hits.size();
+      Jug::Base::FlatIndexMap hit_index(nhits);
+      for (size_t i = 0; i < nhits; ++i) {
+        hit_index.emplace(hits[i].getCellID(), static_cast<uint32_t>(i));
+      }
+      std::vector<double> total(nhits, 0.);
+      std::vector<double> visible(nhits, 0.);
+      for (const auto& step : steps) {
+        const uint32_t i = hit_index.find(step.getCellID());
+        if (i == Jug::Base::FlatIndexMap::kEmpty) {
+          continue;
+        }
+        const double edep = step.getEDep();
+        total[i] += edep;
+        visible[i] += corrected(edep, step.getPathLength(), step.getMCParticle().getCharge());
+      }
+      std::vector<double> energies(nhits);
+      for (size_t i = 0; i < nhits; ++i) {
+        const double e = hits[i].getEnergy();
+        energies[i]    = (total[i] > 0.) ? e * visible[i] / total[i] : e;
+      }
+      return energies;
+    }
+
+  private:
+    double m_kB;
+  };
+
+  /** Birks' law correction of the calorimeter hit energies.
+   *
+   *  Framework-independent, run in Gaudi with Jug::AlgorithmAdaptor. See CalorimeterBirksHitDigi
+   *  to correct the energies in the digitization, without the copy of the hits.
+   *
+   * \ingroup digi
+   * \ingroup calorimetry
+   */
+  class CalorimeterBirksCorr
+      : public Jug::Algorithm<Jug::Input<edm4hep::SimCalorimeterHitCollection, edm4hep::SimTrackerHitCollection>,
+                              Jug::Output<edm4hep::SimCalorimeterHitCollection>> {
+  public:
+    // digitization settings
+    Jug::Property<double> m_birksConstant{this, "birksConstant", 0.126 * Jug::Units::mm / Jug::Units::MeV};
+
+    CalorimeterBirksCorr(const std::string& name)
+        : Algorithm(name, {"inputHitCollection", "inputStepCollection"}, {"outputHitCollection"}) {}
+
+    bool initialize(const dd4hep::Detector* /* detector */) override {
+      // using juggler internal units (GeV, mm, radian, ns)
+      m_birks = BirksLaw(m_birksConstant.value() / Jug::Units::mm * Jug::Units::GeV);
+      return true;
+    }
+
+    Output execute(const Input& input, const Jug::AlgorithmContext& /* context */) const override {
+      const auto& [hits, steps] = input;
+      const auto energies       = m_birks.energies(hits, steps);
+
+      edm4hep::SimCalorimeterHitCollection ohits;
+      for (size_t i = 0; i < hits.size(); ++i) {
+        const auto& hit = hits[i];
+        auto ohit       = ohits.create();
+        ohit.setCellID(hit.getCellID());
+        ohit.setPosition(hit.getPosition());
+        // replace energy deposit with Birks Law corrected value
+        ohit.setEnergy(static_cast<float>(energies[i]));
+        for (const auto& c : hit.getContributions()) {
+          ohit.addToContributions(c);
+        }
+      }
+      return {std::move(ohits)};
+    }
+
+  private:
+    BirksLaw m_birks;
+  };
+
+} // namespace Jug::Digi
+
+#endif
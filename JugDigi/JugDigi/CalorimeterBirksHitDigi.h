@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGDIGI_CALORIMETERBIRKSHITDIGI_H
+#define JUGDIGI_CALORIMETERBIRKSHITDIGI_H
+
+#include "JugBase/Algorithm.h"
+#include "JugBase/Property.h"
+
+#include "JugDigi/CalorimeterBirksCorr.h"
+#include "JugDigi/CalorimeterHitDigi.h"
+
+namespace Jug::Digi {
+
+  /** Calorimeter hit digitization of the Birks' law corrected energies.
+   *
+   *  CalorimeterBirksCorr followed by CalorimeterHitDigi, without the corrected copy of the sim
+   *  hits: the corrected energies are given to the digitization directly. The properties are the
+   *  ones of CalorimeterHitDigi and birksConstant, the digitization (and its random numbers) is the
+   *  same as for the corrected hits. Framework-independent, run in Gaudi with Jug::AlgorithmAdaptor.
+   *
+   * \ingroup digi
+   * \ingroup calorimetry
+   */
+  class CalorimeterBirksHitDigi
+      : public Jug::Algorithm<Jug::Input<edm4hep::SimCalorimeterHitCollection, edm4hep::SimTrackerHitCollection>,
+                              Jug::Output<edm4hep::RawCalorimeterHitCollection>> {
+  public:
+    static constexpr bool usesRandom = true;
+
+    Jug::Property<double> m_birksConstant{this, "birksConstant", 0.126 * Jug::Units::mm / Jug::Units::MeV};
+
+    CalorimeterBirksHitDigi(const std::string& name)
+        : Algorithm(name, {"inputHitCollection", "inputStepCollection"}, {"outputHitCollection"}), m_digi(name) {
+      // the digitization settings are set on the digitization directly
+      for (const auto& [key, value] : m_digi.properties()) {
+        registerProperty(key, value);
+      }
+    }
+
+    bool initialize(const dd4hep::Detector* detector) override {
+      m_digi.setLogSink([this](LogLevel level, const std::string& msg) {
+        switch (level) {
+        case LogLevel::kDebug:
+          debug() << msg;
+          break;
+        case LogLevel::kInfo:
+          info() << msg;
+          break;
+        case LogLevel::kWarning:
+          warning() << msg;
+          break;
+        default:
+          error() << msg;
+          break;
+        }
+      });
+      m_digi.setLogLevel(msgLevel(LogLevel::kDebug) ? LogLevel::kDebug : LogLevel::kInfo);
+      // using juggler internal units (GeV, mm, radian, ns)
+      m_birks = BirksLaw(m_birksConstant.value() / Jug::Units::mm * Jug::Units::GeV);
+      return m_digi.initialize(detector);
+    }
+
+    Output execute(const Input& input, const Jug::AlgorithmContext& context) const override {
+      const auto& [hits, steps] = input;
+      return {m_digi.execute(hits, m_birks.energies(hits, steps), context.randomKey)};
+    }
+
+  private:
+    CalorimeterHitDigi m_digi;
+    BirksLaw m_birks;
+  };
+
+} // namespace Jug::Digi
+
+#endif
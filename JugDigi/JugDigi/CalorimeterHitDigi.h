@@ -0,0 +1,541 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Chao Peng, Wouter Deconinck, Sylvester Joosten
+
+// A general digitization for CalorimeterHit from simulation
+// 1. Smear energy deposit with a/sqrt(E/GeV) + b + c/E or a/sqrt(E/GeV) (relative value)
+// 2. Digitize the energy with dynamic ADC range and add pedestal (mean +- sigma)
+// 3. Time conversion with smearing resolution (absolute value)
+// 4. Signal is summed if the SumFields are provided
+// 5. Or, with waveforms(), the contributions are shaped and sampled at the ADC clock
+// 6. Noise hits above noiseThreshold are added in the channels without sim hits
+//
+// Author: Chao Peng
+// Date: 06/02/2021
+
+#ifndef JUGDIGI_CALORIMETERHITDIGI_H
+#define JUGDIGI_CALORIMETERHITDIGI_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "DD4hep/Detector.h"
+
+#include "JugBase/Algorithm.h"
+#include "JugBase/CalorimeterWaveforms.h"
+#include "JugBase/CellIDDecoder.h"
+#include "JugBase/Property.h"
+#include "JugBase/Utilities/KeyGroups.h"
+#include "JugBase/Utilities/Philox.h"
+#include "JugBase/Utilities/Units.h"
+
+#include "JugDigi/DenseChannels.h"
+
+#include "fmt/format.h"
+#include "fmt/ranges.h"
+
+// Event Model related classes
+#include "edm4hep/SimCalorimeterHitCollection.h"
+#include "edm4hep/RawCalorimeterHitCollection.h"
+
+namespace Jug::Digi {
+
+  /** Generic calorimeter hit digitiziation.
+   *
+   *  The Gaussian variates of an event are drawn into a buffer before the digitization, from the
+   *  given generator or, for reproducible events in any thread, from a counter-based generator
+   *  seeded per event (Jug::Base::Random::fill_normal). Framework-independent, run in Gaudi with
+   *  Jug::AlgorithmAdaptor, where the seed is the RandomSvc key of the event.
+   *
+   * \ingroup digi
+   * \ingroup calorimetry
+   */
+  class CalorimeterHitDigi : public Jug::Algorithm<Jug::Input<edm4hep::SimCalorimeterHitCollection>,
+                                                    Jug::Output<edm4hep::RawCalorimeterHitCollection>> {
+  public:
+    static constexpr bool usesRandom = true;
+
+    // additional smearing resolutions
+    Jug::Property<std::vector<double>> u_eRes{this, "energyResolutions", {}}; // a/sqrt(E/GeV) + b + c/(E/GeV)
+    Jug::Property<double>              m_tRes{this, "timeResolution", 0.0 * Jug::Units::ns};
+
+    // digitization settings
+    Jug::Property<unsigned int>       m_capADC{this, "capacityADC", 8096};
+    Jug::Property<double>             m_dyRangeADC{this, "dynamicRangeADC", 100 * Jug::Units::MeV};
+    Jug::Property<unsigned int>       m_pedMeanADC{this, "pedestalMean", 400};
+    Jug::Property<double>             m_pedSigmaADC{this, "pedestalSigma", 3.2};
+    Jug::Property<double>             m_resolutionTDC{this, "resolutionTDC", 0.010 * Jug::Units::ns};
+
+    Jug::Property<double>             m_corrMeanScale{this, "scaleResponse", 1.0};
+    // These are better variable names for the "energyResolutions" array which is a bit
+    // magic @FIXME
+    //Jug::Property<double>             m_corrSigmaCoeffE{this, "responseCorrectionSigmaCoeffE", 0.0};
+    //Jug::Property<double>             m_corrSigmaCoeffSqrtE{this, "responseCorrectionSigmaCoeffSqrtE", 0.0};
+
+    // signal sums
+    // signal sums with timing are made by waveforms()
+    // field names to generate id mask, the hits will be grouped by masking the field
+    Jug::Property<std::vector<std::string>> u_fields{this, "signalSumFields", {}};
+    // ref field ids are used for the merged hits, 0 is used if nothing provided
+    Jug::Property<std::vector<int>>         u_refs{this, "fieldRefNumbers", {}};
+    Jug::Property<std::string>              m_readout{this, "readoutClass", ""};
+
+    // noise hits of the channels without sim hits, the channels are all the values of the fields
+    // in [noiseFieldMin, noiseFieldMax] (the other fields 0), no noise hits without threshold
+    Jug::Property<std::vector<std::string>> u_noiseFields{this, "noiseFields", {}};
+    Jug::Property<std::vector<int>>         u_noiseMin{this, "noiseFieldMin", {}};
+    Jug::Property<std::vector<int>>         u_noiseMax{this, "noiseFieldMax", {}};
+    Jug::Property<double>                   m_noiseThreshold{this, "noiseThreshold", 0.}; // ADC above pedestal
+    Jug::Property<double>                   m_noiseTimeWindow{this, "noiseTimeWindow", 0. * Jug::Units::ns};
+
+    // unitless counterparts of inputs
+    double           dyRangeADC{0}, stepTDC{0}, tRes{0}, eRes[3] = {0., 0., 0.};
+    uint64_t         id_mask{0}, ref_mask{0};
+
+    CalorimeterHitDigi(const std::string& name)
+    : Algorithm(name, {"inputHitCollection"}, {"outputHitCollection"}) { }
+
+    bool initialize(const dd4hep::Detector* detector) override
+    {
+      // set energy resolution numbers
+      for (size_t i = 0; i < u_eRes.value().size() && i < 3; ++i) {
+        eRes[i] = u_eRes.value()[i];
+      }
+
+      // using juggler internal units (GeV, mm, radian, ns), from the units of the job options
+      dyRangeADC = m_dyRangeADC.value() / Jug::Units::GeV;
+      tRes       = m_tRes.value() / Jug::Units::ns;
+      stepTDC    = Jug::Units::ns / m_resolutionTDC.value();
+
+      if (!initialize_noise(detector)) {
+        return false;
+      }
+
+      // need signal sum
+      if (!u_fields.value().empty()) {
+        // sanity checks
+        if (!detector) {
+          error() << "Unable to locate Geometry Service. "
+                  << "Make sure you have GeoSvc and SimSvc in the right order in the configuration."
+                  << std::endl;;
+          return false;
+        }
+        if (m_readout.value().empty()) {
+          error() << "readoutClass is not provided, it is needed to know the fields in readout ids"
+                  << std::endl;;
+          return false;
+        }
+
+        // get decoders
+        try {
+          // compiled fields of the readout, shared with the other algorithms of the readout
+          const auto id_desc = Jug::Base::CellIDDecoder::readout(*detector, m_readout.value());
+          id_mask            = id_desc->mask(u_fields.value());
+          std::vector<std::pair<std::string, int>> ref_fields;
+          for (size_t i = 0; i < u_fields.value().size(); ++i) {
+            // use the provided id number to find ref cell, or use 0
+            int ref = i < u_refs.value().size() ? u_refs.value()[i] : 0;
+            ref_fields.emplace_back(u_fields.value()[i], ref);
+          }
+          ref_mask = id_desc->encode(ref_fields);
+          // debug() << fmt::format("Referece id mask for the fields {:#064b}", ref_mask) << std::endl;;
+        } catch (...) {
+          error() << "Failed to load ID decoder for " << m_readout.value() << std::endl;;
+          return false;
+        }
+        id_mask = ~id_mask;
+        info() << fmt::format("ID mask in {:s}: {:#064b}", m_readout.value(), id_mask) << std::endl;;
+        return true;
+      }
+
+      return true;
+    }
+
+    /// Gaussian variates per hit (energy resolution, pedestal, time) and per signal sum group
+    /// (the three energy resolution terms, pedestal, time), in fixed slots of the buffer
+    static constexpr size_t kSingleHitDraws = 3;
+    static constexpr size_t kSignalSumDraws = 5;
+
+    /// Digitize the event with the variates of its random key
+    Output execute(const Input& input, const Jug::AlgorithmContext& context) const override {
+      return {execute(std::get<0>(input), context.randomKey)};
+    }
+
+    /// Digitize with the variates of normdist, drawn into the buffer before the digitization
+    edm4hep::RawCalorimeterHitCollection
+    execute(
+        const edm4hep::SimCalorimeterHitCollection& input,
+        const std::function<double()> normdist
+    ) const {
+      auto draw = [&normdist](size_t n) {
+        std::vector<double> normals(n);
+        for (auto& z : normals) {
+          z = normdist();
+        }
+        return normals;
+      };
+      if (!u_fields.value().empty()) {
+        const auto groups = group_hits(input);
+        return collection(signal_sum_digi(input, groups, draw(groups.size() * kSignalSumDraws)));
+      } else {
+        return collection(single_hits_digi(input, draw(input.size() * kSingleHitDraws)));
+      }
+    }
+
+    /** Digitize with the counter-based variates of an event seed.
+     *
+     *  The variates of a hit depend on the seed, the stream and the position of the hit only,
+     *  so that the digitization of an event is reproducible whatever the thread or the order
+     *  of the events. The caller derives the seed from the event (e.g. run and event numbers)
+     *  and the stream from the detector.
+     */
+    edm4hep::RawCalorimeterHitCollection
+    execute(
+        const edm4hep::SimCalorimeterHitCollection& input,
+        uint64_t seed,
+        uint64_t stream = 0
+    ) const {
+      return collection(digitize(input, seed, stream));
+    }
+
+    /// Digitize with the energies of the hits replaced (e.g. corrected by CalorimeterBirksCorr), in order
+    edm4hep::RawCalorimeterHitCollection
+    execute(
+        const edm4hep::SimCalorimeterHitCollection& input,
+        const std::vector<double>& energies,
+        uint64_t seed,
+        uint64_t stream = 0
+    ) const {
+      return collection(digitize(input, seed, stream, &energies));
+    }
+
+    /// Digitized hits in flat arrays, the values of the RawCalorimeterHits
+    struct RawHits {
+      std::vector<uint64_t> cellID;
+      std::vector<int32_t>  amplitude;
+      std::vector<int32_t>  timeStamp;
+
+      size_t size() const { return cellID.size(); }
+      void reserve(size_t n) {
+        cellID.reserve(n);
+        amplitude.reserve(n);
+        timeStamp.reserve(n);
+      }
+      void push_back(uint64_t id, int32_t adc, int32_t tdc) {
+        cellID.push_back(id);
+        amplitude.push_back(adc);
+        timeStamp.push_back(tdc);
+      }
+    };
+
+    /// Digitize with the counter-based variates of an event seed, without making the collection
+    /// (e.g. for a reconstruction in the same algorithm)
+    RawHits
+    digitize(
+        const edm4hep::SimCalorimeterHitCollection& input,
+        uint64_t seed,
+        uint64_t stream = 0,
+        const std::vector<double>* energies = nullptr
+    ) const {
+      RawHits rawhits;
+      if (!u_fields.value().empty()) {
+        const auto groups = group_hits(input);
+        rawhits = signal_sum_digi(input, groups,
+                                  Jug::Base::Random::normal_buffer(seed, stream, groups.size() * kSignalSumDraws),
+                                  energies);
+      } else {
+        rawhits = single_hits_digi(input,
+                                   Jug::Base::Random::normal_buffer(seed, stream, input.size() * kSingleHitDraws),
+                                   energies);
+      }
+      if (!m_noiseChannels.empty()) {
+        add_noise(rawhits, seed, stream);
+      }
+      return rawhits;
+    }
+
+    static edm4hep::RawCalorimeterHitCollection collection(const RawHits& hits) {
+      edm4hep::RawCalorimeterHitCollection rawhits;
+      for (size_t i = 0; i < hits.size(); ++i) {
+        rawhits.push_back(edm4hep::RawCalorimeterHit(hits.cellID[i], hits.amplitude[i], hits.timeStamp[i]));
+      }
+      return rawhits;
+    }
+
+    /** Digitize into waveforms sampled at the ADC clock, with the variates of an event seed.
+     *
+     *  The channels are the cells, or the signal sum groups. Each contribution of a channel adds
+     *  the pulse shape, from the contribution time with its energy (in ADC counts of the energy
+     *  smeared with the resolution of the channel) as peak, to the channel waveform of nSamples
+     *  from startTime (ns). The pedestal with its noise is then added to every sample, and the
+     *  samples are limited to the ADC range, in one pass over the waveforms of all the channels.
+     */
+    Jug::Base::CalorimeterWaveforms
+    waveforms(
+        const edm4hep::SimCalorimeterHitCollection& input,
+        const Jug::Base::PulseShape& shape,
+        size_t nSamples,
+        double startTime,
+        uint64_t seed,
+        uint64_t stream = 0,
+        const std::vector<double>* energies = nullptr
+    ) const {
+      std::vector<uint64_t> ids(input.size());
+      for (size_t i = 0; i < input.size(); ++i) {
+        ids[i] = u_fields.value().empty() ? input[i].getCellID() : (input[i].getCellID() & id_mask) | ref_mask;
+      }
+      const auto groups   = Jug::Base::group_by_key(std::move(ids));
+      const size_t nchan  = groups.size();
+      const size_t nvalue = nchan * nSamples;
+      // the resolution variate of each channel, then the noise of each sample
+      const auto normals = Jug::Base::Random::normal_buffer(seed, stream, nchan + nvalue);
+
+      Jug::Base::CalorimeterWaveforms waves;
+      waves.nSamples       = nSamples;
+      waves.samplingPeriod = shape.samplingPeriod();
+      waves.startTime      = startTime;
+      waves.cellID.reserve(nchan);
+
+      std::vector<float> signal(nvalue, 0.F);
+      const double adcScale = m_corrMeanScale.value() / dyRangeADC * m_capADC.value();
+      for (size_t igroup = 0; igroup < nchan; ++igroup) {
+        waves.cellID.push_back(groups.key(igroup));
+        double edep = 0.;
+        for (uint32_t j = groups.begin[igroup]; j < groups.begin[igroup + 1]; ++j) {
+          edep += energies ? (*energies)[groups.index[j]] : input[groups.index[j]].getEnergy();
+        }
+        const double z       = normals[igroup];
+        const double eResRel = (edep > 1e-6)
+                                   ? z * std::sqrt(std::pow(eRes[0] / std::sqrt(edep), 2) + std::pow(eRes[1], 2) +
+                                                   std::pow(eRes[2] / edep, 2))
+                                   : 0;
+        const double scale = (1. + eResRel) * adcScale;
+        float* out         = signal.data() + igroup * nSamples;
+        for (uint32_t j = groups.begin[igroup]; j < groups.begin[igroup + 1]; ++j) {
+          const auto hit = input[groups.index[j]];
+          // the contributions carry the simulated energy, scaled to the replaced one
+          double f = scale;
+          if (energies) {
+            f = (hit.getEnergy() > 0.) ? f * (*energies)[groups.index[j]] / hit.getEnergy() : 0.;
+          }
+          for (const auto& c : hit.getContributions()) {
+            shape.add(out, nSamples, startTime, c.getTime(), static_cast<float>(c.getEnergy() * f));
+          }
+        }
+      }
+
+      const double pedMean  = m_pedMeanADC.value();
+      const double pedSigma = m_pedSigmaADC.value();
+      const double capADC   = m_capADC.value();
+      const double* noise   = normals.data() + nchan;
+      waves.samples.resize(nvalue);
+      for (size_t j = 0; j < nvalue; ++j) {
+        const double adc = std::floor(pedMean + noise[j] * pedSigma + signal[j] + 0.5);
+        waves.samples[j] = static_cast<int32_t>(std::clamp(adc, 0., capADC));
+      }
+      return waves;
+    }
+
+  private:
+    // noise channels, in the ranges of the noise fields
+    DenseChannels m_noiseChannels;
+    double        m_noiseProb{0.};
+
+    bool initialize_noise(const dd4hep::Detector* detector) {
+      if (m_noiseThreshold.value() <= 0. || u_noiseFields.value().empty()) {
+        return true;
+      }
+      if (!detector || m_readout.value().empty()) {
+        error() << "readoutClass and the geometry are needed for the noise channels" << std::endl;
+        return false;
+      }
+      if (m_pedSigmaADC.value() <= 0.) {
+        error() << "noiseThreshold needs a positive pedestalSigma" << std::endl;
+        return false;
+      }
+      try {
+        const auto id_desc = Jug::Base::CellIDDecoder::readout(*detector, m_readout.value());
+        m_noiseChannels.setup(*id_desc, u_noiseFields.value(), u_noiseMin.value(), u_noiseMax.value());
+      } catch (const std::exception& e) {
+        error() << "Failed to set up the noise channels of " << m_readout.value() << ": " << e.what() << std::endl;
+        return false;
+      }
+      // Gaussian tail above the threshold
+      m_noiseProb = 0.5 * std::erfc(m_noiseThreshold.value() / m_pedSigmaADC.value() / std::sqrt(2.));
+      info() << fmt::format("Noise hits in {} channels with probability {:g}", m_noiseChannels.size(), m_noiseProb)
+             << std::endl;
+      return true;
+    }
+
+    /** Noise hits of the channels without sim hits, appended to rawhits.
+     *
+     *  The channels with pedestal noise above the threshold are a Bernoulli process over the
+     *  channel index, placed by geometric skips between them (so that the number of noise hits per
+     *  event follows the binomial tail count) in one pass whose cost is that of the noise hits, and
+     *  their amplitudes are drawn from the Gaussian tail above the threshold. The random numbers
+     *  are a counter-based stream of the event seed and stream, separate from those of the hits.
+     */
+    void add_noise(RawHits& rawhits, uint64_t seed, uint64_t stream) const {
+      if (m_noiseProb <= 0.) {
+        return;
+      }
+      std::vector<uint64_t> signal(rawhits.cellID);
+      std::sort(signal.begin(), signal.end());
+      Jug::Base::Random::Stream rng(seed, Jug::Base::Random::mix64(stream ^ kNoiseStream));
+
+      const double logq     = std::log1p(-m_noiseProb);
+      const double tail     = m_noiseThreshold.value() / m_pedSigmaADC.value();
+      const double pedMean  = m_pedMeanADC.value();
+      const double pedSigma = m_pedSigmaADC.value();
+      const double window   = m_noiseTimeWindow.value() / Jug::Units::ns;
+      const auto capADC     = static_cast<long long>(m_capADC.value());
+      for (uint64_t index = m_noiseChannels.next(0, rng.uniform(), logq); index < m_noiseChannels.size();
+           index = m_noiseChannels.next(index + 1, rng.uniform(), logq)) {
+        uint64_t id = m_noiseChannels.cellID(index);
+        if (!u_fields.value().empty()) {
+          id = (id & id_mask) | ref_mask;
+        }
+        if (std::binary_search(signal.begin(), signal.end(), id)) {
+          continue;
+        }
+        // Marsaglia's sampling of the normal tail above the threshold
+        double z = 0.;
+        do {
+          z = std::sqrt(tail * tail - 2. * std::log(rng.uniform()));
+        } while (rng.uniform() * z > tail);
+        const long long adc = std::llround(pedMean + z * pedSigma);
+        const long long tdc = std::llround(rng.uniform() * window * stepTDC);
+        rawhits.push_back(id, static_cast<int32_t>(std::min(adc, capADC)), static_cast<int32_t>(tdc));
+      }
+    }
+
+    static constexpr uint64_t kNoiseStream = Jug::Base::Random::hash_name("noise");
+
+    RawHits
+    single_hits_digi(
+        const edm4hep::SimCalorimeterHitCollection& simhits,
+        const std::vector<double>& normals,
+        const std::vector<double>* energies = nullptr
+    ) const {
+      RawHits rawhits;
+
+      // inputs of the digitization, then one pass without branches on the random numbers
+      const size_t nhits = simhits.size();
+      std::vector<double> eDep(nhits);
+      std::vector<double> time(nhits);
+      for (size_t i = 0; i < nhits; ++i) {
+        const auto& ahit = simhits[i];
+        // Note: juggler internal unit of energy is GeV
+        eDep[i] = energies ? (*energies)[i] : ahit.getEnergy();
+        time[i] = std::numeric_limits<double>::max();
+        for (const auto& c : ahit.getContributions()) {
+          if (c.getTime() <= time[i]) {
+            time[i] = c.getTime();
+          }
+        }
+      }
+
+      std::vector<long long> adc(nhits);
+      std::vector<long long> tdc(nhits);
+      const double pedMean  = m_pedMeanADC.value();
+      const double pedSigma = m_pedSigmaADC.value();
+      const double adcScale = m_corrMeanScale.value() / dyRangeADC * m_capADC.value();
+      for (size_t i = 0; i < nhits; ++i) {
+        const double* z = &normals[i * kSingleHitDraws];
+        const double e  = eDep[i];
+        // apply additional calorimeter noise to corrected energy deposit
+        const double eResRel = (e > 1e-6)
+                                   ? z[0] * std::sqrt(std::pow(eRes[0] / std::sqrt(e), 2) + std::pow(eRes[1], 2) +
+                                                      std::pow(eRes[2] / e, 2))
+                                   : 0;
+        const double ped = pedMean + z[1] * pedSigma;
+        adc[i]           = std::llround(ped + e * (1. + eResRel) * adcScale);
+        tdc[i]           = std::llround((time[i] + z[2] * tRes) * stepTDC);
+      }
+
+      rawhits.reserve(nhits);
+      for (size_t i = 0; i < nhits; ++i) {
+        rawhits.push_back(
+          simhits[i].getCellID(),
+          static_cast<int32_t>(adc[i] > m_capADC.value() ? m_capADC.value() : adc[i]),
+          static_cast<int32_t>(tdc[i])
+        );
+      }
+
+      return rawhits;
+    }
+
+    // group the hits by masked cell id (for merging), in flat arrays sorted by id
+    Jug::Base::KeyGroups group_hits(const edm4hep::SimCalorimeterHitCollection& simhits) const {
+      std::vector<uint64_t> ids(simhits.size());
+      for (size_t i = 0; i < simhits.size(); ++i) {
+        ids[i] = (simhits[i].getCellID() & id_mask) | ref_mask;
+      }
+      return Jug::Base::group_by_key(std::move(ids));
+    }
+
+    RawHits
+    signal_sum_digi(
+        const edm4hep::SimCalorimeterHitCollection& simhits,
+        const Jug::Base::KeyGroups& groups,
+        const std::vector<double>& normals,
+        const std::vector<double>* energies = nullptr
+    ) const {
+      auto energy = [&simhits, energies](uint32_t i) -> double {
+        return energies ? (*energies)[i] : simhits[i].getEnergy();
+      };
+      RawHits rawhits;
+      rawhits.reserve(groups.size());
+
+      // signal sum, in one pass over the hits of each group
+      for (size_t igroup = 0; igroup < groups.size(); ++igroup) {
+        const uint64_t id     = groups.key(igroup);
+        const double* z       = &normals[igroup * kSignalSumDraws];
+        const uint32_t ifirst = groups.index[groups.begin[igroup]];
+        double edep           = energy(ifirst);
+        double time           = simhits[ifirst].getContributions(0).getTime();
+        double max_edep       = edep;
+        // sum energy, take time from the most energetic hit
+        for (uint32_t i = groups.begin[igroup] + 1; i < groups.begin[igroup + 1]; ++i) {
+          const auto hit = simhits[groups.index[i]];
+          const double e = energy(groups.index[i]);
+          edep += e;
+          if (e > max_edep) {
+            max_edep = e;
+            for (const auto& c : hit.getContributions()) {
+              if (c.getTime() <= time) {
+                time = c.getTime();
+              }
+            }
+          }
+        }
+
+        double eResRel = 0.;
+        // safety check
+        if (edep > 1e-6) {
+            eResRel = z[0] * eRes[0] / std::sqrt(edep) +
+                      z[1] * eRes[1] +
+                      z[2] * eRes[2] / edep;
+        }
+        double    ped     = m_pedMeanADC.value() + z[3] * m_pedSigmaADC.value();
+        unsigned long long adc     = std::llround(ped + edep * (1. + eResRel) / dyRangeADC * m_capADC.value());
+        unsigned long long tdc     = std::llround((time + z[4] * tRes) * stepTDC);
+
+        rawhits.push_back(
+          id,
+          static_cast<int32_t>(adc > m_capADC.value() ? m_capADC.value() : adc),
+          static_cast<int32_t>(tdc)
+        );
+      }
+
+      return rawhits;
+    }
+  };
+
+} // namespace Jug::Digi
+
+#endif
@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGDIGI_CALORIMETERWAVEFORMDIGI_H
+#define JUGDIGI_CALORIMETERWAVEFORMDIGI_H
+
+#include "JugBase/Algorithm.h"
+#include "JugBase/CalorimeterWaveforms.h"
+#include "JugBase/Property.h"
+#include "JugBase/Utilities/Units.h"
+
+#include "JugDigi/CalorimeterHitDigi.h"
+
+namespace Jug::Digi {
+
+  /** Calorimeter waveform digitization.
+   *
+   *  The hits of each cell (or signal sum group) are shaped and sampled at the ADC clock, see
+   *  CalorimeterHitDigi::waveforms(), for pile-up and streaming readout studies. The properties
+   *  are the ones of CalorimeterHitDigi and the waveform settings, the pulse shape is tabulated
+   *  once in initialize. Framework-independent, run in Gaudi with Jug::AlgorithmAdaptor.
+   *
+   * \ingroup digi
+   * \ingroup calorimetry
+   */
+  class CalorimeterWaveformDigi
+      : public Jug::Algorithm<Jug::Input<edm4hep::SimCalorimeterHitCollection>,
+                              Jug::Output<Jug::Base::CalorimeterWaveforms>> {
+  public:
+    static constexpr bool usesRandom = true;
+
+    Jug::Property<std::string> m_pulseShape{this, "pulseShape", "crrc"}; // crrc or gaussian
+    Jug::Property<double> m_shapingTime{this, "pulseShapingTime", 10. * Jug::Units::ns};
+    Jug::Property<unsigned int> m_pulseOrder{this, "pulseOrder", 4}; // n of CR-RC^n
+    Jug::Property<double> m_samplingPeriod{this, "samplingPeriod", 4. * Jug::Units::ns};
+    Jug::Property<unsigned int> m_nSamples{this, "nSamples", 32};
+    Jug::Property<double> m_startTime{this, "waveformStart", -16. * Jug::Units::ns};
+    Jug::Property<unsigned int> m_oversampling{this, "lutOversampling", 32}; // phases per sampling period
+
+    CalorimeterWaveformDigi(const std::string& name)
+        : Algorithm(name, {"inputHitCollection"}, {"outputWaveforms"}), m_digi(name) {
+      // the digitization settings are set on the digitization directly
+      for (const auto& [key, value] : m_digi.properties()) {
+        registerProperty(key, value);
+      }
+    }
+
+    bool initialize(const dd4hep::Detector* detector) override {
+      m_digi.setLogSink([this](LogLevel level, const std::string& msg) {
+        switch (level) {
+        case LogLevel::kDebug:
+          debug() << msg;
+          break;
+        case LogLevel::kInfo:
+          info() << msg;
+          break;
+        case LogLevel::kWarning:
+          warning() << msg;
+          break;
+        default:
+          error() << msg;
+          break;
+        }
+      });
+      m_digi.setLogLevel(msgLevel(LogLevel::kDebug) ? LogLevel::kDebug : LogLevel::kInfo);
+      if (m_nSamples.value() == 0) {
+        error() << "nSamples must be positive" << std::endl;
+        return false;
+      }
+      // using juggler internal units (GeV, mm, radian, ns)
+      m_shape = Jug::Base::PulseShape(m_pulseShape.value(), m_shapingTime.value() / Jug::Units::ns,
+                                      m_pulseOrder.value(), m_samplingPeriod.value() / Jug::Units::ns,
+                                      m_oversampling.value(),
+                                      m_nSamples.value());
+      if (!m_shape.valid()) {
+        error() << "Invalid pulse shape " << m_pulseShape.value() << " (crrc or gaussian, with positive "
+                << "pulseShapingTime, samplingPeriod and lutOversampling)" << std::endl;
+        return false;
+      }
+      debug() << "Pulse shape " << m_pulseShape.value() << " over " << m_shape.length() << " samples, peak at "
+              << m_shape.peakTime() << " ns" << std::endl;
+      return m_digi.initialize(detector);
+    }
+
+    Output execute(const Input& input, const Jug::AlgorithmContext& context) const override {
+      return {m_digi.waveforms(std::get<0>(input), m_shape, m_nSamples.value(), m_startTime.value() / Jug::Units::ns,
+                               context.randomKey)};
+    }
+
+  private:
+    CalorimeterHitDigi m_digi;
+    Jug::Base::PulseShape m_shape;
+  };
+
+} // namespace Jug::Digi
+
+#endif
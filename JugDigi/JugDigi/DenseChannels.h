@@ -0,0 +1,98 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGDIGI_DENSECHANNELS_H
+#define JUGDIGI_DENSECHANNELS_H
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "JugBase/CellIDDecoder.h"
+
+namespace Jug::Digi {
+
+  /** Dense index of the readout channels in ranges of cellID fields.
+   *
+   *  The channels are all the values of the fields in [min, max], with the other fields 0, and
+   *  the index has the first field as the fastest digit. DD4hep has no enumeration of the cells
+   *  of a readout, this gives the digitizations one for the channels without sim hits (noise,
+   *  dark counts), drawn by skips over the index.
+   */
+  class DenseChannels {
+  public:
+    /// Throws std::out_of_range for unknown fields, std::invalid_argument for invalid ranges
+    void setup(const Jug::Base::CellIDDecoder& decoder, const std::vector<std::string>& fields,
+               const std::vector<int>& min, const std::vector<int>& max) {
+      if (min.size() != fields.size() || max.size() != fields.size()) {
+        throw std::invalid_argument("one min and max value per field needed");
+      }
+      m_fields.clear();
+      m_min.clear();
+      m_size.clear();
+      m_mask     = 0;
+      m_channels = fields.empty() ? 0 : 1;
+      for (size_t i = 0; i < fields.size(); ++i) {
+        if (max[i] < min[i]) {
+          throw std::invalid_argument("empty range of field " + fields[i]);
+        }
+        m_fields.push_back(decoder.field(fields[i]));
+        m_min.push_back(min[i]);
+        m_size.push_back(static_cast<uint64_t>(max[i] - min[i]) + 1);
+        m_mask |= m_fields.back().mask;
+        m_channels *= m_size.back();
+      }
+    }
+
+    /// Number of channels
+    uint64_t size() const { return m_channels; }
+    bool empty() const { return m_channels == 0; }
+
+    uint64_t cellID(uint64_t index) const {
+      uint64_t id = 0;
+      for (size_t f = 0; f < m_fields.size(); ++f) {
+        id |= m_fields[f].encode(m_min[f] + static_cast<int64_t>(index % m_size[f]));
+        index /= m_size[f];
+      }
+      return id;
+    }
+
+    /// Index of a cellID, size() if it is not one of the channels
+    uint64_t index(uint64_t cellID) const {
+      if ((cellID & ~m_mask) != 0) {
+        return m_channels;
+      }
+      uint64_t index = 0;
+      for (size_t f = m_fields.size(); f-- > 0;) {
+        const int64_t digit = m_fields[f].value(cellID) - m_min[f];
+        if (digit < 0 || static_cast<uint64_t>(digit) >= m_size[f]) {
+          return m_channels;
+        }
+        index = index * m_size[f] + static_cast<uint64_t>(digit);
+      }
+      return index;
+    }
+
+    /** Next channel of a Bernoulli process of probability p over the index, at or after index.
+     *
+     *  The gap is geometric, drawn from the uniform u in (0, 1) with logq = log(1 - p), so that
+     *  the channels of a process are drawn in a cost of their number. size() after the last one.
+     */
+    uint64_t next(uint64_t index, double u, double logq) const {
+      const double skip = std::floor(std::log(u) / logq);
+      return (skip >= static_cast<double>(m_channels - index)) ? m_channels : index + static_cast<uint64_t>(skip);
+    }
+
+  private:
+    std::vector<Jug::Base::CellIDField> m_fields;
+    std::vector<int64_t> m_min;
+    std::vector<uint64_t> m_size;
+    uint64_t m_mask{0};
+    uint64_t m_channels{0};
+  };
+
+} // namespace Jug::Digi
+
+#endif
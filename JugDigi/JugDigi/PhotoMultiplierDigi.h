@@ -0,0 +1,450 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Chao Peng
+
+/*  General PhotoMultiplier Digitization
+ *
+ *  Apply the given quantum efficiency for photon detection
+ *  Add the optical cross-talk and the dark counts (optional)
+ *  Converts the number of detected photons to signal amplitude
+ *
+ *  Author: Chao Peng (ANL)
+ *  Date: 10/02/2020
+ */
+
+#ifndef JUGDIGI_PHOTOMULTIPLIERDIGI_H
+#define JUGDIGI_PHOTOMULTIPLIERDIGI_H
+
+#include <iterator>
+#include <algorithm>
+#include <sstream>
+#include <unordered_map>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "JugBase/Algorithm.h"
+#include "JugBase/Property.h"
+#include "JugBase/Utilities/Dispatch.h"
+#include "JugBase/Utilities/Philox.h"
+#include "JugBase/Utilities/Units.h"
+
+#include "JugDigi/DenseChannels.h"
+
+// Event Model related classes
+#include "eicd/RawPMTHitCollection.h"
+#include "edm4hep/MCParticleCollection.h"
+#include "edm4hep/SimTrackerHitCollection.h"
+
+
+namespace Jug::Digi {
+
+// quantum efficiency of n photons from the linear interpolation of a table, branchless so that the
+// loop is vectorized (the table lookups are gathers)
+JUG_KERNEL_BODY void qe_pass_all_body(const double* __restrict table, double emin, double emax, double inv,
+                                      double xmax, const double* __restrict ev, const double* __restrict rand,
+                                      uint8_t* __restrict pass, size_t n)
+{
+    for (size_t k = 0; k < n; ++k) {
+        // clamped with selects (no branches, a NaN goes to 0), the energies out of range do not pass
+        const double e = ev[k];
+        double x = (e - emin)*inv;
+        x = x > 0. ? x : 0.;
+        x = x < xmax ? x : xmax;
+        const int i = static_cast<int>(x);
+        const double prob = table[i] + (x - i)*(table[i + 1] - table[i]);
+        pass[k] = static_cast<uint8_t>((e >= emin) & (e <= emax) & (rand[k] <= prob));
+    }
+}
+JUG_DISPATCH_KERNEL(qe_pass_all,
+                    (const double* __restrict table, double emin, double emax, double inv, double xmax,
+                     const double* __restrict ev, const double* __restrict rand, uint8_t* __restrict pass,
+                     size_t n),
+                    (table, emin, emax, inv, xmax, ev, rand, pass, n))
+
+/** PhotoMultiplierDigi.
+ *
+ *  The quantum efficiency and the amplitudes are drawn from the random stream of each cell in
+ *  the event, reproducible whatever the order of the events and the threads. Framework-
+ *  independent, run in Gaudi with Jug::AlgorithmAdaptor.
+ *
+ *  With crossTalkProbability, every detected photon fires each neighbour of its pixel with that
+ *  probability, from a neighbour table of the pixels (pixelFields ranges of readoutClass) made
+ *  once at initialize with the lookup of setNeighbourLookup (the cell neighbour service in
+ *  Gaudi). With darkCountRate, the pixels with a dark count in darkCountWindow are drawn by skips
+ *  over the pixel index, so their cost is that of the dark counts. Both are added to the detected
+ *  photons before the sorted grouping, which is then used whatever sortedGrouping is.
+ *
+ * \ingroup digi
+ */
+class PhotoMultiplierDigi : public Jug::Algorithm<Jug::Input<edm4hep::SimTrackerHitCollection>,
+                                                  Jug::Output<eicd::RawPMTHitCollection>>
+{
+public:
+    static constexpr bool usesRandom = true;
+
+    Jug::Property<std::vector<std::pair<double, double>>>
+        u_quantumEfficiency{this, "quantumEfficiency", {{2.6*Jug::Units::eV, 0.3}, {7.0*Jug::Units::eV, 0.3}}};
+    Jug::Property<double> m_hitTimeWindow{this, "hitTimeWindow", 20.0*Jug::Units::ns};
+    Jug::Property<double> m_timeStep{this, "timeStep", 0.0625*Jug::Units::ns};
+    Jug::Property<double> m_speMean{this, "speMean", 80.0};
+    Jug::Property<double> m_speError{this, "speError", 16.0};
+    Jug::Property<double> m_pedMean{this, "pedMean", 200.0};
+    Jug::Property<double> m_pedError{this, "pedError", 3.0};
+    // evaluate the quantum efficiency of the photons of the event together, and group the photons
+    // of a cell in a single sweep after sorting them by (cellID, time), instead of searching the
+    // groups of the cell for every photon (in the order of the input)
+    Jug::Property<bool> m_sortedGrouping{this, "sortedGrouping", false};
+    // number of uniform energy bins of the quantum efficiency lookup table
+    Jug::Property<int> m_qeBins{this, "quantumEfficiencyBins", 4096};
+    // pixels of the cross-talk and dark counts: all the values of the fields in [min, max], the
+    // other fields of readoutClass 0
+    Jug::Property<std::string> m_readout{this, "readoutClass", ""};
+    Jug::Property<std::vector<std::string>> u_pixelFields{this, "pixelFields", {}};
+    Jug::Property<std::vector<int>> u_pixelMin{this, "pixelFieldMin", {}};
+    Jug::Property<std::vector<int>> u_pixelMax{this, "pixelFieldMax", {}};
+    // probability of each neighbour pixel to fire for a detected photon
+    Jug::Property<double> m_crossTalkProb{this, "crossTalkProbability", 0.0};
+    // dark count rate of a pixel, at most one dark count per pixel in the window from time 0
+    Jug::Property<double> m_darkCountRate{this, "darkCountRate", 0.0/Jug::Units::ns};
+    Jug::Property<double> m_darkCountWindow{this, "darkCountWindow", 20.0*Jug::Units::ns};
+
+    /// Neighbour cellIDs of a cellID, sorted
+    using NeighbourLookup = std::function<const std::vector<uint64_t>&(uint64_t)>;
+
+    // constructor
+    PhotoMultiplierDigi(const std::string& name)
+        : Algorithm(name, {"inputHitCollection"}, {"outputHitCollection"})
+    {
+    }
+
+    /// Neighbours of the pixels for the cross-talk, only used in initialize
+    void setNeighbourLookup(NeighbourLookup lookup) { m_neighbourLookup = std::move(lookup); }
+
+    bool initialize(const dd4hep::Detector* detector) override
+    {
+        qe_init();
+        qe_table();
+        return pixels_init(detector);
+    }
+
+    Output execute(const Input& input, const Jug::AlgorithmContext& context) const override
+    {
+        // input collection
+        const auto &sim = std::get<0>(input);
+        // Create output collections
+        eicd::RawPMTHitCollection raw;
+        if (m_sortedGrouping || !m_pixels.empty()) {
+            sorted_digi(sim, context, raw);
+            return {std::move(raw)};
+        }
+
+        struct HitData { int npe; double signal; double time; };
+        std::unordered_map<uint64_t, std::vector<HitData>> hit_groups;
+        // one stream per cell, for the draws of its photon hits in order
+        std::unordered_map<uint64_t, Jug::Base::Random::Stream> cell_streams;
+        // collect the photon hit in the same cell
+        // calculate signal
+        for(const auto& ahit : sim) {
+            uint64_t id = ahit.getCellID();
+            auto& stream = cell_streams.try_emplace(id, context.randomKey, id).first->second;
+
+            // quantum efficiency
+            if (!qe_pass(ahit.getEDep(), stream.uniform())) {
+                continue;
+            }
+            // cell id, time, signal amplitude
+            double time = ahit.getMCParticle().getTime();
+            double amp = m_speMean + stream.normal()*m_speError;
+
+            // group hits
+            auto it = hit_groups.find(id);
+            if (it != hit_groups.end()) {
+                size_t i = 0;
+                for (auto git = it->second.begin(); git != it->second.end(); ++git, ++i) {
+                    if (std::abs(time - git->time) <= (m_hitTimeWindow/Jug::Units::ns)) {
+                        git->npe += 1;
+                        git->signal += amp;
+                        break;
+                    }
+                }
+                // no hits group found
+                if (i >= it->second.size()) {
+                    it->second.emplace_back(HitData{1, amp + m_pedMean + m_pedError*stream.normal(), time});
+                }
+            } else {
+                hit_groups[id] = {HitData{1, amp + m_pedMean + m_pedError*stream.normal(), time}};
+            }
+        }
+
+        // build hit
+        for (auto &it : hit_groups) {
+            for (auto &data : it.second) {
+                eicd::RawPMTHit hit{
+                  it.first,
+                  static_cast<uint32_t>(data.signal), 
+                  static_cast<uint32_t>(data.time/(m_timeStep/Jug::Units::ns))};
+                raw.push_back(hit);
+            }
+        }
+
+        return {std::move(raw)};
+    }
+
+private:
+    void qe_init()
+    {
+        auto &qeff = u_quantumEfficiency.value();
+        auto print = [&qeff]() {
+            std::ostringstream os;
+            for (const auto& [e, q] : qeff) {
+                os << "(" << e << ", " << q << ") ";
+            }
+            return os.str();
+        };
+
+        // sort quantum efficiency data first
+        std::sort(qeff.begin(), qeff.end(),
+            [] (const std::pair<double, double> &v1, const std::pair<double, double> &v2) {
+                return v1.first < v2.first;
+            });
+
+        // sanity checks
+        if (qeff.empty()) {
+            qeff = {{2.6*Jug::Units::eV, 0.3}, {7.0*Jug::Units::eV, 0.3}};
+            warning() << "Invalid quantum efficiency data provided, using default values: " << print() << std::endl;
+        }
+        if (qeff.front().first > 3.0*Jug::Units::eV) {
+            warning() << "Quantum efficiency data start from " << qeff.front().first/Jug::Units::eV
+                      << " eV, maybe you are using wrong units?" << std::endl;
+        }
+        if (qeff.back().first < 6.0*Jug::Units::eV) {
+            warning() << "Quantum efficiency data end at " << qeff.back().first/Jug::Units::eV
+                      << " eV, maybe you are using wrong units?" << std::endl;
+        }
+    }
+
+    // the quantum efficiency of all the photons is evaluated together, on a buffer of uniforms of
+    // the event, then the detected photons are sorted by (cellID, time) once and grouped in a
+    // single sweep: a hit starts at the earliest photon of a cell not in the previous hit, and
+    // takes the photons within hitTimeWindow of it; the amplitudes of a cell are drawn in the
+    // time order of its photons
+    void sorted_digi(const edm4hep::SimTrackerHitCollection& sim, const Jug::AlgorithmContext& context,
+                     eicd::RawPMTHitCollection& raw) const
+    {
+        const size_t n = sim.size();
+        std::vector<double> ev(n);
+        std::vector<double> rand(n);
+        std::vector<uint8_t> pass(n);
+        for (size_t i = 0; i < n; ++i) {
+            ev[i] = sim[i].getEDep();
+        }
+        // uniform i is the one of the i-th photon, with a key of its own so that it is independent
+        // of the streams of the cells
+        Jug::Base::Random::fill_uniform(Jug::Base::Random::mix64(context.randomKey ^ kQEStream), 0, rand.data(), n);
+        qe_pass(ev.data(), rand.data(), pass.data(), n);
+
+        std::vector<Photon> photons;
+        photons.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            if (pass[i] != 0) {
+                photons.push_back({sim[i].getCellID(), sim[i].getMCParticle().getTime()});
+            }
+        }
+        if (!m_crossTalkCells.empty()) {
+            cross_talk(photons, context.randomKey);
+        }
+        if (m_darkProb > 0.) {
+            dark_counts(photons, context.randomKey);
+        }
+        std::stable_sort(photons.begin(), photons.end(), [] (const Photon& p1, const Photon& p2) {
+            return p1.id < p2.id || (p1.id == p2.id && p1.time < p2.time);
+        });
+
+        const double window = m_hitTimeWindow/Jug::Units::ns;
+        const double step = m_timeStep/Jug::Units::ns;
+        for (size_t begin = 0; begin < photons.size();) {
+            const uint64_t id = photons[begin].id;
+            Jug::Base::Random::Stream stream(context.randomKey, id);
+            double start = photons[begin].time;
+            double signal = m_pedMean + m_pedError*stream.normal();
+            size_t i = begin;
+            for (; i < photons.size() && photons[i].id == id; ++i) {
+                if (photons[i].time - start > window) {
+                    raw.push_back(eicd::RawPMTHit{id, static_cast<uint32_t>(signal), static_cast<uint32_t>(start/step)});
+                    start = photons[i].time;
+                    signal = m_pedMean + m_pedError*stream.normal();
+                }
+                signal += m_speMean + stream.normal()*m_speError;
+            }
+            raw.push_back(eicd::RawPMTHit{id, static_cast<uint32_t>(signal), static_cast<uint32_t>(start/step)});
+            begin = i;
+        }
+    }
+
+    bool pixels_init(const dd4hep::Detector* detector)
+    {
+        if (m_crossTalkProb <= 0. && m_darkCountRate <= 0.) {
+            return true;
+        }
+        if (!detector || m_readout.value().empty() || u_pixelFields.value().empty()) {
+            error() << "readoutClass, pixelFields and the geometry are needed for the cross-talk and dark counts"
+                    << std::endl;
+            return false;
+        }
+        try {
+            const auto id_desc = Jug::Base::CellIDDecoder::readout(*detector, m_readout.value());
+            m_pixels.setup(*id_desc, u_pixelFields.value(), u_pixelMin.value(), u_pixelMax.value());
+        } catch (const std::exception& e) {
+            error() << "Failed to set up the pixels of " << m_readout.value() << ": " << e.what() << std::endl;
+            return false;
+        }
+
+        if (m_crossTalkProb > 0.) {
+            if (!m_neighbourLookup) {
+                error() << "crossTalkProbability needs the neighbours of the pixels (cell neighbour service)"
+                        << std::endl;
+                return false;
+            }
+            // neighbour cellIDs of pixel p: m_crossTalkCells[m_crossTalkBegin[p] ... m_crossTalkBegin[p + 1] - 1]
+            m_crossTalkBegin.assign(1, 0);
+            m_crossTalkCells.clear();
+            for (uint64_t p = 0; p < m_pixels.size(); ++p) {
+                const auto& nbs = m_neighbourLookup(m_pixels.cellID(p));
+                m_crossTalkCells.insert(m_crossTalkCells.end(), nbs.begin(), nbs.end());
+                m_crossTalkBegin.push_back(static_cast<uint32_t>(m_crossTalkCells.size()));
+            }
+            m_neighbourLookup = nullptr;
+            info() << "Cross-talk neighbour table of " << m_pixels.size() << " pixels, "
+                   << m_crossTalkCells.size() << " neighbours" << std::endl;
+        }
+        if (m_darkCountRate > 0.) {
+            m_darkProb = -std::expm1(-m_darkCountRate*m_darkCountWindow);
+            info() << "Dark count probability per pixel " << m_darkProb << std::endl;
+        }
+        if (!m_sortedGrouping) {
+            info() << "Sorted grouping used for the cross-talk and dark counts" << std::endl;
+        }
+        return true;
+    }
+
+    struct Photon { uint64_t id; double time; };
+
+    // the neighbour slots of all the photons are drawn together (a Bernoulli trial on each
+    // uniform of a buffer, without branches), then the fired neighbours are added as photons at
+    // the time of the photon that fired them
+    void cross_talk(std::vector<Photon>& photons, uint64_t key) const
+    {
+        const size_t n = photons.size();
+        std::vector<uint64_t> pixel(n);
+        std::vector<uint32_t> offset(n + 1, 0);
+        for (size_t i = 0; i < n; ++i) {
+            pixel[i] = m_pixels.index(photons[i].id);
+            const uint32_t count = (pixel[i] < m_pixels.size())
+                ? m_crossTalkBegin[pixel[i] + 1] - m_crossTalkBegin[pixel[i]] : 0;
+            offset[i + 1] = offset[i] + count;
+        }
+        const size_t m = offset[n];
+        std::vector<double> rand(m);
+        std::vector<uint8_t> fire(m);
+        Jug::Base::Random::fill_uniform(Jug::Base::Random::mix64(key ^ kCrossTalkStream), 0, rand.data(), m);
+        const double prob = m_crossTalkProb;
+        for (size_t k = 0; k < m; ++k) {
+            fire[k] = static_cast<uint8_t>(rand[k] < prob);
+        }
+        for (size_t i = 0; i < n; ++i) {
+            for (uint32_t k = offset[i]; k < offset[i + 1]; ++k) {
+                if (fire[k] != 0) {
+                    const uint64_t id = m_crossTalkCells[m_crossTalkBegin[pixel[i]] + (k - offset[i])];
+                    photons.push_back({id, photons[i].time});
+                }
+            }
+        }
+    }
+
+    // the pixels with a dark count are a Bernoulli process over the pixel index, drawn by skips
+    void dark_counts(std::vector<Photon>& photons, uint64_t key) const
+    {
+        Jug::Base::Random::Stream rng(Jug::Base::Random::mix64(key ^ kDarkStream), 0);
+        const double logq = std::log1p(-m_darkProb);
+        const double window = m_darkCountWindow/Jug::Units::ns;
+        for (uint64_t p = m_pixels.next(0, rng.uniform(), logq); p < m_pixels.size();
+             p = m_pixels.next(p + 1, rng.uniform(), logq)) {
+            photons.push_back({m_pixels.cellID(p), rng.uniform()*window});
+        }
+    }
+
+    // quantum efficiency at the nodes of a uniform energy grid over the data range, the lookup is
+    // a single index computation and a linear interpolation within a bin
+    void qe_table()
+    {
+        const auto &qeff = u_quantumEfficiency.value();
+        m_qeTable.clear();
+        if (qeff.size() < 2 || m_qeBins < 1 || qeff.back().first <= qeff.front().first) {
+            warning() << "Not enough quantum efficiency data for a table, assuming 0% efficiency" << std::endl;
+            return;
+        }
+        const int bins = m_qeBins;
+        m_qeMin = qeff.front().first;
+        m_qeMax = qeff.back().first;
+        const double width = (m_qeMax - m_qeMin) / bins;
+        m_qeInvWidth = 1. / width;
+        m_qeBinsMax = bins;
+        m_qeTable.resize(bins + 2);
+        auto it = qeff.begin();
+        for (int i = 0; i <= bins; ++i) {
+            const double ev = (i == bins) ? m_qeMax : m_qeMin + i*width;
+            while (std::next(it) != qeff.end() && std::next(it)->first < ev) {
+                ++it;
+            }
+            const auto itn = std::next(it);
+            m_qeTable[i] = (itn == qeff.end() || itn->first == it->first) ? it->second
+                : (it->second*(itn->first - ev) + itn->second*(ev - it->first)) / (itn->first - it->first);
+        }
+        // guard for the interpolation at the upper edge
+        m_qeTable[bins + 1] = m_qeTable[bins];
+    }
+
+    bool qe_pass(double ev, double rand) const
+    {
+        // out of QE data range, assuming 0% efficiency
+        if (m_qeTable.empty() || !(ev >= m_qeMin && ev <= m_qeMax)) {
+            return false;
+        }
+        const double x = std::min((ev - m_qeMin)*m_qeInvWidth, m_qeBinsMax);
+        const auto i = static_cast<size_t>(x);
+        const double prob = m_qeTable[i] + (x - i)*(m_qeTable[i + 1] - m_qeTable[i]);
+        return rand <= prob;
+    }
+
+    // the same for n photons, with the kernel of the instruction set of the CPU
+    void qe_pass(const double* __restrict ev, const double* __restrict rand, uint8_t* __restrict pass,
+                 size_t n) const
+    {
+        if (m_qeTable.empty()) {
+            std::fill(pass, pass + n, 0);
+            return;
+        }
+        qe_pass_all(m_qeTable.data(), m_qeMin, m_qeMax, m_qeInvWidth, m_qeBinsMax, ev, rand, pass, n);
+    }
+
+    // key of the quantum efficiency uniforms, derived from the event key
+    static constexpr uint64_t kQEStream = Jug::Base::Random::hash_name("quantumEfficiency");
+    // keys of the cross-talk uniforms and of the dark counts
+    static constexpr uint64_t kCrossTalkStream = Jug::Base::Random::hash_name("crossTalk");
+    static constexpr uint64_t kDarkStream = Jug::Base::Random::hash_name("darkCounts");
+
+    std::vector<double> m_qeTable;
+    double m_qeMin{0.}, m_qeMax{0.}, m_qeInvWidth{0.}, m_qeBinsMax{0.};
+
+    NeighbourLookup m_neighbourLookup;
+    DenseChannels m_pixels;
+    std::vector<uint32_t> m_crossTalkBegin;
+    std::vector<uint64_t> m_crossTalkCells;
+    double m_darkProb{0.};
+};
+
+} // namespace Jug::Digi
+
+#endif
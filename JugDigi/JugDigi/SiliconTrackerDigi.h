@@ -0,0 +1,139 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Whitney Armstrong, Wouter Deconinck, Sylvester Joosten
+
+#ifndef JUGDIGI_SILICONTRACKERDIGI_H
+#define JUGDIGI_SILICONTRACKERDIGI_H
+
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "JugBase/Algorithm.h"
+#include "JugBase/Property.h"
+#include "JugBase/Utilities/FlatIndexMap.h"
+#include "JugBase/Utilities/Philox.h"
+#include "JugBase/Utilities/Units.h"
+
+// Event Model related classes
+// edm4hep's tracker hit is the input collectiopn
+#include "edm4hep/MCParticle.h"
+#include "edm4hep/SimTrackerHitCollection.h"
+// eicd's RawTrackerHit is the output
+#include "eicd/RawTrackerHitCollection.h"
+
+namespace Jug::Digi {
+
+/** Silicon detector digitization.
+ *
+ *  The time smearing is drawn from the random stream of each cell in the event, reproducible
+ *  whatever the order of the events and the threads. The hits are aggregated per cell in one
+ *  pass through a flat cellID table, and the raw hits are made at the end, one per cell. The
+ *  reference implementation for the validation mode aggregates them with a std::unordered_map.
+ *  Framework-independent, run in Gaudi with Jug::AlgorithmAdaptor.
+ *
+ * \ingroup digi
+ */
+class SiliconTrackerDigi : public Jug::Algorithm<Jug::Input<edm4hep::SimTrackerHitCollection>,
+                                                 Jug::Output<eicd::RawTrackerHitCollection>> {
+public:
+  static constexpr bool usesRandom = true;
+
+  Jug::Property<double> m_timeResolution{this, "timeResolution", 10}; // todo : add units
+  Jug::Property<double> m_threshold{this, "threshold", 0. * Jug::Units::keV};
+
+  SiliconTrackerDigi(const std::string& name) : Algorithm(name, {"inputHitCollection"}, {"outputHitCollection"}) {}
+
+  Output execute(const Input& input, const Jug::AlgorithmContext& context) const override {
+    Jug::Base::FlatIndexMap cell_index(std::get<0>(input).size());
+    return digitize(input, context, [&cell_index](uint64_t cellID, uint32_t index) {
+      return cell_index.emplace(cellID, index);
+    });
+  }
+
+  bool hasReference() const override { return true; }
+  Output executeReference(const Input& input, const Jug::AlgorithmContext& context) const override {
+    std::unordered_map<uint64_t, uint32_t> cell_index;
+    return digitize(input, context, [&cell_index](uint64_t cellID, uint32_t index) {
+      const auto [it, inserted] = cell_index.emplace(cellID, index);
+      return std::make_pair(it->second, inserted);
+    });
+  }
+
+  void compare(const Output& reference, const Output& optimized, Jug::ValidationReport& report) const override {
+    const auto& ref = std::get<0>(reference);
+    const auto& opt = std::get<0>(optimized);
+    report.collection(outputNames()[0]);
+    if (!report.size(ref.size(), opt.size())) {
+      return;
+    }
+    for (size_t i = 0; i < ref.size(); ++i) {
+      report.value(i, "cellID", ref[i].getCellID(), opt[i].getCellID());
+      report.value(i, "charge", ref[i].getCharge(), opt[i].getCharge());
+      report.value(i, "timeStamp", ref[i].getTimeStamp(), opt[i].getTimeStamp());
+    }
+  }
+
+private:
+  // cell_index(cellID, index) gives the index of the cell and if it was inserted with index
+  template <class CellIndex>
+  Output digitize(const Input& input, const Jug::AlgorithmContext& context, CellIndex&& cell_index) const {
+    const auto& simhits = std::get<0>(input);
+    // hit cells in the order of their first hit: cellID, time stamp of the last hit, summed charge
+    // and the stream for the time smearing of the hits in order
+    std::vector<uint64_t> cellIDs;
+    std::vector<double> timeStamps;
+    std::vector<long long> charges;
+    std::vector<Jug::Base::Random::Stream> streams;
+    cellIDs.reserve(simhits.size());
+    timeStamps.reserve(simhits.size());
+    charges.reserve(simhits.size());
+    streams.reserve(simhits.size());
+    for (const auto& ahit : simhits) {
+      if (msgLevel(Jug::LogLevel::kDebug)) {
+        debug() << "--------------------" << ahit.getCellID() << std::endl;
+        debug() << "Hit in cellID = " << ahit.getCellID() << std::endl;
+        debug() << "     position = (" << ahit.getPosition().x << "," << ahit.getPosition().y << ","
+                << ahit.getPosition().z << ")" << std::endl;
+        debug() << "    xy_radius = " << std::hypot(ahit.getPosition().x, ahit.getPosition().y) << std::endl;
+        debug() << "     momentum = (" << ahit.getMomentum().x << "," << ahit.getMomentum().y << ","
+                << ahit.getMomentum().z << ")" << std::endl;
+      }
+      if (ahit.getEDep() * Jug::Units::keV < m_threshold) {
+        if (msgLevel(Jug::LogLevel::kDebug)) {
+          debug() << "         edep = " << ahit.getEDep() << " (below threshold of "
+                  << m_threshold / Jug::Units::keV << " keV)" << std::endl;
+        }
+        continue;
+      } else {
+        if (msgLevel(Jug::LogLevel::kDebug)) {
+          debug() << "         edep = " << ahit.getEDep() << std::endl;
+        }
+      }
+      const uint64_t cellID        = ahit.getCellID();
+      const auto [icell, inserted] = cell_index(cellID, static_cast<uint32_t>(cellIDs.size()));
+      if (inserted) {
+        cellIDs.push_back(cellID);
+        timeStamps.push_back(0.);
+        charges.push_back(0);
+        streams.emplace_back(context.randomKey, cellID);
+      }
+      // ns->fs
+      timeStamps[icell] =
+          ahit.getMCParticle().getTime() * 1e6 + streams[icell].normal() * m_timeResolution.value() * 1e3;
+      charges[icell] += std::llround(ahit.getEDep() * 1e6);
+    }
+
+    eicd::RawTrackerHitCollection rawhits;
+    for (size_t icell = 0; icell < cellIDs.size(); ++icell) {
+      rawhits.push_back(eicd::RawTrackerHit(cellIDs[icell], static_cast<int32_t>(timeStamps[icell]),
+                                            static_cast<int32_t>(charges[icell])));
+    }
+    return {std::move(rawhits)};
+  }
+};
+
+} // namespace Jug::Digi
+
+#endif
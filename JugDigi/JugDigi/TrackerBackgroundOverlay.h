@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGDIGI_TRACKERBACKGROUNDOVERLAY_H
+#define JUGDIGI_TRACKERBACKGROUNDOVERLAY_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "JugBase/Algorithm.h"
+#include "JugBase/Property.h"
+#include "JugBase/Utilities/Units.h"
+#include "JugDigi/BackgroundOverlay.h"
+
+#include "edm4hep/MCParticleCollection.h"
+#include "edm4hep/SimTrackerHitCollection.h"
+
+namespace Jug::Digi {
+
+  /** Overlay of background events on the simulated tracker hits.
+   *
+   *  The background hits of the first poolSize events of backgroundFiles are kept in memory at
+   *  initialize. Each signal event gets a Poisson number of background events (meanMultiplicity),
+   *  picked in the pool with a uniform time offset in [timeOffsetMin, timeOffsetMax). The
+   *  background hits are added after the signal hits, shifted in time; the digitization merges the
+   *  hits per cell. The background hits of an overlaid event refer to one particle of
+   *  outputParticleCollection, at the time offset of the event, since the digitization takes the
+   *  time of the hits from their particle.
+   *
+   *  The background events of a signal event are drawn from the streams of randomName, so that the
+   *  overlays of the detectors with the same randomName and pool overlay the same events.
+   *  Framework-independent, run in Gaudi with Jug::AlgorithmAdaptor.
+   *
+   * \ingroup digi
+   */
+  class TrackerBackgroundOverlay
+      : public Jug::Algorithm<Jug::Input<edm4hep::SimTrackerHitCollection>,
+                              Jug::Output<edm4hep::SimTrackerHitCollection, edm4hep::MCParticleCollection>> {
+  public:
+    static constexpr bool usesRandom = true;
+
+    Jug::Property<std::vector<std::string>> m_backgroundFiles{this, "backgroundFiles", {}};
+    Jug::Property<std::string> m_backgroundCollection{this, "backgroundCollection", ""};
+    Jug::Property<unsigned int> m_poolSize{this, "poolSize", 100};
+    Jug::Property<double> m_meanMultiplicity{this, "meanMultiplicity", 1.};
+    Jug::Property<double> m_timeOffsetMin{this, "timeOffsetMin", 0. * Jug::Units::ns};
+    Jug::Property<double> m_timeOffsetMax{this, "timeOffsetMax", 0. * Jug::Units::ns};
+    Jug::Property<std::string> m_randomName{this, "randomStreamName", "BackgroundOverlay"};
+
+    TrackerBackgroundOverlay(const std::string& name)
+        : Algorithm(name, {"inputHitCollection"}, {"outputHitCollection", "outputParticleCollection"}) {}
+
+    const std::string& randomName() const override { return m_randomName.value(); }
+
+    bool initialize(const dd4hep::Detector* /* detector */) override {
+      if (m_backgroundFiles.value().empty() || m_backgroundCollection.value().empty()) {
+        error() << "backgroundFiles and backgroundCollection are needed for the overlay" << std::endl;
+        return false;
+      }
+      if (m_timeOffsetMax.value() < m_timeOffsetMin.value()) {
+        error() << "timeOffsetMax is below timeOffsetMin" << std::endl;
+        return false;
+      }
+      try {
+        loadBackground<edm4hep::SimTrackerHitCollection>(m_backgroundFiles.value(), m_backgroundCollection.value(),
+                                                         m_poolSize.value(), m_pool);
+      } catch (const std::exception& e) {
+        error() << "Cannot read the background: " << e.what() << std::endl;
+        return false;
+      }
+      if (m_pool.size() == 0) {
+        error() << "No background events in backgroundFiles" << std::endl;
+        return false;
+      }
+      info() << "Background pool of " << m_pool.size() << " events, " << m_pool.cellID.size() << " hits of "
+             << m_backgroundCollection.value() << std::endl;
+      return true;
+    }
+
+    Output execute(const Input& input, const Jug::AlgorithmContext& context) const override {
+      const auto& simhits = std::get<0>(input);
+      std::vector<BackgroundSample> samples;
+      sampleBackground(context.randomKey, 0, m_meanMultiplicity.value(), m_pool.size(), m_timeOffsetMin.value(),
+                       m_timeOffsetMax.value(), samples);
+
+      edm4hep::SimTrackerHitCollection hits;
+      edm4hep::MCParticleCollection particles;
+      for (const auto& ahit : simhits) {
+        hits.push_back(ahit.clone());
+      }
+      for (const auto& sample : samples) {
+        auto particle = particles.create();
+        particle.setTime(static_cast<float>(sample.timeOffset));
+        for (uint32_t h = m_pool.hitBegin[sample.event]; h < m_pool.hitBegin[sample.event + 1]; ++h) {
+          auto hit = hits.create();
+          hit.setCellID(m_pool.cellID[h]);
+          hit.setEDep(m_pool.eDep[h]);
+          hit.setTime(static_cast<float>(m_pool.time[h] + sample.timeOffset));
+          hit.setPathLength(m_pool.pathLength[h]);
+          hit.setQuality(m_pool.quality[h]);
+          hit.setPosition(m_pool.position[h]);
+          hit.setMomentum(m_pool.momentum[h]);
+          hit.setMCParticle(particle);
+        }
+      }
+      if (msgLevel(Jug::LogLevel::kDebug)) {
+        debug() << samples.size() << " background events, " << hits.size() - simhits.size() << " hits added to "
+                << simhits.size() << " signal hits" << std::endl;
+      }
+      return {std::move(hits), std::move(particles)};
+    }
+
+  private:
+    TrackerBackgroundPool m_pool;
+  };
+
+} // namespace Jug::Digi
+
+#endif
@@ -0,0 +1,13 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "JugBase/AlgorithmAdaptor.h"
+#include "JugDigi/CalorimeterBackgroundOverlay.h"
+
+namespace Jug::Digi {
+
+using CalorimeterBackgroundOverlayAlgorithm = Jug::AlgorithmAdaptor<CalorimeterBackgroundOverlay>;
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT_WITH_ID(CalorimeterBackgroundOverlayAlgorithm, "Jug::Digi::CalorimeterBackgroundOverlay")
+
+} // namespace Jug::Digi
@@ -0,0 +1,13 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "JugBase/AlgorithmAdaptor.h"
+#include "JugDigi/CalorimeterBirksHitDigi.h"
+
+namespace Jug::Digi {
+
+using CalorimeterBirksHitDigiAlgorithm = Jug::AlgorithmAdaptor<CalorimeterBirksHitDigi>;
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT_WITH_ID(CalorimeterBirksHitDigiAlgorithm, "Jug::Digi::CalorimeterBirksHitDigi")
+
+} // namespace Jug::Digi
@@ -0,0 +1,13 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "JugBase/AlgorithmAdaptor.h"
+#include "JugDigi/CalorimeterWaveformDigi.h"
+
+namespace Jug::Digi {
+
+using CalorimeterWaveformDigiAlgorithm = Jug::AlgorithmAdaptor<CalorimeterWaveformDigi>;
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT_WITH_ID(CalorimeterWaveformDigiAlgorithm, "Jug::Digi::CalorimeterWaveformDigi")
+
+} // namespace Jug::Digi
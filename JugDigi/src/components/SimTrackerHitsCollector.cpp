@@ -8,6 +8,8 @@
 #include "GaudiAlg/Transformer.h"
 
 #include "JugBase/DataHandle.h"
+#include "JugBase/DataHandleArray.h"
+#include "JugBase/Logging.h"
 
 // Event Model related classes
 #include "edm4hep/SimTrackerHitCollection.h"
@@ -19,14 +21,18 @@ namespace Jug::Digi {
      * \param inputSimTrackerHits [in] vector of collection names
      * \param outputSimTrackerHits [out] hits combined into one collection.
      *
+     * With subsetCollection, the output is a subset collection referencing the input hits instead
+     * of copies (the hits keep the object IDs of their input collection).
+     *
      * \ingroup digi
      */
     class SimTrackerHitsCollector : public GaudiAlgorithm {
     private:
-      Gaudi::Property<std::vector<std::string>> m_inputSimTrackerHits{this, "inputSimTrackerHits", {},"Tracker hits to be aggregated"};
+      Jug::Base::DataHandleArray<edm4hep::SimTrackerHitCollection> m_hitCollections{this, "inputSimTrackerHits",
+                                                                                   "Tracker hits to be aggregated"};
       DataHandle<edm4hep::SimTrackerHitCollection> m_outputSimTrackerHits{"outputSimTrackerHits", Gaudi::DataHandle::Writer, this};
-
-      std::vector<DataHandle<edm4hep::SimTrackerHitCollection>*> m_hitCollections;
+      Gaudi::Property<bool> m_subsetCollection{this, "subsetCollection", false,
+                                               "Reference the input hits instead of copying them"};
 
     public:
       SimTrackerHitsCollector(const std::string& name, ISvcLocator* svcLoc)
@@ -34,34 +40,37 @@ namespace Jug::Digi {
       {
         declareProperty("outputSimTrackerHits", m_outputSimTrackerHits, "output hits combined into single collection");
       }
-      ~SimTrackerHitsCollector() {
-        for (auto* col : m_hitCollections) {
-          delete col;
-        }
-      }
 
       StatusCode initialize() override {
         if (GaudiAlgorithm::initialize().isFailure()) {
           return StatusCode::FAILURE;
         }
-        for (auto colname : m_inputSimTrackerHits) {
-          debug() << "initializing collection: " << colname  << endmsg;
-          m_hitCollections.push_back(new DataHandle<edm4hep::SimTrackerHitCollection>{colname, Gaudi::DataHandle::Reader, this});
+        for (const auto& colname : m_hitCollections.keys()) {
+          JUG_DEBUG("initializing collection: " << colname);
         }
         return StatusCode::SUCCESS;
       }
 
       StatusCode execute() override
       {
-        auto* outputHits = m_outputSimTrackerHits.createAndPut();
+        const auto& collections = m_hitCollections.get();
+        auto* outputHits        = m_outputSimTrackerHits.createAndPut(m_hitCollections.totalSize());
+        if (m_subsetCollection.value()) {
+          outputHits->setSubsetCollection();
+        }
         if (msgLevel(MSG::DEBUG)) {
           debug() << "execute collector" << endmsg;
         }
-        for(const auto& hits: m_hitCollections) {
-          const edm4hep::SimTrackerHitCollection* hitCol = hits->get();
+        for (const edm4hep::SimTrackerHitCollection* hitCol : collections) {
           if (msgLevel(MSG::DEBUG)) {
             debug() << "col n hits: " << hitCol->size() << endmsg;
           }
+          if (m_subsetCollection.value()) {
+            for (const auto& ahit : *hitCol) {
+              outputHits->push_back(ahit);
+            }
+            continue;
+          }
           for (const auto& ahit : *hitCol) {
             outputHits->push_back(ahit.clone());
           }
@@ -0,0 +1,13 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "JugBase/AlgorithmAdaptor.h"
+#include "JugDigi/TrackerBackgroundOverlay.h"
+
+namespace Jug::Digi {
+
+using TrackerBackgroundOverlayAlgorithm = Jug::AlgorithmAdaptor<TrackerBackgroundOverlay>;
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT_WITH_ID(TrackerBackgroundOverlayAlgorithm, "Jug::Digi::TrackerBackgroundOverlay")
+
+} // namespace Jug::Digi
@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+/*
+ *  Units of the properties of the framework-independent calorimeter digitization. The job options
+ *  give the values in Gaudi units (Jug::AlgorithmAdaptor passes them unchanged), so the values of
+ *  the existing option files have to give the digitization of the Gaudi CalorimeterHitDigi.
+ */
+#include <cmath>
+#include <iostream>
+
+#include "JugDigi/CalorimeterHitDigi.h"
+
+#include "edm4hep/CaloHitContributionCollection.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+  if (!ok) {
+    std::cerr << "FAILED: " << what << std::endl;
+    ++failures;
+  }
+}
+
+} // namespace
+
+int main() {
+  // defaults, 100 MeV and 10 ps
+  {
+    Jug::Digi::CalorimeterHitDigi digi("TestCalorimeterHitDigiDefaults");
+    check(digi.initialize(nullptr), "initialize with the defaults");
+    check(std::abs(digi.dyRangeADC - 0.1) < 1e-12, "default dynamicRangeADC is 0.1 GeV");
+    check(std::abs(digi.stepTDC - 100.) < 1e-9, "default resolutionTDC is 100 TDC per ns");
+  }
+
+  // dynamicRangeADC=3*units.MeV, timeResolution=8*units.ns (JugBenchmarks/options/chains.py,
+  // Examples/options/imaging_topocluster.py), as Gaudi gives them
+  Jug::Digi::CalorimeterHitDigi digi("TestCalorimeterHitDigi");
+  digi.m_dyRangeADC.value()  = 3.;
+  digi.m_tRes.value()        = 8.;
+  digi.m_pedSigmaADC.value() = 0.;
+  check(digi.initialize(nullptr), "initialize with the option values");
+  check(std::abs(digi.dyRangeADC - 0.003) < 1e-15, "dynamicRangeADC of 3 MeV is 0.003 GeV");
+  check(std::abs(digi.tRes - 8.) < 1e-12, "timeResolution of 8 ns is 8 ns");
+
+  // a hit of 1.5 MeV at 5 ns: half the ADC range above the pedestal, as in CalorimeterHitReco
+  edm4hep::CaloHitContributionCollection contributions;
+  edm4hep::SimCalorimeterHitCollection hits;
+  auto c = contributions.create();
+  c.setEnergy(0.0015);
+  c.setTime(5.);
+  auto hit = hits.create();
+  hit.setCellID(1);
+  hit.setEnergy(0.0015);
+  hit.addToContributions(c);
+  digi.m_tRes.value() = 0.;
+  check(digi.initialize(nullptr), "initialize without time resolution");
+  const auto raw = digi.digitize(hits, 1);
+  check(raw.size() == 1, "one raw hit");
+  if (raw.size() == 1) {
+    check(raw.amplitude[0] == 400 + 4048, "ADC of 1.5 MeV in a range of 3 MeV");
+    check(raw.timeStamp[0] == 500, "TDC of 5 ns at 10 ps");
+  }
+
+  return failures == 0 ? 0 : 1;
+}
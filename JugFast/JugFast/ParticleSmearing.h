@@ -0,0 +1,188 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "JugBase/Utilities/Philox.h"
+
+namespace Jug::Fast {
+
+/** Resolution as a function of the momentum, precomputed on a uniform grid.
+ *
+ *  Configured from a single value (a constant resolution) or from (p, sigma) knots in increasing
+ *  momentum, linearly interpolated and constant outside of the knots. The knots are resampled on
+ *  kPoints points at configure, so that an evaluation is an index and a linear interpolation
+ *  without search.
+ *
+ * \ingroup fast
+ */
+class ResolutionTable {
+public:
+  static constexpr size_t kPoints = 256;
+
+  explicit ResolutionTable(double constant = 0.) : m_grid{constant} {}
+
+  /// False (and unchanged) if the values are neither a constant nor increasing (p, sigma) knots
+  bool configure(const std::vector<double>& values) {
+    if (values.size() == 1) {
+      m_grid.assign(1, values[0]);
+      return true;
+    }
+    if (values.size() < 4 || values.size() % 2 != 0) {
+      return false;
+    }
+    const size_t knots = values.size() / 2;
+    for (size_t k = 1; k < knots; ++k) {
+      if (!(values[2 * k] > values[2 * k - 2])) {
+        return false;
+      }
+    }
+    m_p0      = values[0];
+    m_invStep = (kPoints - 1) / (values[2 * knots - 2] - m_p0);
+    m_grid.resize(kPoints);
+    size_t k = 0;
+    for (size_t i = 0; i < kPoints; ++i) {
+      const double p = m_p0 + i / m_invStep;
+      while (k + 2 < knots && p > values[2 * k + 2]) {
+        ++k;
+      }
+      const double f = std::clamp((p - values[2 * k]) / (values[2 * k + 2] - values[2 * k]), 0., 1.);
+      m_grid[i]      = values[2 * k + 1] + f * (values[2 * k + 3] - values[2 * k + 1]);
+    }
+    return true;
+  }
+
+  double operator()(double p) const {
+    if (m_grid.size() == 1) {
+      return m_grid[0];
+    }
+    const double x = std::clamp((p - m_p0) * m_invStep, 0., static_cast<double>(kPoints - 1));
+    const auto i   = std::min(static_cast<size_t>(x), kPoints - 2);
+    return m_grid[i] + (x - i) * (m_grid[i + 1] - m_grid[i]);
+  }
+
+  bool zero() const { return m_grid.size() == 1 && m_grid[0] == 0.; }
+
+private:
+  std::vector<double> m_grid;
+  double m_p0{0};
+  double m_invStep{0};
+};
+
+/// Parametrized response: relative momentum, polar and azimuthal angle [rad] and vertex [mm] resolutions
+struct SmearingModel {
+  ResolutionTable momentum;
+  ResolutionTable theta;
+  ResolutionTable phi;
+  ResolutionTable vertex;
+};
+
+/** Batched smearing of particles with a parametrized response.
+ *
+ *  The selected particles of an event are gathered in structure of arrays, the normal variates of
+ *  all of them are drawn at once from the (seed, stream) of the event, with kNormals fixed slots
+ *  per particle, and the smeared momenta, energies and vertices are computed in one pass over the
+ *  arrays. The energy is kept consistent with the mass (E^2 - p^2 unchanged), the directions
+ *  are only recomputed from the angles when the angles are smeared.
+ *
+ * \ingroup fast
+ */
+class ParticleSmearing {
+public:
+  // momentum, theta, phi, vertex x, y, z
+  static constexpr size_t kNormals = 6;
+
+  void clear() {
+    for (auto* column : {&m_px, &m_py, &m_pz, &m_energy, &m_vx, &m_vy, &m_vz}) {
+      column->clear();
+    }
+    m_index.clear();
+  }
+  void reserve(size_t n) {
+    for (auto* column : {&m_px, &m_py, &m_pz, &m_energy, &m_vx, &m_vy, &m_vz}) {
+      column->reserve(n);
+    }
+    m_index.reserve(n);
+  }
+
+  /// Add a particle, index is its index in the input collection
+  void add(uint32_t index, double px, double py, double pz, double energy, double vx, double vy, double vz) {
+    m_index.push_back(index);
+    m_px.push_back(px);
+    m_py.push_back(py);
+    m_pz.push_back(pz);
+    m_energy.push_back(energy);
+    m_vx.push_back(vx);
+    m_vy.push_back(vy);
+    m_vz.push_back(vz);
+  }
+
+  size_t size() const { return m_index.size(); }
+  uint32_t index(size_t i) const { return m_index[i]; }
+
+  /// Smear the particles added since the last clear
+  void smear(const SmearingModel& model, uint64_t seed, uint64_t stream) { smear(model, seed, stream, 0, size()); }
+
+  /// Smear the particles [first, last) with the variates of (seed, stream), e.g. the particles of one
+  /// event of a batch; the same results as smearing them alone
+  void smear(const SmearingModel& model, uint64_t seed, uint64_t stream, size_t first, size_t last) {
+    m_normals.resize(kNormals * (last - first));
+    Jug::Base::Random::fill_normal(seed, stream, m_normals.data(), m_normals.size());
+    const double* g = m_normals.data();
+
+    m_out.resize(size());
+    m_sigma.resize(size());
+    for (size_t i = first; i < last; ++i) {
+      Smeared& out       = m_out[i];
+      const double p     = std::sqrt(m_px[i] * m_px[i] + m_py[i] * m_py[i] + m_pz[i] * m_pz[i]);
+      m_sigma[i]         = model.momentum(p);
+      out.p              = p * (1. + m_sigma[i] * g[kNormals * (i - first)]);
+      out.energy         = std::sqrt(std::max(0., m_energy[i] * m_energy[i] - p * p + out.p * out.p));
+      const double scale = (p > 0.) ? out.p / p : 0.;
+      out.px             = m_px[i] * scale;
+      out.py             = m_py[i] * scale;
+      out.pz             = m_pz[i] * scale;
+      const double sv    = model.vertex(p);
+      out.vx             = m_vx[i] + sv * g[kNormals * (i - first) + 3];
+      out.vy             = m_vy[i] + sv * g[kNormals * (i - first) + 4];
+      out.vz             = m_vz[i] + sv * g[kNormals * (i - first) + 5];
+    }
+    if (!model.theta.zero() || !model.phi.zero()) {
+      for (size_t i = first; i < last; ++i) {
+        const double pt    = std::hypot(m_px[i], m_py[i]);
+        const double p     = std::hypot(pt, m_pz[i]);
+        const double theta = std::atan2(pt, m_pz[i]) + model.theta(p) * g[kNormals * (i - first) + 1];
+        const double phi   = std::atan2(m_py[i], m_px[i]) + model.phi(p) * g[kNormals * (i - first) + 2];
+        const double ps    = m_out[i].p;
+        m_out[i].px        = ps * std::sin(theta) * std::cos(phi);
+        m_out[i].py        = ps * std::sin(theta) * std::sin(phi);
+        m_out[i].pz        = ps * std::cos(theta);
+      }
+    }
+  }
+
+  /// Smeared particle i, valid until the next smear
+  struct Smeared {
+    double px, py, pz;
+    double p;
+    double energy;
+    double vx, vy, vz;
+  };
+  const Smeared& smeared(size_t i) const { return m_out[i]; }
+  /// Relative momentum resolution of particle i
+  double sigma(size_t i) const { return m_sigma[i]; }
+
+private:
+  std::vector<uint32_t> m_index;
+  std::vector<double> m_px, m_py, m_pz, m_energy, m_vx, m_vy, m_vz;
+  std::vector<double> m_normals;
+  std::vector<double> m_sigma;
+  std::vector<Smeared> m_out;
+};
+
+} // namespace Jug::Fast
@@ -0,0 +1,128 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace Jug::Fast {
+
+/** Binned (theta, phi, p) acceptance and resolution of a far-forward subsystem.
+ *
+ *  Read at initialize from a text file (# for comments) with the binning of the 3 axes, the
+ *  detected particles and one line per filled bin:
+ *
+ *      theta <bins> <min> <max>            polar angle in the ion frame [rad]
+ *      phi <bins> <min> <max>              azimuthal angle in the ion frame [rad]
+ *      p <bins> <min> <max>                momentum [GeV], or
+ *      xL <bins> <min> <max>               momentum over the ion beam energy
+ *      pdg <code> <code> ...
+ *      bin <itheta> <iphi> <ip> <acceptance> <sigmaP / p> <sigmaTheta> <sigmaPhi>
+ *
+ *  The bins that are not listed, and the particles outside of the axes, are not accepted. The
+ *  responses are in a flat array indexed by bin, so that a lookup is three multiplications.
+ *
+ * \ingroup fast
+ */
+class ResponseMap {
+public:
+  struct Response {
+    float acceptance{0};
+    float sigmaP{0};
+    float sigmaTheta{0};
+    float sigmaPhi{0};
+  };
+
+  /// False with the reason in error if the file cannot be read or is not a valid map
+  bool load(const std::string& filename, std::string& error) {
+    std::ifstream is(filename);
+    if (!is) {
+      error = "cannot open " + filename;
+      return false;
+    }
+    std::string line;
+    for (size_t lineNumber = 1; std::getline(is, line); ++lineNumber) {
+      line = line.substr(0, line.find('#'));
+      std::istringstream fields(line);
+      std::string keyword;
+      if (!(fields >> keyword)) {
+        continue;
+      }
+      bool valid = false;
+      if (keyword == "theta" || keyword == "phi" || keyword == "p" || keyword == "xL") {
+        Axis& axis = (keyword == "theta") ? m_axes[0] : (keyword == "phi") ? m_axes[1] : m_axes[2];
+        valid      = (fields >> axis.bins >> axis.min >> axis.max) && axis.bins > 0 && axis.max > axis.min;
+        axis.scale = valid ? axis.bins / (axis.max - axis.min) : 0.;
+        if (keyword == "p" || keyword == "xL") {
+          m_fraction = (keyword == "xL");
+        }
+      } else if (keyword == "pdg") {
+        for (int pdg = 0; fields >> pdg;) {
+          m_pdg.push_back(pdg);
+        }
+        valid = fields.eof();
+      } else if (keyword == "bin") {
+        int64_t ibin[3] = {0, 0, 0};
+        Response r;
+        valid = static_cast<bool>(fields >> ibin[0] >> ibin[1] >> ibin[2] >> r.acceptance >> r.sigmaP >> r.sigmaTheta >>
+                                  r.sigmaPhi);
+        for (size_t a = 0; valid && a < 3; ++a) {
+          valid = ibin[a] >= 0 && ibin[a] < m_axes[a].bins;
+        }
+        if (valid) {
+          m_responses.resize(m_axes[0].bins * m_axes[1].bins * m_axes[2].bins);
+          m_responses[(ibin[0] * m_axes[1].bins + ibin[1]) * m_axes[2].bins + ibin[2]] = r;
+        }
+      }
+      if (!valid) {
+        error = filename + " line " + std::to_string(lineNumber) + ": " + line;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool detects(int pdg) const { return std::find(m_pdg.begin(), m_pdg.end(), pdg) != m_pdg.end(); }
+  /// True if the momentum axis is the fraction of the ion beam energy
+  bool momentumFraction() const { return m_fraction; }
+  size_t filledBins() const {
+    return std::count_if(m_responses.begin(), m_responses.end(), [](const Response& r) { return r.acceptance > 0; });
+  }
+
+  /// Response of the bin, nullptr outside of the axes
+  const Response* find(double theta, double phi, double p) const {
+    const int64_t it = m_axes[0].bin(theta);
+    const int64_t ip = m_axes[1].bin(phi);
+    const int64_t im = m_axes[2].bin(p);
+    if ((it | ip | im) < 0 || m_responses.empty()) {
+      return nullptr;
+    }
+    return &m_responses[(it * m_axes[1].bins + ip) * m_axes[2].bins + im];
+  }
+
+private:
+  struct Axis {
+    int64_t bins{0};
+    double min{0};
+    double max{0};
+    double scale{0};
+    // -1 outside of the axis
+    int64_t bin(double x) const {
+      const double b = std::floor((x - min) * scale);
+      return (b >= 0 && b < bins) ? static_cast<int64_t>(b) : -1;
+    }
+  };
+
+  Axis m_axes[3];
+  bool m_fraction{false};
+  std::vector<int> m_pdg;
+  std::vector<Response> m_responses;
+};
+
+} // namespace Jug::Fast
@@ -13,6 +13,7 @@
 #include "GaudiKernel/PhysicalConstants.h"
 
 #include "JugBase/DataHandle.h"
+#include "JugBase/Utilities/AssociationIndex.h"
 
 // Event Model related classes
 #include "eicd/ClusterCollection.h"
@@ -149,18 +150,13 @@ public:
 
     std::map<int, std::vector<eicd::Cluster>> matched = {};
 
+    // associated particles, indexed once instead of a search for every cluster
+    const auto assocIndex = Jug::Base::association_index(associations);
+
     // loop over clusters
     for (const auto& cluster : clusters) {
-
-      int mcID = -1;
-
-      // find associated particle
-      for (const auto& assoc : associations) {
-        if (assoc.getRec() == cluster) {
-          mcID = assoc.getSimID();
-          break;
-        }
-      }
+      const auto iassoc = assocIndex.find(Jug::Base::object_key(cluster.getObjectID()));
+      const int mcID    = (iassoc != Jug::Base::FlatIndexMap::kEmpty) ? associations[iassoc].getSimID() : -1;
 
       if (msgLevel(MSG::VERBOSE)) {
         verbose() << " --> Found cluster with mcID " << mcID << " and energy "
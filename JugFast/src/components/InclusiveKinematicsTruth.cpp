@@ -9,11 +9,15 @@
 #include "GaudiKernel/PhysicalConstants.h"
 #include <algorithm>
 #include <cmath>
+#include <memory>
 
 #include "JugBase/IParticleSvc.h"
 #include "JugBase/DataHandle.h"
+#include "JugBase/EventFilter.h"
+#include "JugBase/TruthParticleIndex.h"
 
 #include "JugBase/Utilities/Beam.h"
+#include "JugBase/Utilities/EventBatch.h"
 
 #include "Math/Vector4D.h"
 using ROOT::Math::PxPyPzEVector;
@@ -37,6 +41,17 @@ private:
     Gaudi::DataHandle::Writer,
     this};
 
+  // Events of the batch of the input particles, and of the output kinematics, in the batched mode
+  Gaudi::Property<std::string> m_inputEventBatch{this, "inputEventBatch", ""};
+  Gaudi::Property<std::string> m_outputEventBatch{this, "outputEventBatch", "InclusiveKinematicsTruthBatch"};
+  std::unique_ptr<DataHandle<std::vector<unsigned long>>> m_inputBatch_ptr;
+  std::unique_ptr<DataHandle<std::vector<unsigned long>>> m_outputBatch_ptr;
+
+  // Beams and final state from the truth index of the event (TruthParticleIndexer), instead of
+  // scanning the particles
+  Gaudi::Property<std::string> m_inputTruthIndex{this, "inputTruthIndex", ""};
+  std::unique_ptr<DataHandle<TruthParticleIndex>> m_truthIndex_ptr;
+
   SmartIF<IParticleSvc> m_pidSvc;
   double m_proton{0};
   double m_neutron{0};
@@ -65,6 +80,18 @@ public:
     m_neutron = m_pidSvc->particle(2112).mass;
     m_electron = m_pidSvc->particle(11).mass;
 
+    // batched mode if requested
+    if (!m_inputEventBatch.value().empty()) {
+      m_inputBatch_ptr = std::make_unique<DataHandle<std::vector<unsigned long>>>(m_inputEventBatch,
+                                                                                    Gaudi::DataHandle::Reader, this);
+      m_outputBatch_ptr = std::make_unique<DataHandle<std::vector<unsigned long>>>(m_outputEventBatch,
+                                                                                     Gaudi::DataHandle::Writer, this);
+    }
+    if (!m_inputTruthIndex.value().empty()) {
+      m_truthIndex_ptr =
+          std::make_unique<DataHandle<TruthParticleIndex>>(m_inputTruthIndex, Gaudi::DataHandle::Reader, this);
+    }
+
     return StatusCode::SUCCESS;
   }
 
@@ -73,7 +100,49 @@ public:
     const auto& mcparts = *(m_inputMCParticleCollection.get());
     // output collection
     auto& out_kinematics = *(m_outputInclusiveKinematicsCollection.createAndPut());
+    const TruthParticleIndex* truth = m_truthIndex_ptr ? m_truthIndex_ptr->get() : nullptr;
+
+    if (!m_inputBatch_ptr) {
+      const char* reason = nullptr;
+      if (!kinematics(mcparts, truth, 0, mcparts.size(), out_kinematics, reason)) {
+        return Jug::Base::rejectEvent(*this, reason);
+      }
+      return StatusCode::SUCCESS;
+    }
 
+    // batched mode: the events without kinematics have none in the output batch instead of being rejected
+    Jug::Base::EventBatch batch;
+    if (!Jug::Base::EventBatch::decode(*m_inputBatch_ptr->get(), batch) || batch.begin.back() != mcparts.size()) {
+      error() << "Invalid event batch of the particles" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    Jug::Base::EventBatch outBatch;
+    outBatch.clear(batch.firstEntry);
+    for (size_t e = 0; e < batch.size(); ++e) {
+      const auto [first, last] = batch.range(e);
+      const char* reason       = nullptr;
+      if (!kinematics(mcparts, truth, first, last, out_kinematics, reason) && msgLevel(MSG::DEBUG)) {
+        debug() << "Entry " << batch.firstEntry + e << ": " << reason << endmsg;
+      }
+      outBatch.add(out_kinematics.size());
+    }
+    m_outputBatch_ptr->put(new std::vector<unsigned long>(outBatch.encode()));
+    return StatusCode::SUCCESS;
+  }
+
+private:
+  /// Particle of a truth index lookup, as the Beam finders return it (none if the index is -1)
+  static auto indexed(const edm4hep::MCParticleCollection& mcparts, int64_t i) {
+    std::vector<decltype(mcparts[0])> c;
+    if (i >= 0) {
+      c.push_back(mcparts[i]);
+    }
+    return c;
+  }
+
+  /// Kinematics of the event of the particles [first, last), false with the reason if not found
+  bool kinematics(const edm4hep::MCParticleCollection& mcparts, const TruthParticleIndex* truth, size_t first,
+                  size_t last, eicd::InclusiveKinematicsCollection& out_kinematics, const char*& reason) const {
     // Loop over generated particles to get incoming electron and proton beams
     // and the scattered electron. In the presence of QED radition on the incoming
     // or outgoing electron line, the vertex kinematics will be different than the
@@ -81,12 +150,11 @@ public:
     // Also need to update for CC events.
 
     // Get incoming electron beam
-    const auto ei_coll = Jug::Base::Beam::find_first_beam_electron(mcparts);
+    const auto ei_coll = (truth != nullptr) ? indexed(mcparts, truth->findFirst(truth->beams, {11}, first, last))
+                                            : Jug::Base::Beam::find_first_beam_electron(mcparts, first, last);
     if (ei_coll.size() == 0) {
-      if (msgLevel(MSG::DEBUG)) {
-        debug() << "No beam electron found" << endmsg;
-      }
-      return StatusCode::SUCCESS;
+      reason = "No beam electron found";
+      return false;
     }
     const auto ei_p = ei_coll[0].getMomentum();
     const auto ei_p_mag = eicd::magnitude(ei_p);
@@ -94,12 +162,12 @@ public:
     const PxPyPzEVector ei(ei_p.x, ei_p.y, ei_p.z, std::hypot(ei_p_mag, ei_mass));
 
     // Get incoming hadron beam
-    const auto pi_coll = Jug::Base::Beam::find_first_beam_hadron(mcparts);
+    const auto pi_coll = (truth != nullptr)
+                             ? indexed(mcparts, truth->findFirst(truth->beams, {2212, 2112}, first, last))
+                             : Jug::Base::Beam::find_first_beam_hadron(mcparts, first, last);
     if (pi_coll.size() == 0) {
-      if (msgLevel(MSG::DEBUG)) {
-        debug() << "No beam hadron found" << endmsg;
-      }
-      return StatusCode::SUCCESS;
+      reason = "No beam hadron found";
+      return false;
     }
     const auto pi_p = pi_coll[0].getMomentum();
     const auto pi_p_mag = eicd::magnitude(pi_p);
@@ -111,12 +179,12 @@ public:
     // which seems to be correct based on a cursory glance at the Pythia8 output. In the future,
     // it may be better to trace back each final-state electron and see which one originates from
     // the beam.
-    const auto ef_coll = Jug::Base::Beam::find_first_scattered_electron(mcparts);
+    const auto ef_coll = (truth != nullptr)
+                             ? indexed(mcparts, truth->findFirst(truth->finalState, {11}, first, last))
+                             : Jug::Base::Beam::find_first_scattered_electron(mcparts, first, last);
     if (ef_coll.size() == 0) {
-      if (msgLevel(MSG::DEBUG)) {
-        debug() << "No truth scattered electron found" << endmsg;
-      }
-      return StatusCode::SUCCESS;
+      reason = "No truth scattered electron found";
+      return false;
     }
     const auto ef_p = ef_coll[0].getMomentum();
     const auto ef_p_mag = eicd::magnitude(ef_p);
@@ -148,7 +216,7 @@ public:
               << endmsg;
     }
 
-    return StatusCode::SUCCESS;
+    return true;
   }
 };
 
@@ -5,89 +5,185 @@
 #include "GaudiAlg/GaudiTool.h"
 #include "GaudiAlg/Producer.h"
 #include "GaudiAlg/Transformer.h"
-#include "GaudiKernel/RndmGenerators.h"
+#include "GaudiKernel/ThreadLocalContext.h"
 #include <algorithm>
 #include <cmath>
+#include <memory>
 
 #include "JugBase/DataHandle.h"
+#include "JugBase/IRandomSvc.h"
+#include "JugBase/TruthParticleIndex.h"
+#include "JugBase/Utilities/EventBatch.h"
+#include "JugFast/ParticleSmearing.h"
 
 // Event Model related classes
 #include "edm4hep/MCParticleCollection.h"
+#include "eicd/MCRecoParticleAssociationCollection.h"
 #include "eicd/ReconstructedParticleCollection.h"
 
 namespace Jug::Fast {
 
+/** Parametrized smearing of the generated particles.
+ *
+ *  The relative momentum, polar and azimuthal angle and vertex resolutions are either a single
+ *  value or (p, sigma) knots in increasing momentum (see ResolutionTable); the momentum
+ *  resolution defaults to the smearing property, the others to no smearing. The particles of an
+ *  event are smeared at once with the normal variates of the event from the RandomSvc.
+ *
+ *  With inputEventBatch, the particles are the concatenated events of a batch (EventBatch, e.g.
+ *  from MCParticleBatchInput), each event is smeared with the variates of its input entry, and the
+ *  events of the output particles are stored in outputEventBatch.
+ *
+ * \ingroup fast
+ */
 class MC2SmearedParticle : public GaudiAlgorithm {
 private:
   DataHandle<edm4hep::MCParticleCollection> m_inputMCParticles{"MCParticles", Gaudi::DataHandle::Reader, this};
   DataHandle<eicd::ReconstructedParticleCollection> m_outputParticles{"SmearedReconstructedParticles",
                                                                       Gaudi::DataHandle::Writer, this};
-  Rndm::Numbers m_gaussDist;
+  DataHandle<eicd::MCRecoParticleAssociationCollection> m_outputAssocCollection{"SmearedParticleAssociations",
+                                                                                Gaudi::DataHandle::Writer, this};
   Gaudi::Property<double> m_smearing{this, "smearing", 0.01 /* 1 percent*/};
+  Gaudi::Property<std::vector<double>> m_momentumResolution{this, "momentumResolution", {}};
+  Gaudi::Property<std::vector<double>> m_thetaResolution{this, "thetaResolution", {0.}};
+  Gaudi::Property<std::vector<double>> m_phiResolution{this, "phiResolution", {0.}};
+  Gaudi::Property<std::vector<double>> m_vertexResolution{this, "vertexResolution", {0.}};
+  Gaudi::Property<std::string> m_randomSvcName{this, "randomServiceName", "RandomSvc"};
+  // Events of the batch of the input particles, and of the output particles, in the batched mode
+  Gaudi::Property<std::string> m_inputEventBatch{this, "inputEventBatch", ""};
+  Gaudi::Property<std::string> m_outputEventBatch{this, "outputEventBatch", "SmearedParticlesBatch"};
+  std::unique_ptr<DataHandle<std::vector<unsigned long>>> m_inputBatch_ptr;
+  std::unique_ptr<DataHandle<std::vector<unsigned long>>> m_outputBatch_ptr;
+  // Primaries from the truth index of the event (TruthParticleIndexer), instead of scanning the particles
+  Gaudi::Property<std::string> m_inputTruthIndex{this, "inputTruthIndex", ""};
+  std::unique_ptr<DataHandle<TruthParticleIndex>> m_truthIndex_ptr;
+
+  SmartIF<IRandomSvc> m_randomSvc;
+  SmearingModel m_model;
+  ParticleSmearing m_smear;
 
 public:
   MC2SmearedParticle(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
     declareProperty("inputParticles", m_inputMCParticles, "MCParticles");
     declareProperty("outputParticles", m_outputParticles, "SmearedReconstructedParticles");
+    declareProperty("outputAssociations", m_outputAssocCollection, "SmearedParticleAssociations");
   }
   StatusCode initialize() override {
     if (GaudiAlgorithm::initialize().isFailure()) {
       return StatusCode::FAILURE;
     }
-
-    IRndmGenSvc* randSvc = svc<IRndmGenSvc>("RndmGenSvc", true);
-    StatusCode sc        = m_gaussDist.initialize(randSvc, Rndm::Gauss(1.0, m_smearing.value()));
-    if (!sc.isSuccess()) {
+    m_randomSvc = service(m_randomSvcName);
+    if (!m_randomSvc) {
+      error() << "Unable to locate Random Service. "
+              << "Make sure you have RandomSvc in the configuration." << endmsg;
+      return StatusCode::FAILURE;
+    }
+    const std::vector<double> momentum =
+        m_momentumResolution.value().empty() ? std::vector<double>{m_smearing.value()} : m_momentumResolution.value();
+    if (!m_model.momentum.configure(momentum) || !m_model.theta.configure(m_thetaResolution) ||
+        !m_model.phi.configure(m_phiResolution) || !m_model.vertex.configure(m_vertexResolution)) {
+      error() << "Resolutions need a single value or (p, sigma) pairs in increasing p." << endmsg;
       return StatusCode::FAILURE;
     }
+    // batched mode if requested
+    if (!m_inputEventBatch.value().empty()) {
+      m_inputBatch_ptr = std::make_unique<DataHandle<std::vector<unsigned long>>>(m_inputEventBatch,
+                                                                                    Gaudi::DataHandle::Reader, this);
+      m_outputBatch_ptr = std::make_unique<DataHandle<std::vector<unsigned long>>>(m_outputEventBatch,
+                                                                                     Gaudi::DataHandle::Writer, this);
+    }
+    if (!m_inputTruthIndex.value().empty()) {
+      m_truthIndex_ptr =
+          std::make_unique<DataHandle<TruthParticleIndex>>(m_inputTruthIndex, Gaudi::DataHandle::Reader, this);
+    }
     return StatusCode::SUCCESS;
   }
   StatusCode execute() override {
     // input collection
     const auto* const parts = m_inputMCParticles.get();
-    // output collection
-    auto& out_parts = *(m_outputParticles.createAndPut());
-    for (const auto& p : *parts) {
-      if (p.getGeneratorStatus() > 1) {
-        if (msgLevel(MSG::DEBUG)) {
-          debug() << "ignoring particle with generatorStatus = " << p.getGeneratorStatus() << endmsg;
-        }
-        continue;
+    // output collections
+    auto& out_parts = *(m_outputParticles.createAndPut(parts->size()));
+    auto& assoc     = *(m_outputAssocCollection.createAndPut(parts->size()));
+
+    // events of the input, a single one unless batched
+    Jug::Base::EventBatch batch;
+    if (m_inputBatch_ptr) {
+      if (!Jug::Base::EventBatch::decode(*m_inputBatch_ptr->get(), batch) || batch.begin.back() != parts->size()) {
+        error() << "Invalid event batch of the particles" << endmsg;
+        return StatusCode::FAILURE;
       }
+    } else {
+      batch.clear(Gaudi::Hive::currentContext().evt());
+      batch.add(parts->size());
+    }
 
-      // for now just use total momentum smearing as this is the largest effect,
-      // ideally we should also smear the angles but this should be good enough
-      // for now.
-      const auto pvec     = p.getMomentum();
-      const auto pgen     = std::hypot(pvec.x, pvec.y, pvec.z);
-      const auto momentum = pgen * m_gaussDist();
-      // make sure we keep energy consistent
-      using MomType        = decltype(eicd::ReconstructedParticle().getMomentum().x);
-      const MomType energy = std::sqrt(p.getEnergy() * p.getEnergy() - pgen * pgen + momentum * momentum);
-      const MomType px     = p.getMomentum().x * momentum / pgen;
-      const MomType py     = p.getMomentum().y * momentum / pgen;
-      const MomType pz     = p.getMomentum().z * momentum / pgen;
+    const TruthParticleIndex* truth = m_truthIndex_ptr ? m_truthIndex_ptr->get() : nullptr;
 
-      const MomType dpx = m_smearing.value() * px;
-      const MomType dpy = m_smearing.value() * py;
-      const MomType dpz = m_smearing.value() * pz;
-      const MomType dE  = m_smearing.value() * energy;
-      // ignore covariance for now
-      // @TODO: vertex smearing
-      const MomType vx = p.getVertex().x;
-      const MomType vy = p.getVertex().y;
-      const MomType vz = p.getVertex().z;
+    // gather the particles to smear, and smear them event by event
+    m_smear.clear();
+    m_smear.reserve(parts->size());
+    Jug::Base::EventBatch outBatch;
+    outBatch.clear(batch.firstEntry);
+    for (size_t e = 0; e < batch.size(); ++e) {
+      const size_t first      = m_smear.size();
+      const auto [begin, end] = batch.range(e);
+      auto add                = [&](size_t i) {
+        const auto& p   = (*parts)[i];
+        const auto& mom = p.getMomentum();
+        const auto& vtx = p.getVertex();
+        m_smear.add(i, mom.x, mom.y, mom.z, p.getEnergy(), vtx.x, vtx.y, vtx.z);
+      };
+      if (truth != nullptr) {
+        const auto [first_primary, last_primary] = TruthParticleIndex::range(truth->primaries, begin, end);
+        std::for_each(first_primary, last_primary, add);
+      } else {
+        for (size_t i = begin; i < end; ++i) {
+          const auto& p = (*parts)[i];
+          if (p.getGeneratorStatus() > 1) {
+            if (msgLevel(MSG::DEBUG)) {
+              debug() << "ignoring particle with generatorStatus = " << p.getGeneratorStatus() << endmsg;
+            }
+            continue;
+          }
+          add(i);
+        }
+      }
+      const auto key = m_randomSvc->eventKey(name(), batch.firstEntry + e);
+      m_smear.smear(m_model, key, 0, first, m_smear.size());
+      outBatch.add(m_smear.size());
+    }
+    if (m_outputBatch_ptr) {
+      m_outputBatch_ptr->put(new std::vector<unsigned long>(outBatch.encode()));
+    }
+
+    using MomType = decltype(eicd::ReconstructedParticle().getMomentum().x);
+    for (size_t k = 0; k < m_smear.size(); ++k) {
+      const auto& p     = (*parts)[m_smear.index(k)];
+      const auto& s     = m_smear.smeared(k);
+      const auto energy = static_cast<MomType>(s.energy);
+      const auto px     = static_cast<MomType>(s.px);
+      const auto py     = static_cast<MomType>(s.py);
+      const auto pz     = static_cast<MomType>(s.pz);
+      // relative momentum resolution on the components, no correlations
+      const auto sigma  = static_cast<MomType>(m_smear.sigma(k));
 
       auto rec_part = out_parts.create();
       rec_part.setType(-1); // @TODO: determine type codes
       rec_part.setEnergy(energy);
       rec_part.setMomentum({px, py, pz});
-      rec_part.setReferencePoint({vx, vy, vz}); // @FIXME: probably not what we want?
+      rec_part.setReferencePoint({static_cast<MomType>(s.vx), static_cast<MomType>(s.vy),
+                                  static_cast<MomType>(s.vz)}); // @FIXME: probably not what we want?
       rec_part.setCharge(p.getCharge());
       rec_part.setMass(p.getMass());
       rec_part.setGoodnessOfPID(1); // Perfect PID
-      rec_part.setCovMatrix({dpx, dpy, dpz, dE});
+      rec_part.setCovMatrix({sigma * px, sigma * py, sigma * pz, sigma * energy});
       rec_part.setPDG(p.getPDG());
+
+      auto rec_assoc = assoc.create();
+      rec_assoc.setRecID(rec_part.getObjectID().index);
+      rec_assoc.setSimID(p.getObjectID().index);
+      rec_assoc.setWeight(1);
+      rec_assoc.setRec(rec_part);
     }
     return StatusCode::SUCCESS;
   }
@@ -0,0 +1,169 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Gaudi/Property.h"
+#include "GaudiAlg/GaudiAlgorithm.h"
+#include "GaudiKernel/IEventProcessor.h"
+
+#include "podio/EventStore.h"
+#include "podio/ROOTReader.h"
+
+#include "JugBase/DataHandle.h"
+#include "JugBase/Utilities/EventBatch.h"
+
+#include "edm4hep/MCParticleCollection.h"
+
+namespace Jug::Fast {
+
+/** Batched input of the generated particles, for the fast simulation chain.
+ *
+ *  Reads batchSize events of MCParticles from the input files per framework event (instead of
+ *  PodioInput and the input of the data service) and concatenates them in one collection, with the
+ *  events of the batch in outputEventBatch (Jug::Base::EventBatch). The algorithms of the chain
+ *  with an inputEventBatch process the events of the batch one after the other, and the output
+ *  holds one entry per batch, so that the per-event overhead of the framework is paid once per
+ *  batch. The parents and daughters are kept within each event.
+ *
+ *  The input is read sequentially (one event slot), the run stops after the last batch.
+ *
+ * \ingroup fast
+ */
+class MCParticleBatchInput : public GaudiAlgorithm {
+private:
+  Gaudi::Property<std::vector<std::string>> m_inputs{this, "inputs", {}, "Names of the files to read"};
+  Gaudi::Property<std::string> m_collection{this, "collection", "MCParticles", "Particle collection of the files"};
+  Gaudi::Property<unsigned> m_batchSize{this, "batchSize", 1000, "Number of input events per batch"};
+  Gaudi::Property<long long> m_maxEvents{this, "maxEvents", -1, "Number of input events to read, all if negative"};
+  DataHandle<edm4hep::MCParticleCollection> m_outputParticles{"MCParticles", Gaudi::DataHandle::Writer, this};
+  DataHandle<std::vector<unsigned long>> m_outputBatch{"MCParticlesBatch", Gaudi::DataHandle::Writer, this};
+
+  std::unique_ptr<podio::ROOTReader> m_reader;
+  std::unique_ptr<podio::EventStore> m_store;
+  size_t m_file{0};
+  unsigned m_fileEntry{0};
+  uint64_t m_entry{0};
+
+public:
+  MCParticleBatchInput(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
+    declareProperty("outputParticles", m_outputParticles, "MCParticles");
+    declareProperty("outputEventBatch", m_outputBatch, "MCParticlesBatch");
+  }
+
+  StatusCode initialize() override {
+    if (GaudiAlgorithm::initialize().isFailure()) {
+      return StatusCode::FAILURE;
+    }
+    if (m_inputs.value().empty() || m_batchSize.value() == 0) {
+      error() << "Batches need input files and a batchSize of at least 1" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    openFile(0);
+    if (atEnd()) {
+      error() << "No events in the input files" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    return StatusCode::SUCCESS;
+  }
+
+  StatusCode execute() override {
+    auto& parts = *(m_outputParticles.createAndPut());
+    Jug::Base::EventBatch batch;
+    batch.clear(m_entry);
+    std::vector<edm4hep::MCParticle> event;
+    while (batch.size() < m_batchSize.value() && !atEnd()) {
+      const edm4hep::MCParticleCollection* input = nullptr;
+      if (m_reader->getCollectionIDTable()->present(m_collection) && m_store->get(m_collection, input)) {
+        // members first, then the relations by index in the event
+        event.clear();
+        for (const auto& p : *input) {
+          auto q = parts.create();
+          q.setPDG(p.getPDG());
+          q.setGeneratorStatus(p.getGeneratorStatus());
+          q.setSimulatorStatus(p.getSimulatorStatus());
+          q.setCharge(p.getCharge());
+          q.setTime(p.getTime());
+          q.setMass(p.getMass());
+          q.setVertex(p.getVertex());
+          q.setEndpoint(p.getEndpoint());
+          q.setMomentum(p.getMomentum());
+          q.setMomentumAtEndpoint(p.getMomentumAtEndpoint());
+          q.setSpin(p.getSpin());
+          q.setColorFlow(p.getColorFlow());
+          event.push_back(q);
+        }
+        for (size_t i = 0; i < input->size(); ++i) {
+          for (const auto& parent : (*input)[i].getParents()) {
+            event[i].addToParents(event[parent.getObjectID().index]);
+          }
+          for (const auto& daughter : (*input)[i].getDaughters()) {
+            event[i].addToDaughters(event[daughter.getObjectID().index]);
+          }
+        }
+      }
+      batch.add(parts.size());
+      nextEntry();
+    }
+    m_outputBatch.put(new std::vector<unsigned long>(batch.encode()));
+    if (msgLevel(MSG::DEBUG)) {
+      debug() << "Batch of " << batch.size() << " events from entry " << batch.firstEntry << ", " << parts.size()
+              << " particles" << endmsg;
+    }
+    if (atEnd()) {
+      info() << "Reached the end of the input with entry " << m_entry << endmsg;
+      return service<IEventProcessor>("ApplicationMgr")->stopRun();
+    }
+    return StatusCode::SUCCESS;
+  }
+
+  StatusCode finalize() override {
+    if (m_reader) {
+      m_reader->closeFile();
+    }
+    return GaudiAlgorithm::finalize();
+  }
+
+private:
+  /// Open the next file with events at or after file, none after the last one
+  void openFile(size_t file) {
+    if (m_reader) {
+      m_reader->closeFile();
+    }
+    m_file      = file;
+    m_fileEntry = 0;
+    if (m_file >= m_inputs.value().size()) {
+      m_store.reset();
+      m_reader.reset();
+      return;
+    }
+    m_reader = std::make_unique<podio::ROOTReader>();
+    m_reader->openFile(m_inputs.value()[m_file]);
+    m_store = std::make_unique<podio::EventStore>();
+    m_store->setReader(m_reader.get());
+    // files without events are skipped
+    if (m_reader->getEntries() == 0) {
+      openFile(m_file + 1);
+    }
+  }
+
+  bool atEnd() const {
+    return !m_reader || (m_maxEvents.value() >= 0 && m_entry >= static_cast<uint64_t>(m_maxEvents.value()));
+  }
+
+  void nextEntry() {
+    m_store->clear();
+    m_reader->endOfEvent();
+    ++m_entry;
+    if (++m_fileEntry >= m_reader->getEntries()) {
+      openFile(m_file + 1);
+    }
+  }
+};
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(MCParticleBatchInput)
+
+} // namespace Jug::Fast
@@ -4,9 +4,22 @@
 // Takes a list of particles (presumed to be from tracking), and all available clusters.
 // 1. Match clusters to their tracks using the mcID field
 // 2. For unmatched clusters create neutrals and add to the particle list
+//
+// With useTrackProjections, the clusters are matched to the track projections to the calorimeter
+// faces instead (TrackSurfaceProjector, one track segment per particle in particle order): the
+// clusters of every calorimeter are indexed by (eta, phi) cell, the track points look up the
+// clusters within maxDeltaR, and the closest track-cluster pairs are assigned first, at most one
+// cluster per calorimeter for every track. The matched clusters are added to the charged
+// particles, the others become unidentified neutrals. No MC truth is used, and the output
+// associations are empty.
 
 #include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstdint>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
 
 #include <fmt/format.h>
 
@@ -17,6 +30,9 @@
 #include "GaudiKernel/RndmGenerators.h"
 
 #include "JugBase/DataHandle.h"
+#include "JugBase/DataHandleArray.h"
+#include "JugBase/Logging.h"
+#include "JugBase/Utilities/SpatialIndex.h"
 
 // Event Model related classes
 #include "edm4hep/MCParticleCollection.h"
@@ -25,6 +41,7 @@
 #include "eicd/MCRecoParticleAssociationCollection.h"
 #include "eicd/ReconstructedParticleCollection.h"
 #include "eicd/TrackParametersCollection.h"
+#include "eicd/TrackSegmentCollection.h"
 #include "eicd/vector_utils.h"
 
 namespace Jug::Fast {
@@ -37,10 +54,21 @@ private:
                                                                     Gaudi::DataHandle::Reader, this};
   DataHandle<eicd::MCRecoParticleAssociationCollection> m_inputParticlesAssoc{"ReconstructedChargedParticlesAssoc",
                                                                     Gaudi::DataHandle::Reader, this};
-  Gaudi::Property<std::vector<std::string>> m_inputClusters{this, "inputClusters", {}, "Clusters to be aggregated"};
-  Gaudi::Property<std::vector<std::string>> m_inputClustersAssoc{this, "inputClustersAssoc", {}, "Cluster associations to be aggregated"};
-  std::vector<DataHandle<eicd::ClusterCollection>*> m_inputClustersCollections;
-  std::vector<DataHandle<eicd::MCRecoClusterParticleAssociationCollection>*> m_inputClustersAssocCollections;
+  using ClusterHandles     = Jug::Base::DataHandleArray<eicd::ClusterCollection>;
+  using ClusterAssocHandles = Jug::Base::DataHandleArray<eicd::MCRecoClusterParticleAssociationCollection>;
+  ClusterHandles m_inputClustersCollections{this, "inputClusters", "Clusters to be aggregated"};
+  ClusterAssocHandles m_inputClustersAssocCollections{this, "inputClustersAssoc",
+                                                      "Cluster associations to be aggregated"};
+
+  // Also run the scans over all associations, and warn if they disagree with the indexed lookups
+  Gaudi::Property<bool> m_validateLookup{this, "validateLookup", false};
+
+  // Reco-level matching to the track projections, within maxDeltaR in (eta, phi)
+  DataHandle<eicd::TrackSegmentCollection> m_inputTrackSegments{"inputTrackSegments", Gaudi::DataHandle::Reader,
+                                                                this};
+  Gaudi::Property<bool> m_useTrackProjections{this, "useTrackProjections", false,
+                                              "Match the clusters to inputTrackSegments instead of the MC truth"};
+  Gaudi::Property<double> m_maxDeltaR{this, "maxDeltaR", 0.05, "Largest (eta, phi) distance of a matched cluster"};
 
   // output data
   DataHandle<eicd::ReconstructedParticleCollection> m_outputParticles{"ReconstructedParticles",
@@ -56,20 +84,30 @@ public:
     declareProperty("inputParticlesAssoc", m_inputParticlesAssoc, "ReconstructedChargedParticlesAssoc");
     declareProperty("outputParticles", m_outputParticles, "ReconstructedParticles");
     declareProperty("outputParticlesAssoc", m_outputParticlesAssoc, "ReconstructedParticlesAssoc");
+    declareProperty("inputTrackSegments", m_inputTrackSegments, "Track projections to the calorimeters");
   }
 
   StatusCode initialize() override {
     if (GaudiAlgorithm::initialize().isFailure()) {
       return StatusCode::FAILURE;
     }
-    m_inputClustersCollections = getClusterCollections(m_inputClusters);
-    m_inputClustersAssocCollections = getClusterAssociations(m_inputClustersAssoc);
+    for (const auto& colname : m_inputClustersCollections.keys()) {
+      JUG_DEBUG("initializing cluster collection: " << colname);
+    }
+    for (const auto& colname : m_inputClustersAssocCollections.keys()) {
+      JUG_DEBUG("initializing cluster association collection: " << colname);
+    }
     return StatusCode::SUCCESS;
   }
   StatusCode execute() override {
     if (msgLevel(MSG::DEBUG)) {
       debug() << "Processing cluster info for new event" << endmsg;
     }
+    if (m_useTrackProjections) {
+      m_outputParticlesAssoc.createAndPut();
+      matchProjections(*(m_inputParticles.get()), *(m_inputTrackSegments.get()), *(m_outputParticles.createAndPut()));
+      return StatusCode::SUCCESS;
+    }
     // input collection
     const auto& mcparticles  = *(m_inputMCParticles.get());
     const auto& inparts      = *(m_inputParticles.get());
@@ -77,6 +115,10 @@ public:
     auto& outparts           = *(m_outputParticles.createAndPut());
     auto& outpartsassoc      = *(m_outputParticlesAssoc.createAndPut());
 
+    // index of the particle associations
+    std::unordered_map<uint64_t, int> partsMcID;
+    indexAssociations(inpartsassoc, partsMcID);
+
     if (msgLevel(MSG::DEBUG)) {
       debug() << "Step 0/2: Getting indexed list of clusters..." << endmsg;
     }
@@ -100,13 +142,20 @@ public:
       auto outpart = inpart.clone();
       outparts.push_back(outpart);
 
-      int mcID = -1;
-
       // find associated particle
-      for (const auto& assoc: inpartsassoc) {
-        if (assoc.getRec() == inpart) {
-          mcID = assoc.getSimID();
-          break;
+      const auto it = partsMcID.find(objectKey(inpart.getObjectID()));
+      const int mcID = (it != partsMcID.end()) ? it->second : -1;
+      if (m_validateLookup) {
+        int scanID = -1;
+        for (const auto& assoc: inpartsassoc) {
+          if (assoc.getRec() == inpart) {
+            scanID = assoc.getSimID();
+            break;
+          }
+        }
+        if (scanID != mcID) {
+          warning() << "Indexed mcID " << mcID << " of particle " << inpart.getObjectID().index
+                    << " differs from the scanned mcID " << scanID << endmsg;
         }
       }
 
@@ -183,57 +232,136 @@ public:
   }
 
 private:
-  std::vector<DataHandle<eicd::ClusterCollection>*> getClusterCollections(const std::vector<std::string>& cols) {
-    std::vector<DataHandle<eicd::ClusterCollection>*> ret;
-    for (const auto& colname : cols) {
-      debug() << "initializing cluster collection: " << colname << endmsg;
-      ret.push_back(new DataHandle<eicd::ClusterCollection>{colname, Gaudi::DataHandle::Reader, this});
+  // reco-level matching of the clusters to the track projections
+  void matchProjections(const eicd::ReconstructedParticleCollection& inparts,
+                        const eicd::TrackSegmentCollection& segments,
+                        eicd::ReconstructedParticleCollection& outparts) {
+    std::vector<eicd::MutableReconstructedParticle> charged;
+    charged.reserve(inparts.size());
+    for (const auto& inpart : inparts) {
+      charged.push_back(inpart.clone());
+      outparts.push_back(charged.back());
+    }
+    const bool paired = (segments.size() == inparts.size());
+    if (!paired) {
+      warning() << segments.size() << " track segments for " << inparts.size()
+                << " particles, the clusters are not matched" << endmsg;
     }
-    return ret;
-  }
 
-  std::vector<DataHandle<eicd::MCRecoClusterParticleAssociationCollection>*> getClusterAssociations(const std::vector<std::string>& cols) {
-    std::vector<DataHandle<eicd::MCRecoClusterParticleAssociationCollection>*> ret;
-    for (const auto& colname : cols) {
-      debug() << "initializing cluster association collection: " << colname << endmsg;
-      ret.push_back(new DataHandle<eicd::MCRecoClusterParticleAssociationCollection>{colname, Gaudi::DataHandle::Reader, this});
+    const double maxDeltaR = m_maxDeltaR.value();
+    struct Candidate {
+      double dr2;
+      uint32_t track;
+      uint32_t cluster;
+    };
+    std::vector<Candidate> candidates;
+    std::vector<double> eta;
+    std::vector<double> phi;
+    size_t nmatched = 0;
+    size_t nneutral = 0;
+    for (const auto* collection : m_inputClustersCollections.get()) {
+      const auto& clusters = *collection;
+      const size_t nclusters = clusters.size();
+
+      // (eta, phi) cell index of the clusters of the calorimeter
+      eta.resize(nclusters);
+      phi.resize(nclusters);
+      for (size_t i = 0; i < nclusters; ++i) {
+        const auto position = clusters[i].getPosition();
+        eta[i]              = std::asinh(position.z / std::hypot(position.x, position.y));
+        phi[i]              = std::atan2(position.y, position.x);
+      }
+      Jug::Base::SpatialPoints<2> points{{eta.data(), phi.data()}, nclusters, {0., 2 * M_PI}};
+      Jug::Base::CellList<2> index;
+      index.build(points, {maxDeltaR, maxDeltaR});
+
+      // the clusters near the track points, closest first
+      candidates.clear();
+      for (uint32_t t = 0; paired && t < segments.size(); ++t) {
+        const auto segment = segments[t];
+        for (unsigned int k = 0; k < segment.points_size(); ++k) {
+          const auto position = segment.getPoints(k).position;
+          const std::array<double, 2> point{std::asinh(position.z / std::hypot(position.x, position.y)),
+                                            std::atan2(position.y, position.x)};
+          index.forEachWithin(point, maxDeltaR, [&](uint32_t i, double d2) { candidates.push_back({d2, t, i}); });
+        }
+      }
+      std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        return std::tie(a.dr2, a.track, a.cluster) < std::tie(b.dr2, b.track, b.cluster);
+      });
+
+      std::vector<char> trackMatched(charged.size(), 0);
+      std::vector<char> clusterMatched(nclusters, 0);
+      for (const auto& candidate : candidates) {
+        if (trackMatched[candidate.track] != 0 || clusterMatched[candidate.cluster] != 0) {
+          continue;
+        }
+        trackMatched[candidate.track]     = 1;
+        clusterMatched[candidate.cluster] = 1;
+        charged[candidate.track].addToClusters(clusters[candidate.cluster]);
+        ++nmatched;
+      }
+      for (size_t i = 0; i < nclusters; ++i) {
+        if (clusterMatched[i] == 0) {
+          outparts.push_back(reconstruct_neutral(clusters[i], 0, 0));
+          ++nneutral;
+        }
+      }
+    }
+    if (msgLevel(MSG::DEBUG)) {
+      debug() << nmatched << " clusters matched to " << charged.size() << " charged particles, " << nneutral
+              << " neutrals" << endmsg;
     }
-    return ret;
   }
 
   // get a map of mcID --> cluster
   // input: cluster_collections --> list of handles to all cluster collections
   std::map<int, eicd::Cluster>
   indexedClusters(
-      const std::vector<DataHandle<eicd::ClusterCollection>*>& cluster_collections,
-      const std::vector<DataHandle<eicd::MCRecoClusterParticleAssociationCollection>*>& associations_collections
-  ) const {
+      ClusterHandles& cluster_collections,
+      ClusterAssocHandles& associations_collections
+  ) {
     std::map<int, eicd::Cluster> matched = {};
 
+    // index of the cluster associations, the first association of a cluster in the order of the
+    // association collections gives its mcID
+    std::unordered_map<uint64_t, int> clustersMcID;
+    const auto& associations = associations_collections.get();
+    for (const auto* assocs : associations) {
+      indexAssociations(*assocs, clustersMcID);
+    }
+
     // loop over cluster collections
-    for (const auto& cluster_handle : cluster_collections) {
-      const auto& clusters = *(cluster_handle->get());
+    for (const auto* collection : cluster_collections.get()) {
+      const auto& clusters = *collection;
 
       // loop over clusters
       for (const auto& cluster : clusters) {
 
-        int mcID = -1;
+        const auto it  = clustersMcID.find(objectKey(cluster.getObjectID()));
+        const int mcID = (it != clustersMcID.end()) ? it->second : -1;
 
-        // loop over association collections
-        for (const auto& associations_handle : associations_collections) {
-          const auto& associations = *(associations_handle->get());
+        if (m_validateLookup) {
+          int scanID = -1;
+          // loop over association collections
+          for (const auto* assocs : associations) {
+
+            // find associated particle
+            for (const auto& assoc : *assocs) {
+              if (assoc.getRec() == cluster) {
+                scanID = assoc.getSimID();
+                break;
+              }
+            }
 
-          // find associated particle
-          for (const auto& assoc : associations) {
-            if (assoc.getRec() == cluster) {
-              mcID = assoc.getSimID();
+            // found associated particle
+            if (scanID != -1) {
               break;
             }
           }
-
-          // found associated particle
-          if (mcID != -1) {
-            break;
+          if (scanID != mcID) {
+            warning() << "Indexed mcID " << mcID << " of cluster " << cluster.getObjectID().index
+                      << " differs from the scanned mcID " << scanID << endmsg;
           }
         }
 
@@ -264,6 +392,23 @@ private:
     return matched;
   }
 
+  // key of a reconstructed object, unique across collections
+  static uint64_t objectKey(const podio::ObjectID& id) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(id.collectionID)) << 32) | static_cast<uint32_t>(id.index);
+  }
+
+  // add the rec object --> simID of the associations, keeping the first simID of every object
+  template <typename AssociationCollection>
+  static void indexAssociations(const AssociationCollection& associations, std::unordered_map<uint64_t, int>& mcIDs) {
+    mcIDs.reserve(mcIDs.size() + associations.size());
+    for (const auto& assoc : associations) {
+      const auto rec = assoc.getRec();
+      if (rec.isAvailable()) {
+        mcIDs.emplace(objectKey(rec.getObjectID()), assoc.getSimID());
+      }
+    }
+  }
+
   // reconstruct a neutral cluster
   // (for now assuming the vertex is at (0,0,0))
   eicd::ReconstructedParticle reconstruct_neutral(const eicd::Cluster& clus, const double mass,
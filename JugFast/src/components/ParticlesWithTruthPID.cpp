@@ -3,6 +3,9 @@
 
 #include <algorithm>
 #include <cmath>
+#include <limits>
+#include <memory>
+#include <vector>
 
 #include <fmt/format.h>
 
@@ -13,6 +16,7 @@
 #include "GaudiKernel/RndmGenerators.h"
 
 #include "JugBase/DataHandle.h"
+#include "JugBase/TruthParticleIndex.h"
 
 // Event Model related classes
 #include "edm4hep/MCParticleCollection.h"
@@ -39,6 +43,12 @@ private:
   Gaudi::Property<double> m_phiTolerance{this, "phiTolerance", {0.030}};
   // Matchin eta tolerance of 0.1
   Gaudi::Property<double> m_etaTolerance{this, "etaTolerance", {0.2}};
+  // Search the candidates in the phi window of the track, instead of all MC particles
+  Gaudi::Property<bool> m_indexedMatching{this, "indexedMatching", true};
+  // Candidates from the truth index of the event (TruthParticleIndexer) in the indexed matching,
+  // instead of scanning the MCParticles
+  Gaudi::Property<std::string> m_inputTruthIndex{this, "inputTruthIndex", ""};
+  std::unique_ptr<DataHandle<TruthParticleIndex>> m_truthIndex_ptr;
 
 public:
   ParticlesWithTruthPID(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
@@ -51,50 +61,131 @@ public:
     if (GaudiAlgorithm::initialize().isFailure()) {
       return StatusCode::FAILURE;
     }
+    if (!m_inputTruthIndex.value().empty()) {
+      m_truthIndex_ptr =
+          std::make_unique<DataHandle<TruthParticleIndex>>(m_inputTruthIndex, Gaudi::DataHandle::Reader, this);
+    }
     return StatusCode::SUCCESS;
   }
   StatusCode execute() override {
     // input collection
     const auto& mc     = *(m_inputTruthCollection.get());
     const auto& tracks = *(m_inputTrackCollection.get());
-    auto& part         = *(m_outputParticleCollection.createAndPut());
-    auto& assoc        = *(m_outputAssocCollection.createAndPut());
+    auto& part         = *(m_outputParticleCollection.createAndPut(tracks.size()));
+    auto& assoc        = *(m_outputAssocCollection.createAndPut(tracks.size()));
 
     const double sinPhiOver2Tolerance = sin(0.5 * m_phiTolerance);
     std::vector<bool> consumed(mc.size(), false);
+
+    // charged primaries, (p, phi, eta) computed once and sorted by phi
+    struct Candidates {
+      std::vector<double> phi;
+      std::vector<double> eta;
+      std::vector<double> p;
+      std::vector<float> charge;
+      std::vector<size_t> index;
+    } cands;
+    if (m_indexedMatching && m_truthIndex_ptr) {
+      const auto& truth = *(m_truthIndex_ptr->get());
+      std::vector<size_t> primaries(truth.chargedPrimaries.begin(), truth.chargedPrimaries.end());
+      std::sort(primaries.begin(), primaries.end(),
+                [&](size_t a, size_t b) { return truth.phi[a] < truth.phi[b]; });
+      for (size_t ip : primaries) {
+        cands.phi.push_back(truth.phi[ip]);
+        cands.eta.push_back(truth.eta[ip]);
+        cands.p.push_back(truth.p[ip]);
+        cands.charge.push_back(truth.charge[ip]);
+        cands.index.push_back(ip);
+      }
+    } else if (m_indexedMatching) {
+      std::vector<size_t> primaries;
+      std::vector<double> phis(mc.size());
+      for (size_t ip = 0; ip < mc.size(); ++ip) {
+        if (mc[ip].getGeneratorStatus() <= 1 && mc[ip].getCharge() != 0) {
+          const auto& p = mc[ip].getMomentum();
+          phis[ip]      = std::atan2(p.y, p.x);
+          primaries.push_back(ip);
+        }
+      }
+      std::sort(primaries.begin(), primaries.end(), [&](size_t a, size_t b) { return phis[a] < phis[b]; });
+      for (size_t ip : primaries) {
+        const auto& p    = mc[ip].getMomentum();
+        const auto p_mag = std::hypot(p.x, p.y, p.z);
+        cands.phi.push_back(phis[ip]);
+        cands.eta.push_back(std::atanh(p.z / p_mag));
+        cands.p.push_back(p_mag);
+        cands.charge.push_back(mc[ip].getCharge());
+        cands.index.push_back(ip);
+      }
+    }
+
     for (const auto& trk : tracks) {
       const auto mom        = eicd::sphericalToVector(1.0 / std::abs(trk.getQOverP()), trk.getTheta(), trk.getPhi());
       const auto charge_rec = trk.getCharge();
+      const double mom_mag  = eicd::magnitude(mom);
+      const double mom_phi  = eicd::angleAzimuthal(mom);
+      const double mom_eta  = eicd::eta(mom);
       // utility variables for matching
       int best_match    = -1;
       double best_delta = std::numeric_limits<double>::max();
-      for (size_t ip = 0; ip < mc.size(); ++ip) {
-        const auto& mcpart = mc[ip];
-        if (consumed[ip] || mcpart.getGeneratorStatus() > 1 || mcpart.getCharge() == 0 ||
-            mcpart.getCharge() * charge_rec < 0) {
-          if (msgLevel(MSG::DEBUG)) {
-            debug() << "ignoring non-primary/neutral/opposite charge particle" << endmsg;
-          }
-          continue;
-        }
-        const auto& p       = mcpart.getMomentum();
-        const auto p_mag    = std::hypot(p.x, p.y, p.z);
-        const auto p_phi    = std::atan2(p.y, p.x);
-        const auto p_eta    = std::atanh(p.z / p_mag);
-        const double dp_rel = std::abs((eicd::magnitude(mom) - p_mag) / p_mag);
+      auto consider     = [&](size_t ip, double p_mag, double p_phi, double p_eta) {
+        const double dp_rel = std::abs((mom_mag - p_mag) / p_mag);
         // check the tolerance for sin(dphi/2) to avoid the hemisphere problem and allow
         // for phi rollovers
-        const double dsphi = std::abs(sin(0.5 * (eicd::angleAzimuthal(mom) - p_phi)));
-        const double deta  = std::abs((eicd::eta(mom) - p_eta));
+        const double dsphi = std::abs(sin(0.5 * (mom_phi - p_phi)));
+        const double deta  = std::abs((mom_eta - p_eta));
 
         if (dp_rel < m_pRelativeTolerance && deta < m_etaTolerance && dsphi < sinPhiOver2Tolerance) {
           const double delta =
               std::hypot(dp_rel / m_pRelativeTolerance, deta / m_etaTolerance, dsphi / sinPhiOver2Tolerance);
-          if (delta < best_delta) {
+          // ties go to the first MC particle, as in the scan of all particles
+          if (delta < best_delta || (delta == best_delta && static_cast<int>(ip) < best_match)) {
             best_match = ip;
             best_delta = delta;
           }
         }
+      };
+
+      if (m_indexedMatching) {
+        // the phi window of the track, in up to two ranges if it rolls over; slightly wider,
+        // the candidates are checked with the same tolerances as above
+        auto scan = [&](double lo, double hi) {
+          auto first = std::lower_bound(cands.phi.begin(), cands.phi.end(), lo);
+          auto last  = std::upper_bound(first, cands.phi.end(), hi);
+          for (auto it = first; it != last; ++it) {
+            const size_t ic = it - cands.phi.begin();
+            const size_t ip = cands.index[ic];
+            if (!consumed[ip] && cands.charge[ic] * charge_rec >= 0) {
+              consider(ip, cands.p[ic], cands.phi[ic], cands.eta[ic]);
+            }
+          }
+        };
+        const double window = m_phiTolerance + 1e-9;
+        if (window >= M_PI) {
+          scan(-M_PI, M_PI);
+        } else {
+          scan(mom_phi - window, mom_phi + window);
+          if (mom_phi - window < -M_PI) {
+            scan(mom_phi - window + 2. * M_PI, M_PI);
+          }
+          if (mom_phi + window > M_PI) {
+            scan(-M_PI, mom_phi + window - 2. * M_PI);
+          }
+        }
+      } else {
+        for (size_t ip = 0; ip < mc.size(); ++ip) {
+          const auto& mcpart = mc[ip];
+          if (consumed[ip] || mcpart.getGeneratorStatus() > 1 || mcpart.getCharge() == 0 ||
+              mcpart.getCharge() * charge_rec < 0) {
+            if (msgLevel(MSG::DEBUG)) {
+              debug() << "ignoring non-primary/neutral/opposite charge particle" << endmsg;
+            }
+            continue;
+          }
+          const auto& p    = mcpart.getMomentum();
+          const auto p_mag = std::hypot(p.x, p.y, p.z);
+          consider(ip, p_mag, std::atan2(p.y, p.x), std::atanh(p.z / p_mag));
+        }
       }
       auto rec_part       = part.create();
       int32_t best_pid    = 0;
@@ -2,16 +2,22 @@
 // Copyright (C) 2022 Sylvester Joosten, Wouter Deconinck
 
 #include <algorithm>
+#include <array>
 #include <cmath>
+#include <memory>
 #include <fmt/format.h>
 
 #include "Gaudi/Algorithm.h"
 #include "GaudiAlg/GaudiTool.h"
 #include "GaudiAlg/Producer.h"
 #include "GaudiAlg/Transformer.h"
-#include "GaudiKernel/RndmGenerators.h"
+#include "GaudiKernel/ThreadLocalContext.h"
 
 #include "JugBase/DataHandle.h"
+#include "JugBase/EventFilter.h"
+#include "JugBase/IRandomSvc.h"
+#include "JugBase/TruthParticleIndex.h"
+#include "JugFast/ResponseMap.h"
 
 // Event Model related classes
 #include "edm4hep/MCParticleCollection.h"
@@ -25,6 +31,15 @@ enum DetectorTags { kTagB0 = 1, kTagRP = 2, kTagOMD = 3, kTagZDC = 4 };
 
 namespace Jug::Fast {
 
+/** Fast simulation of the far-forward detectors (ZDC, B0, Roman pots and off-momentum detectors).
+ *
+ *  The acceptance and resolution of a subsystem are either the parametrizations of eic_smear or,
+ *  when its responseMap file is set, the binned (theta, phi, p) maps of ResponseMap: the particles
+ *  of the map are then accepted with the acceptance of their bin and smeared in momentum and
+ *  angles with its resolutions, in the ion frame.
+ *
+ * \ingroup fast
+ */
 class SmearedFarForwardParticles : public GaudiAlgorithm {
 private:
   DataHandle<edm4hep::MCParticleCollection> m_inputMCParticles{"inputMCParticles", Gaudi::DataHandle::Reader, this};
@@ -40,6 +55,8 @@ private:
 
   // Beam energy, only used to determine the RP/OMD momentum ranges
   Gaudi::Property<double> m_ionBeamEnergy{this, "ionBeamEnergy", 0.};
+  // Reject the events without ion beam (found from the particles) instead of assuming 100 GeV
+  Gaudi::Property<bool> m_requireIonBeam{this, "requireIonBeam", false};
   // RP default to 10-on-100 setting
   // Pz > 60% of beam energy (60% x 100GeV = 60GeV)
   // theta from 0.2mrad -> 5mrad
@@ -64,7 +81,32 @@ private:
   Gaudi::Property<double> m_crossingAngle{this, "crossingAngle",
                                           -0.025}; //-0.025}; -- causes double rotation with afterburner
 
-  Rndm::Numbers m_gaussDist;
+  // Binned response maps, the parametrizations if empty
+  Gaudi::Property<std::string> m_responseMapZDC{this, "responseMapZDC", ""};
+  Gaudi::Property<std::string> m_responseMapB0{this, "responseMapB0", ""};
+  Gaudi::Property<std::string> m_responseMapRP{this, "responseMapRP", ""};
+  Gaudi::Property<std::string> m_responseMapOMD{this, "responseMapOMD", ""};
+
+  Gaudi::Property<std::string> m_randomSvcName{this, "randomServiceName", "RandomSvc"};
+  SmartIF<IRandomSvc> m_randomSvc;
+
+  // Beams and primaries from the truth index of the event (TruthParticleIndexer), instead of scanning
+  // the particles
+  Gaudi::Property<std::string> m_inputTruthIndex{this, "inputTruthIndex", ""};
+  std::unique_ptr<DataHandle<TruthParticleIndex>> m_truthIndex_ptr;
+  // primaries of the event, selected once for the detectors
+  std::vector<uint32_t> m_primaries;
+
+  // normal variates of the event, kNormals fixed slots per particle, and the acceptance uniforms
+  static constexpr size_t kNormals = 3;
+  std::vector<double> m_normals;
+  std::vector<double> m_uniforms;
+
+  // response maps by detector tag, and the rotations to and from the ion frame
+  std::array<ResponseMap, kTagZDC + 1> m_maps;
+  std::array<bool, kTagZDC + 1> m_mapped{};
+  double m_sinCrossing{0};
+  double m_cosCrossing{1};
 
   using RecPart = eicd::MutableReconstructedParticle;
   using Assoc   = eicd::MutableMCRecoParticleAssociation;
@@ -80,25 +122,51 @@ public:
     if (GaudiAlgorithm::initialize().isFailure()) {
       return StatusCode::FAILURE;
     }
-    IRndmGenSvc* randSvc = svc<IRndmGenSvc>("RndmGenSvc", true);
-    // use 0 for mean and 1 for standard deviation. Can rescale appropriately for the
-    // different subsystems
-    StatusCode sc = m_gaussDist.initialize(randSvc, Rndm::Gauss(0.0, 1.0));
-    if (!sc.isSuccess()) {
+    m_randomSvc = service(m_randomSvcName);
+    if (!m_randomSvc) {
+      error() << "Unable to locate Random Service. "
+              << "Make sure you have RandomSvc in the configuration." << endmsg;
       return StatusCode::FAILURE;
     }
+    m_sinCrossing = std::sin(m_crossingAngle);
+    m_cosCrossing = std::cos(m_crossingAngle);
+
+    const std::array<std::pair<DetectorTags, const Gaudi::Property<std::string>*>, 4> files{{{kTagZDC, &m_responseMapZDC},
+                                                                                            {kTagB0, &m_responseMapB0},
+                                                                                            {kTagRP, &m_responseMapRP},
+                                                                                            {kTagOMD, &m_responseMapOMD}}};
+    for (const auto& [tag, file] : files) {
+      if (file->value().empty()) {
+        continue;
+      }
+      std::string why;
+      if (!m_maps[tag].load(file->value(), why)) {
+        error() << "Invalid response map: " << why << endmsg;
+        return StatusCode::FAILURE;
+      }
+      m_mapped[tag] = true;
+      info() << fmt::format("Response map of {} filled bins from {}", m_maps[tag].filledBins(), file->value())
+             << endmsg;
+    }
+    if (!m_inputTruthIndex.value().empty()) {
+      m_truthIndex_ptr =
+          std::make_unique<DataHandle<TruthParticleIndex>>(m_inputTruthIndex, Gaudi::DataHandle::Reader, this);
+    }
     return StatusCode::SUCCESS;
   }
   StatusCode execute() override {
     const auto& mc = *(m_inputMCParticles.get());
     auto& rc       = *(m_outputParticles.createAndPut());
     auto& assoc    = *(m_outputAssocCollection.createAndPut());
+    const TruthParticleIndex* truth = m_truthIndex_ptr ? m_truthIndex_ptr->get() : nullptr;
 
     double ionBeamEnergy = 0;
     if (m_ionBeamEnergy > 0) {
       ionBeamEnergy = m_ionBeamEnergy;
     } else {
-      for (const auto& part : mc) {
+      const size_t ncandidates = (truth != nullptr) ? truth->beams.size() : mc.size();
+      for (size_t k = 0; k < ncandidates; ++k) {
+        const auto& part = mc[(truth != nullptr) ? truth->beams[k] : k];
         if (part.getGeneratorStatus() == 4 && part.getPDG() == 2212) {
           auto E = part.getEnergy();
           if (33 < E && E < 50) {
@@ -114,24 +182,52 @@ public:
           break;
         }
       }
+      if (ionBeamEnergy == 0 && m_requireIonBeam) {
+        return Jug::Base::rejectEvent(*this, "No incoming ion beam");
+      }
       if (ionBeamEnergy == 0) {
         warning() << "No incoming ion beam; using 100 GeV ion beam energy." << endmsg;
         ionBeamEnergy = 100;
       }
     }
 
+    if (truth != nullptr) {
+      m_primaries = truth->primaries;
+    } else {
+      m_primaries.clear();
+      for (size_t i = 0; i < mc.size(); ++i) {
+        if (mc[i].getGeneratorStatus() <= 1) {
+          m_primaries.push_back(static_cast<uint32_t>(i));
+        }
+      }
+    }
+
+    // the variates are drawn at once per detector, with one stream per detector tag
+    const auto key = m_randomSvc->eventKey(name(), Gaudi::Hive::currentContext().evt());
+    m_normals.resize(kNormals * mc.size());
+    auto draw = [&](DetectorTags tag) {
+      Jug::Base::Random::fill_normal(key, tag, m_normals.data(), m_normals.size());
+      return m_normals.data();
+    };
+    // the uniforms of the maps on streams after those of the normals
+    auto mapped = [&](DetectorTags tag) {
+      m_uniforms.resize(mc.size());
+      Jug::Base::Random::fill_uniform(key, (uint64_t{1} << 32) | tag, m_uniforms.data(), m_uniforms.size());
+      return responseMap(mc, tag, ionBeamEnergy, draw(tag));
+    };
+
     std::vector<std::vector<RecData>> rc_parts;
     if (m_enableZDC) {
-      rc_parts.push_back(zdc(mc, ionBeamEnergy));
+      rc_parts.push_back(m_mapped[kTagZDC] ? mapped(kTagZDC) : zdc(mc, ionBeamEnergy, draw(kTagZDC)));
     }
     if (m_enableRP) {
-      rc_parts.push_back(rp(mc, ionBeamEnergy));
+      rc_parts.push_back(m_mapped[kTagRP] ? mapped(kTagRP) : rp(mc, ionBeamEnergy, draw(kTagRP)));
     }
     if (m_enableB0) {
-      rc_parts.push_back(b0(mc, ionBeamEnergy));
+      rc_parts.push_back(m_mapped[kTagB0] ? mapped(kTagB0) : b0(mc, ionBeamEnergy, draw(kTagB0)));
     }
     if (m_enableOMD) {
-      rc_parts.push_back(omd(mc, ionBeamEnergy));
+      rc_parts.push_back(m_mapped[kTagOMD] ? mapped(kTagOMD) : omd(mc, ionBeamEnergy, draw(kTagOMD)));
     }
     for (const auto& det : rc_parts) {
       for (const auto& [part, link] : det) {
@@ -145,15 +241,12 @@ public:
 private:
   // ZDC smearing as in eic_smear
   // https://github.com/eic/eicsmeardetectors/blob/9a1831dd97bf517b80a06043b9ee4bfb96b483d8/SmearMatrixDetector_0_1_FF.cxx#L224
-  std::vector<RecData> zdc(const edm4hep::MCParticleCollection& mc, const double /* ionBeamEnergy */) {
+  std::vector<RecData> zdc(const edm4hep::MCParticleCollection& mc, const double /* ionBeamEnergy */,
+                           const double* normals) {
     std::vector<RecData> rc;
-    for (const auto& part : mc) {
-      if (part.getGeneratorStatus() > 1) {
-        if (msgLevel(MSG::DEBUG)) {
-          debug() << "ignoring particle with generatorStatus = " << part.getGeneratorStatus() << endmsg;
-        }
-        continue;
-      }
+    for (const size_t i : m_primaries) {
+      const auto& part = mc[i];
+      const double* g  = normals + kNormals * i;
       // only detect neutrons and photons
       const auto mom_ion = rotateLabToIonDirection(part.getMomentum());
       if (part.getPDG() != 2112 && part.getPDG() != 22) {
@@ -182,10 +275,10 @@ private:
 
       // explicit double precision due to E*E - m*m
       const double E    = part.getEnergy();
-      const double dE   = sqrt((conTerm * E) * (conTerm * E) + stoTerm * stoTerm * E) * m_gaussDist(); // 50%/SqrtE + 5%
+      const double dE   = sqrt((conTerm * E) * (conTerm * E) + stoTerm * stoTerm * E) * g[0]; // 50%/SqrtE + 5%
       const double Es   = E + dE;
       const double th   = mom_ion_theta;
-      const double dth  = (angTerm / sqrt(E)) * m_gaussDist();
+      const double dth  = (angTerm / sqrt(E)) * g[1];
       const double ths  = th + dth;
       const double phi  = mom_ion_phi;
       const double dphi = 0;
@@ -229,15 +322,12 @@ private:
   }
   // Fast B0 as in
   // https://github.com/eic/eicsmeardetectors/blob/9a1831dd97bf517b80a06043b9ee4bfb96b483d8/SmearMatrixDetector_0_1_FF.cxx#L254
-  std::vector<RecData> b0(const edm4hep::MCParticleCollection& mc, const double /* ionBeamEnergy */) {
+  std::vector<RecData> b0(const edm4hep::MCParticleCollection& mc, const double /* ionBeamEnergy */,
+                          const double* normals) {
     std::vector<RecData> rc;
-    for (const auto& part : mc) {
-      if (part.getGeneratorStatus() > 1) {
-        if (msgLevel(MSG::DEBUG)) {
-          debug() << "ignoring particle with getGeneratorStatus = " << part.getGeneratorStatus() << endmsg;
-        }
-        continue;
-      }
+    for (const size_t i : m_primaries) {
+      const auto& part = mc[i];
+      const double* g  = normals + kNormals * i;
       // only detect charged hadrons and photons
       if (part.getPDG() != 2212 && part.getPDG() != -2212 && part.getPDG() != 211 && part.getPDG() != -211 &&
           part.getPDG() != 321 && part.getPDG() != -321 && part.getPDG() != 22) {
@@ -249,7 +339,7 @@ private:
       if (mom_ion_theta < m_thetaMinB0 || mom_ion_theta > m_thetaMaxB0) {
         continue;
       }
-      auto [rc_part, assoc] = smearMomentum(part);
+      auto [rc_part, assoc] = smearMomentum(part, g);
       // we don't detect photon energy, just its angles and presence
       if (part.getPDG() == 22) {
         rc_part.setMomentum({0, 0, 0});
@@ -274,15 +364,11 @@ private:
     return rc;
   }
 
-  std::vector<RecData> rp(const edm4hep::MCParticleCollection& mc, const double ionBeamEnergy) {
+  std::vector<RecData> rp(const edm4hep::MCParticleCollection& mc, const double ionBeamEnergy, const double* normals) {
     std::vector<RecData> rc;
-    for (const auto& part : mc) {
-      if (part.getGeneratorStatus() > 1) {
-        if (msgLevel(MSG::DEBUG)) {
-          debug() << "ignoring particle with getGeneratorStatus = " << part.getGeneratorStatus() << endmsg;
-        }
-        continue;
-      }
+    for (const size_t i : m_primaries) {
+      const auto& part = mc[i];
+      const double* g  = normals + kNormals * i;
       // only detect protons
       if (part.getPDG() != 2212) {
         continue;
@@ -293,7 +379,7 @@ private:
           mom_ion.z < m_pMinRigidityRP * ionBeamEnergy) {
         continue;
       }
-      auto [rc_part, assoc] = smearMomentum(part);
+      auto [rc_part, assoc] = smearMomentum(part, g);
       rc_part.setType(kTagRP);
       rc.emplace_back(rc_part, assoc);
       if (msgLevel(MSG::DEBUG)) {
@@ -312,15 +398,11 @@ private:
     return rc;
   }
 
-  std::vector<RecData> omd(const edm4hep::MCParticleCollection& mc, const double ionBeamEnergy) {
+  std::vector<RecData> omd(const edm4hep::MCParticleCollection& mc, const double ionBeamEnergy, const double* normals) {
     std::vector<RecData> rc;
-    for (const auto& part : mc) {
-      if (part.getGeneratorStatus() > 1) {
-        if (msgLevel(MSG::DEBUG)) {
-          debug() << "ignoring particle with getGeneratorStatus = " << part.getGeneratorStatus() << endmsg;
-        }
-        continue;
-      }
+    for (const size_t i : m_primaries) {
+      const auto& part = mc[i];
+      const double* g  = normals + kNormals * i;
       // only detect protons
       if (part.getPDG() != 2212) {
         continue;
@@ -329,7 +411,7 @@ private:
       if (mom_ion.z < m_pMinRigidityOMD * ionBeamEnergy || mom_ion.z > m_pMaxRigidityOMD * ionBeamEnergy) {
         continue;
       }
-      auto [rc_part, assoc] = smearMomentum(part);
+      auto [rc_part, assoc] = smearMomentum(part, g);
       rc_part.setType(kTagOMD);
       rc.emplace_back(rc_part, assoc);
       if (msgLevel(MSG::DEBUG)) {
@@ -348,19 +430,68 @@ private:
     return rc;
   }
 
+  // acceptance and resolution of the bin of the particles, with the uniforms of the event
+  std::vector<RecData> responseMap(const edm4hep::MCParticleCollection& mc, const DetectorTags tag,
+                                   const double ionBeamEnergy, const double* normals) {
+    const ResponseMap& map = m_maps[tag];
+    const double scale     = map.momentumFraction() ? 1. / ionBeamEnergy : 1.;
+    std::vector<RecData> rc;
+    for (const size_t i : m_primaries) {
+      const auto& part = mc[i];
+      if (!map.detects(part.getPDG())) {
+        continue;
+      }
+      const auto mom_ion   = removeCrossingAngle(part.getMomentum());
+      const double p       = eicd::magnitude(mom_ion);
+      const double theta   = eicd::anglePolar(mom_ion);
+      const double phi     = eicd::angleAzimuthal(mom_ion);
+      const auto* response = map.find(theta, phi, p * scale);
+      if (response == nullptr || !(m_uniforms[i] < response->acceptance)) {
+        continue;
+      }
+      const double* g   = normals + kNormals * i;
+      const double ps   = p * (1. + response->sigmaP * g[0]);
+      const double ths  = theta + response->sigmaTheta * g[1];
+      const double phis = phi + response->sigmaPhi * g[2];
+      const auto mom3s  = rotateIonToLabDirection(eicd::sphericalToVector(ps, ths, phis));
+      RecPart rec_part;
+      rec_part.setType(tag);
+      rec_part.setEnergy(static_cast<float>(std::hypot(ps, part.getMass())));
+      rec_part.setMomentum({mom3s.x, mom3s.y, mom3s.z});
+      rec_part.setReferencePoint({static_cast<float>(part.getVertex().x), static_cast<float>(part.getVertex().y),
+                                  static_cast<float>(part.getVertex().z)});
+      rec_part.setCharge(static_cast<int16_t>(part.getCharge()));
+      rec_part.setMass(static_cast<float>(part.getMass()));
+      rec_part.setGoodnessOfPID(1.);
+      rec_part.setPDG(part.getPDG());
+      // we don't detect photon energy in B0, just its angles and presence
+      if (tag == kTagB0 && part.getPDG() == 22) {
+        rec_part.setMomentum({0, 0, 0});
+        rec_part.setEnergy(0);
+      }
+      Assoc assoc;
+      assoc.setRecID(rec_part.getObjectID().index);
+      assoc.setSimID(part.getObjectID().index);
+      assoc.setWeight(1.);
+      assoc.setRec(rec_part);
+      rc.emplace_back(rec_part, assoc);
+    }
+    return rc;
+  }
+
   // all momentum smearing in EIC-smear for the far-forward region uses
   // the same 2 relations for P and Pt smearing (B0, RP, OMD)
-  RecData smearMomentum(const edm4hep::MCParticle& part) {
+  RecData smearMomentum(const edm4hep::MCParticle& part, const double* g) {
     const auto mom_ion = rotateLabToIonDirection(part.getMomentum());
     const double p     = std::hypot(mom_ion.x, mom_ion.y, mom_ion.z);
-    const double dp    = (0.025 * p) * m_gaussDist();
+    const double dp    = (0.025 * p) * g[0];
     const double ps    = p + dp;
 
     // const double pt  = std::hypot(mom_ion.x, mom_ion.y);
     // const double dpt = (0.03 * pt) * m_gaussDist();
     // just apply relative smearing on px and py
-    const double dpxs = (0.03 * mom_ion.x) * m_gaussDist(); //+ (1 + dpt / pt);
-    const double dpys = (0.03 * mom_ion.y) * m_gaussDist(); //+ (1 + dpt / pt);
+    const double dpxs = (0.03 * mom_ion.x) * g[1]; //+ (1 + dpt / pt);
+    const double dpys = (0.03 * mom_ion.y) * g[2]; //+ (1 + dpt / pt);
 
     const double pxs = mom_ion.x + dpxs;
     const double pys = mom_ion.y + dpys;
@@ -393,22 +524,22 @@ private:
 
   // Rotate 25mrad about the y-axis
   edm4hep::Vector3f rotateLabToIonDirection(const edm4hep::Vector3f& vec) const {
-    const auto sth = sin(-m_crossingAngle);
-    const auto cth = cos(-m_crossingAngle);
+    const auto sth = -m_sinCrossing;
+    const auto cth = m_cosCrossing;
     return {static_cast<float>(cth * vec.x + sth * vec.z), static_cast<float>(vec.y),
             static_cast<float>(-sth * vec.x + cth * vec.z)};
   }
 
   edm4hep::Vector3f rotateIonToLabDirection(const edm4hep::Vector3f& vec) const {
-    const auto sth = sin(m_crossingAngle);
-    const auto cth = cos(m_crossingAngle);
+    const auto sth = m_sinCrossing;
+    const auto cth = m_cosCrossing;
     return {static_cast<float>(cth * vec.x + sth * vec.z), static_cast<float>(vec.y),
             static_cast<float>(-sth * vec.x + cth * vec.z)};
   }
 
   edm4hep::Vector3f removeCrossingAngle(const edm4hep::Vector3f& vec) const {
-    const auto sth = std::sin(-m_crossingAngle);
-    const auto cth = std::cos(-m_crossingAngle);
+    const auto sth = -m_sinCrossing;
+    const auto cth = m_cosCrossing;
     return {static_cast<float>(cth * vec.x + sth * vec.z), static_cast<float>(vec.y),
             static_cast<float>(-sth * vec.x + cth * vec.z)};
   }
@@ -17,6 +17,7 @@
 
 #include "JugBase/DataHandle.h"
 #include "JugBase/IGeoSvc.h"
+#include "JugBase/Utilities/FlatIndexMap.h"
 
 // Event Model related classes
 #include "edm4hep/MCParticle.h"
@@ -31,6 +32,10 @@ using namespace Gaudi::Units;
 namespace Jug::Fast {
 
 /** Truth clustering algorithm.
+ *
+ *  One protocluster per MC particle of the first contribution of the hits, in the order of their
+ *  first hit, with the hits in input order. The hits are grouped with one hash lookup each and
+ *  ordered by group with a counting sort, so that every protocluster is filled in one go.
  *
  * \ingroup reco
  */
@@ -40,6 +45,11 @@ private:
   DataHandle<edm4hep::SimCalorimeterHitCollection> m_mcHits{"mcHits", Gaudi::DataHandle::Reader, this};
   DataHandle<eicd::ProtoClusterCollection> m_outputProtoClusters{"outputProtoClusters", Gaudi::DataHandle::Writer, this};
 
+  // group of the hits, and first hit of the groups in the hits sorted by group
+  std::vector<uint32_t> m_group;
+  std::vector<uint32_t> m_groupBegin;
+  std::vector<uint32_t> m_sorted;
+
 public:
   TruthClustering(const std::string& name, ISvcLocator* svcLoc)
       : GaudiAlgorithm(name, svcLoc) {
@@ -60,23 +70,40 @@ public:
     const auto& hits = *m_inputHits.get();
     const auto& mc   = *m_mcHits.get();
     // Create output collections
-    auto& proto = *m_outputProtoClusters.createAndPut();
+    const size_t n = hits.size();
 
     // Map mc track ID to protoCluster index
-    std::map<int32_t, int32_t> protoIndex;
-
-    // Loop over al calorimeter hits and sort per mcparticle
-    for (const auto& hit : hits) {
-      const auto& mcHit     = mc[hit.getObjectID().index];
-      const auto& trackID   = mcHit.getContributions(0).getParticle().id();
-      // Create a new protocluster if we don't have one for this trackID
-      if (protoIndex.count(trackID) == 0) {
-        auto pcl = proto.create();
-        protoIndex[trackID] = proto.size() - 1;
+    Jug::Base::FlatIndexMap protoIndex(n);
+    m_group.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+      const auto& mcHit  = mc[hits[i].getObjectID().index];
+      const auto trackID = mcHit.getContributions(0).getParticle().id();
+      m_group[i]         = protoIndex.emplace(static_cast<uint32_t>(trackID), protoIndex.size()).first;
+    }
+    const size_t groups = protoIndex.size();
+
+    // hits sorted by protocluster, in input order within each
+    m_groupBegin.assign(groups + 1, 0);
+    for (size_t i = 0; i < n; ++i) {
+      ++m_groupBegin[m_group[i] + 1];
+    }
+    for (size_t g = 0; g < groups; ++g) {
+      m_groupBegin[g + 1] += m_groupBegin[g];
+    }
+    // m_groupBegin[g] is the end of group g after the scatter
+    m_sorted.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+      m_sorted[m_groupBegin[m_group[i]]++] = i;
+    }
+
+    // Create output collections
+    auto& proto = *m_outputProtoClusters.createAndPut(groups);
+    for (size_t g = 0, k = 0; g < groups; ++g) {
+      auto pcl = proto.create();
+      for (; k < m_groupBegin[g]; ++k) {
+        pcl.addToHits(hits[m_sorted[k]]);
+        pcl.addToWeights(1);
       }
-      // Add hit to the appropriate protocluster
-      proto[protoIndex[trackID]].addToHits(hit);
-      proto[protoIndex[trackID]].addToWeights(1);
     }
     return StatusCode::SUCCESS;
   }
@@ -13,6 +13,7 @@
 #include "GaudiKernel/PhysicalConstants.h"
 
 #include "JugBase/DataHandle.h"
+#include "JugBase/Utilities/AssociationIndex.h"
 
 // Event Model related classes
 #include "edm4hep/MCParticleCollection.h"
@@ -198,16 +199,12 @@ public:
 
     std::map<int, eicd::Cluster> matched = {};
 
-    for (const auto& cluster : clusters) {
-      int mcID = -1;
+    // associated particles, indexed once instead of a search for every cluster
+    const auto assocIndex = Jug::Base::association_index(associations);
 
-      // find associated particle
-      for (const auto& assoc : associations) {
-        if (assoc.getRec() == cluster) {
-          mcID = assoc.getSimID();
-          break;
-        }
-      }
+    for (const auto& cluster : clusters) {
+      const auto iassoc = assocIndex.find(Jug::Base::object_key(cluster.getObjectID()));
+      const int mcID    = (iassoc != Jug::Base::FlatIndexMap::kEmpty) ? associations[iassoc].getSimID() : -1;
 
       if (msgLevel(MSG::VERBOSE)) {
         verbose() << " --> Found cluster: " << cluster.getObjectID().index << " with mcID " << mcID << " and energy "
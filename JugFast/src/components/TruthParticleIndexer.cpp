@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include <cmath>
+
+#include "Gaudi/Property.h"
+#include "GaudiAlg/GaudiAlgorithm.h"
+
+#include "JugBase/DataHandle.h"
+#include "JugBase/IParticleSvc.h"
+#include "JugBase/TruthParticleIndex.h"
+
+#include "edm4hep/MCParticleCollection.h"
+
+namespace Jug::Fast {
+
+/** Truth particle index of the event, for the truth consumers.
+ *
+ *  The momentum magnitude, transverse momentum, pseudorapidity and angles, the charge from the PDG
+ *  code and the selections of the MCParticles (TruthParticleIndex) are computed in one pass, so
+ *  that the truth seeding, the truth PID matching, the smearing and the truth kinematics (with
+ *  their inputTruthIndex) read them instead of each scanning and filtering the MCParticles. The
+ *  particles of a batch are indexed at once, in their indices in the batch.
+ *
+ * \ingroup fast
+ */
+class TruthParticleIndexer : public GaudiAlgorithm {
+private:
+  DataHandle<edm4hep::MCParticleCollection> m_inputMCParticles{"inputMCParticles", Gaudi::DataHandle::Reader, this};
+  DataHandle<TruthParticleIndex> m_outputIndex{"outputTruthIndex", Gaudi::DataHandle::Writer, this};
+
+  SmartIF<IParticleSvc> m_pidSvc;
+
+public:
+  TruthParticleIndexer(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
+    declareProperty("inputMCParticles", m_inputMCParticles, "MCParticles");
+    declareProperty("outputTruthIndex", m_outputIndex, "TruthParticleIndex");
+  }
+
+  StatusCode initialize() override {
+    if (GaudiAlgorithm::initialize().isFailure()) {
+      return StatusCode::FAILURE;
+    }
+    m_pidSvc = service("ParticleSvc");
+    if (!m_pidSvc) {
+      error() << "Unable to locate Particle Service. "
+              << "Make sure you have ParticleSvc in the configuration." << endmsg;
+      return StatusCode::FAILURE;
+    }
+    return StatusCode::SUCCESS;
+  }
+
+  StatusCode execute() override {
+    const auto& mc = *(m_inputMCParticles.get());
+    auto& index    = *(m_outputIndex.createAndPut());
+
+    const size_t n = mc.size();
+    index.p.resize(n);
+    index.pt.resize(n);
+    index.eta.resize(n);
+    index.phi.resize(n);
+    index.theta.resize(n);
+    index.charge.resize(n);
+    index.pdg.resize(n);
+    index.status.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+      const auto& part = mc[i];
+      const auto& mom  = part.getMomentum();
+      const double pt  = std::hypot(mom.x, mom.y);
+      index.p[i]       = std::hypot(pt, mom.z);
+      index.pt[i]      = pt;
+      index.theta[i]   = std::atan2(pt, mom.z);
+      index.eta[i]     = -std::log(std::tan(0.5 * index.theta[i]));
+      index.phi[i]     = std::atan2(mom.y, mom.x);
+      index.pdg[i]     = part.getPDG();
+      index.status[i]  = part.getGeneratorStatus();
+      // DD4hep sets the charge of the MCParticles to zero, the PDG code has it
+      index.charge[i] = static_cast<float>(m_pidSvc->particle(index.pdg[i]).charge);
+
+      const auto k = static_cast<uint32_t>(i);
+      if (index.status[i] <= 1) {
+        index.primaries.push_back(k);
+        if (index.charge[i] != 0) {
+          index.chargedPrimaries.push_back(k);
+        }
+      }
+      if (index.status[i] == 1) {
+        index.finalState.push_back(k);
+      } else if (index.status[i] == 4) {
+        index.beams.push_back(k);
+      }
+    }
+    return StatusCode::SUCCESS;
+  }
+};
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(TruthParticleIndexer)
+
+} // namespace Jug::Fast
@@ -0,0 +1,320 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+/*
+ *  Track-seeded Cherenkov angle reconstruction and mass hypothesis likelihoods for RICH detectors
+ *  with spherical mirrors
+ */
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "fmt/format.h"
+
+#include "Gaudi/Property.h"
+#include "GaudiAlg/GaudiAlgorithm.h"
+#include "GaudiKernel/PhysicalConstants.h"
+
+#include "JugBase/DataHandle.h"
+#include "JugBase/IParticleSvc.h"
+#include "JugBase/Tensor.h"
+
+// Event Model related classes
+#include "eicd/PMTHitCollection.h"
+#include "eicd/RingImageCollection.h"
+#include "eicd/TrackSegmentCollection.h"
+
+using namespace Gaudi::Units;
+
+namespace Jug::Reco {
+
+/** Track-seeded Cherenkov particle identification.
+ *
+ *  The tracks are the segments of TrackSurfaceProjector, the emission point and direction are
+ *  those of the point radiatorPoint of every segment (e.g. the projection to the middle of the
+ *  radiator). The photons are the hits of PhotoMultiplierReco, at their global positions.
+ *
+ *  The mirror of a photon is the spherical mirror of its azimuthal sector: nSectors sectors of
+ *  equal width, the first centered at sectorPhi, the mirror of the first sector has its center
+ *  at mirrorCenter and the others are rotated around the beam line, in a table built at
+ *  initialization. The reflection point of a photon fulfills the law of reflection between the
+ *  emission point and the hit, in their plane with the mirror center, found with mirrorIterations
+ *  secant iterations of its angle on the mirror circle. The Cherenkov angle is the angle of the
+ *  emitted photon and the track direction, for all the photons of a track as array expressions.
+ *
+ *  For every mass hypothesis (PDG codes of hypotheses, masses from the ParticleSvc), the expected
+ *  angle is acos(1 / (n beta)) with the refractiveIndex n, and the expected number of photons is
+ *  photonYield x sin^2 of it. The extended likelihood of the photons below maxAngle is that of a
+ *  Gaussian of angleResolution around the expected angle over a flat background of
+ *  backgroundDensity photons per rad, evaluated for all the hypotheses of a track at once.
+ *
+ *  The outputs are, for every segment in order, a RingImage with the emission point as position,
+ *  the mean angle and number of the photons within 3 angleResolution of the most likely
+ *  hypothesis (none below threshold) and the log-likelihoods as (segments x hypotheses) Tensor,
+ *  with the PDG codes as feature names.
+ *
+ * \ingroup reco
+ */
+class CherenkovTrackPID : public GaudiAlgorithm {
+private:
+  DataHandle<eicd::TrackSegmentCollection> m_inputTrackSegments{"inputTrackSegments", Gaudi::DataHandle::Reader, this};
+  DataHandle<eicd::PMTHitCollection> m_inputHitCollection{"inputHitCollection", Gaudi::DataHandle::Reader, this};
+  DataHandle<eicd::RingImageCollection> m_outputRings{"outputRings", Gaudi::DataHandle::Writer, this};
+  DataHandle<Jug::Tensor> m_outputLikelihoods{"outputLikelihoods", Gaudi::DataHandle::Writer, this};
+
+  Gaudi::Property<size_t> m_radiatorPoint{this, "radiatorPoint", 0, "Index of the emission point in the segments"};
+  Gaudi::Property<std::vector<int>> m_hypotheses{this, "hypotheses", {11, 211, 321, 2212}};
+  Gaudi::Property<double> m_refractiveIndex{this, "refractiveIndex", 1.0008};
+  Gaudi::Property<double> m_photonYield{this, "photonYield", 2000., "Photons at the saturated angle over sin^2"};
+  Gaudi::Property<double> m_angleResolution{this, "angleResolution", 2.0 * mrad};
+  Gaudi::Property<double> m_backgroundDensity{this, "backgroundDensity", 100. / rad};
+  Gaudi::Property<double> m_maxAngle{this, "maxAngle", 80. * mrad};
+  Gaudi::Property<double> m_minNpe{this, "minNpe", 0.5};
+
+  // mirror geometry
+  Gaudi::Property<int> m_nSectors{this, "nSectors", 6};
+  Gaudi::Property<double> m_sectorPhi{this, "sectorPhi", 0. * rad};
+  Gaudi::Property<std::vector<double>> u_mirrorCenter{this, "mirrorCenter", {0., 0., 0.}};
+  Gaudi::Property<double> m_mirrorRadius{this, "mirrorRadius", 2000. * mm};
+  Gaudi::Property<int> m_mirrorIterations{this, "mirrorIterations", 3};
+
+  SmartIF<IParticleSvc> m_pidSvc;
+
+  // mirror centers of the sectors, and masses of the hypotheses
+  Eigen::Matrix3Xd m_mirrorCenters;
+  Eigen::ArrayXd m_masses;
+
+  // photons of the event and their mirror centers (unitless, mm)
+  Eigen::Array3Xd m_photons;
+  Eigen::Array3Xd m_photonMirrors;
+
+  // unitless counterparts of the input parameters
+  double angleResolution{0}, backgroundDensity{0}, maxAngle{0}, mirrorRadius{0};
+
+public:
+  CherenkovTrackPID(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
+    declareProperty("inputTrackSegments", m_inputTrackSegments, "");
+    declareProperty("inputHitCollection", m_inputHitCollection, "");
+    declareProperty("outputRings", m_outputRings, "");
+    declareProperty("outputLikelihoods", m_outputLikelihoods, "");
+  }
+
+  StatusCode initialize() override {
+    if (GaudiAlgorithm::initialize().isFailure()) {
+      return StatusCode::FAILURE;
+    }
+    m_pidSvc = service("ParticleSvc");
+    if (!m_pidSvc) {
+      error() << "Unable to locate Particle Service. "
+              << "Make sure you have ParticleSvc in the configuration." << endmsg;
+      return StatusCode::FAILURE;
+    }
+    if (m_hypotheses.value().empty()) {
+      error() << "No mass hypotheses" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    m_masses.resize(m_hypotheses.size());
+    for (size_t h = 0; h < m_hypotheses.size(); ++h) {
+      m_masses(h) = m_pidSvc->particle(m_hypotheses[h]).mass;
+    }
+    if (u_mirrorCenter.size() != 3 || m_nSectors.value() <= 0 || !(m_mirrorRadius.value() > 0.) ||
+        m_mirrorIterations.value() <= 0) {
+      error() << "Expected mirrorCenter of {x, y, z}, positive nSectors, mirrorRadius and mirrorIterations" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    if (!(m_refractiveIndex.value() > 1.) || !(m_angleResolution.value() > 0.) ||
+        !(m_backgroundDensity.value() > 0.)) {
+      error() << "Expected refractiveIndex above 1, positive angleResolution and backgroundDensity" << endmsg;
+      return StatusCode::FAILURE;
+    }
+
+    // unitless conversion, keep consistency with juggler internal units (GeV, mm, ns, rad)
+    angleResolution   = m_angleResolution.value() / rad;
+    backgroundDensity = m_backgroundDensity.value() * rad;
+    maxAngle          = m_maxAngle.value() / rad;
+    mirrorRadius      = m_mirrorRadius.value() / mm;
+
+    // mirror center of the first sector rotated to the others
+    const Eigen::Vector3d center(u_mirrorCenter[0] / mm, u_mirrorCenter[1] / mm, u_mirrorCenter[2] / mm);
+    m_mirrorCenters.resize(3, m_nSectors.value());
+    for (int s = 0; s < m_nSectors.value(); ++s) {
+      m_mirrorCenters.col(s) = Eigen::AngleAxisd(2. * M_PI * s / m_nSectors.value(), Eigen::Vector3d::UnitZ()) * center;
+    }
+    info() << fmt::format("Hypotheses [{}], {} mirror sectors of radius {:g} mm", fmt::join(m_hypotheses.value(), ", "),
+                          m_nSectors.value(), mirrorRadius)
+           << endmsg;
+    return StatusCode::SUCCESS;
+  }
+
+  StatusCode execute() override {
+    // input collections
+    const auto& segments = *m_inputTrackSegments.get();
+    const auto& hits     = *m_inputHitCollection.get();
+    // Create output collections
+    auto& rings       = *m_outputRings.createAndPut();
+    auto& likelihoods = *m_outputLikelihoods.createAndPut();
+    std::vector<std::string> names;
+    for (const auto pdg : m_hypotheses.value()) {
+      names.push_back(std::to_string(pdg));
+    }
+    likelihoods = Jug::Tensor({segments.size(), static_cast<size_t>(m_masses.size())}, names);
+
+    fill_photons(hits);
+
+    Eigen::ArrayXd angles;
+    Eigen::ArrayXd logL;
+    for (size_t t = 0; t < segments.size(); ++t) {
+      const auto segment = segments[t];
+      auto ring          = rings.create();
+      if (m_radiatorPoint.value() >= segment.points_size()) {
+        continue;
+      }
+      const auto point = segment.getPoints(m_radiatorPoint.value());
+      const Eigen::Vector3d emission(point.position.x / mm, point.position.y / mm, point.position.z / mm);
+      const Eigen::Vector3d momentum(point.momentum.x, point.momentum.y, point.momentum.z);
+      ring.setPosition(point.position);
+      const double p = momentum.norm();
+      if (!(p > 0.)) {
+        continue;
+      }
+
+      cherenkov_angles(emission, momentum / p, angles);
+      const auto best = likelihood(angles, p, logL);
+      for (Eigen::Index h = 0; h < logL.size(); ++h) {
+        likelihoods[t * logL.size() + h] = static_cast<float>(logL(h));
+      }
+
+      // photons of the most likely hypothesis
+      const double expected = expected_angle(m_masses(best), p);
+      if (expected > 0.) {
+        const auto selected = ((angles - expected).abs() < 3. * angleResolution).cast<double>();
+        const double n      = selected.sum();
+        if (n > 0.) {
+          ring.setNpe(static_cast<float>(n));
+          ring.setTheta(static_cast<float>((selected * angles).sum() / n));
+          ring.setThetaError(static_cast<float>(angleResolution / std::sqrt(n)));
+        }
+      }
+      if (msgLevel(MSG::DEBUG)) {
+        debug() << fmt::format("track {} with p = {:.3f} GeV, most likely {}", t, p, m_hypotheses[best]) << endmsg;
+      }
+    }
+    return StatusCode::SUCCESS;
+  }
+
+private:
+  // photon positions and the mirror centers of their sectors
+  void fill_photons(const eicd::PMTHitCollection& hits) {
+    const double width = 2. * M_PI / m_nSectors.value();
+    m_photons.resize(3, hits.size());
+    m_photonMirrors.resize(3, hits.size());
+    Eigen::Index n = 0;
+    for (const auto& hit : hits) {
+      if (hit.getNpe() < m_minNpe) {
+        continue;
+      }
+      const auto& pos = hit.getPosition();
+      m_photons.col(n) << pos.x / mm, pos.y / mm, pos.z / mm;
+      const double phi = std::atan2(pos.y, pos.x) - m_sectorPhi.value() / rad + 0.5 * width;
+      const int sector = static_cast<int>(std::floor(phi / width)) % m_nSectors.value();
+      m_photonMirrors.col(n) = m_mirrorCenters.col(sector < 0 ? sector + m_nSectors.value() : sector);
+      ++n;
+    }
+    m_photons.conservativeResize(3, n);
+    m_photonMirrors.conservativeResize(3, n);
+  }
+
+  // Cherenkov angles of all the photons for an emission point and direction
+  void cherenkov_angles(const Eigen::Vector3d& emission, const Eigen::Vector3d& direction,
+                        Eigen::ArrayXd& angles) const {
+    const Eigen::Index n = m_photons.cols();
+    auto unit            = [](const Eigen::Array3Xd& v) {
+      return (v.rowwise() / v.matrix().colwise().norm().array()).eval();
+    };
+
+    // in the plane of the mirror center, emission point and hit: the emission point on the first
+    // axis at ex, the hit at (px, py) and the reflection point at mirrorRadius (cos(alpha), sin(alpha))
+    const Eigen::Array3Xd toEmission = emission.array().replicate(1, n) - m_photonMirrors;
+    const Eigen::Array3Xd toHit      = m_photons - m_photonMirrors;
+    const Eigen::ArrayXd ex          = toEmission.matrix().colwise().norm().transpose().array();
+    const Eigen::Array3Xd u          = toEmission.rowwise() / ex.transpose();
+    const Eigen::ArrayXd px          = (u * toHit).colwise().sum().transpose();
+    const Eigen::Array3Xd perp       = toHit - u.rowwise() * px.transpose();
+    const Eigen::ArrayXd py          = perp.matrix().colwise().norm().transpose().array().max(1e-9);
+
+    // law of reflection: the normal bisects the directions to the emission point and the hit
+    auto reflection = [&](const Eigen::ArrayXd& alpha) {
+      const Eigen::ArrayXd c  = alpha.cos();
+      const Eigen::ArrayXd s  = alpha.sin();
+      const Eigen::ArrayXd mx = mirrorRadius * c;
+      const Eigen::ArrayXd my = mirrorRadius * s;
+      return ((-c * my - s * (ex - mx)) / ((ex - mx).square() + my.square()).sqrt() +
+              (c * (py - my) - s * (px - mx)) / ((px - mx).square() + (py - my).square()).sqrt())
+          .eval();
+    };
+    // secant iterations from the direction of the midpoint
+    Eigen::ArrayXd alpha0 = (0.5 * py).binaryExpr(0.5 * (ex + px), [](double y, double x) { return std::atan2(y, x); });
+    Eigen::ArrayXd alpha1 = alpha0 + 1e-3;
+    Eigen::ArrayXd f0     = reflection(alpha0);
+    Eigen::ArrayXd f1     = reflection(alpha1);
+    for (int i = 0; i < m_mirrorIterations.value(); ++i) {
+      const Eigen::ArrayXd alpha2 = (f1 == f0).select(alpha1, alpha1 - f1 * (alpha1 - alpha0) / (f1 - f0));
+      alpha0.swap(alpha1);
+      f0.swap(f1);
+      alpha1 = alpha2;
+      f1     = reflection(alpha1);
+    }
+
+    const Eigen::Array3Xd v      = perp.rowwise() / py.transpose();
+    const Eigen::Array3Xd mirror = m_photonMirrors + u.rowwise() * (mirrorRadius * alpha1.cos()).transpose() +
+                                   v.rowwise() * (mirrorRadius * alpha1.sin()).transpose();
+    const Eigen::ArrayXd cosines = (direction.transpose() * unit(mirror - emission.array().replicate(1, n)).matrix())
+                                       .transpose()
+                                       .array();
+    angles = cosines.min(1.).max(-1.).acos();
+  }
+
+  // expected Cherenkov angle of a mass, 0 below threshold
+  double expected_angle(double mass, double p) const {
+    const double cosine = std::sqrt(p * p + mass * mass) / (m_refractiveIndex.value() * p);
+    return (cosine < 1.) ? std::acos(cosine) : 0.;
+  }
+
+  // log-likelihoods of all the hypotheses, returns the most likely one
+  Eigen::Index likelihood(const Eigen::ArrayXd& angles, double p, Eigen::ArrayXd& logL) const {
+    const Eigen::Index nh = m_masses.size();
+    Eigen::ArrayXd expected(nh);
+    Eigen::ArrayXd yield(nh);
+    for (Eigen::Index h = 0; h < nh; ++h) {
+      expected(h) = expected_angle(m_masses(h), p);
+      yield(h)    = m_photonYield.value() * std::pow(std::sin(expected(h)), 2);
+    }
+
+    // photons in the angular window, against the hypotheses (hypotheses x photons)
+    std::vector<double> window;
+    for (Eigen::Index i = 0; i < angles.size(); ++i) {
+      if (angles(i) < maxAngle) {
+        window.push_back(angles(i));
+      }
+    }
+    const Eigen::Map<const Eigen::ArrayXd> photons(window.data(), window.size());
+    const double norm          = 1. / (std::sqrt(2. * M_PI) * angleResolution);
+    const Eigen::ArrayXXd pull = (photons.transpose().replicate(nh, 1) - expected.replicate(1, photons.size())) /
+                                 angleResolution;
+    const Eigen::ArrayXXd density =
+        (yield.replicate(1, photons.size()) * norm * (-0.5 * pull.square()).exp()) + backgroundDensity;
+    logL = density.log().rowwise().sum() - yield - backgroundDensity * maxAngle;
+
+    Eigen::Index best = 0;
+    logL.maxCoeff(&best);
+    return best;
+  }
+};
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(CherenkovTrackPID)
+
+} // namespace Jug::Reco
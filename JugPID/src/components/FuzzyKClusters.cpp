@@ -11,7 +11,11 @@
 #include "FuzzyKClusters.h"
 #include <exception>
 #include <iostream>
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
 
 
 using namespace fkc;
@@ -30,12 +34,11 @@ MatrixXd KMeans::Fit(const MatrixXd &data, int k, double q, double epsilon, int
     auto res = Initialize(data, k, q);
 
     for (n_iters = 0; n_iters < max_iters; ++n_iters) {
-        auto old_mems = mems;
         Distances(res, data);
         Memberships(q);
         FormClusters(res, data, q);
 
-        if ((old_mems - mems).cwiseAbs().maxCoeff() < epsilon) {
+        if (delta < epsilon) {
             break;
         }
     }
@@ -51,53 +54,63 @@ MatrixXd KMeans::Initialize(const MatrixXd &data, int k, double q)
 
     // guess the cluster centers
     mems = MatrixXd::Random(k, data.rows());
-    for (int j = 0; j < mems.cols(); ++j) {
-        auto csum = mems.col(j).sum();
-        for (int i = 0; i < mems.rows(); ++i) {
-            mems(i, j) = mems(i, j)/csum;
-        }
-    }
+    mems = mems.array().rowwise() / mems.colwise().sum().array();
+    Weights(q);
 
     MatrixXd clusters(k, data.cols());
     FormClusters(clusters, data, q);
     return clusters;
 }
 
+// squared distances |c|^2 + |x|^2 - 2 c.x, with the cross terms from one matrix product
+void KMeans::SquaredDistances(MatrixXd &d2, const MatrixXd &centers, const MatrixXd &data)
+{
+    d2.noalias() = -2.0 * centers * data.transpose();
+    d2.colwise() += centers.rowwise().squaredNorm();
+    d2.rowwise() += data.rowwise().squaredNorm().transpose();
+    // rounding of the cancellation
+    d2 = d2.cwiseMax(0.);
+}
+
 // distance matrix (num_clusters, num_data)
 void KMeans::Distances(const MatrixXd &centroids, const MatrixXd &data)
 {
-    for (int i = 0; i < centroids.rows(); ++i) {
-        for (int j = 0; j < data.rows(); ++j) {
-            dists(i, j) = (centroids.row(i) - data.row(j)).cwiseAbs2().sum();
-        }
-    }
+    SquaredDistances(dists, centroids, data);
 }
 
 // membership matrix (num_clusters, num_data)
 void KMeans::Memberships(double q)
 {
     // coeffcient-wise operation
-    auto d = dists.array().pow(-1.0/(q - 1.0)).matrix();
+    if (q == 2.0) {
+        next_mems = dists.cwiseInverse();
+    } else {
+        next_mems = dists.array().pow(-1.0/(q - 1.0)).matrix();
+    }
+    next_mems = next_mems.array().rowwise() / next_mems.colwise().sum().array();
 
-    for (int j = 0; j < d.cols(); ++j) {
-        auto dsum = d.col(j).sum();
-        for (int i = 0; i < d.rows(); ++i) {
-            mems(i, j) = d(i, j)/dsum;
-        }
+    // no previous memberships (initial rings), not converged
+    delta = (mems.size() == next_mems.size()) ? (next_mems - mems).cwiseAbs().maxCoeff()
+                                              : std::numeric_limits<double>::infinity();
+    mems.swap(next_mems);
+    Weights(q);
+}
+
+// membership weights
+void KMeans::Weights(double q)
+{
+    if (q == 2.0) {
+        weights = mems.cwiseAbs2();
+    } else {
+        weights = mems.array().pow(q).matrix();
     }
 }
 
 // rebuild clusters
-void KMeans::FormClusters(MatrixXd &clusters, const MatrixXd &data, double q)
+void KMeans::FormClusters(MatrixXd &clusters, const MatrixXd &data, double /* q */)
 {
-    auto weights = mems.array().pow(q).matrix();
-    for (int i = 0; i < clusters.rows(); ++i) {
-        clusters.row(i) *= 0;
-        for (int j = 0; j < data.rows(); ++j) {
-            clusters.row(i) += data.row(j)*weights(i, j);
-        }
-        clusters.row(i) /= weights.row(i).sum();
-    }
+    clusters.noalias() = weights * data;
+    clusters = clusters.array().colwise() / weights.rowwise().sum().array();
 }
 
 
@@ -115,16 +128,27 @@ KRings::~KRings() = default;
 
 MatrixXd KRings::Fit(const MatrixXd &data, int k, double q, double epsilon, int max_iters)
 {
-    auto res = Initialize(data, k, q);
+    return Iterate(Initialize(data, k, q), data, q, epsilon, max_iters);
+}
 
+MatrixXd KRings::Fit(const MatrixXd &data, const MatrixXd &rings, double q, double epsilon, int max_iters)
+{
+    // memberships from the distances to the initial rings in the first iteration
+    dists.resize(rings.rows(), data.rows());
+    dists_euc.resize(rings.rows(), data.rows());
+    mems.resize(0, 0);
+    return Iterate(rings, data, q, epsilon, max_iters);
+}
+
+MatrixXd KRings::Iterate(MatrixXd res, const MatrixXd &data, double q, double epsilon, int max_iters)
+{
     for (n_iters = 0; n_iters < max_iters; ++n_iters) {
-        auto old_mems = mems;
         Distances(res, data);
         Memberships(q);
         FormRadii(res, q);
         FormClusters(res, data, q);
 
-        if ((old_mems - mems).cwiseAbs().maxCoeff() < epsilon) {
+        if (delta < epsilon) {
             break;
         }
     }
@@ -145,6 +169,7 @@ MatrixXd KRings::Initialize(const MatrixXd &data, int k, double q)
     dists.resize(k, data.rows());
     dists_euc = fkm.GetDistances().cwiseSqrt();
     mems = fkm.GetMemberships();
+    Weights(q);
     FormRadii(clusters, q);
     return clusters;
 }
@@ -152,48 +177,102 @@ MatrixXd KRings::Initialize(const MatrixXd &data, int k, double q)
 // distance matrix (num_clusters, num_data)
 void KRings::Distances(const MatrixXd &centroids, const MatrixXd &data)
 {
-    auto const centers = centroids.leftCols(centroids.cols() - 1);
-    auto const radii = centroids.rightCols(1);
+    const auto centers = centroids.leftCols(centroids.cols() - 1);
+    const auto radii = centroids.rightCols(1);
 
-    for (int i = 0; i < centroids.rows(); ++i) {
-        for (int j = 0; j < data.rows(); ++j) {
-            dists_euc(i, j) = std::sqrt((centers.row(i) - data.row(j)).cwiseAbs2().sum());
-            dists(i, j) = std::pow(dists_euc(i, j) - radii(i, 0), 2);
-        }
-    }
+    SquaredDistances(dists_euc, centers, data);
+    dists_euc = dists_euc.cwiseSqrt();
+    dists = (dists_euc.colwise() - radii.col(0)).cwiseAbs2();
 }
 
 // rebuild clusters radii
-void KRings::FormRadii(MatrixXd &clusters, double q)
+void KRings::FormRadii(MatrixXd &clusters, double /* q */)
 {
-    auto radii = clusters.rightCols(1);
-    auto weights = mems.array().pow(q).matrix();
-
-    for (int i = 0; i < weights.rows(); ++i) {
-        radii(i, 0) = 0;
-        for (int j = 0; j < weights.cols(); ++j) {
-            radii(i, 0) += weights(i, j)*dists_euc(i, j);
-        }
-        radii(i, 0) /= weights.row(i).sum();
-    }
+    clusters.rightCols(1) = weights.cwiseProduct(dists_euc).rowwise().sum().cwiseQuotient(weights.rowwise().sum());
 }
 
 // rebuild clusters centers
-void KRings::FormClusters(MatrixXd &clusters, const MatrixXd &data, double q)
+// c_i = sum_j w_ij (x_j - (x_j - c_i) s_ij) / sum_j w_ij, with s_ij = r_i/d_ij
+void KRings::FormClusters(MatrixXd &clusters, const MatrixXd &data, double /* q */)
 {
     auto centers = clusters.leftCols(data.cols());
-    const auto &radii = clusters.rightCols(1);
-    auto weights = mems.array().pow(q).matrix();
-
-    for (int i = 0; i < weights.rows(); ++i) {
-        MatrixXd icenter = centers.row(i);
-        centers.row(i) *= 0;
-        for (int j = 0; j < weights.cols(); ++j) {
-            double scale = radii(i, 0)/dists_euc(i, j);
-            centers.row(i) += weights(i, j)*(data.row(j) - (data.row(j) - icenter)*scale);
+    const auto radii = clusters.rightCols(1);
+
+    const MatrixXd scaled = weights.cwiseProduct((dists_euc.cwiseInverse().array().colwise() * radii.col(0).array()).matrix());
+    const MatrixXd icenters = centers;
+    MatrixXd sums = (weights - scaled) * data;
+    sums += icenters.cwiseProduct(scaled.rowwise().sum().replicate(1, data.cols()));
+    centers = sums.array().colwise() / weights.rowwise().sum().array();
+}
+
+
+// =================================================================================================
+//  Hough transform estimate of the rings, for a deterministic initialization of KRings
+// =================================================================================================
+
+MatrixXd fkc::HoughRings(const MatrixXd &data, int k, double min_radius, double max_radius, double bin_size,
+                         int n_radii)
+{
+    if (data.rows() == 0 || data.cols() != 2 || k <= 0 || n_radii <= 0 || !(bin_size > 0.) ||
+        !(max_radius >= min_radius)) {
+        return MatrixXd(0, 3);
+    }
+    const double r_step = (max_radius - min_radius) / n_radii;
+    // centers are within max_radius of the data, the grid is bounded by 1024 bins per side
+    const double x0 = data.col(0).minCoeff() - max_radius;
+    const double y0 = data.col(1).minCoeff() - max_radius;
+    const double width = std::max(data.col(0).maxCoeff() + max_radius - x0, data.col(1).maxCoeff() + max_radius - y0);
+    bin_size = std::max(bin_size, width / 1024.);
+    const int nx = static_cast<int>(std::ceil((data.col(0).maxCoeff() + max_radius - x0) / bin_size)) + 1;
+    const int ny = static_cast<int>(std::ceil((data.col(1).maxCoeff() + max_radius - y0) / bin_size)) + 1;
+    auto bin = [nx, ny](int ix, int iy, int ir) { return (static_cast<size_t>(ir) * ny + iy) * nx + ix; };
+
+    // votes, a point votes at most once per bin
+    std::vector<uint32_t> votes(static_cast<size_t>(nx) * ny * n_radii, 0);
+    std::vector<uint32_t> voter(votes.size(), 0);
+    for (int j = 0; j < data.rows(); ++j) {
+        for (int ir = 0; ir < n_radii; ++ir) {
+            const double r = min_radius + (ir + 0.5) * r_step;
+            // steps of at most half a bin along the circle
+            const int n_angles = std::max(8, static_cast<int>(std::ceil(4. * M_PI * r / bin_size)));
+            for (int ia = 0; ia < n_angles; ++ia) {
+                const double a = 2. * M_PI * ia / n_angles;
+                const int ix = static_cast<int>((data(j, 0) + r * std::cos(a) - x0) / bin_size);
+                const int iy = static_cast<int>((data(j, 1) + r * std::sin(a) - y0) / bin_size);
+                if (ix < 0 || ix >= nx || iy < 0 || iy >= ny) {
+                    continue;
+                }
+                const size_t b = bin(ix, iy, ir);
+                if (voter[b] != static_cast<uint32_t>(j) + 1) {
+                    voter[b] = j + 1;
+                    ++votes[b];
+                }
+            }
+        }
+    }
+
+    // highest peaks, the first bin of equal ones
+    MatrixXd rings(k, 3);
+    int n_rings = 0;
+    for (; n_rings < k; ++n_rings) {
+        const auto peak = std::max_element(votes.begin(), votes.end());
+        if (*peak == 0) {
+            break;
+        }
+        const size_t b = peak - votes.begin();
+        const int ix = b % nx;
+        const int iy = (b / nx) % ny;
+        const int ir = b / (static_cast<size_t>(nx) * ny);
+        rings.row(n_rings) << x0 + (ix + 0.5) * bin_size, y0 + (iy + 0.5) * bin_size, min_radius + (ir + 0.5) * r_step;
+        for (int jr = std::max(0, ir - 2); jr <= std::min(n_radii - 1, ir + 2); ++jr) {
+            for (int jy = std::max(0, iy - 2); jy <= std::min(ny - 1, iy + 2); ++jy) {
+                for (int jx = std::max(0, ix - 2); jx <= std::min(nx - 1, ix + 2); ++jx) {
+                    votes[bin(jx, jy, jr)] = 0;
+                }
+            }
         }
-        centers.row(i) /= weights.row(i).sum();
     }
+    return rings.topRows(n_rings);
 }
 
 
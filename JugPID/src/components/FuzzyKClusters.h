@@ -9,6 +9,10 @@ namespace fkc {
 
   /**  Fuzzy K Clustering Algorithms
    *
+   *  The distances, memberships and clusters are evaluated as (k x n) matrix expressions, the
+   *  distances to the centers through a matrix product. The membership weights (memberships to the
+   *  power q) are evaluated once per iteration, without pow for q = 2, and the convergence is the
+   *  largest change of the memberships, measured when they are updated.
    *
    * \ingroup reco
    */
@@ -33,11 +37,18 @@ namespace fkc {
     virtual void            Distances(const Eigen::MatrixXd& centroids, const Eigen::MatrixXd& data);
     virtual void            Memberships(double q);
     virtual void            FormClusters(Eigen::MatrixXd& clusters, const Eigen::MatrixXd& data, double q);
+    // membership weights, mems to the power q
+    void                    Weights(double q);
+    // squared euclidean distances (num_clusters, num_data) of the centers to the data
+    static void             SquaredDistances(Eigen::MatrixXd& d2, const Eigen::MatrixXd& centers,
+                                             const Eigen::MatrixXd& data);
 
   protected:
     int             n_iters{0};
     double          variance{0};
-    Eigen::MatrixXd dists, mems;
+    // largest change of the memberships in the last update
+    double          delta{0};
+    Eigen::MatrixXd dists, mems, weights, next_mems;
   };
 
   class KRings : public KMeans {
@@ -47,15 +58,30 @@ namespace fkc {
 
     virtual Eigen::MatrixXd Fit(const Eigen::MatrixXd& data, int k, double q = 2.0, double epsilon = 1e-4,
                                 int max_iters = 1000);
+    // fit from initial rings (num_clusters, data dimension + 1 for the radius), e.g. from HoughRings
+    Eigen::MatrixXd Fit(const Eigen::MatrixXd& data, const Eigen::MatrixXd& rings, double q = 2.0,
+                        double epsilon = 1e-4, int max_iters = 1000);
 
   protected:
     virtual Eigen::MatrixXd Initialize(const Eigen::MatrixXd& data, int k, double q);
     virtual void            Distances(const Eigen::MatrixXd& centroids, const Eigen::MatrixXd& data);
     virtual void            FormClusters(Eigen::MatrixXd& clusters, const Eigen::MatrixXd& data, double q);
     virtual void            FormRadii(Eigen::MatrixXd& clusters, double g);
+    Eigen::MatrixXd         Iterate(Eigen::MatrixXd res, const Eigen::MatrixXd& data, double q, double epsilon,
+                                    int max_iters);
 
   protected:
     Eigen::MatrixXd dists_euc;
   };
 
+  /** Deterministic estimate of k rings in 2D data, with a Hough transform of the ring centers.
+   *
+   *  Every point votes for the centers at the radii of n_radii bins in [min_radius, max_radius] around
+   *  it, in a (center x, center y, radius) grid of bin_size; the rings are the k highest peaks, the
+   *  bins around a peak (2 bins in every direction) are not used for the next ones. Returns the rings
+   *  as (k, 3) matrix of center x, center y and radius, fewer rows if there are not enough peaks.
+   */
+  Eigen::MatrixXd HoughRings(const Eigen::MatrixXd& data, int k, double min_radius, double max_radius,
+                             double bin_size, int n_radii = 16);
+
 } // namespace fkc
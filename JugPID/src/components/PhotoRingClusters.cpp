@@ -9,6 +9,8 @@
  */
 
 #include <algorithm>
+#include <string>
+#include <vector>
 
 #include "Gaudi/Property.h"
 #include "GaudiAlg/GaudiAlgorithm.h"
@@ -51,6 +53,11 @@ private:
   Gaudi::Property<double> m_q{this, "q", 2.0};
   Gaudi::Property<double> m_eps{this, "epsilon", 1e-4};
   Gaudi::Property<double> m_minNpe{this, "minNpe", 0.5};
+  // initial rings: "hough" (deterministic, Hough transform estimate) or "random" (fuzzy K-means)
+  Gaudi::Property<std::string> m_initialization{this, "initialization", "hough"};
+  Gaudi::Property<std::vector<double>> u_houghRadiusRange{this, "houghRadiusRange", {10. * mm, 100. * mm}};
+  Gaudi::Property<double> m_houghBinSize{this, "houghBinSize", 2. * mm};
+  Gaudi::Property<int> m_houghRadii{this, "houghRadii", 16};
   // Pointer to the geometry service
   SmartIF<IGeoSvc> m_geoSvc;
 
@@ -71,6 +78,16 @@ public:
               << "Make sure you have GeoSvc and SimSvc in the right order in the configuration." << endmsg;
       return StatusCode::FAILURE;
     }
+    if (m_initialization.value() != "hough" && m_initialization.value() != "random") {
+      error() << "Unknown initialization " << m_initialization.value() << ", please choose from [hough, random]"
+              << endmsg;
+      return StatusCode::FAILURE;
+    }
+    if (u_houghRadiusRange.size() != 2 || !(u_houghRadiusRange[1] >= u_houghRadiusRange[0]) ||
+        !(m_houghBinSize.value() > 0.) || m_houghRadii.value() <= 0) {
+      error() << "Expected houghRadiusRange of {min, max}, positive houghBinSize and houghRadii" << endmsg;
+      return StatusCode::FAILURE;
+    }
     return StatusCode::SUCCESS;
   }
 
@@ -83,16 +100,31 @@ public:
     // algorithm
     auto alg = fkc::KRings();
 
-    // fill data
+    // fill data, only the photons above minNpe
     MatrixXd data(rawhits.size(), 2);
-    for (int i = 0; i < data.rows(); ++i) {
-      if (rawhits[i].getNpe() > m_minNpe) {
-        data.row(i) << rawhits[i].getLocal().x, rawhits[i].getLocal().y;
+    int nPhotons = 0;
+    for (const auto& hit : rawhits) {
+      if (hit.getNpe() > m_minNpe) {
+        data.row(nPhotons++) << hit.getLocal().x / mm, hit.getLocal().y / mm;
       }
     }
+    data.conservativeResize(nPhotons, 2);
+    if (nPhotons == 0) {
+      return StatusCode::SUCCESS;
+    }
 
     // clustering
-    auto res = alg.Fit(data, m_nRings, m_q, m_eps, m_nIters);
+    MatrixXd res;
+    if (m_initialization.value() == "hough") {
+      const auto init = fkc::HoughRings(data, m_nRings, u_houghRadiusRange[0] / mm, u_houghRadiusRange[1] / mm,
+                                        m_houghBinSize / mm, m_houghRadii);
+      res = alg.Fit(data, init, m_q, m_eps, m_nIters);
+    } else {
+      res = alg.Fit(data, m_nRings, m_q, m_eps, m_nIters);
+    }
+    if (msgLevel(MSG::DEBUG)) {
+      debug() << nPhotons << " photons, " << res.rows() << " rings after " << alg.NIters() << " iterations" << endmsg;
+    }
 
     // local position
     // @TODO: Many fields in RingImage not filled, need to assess
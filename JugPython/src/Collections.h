@@ -0,0 +1,153 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JUGPYTHON_COLLECTIONS_H
+#define JUGPYTHON_COLLECTIONS_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+
+#include "JugBase/CalorimeterWaveforms.h"
+
+// Event Model related classes
+#include "edm4hep/CaloHitContributionCollection.h"
+#include "edm4hep/RawCalorimeterHitCollection.h"
+#include "edm4hep/SimCalorimeterHitCollection.h"
+
+// NumPy record types of the data of the collections, field by field
+PYBIND11_NUMPY_DTYPE(edm4hep::Vector3f, x, y, z);
+PYBIND11_NUMPY_DTYPE(edm4hep::SimCalorimeterHitData, cellID, energy, position, contributions_begin,
+                     contributions_end);
+PYBIND11_NUMPY_DTYPE(edm4hep::CaloHitContributionData, PDG, energy, time, stepPosition);
+PYBIND11_NUMPY_DTYPE(edm4hep::RawCalorimeterHitData, cellID, amplitude, timeStamp);
+
+namespace Jug::Python {
+
+  namespace py = pybind11;
+
+  /** Conversion of the collections of a type between Python and the algorithms.
+   *
+   *  from makes the input of an algorithm from a Python object, as a holder of the collection
+   *  (and of the collections it refers to) with get(). to gives an output of an algorithm to
+   *  Python, as NumPy arrays on its buffers: the arrays own the output, nothing is copied.
+   */
+  template <class T> struct Converter;
+
+  /// Record array on the data buffer of a podio collection, which the array owns
+  template <class Data, class Collection> py::array dataView(Collection&& collection) {
+    auto owned = std::make_unique<Collection>(std::move(collection));
+    owned->prepareForWrite();
+    auto* data = *static_cast<std::vector<Data>**>(owned->getBuffers().data);
+    py::capsule base(owned.get(), [](void* p) { delete static_cast<Collection*>(p); });
+    owned.release();
+    return py::array_t<Data>({static_cast<py::ssize_t>(data->size())}, {static_cast<py::ssize_t>(sizeof(Data))},
+                             data->data(), base);
+  }
+
+  /// Contiguous record array of a Python object (a copy only if it is not contiguous or of another dtype)
+  template <class Data> py::array_t<Data, py::array::c_style | py::array::forcecast> records(const py::handle& obj) {
+    auto array = py::array_t<Data, py::array::c_style | py::array::forcecast>::ensure(obj);
+    if (!array || array.ndim() != 1) {
+      throw py::type_error("expected a one-dimensional array of " + py::str(py::dtype::of<Data>()).cast<std::string>());
+    }
+    return array;
+  }
+
+  /** Sim calorimeter hits, from a record array of the hits, or a tuple of the hits and of their
+   *  contributions (contributions_begin and contributions_end of a hit index the contributions).
+   *
+   *  podio collections own their objects: the records are copied into them once, the relations
+   *  are made from the index ranges.
+   */
+  template <> struct Converter<edm4hep::SimCalorimeterHitCollection> {
+    struct Holder {
+      edm4hep::CaloHitContributionCollection contributions;
+      edm4hep::SimCalorimeterHitCollection hits;
+      const edm4hep::SimCalorimeterHitCollection& get() const { return hits; }
+    };
+
+    static std::unique_ptr<Holder> from(const py::handle& obj) {
+      py::object hitObj = py::reinterpret_borrow<py::object>(obj);
+      py::object contribObj;
+      if (py::isinstance<py::tuple>(obj)) {
+        auto pair = obj.cast<py::tuple>();
+        if (pair.size() != 2) {
+          throw py::type_error("expected the hits, or a tuple of the hits and of their contributions");
+        }
+        hitObj     = pair[0];
+        contribObj = pair[1];
+      }
+      const auto hits     = records<edm4hep::SimCalorimeterHitData>(hitObj);
+      const size_t nHits  = hits.size();
+      const auto* hitData = hits.data();
+      py::array_t<edm4hep::CaloHitContributionData, py::array::c_style | py::array::forcecast> contribs;
+      const edm4hep::CaloHitContributionData* contribData = nullptr;
+      size_t nContribs                                    = 0;
+      if (contribObj) {
+        contribs    = records<edm4hep::CaloHitContributionData>(contribObj);
+        contribData = contribs.data();
+        nContribs   = contribs.size();
+      }
+
+      auto holder = std::make_unique<Holder>();
+      for (size_t i = 0; i < nHits; ++i) {
+        const auto& d = hitData[i];
+        auto hit      = holder->hits.create();
+        hit.setCellID(d.cellID);
+        hit.setEnergy(d.energy);
+        hit.setPosition(d.position);
+        if (contribData == nullptr) {
+          continue;
+        }
+        if (d.contributions_begin > d.contributions_end || d.contributions_end > nContribs) {
+          throw py::value_error("contributions of hit " + std::to_string(i) + " out of range");
+        }
+        for (auto k = d.contributions_begin; k < d.contributions_end; ++k) {
+          const auto& c = contribData[k];
+          auto contrib  = holder->contributions.create();
+          contrib.setPDG(c.PDG);
+          contrib.setEnergy(c.energy);
+          contrib.setTime(c.time);
+          contrib.setStepPosition(c.stepPosition);
+          hit.addToContributions(contrib);
+        }
+      }
+      return holder;
+    }
+  };
+
+  /// Raw calorimeter hits, to a record array (cellID, amplitude, timeStamp)
+  template <> struct Converter<edm4hep::RawCalorimeterHitCollection> {
+    static py::object to(edm4hep::RawCalorimeterHitCollection&& hits) {
+      return dataView<edm4hep::RawCalorimeterHitData>(std::move(hits));
+    }
+  };
+
+  /// Waveforms, to a dict of the cellIDs (n), the samples (n, nSamples) and the timing
+  template <> struct Converter<Jug::Base::CalorimeterWaveforms> {
+    static py::object to(Jug::Base::CalorimeterWaveforms&& waveforms) {
+      auto owned  = std::make_unique<Jug::Base::CalorimeterWaveforms>(std::move(waveforms));
+      auto* w     = owned.get();
+      py::capsule base(owned.release(), [](void* p) { delete static_cast<Jug::Base::CalorimeterWaveforms*>(p); });
+      const auto n = static_cast<py::ssize_t>(w->cellID.size());
+      const auto m = static_cast<py::ssize_t>(w->nSamples);
+      py::dict out;
+      out["cellID"]         = py::array_t<uint64_t>({n}, {static_cast<py::ssize_t>(sizeof(uint64_t))}, w->cellID.data(), base);
+      out["samples"]        = py::array_t<int32_t>({n, m}, {m * static_cast<py::ssize_t>(sizeof(int32_t)),
+                                                            static_cast<py::ssize_t>(sizeof(int32_t))},
+                                                   w->samples.data(), base);
+      out["samplingPeriod"] = w->samplingPeriod;
+      out["startTime"]      = w->startTime;
+      return out;
+    }
+  };
+
+} // namespace Jug::Python
+
+#endif
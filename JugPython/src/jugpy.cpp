@@ -0,0 +1,172 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include "DD4hep/Detector.h"
+
+#include "JugBase/Algorithm.h"
+#include "JugBase/Utilities/Philox.h"
+#include "JugDigi/CalorimeterHitDigi.h"
+#include "JugDigi/CalorimeterWaveformDigi.h"
+
+#include "Collections.h"
+
+namespace py = pybind11;
+
+namespace Jug::Python {
+
+  /// Detector of load_geometry, given to the algorithms at initialize
+  const dd4hep::Detector* g_detector = nullptr;
+
+  void setProperty(AlgorithmBase& algo, const std::string& key, const py::handle& value) {
+    auto it = algo.properties().find(key);
+    if (it == algo.properties().end()) {
+      throw py::key_error(algo.name() + ": unknown property " + key);
+    }
+    std::visit([&](auto* ref) { *ref = value.cast<std::remove_pointer_t<decltype(ref)>>(); }, it->second);
+  }
+
+  py::object getProperty(const AlgorithmBase& algo, const std::string& key) {
+    auto it = algo.properties().find(key);
+    if (it == algo.properties().end()) {
+      throw py::key_error(algo.name() + ": unknown property " + key);
+    }
+    return std::visit([](auto* ref) { return py::cast(*ref); }, it->second);
+  }
+
+  /** Python class of a framework-independent algorithm.
+   *
+   *  The properties are given as keyword arguments of the constructor (or set later), the
+   *  inputs of execute are converted by Converter, and the outputs are NumPy arrays on the
+   *  buffers of the output collections. execute releases the GIL while the algorithm runs.
+   *  The random numbers of an event are those of RandomSvc with the same seed and run.
+   */
+  template <class Algo, class In = typename Algo::InputTypes, class Out = typename Algo::OutputTypes>
+  struct AlgorithmBinding;
+
+  template <class Algo, class... In, class... Out>
+  struct AlgorithmBinding<Algo, Input<In...>, Output<Out...>> {
+    static void bind(py::module_& m, const char* name, const char* doc) {
+      const std::string defaultName = name;
+      py::class_<Algo>(m, name, doc)
+          .def(py::init([defaultName](const std::string& instance, const py::kwargs& properties) {
+                 auto algo = std::make_unique<Algo>(instance.empty() ? defaultName : instance);
+                 for (const auto& [key, value] : properties) {
+                   setProperty(*algo, key.cast<std::string>(), value);
+                 }
+                 return algo;
+               }),
+               py::arg("name") = "")
+          .def_property_readonly("name", &Algo::name)
+          .def_property_readonly("inputs", &Algo::inputNames)
+          .def_property_readonly("outputs", &Algo::outputNames)
+          .def_property_readonly("properties",
+                                 [](const Algo& algo) {
+                                   std::vector<std::string> keys;
+                                   for (const auto& [key, value] : algo.properties()) {
+                                     keys.push_back(key);
+                                   }
+                                   return keys;
+                                 })
+          .def("set", [](Algo& algo, const std::string& key, const py::object& value) { setProperty(algo, key, value); })
+          .def("get", [](const Algo& algo, const std::string& key) { return getProperty(algo, key); })
+          .def("set_log_level",
+               [](Algo& algo, const std::string& level) {
+                 algo.setLogLevel(level == "debug"     ? LogLevel::kDebug
+                                  : level == "warning" ? LogLevel::kWarning
+                                  : level == "error"   ? LogLevel::kError
+                                                       : LogLevel::kInfo);
+               })
+          .def("initialize",
+               [](Algo& algo) {
+                 if (!algo.initialize(g_detector)) {
+                   throw std::runtime_error(algo.name() + ": initialization failed");
+                 }
+               })
+          .def("execute", &execute);
+    }
+
+    /// execute(*inputs, event=0, seed=1, run=0)
+    static py::object execute(const Algo& algo, const py::args& inputs, const py::kwargs& options) {
+      if (inputs.size() != sizeof...(In)) {
+        throw py::type_error(algo.name() + ": expected " + std::to_string(sizeof...(In)) + " inputs");
+      }
+      uint64_t event = 0;
+      uint64_t seed  = 1;
+      uint64_t run   = 0;
+      for (const auto& [key, value] : options) {
+        const auto option = key.cast<std::string>();
+        if (option == "event") {
+          event = value.cast<uint64_t>();
+        } else if (option == "seed") {
+          seed = value.cast<uint64_t>();
+        } else if (option == "run") {
+          run = value.cast<uint64_t>();
+        } else {
+          throw py::type_error(algo.name() + ": unknown option " + option);
+        }
+      }
+      AlgorithmContext context;
+      context.event     = event;
+      context.randomKey = Base::Random::event_key(Base::Random::job_key(seed, run), algo.randomName(), event);
+      return call(algo, inputs, context, std::index_sequence_for<In...>{}, std::index_sequence_for<Out...>{});
+    }
+
+    template <size_t... I, size_t... O>
+    static py::object call(const Algo& algo, const py::args& inputs, const AlgorithmContext& context,
+                           std::index_sequence<I...> /* inputs */, std::index_sequence<O...> /* outputs */) {
+      const auto holders = std::make_tuple(Converter<In>::from(inputs[I])...);
+      const typename Algo::Input in{std::get<I>(holders)->get()...};
+      auto out = [&] {
+        py::gil_scoped_release release;
+        return algo.execute(in, context);
+      }();
+      if constexpr (sizeof...(Out) == 1) {
+        return Converter<Out...>::to(std::move(std::get<0>(out)));
+      } else {
+        return py::make_tuple(Converter<Out>::to(std::move(std::get<O>(out)))...);
+      }
+    }
+  };
+
+} // namespace Jug::Python
+
+PYBIND11_MODULE(jugpy, m) {
+  using namespace Jug::Python;
+  m.doc() = "Framework-independent reconstruction algorithms on NumPy arrays";
+
+  m.def(
+      "load_geometry",
+      [](const std::string& compact) {
+        if (g_detector != nullptr) {
+          throw std::runtime_error("The geometry is already loaded");
+        }
+        auto& detector = dd4hep::Detector::getInstance();
+        detector.fromCompact(compact);
+        g_detector = &detector;
+      },
+      py::arg("compact"), "Load the DD4hep geometry given to the algorithms at initialize");
+
+  // record dtypes of the inputs, e.g. numpy.zeros(n, dtype=jugpy.dtypes["SimCalorimeterHit"])
+  py::dict dtypes;
+  dtypes["SimCalorimeterHit"]   = py::dtype::of<edm4hep::SimCalorimeterHitData>();
+  dtypes["CaloHitContribution"] = py::dtype::of<edm4hep::CaloHitContributionData>();
+  dtypes["RawCalorimeterHit"]   = py::dtype::of<edm4hep::RawCalorimeterHitData>();
+  m.attr("dtypes") = dtypes;
+
+  AlgorithmBinding<Jug::Digi::CalorimeterHitDigi>::bind(
+      m, "CalorimeterHitDigi", "Calorimeter hit digitization, sim hits (and contributions) to raw hits");
+  AlgorithmBinding<Jug::Digi::CalorimeterWaveformDigi>::bind(
+      m, "CalorimeterWaveformDigi", "Calorimeter waveform digitization, sim hits and contributions to samples");
+}
@@ -0,0 +1,188 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "eicd/CalorimeterHit.h"
+#include "eicd/ProtoCluster.h"
+#include "eicd/Vector3f.h"
+#include "eicd/vector_utils.h"
+
+#include "JugBase/Utilities/Dispatch.h"
+#include "JugReco/ProtoClusterIndex.h"
+
+namespace Jug::Reco {
+
+// distances of n positions to the beam axis (rT) and to the origin (r)
+JUG_KERNEL_BODY void hit_radii_body(const float* __restrict x, const float* __restrict y, const float* __restrict z,
+                                    float* __restrict rT, float* __restrict r, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    const float rT2 = x[i] * x[i] + y[i] * y[i];
+    rT[i]           = std::sqrt(rT2);
+    r[i]            = std::sqrt(rT2 + z[i] * z[i]);
+  }
+}
+JUG_DISPATCH_KERNEL(hit_radii,
+                    (const float* __restrict x, const float* __restrict y, const float* __restrict z,
+                     float* __restrict rT, float* __restrict r, size_t n),
+                    (x, y, z, rT, r, n))
+
+/** Structure-of-arrays copy of calorimeter hits.
+ *
+ *  Filled once per hit collection (or proto-cluster), so that the hot loops of the clustering and
+ *  cluster reconstruction run over contiguous arrays instead of going through the podio handles.
+ *  Entry i corresponds to the i-th hit of the input, which remains the owner of the hit.
+ *
+ *  The columns derived from the global position (r, rT, eta, phi) are computed in one pass over
+ *  the x, y, z arrays once the hits are added, so that the binning and clustering algorithms read
+ *  them instead of evaluating the transcendental functions per hit and per use. They can be left
+ *  empty by the algorithms that do not need them.
+ *
+ * \ingroup reco
+ */
+struct CalorimeterHitCache {
+  std::vector<uint64_t> cellID;
+  std::vector<float> energy, energyError;
+  std::vector<float> time, timeError;
+  // global position
+  std::vector<float> x, y, z;
+  std::vector<float> localX, localY, localZ;
+  std::vector<float> dimX, dimY, dimZ;
+  std::vector<int32_t> sector, layer;
+  // derived from the global position: distance to the origin, to the beam axis (cylindrical r), eta and phi
+  std::vector<float> r, rT, eta, phi;
+  // hit weights of the proto-cluster, 1 for a hit collection
+  std::vector<float> weight;
+
+  size_t size() const { return cellID.size(); }
+  bool empty() const { return cellID.empty(); }
+
+  eicd::Vector3f position(size_t i) const { return {x[i], y[i], z[i]}; }
+  eicd::Vector3f local(size_t i) const { return {localX[i], localY[i], localZ[i]}; }
+  eicd::Vector3f dimension(size_t i) const { return {dimX[i], dimY[i], dimZ[i]}; }
+
+  void clear() {
+    for_each_array([](auto& v) { v.clear(); });
+  }
+  void reserve(size_t n) {
+    for_each_array([n](auto& v) { v.reserve(n); });
+  }
+
+  /// Add a hit with its derived columns
+  void push_back(const eicd::CalorimeterHit& hit, float w = 1.) {
+    append(hit, w);
+    update_derived();
+  }
+
+  /// Add a hit without its derived columns, see update_derived()
+  void append(const eicd::CalorimeterHit& hit, float w = 1.) {
+    const auto pos = hit.getPosition();
+    const auto loc = hit.getLocal();
+    const auto dim = hit.getDimension();
+    cellID.push_back(hit.getCellID());
+    energy.push_back(hit.getEnergy());
+    energyError.push_back(hit.getEnergyError());
+    time.push_back(hit.getTime());
+    timeError.push_back(hit.getTimeError());
+    x.push_back(pos.x);
+    y.push_back(pos.y);
+    z.push_back(pos.z);
+    localX.push_back(loc.x);
+    localY.push_back(loc.y);
+    localZ.push_back(loc.z);
+    dimX.push_back(dim.x);
+    dimY.push_back(dim.y);
+    dimZ.push_back(dim.z);
+    sector.push_back(hit.getSector());
+    layer.push_back(hit.getLayer());
+    weight.push_back(w);
+  }
+
+  /// Compute the derived columns of the hits added without them
+  void update_derived() {
+    const size_t begin = rT.size();
+    const size_t n     = size();
+    r.resize(n);
+    rT.resize(n);
+    eta.resize(n);
+    phi.resize(n);
+    // the square roots first, in a loop without calls that the compiler vectorizes
+    hit_radii(x.data() + begin, y.data() + begin, z.data() + begin, rT.data() + begin, r.data() + begin, n - begin);
+    // eta = -ln(tan(theta / 2)) = asinh(z / rT), without the polar angle
+    for (size_t i = begin; i < n; ++i) {
+      eta[i] = std::asinh(z[i] / rT[i]);
+      phi[i] = std::atan2(y[i], x[i]);
+    }
+  }
+
+  // fill from a hit collection (or any range of hits), replacing the current content,
+  // without the derived columns if not needed
+  template <typename Hits> void fill(const Hits& hits, bool withDerived = true) {
+    clear();
+    reserve(hits.size());
+    for (const auto& hit : hits) {
+      append(hit);
+    }
+    if (withDerived) {
+      update_derived();
+    }
+  }
+
+  // fill from the hits of a proto-cluster with their weights, replacing the current content
+  void fill(const eicd::ProtoCluster& pcl, bool withDerived = true) {
+    const auto& hits    = pcl.getHits();
+    const auto& weights = pcl.getWeights();
+    clear();
+    reserve(hits.size());
+    for (size_t i = 0; i < hits.size(); ++i) {
+      append(hits[i], weights[i]);
+    }
+    if (withDerived) {
+      update_derived();
+    }
+  }
+
+  // fill from the hits of proto-cluster k of an index with their weights, replacing the current content
+  template <typename Hits>
+  void fill(const Hits& hits, const ProtoClusterIndex& index, size_t k, bool withDerived = true) {
+    clear();
+    reserve(index.hits_size(k));
+    for (uint32_t j = index.begin[k]; j < index.begin[k + 1]; ++j) {
+      append(hits[index.hit[j]], index.weight[j]);
+    }
+    if (withDerived) {
+      update_derived();
+    }
+  }
+
+private:
+  template <typename Func> void for_each_array(Func&& func) {
+    func(cellID);
+    func(energy);
+    func(energyError);
+    func(time);
+    func(timeError);
+    func(x);
+    func(y);
+    func(z);
+    func(localX);
+    func(localY);
+    func(localZ);
+    func(dimX);
+    func(dimY);
+    func(dimZ);
+    func(sector);
+    func(layer);
+    func(r);
+    func(rT);
+    func(eta);
+    func(phi);
+    func(weight);
+  }
+};
+
+} // namespace Jug::Reco
@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+
+#include "Math/Vector4D.h"
+
+#include "JugBase/Utilities/Beam.h"
+
+#include "edm4hep/MCParticleCollection.h"
+#include "eicd/MCRecoParticleAssociationCollection.h"
+#include "eicd/ReconstructedParticle.h"
+
+namespace Jug::Reco {
+
+/** Beams and scattered electron of an event, for the inclusive kinematics.
+ *
+ *  Made once per event by InclusiveKinematicsBeams (or by makeDISBeams in the kinematics
+ *  algorithms without it): the rounded beam four-momenta, the first scattered electron in the
+ *  MC particles and its reconstructed particle, and the reconstructed particle of every
+ *  associated MC particle index (the first association of each) for the other consumers.
+ *
+ * \ingroup reco
+ */
+struct DISBeams {
+  std::optional<ROOT::Math::PxPyPzEVector> ei;
+  std::optional<ROOT::Math::PxPyPzEVector> pi;
+  /// Truth scattered electron
+  std::optional<edm4hep::MCParticle> ef_mc;
+  /// Reconstructed scattered electron, and its index in the reconstructed particles
+  std::optional<eicd::ReconstructedParticle> ef_rc;
+  int ef_rc_id{-1};
+  /// MC particle index --> reconstructed particle
+  std::unordered_map<uint32_t, eicd::ReconstructedParticle> recBySimID;
+
+  /// What is missing for the kinematics, nullptr if nothing
+  const char* missing() const {
+    if (!ei) {
+      return "No beam electron found";
+    }
+    if (!pi) {
+      return "No beam hadron found";
+    }
+    if (!ef_mc) {
+      return "No truth scattered electron found";
+    }
+    if (!ef_rc) {
+      return "Truth scattered electron not in reconstructed particles";
+    }
+    return nullptr;
+  }
+};
+
+/// Masses of the beam particles (from the ParticleSvc) and the crossing angle
+struct DISBeamsConfig {
+  double electronMass{0};
+  double protonMass{0};
+  double neutronMass{0};
+  double crossingAngle{0};
+};
+
+/// Find the beams and the scattered electron of an event, with one pass over the associations
+inline DISBeams makeDISBeams(const edm4hep::MCParticleCollection& mcparts,
+                             const eicd::MCRecoParticleAssociationCollection& rcassoc, const DISBeamsConfig& cfg) {
+  DISBeams beams;
+
+  // the first association of every MC particle
+  beams.recBySimID.reserve(rcassoc.size());
+  for (const auto& assoc : rcassoc) {
+    beams.recBySimID.emplace(assoc.getSimID(), assoc.getRec());
+  }
+
+  // Get incoming electron beam
+  const auto ei_coll = Jug::Base::Beam::find_first_beam_electron(mcparts);
+  if (ei_coll.empty()) {
+    return beams;
+  }
+  beams.ei = Jug::Base::Beam::round_beam_four_momentum(ei_coll[0].getMomentum(), cfg.electronMass,
+                                                       {-5.0, -10.0, -18.0}, 0.0);
+
+  // Get incoming hadron beam
+  const auto pi_coll = Jug::Base::Beam::find_first_beam_hadron(mcparts);
+  if (pi_coll.empty()) {
+    return beams;
+  }
+  beams.pi = Jug::Base::Beam::round_beam_four_momentum(
+      pi_coll[0].getMomentum(), pi_coll[0].getPDG() == 2212 ? cfg.protonMass : cfg.neutronMass,
+      {41.0, 100.0, 275.0}, cfg.crossingAngle);
+
+  // Get first scattered electron
+  const auto ef_coll = Jug::Base::Beam::find_first_scattered_electron(mcparts);
+  if (ef_coll.empty()) {
+    return beams;
+  }
+  beams.ef_mc = ef_coll[0];
+
+  // Associate first scattered electron with reconstructed electrons
+  const auto it = beams.recBySimID.find(static_cast<uint32_t>(ef_coll[0].getObjectID().index));
+  if (it != beams.recBySimID.end()) {
+    beams.ef_rc    = it->second;
+    beams.ef_rc_id = it->second.getObjectID().index;
+  }
+  return beams;
+}
+
+} // namespace Jug::Reco
@@ -0,0 +1,187 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Dense>
+
+namespace Jug::Reco {
+
+/** Linear optics between the interaction point and a pair of far-forward tracking stations.
+ *
+ *  The transfer matrices map (deltaP / p [%], angle [mrad]) at the IP to (position [mm], slope
+ *  [mrad]) at the detector, in x and y. The slope offsets are those of the reference orbit.
+ *
+ * \ingroup reco
+ */
+struct FarForwardOptics {
+  Eigen::Matrix2d transferX{Eigen::Matrix2d::Identity()};
+  Eigen::Matrix2d transferY{Eigen::Matrix2d::Identity()};
+  double xSlopeOffset{0};
+  double ySlopeOffset{0};
+  // nominal momentum of the beam, in GeV
+  double beamMomentum{0};
+};
+
+/** Multi-track reconstruction of far-forward protons with the inverse transfer matrices.
+ *
+ *  The hits of an event (in the coordinates of the orbit) are sorted in z and grouped in planes
+ *  (hits within planeTolerance of the first one of the plane) and stations (planes separated by
+ *  less than stationSeparation). The tracks are pairs of a hit of the first plane of the first
+ *  station and a hit of the first plane of the last station, within the x and y windows (no cut
+ *  if not positive), paired greedily in increasing distance. Their positions and slopes at the
+ *  last station are then taken to the IP all at once with the inverse matrices.
+ *
+ * \ingroup reco
+ */
+class FarForwardTracks {
+public:
+  struct Settings {
+    double planeTolerance{1.};
+    double stationSeparation{100.};
+    double xWindow{-1};
+    double yWindow{-1};
+  };
+
+  /// False if a transfer matrix cannot be inverted
+  bool configure(const FarForwardOptics& optics, const Settings& settings) {
+    m_optics   = optics;
+    m_settings = settings;
+    if (optics.transferX.determinant() == 0. || optics.transferY.determinant() == 0.) {
+      return false;
+    }
+    m_inverseX = optics.transferX.inverse();
+    m_inverseY = optics.transferY.inverse();
+    return true;
+  }
+
+  void clear() {
+    m_x.clear();
+    m_y.clear();
+    m_z.clear();
+  }
+  void add(double x, double y, double z) {
+    m_x.push_back(x);
+    m_y.push_back(y);
+    m_z.push_back(z);
+  }
+
+  /// Momenta at the IP of the tracks of the hits added since the last clear, 3 x number of tracks
+  const Eigen::Matrix3Xd& reconstruct() {
+    pair_stations();
+    const auto n = static_cast<Eigen::Index>(m_pairs.size());
+    Eigen::Matrix2Xd detX(2, n);
+    Eigen::Matrix2Xd detY(2, n);
+    for (Eigen::Index k = 0; k < n; ++k) {
+      const auto [a, b] = m_pairs[k];
+      const double base = m_z[b] - m_z[a];
+      detX(0, k)        = m_x[b];
+      detX(1, k)        = 1000. * (m_x[b] - m_x[a]) / base - m_optics.xSlopeOffset;
+      detY(0, k)        = m_y[b];
+      detY(1, k)        = 1000. * (m_y[b] - m_y[a]) / base - m_optics.ySlopeOffset;
+    }
+    // (deltaP / p [%], angle [mrad]) at the IP of all the tracks
+    const Eigen::Matrix2Xd ipX = m_inverseX * detX;
+    const Eigen::Matrix2Xd ipY = m_inverseY * detY;
+
+    // angles in radians, momentum magnitude from the deltaP with thin lens optics
+    const Eigen::ArrayXd rsx  = ipX.row(1).array().transpose() / 1000.;
+    const Eigen::ArrayXd rsy  = ipY.row(1).array().transpose() / 1000.;
+    const Eigen::ArrayXd p    = m_optics.beamMomentum * (1. + 0.01 * ipX.row(0).array().transpose());
+    const Eigen::ArrayXd norm = (1. + rsx.square() + rsy.square()).sqrt();
+    m_momenta.resize(3, n);
+    m_momenta.row(0) = (p * rsx / norm).matrix().transpose();
+    m_momenta.row(1) = (p * rsy / norm).matrix().transpose();
+    m_momenta.row(2) = (p / norm).matrix().transpose();
+    return m_momenta;
+  }
+
+  size_t size() const { return m_x.size(); }
+
+private:
+  // hits of the first plane of the first and of the last station, paired within the windows
+  void pair_stations() {
+    m_pairs.clear();
+    const size_t n = m_z.size();
+    m_order.resize(n);
+    std::iota(m_order.begin(), m_order.end(), 0);
+    std::stable_sort(m_order.begin(), m_order.end(), [this](uint32_t a, uint32_t b) { return m_z[a] < m_z[b]; });
+    if (n < 2) {
+      return;
+    }
+    // first planes of the stations, as ranges of the sorted hits
+    std::vector<std::pair<size_t, size_t>> firstPlanes;
+    for (size_t begin = 0; begin < n;) {
+      size_t end = begin + 1;
+      while (end < n && m_z[m_order[end]] - m_z[m_order[begin]] <= m_settings.planeTolerance) {
+        ++end;
+      }
+      const bool newStation =
+          firstPlanes.empty() || m_z[m_order[begin]] - m_z[m_order[begin - 1]] > m_settings.stationSeparation;
+      if (newStation) {
+        firstPlanes.emplace_back(begin, end);
+      }
+      begin = end;
+    }
+    if (firstPlanes.size() < 2) {
+      return;
+    }
+    const auto [aBegin, aEnd] = firstPlanes.front();
+    const auto [bBegin, bEnd] = firstPlanes.back();
+
+    // candidate pairs by distance in the transverse plane, the closest ones first
+    m_candidates.clear();
+    for (size_t i = aBegin; i < aEnd; ++i) {
+      for (size_t j = bBegin; j < bEnd; ++j) {
+        const uint32_t a = m_order[i];
+        const uint32_t b = m_order[j];
+        const double dx  = m_x[b] - m_x[a];
+        const double dy  = m_y[b] - m_y[a];
+        if ((m_settings.xWindow > 0 && std::abs(dx) > m_settings.xWindow) ||
+            (m_settings.yWindow > 0 && std::abs(dy) > m_settings.yWindow)) {
+          continue;
+        }
+        m_candidates.push_back({dx * dx + dy * dy, a, b});
+      }
+    }
+    std::stable_sort(m_candidates.begin(), m_candidates.end(),
+                     [](const Candidate& l, const Candidate& r) { return l.distance2 < r.distance2; });
+    m_used.assign(n, 0);
+    for (const auto& c : m_candidates) {
+      if (m_used[c.a] == 0 && m_used[c.b] == 0) {
+        m_used[c.a] = 1;
+        m_used[c.b] = 1;
+        m_pairs.emplace_back(c.a, c.b);
+      }
+    }
+    // tracks in the order of their hits in the first station
+    std::sort(m_pairs.begin(), m_pairs.end());
+  }
+
+  struct Candidate {
+    double distance2;
+    uint32_t a;
+    uint32_t b;
+  };
+
+  FarForwardOptics m_optics;
+  Settings m_settings;
+  Eigen::Matrix2d m_inverseX{Eigen::Matrix2d::Identity()};
+  Eigen::Matrix2d m_inverseY{Eigen::Matrix2d::Identity()};
+  // hits of the event and work buffers, kept to reuse them
+  std::vector<double> m_x, m_y, m_z;
+  std::vector<uint32_t> m_order;
+  std::vector<Candidate> m_candidates;
+  std::vector<char> m_used;
+  std::vector<std::pair<uint32_t, uint32_t>> m_pairs;
+  Eigen::Matrix3Xd m_momenta;
+};
+
+} // namespace Jug::Reco
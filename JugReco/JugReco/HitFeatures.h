@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+#pragma once
+
+#include <array>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "JugReco/CalorimeterHitCache.h"
+
+namespace Jug::Reco {
+
+/** Per-hit features of the ML inputs, by name.
+ *
+ *  The features are read from CalorimeterHitCache: energy, energyError, time, timeError, x, y, z,
+ *  r, eta, phi, layer and sector.
+ *
+ * \ingroup reco
+ */
+enum class HitFeature { kEnergy, kEnergyError, kTime, kTimeError, kX, kY, kZ, kR, kEta, kPhi, kLayer, kSector };
+
+inline constexpr std::array<std::string_view, 12> kHitFeatureNames{
+    "energy", "energyError", "time", "timeError", "x", "y", "z", "r", "eta", "phi", "layer", "sector"};
+
+/// Feature of a name, none if unknown
+inline std::optional<HitFeature> hit_feature(std::string_view name) {
+  for (size_t i = 0; i < kHitFeatureNames.size(); ++i) {
+    if (kHitFeatureNames[i] == name) {
+      return static_cast<HitFeature>(i);
+    }
+  }
+  return std::nullopt;
+}
+
+/// Value of a feature of the i-th hit of the cache
+inline float hit_feature_value(const CalorimeterHitCache& hits, HitFeature feature, size_t i) {
+  switch (feature) {
+  case HitFeature::kEnergy:
+    return hits.energy[i];
+  case HitFeature::kEnergyError:
+    return hits.energyError[i];
+  case HitFeature::kTime:
+    return hits.time[i];
+  case HitFeature::kTimeError:
+    return hits.timeError[i];
+  case HitFeature::kX:
+    return hits.x[i];
+  case HitFeature::kY:
+    return hits.y[i];
+  case HitFeature::kZ:
+    return hits.z[i];
+  case HitFeature::kR:
+    return hits.r[i];
+  case HitFeature::kEta:
+    return hits.eta[i];
+  case HitFeature::kPhi:
+    return hits.phi[i];
+  case HitFeature::kLayer:
+    return static_cast<float>(hits.layer[i]);
+  case HitFeature::kSector:
+    return static_cast<float>(hits.sector[i]);
+  }
+  return 0.f;
+}
+
+} // namespace Jug::Reco
@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Jug::Reco {
+
+/** Constituents of jets as indices of the particles they were found from.
+ *
+ *  The constituents of jet k are particle[begin[k]] to particle[begin[k + 1] - 1], indices of
+ *  the input particle collection of the jet finding, in the order of the jets in their
+ *  collection. Written by JetReco next to the jets, so that the analyses do not need to match
+ *  the particles to the jets again.
+ *
+ * \ingroup reco
+ */
+struct JetConstituents {
+  std::vector<uint32_t> begin{0};
+  std::vector<uint32_t> particle;
+
+  /// Number of jets
+  size_t size() const { return begin.size() - 1; }
+  bool empty() const { return size() == 0; }
+  /// Number of constituents of jet k
+  uint32_t constituents_size(size_t k) const { return begin[k + 1] - begin[k]; }
+
+  /// Add particle i to the current jet
+  void add(uint32_t i) { particle.push_back(i); }
+  /// End the current jet, the next constituents start a new one
+  void close() { begin.push_back(static_cast<uint32_t>(particle.size())); }
+};
+
+} // namespace Jug::Reco
@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "eicd/ProtoClusterCollection.h"
+
+namespace Jug::Reco {
+
+/** Proto-clusters as indices of the hits of their input collection.
+ *
+ *  The hits of proto-cluster k are hit[begin[k]] to hit[begin[k + 1] - 1], indices of the hit
+ *  collection the clustering ran on, with their weights in the same positions of weight. The
+ *  clusterers put it in the event store next to (or instead of) the ProtoClusterCollection, and
+ *  the cluster reconstructions read the hits through it, without a podio relation per hit. The
+ *  podio proto-clusters are only needed when they are written out, see to_collection().
+ *
+ * \ingroup reco
+ */
+struct ProtoClusterIndex {
+  std::vector<uint32_t> begin{0};
+  std::vector<uint32_t> hit;
+  std::vector<float> weight;
+
+  /// Number of proto-clusters
+  size_t size() const { return begin.size() - 1; }
+  bool empty() const { return size() == 0; }
+  /// Number of hits of proto-cluster k
+  uint32_t hits_size(size_t k) const { return begin[k + 1] - begin[k]; }
+
+  void clear() {
+    begin.assign(1, 0);
+    hit.clear();
+    weight.clear();
+  }
+  void reserve(size_t nclusters, size_t nhits) {
+    begin.reserve(nclusters + 1);
+    hit.reserve(nhits);
+    weight.reserve(nhits);
+  }
+
+  /// Add hit i to the current proto-cluster
+  void add(uint32_t i, float w = 1.F) {
+    hit.push_back(i);
+    weight.push_back(w);
+  }
+  /// End the current proto-cluster, the next hits start a new one
+  void close() { begin.push_back(static_cast<uint32_t>(hit.size())); }
+
+  /// Podio proto-clusters of the hits they were made from, appended to proto
+  template <typename Hits> void to_collection(const Hits& hits, eicd::ProtoClusterCollection& proto) const {
+    for (size_t k = 0; k < size(); ++k) {
+      auto pcl = proto.create();
+      for (uint32_t j = begin[k]; j < begin[k + 1]; ++j) {
+        pcl.addToHits(hits[hit[j]]);
+        pcl.addToWeights(weight[j]);
+      }
+    }
+  }
+};
+
+} // namespace Jug::Reco
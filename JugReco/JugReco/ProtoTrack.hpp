@@ -1,21 +0,0 @@
-// This file is part of the Acts project.
-//
-// Copyright (C) 2019 CERN for the benefit of the Acts project
-//
-// This Source Code Form is subject to the terms of the Mozilla Public
-// License, v. 2.0. If a copy of the MPL was not distributed with this
-// file, You can obtain one at http://mozilla.org/MPL/2.0/.
-
-#pragma once
-
-#include <cstddef>
-#include <vector>
-
-namespace FW {
-
-/// A proto track is a collection of hits identified by their indices.
-using ProtoTrack = std::vector<size_t>;
-/// Container of proto tracks. Each proto track is identified by its index.
-using ProtoTrackContainer = std::vector<ProtoTrack>;
-
-}  // namespace FW
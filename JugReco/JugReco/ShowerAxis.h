@@ -0,0 +1,98 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+#include <Eigen/Dense>
+
+#include "eicd/Vector3f.h"
+
+namespace Jug::Reco {
+
+/** Weighted moments of a set of positions (hits or layer centroids).
+ *
+ *  Accumulated in the loops that already go over the positions, the weighted mean and the 3x3
+ *  covariance are then available without another pass.
+ *
+ * \ingroup reco
+ */
+struct PositionMoments {
+  double sumOfWeights{0};
+  double x{0}, y{0}, z{0};
+  double xx{0}, xy{0}, xz{0}, yy{0}, yz{0}, zz{0};
+
+  void add(double px, double py, double pz, double w) {
+    sumOfWeights += w;
+    x += w * px;
+    y += w * py;
+    z += w * pz;
+    xx += w * px * px;
+    xy += w * px * py;
+    xz += w * px * pz;
+    yy += w * py * py;
+    yz += w * py * pz;
+    zz += w * pz * pz;
+  }
+  void add(const eicd::Vector3f& p, double w) { add(p.x, p.y, p.z, w); }
+
+  Eigen::Vector3d mean() const { return Eigen::Vector3d(x, y, z) / sumOfWeights; }
+
+  /// Weighted covariance, normalized by the sum of weights
+  Eigen::Matrix3d covariance() const {
+    const Eigen::Vector3d m = mean();
+    Eigen::Matrix3d cov;
+    cov(0, 0) = xx / sumOfWeights - m.x() * m.x();
+    cov(0, 1) = xy / sumOfWeights - m.x() * m.y();
+    cov(0, 2) = xz / sumOfWeights - m.x() * m.z();
+    cov(1, 1) = yy / sumOfWeights - m.y() * m.y();
+    cov(1, 2) = yz / sumOfWeights - m.y() * m.z();
+    cov(2, 2) = zz / sumOfWeights - m.z() * m.z();
+    cov(1, 0) = cov(0, 1);
+    cov(2, 0) = cov(0, 2);
+    cov(2, 1) = cov(1, 2);
+    return cov;
+  }
+};
+
+/// Principal axis of a set of positions, with the RMS spreads along and across it
+struct ShowerAxis {
+  bool valid{false};
+  double theta{0};
+  double phi{0};
+  // RMS along the axis and transverse to it
+  double length{0};
+  double width{0};
+};
+
+/** Principal axis from the moments, with the closed-form solver of the 3x3 covariance.
+ *
+ *  The axis is the eigenvector of the largest eigenvalue, pointing away from the origin (the sign
+ *  of a fitted axis is otherwise arbitrary). Not valid without a positive sum of weights.
+ */
+inline ShowerAxis principal_axis(const PositionMoments& moments) {
+  ShowerAxis axis;
+  if (!(moments.sumOfWeights > 0.)) {
+    return axis;
+  }
+  Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver;
+  solver.computeDirect(moments.covariance());
+  if (solver.info() != Eigen::Success) {
+    return axis;
+  }
+  // eigenvalues in increasing order
+  const Eigen::Vector3d lambda = solver.eigenvalues().cwiseMax(0.);
+  Eigen::Vector3d dir          = solver.eigenvectors().col(2);
+  if (dir.dot(moments.mean()) < 0.) {
+    dir = -dir;
+  }
+  axis.valid  = true;
+  axis.theta  = std::acos(std::clamp(dir.z(), -1., 1.));
+  axis.phi    = std::atan2(dir.y(), dir.x());
+  axis.length = std::sqrt(lambda(2));
+  axis.width  = std::sqrt(lambda(0) + lambda(1));
+  return axis;
+}
+
+} // namespace Jug::Reco
@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// the neighbour criteria are shared by the host and the device implementations
+#if defined(__CUDACC__)
+#define JUG_HOST_DEVICE __host__ __device__
+#else
+#define JUG_HOST_DEVICE
+#endif
+
+namespace Jug::Reco {
+
+  /// Neighbour criteria of ImagingTopoCluster, in juggler units (mm, rad, ns)
+  struct TopoNeighbourParams {
+    double localDistX{0.};
+    double localDistY{0.};
+    double layerDistEta{0.};
+    double layerDistPhi{0.};
+    double sectorDist{0.};
+    double timeWindow{0.};
+    int layerRange{1};
+  };
+
+  /// Hits of ImagingTopoCluster as flat arrays, in the types of the hit fields
+  template <typename Angle> struct TopoHitArrays {
+    const float* x{nullptr};
+    const float* y{nullptr};
+    const float* z{nullptr};
+    const float* localX{nullptr};
+    const float* localY{nullptr};
+    const Angle* eta{nullptr};
+    const Angle* phi{nullptr};
+    const float* time{nullptr};
+    const int* sector{nullptr};
+    const int* layer{nullptr};
+  };
+
+  /** Whether hits i and j are neighbours.
+   *
+   *  Within the time window (if positive), and in different sectors within sectorDist, in the same
+   *  layer within the local distances, or in neighbour layers within the (eta, phi) distances. The
+   *  arithmetic is the same on the host and the device (without contracted multiply-adds), so that
+   *  both find the same neighbours.
+   */
+  template <typename Angle>
+  JUG_HOST_DEVICE inline bool topoNeighbours(const TopoHitArrays<Angle>& h, const TopoNeighbourParams& p, size_t i,
+                                             size_t j) {
+    if (p.timeWindow > 0. && fabs(static_cast<double>(h.time[i]) - static_cast<double>(h.time[j])) > p.timeWindow) {
+      return false;
+    }
+    // different sectors, simple distance check
+    if (h.sector[i] != h.sector[j]) {
+      const float dx = h.x[i] - h.x[j];
+      const float dy = h.y[i] - h.y[j];
+      const float dz = h.z[i] - h.z[j];
+      return sqrtf(dx * dx + dy * dy + dz * dz) <= p.sectorDist;
+    }
+
+    // layer check
+    const int ldiff = (h.layer[i] > h.layer[j]) ? h.layer[i] - h.layer[j] : h.layer[j] - h.layer[i];
+    // same layer, check local positions
+    if (ldiff == 0) {
+      return (fabsf(h.localX[i] - h.localX[j]) <= p.localDistX) && (fabsf(h.localY[i] - h.localY[j]) <= p.localDistY);
+    } else if (ldiff <= p.layerRange) {
+      return (fabs(static_cast<double>(h.eta[i] - h.eta[j])) <= p.layerDistEta) &&
+             (fabs(static_cast<double>(h.phi[i] - h.phi[j])) <= p.layerDistPhi);
+    }
+
+    // not in adjacent layers
+    return false;
+  }
+
+#if defined(JUGGLER_HAVE_CUDA)
+  /// Whether a CUDA device is available for topoComponentsCUDA
+  bool topoCUDAAvailable();
+  /** Connected components of the hits on the CUDA device.
+   *
+   *  The candidate pairs (first[k], second[k]) that are neighbours are joined, root[i] is the
+   *  smallest hit of the component of hit i, as for the union-find on the host. False (and root
+   *  unchanged) on failure.
+   */
+  bool topoComponentsCUDA(const TopoHitArrays<double>& hits, size_t nhits, const TopoNeighbourParams& params,
+                          const std::vector<uint32_t>& first, const std::vector<uint32_t>& second,
+                          std::vector<uint32_t>& root);
+#endif
+
+} // namespace Jug::Reco
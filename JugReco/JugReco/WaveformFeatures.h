@@ -0,0 +1,161 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "JugBase/CalorimeterWaveforms.h"
+
+namespace Jug::Reco {
+
+/// Settings of the waveform feature extraction, times in ns
+struct WaveformFeatureParams {
+  /// Samples at the start of the waveforms for the pedestal, the pedestal is 0 without
+  size_t presamples{4};
+  /// Constant fraction of the amplitude for the time, the time of the peak if not positive
+  double cfdFraction{0.};
+};
+
+/** Amplitude (ADC counts above the pedestal), time (ns) and pedestal of sampled waveforms.
+ *
+ *  All the channels are processed together in passes over the flat sample buffer: the pedestal
+ *  is the mean of the presamples, the peak is the largest sample after the pedestal subtraction
+ *  with a parabola through it and its neighbours for the amplitude and the time, and the constant
+ *  fraction time is the linear interpolation of the first crossing of the fraction of the
+ *  amplitude before the peak. With a pulse shape template, fit() replaces the amplitude and the
+ *  time with those of the template.
+ *
+ * \ingroup reco
+ */
+struct WaveformFeatures {
+  std::vector<float> pedestal;
+  std::vector<float> amplitude;
+  std::vector<float> time;
+
+  size_t size() const { return amplitude.size(); }
+
+  void extract(const Jug::Base::CalorimeterWaveforms& waves, const WaveformFeatureParams& params) {
+    const size_t nchan = waves.size();
+    const size_t ns    = waves.nSamples;
+    const size_t npre  = std::min(params.presamples, ns);
+    pedestal.assign(nchan, 0.F);
+    amplitude.assign(nchan, 0.F);
+    time.assign(nchan, static_cast<float>(waves.startTime));
+    m_peakTime.assign(nchan, static_cast<float>(waves.startTime));
+    if (ns == 0) {
+      return;
+    }
+
+    // pedestal subtracted samples of all the channels
+    m_signal.resize(nchan * ns);
+    for (size_t c = 0; c < nchan; ++c) {
+      const int32_t* in = waves.channel(c);
+      float sum         = 0.F;
+      for (size_t k = 0; k < npre; ++k) {
+        sum += static_cast<float>(in[k]);
+      }
+      const float ped = (npre > 0) ? sum / static_cast<float>(npre) : 0.F;
+      float* out      = m_signal.data() + c * ns;
+      for (size_t k = 0; k < ns; ++k) {
+        out[k] = static_cast<float>(in[k]) - ped;
+      }
+      pedestal[c] = ped;
+    }
+
+    const auto period = static_cast<float>(waves.samplingPeriod);
+    const auto start  = static_cast<float>(waves.startTime);
+    for (size_t c = 0; c < nchan; ++c) {
+      const float* s = m_signal.data() + c * ns;
+      size_t peak    = 0;
+      for (size_t k = 1; k < ns; ++k) {
+        peak = (s[k] > s[peak]) ? k : peak;
+      }
+      // parabola through the peak and its neighbours
+      float amp   = s[peak];
+      float shift = 0.F;
+      if (peak > 0 && peak + 1 < ns) {
+        const float denom = s[peak - 1] - 2.F * s[peak] + s[peak + 1];
+        if (denom < 0.F) {
+          shift = 0.5F * (s[peak - 1] - s[peak + 1]) / denom;
+          amp   = s[peak] - 0.25F * (s[peak - 1] - s[peak + 1]) * shift;
+        }
+      }
+      float t       = static_cast<float>(peak) + shift;
+      m_peakTime[c] = start + t * period;
+      if (params.cfdFraction > 0. && amp > 0.F) {
+        const auto level = static_cast<float>(params.cfdFraction) * amp;
+        size_t k         = peak;
+        while (k > 0 && s[k - 1] >= level) {
+          --k;
+        }
+        if (k > 0) {
+          t = static_cast<float>(k - 1) + (level - s[k - 1]) / (s[k] - s[k - 1]);
+        }
+      }
+      amplitude[c] = amp;
+      time[c]      = start + t * period;
+    }
+  }
+
+  /** Template fit of the amplitude and the time of the extracted channels.
+   *
+   *  The pulse start times within one sampling period of the estimate from the peak (whatever the
+   *  timing of extract()) are scanned at the phases of the template table, the amplitude of each
+   *  is the least squares one, and the start with the smallest chi2 is kept. The time is then the
+   *  peak of the fitted template. Channels in mask are fitted (all without mask), after extract().
+   */
+  void fit(const Jug::Base::CalorimeterWaveforms& waves, const Jug::Base::PulseShape& shape,
+           const std::vector<char>* mask = nullptr) {
+    const size_t ns     = waves.nSamples;
+    const size_t over   = shape.oversampling();
+    const double period = waves.samplingPeriod;
+    const double dt     = period / static_cast<double>(over);
+    std::vector<float> templ(ns);
+    for (size_t c = 0; c < size(); ++c) {
+      if ((mask != nullptr && (*mask)[c] == 0) || amplitude[c] <= 0.F) {
+        continue;
+      }
+      const float* s   = m_signal.data() + c * ns;
+      const double t0  = m_peakTime[c] - shape.peakTime();
+      double best      = std::numeric_limits<double>::max();
+      float bestAmp    = amplitude[c];
+      double bestStart = t0;
+      for (size_t p = 0; p <= 2 * over; ++p) {
+        const double tstart = t0 + (static_cast<double>(p) - static_cast<double>(over)) * dt;
+        std::fill(templ.begin(), templ.end(), 0.F);
+        shape.add(templ.data(), ns, waves.startTime, tstart, 1.F);
+        float sy = 0.F;
+        float tt = 0.F;
+        float yy = 0.F;
+        for (size_t k = 0; k < ns; ++k) {
+          sy += s[k] * templ[k];
+          tt += templ[k] * templ[k];
+          yy += s[k] * s[k];
+        }
+        if (tt <= 0.F) {
+          continue;
+        }
+        // chi2 of the least squares amplitude sy / tt
+        const double chi2 = yy - static_cast<double>(sy) * sy / tt;
+        if (chi2 < best) {
+          best      = chi2;
+          bestAmp   = sy / tt;
+          bestStart = tstart;
+        }
+      }
+      amplitude[c] = bestAmp;
+      time[c]      = static_cast<float>(bestStart + shape.peakTime());
+    }
+  }
+
+private:
+  std::vector<float> m_signal;
+  std::vector<float> m_peakTime;
+};
+
+} // namespace Jug::Reco
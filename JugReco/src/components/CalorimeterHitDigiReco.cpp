@@ -0,0 +1,218 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+// Digitization and reconstruction of calorimeter hits in one algorithm, for the studies that only
+// use the reconstructed hits: Jug::Digi::CalorimeterHitDigi followed by CalorimeterHitReco,
+// without the raw hit collection
+
+#include "fmt/format.h"
+#include <algorithm>
+#include <variant>
+#include <vector>
+
+#include "Gaudi/Property.h"
+#include "GaudiKernel/PhysicalConstants.h"
+#include "GaudiKernel/ThreadLocalContext.h"
+
+#include "JugBase/ICellGeometrySvc.h"
+#include "JugBase/IGeoSvc.h"
+#include "JugBase/IRandomSvc.h"
+#include "JugBase/Transformer.h"
+#include "JugDigi/CalorimeterHitDigi.h"
+
+// Event Model related classes
+#include "edm4hep/SimCalorimeterHitCollection.h"
+#include "eicd/CalorimeterHitCollection.h"
+
+using namespace Gaudi::Units;
+
+namespace Jug::Reco {
+
+/** Calorimeter hit digitization and reconstruction.
+ *
+ *  The hits are digitized by Jug::Digi::CalorimeterHitDigi into flat arrays of ADC and TDC values,
+ *  with the random numbers of the RandomSvc event key of this algorithm, and reconstructed from
+ *  them as in CalorimeterHitReco: same quantization, zero suppression and conversion back to
+ *  energy and time, with the ADC and TDC settings of the digitization for both. The geometry of the
+ *  cells above the threshold is looked up once, from CellGeometrySvc.
+ *
+ *  The properties are the ones of CalorimeterHitDigi (readoutClass is shared, for the signal sum
+ *  fields and the layer/sector fields) and the reconstruction ones of CalorimeterHitReco.
+ *
+ * \ingroup reco
+ */
+class CalorimeterHitDigiReco
+    : public Jug::Transformer<eicd::CalorimeterHitCollection, edm4hep::SimCalorimeterHitCollection> {
+private:
+  // length unit from dd4hep, should be fixed
+  Gaudi::Property<double> m_lUnit{this, "lengthUnit", dd4hep::mm};
+
+  // zero suppression values
+  Gaudi::Property<double> m_thresholdFactor{this, "thresholdFactor", 0.0};
+  Gaudi::Property<double> m_thresholdValue{this, "thresholdValue", 0.0};
+
+  // energy correction with sampling fraction
+  Gaudi::Property<double> m_sampFrac{this, "samplingFraction", 1.0};
+
+  // geometry service to get ids, ignored if no names provided
+  Gaudi::Property<std::string> m_geoSvcName{this, "geoServiceName", "GeoSvc"};
+  Gaudi::Property<std::string> m_cellGeoSvcName{this, "cellGeometryServiceName", "CellGeometrySvc"};
+  Gaudi::Property<std::string> m_randomSvcName{this, "randomServiceName", "RandomSvc"};
+  Gaudi::Property<std::string> m_layerField{this, "layerField", ""};
+  Gaudi::Property<std::string> m_sectorField{this, "sectorField", ""};
+  SmartIF<IGeoSvc> m_geoSvc;
+  SmartIF<IRandomSvc> m_randomSvc;
+
+  // name of detelment or fields to find the local detector (for global->local transform)
+  // if nothing is provided, the lowest level DetElement (from cellID) will be used
+  Gaudi::Property<std::string> m_localDetElement{this, "localDetElement", ""};
+  Gaudi::Property<std::vector<std::string>> u_localDetFields{this, "localDetFields", {}};
+
+  // cached cell positions, dimensions and layer/sector ids, shared with the other hit reconstructions
+  SmartIF<ICellGeometrySvc> m_cellGeoSvc;
+  const Jug::Base::CellGeometryTable* m_cellGeometry{nullptr};
+
+  // the digitization, its properties are declared as properties of this algorithm
+  Jug::Digi::CalorimeterHitDigi m_digi;
+
+  // unitless counterparts of the input parameters
+  double thresholdADC{0};
+
+public:
+  CalorimeterHitDigiReco(const std::string& name, ISvcLocator* svcLoc)
+      : MultiTransformer(name, svcLoc, {KeyValue{"inputHitCollection", "inputHitCollection"}},
+                         {KeyValue{"outputHitCollection", "outputHitCollection"}})
+      , m_digi(name) {
+    for (const auto& [key, value] : m_digi.properties()) {
+      std::visit([this, &key = key](auto* ref) { declareProperty(key, *ref); }, value);
+    }
+  }
+
+  StatusCode initialize() override {
+    if (Gaudi::Algorithm::initialize().isFailure()) {
+      return StatusCode::FAILURE;
+    }
+
+    m_geoSvc = service(m_geoSvcName);
+    if (!m_geoSvc) {
+      error() << "Unable to locate Geometry Service. "
+              << "Make sure you have GeoSvc and SimSvc in the right order in the configuration." << endmsg;
+      return StatusCode::FAILURE;
+    }
+    m_randomSvc = service(m_randomSvcName);
+    if (!m_randomSvc) {
+      error() << "Unable to locate Random Service. "
+              << "Make sure you have RandomSvc in the configuration." << endmsg;
+      return StatusCode::FAILURE;
+    }
+
+    m_digi.setLogSink([this](Jug::LogLevel level, const std::string& msg) {
+      switch (level) {
+      case Jug::LogLevel::kDebug:
+        debug() << msg << endmsg;
+        break;
+      case Jug::LogLevel::kInfo:
+        info() << msg << endmsg;
+        break;
+      case Jug::LogLevel::kWarning:
+        warning() << msg << endmsg;
+        break;
+      default:
+        error() << msg << endmsg;
+        break;
+      }
+    });
+    m_digi.setLogLevel(msgLevel(MSG::DEBUG) ? Jug::LogLevel::kDebug : Jug::LogLevel::kInfo);
+    if (!m_digi.initialize(m_geoSvc->detector())) {
+      return StatusCode::FAILURE;
+    }
+
+    // threshold for firing
+    thresholdADC = m_thresholdFactor.value() * m_digi.m_pedSigmaADC.value() + m_thresholdValue.value();
+
+    m_cellGeoSvc = service(m_cellGeoSvcName);
+    if (!m_cellGeoSvc) {
+      error() << "Unable to locate Cell Geometry Service " << m_cellGeoSvcName.value() << endmsg;
+      return StatusCode::FAILURE;
+    }
+    // local detector name has higher priority than the fields
+    m_cellGeometry = m_cellGeoSvc->geometryTable(
+        {m_digi.m_readout.value(), m_localDetElement.value(),
+         m_localDetElement.value().empty() ? u_localDetFields.value() : std::vector<std::string>{}, m_layerField.value(),
+         m_sectorField.value()});
+    if (m_cellGeometry == nullptr) {
+      error() << "Failed to set up the cell geometry of " << m_digi.m_readout.value() << endmsg;
+      return StatusCode::FAILURE;
+    }
+
+    return StatusCode::SUCCESS;
+  }
+
+  void operator()(const edm4hep::SimCalorimeterHitCollection& simhits,
+                  eicd::CalorimeterHitCollection& hits) const override {
+    const auto key = m_randomSvc->eventKey(name(), Gaudi::Hive::currentContext().evt());
+    const auto raw = m_digi.digitize(simhits, key);
+
+    // hits above the threshold, their cell geometries are looked up together
+    const unsigned int pedMean = m_digi.m_pedMeanADC.value();
+    const unsigned int capADC  = m_digi.m_capADC.value();
+    std::vector<uint64_t> cellIDs;
+    std::vector<float> energies;
+    std::vector<float> times;
+    cellIDs.reserve(raw.size());
+    energies.reserve(raw.size());
+    times.reserve(raw.size());
+    for (size_t i = 0; i < raw.size(); ++i) {
+      // the raw hit amplitude and time stamp as read by CalorimeterHitReco
+      const auto amplitude = static_cast<uint32_t>(raw.amplitude[i]);
+      const auto timeStamp = static_cast<uint32_t>(raw.timeStamp[i]);
+      // did not pass the zero-suppression threshold
+      if (amplitude < pedMean + thresholdADC) {
+        continue;
+      }
+      // convert ADC -> energy
+      cellIDs.push_back(raw.cellID[i]);
+      energies.push_back((static_cast<int>(amplitude) - static_cast<int>(pedMean)) / static_cast<float>(capADC) *
+                         m_digi.dyRangeADC / m_sampFrac);
+      times.push_back(timeStamp / m_digi.stepTDC);
+    }
+
+    std::vector<const Jug::Base::CellGeometry*> geometries;
+    m_cellGeometry->geometry(cellIDs, geometries);
+
+    for (size_t i = 0; i < cellIDs.size(); ++i) {
+      const auto& geo = *geometries[i];
+
+      // create const vectors for passing to hit initializer list
+      const decltype(eicd::CalorimeterHitData::position) position(
+        geo.global.x() / m_lUnit, geo.global.y() / m_lUnit, geo.global.z() / m_lUnit
+      );
+      const decltype(eicd::CalorimeterHitData::dimension) dimension(
+        geo.dimension[0] / m_lUnit, geo.dimension[1] / m_lUnit, geo.dimension[2] / m_lUnit
+      );
+      const decltype(eicd::CalorimeterHitData::local) local_position(
+        geo.local.x() / m_lUnit, geo.local.y() / m_lUnit, geo.local.z() / m_lUnit
+      );
+
+      hits.push_back({
+          cellIDs[i],     // cellID
+          energies[i],    // energy
+          0,              // @TODO: energy error
+          times[i],       // time
+          0,              // time error FIXME should be configurable
+          position,       // global pos
+          dimension,
+          // Local hit info
+          geo.sector,
+          geo.layer,
+          local_position, // local pos
+      });
+    }
+  }
+
+}; // class CalorimeterHitDigiReco
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(CalorimeterHitDigiReco)
+
+} // namespace Jug::Reco
@@ -8,12 +8,12 @@
 #include "fmt/format.h"
 #include "fmt/ranges.h"
 #include <algorithm>
-#include <bitset>
+#include <cmath>
+#include <memory>
+#include <vector>
 
 #include "Gaudi/Property.h"
-#include "GaudiAlg/GaudiAlgorithm.h"
-#include "GaudiAlg/GaudiTool.h"
-#include "GaudiAlg/Transformer.h"
+#include "GaudiKernel/GaudiException.h"
 #include "GaudiKernel/PhysicalConstants.h"
 #include "GaudiKernel/RndmGenerators.h"
 #include "GaudiKernel/ToolHandle.h"
@@ -22,8 +22,14 @@
 #include "DDRec/Surface.h"
 #include "DDRec/SurfaceManager.h"
 
+#include "JugBase/CalorimeterWaveforms.h"
 #include "JugBase/DataHandle.h"
+#include "JugBase/ICalibrationSvc.h"
+#include "JugBase/ICellGeometrySvc.h"
 #include "JugBase/IGeoSvc.h"
+#include "JugBase/Transformer.h"
+
+#include "JugReco/WaveformFeatures.h"
 
 // Event Model related classes
 #include "eicd/CalorimeterHitCollection.h"
@@ -36,9 +42,22 @@ namespace Jug::Reco {
 /** Calorimeter hit reconstruction.
  *
  * Reconstruct digitized outputs, paired with Jug::Digi::CalorimeterHitDigi
+ *
+ * With calibration, the pedestalMean, pedestalSigma, samplingFraction and thresholdValue of a
+ * channel are the per-channel constants of that name in the calibration (CalibrationSvc) for the
+ * run, the properties for the channels and constants not in the calibration. The constants of the
+ * hits are gathered in array loops before the reconstruction.
+ *
+ * With inputWaveforms, the hits are reconstructed from the sampled waveforms of
+ * Jug::Digi::CalorimeterWaveformDigi instead of the raw hits: the pedestal is the mean of the
+ * waveformPresamples (pedestalMean without presamples), the amplitude is that of the peak and the
+ * time that of the peak or of the cfdFraction of the amplitude (waveformTiming), or both are those
+ * of a fit of the pulse shape template (waveformTemplateFit, with the shape of the digitization).
+ * The features of all the channels are extracted together, see WaveformFeatures.
  * \ingroup reco
  */
-class CalorimeterHitReco : public GaudiAlgorithm {
+class CalorimeterHitReco
+    : public Jug::Transformer<eicd::CalorimeterHitCollection, eicd::RawCalorimeterHitCollection> {
 private:
   // length unit from dd4hep, should be fixed
   Gaudi::Property<double> m_lUnit{this, "lengthUnit", dd4hep::mm};
@@ -57,40 +76,60 @@ private:
   // energy correction with sampling fraction
   Gaudi::Property<double> m_sampFrac{this, "samplingFraction", 1.0};
 
+  // per-channel constants, the properties above otherwise
+  Gaudi::Property<std::string> m_calibSvcName{this, "calibrationServiceName", "CalibrationSvc"};
+  Gaudi::Property<std::string> m_calibrationName{this, "calibration", "", "Calibration of the channels (optional)"};
+  SmartIF<ICalibrationSvc> m_calibSvc;
+  const Jug::Base::Calibration* m_calibration{nullptr};
+  int m_pedMeanColumn{-1};
+  int m_pedSigmaColumn{-1};
+  int m_sampFracColumn{-1};
+  int m_thresholdColumn{-1};
+
+  // sampled waveforms, instead of the raw hits
+  Gaudi::Property<std::string> m_inputWaveforms{this, "inputWaveforms", ""};
+  std::unique_ptr<DataHandle<Jug::Base::CalorimeterWaveforms>> m_inputWaveforms_ptr;
+  Gaudi::Property<unsigned int> m_presamples{this, "waveformPresamples", 4};
+  Gaudi::Property<std::string> m_waveformTiming{this, "waveformTiming", "peak"}; // peak or cfd
+  Gaudi::Property<double> m_cfdFraction{this, "cfdFraction", 0.5};
+  Gaudi::Property<bool> m_templateFit{this, "waveformTemplateFit", false};
+  // pulse shape template, must be consistent with the waveform digitization
+  Gaudi::Property<std::string> m_pulseShape{this, "pulseShape", "crrc"};
+  Gaudi::Property<double> m_shapingTime{this, "pulseShapingTime", 10. * ns};
+  Gaudi::Property<unsigned int> m_pulseOrder{this, "pulseOrder", 4};
+  Gaudi::Property<double> m_samplingPeriod{this, "samplingPeriod", 4. * ns};
+  Gaudi::Property<unsigned int> m_oversampling{this, "lutOversampling", 32};
+  Jug::Reco::WaveformFeatureParams m_waveformParams;
+  Jug::Base::PulseShape m_template;
+
   // unitless counterparts of the input parameters
   double dyRangeADC{0};
-  double thresholdADC{0};
   double stepTDC{0};
 
-  DataHandle<eicd::RawCalorimeterHitCollection> m_inputHitCollection{"inputHitCollection", Gaudi::DataHandle::Reader,
-                                                                    this};
-  DataHandle<eicd::CalorimeterHitCollection> m_outputHitCollection{"outputHitCollection", Gaudi::DataHandle::Writer,
-                                                                  this};
-
   // geometry service to get ids, ignored if no names provided
   Gaudi::Property<std::string> m_geoSvcName{this, "geoServiceName", "GeoSvc"};
+  Gaudi::Property<std::string> m_cellGeoSvcName{this, "cellGeometryServiceName", "CellGeometrySvc"};
   Gaudi::Property<std::string> m_readout{this, "readoutClass", ""};
   Gaudi::Property<std::string> m_layerField{this, "layerField", ""};
   Gaudi::Property<std::string> m_sectorField{this, "sectorField", ""};
   SmartIF<IGeoSvc> m_geoSvc;
-  dd4hep::BitFieldCoder* id_dec = nullptr;
-  size_t sector_idx{0}, layer_idx{0};
 
   // name of detelment or fields to find the local detector (for global->local transform)
   // if nothing is provided, the lowest level DetElement (from cellID) will be used
   Gaudi::Property<std::string> m_localDetElement{this, "localDetElement", ""};
   Gaudi::Property<std::vector<std::string>> u_localDetFields{this, "localDetFields", {}};
-  dd4hep::DetElement local;
-  size_t local_mask = ~0;
+
+  // cached cell positions, dimensions and layer/sector ids, shared with the other hit reconstructions
+  SmartIF<ICellGeometrySvc> m_cellGeoSvc;
+  const Jug::Base::CellGeometryTable* m_cellGeometry{nullptr};
 
 public:
-  CalorimeterHitReco(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
-    declareProperty("inputHitCollection", m_inputHitCollection, "");
-    declareProperty("outputHitCollection", m_outputHitCollection, "");
-  }
+  CalorimeterHitReco(const std::string& name, ISvcLocator* svcLoc)
+      : MultiTransformer(name, svcLoc, {KeyValue{"inputHitCollection", "inputHitCollection"}},
+                         {KeyValue{"outputHitCollection", "outputHitCollection"}}) {}
 
   StatusCode initialize() override {
-    if (GaudiAlgorithm::initialize().isFailure()) {
+    if (Gaudi::Algorithm::initialize().isFailure()) {
       return StatusCode::FAILURE;
     }
 
@@ -104,136 +143,243 @@ public:
     // unitless conversion
     dyRangeADC = m_dyRangeADC.value() / GeV;
 
-    // threshold for firing
-    thresholdADC = m_thresholdFactor.value() * m_pedSigmaADC.value() + m_thresholdValue.value();
-
     // TDC channels to timing conversion
     stepTDC = ns / m_resolutionTDC.value();
 
-    // do not get the layer/sector ID if no readout class provided
-    if (m_readout.value().empty()) {
-      return StatusCode::SUCCESS;
+    // the layer/sector ID and the local fields are not used if no readout class provided
+    m_cellGeoSvc = service(m_cellGeoSvcName);
+    if (!m_cellGeoSvc) {
+      error() << "Unable to locate Cell Geometry Service " << m_cellGeoSvcName.value() << endmsg;
+      return StatusCode::FAILURE;
+    }
+    // local detector name has higher priority than the fields
+    m_cellGeometry = m_cellGeoSvc->geometryTable(
+        {m_readout.value(), m_localDetElement.value(),
+         m_localDetElement.value().empty() ? u_localDetFields.value() : std::vector<std::string>{}, m_layerField.value(),
+         m_sectorField.value()});
+    if (m_cellGeometry == nullptr) {
+      error() << "Failed to set up the cell geometry of " << m_readout.value() << endmsg;
+      return StatusCode::FAILURE;
+    }
+    if (!m_localDetElement.value().empty()) {
+      info() << "Local coordinate system from DetElement " << m_localDetElement.value() << endmsg;
+    } else {
+      info() << fmt::format("Local coordinate system from DetElement fields [{}]",
+                            fmt::join(u_localDetFields.value(), ", "))
+             << endmsg;
     }
 
-    auto id_spec = m_geoSvc->detector()->readout(m_readout).idSpec();
-    try {
-      id_dec = id_spec.decoder();
-      if (!m_sectorField.value().empty()) {
-        sector_idx = id_dec->index(m_sectorField);
-        info() << "Find sector field " << m_sectorField.value() << ", index = " << sector_idx << endmsg;
+    if (!m_calibrationName.value().empty()) {
+      m_calibSvc = service(m_calibSvcName);
+      if (!m_calibSvc) {
+        error() << "Unable to locate Calibration Service " << m_calibSvcName.value() << endmsg;
+        return StatusCode::FAILURE;
       }
-      if (!m_layerField.value().empty()) {
-        layer_idx = id_dec->index(m_layerField);
-        info() << "Find layer field " << m_layerField.value() << ", index = " << sector_idx << endmsg;
+      m_calibration = m_calibSvc->calibration(m_calibrationName.value());
+      if (m_calibration == nullptr) {
+        error() << "Failed to load the calibration " << m_calibrationName.value() << endmsg;
+        return StatusCode::FAILURE;
       }
-    } catch (...) {
-      error() << "Failed to load ID decoder for " << m_readout << endmsg;
-      return StatusCode::FAILURE;
+      m_pedMeanColumn   = m_calibration->column("pedestalMean");
+      m_pedSigmaColumn  = m_calibration->column("pedestalSigma");
+      m_sampFracColumn  = m_calibration->column("samplingFraction");
+      m_thresholdColumn = m_calibration->column("thresholdValue");
     }
 
-    // local detector name has higher priority
-    if (!m_localDetElement.value().empty()) {
-      try {
-        local = m_geoSvc->detector()->detector(m_localDetElement.value());
-        info() << "Local coordinate system from DetElement " << m_localDetElement.value() << endmsg;
-      } catch (...) {
-        error() << "Failed to locate local coordinate system from DetElement " << m_localDetElement.value() << endmsg;
+    if (!m_inputWaveforms.value().empty()) {
+      m_inputWaveforms_ptr = std::make_unique<DataHandle<Jug::Base::CalorimeterWaveforms>>(
+          m_inputWaveforms, Gaudi::DataHandle::Reader, this);
+      if (m_waveformTiming.value() != "peak" && m_waveformTiming.value() != "cfd") {
+        error() << "Unknown waveformTiming " << m_waveformTiming.value() << ", peak or cfd" << endmsg;
         return StatusCode::FAILURE;
       }
-      // or get from fields
-    } else {
-      std::vector<std::pair<std::string, int>> fields;
-      for (auto& f : u_localDetFields.value()) {
-        fields.emplace_back(f, 0);
+      m_waveformParams.presamples  = m_presamples.value();
+      m_waveformParams.cfdFraction = (m_waveformTiming.value() == "cfd") ? m_cfdFraction.value() : 0.;
+      if (m_templateFit && m_presamples.value() == 0) {
+        error() << "waveformTemplateFit needs the pedestal of the waveformPresamples" << endmsg;
+        return StatusCode::FAILURE;
       }
-      local_mask = id_spec.get_mask(fields);
-      // use all fields if nothing provided
-      if (fields.empty()) {
-        local_mask = ~0;
+      if (m_templateFit) {
+        m_template = Jug::Base::PulseShape(m_pulseShape.value(), m_shapingTime.value() / ns, m_pulseOrder.value(),
+                                           m_samplingPeriod.value() / ns, m_oversampling.value(), kMaxTemplateSamples);
+        if (!m_template.valid()) {
+          error() << "Invalid pulse shape template " << m_pulseShape.value() << endmsg;
+          return StatusCode::FAILURE;
+        }
       }
-      info() << fmt::format("Local DetElement mask {:#064b} from fields [{}]", local_mask, fmt::join(fields, ", "))
-             << endmsg;
     }
 
     return StatusCode::SUCCESS;
   }
 
-  StatusCode execute() override {
-    // input collections
-    const auto& rawhits = *m_inputHitCollection.get();
-    // create output collections
-    auto& hits     = *m_outputHitCollection.createAndPut();
-    auto converter = m_geoSvc->cellIDPositionConverter();
+  void operator()(const eicd::RawCalorimeterHitCollection& rawhits,
+                  eicd::CalorimeterHitCollection& hits) const override {
+    if (m_inputWaveforms_ptr) {
+      reconstruct(*m_inputWaveforms_ptr->get(), hits);
+      return;
+    }
 
-    // energy time reconstruction
-    for (const auto& rh : rawhits) {
+    const size_t n = rawhits.size();
+    std::vector<uint64_t> rawIDs(n);
+    for (size_t i = 0; i < n; ++i) {
+      rawIDs[i] = rawhits[i].getCellID();
+    }
+
+    // constants of the hits, those of the properties without calibration
+    const auto constants        = channelConstants(rawIDs);
+    const auto& pedMeans        = constants.pedMeans;
+    const auto& pedSigmas       = constants.pedSigmas;
+    const auto& sampFracs       = constants.sampFracs;
+    const auto& thresholdValues = constants.thresholdValues;
+
+    // hits above the threshold, their cell geometries are looked up together
+    std::vector<uint64_t> cellIDs;
+    std::vector<float> energies;
+    std::vector<float> times;
+    cellIDs.reserve(n);
+    energies.reserve(n);
+    times.reserve(n);
 
-      #pragma GCC diagnostic push
-      #pragma GCC diagnostic error "-Wsign-conversion"
+    // energy time reconstruction
+    const double thresholdFactor = m_thresholdFactor.value();
+    for (size_t i = 0; i < n; ++i) {
+      const auto rh             = rawhits[i];
+      const double amplitude    = rh.getAmplitude();
+      const double pedMean      = pedMeans[i];
+      const double thresholdADC = thresholdFactor * pedSigmas[i] + thresholdValues[i];
 
       // did not pass the zero-suppression threshold
-      if (rh.getAmplitude() < m_pedMeanADC + thresholdADC) {
+      if (amplitude < pedMean + thresholdADC) {
         continue;
       }
 
       // convert ADC -> energy
-      const float energy =
-        (((signed)rh.getAmplitude() - (signed)m_pedMeanADC)) / static_cast<float>(m_capADC.value()) * dyRangeADC / m_sampFrac;
-      const float time  = rh.getTimeStamp() / stepTDC;
-
-      #pragma GCC diagnostic pop
-
-      const auto cellID = rh.getCellID();
-      const int lid = id_dec != nullptr && !m_layerField.value().empty() ? static_cast<int>(id_dec->get(cellID, layer_idx)) : -1;
-      const int sid = id_dec != nullptr && !m_sectorField.value().empty() ? static_cast<int>(id_dec->get(cellID, sector_idx)) : -1;
-      // global positions
-      const auto gpos = converter->position(cellID);
-      // local positions
-      if (m_localDetElement.value().empty()) {
-        auto volman = m_geoSvc->detector()->volumeManager();
-        local       = volman.lookupDetElement(cellID & local_mask);
-        }
-        const auto pos = local.nominal().worldToLocal(dd4hep::Position(gpos.x(), gpos.y(), gpos.z()));
-        // cell dimension
-        std::vector<double> cdim;
-        // get segmentation dimensions
-        if (converter->findReadout(local).segmentation().type() != "NoSegmentation") {
-        cdim = converter->cellDimensions(cellID);
-        // get volume dimensions (multiply by two to get fullsize)
-        } else {
-        // Using bounding box instead of actual solid so the dimensions are always in dim_x, dim_y, dim_z
-        cdim = converter->findContext(cellID)->volumePlacement().volume().boundingBox().dimensions();
-        std::transform(cdim.begin(), cdim.end(), cdim.begin(),
-                       std::bind(std::multiplies<double>(), std::placeholders::_1, 2));
+      const float energy = (amplitude - pedMean) / m_capADC.value() * dyRangeADC / sampFracs[i];
+      const float time   = rh.getTimeStamp() / stepTDC;
+
+      cellIDs.push_back(rawIDs[i]);
+      energies.push_back(energy);
+      times.push_back(time);
+    }
+
+    fill(cellIDs, energies, times, hits);
+  }
+
+private:
+  static constexpr size_t kMaxTemplateSamples = 1024;
+
+  /// Per-channel constants of the hits
+  struct ChannelConstants {
+    std::vector<float> pedMeans;
+    std::vector<float> pedSigmas;
+    std::vector<float> sampFracs;
+    std::vector<float> thresholdValues;
+  };
+
+  ChannelConstants channelConstants(const std::vector<uint64_t>& ids) const {
+    ChannelConstants constants;
+    const auto* table = (m_calibration != nullptr) ? m_calibration->table(m_calibSvc->run()) : nullptr;
+    std::vector<Jug::Base::Calibration::Channel> channels;
+    if (table != nullptr) {
+      m_calibration->channels(ids, channels);
+    }
+    auto gather = [&](int column, double fallback, std::vector<float>& values) {
+      if (table != nullptr) {
+        table->values(column, channels, fallback, values);
+      } else {
+        values.assign(ids.size(), fallback);
+      }
+    };
+    gather(m_pedMeanColumn, m_pedMeanADC.value(), constants.pedMeans);
+    gather(m_pedSigmaColumn, m_pedSigmaADC.value(), constants.pedSigmas);
+    gather(m_sampFracColumn, m_sampFrac.value(), constants.sampFracs);
+    gather(m_thresholdColumn, m_thresholdValue.value(), constants.thresholdValues);
+    return constants;
+  }
+
+  /// Hits of the channels of sampled waveforms
+  void reconstruct(const Jug::Base::CalorimeterWaveforms& waves, eicd::CalorimeterHitCollection& hits) const {
+    if (m_templateFit && std::abs(waves.samplingPeriod - m_template.samplingPeriod()) > 1e-6) {
+      throw GaudiException("Sampling period of the waveforms differs from samplingPeriod", name(),
+                           StatusCode::FAILURE);
+    }
+    const auto constants = channelConstants(waves.cellID);
+
+    // features of all the channels together, the template fit only for those above the threshold
+    Jug::Reco::WaveformFeatures features;
+    features.extract(waves, m_waveformParams);
+    const size_t n = features.size();
+    std::vector<float> amplitudes(n);
+    std::vector<char> passed(n);
+    const double thresholdFactor = m_thresholdFactor.value();
+    for (size_t i = 0; i < n; ++i) {
+      // the pedestal of the properties or calibration without presamples
+      amplitudes[i] = features.amplitude[i];
+      if (m_waveformParams.presamples == 0) {
+        amplitudes[i] -= constants.pedMeans[i];
+      }
+      passed[i] = (amplitudes[i] >= thresholdFactor * constants.pedSigmas[i] + constants.thresholdValues[i]);
+    }
+    if (m_templateFit) {
+      features.fit(waves, m_template, &passed);
+      for (size_t i = 0; i < n; ++i) {
+        if (passed[i] != 0) {
+          amplitudes[i] = features.amplitude[i];
         }
+      }
+    }
 
-        // create const vectors for passing to hit initializer list
-        const decltype(eicd::CalorimeterHitData::position) position(
-          gpos.x() / m_lUnit, gpos.y() / m_lUnit, gpos.z() / m_lUnit
-        );
-        const decltype(eicd::CalorimeterHitData::dimension) dimension(
-          cdim[0] / m_lUnit, cdim[1] / m_lUnit, cdim[2] / m_lUnit
-        );
-        const decltype(eicd::CalorimeterHitData::local) local_position(
-          pos.x() / m_lUnit, pos.y() / m_lUnit, pos.z() / m_lUnit
-        );
-
-        hits.push_back({
-            rh.getCellID(), // cellID
-            energy,         // energy
-            0,              // @TODO: energy error
-            time,           // time
-            0,              // time error FIXME should be configurable
-            position,       // global pos
-            dimension,
-            // Local hit info
-            sid,
-            lid,
-            local_position, // local pos
-        });
+    std::vector<uint64_t> cellIDs;
+    std::vector<float> energies;
+    std::vector<float> times;
+    cellIDs.reserve(n);
+    energies.reserve(n);
+    times.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+      if (passed[i] == 0) {
+        continue;
+      }
+      cellIDs.push_back(waves.cellID[i]);
+      energies.push_back(amplitudes[i] / m_capADC.value() * dyRangeADC / constants.sampFracs[i]);
+      times.push_back(features.time[i]);
     }
+    fill(cellIDs, energies, times, hits);
+  }
 
-    return StatusCode::SUCCESS;
+  /// Hits of the reconstructed channels, with their cell geometries
+  void fill(const std::vector<uint64_t>& cellIDs, const std::vector<float>& energies, const std::vector<float>& times,
+            eicd::CalorimeterHitCollection& hits) const {
+    std::vector<const Jug::Base::CellGeometry*> geometries;
+    m_cellGeometry->geometry(cellIDs, geometries);
+
+    for (size_t i = 0; i < cellIDs.size(); ++i) {
+      const auto& geo = *geometries[i];
+
+      // create const vectors for passing to hit initializer list
+      const decltype(eicd::CalorimeterHitData::position) position(
+        geo.global.x() / m_lUnit, geo.global.y() / m_lUnit, geo.global.z() / m_lUnit
+      );
+      const decltype(eicd::CalorimeterHitData::dimension) dimension(
+        geo.dimension[0] / m_lUnit, geo.dimension[1] / m_lUnit, geo.dimension[2] / m_lUnit
+      );
+      const decltype(eicd::CalorimeterHitData::local) local_position(
+        geo.local.x() / m_lUnit, geo.local.y() / m_lUnit, geo.local.z() / m_lUnit
+      );
+
+      hits.push_back({
+          cellIDs[i],     // cellID
+          energies[i],    // energy
+          0,              // @TODO: energy error
+          times[i],       // time
+          0,              // time error FIXME should be configurable
+          position,       // global pos
+          dimension,
+          // Local hit info
+          geo.sector,
+          geo.layer,
+          local_position, // local pos
+      });
+    }
   }
 
 }; // class CalorimeterHitReco
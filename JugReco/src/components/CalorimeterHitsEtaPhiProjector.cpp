@@ -13,7 +13,8 @@
  */
 #include <algorithm>
 #include <bitset>
-#include <unordered_map>
+#include <cstdint>
+#include <vector>
 
 #include "Gaudi/Property.h"
 #include "GaudiAlg/GaudiAlgorithm.h"
@@ -29,7 +30,9 @@
 
 #include "JugBase/DataHandle.h"
 #include "JugBase/IGeoSvc.h"
+#include "JugBase/Utilities/FlatIndexMap.h"
 #include "JugBase/Utilities/Utils.hpp"
+#include "JugReco/CalorimeterHitCache.h"
 
 // Event Model related classes
 #include "eicd/CalorimeterHitCollection.h"
@@ -38,12 +41,6 @@
 using namespace Gaudi::Units;
 using Point3D = ROOT::Math::XYZPoint;
 
-struct pair_hash {
-  template <class T1, class T2> std::size_t operator()(const std::pair<T1, T2>& pair) const {
-    return std::hash<T1>()(pair.first) ^ std::hash<T2>()(pair.second);
-  }
-};
-
 namespace Jug::Reco {
 
 /** Calorimeter eta-phi projector
@@ -67,6 +64,12 @@ private:
 
   double gridSizes[2]{0.0, 0.0};
 
+  // hits of the event and first hit, bins and energy of the merged hits, kept to reuse their buffers
+  CalorimeterHitCache m_cache;
+  std::vector<size_t> m_first;
+  std::vector<int64_t> m_etaBin, m_phiBin;
+  std::vector<float> m_sumEnergy;
+
 public:
   CalorimeterHitsEtaPhiProjector(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
     declareProperty("inputHitCollection", m_inputHitCollection, "");
@@ -89,35 +92,50 @@ public:
   }
 
   StatusCode execute() override {
+    // input collections
+    const auto& hits = *m_inputHitCollection.get();
     // Create output collections
     auto& mhits = *m_outputHitCollection.createAndPut();
 
-    // container
-    std::unordered_map<std::pair<int64_t, int64_t>, std::vector<eicd::CalorimeterHit>, pair_hash> merged_hits;
-
-    for (const auto h : *m_inputHitCollection.get()) {
-      auto bins =
-          std::make_pair(static_cast<int64_t>(pos2bin(eicd::eta(h.getPosition()), gridSizes[0], 0.)),
-                         static_cast<int64_t>(pos2bin(eicd::angleAzimuthal(h.getPosition()), gridSizes[1], 0.)));
-      merged_hits[bins].push_back(h);
+    // eta and phi of the hits, computed once for the collection
+    m_cache.fill(hits);
+    const size_t n = m_cache.size();
+
+    // merged hits by (eta, phi) bin, in the order of their first hits
+    Jug::Base::FlatIndexMap binIndex(n);
+    m_first.clear();
+    m_etaBin.clear();
+    m_phiBin.clear();
+    m_sumEnergy.clear();
+    for (size_t i = 0; i < n; ++i) {
+      const int64_t etaBin = pos2bin(m_cache.eta[i], gridSizes[0], 0.);
+      const int64_t phiBin = pos2bin(m_cache.phi[i], gridSizes[1], 0.);
+      // the bins are well within 32 bits for any sensible grid size
+      const uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(etaBin)) << 32) |
+                           static_cast<uint64_t>(static_cast<uint32_t>(phiBin));
+      const auto [index, inserted] = binIndex.emplace(key, m_first.size());
+      if (inserted) {
+        m_first.push_back(i);
+        m_etaBin.push_back(etaBin);
+        m_phiBin.push_back(phiBin);
+        m_sumEnergy.push_back(0.);
+      }
+      m_sumEnergy[index] += m_cache.energy[i];
     }
 
-    for (const auto& [bins, hits] : merged_hits) {
-      const auto ref = hits.front();
+    for (size_t b = 0; b < m_first.size(); ++b) {
+      const auto ref = m_first[b];
       eicd::MutableCalorimeterHit hit;
-      hit.setCellID(ref.getCellID());
+      hit.setCellID(m_cache.cellID[ref]);
       // TODO, we can do timing cut to reject noises
-      hit.setTime(ref.getTime());
-      double r   = eicd::magnitude(ref.getPosition());
-      double eta = bin2pos(bins.first, gridSizes[0], 0.);
-      double phi = bin2pos(bins.second, gridSizes[1], 1.);
+      hit.setTime(m_cache.time[ref]);
+      double r   = m_cache.r[ref];
+      double eta = bin2pos(m_etaBin[b], gridSizes[0], 0.);
+      double phi = bin2pos(m_phiBin[b], gridSizes[1], 1.);
       hit.setPosition(eicd::sphericalToVector(r, eicd::etaToAngle(eta), phi));
       hit.setDimension({static_cast<float>(gridSizes[0]), static_cast<float>(gridSizes[1]), 0.});
       // merge energy
-      hit.setEnergy(0.);
-      for (const auto& h : hits) {
-        hit.setEnergy(hit.getEnergy() + h.getEnergy());
-      }
+      hit.setEnergy(m_sumEnergy[b]);
       mhits.push_back(hit);
     }
 
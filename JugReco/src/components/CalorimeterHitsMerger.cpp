@@ -10,7 +10,8 @@
 #include <algorithm>
 #include <bitset>
 #include <tuple>
-#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "Gaudi/Property.h"
 #include "GaudiAlg/GaudiAlgorithm.h"
@@ -28,8 +29,12 @@
 #include "fmt/format.h"
 #include "fmt/ranges.h"
 
+#include "JugBase/CellIDDecoder.h"
 #include "JugBase/DataHandle.h"
+#include "JugBase/ICellGeometrySvc.h"
 #include "JugBase/IGeoSvc.h"
+#include "JugBase/Logging.h"
+#include "JugBase/Utilities/KeyGroups.h"
 
 // Event Model related classes
 #include "eicd/CalorimeterHitCollection.h"
@@ -43,11 +48,16 @@ namespace Jug::Reco {
  *  An algorithm to group readout hits from a calorimeter
  *  Energy is summed
  *
+ *  The positions of the merged hits are those of the reference cells (fieldRefNumbers), looked
+ *  up in the cell geometry table of the readout (CellGeometrySvc), so that each reference cell
+ *  costs the DD4hep lookups once per job instead of once per merged hit.
+ *
  *  \ingroup reco
  */
 class CalorimeterHitsMerger : public GaudiAlgorithm {
 private:
   Gaudi::Property<std::string> m_geoSvcName{this, "geoServiceName", "GeoSvc"};
+  Gaudi::Property<std::string> m_cellGeoSvcName{this, "cellGeometryServiceName", "CellGeometrySvc"};
   Gaudi::Property<std::string> m_readout{this, "readoutClass", ""};
   // field names to generate id mask, the hits will be grouped by masking the field
   Gaudi::Property<std::vector<std::string>> u_fields{this, "fields", {"layer"}};
@@ -60,6 +70,10 @@ private:
   SmartIF<IGeoSvc> m_geoSvc;
   uint64_t id_mask{0}, ref_mask{0};
 
+  // cached positions of the reference cells, local frame of their lowest level DetElement
+  SmartIF<ICellGeometrySvc> m_cellGeoSvc;
+  const Jug::Base::CellGeometryTable* m_cellGeometry{nullptr};
+
 public:
   CalorimeterHitsMerger(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
     declareProperty("inputHitCollection", m_inputHitCollection, "");
@@ -83,17 +97,28 @@ public:
       return StatusCode::FAILURE;
     }
 
+    m_cellGeoSvc = service(m_cellGeoSvcName);
+    if (!m_cellGeoSvc) {
+      error() << "Unable to locate Cell Geometry Service " << m_cellGeoSvcName.value() << endmsg;
+      return StatusCode::FAILURE;
+    }
+    m_cellGeometry = m_cellGeoSvc->geometryTable({m_readout.value(), "", {}, "", ""});
+    if (m_cellGeometry == nullptr) {
+      error() << "Failed to set up the cell geometry of " << m_readout.value() << endmsg;
+      return StatusCode::FAILURE;
+    }
+
     try {
-      auto id_desc = m_geoSvc->detector()->readout(m_readout).idSpec();
-      id_mask      = 0;
+      // compiled fields of the readout, shared with the other algorithms of the readout
+      const auto id_desc = Jug::Base::CellIDDecoder::readout(*m_geoSvc->detector(), m_readout);
+      id_mask            = id_desc->mask(u_fields);
       std::vector<std::pair<std::string, int>> ref_fields;
       for (size_t i = 0; i < u_fields.size(); ++i) {
-        id_mask |= id_desc.field(u_fields[i])->mask();
         // use the provided id number to find ref cell, or use 0
         int ref = i < u_refs.size() ? u_refs[i] : 0;
         ref_fields.emplace_back(u_fields[i], ref);
       }
-      ref_mask = id_desc.encode(ref_fields);
+      ref_mask = id_desc->encode(ref_fields);
       // debug() << fmt::format("Referece id mask for the fields {:#064b}", ref_mask) << endmsg;
     } catch (...) {
       error() << "Failed to load ID decoder for " << m_readout << endmsg;
@@ -108,58 +133,51 @@ public:
     // input collections
     const auto& inputs = *m_inputHitCollection.get();
     // Create output collections
-    auto& outputs = *m_outputHitCollection.createAndPut();
-
-    // find the hits that belong to the same group (for merging)
-    std::unordered_map<long long, std::vector<eicd::CalorimeterHit>> merge_map;
-    for (const auto& h : inputs) {
-      int64_t id = h.getCellID() & id_mask;
-      // use the reference field position
-      auto it = merge_map.find(id);
-      if (it == merge_map.end()) {
-        merge_map[id] = {h};
-      } else {
-        it->second.push_back(h);
-      }
+    auto& outputs = *m_outputHitCollection.createAndPut(inputs.size());
+
+    // group the hits by masked cell id (for merging), in flat arrays sorted by id
+    std::vector<uint64_t> ids(inputs.size());
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      ids[i] = inputs[i].getCellID() & id_mask;
     }
+    const auto groups = Jug::Base::group_by_key(std::move(ids));
 
-    // sort hits by energy from large to small
-    std::for_each(merge_map.begin(), merge_map.end(), [](auto& it) {
-      std::sort(it.second.begin(), it.second.end(), [](const auto& h1, const auto& h2) {
-        return h1.getEnergy() > h2.getEnergy();
-      });
-    });
-
-    // reconstruct info for merged hits
-    // dd4hep decoders
-    auto poscon = m_geoSvc->cellIDPositionConverter();
-    auto volman = m_geoSvc->detector()->volumeManager();
-
-    for (auto& [id, hits] : merge_map) {
-      // reference fields id
-      const uint64_t ref_id = id | ref_mask;
-      // global positions
-      const auto gpos = poscon->position(ref_id);
-      // local positions
-      auto alignment = volman.lookupDetElement(ref_id).nominal();
-      const auto pos = alignment.worldToLocal(dd4hep::Position(gpos.x(), gpos.y(), gpos.z()));
-      debug() << volman.lookupDetElement(ref_id).path() << ", " << volman.lookupDetector(ref_id).path() << endmsg;
-      // sum energy
+    // reference cells of the merged hits, with their cached geometry
+    std::vector<uint64_t> ref_ids(groups.size());
+    for (size_t igroup = 0; igroup < groups.size(); ++igroup) {
+      ref_ids[igroup] = groups.key(igroup) | ref_mask;
+    }
+    std::vector<const Jug::Base::CellGeometry*> geometries;
+    m_cellGeometry->geometry(ref_ids, geometries);
+
+    for (size_t igroup = 0; igroup < groups.size(); ++igroup) {
+      // global and local positions of the reference cell
+      const auto& gpos = geometries[igroup]->global;
+      const auto& pos  = geometries[igroup]->local;
+      JUG_DEBUG(m_geoSvc->detector()->volumeManager().lookupDetElement(ref_ids[igroup]).path()
+                << ", " << m_geoSvc->detector()->volumeManager().lookupDetector(ref_ids[igroup]).path());
+      // sum energy, and find the most energetic hit (the first one of equal energies)
       float energy      = 0.;
       float energyError = 0.;
       float time        = 0;
       float timeError   = 0;
-      for (auto& hit : hits) {
+      uint32_t iref     = groups.index[groups.begin[igroup]];
+      for (uint32_t i = groups.begin[igroup]; i < groups.begin[igroup + 1]; ++i) {
+        const auto hit = inputs[groups.index[i]];
         energy += hit.getEnergy();
         energyError += hit.getEnergyError() * hit.getEnergyError();
         time += hit.getTime();
         timeError += hit.getTimeError() * hit.getTimeError();
+        if (hit.getEnergy() > inputs[iref].getEnergy()) {
+          iref = groups.index[i];
+        }
       }
+      const auto nhits = groups.count(igroup);
       energyError = sqrt(energyError);
-      time /= hits.size();
-      timeError = sqrt(timeError) / hits.size();
+      time /= nhits;
+      timeError = sqrt(timeError) / nhits;
 
-      const auto& href = hits.front();
+      const auto href = inputs[iref];
 
       // create const vectors for passing to hit initializer list
       const decltype(eicd::CalorimeterHitData::position) position(
@@ -12,8 +12,13 @@
  *      https://www.jlab.org/primex/weekly_meetings/primexII/slides_2012_01_20/island_algorithm.pdf
  */
 #include <algorithm>
-#include <functional>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <memory>
 #include <tuple>
+#include <unordered_map>
+#include <vector>
 
 #include "fmt/format.h"
 
@@ -30,7 +35,13 @@
 #include "DDRec/SurfaceManager.h"
 
 #include "JugBase/DataHandle.h"
+#include "JugBase/ICellNeighbourSvc.h"
+#include "JugBase/IConcurrencySvc.h"
+#include "JugReco/CalorimeterHitCache.h"
 #include "JugBase/IGeoSvc.h"
+#include "JugBase/Profiling.h"
+#include "JugBase/Utilities/TimeIndex.h"
+#include "JugReco/ProtoClusterIndex.h"
 
 // Event Model related classes
 #include "eicd/CalorimeterHitCollection.h"
@@ -44,58 +55,161 @@ using namespace Gaudi::Units;
 
 namespace {
 
-using CaloHit = eicd::CalorimeterHit;
 using CaloHitCollection = eicd::CalorimeterHitCollection;
+using CaloHitCache      = Jug::Reco::CalorimeterHitCache;
 
-// helper functions to get distance between hits
-static eicd::Vector2f localDistXY(const CaloHit& h1, const CaloHit& h2) {
-  const auto delta = h1.getLocal() - h2.getLocal();
+// helper functions to get distance between hits i and j of the hit cache
+static eicd::Vector2f localDistXY(const CaloHitCache& c, size_t i, size_t j) {
+  const auto delta = c.local(i) - c.local(j);
   return {delta.x, delta.y};
 }
-static eicd::Vector2f localDistXZ(const CaloHit& h1, const CaloHit& h2) {
-  const auto delta = h1.getLocal() - h2.getLocal();
+static eicd::Vector2f localDistXZ(const CaloHitCache& c, size_t i, size_t j) {
+  const auto delta = c.local(i) - c.local(j);
   return {delta.x, delta.z};
 }
-static eicd::Vector2f localDistYZ(const CaloHit& h1, const CaloHit& h2) {
-  const auto delta = h1.getLocal() - h2.getLocal();
+static eicd::Vector2f localDistYZ(const CaloHitCache& c, size_t i, size_t j) {
+  const auto delta = c.local(i) - c.local(j);
   return {delta.y, delta.z};
 }
-static eicd::Vector2f dimScaledLocalDistXY(const CaloHit& h1, const CaloHit& h2) {
-  const auto delta = h1.getLocal() - h2.getLocal();
-  const auto dimsum = h1.getDimension() + h2.getDimension();
+static eicd::Vector2f dimScaledLocalDistXY(const CaloHitCache& c, size_t i, size_t j) {
+  const auto delta  = c.local(i) - c.local(j);
+  const auto dimsum = c.dimension(i) + c.dimension(j);
   return {2 * delta.x / dimsum.x, 2 * delta.y / dimsum.y};
 }
-static eicd::Vector2f globalDistRPhi(const CaloHit& h1, const CaloHit& h2) {
-  using vector_type = decltype(eicd::Vector2f::a);
-  return {
-    static_cast<vector_type>(
-      eicd::magnitude(h1.getPosition()) - eicd::magnitude(h2.getPosition())
-    ),
-    static_cast<vector_type>(
-      eicd::angleAzimuthal(h1.getPosition()) - eicd::angleAzimuthal(h2.getPosition())
-    )
-  };
+static eicd::Vector2f globalDistRPhi(const CaloHitCache& c, size_t i, size_t j) {
+  return {c.r[i] - c.r[j], c.phi[i] - c.phi[j]};
 }
-static eicd::Vector2f globalDistEtaPhi(const CaloHit& h1,
-                                       const CaloHit& h2) {
-  using vector_type = decltype(eicd::Vector2f::a);
-  return {
-    static_cast<vector_type>(
-      eicd::eta(h1.getPosition()) - eicd::eta(h2.getPosition())
-    ),
-    static_cast<vector_type>(
-      eicd::angleAzimuthal(h1.getPosition()) - eicd::angleAzimuthal(h2.getPosition())
-    )
-  };
+static eicd::Vector2f globalDistEtaPhi(const CaloHitCache& c, size_t i, size_t j) {
+  return {c.eta[i] - c.eta[j], c.phi[i] - c.phi[j]};
 }
-// name: {method, units}
-static std::map<std::string,
-                std::tuple<std::function<eicd::Vector2f(const CaloHit&, const CaloHit&)>, std::vector<double>>>
-    distMethods{
-        {"localDistXY", {localDistXY, {mm, mm}}},        {"localDistXZ", {localDistXZ, {mm, mm}}},
-        {"localDistYZ", {localDistYZ, {mm, mm}}},        {"dimScaledLocalDistXY", {dimScaledLocalDistXY, {1., 1.}}},
-        {"globalDistRPhi", {globalDistRPhi, {mm, rad}}}, {"globalDistEtaPhi", {globalDistEtaPhi, {1., rad}}},
-    };
+
+// helper functions to get the coordinates whose differences are checked by the distance functions,
+// used to bin the hits for the neighbour search
+static eicd::Vector2f localXY(const CaloHitCache& c, size_t i) { return {c.localX[i], c.localY[i]}; }
+static eicd::Vector2f localXZ(const CaloHitCache& c, size_t i) { return {c.localX[i], c.localZ[i]}; }
+static eicd::Vector2f localYZ(const CaloHitCache& c, size_t i) { return {c.localY[i], c.localZ[i]}; }
+static eicd::Vector2f globalRPhi(const CaloHitCache& c, size_t i) { return {c.r[i], c.phi[i]}; }
+static eicd::Vector2f globalEtaPhi(const CaloHitCache& c, size_t i) { return {c.eta[i], c.phi[i]}; }
+
+// distance method bound at compile time, the clustering kernels are instantiated once per method so that
+// the distance and coordinate calculations are inlined in the neighbour checks
+template <eicd::Vector2f (*Dist)(const CaloHitCache&, size_t, size_t),
+          eicd::Vector2f (*Coords)(const CaloHitCache&, size_t), bool DimScaled>
+struct DistMethod {
+  static eicd::Vector2f dist(const CaloHitCache& c, size_t i, size_t j) { return Dist(c, i, j); }
+  static eicd::Vector2f coords(const CaloHitCache& c, size_t i) { return Coords(c, i); }
+  // distances are scaled by the cell dimensions
+  static constexpr bool dimScaled = DimScaled;
+};
+
+using LocalDistXY          = DistMethod<localDistXY, localXY, false>;
+using LocalDistXZ          = DistMethod<localDistXZ, localXZ, false>;
+using LocalDistYZ          = DistMethod<localDistYZ, localYZ, false>;
+using DimScaledLocalDistXY = DistMethod<dimScaledLocalDistXY, localXY, true>;
+using GlobalDistRPhi       = DistMethod<globalDistRPhi, globalRPhi, false>;
+using GlobalDistEtaPhi     = DistMethod<globalDistEtaPhi, globalEtaPhi, false>;
+
+/**
+ * Cell list of the hits in an event, used to find neighbour candidates without a scan over all hits.
+ *
+ * Hits are binned in (sector, clustering coordinates) with bins as wide as the neighbour distances,
+ * and in global (x, y, z) with bins as wide as the sector distance. All neighbours of a hit are then
+ * located in the adjacent bins of the same sector (local grid) or of other sectors (global grid).
+ * Bin keys are packed into 64 bits, a key collision only adds candidates that fail the exact check.
+ * With a time window, the hits of a bin are sorted by time and the candidates out of the window of
+ * the hit are skipped without being visited.
+ */
+class NeighbourGrid {
+public:
+  template <typename Coords>
+  void build(const CaloHitCache& hits, Coords&& coords, const std::array<double, 2>& width, double sectorWidth,
+             double timeWindow) {
+    m_width       = {positive_or_one(width[0]), positive_or_one(width[1])};
+    m_sectorWidth = positive_or_one(sectorWidth);
+    m_timeWindow  = timeWindow;
+
+    const size_t n = hits.size();
+    m_sector.resize(n);
+    m_time.resize(n);
+    m_localBins.resize(n);
+    m_globalBins.resize(n);
+    m_local.clear();
+    m_global.clear();
+    m_local.reserve(n);
+    m_global.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+      const auto c    = coords(hits, i);
+      m_sector[i]     = hits.sector[i];
+      // without a time window the bins keep the hits in their order
+      m_time[i]       = (m_timeWindow > 0.) ? hits.time[i] : 0.;
+      m_localBins[i]  = {to_bin(c.a, m_width[0]), to_bin(c.b, m_width[1])};
+      m_globalBins[i] = {to_bin(hits.x[i], m_sectorWidth), to_bin(hits.y[i], m_sectorWidth),
+                         to_bin(hits.z[i], m_sectorWidth)};
+      m_local.add(local_key(m_sector[i], m_localBins[i][0], m_localBins[i][1]), m_time[i], i);
+      m_global.add(global_key(m_globalBins[i][0], m_globalBins[i][1], m_globalBins[i][2]), m_time[i], i);
+    }
+    m_local.sort();
+    m_global.sort();
+  }
+
+  // call visit(j) for all hits j != idx in the same sector that are potential neighbours of hit idx
+  template <typename Visitor> void forEachSameSectorCandidate(size_t idx, Visitor&& visit) const {
+    const auto sector       = m_sector[idx];
+    const auto& lbin        = m_localBins[idx];
+    const auto [tmin, tmax] = Jug::Base::timeWindowRange(m_time[idx], m_timeWindow);
+    for (int dx = -1; dx <= 1; ++dx) {
+      for (int dy = -1; dy <= 1; ++dy) {
+        m_local.forEach(local_key(sector, lbin[0] + dx, lbin[1] + dy), tmin, tmax, [&](size_t j) {
+          if (j != idx && m_sector[j] == sector) {
+            visit(j);
+          }
+        });
+      }
+    }
+  }
+
+  // call visit(j) for all hits j in other sectors that are potential neighbours of hit idx
+  template <typename Visitor> void forEachOtherSectorCandidate(size_t idx, Visitor&& visit) const {
+    const auto sector       = m_sector[idx];
+    const auto& gbin        = m_globalBins[idx];
+    const auto [tmin, tmax] = Jug::Base::timeWindowRange(m_time[idx], m_timeWindow);
+    for (int dx = -1; dx <= 1; ++dx) {
+      for (int dy = -1; dy <= 1; ++dy) {
+        for (int dz = -1; dz <= 1; ++dz) {
+          m_global.forEach(global_key(gbin[0] + dx, gbin[1] + dy, gbin[2] + dz), tmin, tmax, [&](size_t j) {
+            if (m_sector[j] != sector) {
+              visit(j);
+            }
+          });
+        }
+      }
+    }
+  }
+
+private:
+  static double positive_or_one(double w) { return (w > 0. && std::isfinite(w)) ? w : 1.; }
+  static int32_t to_bin(double x, double w) { return static_cast<int32_t>(std::floor(x / w)); }
+  static uint64_t local_key(int sector, int32_t i, int32_t j) {
+    return (static_cast<uint64_t>(static_cast<uint16_t>(sector)) << 48) |
+           ((static_cast<uint64_t>(static_cast<uint32_t>(i)) & 0xFFFFFF) << 24) |
+           (static_cast<uint64_t>(static_cast<uint32_t>(j)) & 0xFFFFFF);
+  }
+  static uint64_t global_key(int32_t i, int32_t j, int32_t k) {
+    return ((static_cast<uint64_t>(static_cast<uint32_t>(i)) & 0x1FFFFF) << 42) |
+           ((static_cast<uint64_t>(static_cast<uint32_t>(j)) & 0x1FFFFF) << 21) |
+           (static_cast<uint64_t>(static_cast<uint32_t>(k)) & 0x1FFFFF);
+  }
+
+  std::array<double, 2> m_width{1., 1.};
+  double m_sectorWidth{1.};
+  double m_timeWindow{0.};
+  std::vector<int> m_sector;
+  std::vector<double> m_time;
+  std::vector<std::array<int32_t, 2>> m_localBins;
+  std::vector<std::array<int32_t, 3>> m_globalBins;
+  Jug::Base::TimeSortedBins m_local;
+  Jug::Base::TimeSortedBins m_global;
+};
 
 } // namespace
 namespace Jug::Reco {
@@ -110,16 +224,32 @@ namespace Jug::Reco {
  *      https://cds.cern.ch/record/687345/files/note01_034.pdf
  *      https://www.jlab.org/primex/weekly_meetings/primexII/slides_2012_01_20/island_algorithm.pdf
  *
+ *  The proto-clusters are made as hit indices (ProtoClusterIndex), put in outputProtoClusterIndex
+ *  if given. The podio proto-clusters are only made from them with writeProtoClusters, otherwise
+ *  the collection is empty (for jobs that do not write it, with ClusterRecoCoG on the index).
+ *
+ *  With numThreads, the hits of the sectors are grouped in parallel and the groups stitched across
+ *  the sector boundaries (sector_parallel_group), e.g. for the barrel calorimeters of many sectors.
+ *
  * \ingroup reco
  */
 class CalorimeterIslandCluster : public GaudiAlgorithm {
 private:
   Gaudi::Property<bool> m_splitCluster{this, "splitCluster", true};
+  // validate the batched split weights against the per-hit evaluation (slow, for debugging)
+  Gaudi::Property<bool> m_checkSplitWeights{this, "checkSplitWeights", false};
+  Gaudi::Property<double> m_splitWeightsTolerance{this, "splitWeightsTolerance", 1e-12};
   Gaudi::Property<double> m_minClusterHitEdep{this, "minClusterHitEdep", 0.};
   Gaudi::Property<double> m_minClusterCenterEdep{this, "minClusterCenterEdep", 50.0 * MeV};
   DataHandle<CaloHitCollection> m_inputHitCollection{"inputHitCollection", Gaudi::DataHandle::Reader, this};
   DataHandle<eicd::ProtoClusterCollection> m_outputProtoCollection{"outputProtoClusterCollection",
                                                                   Gaudi::DataHandle::Writer, this};
+  // proto-clusters as hit indices, optional
+  Gaudi::Property<std::string> m_outputProtoIndex{this, "outputProtoClusterIndex", "",
+                                                  "Proto-clusters as hit indices (none if empty)"};
+  Gaudi::Property<bool> m_writeProtoClusters{this, "writeProtoClusters", true,
+                                             "Fill the podio proto-clusters (empty collection otherwise)"};
+  std::unique_ptr<DataHandle<ProtoClusterIndex>> m_outputProtoIndex_ptr;
 
   // neighbour checking distances
   Gaudi::Property<double> m_sectorDist{this, "sectorDist", 5.0 * cm};
@@ -129,11 +259,41 @@ private:
   Gaudi::Property<std::vector<double>> u_globalDistRPhi{this, "globalDistRPhi", {}};
   Gaudi::Property<std::vector<double>> u_globalDistEtaPhi{this, "globalDistEtaPhi", {}};
   Gaudi::Property<std::vector<double>> u_dimScaledLocalDistXY{this, "dimScaledLocalDistXY", {1.8, 1.8}};
-  // neighbor checking function
-  std::function<eicd::Vector2f(const CaloHit&, const CaloHit&)> hitsDist;
+  // neighbours are also within the time window (off if 0), e.g. with time frames or background overlay
+  Gaudi::Property<double> m_timeWindow{this, "timeWindow", 0. * ns};
+  // use the readout segmentation neighbours (from CellNeighbourSvc) for hits in the same sector,
+  // instead of the distances above
+  Gaudi::Property<bool> m_useCellNeighbours{this, "useCellNeighbours", false};
+  Gaudi::Property<std::string> m_readout{this, "readoutClass", ""};
+  Gaudi::Property<std::string> m_cellNeighbourSvcName{this, "cellNeighbourServiceName", "CellNeighbourSvc"};
+  SmartIF<ICellNeighbourSvc> m_cellNeighbourSvc;
+  const Jug::Base::CellNeighbourTable* m_neighbourTable{nullptr};
+  // group the hits of every sector in a parallel task, the groups are then stitched across the
+  // sector boundaries (same groups)
+  Gaudi::Property<int> m_numThreads{this, "numThreads", 1,
+                                    "Sectors of an event in the ConcurrencySvc arena (1: serial)"};
+  SmartIF<IConcurrencySvc> m_concurrencySvc;
+
+  // clustering kernel for the selected distance method
+  using Kernel = void (CalorimeterIslandCluster::*)(const CaloHitCollection&, ProtoClusterIndex&);
+  Kernel m_clusterHits{nullptr};
+  // contiguous copy of the input hits and the neighbour search grid, kept to reuse their buffers
+  CaloHitCache m_hits;
+  NeighbourGrid m_grid;
+  // proto-clusters of the event if they are not in the event store
+  ProtoClusterIndex m_protoIndex;
+  // split weights (maxima x hits) and their per-hit normalization
+  std::vector<double> m_splitWeights;
+  std::vector<double> m_splitNorm;
+  // qualified hits ordered by sector, the sector ranges, the sector group of the hits and the
+  // neighbour pairs across the sectors found by the sector tasks
+  std::vector<uint32_t> m_sectorOrder;
+  std::vector<size_t> m_sectorBegin;
+  std::vector<uint32_t> m_sectorLabel;
+  std::vector<std::vector<std::pair<uint32_t, uint32_t>>> m_sectorLinks;
 
   // unitless counterparts of the input parameters
-  double minClusterHitEdep{0}, minClusterCenterEdep{0}, sectorDist{0};
+  double minClusterHitEdep{0}, minClusterCenterEdep{0}, sectorDist{0}, timeWindow{0};
   std::array<double, 2> neighbourDist = {0., 0.};
 
 public:
@@ -151,13 +311,24 @@ public:
     minClusterHitEdep    = m_minClusterHitEdep.value() / GeV;
     minClusterCenterEdep = m_minClusterCenterEdep.value() / GeV;
     sectorDist           = m_sectorDist.value() / mm;
+    timeWindow           = m_timeWindow.value() / ns;
+
+    // name: {clustering kernel, units}
+    const std::map<std::string, std::tuple<Kernel, std::vector<double>>> distMethods{
+        {"localDistXY", {&CalorimeterIslandCluster::cluster_hits<LocalDistXY>, {mm, mm}}},
+        {"localDistXZ", {&CalorimeterIslandCluster::cluster_hits<LocalDistXZ>, {mm, mm}}},
+        {"localDistYZ", {&CalorimeterIslandCluster::cluster_hits<LocalDistYZ>, {mm, mm}}},
+        {"dimScaledLocalDistXY", {&CalorimeterIslandCluster::cluster_hits<DimScaledLocalDistXY>, {1., 1.}}},
+        {"globalDistRPhi", {&CalorimeterIslandCluster::cluster_hits<GlobalDistRPhi>, {mm, rad}}},
+        {"globalDistEtaPhi", {&CalorimeterIslandCluster::cluster_hits<GlobalDistEtaPhi>, {1., rad}}},
+    };
 
     // set coordinate system
-    auto set_dist_method = [this](const Gaudi::Property<std::vector<double>>& uprop) {
+    auto set_dist_method = [this, &distMethods](const Gaudi::Property<std::vector<double>>& uprop) {
       if (uprop.size() == 0) {
         return false;
       }
-      auto& [method, units] = distMethods[uprop.name()];
+      const auto& [kernel, units] = distMethods.at(uprop.name());
       if (uprop.size() != units.size()) {
         info() << units.size() << endmsg;
         warning() << fmt::format("Expect {} values from {}, received {}: ({}), ignored it.", units.size(), uprop.name(),
@@ -168,7 +339,7 @@ public:
         for (size_t i = 0; i < units.size(); ++i) {
           neighbourDist[i] = uprop.value()[i] / units[i];
         }
-        hitsDist = method;
+        m_clusterHits = kernel;
         info() << fmt::format("Clustering uses {} with distances <= [{}]", uprop.name(), fmt::join(neighbourDist, ","))
                << endmsg;
       }
@@ -197,6 +368,34 @@ public:
       return StatusCode::FAILURE;
     }
 
+    if (!m_outputProtoIndex.value().empty()) {
+      m_outputProtoIndex_ptr =
+          std::make_unique<DataHandle<ProtoClusterIndex>>(m_outputProtoIndex, Gaudi::DataHandle::Writer, this);
+    }
+
+    if (m_useCellNeighbours.value()) {
+      m_cellNeighbourSvc = service(m_cellNeighbourSvcName);
+      if (!m_cellNeighbourSvc) {
+        error() << "Unable to locate Cell Neighbour Service " << m_cellNeighbourSvcName.value() << endmsg;
+        return StatusCode::FAILURE;
+      }
+      m_neighbourTable = m_cellNeighbourSvc->neighbourTable(m_readout.value());
+      if (m_neighbourTable == nullptr) {
+        error() << "No cell neighbour table for readout " << m_readout.value() << endmsg;
+        return StatusCode::FAILURE;
+      }
+      info() << "Clustering uses the segmentation neighbours of " << m_readout.value() << " within sectors" << endmsg;
+    }
+
+    if (m_numThreads.value() != 1) {
+      m_concurrencySvc = service("ConcurrencySvc");
+      if (!m_concurrencySvc) {
+        error() << "Unable to locate ConcurrencySvc for numThreads " << m_numThreads.value() << endmsg;
+        return StatusCode::FAILURE;
+      }
+      info() << "Sector-parallel grouping with up to " << m_concurrencySvc->concurrency() << " threads" << endmsg;
+    }
+
     return StatusCode::SUCCESS;
   }
 
@@ -205,12 +404,43 @@ public:
     const auto& hits = *(m_inputHitCollection.get());
     // Create output collections
     auto& proto = *(m_outputProtoCollection.createAndPut());
+    auto& index = m_outputProtoIndex_ptr ? *(m_outputProtoIndex_ptr->createAndPut()) : m_protoIndex;
+    index.clear();
+
+    (this->*m_clusterHits)(hits, index);
+
+    if (m_writeProtoClusters.value()) {
+      index.to_collection(hits, proto);
+    }
+
+    return StatusCode::SUCCESS;
+  }
+
+private:
+  using CellIndex = std::unordered_map<uint64_t, size_t>;
+
+  // clustering kernel, instantiated for every distance method
+  template <typename Method>
+  void cluster_hits(const CaloHitCollection& hits, ProtoClusterIndex& proto) {
+    m_hits.fill(hits);
+    // bin the hits for the neighbour search
+    m_grid.build(m_hits, Method::coords, binWidths<Method>(m_hits), sectorDist, timeWindow);
+    CellIndex cellIndex;
+    if (m_neighbourTable != nullptr) {
+      cellIndex.reserve(m_hits.size());
+      for (size_t i = 0; i < m_hits.size(); ++i) {
+        cellIndex.emplace(m_hits.cellID[i], i);
+      }
+    }
 
-    // group neighboring hits
-    std::vector<std::vector<std::pair<uint32_t, CaloHit>>> groups;
+    // group neighboring hits, as indices of the input hits
+    std::vector<std::vector<uint32_t>> groups;
 
+    if (m_concurrencySvc) {
+      sector_parallel_group<Method>(groups, m_hits, m_grid, cellIndex);
+    }
     std::vector<bool> visits(hits.size(), false);
-    for (size_t i = 0; i < hits.size(); ++i) {
+    for (size_t i = 0; i < hits.size() && !m_concurrencySvc; ++i) {
       if (msgLevel(MSG::DEBUG)) {
         const auto& hit = hits[i];
         debug() << fmt::format("hit {:d}: energy = {:.4f} MeV, local = ({:.4f}, {:.4f}) mm, "
@@ -225,62 +455,236 @@ public:
       }
       groups.emplace_back();
       // create a new group, and group all the neighboring hits
-      dfs_group(groups.back(), i, hits, visits);
+      bfs_group<Method>(groups.back(), i, m_hits, m_grid, cellIndex, visits);
+      // hits in index order, as in the sector-parallel grouping, so that the proto-clusters are the
+      // same with any numThreads
+      std::sort(groups.back().begin(), groups.back().end());
     }
 
+    JUG_PROFILE_REGION("CalorimeterIslandCluster/splitting");
     for (auto& group : groups) {
       if (group.empty()) {
         continue;
       }
-      auto maxima = find_maxima(group, !m_splitCluster.value());
-      split_group(group, maxima, proto);
+      auto maxima = find_maxima<Method>(group, m_hits, !m_splitCluster.value());
+      split_group<Method>(group, maxima, m_hits, proto);
       if (msgLevel(MSG::DEBUG)) {
         debug() << "hits in a group: " << group.size() << ", "
                 << "local maxima: " << maxima.size() << endmsg;
       }
     }
-
-    return StatusCode::SUCCESS;
   }
 
-private:
   // helper function to group hits
-  inline bool is_neighbour(const CaloHit& h1, const CaloHit& h2) const {
+  template <typename Method> inline bool is_neighbour(const CaloHitCache& hits, size_t i, size_t j) const {
+    if (!Jug::Base::inTimeWindow(hits.time[i], hits.time[j], timeWindow)) {
+      return false;
+    }
     // in the same sector
-    if (h1.getSector() == h2.getSector()) {
-      auto dist = hitsDist(h1, h2);
-      return (dist.a <= neighbourDist[0]) && (dist.b <= neighbourDist[1]);
+    if (hits.sector[i] == hits.sector[j]) {
+      if (m_neighbourTable != nullptr) {
+        return m_neighbourTable->isNeighbour(hits.cellID[i], hits.cellID[j]);
+      }
+      auto dist = Method::dist(hits, i, j);
+      return (std::abs(dist.a) <= neighbourDist[0]) && (std::abs(dist.b) <= neighbourDist[1]);
       // different sector, local coordinates do not work, using global coordinates
     } else {
       // sector may have rotation (barrel), so z is included
-      return (eicd::magnitude(h1.getPosition() - h2.getPosition()) <= sectorDist);
+      return (eicd::magnitude(hits.position(i) - hits.position(j)) <= sectorDist);
+    }
+  }
+
+  // bin widths of the neighbour search grid, neighbours are never more than one bin apart
+  template <typename Method> std::array<double, 2> binWidths(const CaloHitCache& hits) const {
+    if constexpr (!Method::dimScaled) {
+      return neighbourDist;
+    }
+    // distances are scaled by the mean dimension of the two cells, bound them by the largest cell
+    double maxDimX = 0., maxDimY = 0.;
+    for (size_t i = 0; i < hits.size(); ++i) {
+      maxDimX = std::max(maxDimX, static_cast<double>(hits.dimX[i]));
+      maxDimY = std::max(maxDimY, static_cast<double>(hits.dimY[i]));
     }
+    return {neighbourDist[0] * maxDimX, neighbourDist[1] * maxDimY};
   }
 
-  // grouping function with Depth-First Search
-  void dfs_group(std::vector<std::pair<uint32_t, CaloHit>>& group, int idx,
-                 const CaloHitCollection& hits, std::vector<bool>& visits) const {
+  // call visit(j) for all hits j that are potential neighbours of hit idx
+  template <typename Visitor>
+  void forEachCandidate(size_t idx, const CaloHitCache& hits, const NeighbourGrid& grid, const CellIndex& cellIndex,
+                        Visitor&& visit) const {
+    if (m_neighbourTable != nullptr) {
+      for (const auto nb : m_neighbourTable->neighbours(hits.cellID[idx])) {
+        if (auto it = cellIndex.find(nb); it != cellIndex.end()) {
+          visit(it->second);
+        }
+      }
+    } else {
+      grid.forEachSameSectorCandidate(idx, visit);
+    }
+    grid.forEachOtherSectorCandidate(idx, visit);
+  }
+
+  // call visit(j) for all hits j in the same sector that are potential neighbours of hit idx
+  template <typename Visitor>
+  void forEachSameSectorCandidate(size_t idx, const CaloHitCache& hits, const NeighbourGrid& grid,
+                                  const CellIndex& cellIndex, Visitor&& visit) const {
+    if (m_neighbourTable != nullptr) {
+      for (const auto nb : m_neighbourTable->neighbours(hits.cellID[idx])) {
+        if (auto it = cellIndex.find(nb); it != cellIndex.end() && hits.sector[it->second] == hits.sector[idx]) {
+          visit(it->second);
+        }
+      }
+    } else {
+      grid.forEachSameSectorCandidate(idx, visit);
+    }
+  }
+
+  // grouping function with Breadth-First Search, the group itself is used as the queue
+  template <typename Method>
+  void bfs_group(std::vector<uint32_t>& group, size_t idx, const CaloHitCache& hits, const NeighbourGrid& grid,
+                 const CellIndex& cellIndex, std::vector<bool>& visits) const {
+    visits[idx] = true;
     // not a qualified hit to particpate clustering, stop here
-    if (hits[idx].getEnergy() < minClusterHitEdep) {
-      visits[idx] = true;
+    if (hits.energy[idx] < minClusterHitEdep) {
       return;
     }
 
-    group.emplace_back(idx, hits[idx]);
-    visits[idx] = true;
-    for (size_t i = 0; i < hits.size(); ++i) {
-      if (visits[i] || !is_neighbour(hits[idx], hits[i])) {
+    group.push_back(idx);
+    for (size_t next = 0; next < group.size(); ++next) {
+      const auto current = group[next];
+      forEachCandidate(current, hits, grid, cellIndex, [&](size_t i) {
+        if (visits[i] || !is_neighbour<Method>(hits, current, i)) {
+          return;
+        }
+        visits[i] = true;
+        // not a qualified hit to participate in clustering, do not grow from it
+        if (hits.energy[i] < minClusterHitEdep) {
+          return;
+        }
+        group.push_back(i);
+      });
+    }
+  }
+
+  /** Sector-parallel grouping.
+   *
+   *  The qualified hits (above minClusterHitEdep) of every sector are grouped by a task of their
+   *  own, from their neighbours in the sector, and each task collects the neighbour pairs of its
+   *  hits with the hits of the other sectors: only the hits within sectorDist of another sector
+   *  have any (adjacent bins of the global grid). The sector groups are then stitched over these
+   *  pairs with a union-find of the groups, labelled by their first hit, so that there is no
+   *  neighbour graph of the event. The groups are those of the serial search, in the same order
+   *  (of their first hit, the seed of the serial search), with their hits in index order as the
+   *  serial groups once sorted: the same proto-clusters for any number of threads.
+   */
+  template <typename Method>
+  void sector_parallel_group(std::vector<std::vector<uint32_t>>& groups, const CaloHitCache& hits,
+                             const NeighbourGrid& grid, const CellIndex& cellIndex) {
+    JUG_PROFILE_REGION("CalorimeterIslandCluster/sectorGroup");
+    constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+    const size_t n           = hits.size();
+
+    m_sectorOrder.clear();
+    for (size_t i = 0; i < n; ++i) {
+      if (hits.energy[i] >= minClusterHitEdep) {
+        m_sectorOrder.push_back(static_cast<uint32_t>(i));
+      }
+    }
+    std::stable_sort(m_sectorOrder.begin(), m_sectorOrder.end(),
+                     [&hits](uint32_t a, uint32_t b) { return hits.sector[a] < hits.sector[b]; });
+    m_sectorBegin.clear();
+    for (size_t k = 0; k < m_sectorOrder.size(); ++k) {
+      if (k == 0 || hits.sector[m_sectorOrder[k]] != hits.sector[m_sectorOrder[k - 1]]) {
+        m_sectorBegin.push_back(k);
+      }
+    }
+    m_sectorBegin.push_back(m_sectorOrder.size());
+    const size_t nsectors = m_sectorBegin.size() - 1;
+    m_sectorLinks.resize(std::max(m_sectorLinks.size(), nsectors));
+
+    // the label of a hit is the first hit of its sector group, written by the task of its sector only
+    m_sectorLabel.assign(n, kNone);
+    m_concurrencySvc->parallelFor(nsectors, [&](size_t s) {
+      auto& links = m_sectorLinks[s];
+      links.clear();
+      std::vector<uint32_t> queue;
+      for (size_t k = m_sectorBegin[s]; k < m_sectorBegin[s + 1]; ++k) {
+        const uint32_t seed = m_sectorOrder[k];
+        if (m_sectorLabel[seed] != kNone) {
+          continue;
+        }
+        m_sectorLabel[seed] = seed;
+        queue.assign(1, seed);
+        for (size_t next = 0; next < queue.size(); ++next) {
+          const auto current = queue[next];
+          forEachSameSectorCandidate(current, hits, grid, cellIndex, [&](size_t j) {
+            if (m_sectorLabel[j] != kNone || hits.energy[j] < minClusterHitEdep ||
+                !is_neighbour<Method>(hits, current, j)) {
+              return;
+            }
+            m_sectorLabel[j] = seed;
+            queue.push_back(static_cast<uint32_t>(j));
+          });
+        }
+      }
+      // pairs across the sector boundaries, each found from its first hit
+      for (size_t k = m_sectorBegin[s]; k < m_sectorBegin[s + 1]; ++k) {
+        const uint32_t i = m_sectorOrder[k];
+        grid.forEachOtherSectorCandidate(i, [&](size_t j) {
+          if (j > i && hits.energy[j] >= minClusterHitEdep && is_neighbour<Method>(hits, i, j)) {
+            links.emplace_back(i, static_cast<uint32_t>(j));
+          }
+        });
+      }
+    });
+
+    // stitching, the labels are the parents of the union-find: a group is linked to the group of
+    // the smaller first hit, so that the root of the stitched group is its first hit
+    auto find = [this](uint32_t i) {
+      while (m_sectorLabel[i] != i) {
+        m_sectorLabel[i] = m_sectorLabel[m_sectorLabel[i]];
+        i                = m_sectorLabel[i];
+      }
+      return i;
+    };
+    for (size_t s = 0; s < nsectors; ++s) {
+      for (const auto& [i, j] : m_sectorLinks[s]) {
+        const uint32_t a = find(i);
+        const uint32_t b = find(j);
+        if (a != b) {
+          m_sectorLabel[std::max(a, b)] = std::min(a, b);
+        }
+      }
+    }
+
+    std::vector<uint32_t> group_of(n, kNone);
+    for (size_t i = 0; i < n; ++i) {
+      if (m_sectorLabel[i] == kNone) {
         continue;
       }
-      dfs_group(group, i, hits, visits);
+      const uint32_t r = find(static_cast<uint32_t>(i));
+      if (group_of[r] == kNone) {
+        group_of[r] = static_cast<uint32_t>(groups.size());
+        groups.emplace_back();
+      }
+      groups[group_of[r]].push_back(static_cast<uint32_t>(i));
+    }
+    if (msgLevel(MSG::DEBUG)) {
+      size_t nlinks = 0;
+      for (size_t s = 0; s < nsectors; ++s) {
+        nlinks += m_sectorLinks[s].size();
+      }
+      debug() << fmt::format("{} groups from {} sectors, stitched over {} hit pairs", groups.size(), nsectors, nlinks)
+              << endmsg;
     }
   }
 
   // find local maxima that above a certain threshold
-  std::vector<CaloHit>
-  find_maxima(const std::vector<std::pair<uint32_t, CaloHit>>& group,
+  template <typename Method>
+  std::vector<uint32_t>
+  find_maxima(const std::vector<uint32_t>& group, const CaloHitCache& hits,
               bool global = false) const {
-    std::vector<CaloHit> maxima;
+    std::vector<uint32_t> maxima;
     if (group.empty()) {
       return maxima;
     }
@@ -288,42 +692,126 @@ private:
     if (global) {
       int mpos = 0;
       for (size_t i = 0; i < group.size(); ++i) {
-        if (group[mpos].second.getEnergy() < group[i].second.getEnergy()) {
+        if (hits.energy[group[mpos]] < hits.energy[group[i]]) {
           mpos = i;
         }
       }
-      if (group[mpos].second.getEnergy() >= minClusterCenterEdep) {
-        maxima.push_back(group[mpos].second);
+      if (hits.energy[group[mpos]] >= minClusterCenterEdep) {
+        maxima.push_back(group[mpos]);
       }
       return maxima;
     }
 
-    for (const auto& [idx, hit] : group) {
+    for (const auto idx : group) {
       // not a qualified center
-      if (hit.getEnergy() < minClusterCenterEdep) {
+      if (hits.energy[idx] < minClusterCenterEdep) {
         continue;
       }
 
       bool maximum = true;
-      for (const auto& [idx2, hit2] : group) {
-        if (hit == hit2) {
+      for (const auto idx2 : group) {
+        if (idx == idx2) {
           continue;
         }
 
-        if (is_neighbour(hit, hit2) && hit2.getEnergy() > hit.getEnergy()) {
+        if (is_neighbour<Method>(hits, idx, idx2) && hits.energy[idx2] > hits.energy[idx]) {
           maximum = false;
           break;
         }
       }
 
       if (maximum) {
-        maxima.push_back(hit);
+        maxima.push_back(idx);
       }
     }
 
     return maxima;
   }
 
+  // normalize the weights of every hit over the maxima, w is a (maxima x hits) matrix
+  inline static void normalize_columns(std::vector<double>& w, std::vector<double>& norm, size_t nhits) {
+    std::fill(norm.begin(), norm.end(), 0.);
+    for (size_t offset = 0; offset < w.size(); offset += nhits) {
+      for (size_t i = 0; i < nhits; ++i) {
+        norm[i] += w[offset + i];
+      }
+    }
+    for (size_t offset = 0; offset < w.size(); offset += nhits) {
+      for (size_t i = 0; i < nhits; ++i) {
+        w[offset + i] /= norm[i];
+      }
+    }
+  }
+
+  // shower profile weights of the group hits for all maxima, as a (maxima x hits) matrix in w
+  // every row is evaluated over contiguous arrays, the summation order matches the per-hit reference
+  template <typename Method>
+  static void split_weights(const std::vector<uint32_t>& group, const std::vector<uint32_t>& maxima,
+                            const CaloHitCache& cache, std::vector<double>& w, std::vector<double>& norm) {
+    const size_t nhits = group.size();
+    w.resize(maxima.size() * nhits);
+    norm.resize(nhits);
+    for (size_t k = 0; k < maxima.size(); ++k) {
+      const auto cidx       = maxima[k];
+      const double dist_ref = cache.dimX[cidx];
+      const double energy   = cache.energy[cidx];
+      double* wk            = w.data() + k * nhits;
+      for (size_t i = 0; i < nhits; ++i) {
+        wk[i] = -eicd::magnitude(Method::dist(cache, cidx, group[i]));
+      }
+      for (size_t i = 0; i < nhits; ++i) {
+        wk[i] = std::exp(wk[i] / dist_ref) * energy;
+      }
+    }
+
+    normalize_columns(w, norm, nhits);
+    // ignore small weights
+    for (auto& x : w) {
+      x = (x < 0.02) ? 0. : x;
+    }
+    normalize_columns(w, norm, nhits);
+  }
+
+  // compare the batched split weights with the per-hit reference evaluation
+  template <typename Method>
+  void check_split_weights(const std::vector<uint32_t>& group, const std::vector<uint32_t>& maxima,
+                           const CaloHitCache& cache) const {
+    const size_t nhits = group.size();
+    std::vector<double> weights(maxima.size(), 1.);
+    double maxDiff = 0.;
+    for (size_t i = 0; i < nhits; ++i) {
+      size_t j = 0;
+      // calculate weights for local maxima
+      for (const auto cidx : maxima) {
+        double dist_ref = cache.dimX[cidx];
+        double energy   = cache.energy[cidx];
+        double dist     = eicd::magnitude(Method::dist(cache, cidx, group[i]));
+        weights[j]      = std::exp(-dist / dist_ref) * energy;
+        j += 1;
+      }
+
+      // normalize weights
+      vec_normalize(weights);
+
+      // ignore small weights
+      for (auto& w : weights) {
+        if (w < 0.02) {
+          w = 0;
+        }
+      }
+      vec_normalize(weights);
+
+      for (size_t k = 0; k < maxima.size(); ++k) {
+        maxDiff = std::max(maxDiff, std::abs(weights[k] - m_splitWeights[k * nhits + i]));
+      }
+    }
+    if (maxDiff > m_splitWeightsTolerance.value()) {
+      warning() << fmt::format("Split weights differ from the reference by {:g} ({} hits, {} maxima)", maxDiff, nhits,
+                               maxima.size())
+                << endmsg;
+    }
+  }
+
   // helper function
   inline static void vec_normalize(std::vector<double>& vals) {
     double total = 0.;
@@ -336,8 +824,9 @@ private:
   }
 
   // split a group of hits according to the local maxima
-  void split_group(std::vector<std::pair<uint32_t, CaloHit>>& group, const std::vector<CaloHit>& maxima,
-                   eicd::ProtoClusterCollection& proto) const {
+  template <typename Method>
+  void split_group(const std::vector<uint32_t>& group, const std::vector<uint32_t>& maxima,
+                   const CaloHitCache& cache, ProtoClusterIndex& proto) {
     // special cases
     if (maxima.empty()) {
       if (msgLevel(MSG::VERBOSE)) {
@@ -345,12 +834,10 @@ private:
       }
       return;
     } else if (maxima.size() == 1) {
-      eicd::MutableProtoCluster pcl;
-      for (auto& [idx, hit] : group) {
-        pcl.addToHits(hit);
-        pcl.addToWeights(1.);
+      for (const auto idx : group) {
+        proto.add(idx);
       }
-      proto.push_back(pcl);
+      proto.close();
       if (msgLevel(MSG::VERBOSE)) {
         verbose() << "A single maximum found, added one ProtoCluster" << endmsg;
       }
@@ -359,48 +846,22 @@ private:
 
     // split between maxima
     // TODO, here we can implement iterations with profile, or even ML for better splits
-    std::vector<double> weights(maxima.size(), 1.);
-    std::vector<eicd::MutableProtoCluster> pcls;
-    for (size_t k = 0; k < maxima.size(); ++k) {
-      pcls.emplace_back();
+    const size_t nhits = group.size();
+    split_weights<Method>(group, maxima, cache, m_splitWeights, m_splitNorm);
+    if (m_checkSplitWeights.value()) {
+      check_split_weights<Method>(group, maxima, cache);
     }
 
-    size_t i = 0;
-    for (const auto& [idx, hit] : group) {
-      size_t j = 0;
-      // calculate weights for local maxima
-      for (const auto& chit : maxima) {
-        double dist_ref = chit.getDimension().x;
-        double energy   = chit.getEnergy();
-        double dist     = eicd::magnitude(hitsDist(chit, hit));
-        weights[j]      = std::exp(-dist / dist_ref) * energy;
-        j += 1;
-      }
-
-      // normalize weights
-      vec_normalize(weights);
-
-      // ignore small weights
-      for (auto& w : weights) {
-        if (w < 0.02) {
-          w = 0;
-        }
-      }
-      vec_normalize(weights);
-
-      // split energy between local maxima
-      for (size_t k = 0; k < maxima.size(); ++k) {
-        double weight = weights[k];
+    // split energy between local maxima, one proto-cluster per maximum
+    for (size_t k = 0; k < maxima.size(); ++k) {
+      for (size_t i = 0; i < nhits; ++i) {
+        double weight = m_splitWeights[k * nhits + i];
         if (weight <= 1e-6) {
           continue;
         }
-        pcls[k].addToHits(hit);
-        pcls[k].addToWeights(weight);
+        proto.add(group[i], static_cast<float>(weight));
       }
-      i += 1;
-    }
-    for (auto& pcl : pcls) {
-      proto.push_back(pcl);
+      proto.close();
     }
     if (msgLevel(MSG::VERBOSE)) {
       verbose() << "Multiple (" << maxima.size() << ") maxima found, added a ProtoClusters for each maximum" << endmsg;
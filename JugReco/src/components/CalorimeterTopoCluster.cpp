@@ -0,0 +1,261 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+/*
+ *  Topological clustering of calorimeter cells with seed, neighbour and cell thresholds in units of
+ *  the cell noise (4-2-0 by default), over the segmentation neighbours of the readout
+ */
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <queue>
+#include <vector>
+
+#include "fmt/format.h"
+
+#include "Gaudi/Property.h"
+#include "GaudiAlg/GaudiAlgorithm.h"
+#include "GaudiKernel/PhysicalConstants.h"
+
+#include "JugBase/DataHandle.h"
+#include "JugBase/ICellNeighbourSvc.h"
+#include "JugBase/Utilities/FlatIndexMap.h"
+#include "JugBase/Utilities/UnionFind.h"
+#include "JugReco/ProtoClusterIndex.h"
+
+// Event Model related classes
+#include "eicd/CalorimeterHitCollection.h"
+#include "eicd/ProtoClusterCollection.h"
+
+using namespace Gaudi::Units;
+
+namespace Jug::Reco {
+
+/** Topological cell clustering.
+ *
+ *  The significance of a cell is its energy over its noise. Every cell above seedThreshold starts a
+ *  cluster, the clusters grow from their cells above neighbourThreshold to the adjacent cells above
+ *  cellThreshold, and two clusters that reach each other through cells above neighbourThreshold are
+ *  merged. The cells below neighbourThreshold (boundary cells) go to the first cluster reaching them.
+ *
+ *  The adjacency is the neighbour table of the readout (CellNeighbourSvc), turned into a sparse
+ *  graph of the hits of the event. The growth is a breadth-first search over all clusters at once,
+ *  in decreasing significance with a priority queue, so that each hit is expanded at most once.
+ *  The output is the ProtoClusterCollection of CalorimeterIslandCluster, with unit weights, in the
+ *  order of the most significant seed of the clusters. As for CalorimeterIslandCluster, they are
+ *  also put as hit indices in outputProtoClusterIndex if given, and the podio proto-clusters are
+ *  only filled with writeProtoClusters.
+ *
+ * \ingroup reco
+ */
+class CalorimeterTopoCluster : public GaudiAlgorithm {
+private:
+  // thresholds in units of the noise
+  Gaudi::Property<double> m_seedThreshold{this, "seedThreshold", 4.};
+  Gaudi::Property<double> m_neighbourThreshold{this, "neighbourThreshold", 2.};
+  Gaudi::Property<double> m_cellThreshold{this, "cellThreshold", 0.};
+  // noise of the cells, or their energy error if set and positive
+  Gaudi::Property<double> m_noise{this, "noise", 1.0 * MeV};
+  Gaudi::Property<bool> m_noiseFromEnergyError{this, "noiseFromEnergyError", false};
+
+  Gaudi::Property<std::string> m_readout{this, "readoutClass", ""};
+  Gaudi::Property<std::string> m_cellNeighbourSvcName{this, "cellNeighbourServiceName", "CellNeighbourSvc"};
+  SmartIF<ICellNeighbourSvc> m_cellNeighbourSvc;
+  const Jug::Base::CellNeighbourTable* m_neighbourTable{nullptr};
+
+  DataHandle<eicd::CalorimeterHitCollection> m_inputHitCollection{"inputHitCollection", Gaudi::DataHandle::Reader,
+                                                                  this};
+  DataHandle<eicd::ProtoClusterCollection> m_outputProtoCollection{"outputProtoClusterCollection",
+                                                                  Gaudi::DataHandle::Writer, this};
+  Gaudi::Property<std::string> m_outputProtoIndex{this, "outputProtoClusterIndex", "",
+                                                  "Proto-clusters as hit indices (none if empty)"};
+  Gaudi::Property<bool> m_writeProtoClusters{this, "writeProtoClusters", true,
+                                             "Fill the podio proto-clusters (empty collection otherwise)"};
+  std::unique_ptr<DataHandle<ProtoClusterIndex>> m_outputProtoIndex_ptr;
+
+  // hit graph of the event (compressed rows of neighbour hit indices) and clustering state,
+  // kept to reuse their buffers
+  std::vector<float> m_significance;
+  std::vector<uint32_t> m_offsets;
+  std::vector<uint32_t> m_adjacency;
+  std::vector<uint32_t> m_cluster;
+  // merged clusters, the root is the first seed
+  Jug::Base::UnionFind m_merged;
+  ProtoClusterIndex m_protoIndex;
+
+  // unitless counterparts of the input parameters
+  double noise{0};
+
+  static constexpr uint32_t kNone = Jug::Base::FlatIndexMap::kEmpty;
+
+public:
+  CalorimeterTopoCluster(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
+    declareProperty("inputHitCollection", m_inputHitCollection, "");
+    declareProperty("outputProtoClusterCollection", m_outputProtoCollection, "");
+  }
+
+  StatusCode initialize() override {
+    if (GaudiAlgorithm::initialize().isFailure()) {
+      return StatusCode::FAILURE;
+    }
+    if (!(m_seedThreshold.value() >= m_neighbourThreshold.value() &&
+          m_neighbourThreshold.value() >= m_cellThreshold.value())) {
+      error() << "Expected seedThreshold >= neighbourThreshold >= cellThreshold" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    // unitless conversion, keep consistency with juggler internal units (GeV, mm, ns, rad)
+    noise = m_noise.value() / GeV;
+    if (noise <= 0.) {
+      error() << "noise has to be positive" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    if (!m_outputProtoIndex.value().empty()) {
+      m_outputProtoIndex_ptr =
+          std::make_unique<DataHandle<ProtoClusterIndex>>(m_outputProtoIndex, Gaudi::DataHandle::Writer, this);
+    }
+
+    m_cellNeighbourSvc = service(m_cellNeighbourSvcName);
+    if (!m_cellNeighbourSvc) {
+      error() << "Unable to locate Cell Neighbour Service " << m_cellNeighbourSvcName.value() << endmsg;
+      return StatusCode::FAILURE;
+    }
+    m_neighbourTable = m_cellNeighbourSvc->neighbourTable(m_readout.value());
+    if (m_neighbourTable == nullptr) {
+      error() << "No cell neighbour table for readout " << m_readout.value() << endmsg;
+      return StatusCode::FAILURE;
+    }
+    info() << fmt::format("Topological clustering of {} with thresholds {}-{}-{} x {:g} MeV", m_readout.value(),
+                          m_seedThreshold.value(), m_neighbourThreshold.value(), m_cellThreshold.value(),
+                          noise * 1000.)
+           << endmsg;
+    return StatusCode::SUCCESS;
+  }
+
+  StatusCode execute() override {
+    // input collections
+    const auto& hits = *(m_inputHitCollection.get());
+    // Create output collections
+    auto& proto = *(m_outputProtoCollection.createAndPut());
+    auto& index = m_outputProtoIndex_ptr ? *(m_outputProtoIndex_ptr->createAndPut()) : m_protoIndex;
+
+    const size_t n = hits.size();
+    build_graph(hits);
+
+    // clusters are numbered by their seeds, merged clusters share the root of the union-find
+    m_cluster.assign(n, kNone);
+    m_merged.reset(0);
+    struct Entry {
+      float significance;
+      uint32_t hit;
+      bool operator<(const Entry& other) const {
+        // the most significant first, then in hit order
+        return significance < other.significance || (significance == other.significance && hit > other.hit);
+      }
+    };
+    std::vector<Entry> seeds;
+    for (uint32_t i = 0; i < n; ++i) {
+      if (m_significance[i] >= m_seedThreshold.value()) {
+        seeds.push_back({m_significance[i], i});
+      }
+    }
+    std::sort(seeds.begin(), seeds.end(), [](const Entry& a, const Entry& b) { return b < a; });
+    std::priority_queue<Entry, std::vector<Entry>> queue;
+    for (const auto& seed : seeds) {
+      m_cluster[seed.hit] = m_merged.add();
+      queue.push(seed);
+    }
+
+    // grow all clusters at once, in decreasing significance
+    const float growThreshold = m_neighbourThreshold.value();
+    const float cellThreshold = m_cellThreshold.value();
+    while (!queue.empty()) {
+      const auto current = queue.top().hit;
+      queue.pop();
+      const auto cluster = m_merged.find(m_cluster[current]);
+      for (uint32_t k = m_offsets[current]; k < m_offsets[current + 1]; ++k) {
+        const auto nb = m_adjacency[k];
+        if (m_significance[nb] < cellThreshold) {
+          continue;
+        }
+        if (m_cluster[nb] == kNone) {
+          m_cluster[nb] = cluster;
+          // only the cells above the neighbour threshold grow the cluster
+          if (m_significance[nb] >= growThreshold) {
+            queue.push({m_significance[nb], nb});
+          }
+        } else if (m_significance[nb] >= growThreshold) {
+          m_merged.unite(cluster, m_cluster[nb]);
+        }
+      }
+    }
+
+    // proto-clusters in the order of their seeds, the merged clusters are in the one of the first seed
+    std::vector<uint32_t> output(m_merged.size(), kNone);
+    uint32_t nclusters = 0;
+    for (uint32_t c = 0; c < m_merged.size(); ++c) {
+      const auto root = m_merged.find(c);
+      if (output[root] == kNone) {
+        output[root] = nclusters++;
+      }
+    }
+    // hits of the proto-clusters in hit order, counted then placed
+    index.begin.assign(nclusters + 1, 0);
+    for (size_t i = 0; i < n; ++i) {
+      if (m_cluster[i] != kNone) {
+        m_cluster[i] = output[m_merged.find(m_cluster[i])];
+        ++index.begin[m_cluster[i] + 1];
+      }
+    }
+    for (uint32_t k = 0; k < nclusters; ++k) {
+      index.begin[k + 1] += index.begin[k];
+    }
+    index.hit.resize(index.begin[nclusters]);
+    index.weight.assign(index.begin[nclusters], 1.F);
+    std::vector<uint32_t> fill(index.begin.begin(), index.begin.end() - 1);
+    for (uint32_t i = 0; i < n; ++i) {
+      if (m_cluster[i] != kNone) {
+        index.hit[fill[m_cluster[i]]++] = i;
+      }
+    }
+    if (m_writeProtoClusters.value()) {
+      index.to_collection(hits, proto);
+    }
+
+    if (msgLevel(MSG::DEBUG)) {
+      debug() << fmt::format("{} hits, {} seeds, {} proto-clusters", n, seeds.size(), nclusters) << endmsg;
+    }
+    return StatusCode::SUCCESS;
+  }
+
+private:
+  // significance of the hits and their neighbours among the hits, in compressed rows
+  void build_graph(const eicd::CalorimeterHitCollection& hits) {
+    const size_t n = hits.size();
+    Jug::Base::FlatIndexMap cellIndex(n);
+    m_significance.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+      const auto hit = hits[i];
+      cellIndex.emplace(hit.getCellID(), static_cast<uint32_t>(i));
+      const double sigma =
+          (m_noiseFromEnergyError.value() && hit.getEnergyError() > 0.) ? hit.getEnergyError() : noise;
+      m_significance[i] = hit.getEnergy() / sigma;
+    }
+    m_offsets.resize(n + 1);
+    m_adjacency.clear();
+    m_offsets[0] = 0;
+    for (size_t i = 0; i < n; ++i) {
+      for (const auto cellID : m_neighbourTable->neighbours(hits[i].getCellID())) {
+        const auto j = cellIndex.find(cellID);
+        if (j != kNone && j != i) {
+          m_adjacency.push_back(j);
+        }
+      }
+      m_offsets[i + 1] = m_adjacency.size();
+    }
+  }
+};
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(CalorimeterTopoCluster)
+
+} // namespace Jug::Reco
@@ -9,7 +9,7 @@
  */
 #include <algorithm>
 #include <cstring>
-#include <functional>
+#include <limits>
 #include <map>
 
 #include "boost/algorithm/string/join.hpp"
@@ -17,9 +17,6 @@
 #include <boost/range/adaptor/map.hpp>
 
 #include "Gaudi/Property.h"
-#include "GaudiAlg/GaudiAlgorithm.h"
-#include "GaudiAlg/GaudiTool.h"
-#include "GaudiAlg/Transformer.h"
 #include "GaudiKernel/PhysicalConstants.h"
 #include "GaudiKernel/RndmGenerators.h"
 #include "GaudiKernel/ToolHandle.h"
@@ -30,10 +27,16 @@
 
 #include "JugBase/DataHandle.h"
 #include "JugBase/IGeoSvc.h"
+#include "JugBase/Utilities/FlatIndexMap.h"
+#include "JugBase/Transformer.h"
+#include "JugReco/CalorimeterHitCache.h"
+#include "JugReco/ProtoClusterIndex.h"
+#include "JugReco/ShowerAxis.h"
 
 // Event Model related classes
 #include "edm4hep/MCParticle.h"
 #include "edm4hep/SimCalorimeterHitCollection.h"
+#include "eicd/CalorimeterHitCollection.h"
 #include "eicd/ClusterCollection.h"
 #include "eicd/MCRecoClusterParticleAssociationCollection.h"
 #include "eicd/ProtoClusterCollection.h"
@@ -51,20 +54,37 @@ static double logWeight(double E, double tE, double base, int /*type*/) {
   return std::max(0., base + std::log(E / tE));
 }
 
-static const std::map<std::string, std::function<double(double, double, double, int)>> weightMethods{
-    {"none", constWeight},
-    {"linear", linearWeight},
-    {"log", logWeight},
+// weighting methods, resolved once in initialize
+enum class WeightMethod { kNone, kLinear, kLog };
+
+static const std::map<std::string, WeightMethod> weightMethods{
+    {"none", WeightMethod::kNone},
+    {"linear", WeightMethod::kLinear},
+    {"log", WeightMethod::kLog},
 };
 
+template <WeightMethod method> static double hitWeight(double E, double tE, double base) {
+  if constexpr (method == WeightMethod::kNone) {
+    return constWeight(E, tE, base, 0);
+  } else if constexpr (method == WeightMethod::kLinear) {
+    return linearWeight(E, tE, base, 0);
+  } else {
+    return logWeight(E, tE, base, 0);
+  }
+}
+
 /** Clustering with center of gravity method.
  *
  *  Reconstruct the cluster with Center of Gravity method
  *  Logarithmic weighting is used for mimicking energy deposit in transverse direction
+ *  The shape parameters are the radius, the skewness (not calculated) and the transverse width
+ *  around the principal axis of the weighted hits, from the moments of the centroid loop.
+ *  With inputProtoClusterIndex and inputHitCollection, the proto-clusters are read as indices of
+ *  the hits (ProtoClusterIndex of the clustering) instead of the podio proto-clusters.
  *
  * \ingroup reco
  */
-class ClusterRecoCoG : public GaudiAlgorithm {
+class ClusterRecoCoG : public Jug::Transformer<eicd::ClusterCollection, eicd::ProtoClusterCollection> {
 private:
   Gaudi::Property<double> m_sampFrac{this, "samplingFraction", 1.0};
   Gaudi::Property<double> m_logWeightBase{this, "logWeightBase", 3.6};
@@ -76,8 +96,11 @@ private:
   // for endcaps.
   Gaudi::Property<bool> m_enableEtaBounds{this, "enableEtaBounds", false};
 
-  DataHandle<eicd::ProtoClusterCollection> m_inputProto{"inputProtoClusterCollection", Gaudi::DataHandle::Reader, this};
-  DataHandle<eicd::ClusterCollection> m_outputClusters{"outputClusterCollection", Gaudi::DataHandle::Writer, this};
+  // Proto-clusters as hit indices and their hits, instead of the input proto-clusters
+  Gaudi::Property<std::string> m_inputProtoIndex{this, "inputProtoClusterIndex", ""};
+  Gaudi::Property<std::string> m_inputHits{this, "inputHitCollection", ""};
+  std::unique_ptr<DataHandle<ProtoClusterIndex>> m_inputProtoIndex_ptr;
+  std::unique_ptr<DataHandle<eicd::CalorimeterHitCollection>> m_inputHits_ptr;
 
   // Collection for MC hits when running on MC
   Gaudi::Property<std::string> m_mcHits{this, "mcHits", ""};
@@ -92,18 +115,29 @@ private:
   // Pointer to the geometry service
   SmartIF<IGeoSvc> m_geoSvc;
   double m_depthCorr{0};
-  std::function<double(double, double, double, int)> weightFunc;
+  WeightMethod m_weightMethod{WeightMethod::kLog};
 
 public:
-  ClusterRecoCoG(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
-    declareProperty("inputProtoClusterCollection", m_inputProto, "");
-    declareProperty("outputClusterCollection", m_outputClusters, "");
-  }
+  ClusterRecoCoG(const std::string& name, ISvcLocator* svcLoc)
+      : MultiTransformer(name, svcLoc, {KeyValue{"inputProtoClusterCollection", "inputProtoClusterCollection"}},
+                         {KeyValue{"outputClusterCollection", "outputClusterCollection"}}) {}
 
   StatusCode initialize() override {
-    if (GaudiAlgorithm::initialize().isFailure()) {
+    if (Gaudi::Algorithm::initialize().isFailure()) {
+      return StatusCode::FAILURE;
+    }
+
+    // Initialize the optional proto-cluster index if requested, with the hits it refers to
+    if (m_inputProtoIndex.value().empty() != m_inputHits.value().empty()) {
+      error() << "inputProtoClusterIndex and inputHitCollection are used together" << endmsg;
       return StatusCode::FAILURE;
     }
+    if (!m_inputProtoIndex.value().empty()) {
+      m_inputProtoIndex_ptr =
+          std::make_unique<DataHandle<ProtoClusterIndex>>(m_inputProtoIndex, Gaudi::DataHandle::Reader, this);
+      m_inputHits_ptr = std::make_unique<DataHandle<eicd::CalorimeterHitCollection>>(m_inputHits,
+                                                                                     Gaudi::DataHandle::Reader, this);
+    }
 
     // Initialize the optional MC input hit collection if requested
     if (m_mcHits != "") {
@@ -141,15 +175,12 @@ public:
               << endmsg;
       return StatusCode::FAILURE;
     }
-    weightFunc = it->second;
+    m_weightMethod = it->second;
     // info() << "z_length " << depth << endmsg;
     return StatusCode::SUCCESS;
   }
 
-  StatusCode execute() override {
-    // input collections
-    const auto& proto  = *m_inputProto.get();
-    auto& clusters     = *m_outputClusters.createAndPut();
+  void operator()(const eicd::ProtoClusterCollection& proto, eicd::ClusterCollection& clusters) const override {
 
     // Optional input MC data
     const edm4hep::SimCalorimeterHitCollection* mchits = nullptr;
@@ -163,8 +194,34 @@ public:
       associations = m_outputAssociations_ptr->createAndPut();
     }
 
-    for (const auto& pcl : proto) {
-      auto cl = reconstruct(pcl);
+    // index of the first mc hit of each cellID, for the truth association
+    Jug::Base::FlatIndexMap mchit_index;
+    if (mchits != nullptr && associations != nullptr) {
+      mchit_index.reserve(mchits->size());
+      for (size_t i = 0; i < mchits->size(); ++i) {
+        mchit_index.emplace((*mchits)[i].getCellID(), static_cast<uint32_t>(i));
+      }
+    }
+
+    // Optional input proto-clusters as hit indices
+    const ProtoClusterIndex* index                 = nullptr;
+    const eicd::CalorimeterHitCollection* inputHits = nullptr;
+    if (m_inputProtoIndex_ptr) {
+      index     = m_inputProtoIndex_ptr->get();
+      inputHits = m_inputHits_ptr->get();
+    }
+
+    // contiguous copy of the proto-cluster hits, its buffers are reused for the clusters of the event
+    CalorimeterHitCache hits;
+    const size_t nproto = (index != nullptr) ? index->size() : proto.size();
+    for (size_t k = 0; k < nproto; ++k) {
+      if (index != nullptr) {
+        hits.fill(*inputHits, *index, k);
+      } else {
+        hits.fill(proto[k]);
+      }
+      size_t maxHit = 0;
+      auto cl       = reconstruct(hits, maxHit);
 
       if (msgLevel(MSG::DEBUG)) {
         debug() << cl.getNhits() << " hits: " << cl.getEnergy() / GeV << " GeV, (" << cl.getPosition().x / mm << ", "
@@ -176,41 +233,21 @@ public:
       // 1. find proto-cluster hit with largest energy deposition
       // 2. find first mchit with same CellID
       // 3. assign mchit's MCParticle as cluster truth
-      if (m_mcHits_ptr.get() != nullptr && m_outputAssociations_ptr.get() != nullptr) {
-
-        // 1. find pclhit with largest energy deposition
-        auto pclhits = pcl.getHits();
-        auto pclhit = std::max_element(
-          pclhits.begin(),
-          pclhits.end(),
-          [](const auto& pclhit1, const auto& pclhit2) {
-            return pclhit1.getEnergy() < pclhit2.getEnergy();
-          }
-        );
-
-        // 2. find mchit with same CellID
-        // find_if not working, https://github.com/AIDASoft/podio/pull/273
-        //auto mchit = std::find_if(
-        //  mchits.begin(),
-        //  mchits.end(),
-        //  [&pclhit](const auto& mchit1) {
-        //    return mchit1.getCellID() == pclhit->getCellID();
-        //  }
-        //);
-        auto mchit = mchits->begin();
-        for ( ; mchit != mchits->end(); ++mchit) {
-          // break loop when CellID match found
-          if (mchit->getCellID() == pclhit->getCellID()) {
-            break;
-          }
-        }
-        if (!(mchit != mchits->end())) {
+      if (m_mcHits_ptr.get() != nullptr && m_outputAssociations_ptr.get() != nullptr && !hits.empty()) {
+
+        // 1. find pclhit with largest energy deposition, found in the reconstruction
+        const auto pclhit =
+            (index != nullptr) ? (*inputHits)[index->hit[index->begin[k] + maxHit]] : proto[k].getHits(maxHit);
+
+        // 2. find the first mchit with same CellID, from the index of the event
+        const auto mchit_i = mchit_index.find(pclhit.getCellID());
+        if (mchit_i == Jug::Base::FlatIndexMap::kEmpty) {
           // break if no matching hit found for this CellID
-          warning() << "Proto-cluster has highest energy in CellID " << pclhit->getCellID()
+          warning() << "Proto-cluster has highest energy in CellID " << pclhit.getCellID()
                     << ", but no mc hit with that CellID was found." << endmsg;
           info() << "Proto-cluster hits: " << endmsg;
-          for (const auto& pclhit1: pclhits) {
-            info() << pclhit1.getCellID() << ": " << pclhit1.getEnergy() << endmsg;
+          for (size_t i = 0; i < hits.size(); ++i) {
+            info() << hits.cellID[i] << ": " << hits.energy[i] << endmsg;
           }
           info() << "MC hits: " << endmsg;
           for (const auto& mchit1: *mchits) {
@@ -219,14 +256,16 @@ public:
           break;
         }
 
+        const auto mchit = (*mchits)[mchit_i];
+
         // 3. find mchit's MCParticle
-        const auto& mcp = mchit->getContributions(0).getParticle();
+        const auto& mcp = mchit.getContributions(0).getParticle();
 
         // debug output
         if (msgLevel(MSG::DEBUG)) {
-          debug() << "cluster has largest energy in cellID: " << pclhit->getCellID() << endmsg;
-          debug() << "pcl hit with highest energy " << pclhit->getEnergy() << " at index " << pclhit->getObjectID().index << endmsg;
-          debug() << "corresponding mc hit energy " << mchit->getEnergy() << " at index " << mchit->getObjectID().index << endmsg;
+          debug() << "cluster has largest energy in cellID: " << pclhit.getCellID() << endmsg;
+          debug() << "pcl hit with highest energy " << pclhit.getEnergy() << " at index " << pclhit.getObjectID().index << endmsg;
+          debug() << "corresponding mc hit energy " << mchit.getEnergy() << " at index " << mchit.getObjectID().index << endmsg;
           debug() << "from MCParticle index " << mcp.getObjectID().index << ", PDG " << mcp.getPDG() << ", " << eicd::magnitude(mcp.getMomentum()) << endmsg;
         }
 
@@ -244,47 +283,66 @@ public:
         }
       }
     }
-
-    return StatusCode::SUCCESS;
   }
 
 private:
-  eicd::MutableCluster reconstruct(const eicd::ProtoCluster& pcl) const {
+  eicd::MutableCluster reconstruct(const CalorimeterHitCache& hits, size_t& maxHit) const {
+    switch (m_weightMethod) {
+    case WeightMethod::kNone:
+      return reconstruct<WeightMethod::kNone>(hits, maxHit);
+    case WeightMethod::kLinear:
+      return reconstruct<WeightMethod::kLinear>(hits, maxHit);
+    default:
+      return reconstruct<WeightMethod::kLog>(hits, maxHit);
+    }
+  }
+
+  // maxHit is the (first) hit with the largest energy
+  template <WeightMethod method>
+  eicd::MutableCluster reconstruct(const CalorimeterHitCache& hits, size_t& maxHit) const {
     eicd::MutableCluster cl;
-    cl.setNhits(pcl.hits_size());
+    cl.setNhits(hits.size());
 
     // no hits
-    if (msgLevel(MSG::DEBUG)) {
-      debug() << "hit size = " << pcl.hits_size() << endmsg;
+    const bool debugHits = msgLevel(MSG::DEBUG);
+    if (debugHits) {
+      debug() << "hit size = " << hits.size() << endmsg;
     }
-    if (pcl.hits_size() == 0) {
+    if (hits.empty()) {
       return cl;
     }
 
-    // calculate total energy, find the cell with the maximum energy deposit
-    float totalE = 0.;
-    float maxE   = 0.;
+    // one pass for the total energy, the cell with the maximum energy deposit and the eta bounds,
+    // with the moments of the weights that do not depend on the total energy
+    constexpr bool fused = (method != WeightMethod::kLog);
+    const double base    = m_logWeightBase.value();
+    float totalE         = 0.;
+    float maxE           = hits.energy[0];
+    maxHit               = 0;
     // Used to optionally constrain the cluster eta to those of the contributing hits
     float minHitEta = std::numeric_limits<float>::max();
-    float maxHitEta = std::numeric_limits<float>::min();
-    auto time       = pcl.getHits()[0].getTime();
-    auto timeError  = pcl.getHits()[0].getTimeError();
-    for (unsigned i = 0; i < pcl.getHits().size(); ++i) {
-      const auto& hit   = pcl.getHits()[i];
-      const auto weight = pcl.getWeights()[i];
-      if (msgLevel(MSG::DEBUG)) {
-        debug() << "hit energy = " << hit.getEnergy() << " hit weight: " << weight << endmsg;
+    float maxHitEta = std::numeric_limits<float>::lowest();
+    auto time       = hits.time[0];
+    auto timeError  = hits.timeError[0];
+    // weighted moments for the center of gravity and the shower axis, unweighted ones for the radius
+    PositionMoments moments;
+    PositionMoments spread;
+    for (unsigned i = 0; i < hits.size(); ++i) {
+      const auto weight = hits.weight[i];
+      if (debugHits) {
+        debug() << "hit energy = " << hits.energy[i] << " hit weight: " << weight << endmsg;
       }
-      auto energy = hit.getEnergy() * weight;
+      const float energy = hits.energy[i] * weight;
       totalE += energy;
-      if (energy > maxE) {
+      if (hits.energy[i] > maxE) {
+        maxE   = hits.energy[i];
+        maxHit = i;
       }
-      const float eta = eicd::eta(hit.getPosition());
-      if (eta < minHitEta) {
-        minHitEta = eta;
-      }
-      if (eta > maxHitEta) {
-        maxHitEta = eta;
+      minHitEta = std::min(minHitEta, hits.eta[i]);
+      maxHitEta = std::max(maxHitEta, hits.eta[i]);
+      spread.add(hits.x[i], hits.y[i], hits.z[i], 1.);
+      if constexpr (fused) {
+        moments.add(hits.x[i], hits.y[i], hits.z[i], static_cast<float>(hitWeight<method>(energy, 0., base)));
       }
     }
     cl.setEnergy(totalE / m_sampFrac);
@@ -292,20 +350,18 @@ private:
     cl.setTime(time);
     cl.setTimeError(timeError);
 
-    // center of gravity with logarithmic weighting
-    float tw = 0.;
-    auto v   = cl.getPosition();
-    for (unsigned i = 0; i < pcl.getHits().size(); ++i) {
-      const auto& hit   = pcl.getHits()[i];
-      const auto weight = pcl.getWeights()[i];
-      float w           = weightFunc(hit.getEnergy() * weight, totalE, m_logWeightBase.value(), 0);
-      tw += w;
-      v = v + (hit.getPosition() * w);
+    // center of gravity with logarithmic weighting, relative to the total energy
+    if constexpr (!fused) {
+      for (unsigned i = 0; i < hits.size(); ++i) {
+        const float w = hitWeight<method>(hits.energy[i] * hits.weight[i], totalE, base);
+        moments.add(hits.x[i], hits.y[i], hits.z[i], w);
+      }
     }
-    if (tw == 0.) {
+    if (moments.sumOfWeights == 0.) {
       warning() << "zero total weights encountered, you may want to adjust your weighting parameter." << endmsg;
     }
-    cl.setPosition(v / tw);
+    const auto cog = moments.mean();
+    cl.setPosition({static_cast<float>(cog.x()), static_cast<float>(cog.y()), static_cast<float>(cog.z())});
     cl.setPositionError({}); // @TODO: Covariance matrix
 
     // Optionally constrain the cluster to the hit eta values
@@ -333,17 +389,18 @@ private:
     cl.setIntrinsicPhi(eicd::angleAzimuthal(cl.getPosition()));
     // TODO errors
 
-    // Calculate radius
+    // Calculate radius, sum |c - x|^2 = sum |x|^2 - 2 c . sum x + n |c|^2
     // @TODO: add skewness
     if (cl.getNhits() > 1) {
-      double radius = 0;
-      for (const auto& hit : pcl.getHits()) {
-        const auto delta = cl.getPosition() - hit.getPosition();
-        radius += delta * delta;
-      }
-      radius = sqrt((1. / (cl.getNhits() - 1.)) * radius);
+      const auto& c = cl.getPosition();
+      double radius = (spread.xx + spread.yy + spread.zz) - 2. * (c.x * spread.x + c.y * spread.y + c.z * spread.z) +
+                      spread.sumOfWeights * (static_cast<double>(c.x) * c.x + static_cast<double>(c.y) * c.y +
+                                             static_cast<double>(c.z) * c.z);
+      radius = sqrt((1. / (cl.getNhits() - 1.)) * std::max(radius, 0.));
       cl.addToShapeParameters(radius);
       cl.addToShapeParameters(0 /* skewness */); // skewness not yet calculated
+      // transverse width around the principal axis of the weighted hits
+      cl.addToShapeParameters(principal_axis(moments).width);
     }
 
     return cl;
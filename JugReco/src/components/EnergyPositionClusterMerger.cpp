@@ -13,6 +13,7 @@
 #include "GaudiKernel/PhysicalConstants.h"
 
 #include "JugBase/DataHandle.h"
+#include "JugBase/Utilities/PhiWindowMatcher.h"
 
 // Event Model related classes
 #include "eicd/ClusterCollection.h"
@@ -32,6 +33,9 @@ namespace Jug::Reco {
  *
  * In case of ambiguity the closest cluster is merged.
  *
+ * The energy clusters are sorted by phi once per event (Jug::Base::PhiWindowMatcher), so that
+ * each position cluster only compares to the energy clusters within phiTolerance.
+ *
  * \ingroup reco
  */
 class EnergyPositionClusterMerger : public GaudiAlgorithm {
@@ -49,6 +53,8 @@ private:
   double m_zTolerance{0};
   double m_phiTolerance{0};
 
+  Jug::Base::PhiWindowMatcher m_matcher;
+
 public:
   EnergyPositionClusterMerger(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
     declareProperty("energyClusters", m_energyClusters, "Cluster collection with good energy precision");
@@ -57,8 +63,11 @@ public:
   }
 
   StatusCode initialize() override {
+    if (GaudiAlgorithm::initialize().isFailure()) {
+      return StatusCode::FAILURE;
+    }
     m_zTolerance   = m_zToleranceUnits / mm;
-    m_phiTolerance = m_phiTolerance / rad;
+    m_phiTolerance = m_phiToleranceUnits / rad;
     return StatusCode::SUCCESS;
   }
 
@@ -69,42 +78,21 @@ public:
     // output
     auto& merged = *(m_outputClusters.createAndPut());
 
-    std::vector<bool> consumed(e_clus.size(), false);
+    m_matcher.clear();
+    m_matcher.reserve(e_clus.size());
+    for (const auto& ec : e_clus) {
+      m_matcher.add(eicd::angleAzimuthal(ec.getPosition()), ec.getPosition().z, ec.getEnergy());
+    }
+    const Jug::Base::PhiWindowMatcher::Tolerances tolerances{m_phiTolerance, m_zTolerance, m_energyRelTolerance};
 
     // use position clusters as starting point
     for (const auto& pc : pos_clus) {
-      // check if we find a good match
-      int best_match    = -1;
-      double best_delta = std::numeric_limits<double>::max();
-      for (size_t ie = 0; ie < e_clus.size(); ++ie) {
-        if (consumed[ie]) {
-          continue;
-        }
-        const auto& ec = e_clus[ie];
-        // 1. stop if not within tolerance
-        //    (make sure to handle rollover of phi properly)
-        double dphi = eicd::angleAzimuthal(pc.getPosition()) - eicd::angleAzimuthal(ec.getPosition());
-        if (std::abs(dphi) > M_PI) {
-          dphi = std::abs(dphi) - M_PI;
-        }
-        if ((m_energyRelTolerance > 0 &&
-             (ec.getEnergy() <= 0 || fabs((pc.getEnergy() - ec.getEnergy()) / ec.getEnergy()) > m_energyRelTolerance)) ||
-            (m_zTolerance > 0 && fabs(pc.getPosition().z - ec.getPosition().z) > m_zTolerance) ||
-            (m_phiTolerance > 0 && dphi > m_phiTolerance)) {
-          continue;
-        }
-        // --> if we get here, we have a match within tolerance. Now treat the case
-        //     where we have multiple matches. In this case take the one with the closest
-        //     energies.
-        // 2. best match?
-        const double delta = fabs(pc.getEnergy() - ec.getEnergy());
-        if (delta < best_delta) {
-          best_delta = delta;
-          best_match = ie;
-        }
-      }
+      // check if we find a good match: within tolerance, and in case of multiple matches
+      // the one with the closest energies
+      const auto best_match =
+          m_matcher.match(eicd::angleAzimuthal(pc.getPosition()), pc.getPosition().z, pc.getEnergy(), tolerances);
       // Create a merged cluster if we find a good match
-      if (best_match >= 0) {
+      if (best_match != Jug::Base::PhiWindowMatcher::kNone) {
         const auto& ec = e_clus[best_match];
         auto new_clus  = merged.create();
         new_clus.setEnergy(ec.getEnergy());
@@ -116,7 +104,7 @@ public:
         new_clus.addToClusters(pc);
         new_clus.addToClusters(ec);
         // label our energy cluster as consumed
-        consumed[best_match] = true;
+        m_matcher.consume(best_match);
         if (msgLevel(MSG::DEBUG)) {
           debug() << fmt::format("Matched position cluster {} with energy cluster {}\n", pc.id(), ec.id()) << endmsg;
           debug() << fmt::format("  - Position cluster: (E: {}, phi: {}, z: {})", pc.getEnergy(),
@@ -16,7 +16,9 @@
 #include "DDRec/SurfaceManager.h"
 
 #include "JugBase/DataHandle.h"
+#include "JugBase/ICellGeometrySvc.h"
 #include "JugBase/IGeoSvc.h"
+#include "JugReco/FarForwardTracks.h"
 
 // Event Model related classes
 #include "eicd/ReconstructedParticleCollection.h"
@@ -41,6 +43,7 @@ private:
   Gaudi::Property<double> nomMomentum{this, "beamMomentum", 275.0};
 
   Gaudi::Property<std::string> m_geoSvcName{this, "geoServiceName", "GeoSvc"};
+  Gaudi::Property<std::string> m_cellGeoSvcName{this, "cellGeometryServiceName", "CellGeometrySvc"};
   Gaudi::Property<std::string> m_readout{this, "readoutClass", ""};
   Gaudi::Property<std::string> m_layerField{this, "layerField", ""};
   Gaudi::Property<std::string> m_sectorField{this, "sectorField", ""};
@@ -50,14 +53,25 @@ private:
 
   Gaudi::Property<std::string> m_localDetElement{this, "localDetElement", ""};
   Gaudi::Property<std::vector<std::string>> u_localDetFields{this, "localDetFields", {}};
-  dd4hep::DetElement local;
   size_t local_mask = ~0;
-
-  const double aXRP[2][2] = {{2.102403743, 29.11067626}, {0.186640381, 0.192604619}};
-  const double aYRP[2][2] = {{0.0000159900, 3.94082098}, {0.0000079946, -0.1402995}};
-
-  double aXRPinv[2][2] = {{0.0, 0.0}, {0.0, 0.0}};
-  double aYRPinv[2][2] = {{0.0, 0.0}, {0.0, 0.0}};
+  // cached local hit positions, shared with the other hit reconstructions
+  SmartIF<ICellGeometrySvc> m_cellGeoSvc;
+  const Jug::Base::CellGeometryTable* m_cellGeometry{nullptr};
+
+  // transfer matrices (row-major) from (deltaP / p [%], angle [mrad]) at the IP to (position [mm], slope [mrad])
+  Gaudi::Property<std::vector<double>> u_transferX{this, "transferMatrixX",
+                                                    {2.102403743, 29.11067626, 0.186640381, 0.192604619}};
+  Gaudi::Property<std::vector<double>> u_transferY{this, "transferMatrixY",
+                                                    {0.0000159900, 3.94082098, 0.0000079946, -0.1402995}};
+  // hit pairing between the first and the last station (in mm), no window cut if not positive
+  Gaudi::Property<double> m_planeTolerance{this, "planeTolerance", 1.};
+  Gaudi::Property<double> m_stationSeparation{this, "stationSeparation", 100.};
+  Gaudi::Property<double> m_xWindow{this, "xWindow", -1.};
+  Gaudi::Property<double> m_yWindow{this, "yWindow", -1.};
+
+  FarForwardTracks m_tracks;
+  std::vector<uint64_t> m_cellIDs;
+  std::vector<const Jug::Base::CellGeometry*> m_geometries;
 
 public:
   FarForwardParticles(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
@@ -83,6 +97,18 @@ public:
       return StatusCode::FAILURE;
     }
 
+    m_cellGeoSvc = service(m_cellGeoSvcName);
+    if (!m_cellGeoSvc) {
+      error() << "Unable to locate Cell Geometry Service " << m_cellGeoSvcName.value() << endmsg;
+      return StatusCode::FAILURE;
+    }
+    // local positions in the localDetElement, or in the lowest level DetElement of the cell
+    m_cellGeometry = m_cellGeoSvc->geometryTable({m_readout.value(), m_localDetElement.value(), {}, "", ""});
+    if (m_cellGeometry == nullptr) {
+      error() << "Failed to locate local coordinate system from DetElement " << m_localDetElement.value() << endmsg;
+      return StatusCode::FAILURE;
+    }
+
     // do not get the layer/sector ID if no readout class provided
     if (m_readout.value().empty()) {
       return StatusCode::SUCCESS;
@@ -106,13 +132,7 @@ public:
 
     // local detector name has higher priority
     if (!m_localDetElement.value().empty()) {
-      try {
-        local = m_geoSvc->detector()->detector(m_localDetElement.value());
-        info() << "Local coordinate system from DetElement " << m_localDetElement.value() << endmsg;
-      } catch (...) {
-        error() << "Failed to locate local coordinate system from DetElement " << m_localDetElement.value() << endmsg;
-        return StatusCode::FAILURE;
-      }
+      info() << "Local coordinate system from DetElement " << m_localDetElement.value() << endmsg;
       // or get from fields
     } else {
       std::vector<std::pair<std::string, int>> fields;
@@ -129,25 +149,23 @@ public:
       //        << endmsg;
     }
 
-    double det = aXRP[0][0] * aXRP[1][1] - aXRP[0][1] * aXRP[1][0];
-
-    if (det == 0) {
+    if (u_transferX.size() != 4 || u_transferY.size() != 4) {
+      error() << "Expected 4 values (2 x 2, row-major) for transferMatrixX and transferMatrixY" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    FarForwardOptics optics;
+    optics.transferX << u_transferX.value()[0], u_transferX.value()[1], u_transferX.value()[2], u_transferX.value()[3];
+    optics.transferY << u_transferY.value()[0], u_transferY.value()[1], u_transferY.value()[2], u_transferY.value()[3];
+    optics.xSlopeOffset = local_x_slope_offset;
+    optics.ySlopeOffset = local_y_slope_offset;
+    optics.beamMomentum = nomMomentum;
+    const FarForwardTracks::Settings settings{m_planeTolerance, m_stationSeparation, m_xWindow, m_yWindow};
+    if (!m_tracks.configure(optics, settings)) {
       error() << "Reco matrix determinant = 0!"
               << "Matrix cannot be inverted! Double-check matrix!" << endmsg;
       return StatusCode::FAILURE;
     }
 
-    aXRPinv[0][0] = aXRP[1][1] / det;
-    aXRPinv[0][1] = -aXRP[0][1] / det;
-    aXRPinv[1][0] = -aXRP[1][0] / det;
-    aXRPinv[1][1] = aXRP[0][0] / det;
-
-    det           = aYRP[0][0] * aYRP[1][1] - aYRP[0][1] * aYRP[1][0];
-    aYRPinv[0][0] = aYRP[1][1] / det;
-    aYRPinv[0][1] = -aYRP[0][1] / det;
-    aYRPinv[1][0] = -aYRP[1][0] / det;
-    aYRPinv[1][1] = aYRP[0][0] / det;
-
     return StatusCode::SUCCESS;
   }
 
@@ -155,105 +173,29 @@ public:
     const eicd::TrackerHitCollection* rawhits = m_inputHitCollection.get();
     auto& rc                                 = *(m_outputParticles.createAndPut());
 
-    auto converter = m_geoSvc->cellIDPositionConverter();
-
-    // for (const auto& part : mc) {
-    //    if (part.genStatus() > 1) {
-    //        if (msgLevel(MSG::DEBUG)) {
-    //            debug() << "ignoring particle with genStatus = " << part.genStatus() << endmsg;
-    //        }
-    //        continue;
-    //    }
-
     //---- begin Roman Pot Reconstruction code ----
 
-    int eventReset = 0; // counter for IDing at least one hit per layer
-    std::vector<double> hitx;
-    std::vector<double> hity;
-    std::vector<double> hitz;
-
+    // hit positions in local coordinates, looked up together
+    m_cellIDs.clear();
     for (const auto& h : *rawhits) {
-
-      auto cellID = h.getCellID();
-      // The actual hit position in Global Coordinates
-      // auto pos0 = h.position();
-
-      auto gpos = converter->position(cellID);
-      // local positions
-      if (m_localDetElement.value().empty()) {
-        auto volman = m_geoSvc->detector()->volumeManager();
-        local       = volman.lookupDetElement(cellID);
-      }
-      auto pos0 = local.nominal().worldToLocal(
-          dd4hep::Position(gpos.x(), gpos.y(), gpos.z())); // hit position in local coordinates
-
-      // auto mom0 = h.momentum;
-      // auto pidCode = h.g4ID;
-      auto eDep = h.getEdep();
-
-      if (eDep < 0.00001) {
+      if (h.getEdep() < 0.00001) {
         continue;
       }
-
-      if (eventReset < 2) {
-        hitx.push_back(pos0.x()); // - local_x_offset_station_2);
-      }                           // use station 2 for both offsets since it is used for the reference orbit
-      else {
-        hitx.push_back(pos0.x()); // - local_x_offset_station_2);
-      }
-
-      hity.push_back(pos0.y());
-      hitz.push_back(pos0.z());
-
-      eventReset++;
+      m_cellIDs.push_back(h.getCellID());
+    }
+    m_cellGeometry->geometry(m_cellIDs, m_geometries);
+    // station 2 is the reference orbit, its x offset is not subtracted in the local coordinates
+    m_tracks.clear();
+    for (const auto* geo : m_geometries) {
+      const auto& pos0 = geo->local;
+      m_tracks.add(pos0.x(), pos0.y(), pos0.z());
     }
 
-    // NB:
-    // This is a "dumb" algorithm - I am just checking the basic thing works with a simple single-proton test.
-    // Will need to update and modify for generic # of hits for more complicated final-states.
-
-    if (eventReset == 4) {
-
-      // extract hit, subtract orbit offset – this is to get the hits in the coordinate system of the orbit
-      // trajectory
-      double XL[2] = {hitx[0], hitx[2]};
-      double YL[2] = {hity[0], hity[2]};
-
-      double base = hitz[2] - hitz[0];
-
-      if (base == 0) {
-        warning() << "Detector separation = 0!"
-                  << "Cannot calculate slope!" << endmsg;
-        return StatusCode::SUCCESS;
-      }
-
-      double Xip[2] = {0.0, 0.0};
-      double Xrp[2] = {XL[1], (1000 * (XL[1] - XL[0]) / (base)) - local_x_slope_offset}; //- _SX0RP_;
-      double Yip[2] = {0.0, 0.0};
-      double Yrp[2] = {YL[1], (1000 * (YL[1] - YL[0]) / (base)) - local_y_slope_offset}; //- _SY0RP_;
-
-      // use the hit information and calculated slope at the RP + the transfer matrix inverse to calculate the
-      // Polar Angle and deltaP at the IP
-
-      for (unsigned i0 = 0; i0 < 2; i0++) {
-        for (unsigned i1 = 0; i1 < 2; i1++) {
-          Xip[i0] += aXRPinv[i0][i1] * Xrp[i1];
-          Yip[i0] += aYRPinv[i0][i1] * Yrp[i1];
-        }
-      }
-
-      // convert polar angles to radians
-      double rsx = Xip[1] / 1000.;
-      double rsy = Yip[1] / 1000.;
-
-      // calculate momentum magnitude from measured deltaP – using thin lens optics.
-      double p    = nomMomentum * (1 + 0.01 * Xip[0]);
-      double norm = std::sqrt(1.0 + rsx * rsx + rsy * rsy);
-
-      const float prec[3] = {static_cast<float>(p * rsx / norm), static_cast<float>(p * rsy / norm),
-                             static_cast<float>(p / norm)};
-
-      //----- end RP reconstruction code ------
+    // all the tracks at once through the inverse transfer matrices
+    const auto& momenta = m_tracks.reconstruct();
+    for (Eigen::Index k = 0; k < momenta.cols(); ++k) {
+      const float prec[3] = {static_cast<float>(momenta(0, k)), static_cast<float>(momenta(1, k)),
+                             static_cast<float>(momenta(2, k))};
 
       eicd::MutableReconstructedParticle rpTrack;
       rpTrack.setType(0);
@@ -266,8 +208,10 @@ public:
       rpTrack.setPDG(2122);
       //rpTrack.covMatrix(); // @TODO: Errors
       rc->push_back(rpTrack);
-
-    } // end enough hits for matrix reco
+    }
+    if (msgLevel(MSG::DEBUG)) {
+      debug() << fmt::format("{} hits, {} tracks", m_tracks.size(), momenta.cols()) << endmsg;
+    }
 
     return StatusCode::SUCCESS;
   }
@@ -3,6 +3,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <vector>
 #include <fmt/format.h>
 
 #include "Gaudi/Algorithm.h"
@@ -12,6 +13,7 @@
 #include "GaudiKernel/RndmGenerators.h"
 
 #include "JugBase/DataHandle.h"
+#include "JugReco/FarForwardTracks.h"
 
 // Event Model related classes
 #include "eicd/ReconstructedParticleCollection.h"
@@ -35,11 +37,18 @@ private:
   Gaudi::Property<double> crossingAngle{this, "crossingAngle", -0.025};
   Gaudi::Property<double> nomMomentum{this, "beamMomentum", 137.5}; // This number is set to 50% maximum beam momentum
 
-  const double aXOMD[2][2] = {{1.6229248, 12.9519653}, {-2.86056525, 0.1830292}};
-  const double aYOMD[2][2] = {{0.0000185, -28.599739}, {0.00000925, -2.8795791}};
+  // transfer matrices (row-major) from (deltaP / p [%], angle [mrad]) at the IP to (position [mm], slope [mrad])
+  Gaudi::Property<std::vector<double>> u_transferX{this, "transferMatrixX",
+                                                    {1.6229248, 12.9519653, -2.86056525, 0.1830292}};
+  Gaudi::Property<std::vector<double>> u_transferY{this, "transferMatrixY",
+                                                    {0.0000185, -28.599739, 0.00000925, -2.8795791}};
+  // hit pairing between the first and the last station (in mm), no window cut if not positive
+  Gaudi::Property<double> m_planeTolerance{this, "planeTolerance", 1.};
+  Gaudi::Property<double> m_stationSeparation{this, "stationSeparation", 100.};
+  Gaudi::Property<double> m_xWindow{this, "xWindow", -1.};
+  Gaudi::Property<double> m_yWindow{this, "yWindow", -1.};
 
-  double aXOMDinv[2][2] = {{0.0, 0.0}, {0.0, 0.0}};
-  double aYOMDinv[2][2] = {{0.0, 0.0}, {0.0, 0.0}};
+  FarForwardTracks m_tracks;
 
 public:
   FarForwardParticlesOMD(const std::string& name, ISvcLocator* svcLoc)
@@ -52,25 +61,23 @@ public:
     if (GaudiAlgorithm::initialize().isFailure()) {
       return StatusCode::FAILURE;
     }
-    double det = aXOMD[0][0] * aXOMD[1][1] - aXOMD[0][1] * aXOMD[1][0];
-
-    if (det == 0) {
+    if (u_transferX.size() != 4 || u_transferY.size() != 4) {
+      error() << "Expected 4 values (2 x 2, row-major) for transferMatrixX and transferMatrixY" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    FarForwardOptics optics;
+    optics.transferX << u_transferX.value()[0], u_transferX.value()[1], u_transferX.value()[2], u_transferX.value()[3];
+    optics.transferY << u_transferY.value()[0], u_transferY.value()[1], u_transferY.value()[2], u_transferY.value()[3];
+    optics.xSlopeOffset = local_x_slope_offset;
+    optics.ySlopeOffset = local_y_slope_offset;
+    optics.beamMomentum = nomMomentum;
+    const FarForwardTracks::Settings settings{m_planeTolerance, m_stationSeparation, m_xWindow, m_yWindow};
+    if (!m_tracks.configure(optics, settings)) {
       error() << "Reco matrix determinant = 0!"
               << "Matrix cannot be inverted! Double-check matrix!" << endmsg;
       return StatusCode::FAILURE;
     }
 
-    aXOMDinv[0][0] = aXOMD[1][1] / det;
-    aXOMDinv[0][1] = -aXOMD[0][1] / det;
-    aXOMDinv[1][0] = -aXOMD[1][0] / det;
-    aXOMDinv[1][1] = aXOMD[0][0] / det;
-
-    det            = aYOMD[0][0] * aYOMD[1][1] - aYOMD[0][1] * aYOMD[1][0];
-    aYOMDinv[0][0] = aYOMD[1][1] / det;
-    aYOMDinv[0][1] = -aYOMD[0][1] / det;
-    aYOMDinv[1][0] = -aYOMD[1][0] / det;
-    aYOMDinv[1][1] = aYOMD[0][0] / det;
-
     return StatusCode::SUCCESS;
   }
 
@@ -78,91 +85,24 @@ public:
     const eicd::TrackerHitCollection* rawhits = m_inputHitCollection.get();
     auto& rc                                 = *(m_outputParticles.createAndPut());
 
-    // for (const auto& part : mc) {
-    //    if (part.genStatus() > 1) {
-    //        if (msgLevel(MSG::DEBUG)) {
-    //            debug() << "ignoring particle with genStatus = " << part.genStatus() << endmsg;
-    //        }
-    //        continue;
-    //    }
-
     //---- begin Roman Pot Reconstruction code ----
 
-    int eventReset = 0; // counter for IDing at least one hit per layer
-    std::vector<double> hitx;
-    std::vector<double> hity;
-    std::vector<double> hitz;
-
+    // hits in the coordinate system of the orbit trajectory,
+    // with the offset of station 2 for both stations since it is used for the reference orbit
+    m_tracks.clear();
     for (const auto& h : *rawhits) {
-
-      // The actual hit position:
-      auto pos0 = h.getPosition();
-      // auto mom0 = h.momentum;
-      // auto pidCode = h.g4ID;
-      auto eDep = h.getEdep();
-
-      if (eDep < 0.00001) {
+      if (h.getEdep() < 0.00001) {
         continue;
       }
-
-      if (eventReset < 2) {
-        hitx.push_back(pos0.x - local_x_offset_station_2);
-      } // use station 2 for both offsets since it is used for the reference orbit
-      else {
-        hitx.push_back(pos0.x - local_x_offset_station_2);
-      }
-
-      hity.push_back(pos0.y);
-      hitz.push_back(pos0.z);
-
-      eventReset++;
+      const auto& pos0 = h.getPosition();
+      m_tracks.add(pos0.x - local_x_offset_station_2, pos0.y, pos0.z);
     }
 
-    // NB:
-    // This is a "dumb" algorithm - I am just checking the basic thing works with a simple single-proton test.
-    // Will need to update and modify for generic # of hits for more complicated final-states.
-
-    if (eventReset == 4) {
-
-      // extract hit, subtract orbit offset – this is to get the hits in the coordinate system of the orbit trajectory
-      double XL[2] = {hitx[0], hitx[2]};
-      double YL[2] = {hity[0], hity[2]};
-
-      double base = hitz[2] - hitz[0];
-
-      if (base == 0) {
-        warning() << "Detector separation = 0!"
-                << "Cannot calculate slope!" << endmsg;
-        return StatusCode::SUCCESS;
-      }
-
-      double Xomd[2] = {XL[1], (1000 * (XL[1] - XL[0]) / (base)) - local_x_slope_offset};
-      double Xip[2]  = {0.0, 0.0};
-      double Yomd[2] = {YL[1], (1000 * (YL[1] - YL[0]) / (base)) - local_y_slope_offset};
-      double Yip[2]  = {0.0, 0.0};
-
-      // use the hit information and calculated slope at the RP + the transfer matrix inverse to calculate the Polar
-      // Angle and deltaP at the IP
-
-      for (unsigned i0 = 0; i0 < 2; i0++) {
-        for (unsigned i1 = 0; i1 < 2; i1++) {
-          Xip[i0] += aXOMDinv[i0][i1] * Xomd[i1];
-          Yip[i0] += aYOMDinv[i0][i1] * Yomd[i1];
-        }
-      }
-
-      // convert polar angles to radians
-      double rsx = Xip[1] / 1000.;
-      double rsy = Yip[1] / 1000.;
-
-      // calculate momentum magnitude from measured deltaP – using thin lens optics.
-      double p    = nomMomentum * (1 + 0.01 * Xip[0]);
-      double norm = std::sqrt(1.0 + rsx * rsx + rsy * rsy);
-
-      const float prec[3] = {static_cast<float>(p * rsx / norm), static_cast<float>(p * rsy / norm),
-                             static_cast<float>(p / norm)};
-
-      //----- end RP reconstruction code ------
+    // all the tracks at once through the inverse transfer matrices
+    const auto& momenta = m_tracks.reconstruct();
+    for (Eigen::Index k = 0; k < momenta.cols(); ++k) {
+      const float prec[3] = {static_cast<float>(momenta(0, k)), static_cast<float>(momenta(1, k)),
+                             static_cast<float>(momenta(2, k))};
 
       eicd::MutableReconstructedParticle rpTrack;
       rpTrack.setType(0);
@@ -175,8 +115,10 @@ public:
       rpTrack.setPDG(2122);
       //rpTrack.covMatrix(); // @TODO: Errors
       rc->push_back(rpTrack);
-
-    } // end enough hits for matrix reco
+    }
+    if (msgLevel(MSG::DEBUG)) {
+      debug() << fmt::format("{} hits, {} tracks", m_tracks.size(), momenta.cols()) << endmsg;
+    }
 
     return StatusCode::SUCCESS;
   }
@@ -0,0 +1,241 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+/*
+ *  Dense tensor of hit features as the input of ML algorithms, with an optional inference
+ *  of an ONNX model on batches of events
+ */
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "fmt/format.h"
+
+#include "Gaudi/Property.h"
+#include "GaudiAlg/GaudiAlgorithm.h"
+#include "GaudiKernel/ThreadLocalContext.h"
+
+#include "JugBase/DataHandle.h"
+#include "JugBase/Tensor.h"
+#include "JugReco/CalorimeterHitCache.h"
+#include "JugReco/HitFeatures.h"
+
+// Event Model related classes
+#include "eicd/CalorimeterHitCollection.h"
+
+#if defined(JUGGLER_HAVE_ONNX)
+#include <onnxruntime_cxx_api.h>
+#endif
+
+namespace Jug::Reco {
+
+/** Hit tensor builder for ML algorithm input.
+ *
+ * The features of the hits (see Jug::Reco::HitFeature) are written to outputTensor, a dense
+ * (numberOfLayers x numberOfHits x features) Jug::Tensor: the hits of each layer fill its slots in
+ * input order (the output of ImagingPixelDataSorter or ImagingPixelDataCombiner is already sorted),
+ * the hits of other layers or beyond numberOfHits are discarded and the empty slots are zeros.
+ *
+ * With modelPath (builds with JUGGLER_ENABLE_ONNX), the tensors of batchSize events are given to
+ * the ONNX model in one call, with a leading event dimension. The model output is published in the
+ * event that completes the batch, as outputInference (events x model output) and the event
+ * numbers of its rows in outputInferenceEvents, both are empty in the other events. The events of
+ * an incomplete batch at the end of the run are not inferred.
+ *
+ * \ingroup reco
+ */
+class HitTensorBuilder : public GaudiAlgorithm {
+private:
+  Gaudi::Property<std::vector<std::string>> u_features{
+      this, "features", {"energy", "eta", "phi", "layer", "time"}};
+  Gaudi::Property<int> m_nLayers{this, "numberOfLayers", 9};
+  Gaudi::Property<int> m_nHits{this, "numberOfHits", 50};
+
+  // inference, none without a model
+  Gaudi::Property<std::string> m_modelPath{this, "modelPath", ""};
+  Gaudi::Property<std::string> m_modelInput{this, "modelInput", "input"};
+  Gaudi::Property<std::string> m_modelOutput{this, "modelOutput", "output"};
+  Gaudi::Property<int> m_batchSize{this, "batchSize", 1};
+  Gaudi::Property<int> m_numThreads{this, "numThreads", 1, "Intra-op threads of the inference, 0 for all"};
+
+  DataHandle<eicd::CalorimeterHitCollection> m_inputHits{"inputHits", Gaudi::DataHandle::Reader, this};
+  DataHandle<Jug::Tensor> m_outputTensor{"outputTensor", Gaudi::DataHandle::Writer, this};
+  DataHandle<Jug::Tensor> m_outputInference{"outputInference", Gaudi::DataHandle::Writer, this};
+  DataHandle<Jug::VecULong> m_outputInferenceEvents{"outputInferenceEvents", Gaudi::DataHandle::Writer, this};
+
+  std::vector<HitFeature> m_features;
+  CalorimeterHitCache m_cache;
+  std::vector<size_t> m_layerCount;
+
+  // tensors of the events of the current batch
+  bool m_infer{false};
+  Jug::Tensor m_batch;
+  Jug::VecULong m_batchEvents;
+
+#if defined(JUGGLER_HAVE_ONNX)
+  std::unique_ptr<Ort::Env> m_env;
+  std::unique_ptr<Ort::Session> m_session;
+#endif
+
+public:
+  HitTensorBuilder(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
+    declareProperty("inputHits", m_inputHits, "");
+    declareProperty("outputTensor", m_outputTensor, "");
+    declareProperty("outputInference", m_outputInference, "");
+    declareProperty("outputInferenceEvents", m_outputInferenceEvents, "");
+  }
+
+  StatusCode initialize() override {
+    if (GaudiAlgorithm::initialize().isFailure()) {
+      return StatusCode::FAILURE;
+    }
+    if (m_nLayers.value() <= 0 || m_nHits.value() <= 0) {
+      error() << "numberOfLayers and numberOfHits have to be positive" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    m_features.clear();
+    for (const auto& name : u_features.value()) {
+      const auto feature = hit_feature(name);
+      if (!feature) {
+        error() << fmt::format("Unknown feature {}, please choose from [{}]", name, fmt::join(kHitFeatureNames, ", "))
+                << endmsg;
+        return StatusCode::FAILURE;
+      }
+      m_features.push_back(*feature);
+    }
+    if (m_features.empty()) {
+      error() << "No features for the tensor" << endmsg;
+      return StatusCode::FAILURE;
+    }
+
+    m_infer = !m_modelPath.value().empty();
+    if (!m_infer) {
+      return StatusCode::SUCCESS;
+    }
+    if (m_batchSize.value() <= 0) {
+      error() << "batchSize has to be positive" << endmsg;
+      return StatusCode::FAILURE;
+    }
+#if defined(JUGGLER_HAVE_ONNX)
+    try {
+      m_env = std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, name().c_str());
+      Ort::SessionOptions options;
+      options.SetIntraOpNumThreads(m_numThreads.value());
+      options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+      m_session = std::make_unique<Ort::Session>(*m_env, m_modelPath.value().c_str(), options);
+    } catch (const Ort::Exception& e) {
+      error() << "Failed to load the ONNX model " << m_modelPath.value() << ": " << e.what() << endmsg;
+      return StatusCode::FAILURE;
+    }
+    m_batch.reset({static_cast<size_t>(m_batchSize.value()), tensorShape()[0], tensorShape()[1], tensorShape()[2]});
+    m_batchEvents.clear();
+    info() << fmt::format("Inference of {} in batches of {} events", m_modelPath.value(), m_batchSize.value())
+           << endmsg;
+    return StatusCode::SUCCESS;
+#else
+    error() << "Built without ONNX Runtime (JUGGLER_ENABLE_ONNX), modelPath cannot be used" << endmsg;
+    return StatusCode::FAILURE;
+#endif
+  }
+
+  StatusCode execute() override {
+    // input collections
+    const auto& hits = *m_inputHits.get();
+    // Create output collections
+    auto& tensor = *m_outputTensor.createAndPut();
+    tensor       = Jug::Tensor(tensorShape(), u_features.value());
+    fill(hits, tensor);
+
+    if (!m_infer) {
+      return StatusCode::SUCCESS;
+    }
+    auto& inference = *m_outputInference.createAndPut();
+    auto& events    = *m_outputInferenceEvents.createAndPut();
+    std::memcpy(m_batch.data() + m_batchEvents.size() * tensor.size(), tensor.data(), tensor.size() * sizeof(float));
+    m_batchEvents.push_back(Gaudi::Hive::currentContext().evt());
+    if (m_batchEvents.size() < static_cast<size_t>(m_batchSize.value())) {
+      return StatusCode::SUCCESS;
+    }
+    if (!infer(inference)) {
+      return StatusCode::FAILURE;
+    }
+    events.swap(m_batchEvents);
+    m_batchEvents.clear();
+    return StatusCode::SUCCESS;
+  }
+
+  StatusCode finalize() override {
+    if (!m_batchEvents.empty()) {
+      warning() << m_batchEvents.size() << " events of an incomplete batch were not inferred" << endmsg;
+    }
+#if defined(JUGGLER_HAVE_ONNX)
+    m_session.reset();
+    m_env.reset();
+#endif
+    return GaudiAlgorithm::finalize();
+  }
+
+private:
+  std::vector<size_t> tensorShape() const {
+    return {static_cast<size_t>(m_nLayers.value()), static_cast<size_t>(m_nHits.value()), m_features.size()};
+  }
+
+  // features of the hits in the (layer, hit, feature) slots
+  void fill(const eicd::CalorimeterHitCollection& hits, Jug::Tensor& tensor) {
+    const size_t nLayers   = m_nLayers.value();
+    const size_t nHits     = m_nHits.value();
+    const size_t nFeatures = m_features.size();
+    m_cache.fill(hits);
+    m_layerCount.assign(nLayers, 0);
+    for (size_t i = 0; i < m_cache.size(); ++i) {
+      const auto k = m_cache.layer[i];
+      if (k < 0 || static_cast<size_t>(k) >= nLayers || m_layerCount[k] >= nHits) {
+        continue;
+      }
+      float* values = tensor.data() + (k * nHits + m_layerCount[k]++) * nFeatures;
+      for (size_t f = 0; f < nFeatures; ++f) {
+        values[f] = hit_feature_value(m_cache, m_features[f], i);
+      }
+    }
+  }
+
+  // model output of the events of the batch
+  bool infer([[maybe_unused]] Jug::Tensor& output) {
+#if defined(JUGGLER_HAVE_ONNX)
+    const auto& shape = m_batch.shape();
+    const std::vector<int64_t> inputShape{static_cast<int64_t>(m_batchEvents.size()), static_cast<int64_t>(shape[1]),
+                                          static_cast<int64_t>(shape[2]), static_cast<int64_t>(shape[3])};
+    const size_t inputSize = m_batchEvents.size() * shape[1] * shape[2] * shape[3];
+    try {
+      const auto memoryInfo = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+      auto input = Ort::Value::CreateTensor<float>(memoryInfo, m_batch.data(), inputSize, inputShape.data(),
+                                                   inputShape.size());
+      const char* inputNames[]  = {m_modelInput.value().c_str()};
+      const char* outputNames[] = {m_modelOutput.value().c_str()};
+      auto outputs = m_session->Run(Ort::RunOptions{nullptr}, inputNames, &input, 1, outputNames, 1);
+
+      const auto info = outputs[0].GetTensorTypeAndShapeInfo();
+      std::vector<size_t> outputShape;
+      for (const auto dim : info.GetShape()) {
+        outputShape.push_back(static_cast<size_t>(std::max<int64_t>(dim, 0)));
+      }
+      output.reset(outputShape);
+      const float* values = outputs[0].GetTensorData<float>();
+      std::copy(values, values + std::min(output.size(), info.GetElementCount()), output.data());
+    } catch (const Ort::Exception& e) {
+      error() << "Inference of " << m_modelPath.value() << " failed: " << e.what() << endmsg;
+      return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+  }
+
+}; // class HitTensorBuilder
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(HitTensorBuilder)
+
+} // namespace Jug::Reco
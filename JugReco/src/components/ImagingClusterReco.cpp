@@ -8,7 +8,6 @@
  *  Author: Chao Peng (ANL), 06/02/2021
  */
 #include "fmt/format.h"
-#include <Eigen/Dense>
 #include <algorithm>
 
 #include "Gaudi/Property.h"
@@ -25,8 +24,12 @@
 
 #include "JugBase/DataHandle.h"
 #include "JugBase/IGeoSvc.h"
+#include "JugBase/Utilities/FlatIndexMap.h"
 #include "JugBase/Utilities/Utils.hpp"
+#include "JugReco/CalorimeterHitCache.h"
 #include "JugReco/ClusterTypes.h"
+#include "JugReco/ProtoClusterIndex.h"
+#include "JugReco/ShowerAxis.h"
 
 // Event Model related classes
 #include "edm4hep/MCParticleCollection.h"
@@ -38,7 +41,6 @@
 #include "eicd/vector_utils.h"
 
 using namespace Gaudi::Units;
-using namespace Eigen;
 
 namespace Jug::Reco {
 
@@ -46,6 +48,12 @@ namespace Jug::Reco {
  *
  *  Reconstruct the cluster/layer info for imaging calorimeter
  *  Logarithmic weighting is used to describe energy deposit in transverse direction
+ *  The hits of a proto-cluster are summed in one pass, per layer in a flat array indexed by layer,
+ *  and the layers, the cluster and the fitted axis are made from the sums. The axis is the
+ *  principal axis of the energy-weighted layer centroids up to trackStopLayer, its transverse
+ *  width is the second shape parameter of the cluster (0 if it cannot be fitted).
+ *  With inputProtoClusterIndex and inputHitCollection, the proto-clusters are read as indices of
+ *  the hits (ProtoClusterIndex of ImagingTopoCluster) instead of the podio proto-clusters.
  *
  *  \ingroup reco
  */
@@ -57,6 +65,12 @@ private:
   DataHandle<eicd::ClusterCollection> m_outputLayers{"outputLayers", Gaudi::DataHandle::Writer, this};
   DataHandle<eicd::ClusterCollection> m_outputClusters{"outputClusters", Gaudi::DataHandle::Reader, this};
 
+  // Proto-clusters as hit indices and their hits, instead of the input proto-clusters
+  Gaudi::Property<std::string> m_inputProtoIndex{this, "inputProtoClusterIndex", ""};
+  Gaudi::Property<std::string> m_inputHits{this, "inputHitCollection", ""};
+  std::unique_ptr<DataHandle<ProtoClusterIndex>> m_inputProtoIndex_ptr;
+  std::unique_ptr<DataHandle<eicd::CalorimeterHitCollection>> m_inputHits_ptr;
+
   // Collection for MC hits when running on MC
   Gaudi::Property<std::string> m_mcHits{this, "mcHits", ""};
   // Optional handle to MC hits
@@ -67,6 +81,27 @@ private:
   // Optional handle to MC hits
   std::unique_ptr<DataHandle<eicd::MCRecoClusterParticleAssociationCollection>> m_outputAssociations_ptr;
 
+  // running sums of the hits of a layer
+  struct LayerSums {
+    unsigned nHits{0};
+    double sumOfWeights{0};
+    double energy{0};
+    double energyError{0};
+    double time{0};
+    double timeError{0};
+    // weighted position
+    double wx{0}, wy{0}, wz{0};
+    // unweighted position and squared distance to the origin, for the radius
+    double x{0}, y{0}, z{0}, r2{0};
+  };
+
+  // contiguous copy of the proto-cluster hits, kept to reuse its buffers
+  CalorimeterHitCache m_hits;
+  // per-layer sums and hit indices of the proto-cluster, from its first layer
+  std::vector<LayerSums> m_layerSums;
+  std::vector<unsigned> m_layerOffsets;
+  std::vector<unsigned> m_layerHits;
+
 public:
   ImagingClusterReco(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
     declareProperty("inputProtoClusters", m_inputProtoClusters, "");
@@ -79,6 +114,18 @@ public:
       return StatusCode::FAILURE;
     }
 
+    // Initialize the optional proto-cluster index if requested, with the hits it refers to
+    if (m_inputProtoIndex.value().empty() != m_inputHits.value().empty()) {
+      error() << "inputProtoClusterIndex and inputHitCollection are used together" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    if (!m_inputProtoIndex.value().empty()) {
+      m_inputProtoIndex_ptr =
+          std::make_unique<DataHandle<ProtoClusterIndex>>(m_inputProtoIndex, Gaudi::DataHandle::Reader, this);
+      m_inputHits_ptr = std::make_unique<DataHandle<eicd::CalorimeterHitCollection>>(m_inputHits,
+                                                                                     Gaudi::DataHandle::Reader, this);
+    }
+
     // Initialize the optional MC input hit collection if requested
     if (m_mcHits != "") {
       m_mcHits_ptr =
@@ -115,59 +162,85 @@ public:
       associations = m_outputAssociations_ptr->createAndPut();
     }
 
-    for (const auto& pcl : proto) {
-      if (!pcl.getHits().empty() && !pcl.getHits(0).isAvailable()) {
-        warning() << "Protocluster hit relation is invalid, skipping protocluster" << endmsg;
-        continue;
+    // index of the first mc hit of each cellID, for the truth association
+    Jug::Base::FlatIndexMap mchit_index;
+    if (mcHits != nullptr && associations != nullptr) {
+      mchit_index.reserve(mcHits->size());
+      for (size_t i = 0; i < mcHits->size(); ++i) {
+        mchit_index.emplace((*mcHits)[i].getCellID(), static_cast<uint32_t>(i));
       }
+    }
+
+    // Optional input proto-clusters as hit indices
+    const ProtoClusterIndex* index                  = nullptr;
+    const eicd::CalorimeterHitCollection* inputHits = nullptr;
+    if (m_inputProtoIndex_ptr) {
+      index     = m_inputProtoIndex_ptr->get();
+      inputHits = m_inputHits_ptr->get();
+    }
+
+    const size_t nproto = (index != nullptr) ? index->size() : proto.size();
+    for (size_t k = 0; k < nproto; ++k) {
+      if (index != nullptr) {
+        m_hits.fill(*inputHits, *index, k);
+      } else {
+        const auto pcl = proto[k];
+        if (!pcl.getHits().empty() && !pcl.getHits(0).isAvailable()) {
+          warning() << "Protocluster hit relation is invalid, skipping protocluster" << endmsg;
+          continue;
+        }
+        m_hits.fill(pcl);
+      }
+      // hit i of the proto-cluster
+      const auto hitAt = [&proto, index, inputHits, k](unsigned i) {
+        return (index != nullptr) ? (*inputHits)[index->hit[index->begin[k] + i]] : proto[k].getHits(i);
+      };
       // get cluster and associated layers
-      auto cl        = reconstruct_cluster(pcl);
-      auto cl_layers = reconstruct_cluster_layers(pcl);
-
-      // Get cluster direction from the layer profile
-      auto [theta, phi] = fit_track(cl_layers);
-      cl.setIntrinsicTheta(theta);
-      cl.setIntrinsicPhi(phi);
-      // no error on the intrinsic direction TODO
-
-      // store layer and clusters on the datastore
-      for (auto& layer : cl_layers) {
-        layers.push_back(layer);
-        cl.addToClusters(layer);
+      auto cl = reconstruct_cluster(hitAt, m_hits);
+      if (!m_hits.empty()) {
+        const int firstLayer = accumulate_layers(m_hits);
+
+        // Get cluster direction from the layer profile
+        const auto axis = fit_track(firstLayer);
+        cl.setIntrinsicTheta(axis.theta);
+        cl.setIntrinsicPhi(axis.phi);
+        // no error on the intrinsic direction TODO
+        // transverse width of the layer profile around the axis, after the eta-phi radius
+        cl.addToShapeParameters(axis.width);
+
+        // store layer and clusters on the datastore
+        for (unsigned l = 0; l < m_layerSums.size(); ++l) {
+          if (m_layerSums[l].nHits == 0) {
+            continue;
+          }
+          auto layer = reconstruct_layer(hitAt, m_layerSums[l], l);
+          layers.push_back(layer);
+          cl.addToClusters(layer);
+        }
       }
       clusters.push_back(cl);
 
 
       // If mcHits are available, associate cluster with MCParticle
-      if (m_mcHits_ptr.get() != nullptr && m_outputAssociations_ptr.get() != nullptr) {
+      if (m_mcHits_ptr.get() != nullptr && m_outputAssociations_ptr.get() != nullptr && !m_hits.empty()) {
 
         // 1. find pclhit with largest energy deposition
-        auto pclhits = pcl.getHits();
-        auto pclhit = std::max_element(
-          pclhits.begin(),
-          pclhits.end(),
-          [](const auto& pclhit1, const auto& pclhit2) {
-            return pclhit1.getEnergy() < pclhit2.getEnergy();
-          }
-        );
-
-        // 2. find mchit with same CellID
-        auto mchit = mcHits->begin();
-        for ( ; mchit != mcHits->end(); ++mchit) {
-          // break loop when CellID match found
-          if (mchit->getCellID() == pclhit->getCellID()) {
-            break;
-          }
-        }
-        if (!(mchit != mcHits->end())) {
+        const auto maxHit = std::max_element(m_hits.energy.begin(), m_hits.energy.end()) - m_hits.energy.begin();
+        const auto pclhit = hitAt(maxHit);
+
+        // 2. find the first mchit with same CellID, from the index of the event
+        const auto mchit_i = mchit_index.find(pclhit.getCellID());
+        if (mchit_i == Jug::Base::FlatIndexMap::kEmpty) {
           // break if no matching hit found for this CellID
-          warning() << "Proto-cluster has highest energy in CellID " << pclhit->getCellID()
+          warning() << "Proto-cluster has highest energy in CellID " << pclhit.getCellID()
                     << ", but no mc hit with that CellID was found." << endmsg;
           break;
         }
 
+        const auto mchit = (*mcHits)[mchit_i];
+
         // 3. find mchit's MCParticle
-        const auto& mcp = mchit->getContributions(0).getParticle();
+        const auto& mcp = mchit.getContributions(0).getParticle();
 
         // set association
         eicd::MutableMCRecoClusterParticleAssociation clusterassoc;
@@ -197,74 +270,82 @@ public:
 private:
   template <typename T> static inline T pow2(const T& x) { return x * x; }
 
-  static std::vector<eicd::Cluster> reconstruct_cluster_layers(const eicd::ProtoCluster& pcl) {
-    const auto& hits    = pcl.getHits();
-    const auto& weights = pcl.getWeights();
-    // using map to have hits sorted by layer
-    std::map<int, std::vector<std::pair<eicd::CalorimeterHit, float>>> layer_map;
+  // sums and hit indices of the layers in one pass, returns the first layer
+  int accumulate_layers(const CalorimeterHitCache& hits) {
+    const auto [minLayer, maxLayer] = std::minmax_element(hits.layer.begin(), hits.layer.end());
+    const int firstLayer            = *minLayer;
+    m_layerSums.assign(*maxLayer - firstLayer + 1, LayerSums{});
     for (unsigned i = 0; i < hits.size(); ++i) {
-      const auto hit = hits[i];
-      auto lid       = hit.getLayer();
-      if (layer_map.count(lid) == 0) {
-        layer_map[lid] = {};
-      }
-      layer_map[lid].push_back({hit, weights[i]});
+      auto& sums        = m_layerSums[hits.layer[i] - firstLayer];
+      const auto weight = hits.weight[i];
+      sums.nHits += 1;
+      sums.sumOfWeights += weight;
+      sums.energy += hits.energy[i] * weight;
+      sums.energyError += pow2(hits.energyError[i] * weight);
+      sums.time += hits.time[i] * weight;
+      sums.timeError += pow2(hits.timeError[i] * weight);
+      sums.wx += hits.x[i] * weight;
+      sums.wy += hits.y[i] * weight;
+      sums.wz += hits.z[i] * weight;
+      sums.x += hits.x[i];
+      sums.y += hits.y[i];
+      sums.z += hits.z[i];
+      sums.r2 += pow2(hits.x[i]) + pow2(hits.y[i]) + pow2(hits.z[i]);
     }
 
-    // create layers
-    std::vector<eicd::Cluster> cl_layers;
-    for (const auto& [lid, layer_hits] : layer_map) {
-      auto layer = reconstruct_layer(layer_hits);
-      cl_layers.push_back(layer);
+    // hit indices grouped by layer, in the order of the proto-cluster
+    m_layerOffsets.assign(m_layerSums.size() + 1, 0);
+    for (unsigned k = 0; k < m_layerSums.size(); ++k) {
+      m_layerOffsets[k + 1] = m_layerOffsets[k] + m_layerSums[k].nHits;
+    }
+    m_layerHits.resize(hits.size());
+    for (unsigned i = 0; i < hits.size(); ++i) {
+      m_layerHits[m_layerOffsets[hits.layer[i] - firstLayer]++] = i;
     }
-    return cl_layers;
+    // the offsets are now the layer ends, shift them back to the starts
+    for (unsigned k = m_layerSums.size(); k > 0; --k) {
+      m_layerOffsets[k] = m_layerOffsets[k - 1];
+    }
+    m_layerOffsets[0] = 0;
+    return firstLayer;
+  }
+
+  static eicd::Vector3f layer_position(const LayerSums& sums) {
+    return eicd::Vector3f(sums.wx / sums.sumOfWeights, sums.wy / sums.sumOfWeights, sums.wz / sums.sumOfWeights);
   }
 
-  static eicd::Cluster reconstruct_layer(const std::vector<std::pair<eicd::CalorimeterHit, float>>& hits) {
+  // hitAt(i) is hit i of the proto-cluster
+  template <typename HitAt>
+  eicd::Cluster reconstruct_layer(const HitAt& hitAt, const LayerSums& sums, unsigned k) const {
     eicd::MutableCluster layer;
     layer.setType(ClusterType::kClusterSlice);
-    // Calculate averages
-    double energy{0};
-    double energyError{0};
-    double time{0};
-    double timeError{0};
-    double sumOfWeights{0};
-    auto pos            = layer.getPosition();
-    for (const auto& [hit, weight] : hits) {
-      energy += hit.getEnergy() * weight;
-      energyError += std::pow(hit.getEnergyError() * weight, 2);
-      time += hit.getTime() * weight;
-      timeError += std::pow(hit.getTimeError() * weight, 2);
-      pos = pos + hit.getPosition() * weight;
-      sumOfWeights += weight;
-      layer.addToHits(hit);
+    for (unsigned j = m_layerOffsets[k]; j < m_layerOffsets[k + 1]; ++j) {
+      layer.addToHits(hitAt(m_layerHits[j]));
     }
-    layer.setEnergy(energy);
-    layer.setEnergyError(std::sqrt(energyError));
-    layer.setTime(time / sumOfWeights);
-    layer.setTimeError(std::sqrt(timeError) / sumOfWeights);
-    layer.setNhits(hits.size());
-    layer.setPosition(pos / sumOfWeights);
+    const auto pos = layer_position(sums);
+    layer.setEnergy(sums.energy);
+    layer.setEnergyError(std::sqrt(sums.energyError));
+    layer.setTime(sums.time / sums.sumOfWeights);
+    layer.setTimeError(std::sqrt(sums.timeError) / sums.sumOfWeights);
+    layer.setNhits(sums.nHits);
+    layer.setPosition(pos);
     // positionError not set
     // Intrinsic direction meaningless in a cluster layer --> not set
 
-    // Calculate radius as the standard deviation of the hits versus the cluster center
-    double radius = 0.;
-    for (const auto& [hit, weight] : hits) {
-      radius += std::pow(eicd::magnitude(hit.getPosition() - layer.getPosition()), 2);
-    }
-    layer.addToShapeParameters(std::sqrt(radius / layer.getNhits()));
+    // Calculate radius as the standard deviation of the hits versus the cluster center,
+    // sum |x - c|^2 = sum |x|^2 - 2 c . sum x + n |c|^2
+    const double radius = sums.r2 - 2. * (pos.x * sums.x + pos.y * sums.y + pos.z * sums.z) +
+                          sums.nHits * (pow2<double>(pos.x) + pow2<double>(pos.y) + pow2<double>(pos.z));
+    layer.addToShapeParameters(std::sqrt(std::max(radius, 0.) / sums.nHits));
     // TODO Skewedness
 
     return layer;
   }
 
-  eicd::MutableCluster reconstruct_cluster(const eicd::ProtoCluster& pcl) {
+  template <typename HitAt>
+  eicd::MutableCluster reconstruct_cluster(const HitAt& hitAt, const CalorimeterHitCache& hits) {
     eicd::MutableCluster cluster;
 
-    const auto& hits    = pcl.getHits();
-    const auto& weights = pcl.getWeights();
-
     cluster.setType(ClusterType::kCluster3D);
     double energy      = 0.;
     double energyError = 0.;
@@ -273,19 +354,27 @@ private:
     double meta        = 0.;
     double mphi        = 0.;
     double r           = 9999 * cm;
+    // unweighted eta-phi sums for the radius
+    double seta  = 0.;
+    double sphi  = 0.;
+    double seta2 = 0.;
+    double sphi2 = 0.;
     for (unsigned i = 0; i < hits.size(); ++i) {
-      const auto& hit    = hits[i];
-      const auto& weight = weights[i];
-      energy += hit.getEnergy() * weight;
-      energyError += std::pow(hit.getEnergyError() * weight, 2);
+      const auto weight = hits.weight[i];
+      energy += hits.energy[i] * weight;
+      energyError += std::pow(hits.energyError[i] * weight, 2);
       // energy weighting for the other variables
-      const double energyWeight = hit.getEnergy() * weight;
-      time += hit.getTime() * energyWeight;
-      timeError += std::pow(hit.getTimeError() * energyWeight, 2);
-      meta += eicd::eta(hit.getPosition()) * energyWeight;
-      mphi += eicd::angleAzimuthal(hit.getPosition()) * energyWeight;
-      r = std::min(eicd::magnitude(hit.getPosition()), r);
-      cluster.addToHits(hit);
+      const double energyWeight = hits.energy[i] * weight;
+      time += hits.time[i] * energyWeight;
+      timeError += std::pow(hits.timeError[i] * energyWeight, 2);
+      meta += hits.eta[i] * energyWeight;
+      mphi += hits.phi[i] * energyWeight;
+      r = std::min(static_cast<double>(hits.r[i]), r);
+      seta += hits.eta[i];
+      sphi += hits.phi[i];
+      seta2 += pow2<double>(hits.eta[i]);
+      sphi2 += pow2<double>(hits.phi[i]);
+      cluster.addToHits(hitAt(i));
     }
     cluster.setEnergy(energy);
     cluster.setEnergyError(std::sqrt(energyError));
@@ -294,13 +383,12 @@ private:
     cluster.setNhits(hits.size());
     cluster.setPosition(eicd::sphericalToVector(r, eicd::etaToAngle(meta / energy), mphi / energy));
 
-    // shower radius estimate (eta-phi plane)
-    double radius = 0.;
-    for (const auto& hit : hits) {
-      radius += pow2(eicd::eta(hit.getPosition()) - eicd::eta(cluster.getPosition())) +
-                pow2(eicd::angleAzimuthal(hit.getPosition()) - eicd::angleAzimuthal(cluster.getPosition()));
-    }
-    cluster.addToShapeParameters(std::sqrt(radius / cluster.getNhits()));
+    // shower radius estimate (eta-phi plane), from the sums around the cluster center
+    const double ceta   = eicd::eta(cluster.getPosition());
+    const double cphi   = eicd::angleAzimuthal(cluster.getPosition());
+    const double n      = hits.size();
+    const double radius = (seta2 - 2. * ceta * seta + n * ceta * ceta) + (sphi2 - 2. * cphi * sphi + n * cphi * cphi);
+    cluster.addToShapeParameters(std::sqrt(std::max(radius, 0.) / cluster.getNhits()));
     // Skewedness not calculated TODO
 
     // Optionally store the MC truth associated with the first hit in this cluster
@@ -313,12 +401,13 @@ private:
     return cluster;
   }
 
-  std::pair<double /* polar */, double /* azimuthal */> fit_track(const std::vector<eicd::Cluster>& layers) const {
+  // principal axis of the energy-weighted layer centroids up to trackStopLayer
+  ShowerAxis fit_track(int firstLayer) const {
     int nrows = 0;
-    eicd::Vector3f mean_pos{0, 0, 0};
-    for (const auto& layer : layers) {
-      if ((layer.getNhits() > 0) && (layer.getHits(0).getLayer() <= m_trackStopLayer)) {
-        mean_pos = mean_pos + layer.getPosition();
+    PositionMoments moments;
+    for (unsigned k = 0; k < m_layerSums.size(); ++k) {
+      if ((m_layerSums[k].nHits > 0) && (firstLayer + static_cast<int>(k) <= m_trackStopLayer)) {
+        moments.add(layer_position(m_layerSums[k]), std::max(m_layerSums[k].energy, 0.));
         nrows += 1;
       }
     }
@@ -326,25 +415,7 @@ private:
     if (nrows < 2) {
       return {};
     }
-
-    mean_pos = mean_pos / nrows;
-    // fill position data
-    MatrixXd pos(nrows, 3);
-    int ir = 0;
-    for (const auto& layer : layers) {
-      if ((layer.getNhits() > 0) && (layer.getHits(0).getLayer() <= m_trackStopLayer)) {
-        auto delta = layer.getPosition() - mean_pos;
-        pos(ir, 0) = delta.x;
-        pos(ir, 1) = delta.y;
-        pos(ir, 2) = delta.z;
-        ir += 1;
-      }
-    }
-
-    JacobiSVD<MatrixXd> svd(pos, ComputeThinU | ComputeThinV);
-    const auto dir = svd.matrixV().col(0);
-    // theta and phi
-    return {std::acos(dir(2)), std::atan2(dir(1), dir(0))};
+    return principal_axis(moments);
   }
 };
 
@@ -82,7 +82,7 @@ public:
     const auto* const hits2 = m_inputHits2.get();
     std::vector<const eicd::CalorimeterHitCollection*> inputs{hits1, hits2};
     // Create output collections
-    auto* mhits = m_outputHits.createAndPut();
+    auto* mhits = m_outputHits.createAndPut(hits1->size() + hits2->size());
 
     // concatenate
     if (m_rule.value() == supported_rules[0]) {
@@ -7,8 +7,7 @@
  *  Author: Chao Peng (ANL), 05/04/2021
  */
 #include <algorithm>
-#include <bitset>
-#include <unordered_map>
+#include <vector>
 
 #include "Gaudi/Property.h"
 #include "GaudiAlg/GaudiAlgorithm.h"
@@ -24,7 +23,9 @@
 
 #include "JugBase/DataHandle.h"
 #include "JugBase/IGeoSvc.h"
-#include "JugBase/Utilities/Utils.hpp"
+#include "JugBase/Tensor.h"
+#include "JugReco/CalorimeterHitCache.h"
+#include "JugReco/HitFeatures.h"
 
 // Event Model related classes
 #include <eicd/vector_utils.h>
@@ -41,6 +42,9 @@ namespace Jug::Reco {
    * It sorts the hits by layer and energy with defined sizes (max number of layers and max number of hits per layer)
    * Hits are sorted by energy in a descending order.
    * Out-of-range hits will be discarded and empty slots will be padded with zeros
+   * The top hits of each layer are selected over the hit indices with a partial sort.
+   * With tensorFeatures, the same hits are also written to outputTensor, a dense
+   * (numberOfLayers x numberOfHits x features) Jug::Tensor, padded with zeros (and the layer).
    *
    * \ingroup reco
    */
@@ -48,10 +52,20 @@ namespace Jug::Reco {
   private:
     Gaudi::Property<int>                        m_nLayers{this, "numberOfLayers", 9};
     Gaudi::Property<int>                        m_nHits{this, "numberOfHits", 50};
+    // features of the tensor output, see Jug::Reco::HitFeature, no tensor if empty
+    Gaudi::Property<std::vector<std::string>>   u_tensorFeatures{this, "tensorFeatures", {}};
     DataHandle<eicd::CalorimeterHitCollection>   m_inputHitCollection{"inputHitCollection",
                                                                      Gaudi::DataHandle::Reader, this};
     DataHandle<eicd::CalorimeterHitCollection>   m_outputHitCollection{"outputHitCollection",
                                                                       Gaudi::DataHandle::Writer, this};
+    DataHandle<Jug::Tensor>                     m_outputTensor{"outputTensor", Gaudi::DataHandle::Writer, this};
+
+    std::vector<HitFeature> m_features;
+    // hit indices grouped by layer, reused between events
+    std::vector<size_t> m_layerOffsets;
+    std::vector<size_t> m_layerOrder;
+    std::vector<float> m_energies;
+    CalorimeterHitCache m_cache;
 
   public:
     ImagingPixelDataSorter(const std::string& name, ISvcLocator* svcLoc)
@@ -59,6 +73,7 @@ namespace Jug::Reco {
     {
       declareProperty("inputHitCollection", m_inputHitCollection, "");
       declareProperty("outputHitCollection", m_outputHitCollection, "");
+      declareProperty("outputTensor", m_outputTensor, "");
     }
 
     StatusCode initialize() override
@@ -66,6 +81,19 @@ namespace Jug::Reco {
       if (GaudiAlgorithm::initialize().isFailure()) {
         return StatusCode::FAILURE;
       }
+      if (m_nLayers.value() < 0 || m_nHits.value() < 0) {
+        error() << "numberOfLayers and numberOfHits cannot be negative" << endmsg;
+        return StatusCode::FAILURE;
+      }
+      m_features.clear();
+      for (const auto& name : u_tensorFeatures.value()) {
+        const auto feature = hit_feature(name);
+        if (!feature) {
+          error() << "Unknown tensor feature " << name << endmsg;
+          return StatusCode::FAILURE;
+        }
+        m_features.push_back(*feature);
+      }
 
       return StatusCode::SUCCESS;
     }
@@ -75,45 +103,100 @@ namespace Jug::Reco {
       // input collections
       const auto& hits = *m_inputHitCollection.get();
       // Create output collections
-      auto& mhits = *m_outputHitCollection.createAndPut();
-
-      // group the hits by layer
-      std::vector<std::vector<eicd::CalorimeterHit>> layer_hits;
-      layer_hits.resize(m_nLayers);
-      for (const auto& h : hits) {
-        auto k = h.getLayer();
-        if ((int)k < m_nLayers) {
-          layer_hits[k].push_back(h);
+      auto& mhits = *m_outputHitCollection.createAndPut(hits.size());
+
+      const size_t nLayers = m_nLayers.value();
+      const size_t nHits   = m_nHits.value();
+
+      // group the hit indices by layer (counting sort)
+      m_energies.resize(hits.size());
+      m_layerOffsets.assign(nLayers + 1, 0);
+      for (size_t i = 0; i < hits.size(); ++i) {
+        const auto k  = hits[i].getLayer();
+        m_energies[i] = hits[i].getEnergy();
+        if (k >= 0 && (size_t)k < nLayers) {
+          ++m_layerOffsets[k + 1];
+        }
+      }
+      for (size_t k = 0; k < nLayers; ++k) {
+        m_layerOffsets[k + 1] += m_layerOffsets[k];
+      }
+      m_layerOrder.resize(m_layerOffsets[nLayers]);
+      {
+        std::vector<size_t> cursor(m_layerOffsets.begin(), m_layerOffsets.end() - 1);
+        for (size_t i = 0; i < hits.size(); ++i) {
+          const auto k = hits[i].getLayer();
+          if (k >= 0 && (size_t)k < nLayers) {
+            m_layerOrder[cursor[k]++] = i;
+          }
         }
       }
 
-      // sort by energy
-      for (auto &layer : layer_hits) {
-        std::sort(layer.begin(), layer.end(),
-          [] (const eicd::CalorimeterHit &h1, const eicd::CalorimeterHit &h2) {
-            return h1.getEnergy() > h2.getEnergy();
-          });
+      // select the top hits by energy
+      const auto by_energy = [this](size_t i, size_t j) { return m_energies[i] > m_energies[j]; };
+      for (size_t k = 0; k < nLayers; ++k) {
+        auto first = m_layerOrder.begin() + m_layerOffsets[k];
+        auto last  = m_layerOrder.begin() + m_layerOffsets[k + 1];
+        std::partial_sort(first, first + std::min<size_t>(nHits, last - first), last, by_energy);
       }
 
       // fill-in the output
-      for (size_t k = 0; k < layer_hits.size(); ++k) {
-        auto &layer = layer_hits[k];
-        for (size_t i = 0; i < (size_t) m_nHits; ++i) {
+      for (size_t k = 0; k < nLayers; ++k) {
+        const size_t nSelected = std::min(nHits, m_layerOffsets[k + 1] - m_layerOffsets[k]);
+        for (size_t i = 0; i < nHits; ++i) {
           // pad zeros if no hits
-          if (i >= layer.size()) {
+          if (i >= nSelected) {
             auto h = mhits.create();
             h.setLayer((int)k);
             h.setEnergy(0.);
           } else {
-            auto h = layer[i].clone();
-            mhits.push_back(h);
+            mhits.push_back(hits[m_layerOrder[m_layerOffsets[k] + i]].clone());
           }
         }
       }
 
+      if (!m_features.empty()) {
+        fill_tensor(hits, *m_outputTensor.createAndPut());
+      }
+
       return StatusCode::SUCCESS;
     }
 
+  private:
+    // (layer, hit, feature) values of the selected hits, the padding is zero except for the layer
+    void fill_tensor(const eicd::CalorimeterHitCollection& hits, Jug::Tensor& tensor) {
+      const size_t nLayers   = m_nLayers.value();
+      const size_t nHits     = m_nHits.value();
+      const size_t nFeatures = m_features.size();
+      tensor = Jug::Tensor({nLayers, nHits, nFeatures}, u_tensorFeatures.value());
+
+      m_cache.clear();
+      m_cache.reserve(nLayers * nHits);
+      for (size_t k = 0; k < nLayers; ++k) {
+        const size_t nSelected = std::min(nHits, m_layerOffsets[k + 1] - m_layerOffsets[k]);
+        for (size_t i = 0; i < nSelected; ++i) {
+          m_cache.append(hits[m_layerOrder[m_layerOffsets[k] + i]]);
+        }
+      }
+      m_cache.update_derived();
+
+      float* values = tensor.data();
+      size_t cached = 0;
+      for (size_t k = 0; k < nLayers; ++k) {
+        const size_t nSelected = std::min(nHits, m_layerOffsets[k + 1] - m_layerOffsets[k]);
+        for (size_t i = 0; i < nHits; ++i, values += nFeatures) {
+          for (size_t f = 0; f < nFeatures; ++f) {
+            if (i < nSelected) {
+              values[f] = hit_feature_value(m_cache, m_features[f], cached);
+            } else if (m_features[f] == HitFeature::kLayer) {
+              values[f] = static_cast<float>(k);
+            }
+          }
+          cached += (i < nSelected) ? 1 : 0;
+        }
+      }
+    }
+
   }; // class ImagingPixelDataSorter
 
   // NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
@@ -11,8 +11,10 @@
  *              not generically useful as a reconstruction algorithm.
  */
 #include <algorithm>
-#include <bitset>
-#include <unordered_map>
+#include <cmath>
+#include <vector>
+
+#include "fmt/format.h"
 
 #include "Gaudi/Property.h"
 #include "GaudiAlg/GaudiAlgorithm.h"
@@ -28,7 +30,7 @@
 
 #include "JugBase/DataHandle.h"
 #include "JugBase/IGeoSvc.h"
-#include "JugBase/Utilities/Utils.hpp"
+#include "JugReco/CalorimeterHitCache.h"
 
 // Event Model related classes
 #include "eicd/CalorimeterHitCollection.h"
@@ -36,19 +38,127 @@
 
 using namespace Gaudi::Units;
 
-struct PairHashFunction {
-  template <class T1, class T2> std::size_t operator()(const std::pair<T1, T2>& pair) const {
-    return std::hash<T1>()(pair.first) ^ std::hash<T2>()(pair.second);
-  }
-};
-
 namespace Jug::Reco {
 
+namespace {
+
+  // merged data of one pixel
+  struct GridData {
+    unsigned nHits;
+    float rc;
+    float energy;
+    float energyError;
+    float time;
+    float timeError;
+    int sector; // sector associated with one of the merged hits
+    int etaBin;
+    int phiBin;
+  };
+
+  /** Eta-phi pixel accumulator of all the layers.
+   *
+   *  The bounded (layer, eta, phi) grid is divided in tiles of kTileSize x kTileSize pixels, a dense
+   *  table gives the tile of every (layer, eta tile, phi tile) and the pixels of the tiles in use are
+   *  stored in a pool, so that only the tiles with hits take memory. The tiles and the pixels touched
+   *  in an event are listed and reset at the end of it, the pool is kept for the next events: after
+   *  the first events the merging does not allocate.
+   */
+  class PixelGrid {
+  public:
+    static constexpr int kTileBits = 6;
+    static constexpr int kTileSize = 1 << kTileBits;
+    static constexpr int kTileMask = kTileSize - 1;
+    static constexpr int32_t kNoTile = -1;
+
+    void configure(int nLayers, int etaMin, int nEta, int phiMin, int nPhi) {
+      m_nLayers   = nLayers;
+      m_etaMin    = etaMin;
+      m_nEta      = nEta;
+      m_phiMin    = phiMin;
+      m_nPhi      = nPhi;
+      m_nEtaTiles = (nEta + kTileMask) >> kTileBits;
+      m_nPhiTiles = (nPhi + kTileMask) >> kTileBits;
+      m_tiles.assign(static_cast<size_t>(nLayers) * m_nEtaTiles * m_nPhiTiles, kNoTile);
+      m_touched.assign(nLayers, {});
+    }
+
+    int layers() const { return m_nLayers; }
+    size_t tableSize() const { return m_tiles.size(); }
+
+    /// Pixel of (layer, eta bin, phi bin), nullptr if out of the grid, the new pixels have no hits
+    GridData* pixel(int layer, int etaBin, int phiBin) {
+      const int ie = etaBin - m_etaMin;
+      const int ip = phiBin - m_phiMin;
+      if (layer < 0 || layer >= m_nLayers || ie < 0 || ie >= m_nEta || ip < 0 || ip >= m_nPhi) {
+        return nullptr;
+      }
+      const size_t tile =
+          (static_cast<size_t>(layer) * m_nEtaTiles + (ie >> kTileBits)) * m_nPhiTiles + (ip >> kTileBits);
+      int32_t& slot = m_tiles[tile];
+      if (slot == kNoTile) {
+        slot = static_cast<int32_t>(m_usedTiles.size());
+        m_usedTiles.push_back(tile);
+        const size_t size = m_usedTiles.size() * kTileSize * kTileSize;
+        if (m_pixels.size() < size) {
+          m_pixels.resize(size, GridData{});
+        }
+      }
+      const size_t index = static_cast<size_t>(slot) * kTileSize * kTileSize + ((ie & kTileMask) << kTileBits) +
+                           (ip & kTileMask);
+      GridData& data = m_pixels[index];
+      if (data.nHits == 0) {
+        m_touched[layer].push_back(index);
+        data.etaBin = etaBin;
+        data.phiBin = phiBin;
+      }
+      return &data;
+    }
+
+    /// Calls visit(layer, data) for the pixels with hits, layer by layer in the order of their first hits
+    template <typename Visit> void forEach(Visit visit) const {
+      for (int layer = 0; layer < m_nLayers; ++layer) {
+        for (const auto index : m_touched[layer]) {
+          visit(layer, m_pixels[index]);
+        }
+      }
+    }
+
+    /// Empties the pixels and tiles used in the event
+    void clear() {
+      for (auto& touched : m_touched) {
+        for (const auto index : touched) {
+          m_pixels[index].nHits = 0;
+        }
+        touched.clear();
+      }
+      for (const auto tile : m_usedTiles) {
+        m_tiles[tile] = kNoTile;
+      }
+      m_usedTiles.clear();
+    }
+
+  private:
+    int m_nLayers{0};
+    int m_etaMin{0}, m_nEta{0}, m_phiMin{0}, m_nPhi{0};
+    int m_nEtaTiles{0}, m_nPhiTiles{0};
+    // (layer, eta tile, phi tile) -> slot of the tile in the pool
+    std::vector<int32_t> m_tiles;
+    std::vector<size_t> m_usedTiles;
+    // pixels of the tiles in use, slot by slot
+    std::vector<GridData> m_pixels;
+    // pixels with hits, per layer
+    std::vector<std::vector<size_t>> m_touched;
+  };
+
+} // namespace
+
 /** Hits merger for ML algorithm input.
  *
  * A hits merger to prepare dataset for machine learning
  * It merges hits with a defined grid size.
  * Merged hits will be relocated to the grid center and the energies will be summed.
+ * The number of layers is the range of the layer field of readoutClass (numberOfLayers without a
+ * readout), the hits out of the layers or of etaRange are not merged.
  *
  * \ingroup reco
  */
@@ -56,9 +166,17 @@ class ImagingPixelMerger : public GaudiAlgorithm {
 private:
   Gaudi::Property<float> m_etaSize{this, "etaSize", 0.001};
   Gaudi::Property<float> m_phiSize{this, "phiSize", 0.001};
+  Gaudi::Property<std::vector<double>> u_etaRange{this, "etaRange", {-5., 5.}};
+  Gaudi::Property<std::string> m_readout{this, "readoutClass", ""};
+  Gaudi::Property<std::string> m_layerField{this, "layerField", "layer"};
+  Gaudi::Property<int> m_nLayers{this, "numberOfLayers", 50};
+  Gaudi::Property<std::string> m_geoSvcName{this, "geoServiceName", "GeoSvc"};
   DataHandle<eicd::CalorimeterHitCollection> m_inputHits{"inputHits", Gaudi::DataHandle::Reader, this};
   DataHandle<eicd::CalorimeterHitCollection> m_outputHits{"outputHits", Gaudi::DataHandle::Writer, this};
 
+  PixelGrid m_grid;
+  CalorimeterHitCache m_cache;
+
 public:
   ImagingPixelMerger(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
     declareProperty("inputHits", m_inputHits, "");
@@ -69,6 +187,42 @@ public:
     if (GaudiAlgorithm::initialize().isFailure()) {
       return StatusCode::FAILURE;
     }
+    if (u_etaRange.size() != 2 || u_etaRange.value()[0] >= u_etaRange.value()[1]) {
+      error() << "Expected 2 increasing values (min, max) for etaRange" << endmsg;
+      return StatusCode::FAILURE;
+    }
+
+    // number of layers from the range of the layer field
+    int nLayers = m_nLayers.value();
+    if (!m_readout.value().empty()) {
+      auto geoSvc = service<IGeoSvc>(m_geoSvcName);
+      if (!geoSvc) {
+        error() << "Unable to locate Geometry Service. "
+                << "Make sure you have GeoSvc and SimSvc in the right order in the configuration." << endmsg;
+        return StatusCode::FAILURE;
+      }
+      try {
+        const auto* decoder = geoSvc->detector()->readout(m_readout).idSpec().decoder();
+        nLayers             = static_cast<int>((*decoder)[m_layerField.value()].maxValue()) + 1;
+      } catch (...) {
+        error() << "Failed to load the layer field " << m_layerField.value() << " of " << m_readout.value() << endmsg;
+        return StatusCode::FAILURE;
+      }
+    }
+    if (nLayers <= 0) {
+      error() << "Expected a positive number of layers, got " << nLayers << endmsg;
+      return StatusCode::FAILURE;
+    }
+
+    // bounded eta-phi grid, in the bins of pos2grid
+    const int etaMin = pos2grid(u_etaRange.value()[0], m_etaSize);
+    const int etaMax = pos2grid(u_etaRange.value()[1], m_etaSize);
+    const int phiMin = pos2grid(-M_PI, m_phiSize);
+    const int phiMax = pos2grid(M_PI, m_phiSize);
+    m_grid.configure(nLayers, etaMin, etaMax - etaMin + 1, phiMin, phiMax - phiMin + 1);
+    info() << fmt::format("Merging hits of {:d} layers in {:d} x {:d} (eta x phi) pixels, {:d} tiles", nLayers,
+                          etaMax - etaMin + 1, phiMax - phiMin + 1, m_grid.tableSize())
+           << endmsg;
 
     return StatusCode::SUCCESS;
   }
@@ -77,75 +231,63 @@ public:
     // input collections
     const auto& hits = *m_inputHits.get();
     // Create output collections
-    auto& ohits = *m_outputHits.createAndPut();
+    auto& ohits = *m_outputHits.createAndPut(hits.size());
 
     // @TODO: add timing information
+    // cylindrical r, eta and phi of the hits, computed once for the collection
+    m_cache.fill(hits);
     // group the hits by grid per layer
-    struct GridData {
-      unsigned nHits;
-      float rc;
-      float energy;
-      float energyError;
-      float time;
-      float timeError;
-      int sector; // sector associated with one of the merged hits
-    };
-    // @TODO: remove this hard-coded value
-    int max_nlayers = 50;
-    std::vector<std::unordered_map<std::pair<int, int>, GridData, PairHashFunction>> group_hits(max_nlayers);
-    for (const auto& h : hits) {
-      auto k = h.getLayer();
-      if ((int)k >= max_nlayers) {
+    size_t nOutside = 0;
+    for (size_t i = 0; i < m_cache.size(); ++i) {
+      auto* data =
+          m_grid.pixel(m_cache.layer[i], pos2grid(m_cache.eta[i], m_etaSize), pos2grid(m_cache.phi[i], m_phiSize));
+      if (data == nullptr) {
+        ++nOutside;
         continue;
       }
-      auto& layer     = group_hits[k];
-      const auto& pos = h.getPosition();
-
-      // cylindrical r
-      const float rc   = eicd::magnitudeTransverse(pos);
-      const double eta = eicd::eta(pos);
-      const double phi = eicd::angleAzimuthal(pos);
-
-      const auto grid = std::pair<int, int>{pos2grid(eta, m_etaSize), pos2grid(phi, m_phiSize)};
-      auto it         = layer.find(grid);
       // merge energy
-      if (it != layer.end()) {
-        auto& data = it->second;
-        data.nHits += 1;
-        data.energy += h.getEnergy();
-        data.energyError += h.getEnergyError() * h.getEnergyError();
-        data.time += h.getTime();
-        data.timeError += h.getTimeError() * h.getTimeError();
+      const float energyError = m_cache.energyError[i];
+      const float timeError   = m_cache.timeError[i];
+      if (data->nHits > 0) {
+        data->nHits += 1;
+        data->energy += m_cache.energy[i];
+        data->energyError += energyError * energyError;
+        data->time += m_cache.time[i];
+        data->timeError += timeError * timeError;
       } else {
-        layer[grid] = GridData{1,
-                               rc,
-                               h.getEnergy(),
-                               h.getEnergyError() * h.getEnergyError(),
-                               h.getTime(),
-                               h.getTimeError() * h.getTimeError(),
-                               h.getSector()};
+        *data = GridData{1,
+                         m_cache.rT[i],
+                         m_cache.energy[i],
+                         energyError * energyError,
+                         m_cache.time[i],
+                         timeError * timeError,
+                         m_cache.sector[i],
+                         data->etaBin,
+                         data->phiBin};
       }
     }
+    if (nOutside > 0 && msgLevel(MSG::DEBUG)) {
+      debug() << nOutside << " hits out of the layers or of the eta range are not merged" << endmsg;
+    }
 
     // convert grid data back to hits
-    for (const auto& [i, layer] : Jug::Utils::Enumerate(group_hits)) {
-      for (const auto& [grid, data] : layer) {
-        const double eta   = grid2pos(grid.first, m_etaSize);
-        const double phi   = grid2pos(grid.second, m_phiSize);
-        const double theta = eicd::etaToAngle(eta);
-        const double z     = cotan(theta) * data.rc;
-        const float r      = std::hypot(data.rc, z);
-        const auto pos     = eicd::sphericalToVector(r, theta, phi);
-        auto oh            = ohits.create();
-        oh.setEnergy(data.energy);
-        oh.setEnergyError(std::sqrt(data.energyError));
-        oh.setTime(data.time / data.nHits);
-        oh.setTimeError(std::sqrt(data.timeError));
-        oh.setPosition(pos);
-        oh.setLayer(i);
-        oh.setSector(data.sector);
-      }
-    }
+    m_grid.forEach([&](int layer, const GridData& data) {
+      const double eta   = grid2pos(data.etaBin, m_etaSize);
+      const double phi   = grid2pos(data.phiBin, m_phiSize);
+      const double theta = eicd::etaToAngle(eta);
+      const double z     = cotan(theta) * data.rc;
+      const float r      = std::hypot(data.rc, z);
+      const auto pos     = eicd::sphericalToVector(r, theta, phi);
+      auto oh            = ohits.create();
+      oh.setEnergy(data.energy);
+      oh.setEnergyError(std::sqrt(data.energyError));
+      oh.setTime(data.time / data.nHits);
+      oh.setTimeError(std::sqrt(data.timeError));
+      oh.setPosition(pos);
+      oh.setLayer(layer);
+      oh.setSector(data.sector);
+    });
+    m_grid.clear();
     return StatusCode::SUCCESS;
   }
 
@@ -21,6 +21,7 @@
 #include "DDRec/SurfaceManager.h"
 
 #include "JugBase/DataHandle.h"
+#include "JugBase/ICellGeometrySvc.h"
 #include "JugBase/IGeoSvc.h"
 
 // Event Model related classes
@@ -42,6 +43,7 @@ class ImagingPixelReco : public GaudiAlgorithm {
 private:
   // geometry service
   Gaudi::Property<std::string> m_geoSvcName{this, "geoServiceName", "GeoSvc"};
+  Gaudi::Property<std::string> m_cellGeoSvcName{this, "cellGeometryServiceName", "CellGeometrySvc"};
   Gaudi::Property<std::string> m_readout{this, "readoutClass", ""};
   Gaudi::Property<std::string> m_layerField{this, "layerField", "layer"};
   Gaudi::Property<std::string> m_sectorField{this, "sectorField", "sector"};
@@ -67,9 +69,9 @@ private:
 
   // Pointer to the geometry service
   SmartIF<IGeoSvc> m_geoSvc;
-  // visit readout fields
-  dd4hep::BitFieldCoder* id_dec;
-  size_t sector_idx{0}, layer_idx{0};
+  // cached cell positions and layer/sector ids, shared with the other hit reconstructions
+  SmartIF<ICellGeometrySvc> m_cellGeoSvc;
+  const Jug::Base::CellGeometryTable* m_cellGeometry{nullptr};
 
 public:
   ImagingPixelReco(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
@@ -93,11 +95,15 @@ public:
       return StatusCode::FAILURE;
     }
 
-    try {
-      id_dec     = m_geoSvc->detector()->readout(m_readout).idSpec().decoder();
-      sector_idx = id_dec->index(m_sectorField);
-      layer_idx  = id_dec->index(m_layerField);
-    } catch (...) {
+    m_cellGeoSvc = service(m_cellGeoSvcName);
+    if (!m_cellGeoSvc) {
+      error() << "Unable to locate Cell Geometry Service " << m_cellGeoSvcName.value() << endmsg;
+      return StatusCode::FAILURE;
+    }
+    // local positions in the lowest level DetElement of the cell
+    m_cellGeometry =
+        m_cellGeoSvc->geometryTable({m_readout.value(), "", {}, m_layerField.value(), m_sectorField.value()});
+    if (m_cellGeometry == nullptr) {
       error() << "Failed to load ID decoder for " << m_readout << endmsg;
       return StatusCode::FAILURE;
     }
@@ -112,7 +118,7 @@ public:
     // input collections
     const auto& rawhits = *m_inputHitCollection.get();
     // Create output collections
-    auto& hits = *m_outputHitCollection.createAndPut();
+    auto& hits = *m_outputHitCollection.createAndPut(rawhits.size());
 
     // energy time reconstruction
     for (const auto& rh : rawhits) {
@@ -130,26 +136,18 @@ public:
 
       #pragma GCC diagnostic pop
 
-      const auto id     = rh.getCellID();
-      // @TODO remove
-      const int lid = (int)id_dec->get(id, layer_idx);
-      const int sid = (int)id_dec->get(id, sector_idx);
-
-      // global positions
-      const auto gpos = m_geoSvc->cellIDPositionConverter()->position(id);
-      // local positions
-      const auto volman = m_geoSvc->detector()->volumeManager();
-      // TODO remove
-      const auto alignment = volman.lookupDetElement(id).nominal();
-      const auto pos       = alignment.worldToLocal(dd4hep::Position(gpos.x(), gpos.y(), gpos.z()));
-
+      const auto id   = rh.getCellID();
+      const auto& geo = m_cellGeometry->geometry(id);
 
       // create const vectors for passing to hit initializer list
       const decltype(eicd::CalorimeterHitData::position) position(
-        gpos.x() / m_lUnit, gpos.y() / m_lUnit, gpos.z() / m_lUnit
+        geo.global.x() / m_lUnit, geo.global.y() / m_lUnit, geo.global.z() / m_lUnit
       );
       const decltype(eicd::CalorimeterHitData::local) local(
-        pos.x() / m_lUnit, pos.y() / m_lUnit, pos.z() / m_lUnit
+        geo.local.x() / m_lUnit, geo.local.y() / m_lUnit, geo.local.z() / m_lUnit
+      );
+      const decltype(eicd::CalorimeterHitData::dimension) dimension(
+        geo.dimension[0] / m_lUnit, geo.dimension[1] / m_lUnit, geo.dimension[2] / m_lUnit
       );
 
       hits.push_back(eicd::CalorimeterHit{id,                         // cellID
@@ -158,8 +156,8 @@ public:
                                           static_cast<float>(time),   // time
                                           0,                          // timeError TODO
                                           position,                   // global pos
-                                          {0, 0, 0}, // @TODO: add dimension
-                                          sid,lid,
+                                          dimension,
+                                          geo.sector, geo.layer,
                                           local});                    // local pos
     }
     return StatusCode::SUCCESS;
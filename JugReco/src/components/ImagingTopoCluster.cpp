@@ -11,6 +11,13 @@
  */
 #include "fmt/format.h"
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <vector>
 
 #include "Gaudi/Property.h"
 #include "GaudiAlg/GaudiAlgorithm.h"
@@ -26,8 +33,13 @@
 #include "DDRec/SurfaceManager.h"
 
 #include "JugBase/DataHandle.h"
+#include "JugBase/IConcurrencySvc.h"
 #include "JugBase/IGeoSvc.h"
+#include "JugBase/Profiling.h"
+#include "JugBase/Utilities/TimeIndex.h"
 #include "JugReco/ClusterTypes.h"
+#include "JugReco/ProtoClusterIndex.h"
+#include "JugReco/TopoNeighbours.h"
 
 // Event Model related classes
 #include "eicd/CalorimeterHitCollection.h"
@@ -36,6 +48,157 @@
 
 using namespace Gaudi::Units;
 
+namespace {
+
+/**
+ * Hits of an event in flat arrays, with their eta and phi computed once, and binned for the
+ * neighbour candidates of ImagingTopoCluster: bins as wide as the neighbour distances in
+ * (sector, layer, local x, local y) for the same layer, in (sector, layer, eta, phi) for the
+ * neighbour layers and in global (x, y, z) for the other sectors. All the neighbours of a hit are
+ * in the adjacent bins. Bin keys are packed into 64 bits, a key collision only adds candidates
+ * that fail the exact check. With a time window, the hits of a bin are sorted by time and the
+ * candidates out of the window of the hit are skipped without being visited.
+ */
+class TopoHitGrid {
+public:
+  struct Widths {
+    double localX, localY, eta, phi, sector, timeWindow;
+  };
+
+  void build(const eicd::CalorimeterHitCollection& hits, const Widths& widths) {
+    m_widths = {positive_or_one(widths.localX), positive_or_one(widths.localY), positive_or_one(widths.eta),
+                positive_or_one(widths.phi), positive_or_one(widths.sector), widths.timeWindow};
+    const size_t n = hits.size();
+    for (auto* v : {&x, &y, &z, &localX, &localY}) {
+      v->resize(n);
+    }
+    eta.resize(n);
+    phi.resize(n);
+    energy.resize(n);
+    time.resize(n);
+    sector.resize(n);
+    layer.resize(n);
+    m_local.clear();
+    m_etaPhi.clear();
+    m_global.clear();
+    m_local.reserve(n);
+    m_etaPhi.reserve(n);
+    m_global.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+      const auto& hit = hits[i];
+      const auto pos  = hit.getPosition();
+      x[i]            = pos.x;
+      y[i]            = pos.y;
+      z[i]            = pos.z;
+      localX[i]       = hit.getLocal().x;
+      localY[i]       = hit.getLocal().y;
+      eta[i]          = eicd::eta(pos);
+      phi[i]          = eicd::angleAzimuthal(pos);
+      energy[i]       = hit.getEnergy();
+      time[i]         = hit.getTime();
+      sector[i]       = hit.getSector();
+      layer[i]        = hit.getLayer();
+
+      // without a time window the bins keep the hits in their order
+      const double t = (m_widths.timeWindow > 0.) ? time[i] : 0.;
+      m_local.add(layer_key(sector[i], layer[i], to_bin(localX[i], m_widths.localX),
+                            to_bin(localY[i], m_widths.localY)),
+                  t, i);
+      m_etaPhi.add(layer_key(sector[i], layer[i], to_bin(eta[i], m_widths.eta), to_bin(phi[i], m_widths.phi)), t,
+                   i);
+      m_global.add(global_key(to_bin(x[i], m_widths.sector), to_bin(y[i], m_widths.sector),
+                              to_bin(z[i], m_widths.sector)),
+                   t, i);
+    }
+    m_local.sort();
+    m_etaPhi.sort();
+    m_global.sort();
+  }
+
+  size_t size() const { return energy.size(); }
+
+  // call visit(j) for all hits j != idx that are potential neighbours of hit idx (within the layer range)
+  template <typename Visitor> void forEachCandidate(size_t idx, int layerRange, Visitor&& visit) const {
+    const int s       = sector[idx];
+    const int l       = layer[idx];
+    const int32_t lx  = to_bin(localX[idx], m_widths.localX);
+    const int32_t ly  = to_bin(localY[idx], m_widths.localY);
+    const int32_t be  = to_bin(eta[idx], m_widths.eta);
+    const int32_t bp  = to_bin(phi[idx], m_widths.phi);
+    const int32_t gx  = to_bin(x[idx], m_widths.sector);
+    const int32_t gy  = to_bin(y[idx], m_widths.sector);
+    const int32_t gz  = to_bin(z[idx], m_widths.sector);
+
+    const auto [tmin, tmax] = Jug::Base::timeWindowRange(time[idx], m_widths.timeWindow);
+    for (int da = -1; da <= 1; ++da) {
+      for (int db = -1; db <= 1; ++db) {
+        // same sector and layer
+        m_local.forEach(layer_key(s, l, lx + da, ly + db), tmin, tmax, [&](size_t j) {
+          if (j != idx && sector[j] == s && layer[j] == l) {
+            visit(j);
+          }
+        });
+        // same sector, neighbour layers
+        for (int dl = -layerRange; dl <= layerRange; ++dl) {
+          if (dl == 0) {
+            continue;
+          }
+          m_etaPhi.forEach(layer_key(s, l + dl, be + da, bp + db), tmin, tmax, [&](size_t j) {
+            if (sector[j] == s && layer[j] == l + dl) {
+              visit(j);
+            }
+          });
+        }
+        // other sectors
+        for (int dc = -1; dc <= 1; ++dc) {
+          m_global.forEach(global_key(gx + da, gy + db, gz + dc), tmin, tmax, [&](size_t j) {
+            if (sector[j] != s) {
+              visit(j);
+            }
+          });
+        }
+      }
+    }
+  }
+
+  // the types of the hit fields and of eicd::eta and eicd::angleAzimuthal, for the same comparisons as for the hits
+  using Angle = decltype(eicd::eta(eicd::Vector3f{}));
+  std::vector<float> x, y, z, localX, localY;
+  std::vector<Angle> eta, phi;
+  std::vector<double> energy;
+  std::vector<float> time;
+  std::vector<int> sector, layer;
+
+  // the arrays of the neighbour criteria
+  Jug::Reco::TopoHitArrays<Angle> view() const {
+    return {x.data(),   y.data(),   z.data(),    localX.data(), localY.data(),
+            eta.data(), phi.data(), time.data(), sector.data(), layer.data()};
+  }
+
+private:
+
+  static double positive_or_one(double w) { return (w > 0. && std::isfinite(w)) ? w : 1.; }
+  static int32_t to_bin(double v, double w) { return static_cast<int32_t>(std::floor(v / w)); }
+  static uint64_t layer_key(int s, int l, int32_t i, int32_t j) {
+    return (static_cast<uint64_t>(static_cast<uint16_t>(s)) << 48) |
+           (static_cast<uint64_t>(static_cast<uint16_t>(l)) << 32) |
+           ((static_cast<uint64_t>(static_cast<uint32_t>(i)) & 0xFFFF) << 16) |
+           (static_cast<uint64_t>(static_cast<uint32_t>(j)) & 0xFFFF);
+  }
+  static uint64_t global_key(int32_t i, int32_t j, int32_t k) {
+    return ((static_cast<uint64_t>(static_cast<uint32_t>(i)) & 0x1FFFFF) << 42) |
+           ((static_cast<uint64_t>(static_cast<uint32_t>(j)) & 0x1FFFFF) << 21) |
+           (static_cast<uint64_t>(static_cast<uint32_t>(k)) & 0x1FFFFF);
+  }
+
+  Widths m_widths{1., 1., 1., 1., 1., 0.};
+  Jug::Base::TimeSortedBins m_local;
+  Jug::Base::TimeSortedBins m_etaPhi;
+  Jug::Base::TimeSortedBins m_global;
+};
+
+} // namespace
+
 namespace Jug::Reco {
 
 /** Topological Cell Clustering Algorithm.
@@ -46,6 +209,15 @@ namespace Jug::Reco {
  *  Author: Chao Peng (ANL), 06/02/2021
  *  References: https://arxiv.org/pdf/1603.02934.pdf
  *
+ *  The proto-clusters are also put as hit indices in outputProtoClusterIndex if given, for
+ *  ImagingClusterReco. The podio proto-clusters are only filled with writeProtoClusters.
+ *
+ *  With the binned neighbours, the connected components can be found on a CUDA device (backend
+ *  "cuda", in builds with JUGGLER_ENABLE_CUDA): the candidate pairs of the grid and the hits are
+ *  uploaded, the device checks the neighbour criteria of the pairs and joins the neighbours with the
+ *  union-find of the parallel search, so that the groups are the same as on the CPU. Without a
+ *  device, or if the device search fails, the CPU is used.
+ *
  * \ingroup reco
  */
 class ImagingTopoCluster : public GaudiAlgorithm {
@@ -58,6 +230,8 @@ private:
   Gaudi::Property<std::vector<double>> u_layerDistEtaPhi{this, "layerDistEtaPhi", {0.01, 0.01}};
   // maximum global distance to be considered as neighbors in different sectors
   Gaudi::Property<double> m_sectorDist{this, "sectorDist", 1.0 * cm};
+  // maximum time difference to be considered as neighbors (off if 0), e.g. with time frames or background overlay
+  Gaudi::Property<double> m_timeWindow{this, "timeWindow", 0. * ns};
 
   // minimum hit energy to participate clustering
   Gaudi::Property<double> m_minClusterHitEdep{this, "minClusterHitEdep", 0.};
@@ -67,16 +241,36 @@ private:
   Gaudi::Property<double> m_minClusterEdep{this, "minClusterEdep", 0.5 * MeV};
   // minimum number of hits (to save this cluster)
   Gaudi::Property<int> m_minClusterNhits{this, "minClusterNhits", 10};
+  // find the neighbour candidates of a hit in the adjacent (layer, eta, phi) and local bins only,
+  // instead of checking all the hits of the event (same clusters)
+  Gaudi::Property<bool> m_binnedNeighbours{this, "binnedNeighbours", true};
+  // with the binned neighbours, the clusters are the connected components of a lock-free union-find
+  // over the neighbour pairs, found in parallel tasks of hitsPerTask hits (ordered by layer)
+  Gaudi::Property<int> m_numThreads{this, "numThreads", 1, "Hits of an event in the ConcurrencySvc arena (1: serial)"};
+  Gaudi::Property<size_t> m_hitsPerTask{this, "hitsPerTask", 1024, "Hits per parallel task"};
+  Gaudi::Property<std::string> m_backend{this, "backend", "cpu", "Connected components: cpu or cuda"};
   // input hits collection
   DataHandle<eicd::CalorimeterHitCollection> m_inputHitCollection{"inputHitCollection", Gaudi::DataHandle::Reader,
                                                                   this};
   // output clustered hits
   DataHandle<eicd::ProtoClusterCollection> m_outputProtoClusterCollection{"outputProtoClusterCollection",
                                                                           Gaudi::DataHandle::Writer, this};
+  // output clustered hits as hit indices, optional
+  Gaudi::Property<std::string> m_outputProtoIndex{this, "outputProtoClusterIndex", "",
+                                                  "Proto-clusters as hit indices (none if empty)"};
+  Gaudi::Property<bool> m_writeProtoClusters{this, "writeProtoClusters", true,
+                                             "Fill the podio proto-clusters (empty collection otherwise)"};
+  std::unique_ptr<DataHandle<ProtoClusterIndex>> m_outputProtoIndex_ptr;
+  ProtoClusterIndex m_protoIndex;
+
+  SmartIF<IConcurrencySvc> m_concurrencySvc;
+  // connected components on the device, decided in initialize
+  bool m_useDevice{false};
 
   // unitless counterparts of the input parameters
-  double localDistXY[2]{0,0}, layerDistEtaPhi[2]{0,0}, sectorDist{0};
+  double localDistXY[2]{0,0}, layerDistEtaPhi[2]{0,0}, sectorDist{0}, timeWindow{0};
   double minClusterHitEdep{0}, minClusterCenterEdep{0}, minClusterEdep{0}, minClusterNhits{0};
+  TopoNeighbourParams neighbourParams;
 
 public:
   ImagingTopoCluster(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
@@ -106,9 +300,12 @@ public:
     layerDistEtaPhi[0]   = u_layerDistEtaPhi.value()[0];
     layerDistEtaPhi[1]   = u_layerDistEtaPhi.value()[1] / rad;
     sectorDist           = m_sectorDist.value() / mm;
+    timeWindow           = m_timeWindow.value() / ns;
     minClusterHitEdep    = m_minClusterHitEdep.value() / GeV;
     minClusterCenterEdep = m_minClusterCenterEdep.value() / GeV;
     minClusterEdep       = m_minClusterEdep.value() / GeV;
+    neighbourParams      = {localDistXY[0], localDistXY[1], layerDistEtaPhi[0],           layerDistEtaPhi[1],
+                            sectorDist,     timeWindow,     m_neighbourLayersRange.value()};
 
     // summarize the clustering parameters
     info() << fmt::format("Local clustering (same sector and same layer): "
@@ -124,6 +321,43 @@ public:
                           sectorDist)
            << endmsg;
 
+    if (!m_outputProtoIndex.value().empty()) {
+      m_outputProtoIndex_ptr =
+          std::make_unique<DataHandle<ProtoClusterIndex>>(m_outputProtoIndex, Gaudi::DataHandle::Writer, this);
+    }
+
+    if (m_backend.value() == "cuda") {
+      if (!m_binnedNeighbours) {
+        error() << "The cuda backend needs the binned neighbours" << endmsg;
+        return StatusCode::FAILURE;
+      }
+#if defined(JUGGLER_HAVE_CUDA)
+      m_useDevice = topoCUDAAvailable();
+      if (!m_useDevice) {
+        warning() << "No CUDA device available, the clusters are found on the CPU" << endmsg;
+      }
+#else
+      warning() << "Built without CUDA (JUGGLER_ENABLE_CUDA), the clusters are found on the CPU" << endmsg;
+#endif
+    } else if (m_backend.value() != "cpu") {
+      error() << "Unknown backend " << m_backend.value() << ", use cpu or cuda" << endmsg;
+      return StatusCode::FAILURE;
+    }
+
+    if (m_hitsPerTask.value() == 0) {
+      error() << "hitsPerTask must be positive" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    if (m_binnedNeighbours && m_numThreads.value() != 1) {
+      m_concurrencySvc = service("ConcurrencySvc");
+      if (!m_concurrencySvc) {
+        error() << "Unable to locate ConcurrencySvc for numThreads " << m_numThreads.value() << endmsg;
+        return StatusCode::FAILURE;
+      }
+      info() << "Parallel connected-component clustering with up to " << m_concurrencySvc->concurrency()
+             << " threads" << endmsg;
+    }
+
     return StatusCode::SUCCESS;
   }
 
@@ -132,11 +366,31 @@ public:
     const auto& hits = *m_inputHitCollection.get();
     // Create output collections
     auto& proto = *m_outputProtoClusterCollection.createAndPut();
+    auto& index = m_outputProtoIndex_ptr ? *(m_outputProtoIndex_ptr->createAndPut()) : m_protoIndex;
+    index.clear();
 
     // group neighboring hits
     std::vector<bool> visits(hits.size(), false);
     std::vector<std::vector<std::pair<uint32_t, eicd::CalorimeterHit>>> groups;
-    for (size_t i = 0; i < hits.size(); ++i) {
+    TopoHitGrid grid;
+    if (m_binnedNeighbours) {
+      grid.build(hits,
+                 {localDistXY[0], localDistXY[1], layerDistEtaPhi[0], layerDistEtaPhi[1], sectorDist, timeWindow});
+    }
+    bool grouped = false;
+#if defined(JUGGLER_HAVE_CUDA)
+    if (m_useDevice) {
+      grouped = device_group(groups, hits, grid);
+      if (!grouped) {
+        warning() << "Clustering on the CUDA device failed, clustered on the CPU" << endmsg;
+      }
+    }
+#endif
+    if (!grouped && m_binnedNeighbours && m_numThreads.value() != 1) {
+      parallel_group(groups, hits, grid);
+      grouped = true;
+    }
+    for (size_t i = 0; i < hits.size() && !grouped; ++i) {
       if (msgLevel(MSG::DEBUG)) {
         debug() << fmt::format("hit {:d}: local position = ({}, {}, {}), global position = ({}, {}, {})", i + 1,
                                hits[i].getLocal().x, hits[i].getLocal().y, hits[i].getPosition().z,
@@ -149,7 +403,11 @@ public:
       }
       groups.emplace_back();
       // create a new group, and group all the neighboring hits
-      dfs_group(groups.back(), i, hits, visits);
+      if (m_binnedNeighbours) {
+        dfs_group(groups.back(), i, hits, grid, visits);
+      } else {
+        dfs_group(groups.back(), i, hits, visits);
+      }
     }
     if (msgLevel(MSG::DEBUG)) {
       debug() << "found " << groups.size() << " potential clusters (groups of hits)" << endmsg;
@@ -170,11 +428,13 @@ public:
       if (energy < minClusterEdep) {
         continue;
       }
-      auto pcl = proto.create();
       for (const auto& [idx, hit] : group) {
-        pcl.addToHits(hit);
-        pcl.addToWeights(1);
+        index.add(idx);
       }
+      index.close();
+    }
+    if (m_writeProtoClusters.value()) {
+      index.to_collection(hits, proto);
     }
 
     return StatusCode::SUCCESS;
@@ -185,6 +445,9 @@ private:
 
   // helper function to group hits
   bool is_neighbor(const eicd::CalorimeterHit& h1, const eicd::CalorimeterHit& h2) const {
+    if (!Jug::Base::inTimeWindow(h1.getTime(), h2.getTime(), timeWindow)) {
+      return false;
+    }
     // different sectors, simple distance check
     if (h1.getSector() != h2.getSector()) {
       return std::sqrt(pow2(h1.getPosition().x - h2.getPosition().x) + pow2(h1.getPosition().y - h2.getPosition().y) +
@@ -226,6 +489,186 @@ private:
       dfs_group(group, i, hits, visits);
     }
   }
+
+  // same check on the arrays of the grid, with the eta and phi of the hits computed once (shared with the device)
+  bool is_neighbor(const TopoHitGrid& g, size_t i, size_t j) const {
+    return topoNeighbours(g.view(), neighbourParams, i, j);
+  }
+
+  /** Parallel connected-component labelling.
+   *
+   *  The qualified hits (above minClusterHitEdep) are joined with their qualified neighbours by a
+   *  lock-free union-find: a root is only linked to a smaller root, with a compare-and-swap that
+   *  fails if it is no longer a root, so that the root of a component is its first hit whatever the
+   *  order of the unions. Each pair is found once, from its first hit, by the tasks over slices of
+   *  the hits ordered by layer. The groups are the components with a hit above
+   *  minClusterCenterEdep, in the order of their first such hit as for the search from the seeds,
+   *  with their hits in index order: deterministic for any number of threads.
+   */
+  void parallel_group(std::vector<std::vector<std::pair<uint32_t, eicd::CalorimeterHit>>>& groups,
+                      const eicd::CalorimeterHitCollection& hits, const TopoHitGrid& grid) {
+    JUG_PROFILE_REGION("ImagingTopoCluster/parallelGroup");
+    const size_t n = grid.size();
+    std::vector<std::atomic<uint32_t>> parent(n);
+    for (size_t i = 0; i < n; ++i) {
+      parent[i].store(static_cast<uint32_t>(i), std::memory_order_relaxed);
+    }
+    auto find = [&parent](uint32_t i) {
+      while (true) {
+        uint32_t p = parent[i].load(std::memory_order_relaxed);
+        if (p == i) {
+          return i;
+        }
+        // path halving, a failed exchange only skips the shortcut
+        const uint32_t gp = parent[p].load(std::memory_order_relaxed);
+        if (gp != p) {
+          parent[i].compare_exchange_weak(p, gp, std::memory_order_relaxed);
+        }
+        i = gp;
+      }
+    };
+    auto unite = [&parent, &find](uint32_t i, uint32_t j) {
+      while (true) {
+        i = find(i);
+        j = find(j);
+        if (i == j) {
+          return;
+        }
+        if (i < j) {
+          std::swap(i, j);
+        }
+        // link the larger root i to j, if i is still a root
+        uint32_t expected = i;
+        if (parent[i].compare_exchange_strong(expected, j, std::memory_order_relaxed)) {
+          return;
+        }
+      }
+    };
+
+    // slices of the qualified hits ordered by layer, for the locality of the bins
+    std::vector<uint32_t> order;
+    order.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+      if (grid.energy[i] >= minClusterHitEdep) {
+        order.push_back(static_cast<uint32_t>(i));
+      }
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&grid](uint32_t a, uint32_t b) { return grid.layer[a] < grid.layer[b]; });
+    const size_t perTask = m_hitsPerTask.value();
+    const size_t ntasks  = (order.size() + perTask - 1) / perTask;
+    m_concurrencySvc->parallelFor(ntasks, [&](size_t task) {
+      const size_t end = std::min(order.size(), (task + 1) * perTask);
+      for (size_t k = task * perTask; k < end; ++k) {
+        const uint32_t i = order[k];
+        grid.forEachCandidate(i, m_neighbourLayersRange, [&](size_t j) {
+          if (j > i && grid.energy[j] >= minClusterHitEdep && is_neighbor(grid, i, j)) {
+            unite(i, static_cast<uint32_t>(j));
+          }
+        });
+      }
+    });
+
+    make_groups(groups, hits, grid, find);
+  }
+
+  // deterministic compaction of the components (root(i) is the root of the component of hit i) into groups
+  template <typename Root>
+  void make_groups(std::vector<std::vector<std::pair<uint32_t, eicd::CalorimeterHit>>>& groups,
+                   const eicd::CalorimeterHitCollection& hits, const TopoHitGrid& grid, Root&& root) const {
+    const size_t n           = grid.size();
+    constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> group_of(n, kNone);
+    for (size_t i = 0; i < n; ++i) {
+      if (grid.energy[i] >= minClusterHitEdep && grid.energy[i] >= minClusterCenterEdep) {
+        const uint32_t r = root(static_cast<uint32_t>(i));
+        if (group_of[r] == kNone) {
+          group_of[r] = static_cast<uint32_t>(groups.size());
+          groups.emplace_back();
+        }
+      }
+    }
+    for (size_t i = 0; i < n; ++i) {
+      if (grid.energy[i] >= minClusterHitEdep) {
+        const uint32_t g = group_of[root(static_cast<uint32_t>(i))];
+        if (g != kNone) {
+          groups[g].emplace_back(static_cast<uint32_t>(i), hits[i]);
+        }
+      }
+    }
+  }
+
+#if defined(JUGGLER_HAVE_CUDA)
+  // connected components of the candidate pairs of the grid on the device, the same groups as parallel_group
+  bool device_group(std::vector<std::vector<std::pair<uint32_t, eicd::CalorimeterHit>>>& groups,
+                    const eicd::CalorimeterHitCollection& hits, const TopoHitGrid& grid) const {
+    static_assert(std::is_same_v<TopoHitGrid::Angle, double>, "the device arrays have double eta and phi");
+    JUG_PROFILE_REGION("ImagingTopoCluster/deviceGroup");
+    std::vector<uint32_t> first;
+    std::vector<uint32_t> second;
+    for (size_t i = 0; i < grid.size(); ++i) {
+      if (grid.energy[i] < minClusterHitEdep) {
+        continue;
+      }
+      grid.forEachCandidate(i, m_neighbourLayersRange, [&](size_t j) {
+        if (j > i && grid.energy[j] >= minClusterHitEdep) {
+          first.push_back(static_cast<uint32_t>(i));
+          second.push_back(static_cast<uint32_t>(j));
+        }
+      });
+    }
+    std::vector<uint32_t> root;
+    if (!topoComponentsCUDA(grid.view(), grid.size(), neighbourParams, first, second, root)) {
+      return false;
+    }
+    make_groups(groups, hits, grid, [&root](uint32_t i) { return root[i]; });
+    return true;
+  }
+#endif
+
+  // Depth-First Search over the neighbour candidates of the grid, with an explicit stack; the
+  // candidates of a hit are visited in the order of the hits, so that the groups are the same as
+  // with the scan over all the hits
+  void dfs_group(std::vector<std::pair<uint32_t, eicd::CalorimeterHit>>& group, size_t seed,
+                 const eicd::CalorimeterHitCollection& hits, const TopoHitGrid& grid,
+                 std::vector<bool>& visits) const {
+    struct Frame {
+      size_t idx;
+      std::vector<uint32_t> candidates;
+      size_t next;
+    };
+    std::vector<Frame> stack;
+    auto enter = [&](size_t idx) {
+      visits[idx] = true;
+      // not a qualified hit to participate in clustering, stop here
+      if (grid.energy[idx] < minClusterHitEdep) {
+        return;
+      }
+      group.emplace_back(idx, hits[idx]);
+      Frame frame{idx, {}, 0};
+      grid.forEachCandidate(idx, m_neighbourLayersRange, [&](size_t j) {
+        if (is_neighbor(grid, idx, j)) {
+          frame.candidates.push_back(static_cast<uint32_t>(j));
+        }
+      });
+      std::sort(frame.candidates.begin(), frame.candidates.end());
+      frame.candidates.erase(std::unique(frame.candidates.begin(), frame.candidates.end()), frame.candidates.end());
+      stack.push_back(std::move(frame));
+    };
+    enter(seed);
+    while (!stack.empty()) {
+      auto& frame = stack.back();
+      if (frame.next == frame.candidates.size()) {
+        stack.pop_back();
+        continue;
+      }
+      const uint32_t j = frame.candidates[frame.next++];
+      // visited
+      if (!visits[j]) {
+        enter(j);
+      }
+    }
+  }
 }; // namespace Jug::Reco
 
 // NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
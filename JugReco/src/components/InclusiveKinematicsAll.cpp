@@ -0,0 +1,307 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "Gaudi/Algorithm.h"
+#include "GaudiAlg/GaudiAlgorithm.h"
+#include "GaudiKernel/PhysicalConstants.h"
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "JugBase/DataHandle.h"
+#include "JugBase/EventFilter.h"
+#include "JugBase/IParticleSvc.h"
+
+#include "JugBase/Utilities/Boost.h"
+#include "JugReco/DISBeams.h"
+
+#include "Math/Vector4D.h"
+using ROOT::Math::PxPyPzEVector;
+
+// Event Model related classes
+#include "edm4hep/MCParticleCollection.h"
+#include "eicd/InclusiveKinematicsCollection.h"
+#include "eicd/MCRecoParticleAssociationCollection.h"
+#include "eicd/ReconstructedParticleCollection.h"
+
+namespace Jug::Reco {
+
+/** Inclusive kinematics with all the reconstruction methods.
+ *
+ *  Same results as InclusiveKinematicsElectron, JB, DA, Sigma and eSigma, but the beams, the
+ *  boost to the colinear frame and the hadronic final state sums are determined once for all
+ *  the methods. The methods property selects the methods that are computed, the output
+ *  collections of the others are left empty.
+ *
+ * \ingroup reco
+ */
+class InclusiveKinematicsAll : public GaudiAlgorithm {
+private:
+  DataHandle<edm4hep::MCParticleCollection> m_inputMCParticleCollection{
+    "inputMCParticles",
+    Gaudi::DataHandle::Reader,
+    this};
+  DataHandle<eicd::ReconstructedParticleCollection> m_inputParticleCollection{
+    "inputReconstructedParticles",
+    Gaudi::DataHandle::Reader,
+    this};
+  DataHandle<eicd::MCRecoParticleAssociationCollection> m_inputParticleAssociation{
+    "inputParticleAssociations",
+    Gaudi::DataHandle::Reader,
+    this};
+  DataHandle<DISBeams> m_inputBeams{
+    "inputBeams",
+    Gaudi::DataHandle::Reader,
+    this};
+  DataHandle<eicd::InclusiveKinematicsCollection> m_outputElectron{
+    "outputInclusiveKinematicsElectron",
+    Gaudi::DataHandle::Writer,
+    this};
+  DataHandle<eicd::InclusiveKinematicsCollection> m_outputJB{
+    "outputInclusiveKinematicsJB",
+    Gaudi::DataHandle::Writer,
+    this};
+  DataHandle<eicd::InclusiveKinematicsCollection> m_outputDA{
+    "outputInclusiveKinematicsDA",
+    Gaudi::DataHandle::Writer,
+    this};
+  DataHandle<eicd::InclusiveKinematicsCollection> m_outputSigma{
+    "outputInclusiveKinematicsSigma",
+    Gaudi::DataHandle::Writer,
+    this};
+  DataHandle<eicd::InclusiveKinematicsCollection> m_outputeSigma{
+    "outputInclusiveKinematicseSigma",
+    Gaudi::DataHandle::Writer,
+    this};
+
+  Gaudi::Property<double> m_crossingAngle{this, "crossingAngle", -0.025 * Gaudi::Units::radian};
+  // Read the beams and scattered electron of InclusiveKinematicsBeams instead of finding them
+  Gaudi::Property<bool> m_useBeams{this, "useBeams", false};
+  Gaudi::Property<std::vector<std::string>> m_methods{
+    this, "methods", {"Electron", "JB", "DA", "Sigma", "eSigma"}, "Reconstruction methods to compute"};
+
+  SmartIF<IParticleSvc> m_pidSvc;
+  double m_proton{0}, m_neutron{0}, m_electron{0};
+  bool m_doElectron{false}, m_doJB{false}, m_doDA{false}, m_doSigma{false}, m_doeSigma{false};
+
+public:
+  InclusiveKinematicsAll(const std::string& name, ISvcLocator* svcLoc)
+      : GaudiAlgorithm(name, svcLoc) {
+    declareProperty("inputMCParticles", m_inputMCParticleCollection, "MCParticles");
+    declareProperty("inputReconstructedParticles", m_inputParticleCollection, "ReconstructedParticles");
+    declareProperty("inputParticleAssociations", m_inputParticleAssociation, "MCRecoParticleAssociation");
+    declareProperty("inputBeams", m_inputBeams, "DISBeams");
+    declareProperty("outputInclusiveKinematicsElectron", m_outputElectron, "InclusiveKinematicsElectron");
+    declareProperty("outputInclusiveKinematicsJB", m_outputJB, "InclusiveKinematicsJB");
+    declareProperty("outputInclusiveKinematicsDA", m_outputDA, "InclusiveKinematicsDA");
+    declareProperty("outputInclusiveKinematicsSigma", m_outputSigma, "InclusiveKinematicsSigma");
+    declareProperty("outputInclusiveKinematicseSigma", m_outputeSigma, "InclusiveKinematicseSigma");
+  }
+
+  StatusCode initialize() override {
+    if (GaudiAlgorithm::initialize().isFailure())
+      return StatusCode::FAILURE;
+
+    m_pidSvc = service("ParticleSvc");
+    if (!m_pidSvc) {
+      error() << "Unable to locate Particle Service. "
+              << "Make sure you have ParticleSvc in the configuration."
+              << endmsg;
+      return StatusCode::FAILURE;
+    }
+    m_proton = m_pidSvc->particle(2212).mass;
+    m_neutron = m_pidSvc->particle(2112).mass;
+    m_electron = m_pidSvc->particle(11).mass;
+
+    for (const auto& method : m_methods.value()) {
+      if (method == "Electron") {
+        m_doElectron = true;
+      } else if (method == "JB") {
+        m_doJB = true;
+      } else if (method == "DA") {
+        m_doDA = true;
+      } else if (method == "Sigma") {
+        m_doSigma = true;
+      } else if (method == "eSigma") {
+        m_doeSigma = true;
+      } else {
+        error() << "Unknown method " << method << ", use Electron, JB, DA, Sigma or eSigma" << endmsg;
+        return StatusCode::FAILURE;
+      }
+    }
+
+    return StatusCode::SUCCESS;
+  }
+
+  StatusCode execute() override {
+    // input collections
+    const auto& rcparts = *(m_inputParticleCollection.get());
+    // output collections
+    auto& out_electron = *(m_outputElectron.createAndPut());
+    auto& out_jb       = *(m_outputJB.createAndPut());
+    auto& out_da       = *(m_outputDA.createAndPut());
+    auto& out_sigma    = *(m_outputSigma.createAndPut());
+    auto& out_esigma   = *(m_outputeSigma.createAndPut());
+
+    // Get the beams and the reconstructed scattered electron
+    DISBeams localBeams;
+    const DISBeams* beams = &localBeams;
+    if (m_useBeams) {
+      beams = m_inputBeams.get();
+    } else {
+      localBeams = makeDISBeams(*(m_inputMCParticleCollection.get()), *(m_inputParticleAssociation.get()),
+                                {m_electron, m_proton, m_neutron, m_crossingAngle});
+    }
+    if (const char* missing = beams->missing()) {
+      return Jug::Base::rejectEvent(*this, missing);
+    }
+    const PxPyPzEVector ei{*beams->ei};
+    const PxPyPzEVector pi{*beams->pi};
+    const auto ef_rc{*beams->ef_rc};
+    const auto ef_rc_id{beams->ef_rc_id};
+
+    // One loop over the reconstructed particles, shared by all methods: the scattered electron
+    // in the lab and colinear frames, and the sums of all other particles in the colinear frame
+    const bool needBoost = m_doJB || m_doDA || m_doSigma || m_doeSigma;
+    const auto boost = needBoost ? Jug::Base::Boost::determine_boost(ei, pi) : Jug::Base::Boost::LorentzRotation{};
+    bool found_e   = false;
+    PxPyPzEVector ef;
+    double theta_e = 0;
+    double pt_e    = 0;
+    double sigma_e = 0;
+    Jug::Base::Boost::FourMomenta hfs;
+    if (needBoost) {
+      hfs.reserve(rcparts.size());
+    }
+    for (const auto& p : rcparts) {
+      // Lorentz vector in lab frame
+      const PxPyPzEVector p_lab(p.getMomentum().x, p.getMomentum().y, p.getMomentum().z, p.getEnergy());
+      if (p.getObjectID().index == ef_rc_id) {
+        if (!found_e) {
+          found_e = true;
+          ef      = p_lab;
+        }
+        if (needBoost) {
+          // Boost to colinear frame
+          const PxPyPzEVector e_boosted = Jug::Base::Boost::apply_boost(boost, p_lab);
+          theta_e = e_boosted.Theta();
+          pt_e    = e_boosted.Pt();
+          sigma_e = e_boosted.E() - e_boosted.Pz();
+        }
+      } else if (needBoost) {
+        hfs.push_back(p_lab.Px(), p_lab.Py(), p_lab.Pz(), p_lab.E());
+      }
+    }
+    // Boost the hadronic final state to the colinear frame at once
+    Jug::Base::Boost::apply_boost(boost, hfs);
+    const auto hf_sum  = hfs.sum();
+    const double pxsum = hf_sum.Px();
+    const double pysum = hf_sum.Py();
+    const double pzsum = hf_sum.Pz();
+    const double Esum  = hf_sum.E();
+    const auto sigma_h = Esum - pzsum;
+    const auto ptsum   = sqrt(pxsum * pxsum + pysum * pysum);
+
+    // Electron method
+    if (m_doElectron) {
+      if (!found_e) {
+        if (msgLevel(MSG::DEBUG)) {
+          debug() << "No scattered electron found" << endmsg;
+        }
+      } else {
+        const auto q        = ei - ef;
+        const auto q_dot_pi = q.Dot(pi);
+        const auto Q2       = -q.Dot(q);
+        const auto y        = q_dot_pi / ei.Dot(pi);
+        const auto nu       = q_dot_pi / m_proton;
+        const auto x        = Q2 / (2. * q_dot_pi);
+        const auto W        = sqrt(+2. * q_dot_pi - Q2);
+        auto kin            = out_electron.create(x, Q2, W, y, nu);
+        kin.setScat(ef_rc);
+        debugKinematics("Electron", kin);
+      }
+    }
+
+    // the hadronic methods need a hadronic final state
+    if (!needBoost) {
+      return StatusCode::SUCCESS;
+    }
+    if (sigma_h <= 0) {
+      if (msgLevel(MSG::DEBUG)) {
+        debug() << "Sigma zero or negative" << endmsg;
+      }
+      return StatusCode::SUCCESS;
+    }
+
+    // Jacquet-Blondel method
+    if (m_doJB) {
+      const auto y_jb  = sigma_h / (2. * ei.energy());
+      const auto Q2_jb = ptsum * ptsum / (1. - y_jb);
+      const auto x_jb  = Q2_jb / (4. * ei.energy() * pi.energy() * y_jb);
+      const auto nu_jb = Q2_jb / (2. * m_proton * x_jb);
+      const auto W_jb  = sqrt(m_proton * m_proton + 2 * m_proton * nu_jb - Q2_jb);
+      auto kin         = out_jb.create(x_jb, Q2_jb, W_jb, y_jb, nu_jb);
+      kin.setScat(ef_rc);
+      debugKinematics("JB", kin);
+    }
+
+    // Double angle method
+    if (m_doDA) {
+      const auto theta_h = 2. * atan(sigma_h / ptsum);
+      const auto y_da    = tan(theta_h / 2.) / (tan(theta_e / 2.) + tan(theta_h / 2.));
+      const auto Q2_da   = 4. * ei.energy() * ei.energy() * (1. / tan(theta_e / 2.)) *
+                         (1. / (tan(theta_e / 2.) + tan(theta_h / 2.)));
+      const auto x_da  = Q2_da / (4. * ei.energy() * pi.energy() * y_da);
+      const auto nu_da = Q2_da / (2. * m_proton * x_da);
+      const auto W_da  = sqrt(m_proton * m_proton + 2 * m_proton * nu_da - Q2_da);
+      auto kin         = out_da.create(x_da, Q2_da, W_da, y_da, nu_da);
+      kin.setScat(ef_rc);
+      debugKinematics("DA", kin);
+    }
+
+    // Sigma and e-Sigma methods
+    const auto sigma_tot = sigma_e + sigma_h;
+    const auto y_sig     = sigma_h / sigma_tot;
+    const auto Q2_sig    = (pt_e * pt_e) / (1. - y_sig);
+    const auto x_sig     = Q2_sig / (4. * ei.energy() * pi.energy() * y_sig);
+    if (m_doSigma) {
+      const auto nu_sig = Q2_sig / (2. * m_proton * x_sig);
+      const auto W_sig  = sqrt(m_proton * m_proton + 2 * m_proton * nu_sig - Q2_sig);
+      auto kin          = out_sigma.create(x_sig, Q2_sig, W_sig, y_sig, nu_sig);
+      kin.setScat(ef_rc);
+      debugKinematics("Sigma", kin);
+    }
+    if (m_doeSigma) {
+      const auto y_e     = 1. - sigma_e / (2. * ei.energy());
+      const auto Q2_esig = (pt_e * pt_e) / (1. - y_e);
+      const auto x_esig  = x_sig;
+      const auto y_esig  = Q2_esig / (4. * ei.energy() * pi.energy() * x_esig);
+      const auto nu_esig = Q2_esig / (2. * m_proton * x_esig);
+      const auto W_esig  = sqrt(m_proton * m_proton + 2 * m_proton * nu_esig - Q2_esig);
+      auto kin           = out_esigma.create(x_esig, Q2_esig, W_esig, y_esig, nu_esig);
+      kin.setScat(ef_rc);
+      debugKinematics("eSigma", kin);
+    }
+
+    return StatusCode::SUCCESS;
+  }
+
+private:
+  template <typename Kinematics> void debugKinematics(const char* method, const Kinematics& kin) {
+    if (msgLevel(MSG::DEBUG)) {
+      debug() << method << " x,Q2,W,y,nu = "
+              << kin.getX() << ","
+              << kin.getQ2() << ","
+              << kin.getW() << ","
+              << kin.getY() << ","
+              << kin.getNu()
+              << endmsg;
+    }
+  }
+};
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(InclusiveKinematicsAll)
+
+} // namespace Jug::Reco
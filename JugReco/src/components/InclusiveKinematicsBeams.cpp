@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "Gaudi/Property.h"
+#include "GaudiKernel/PhysicalConstants.h"
+
+#include "JugBase/EventFilter.h"
+#include "JugBase/IParticleSvc.h"
+#include "JugBase/Transformer.h"
+#include "JugReco/DISBeams.h"
+
+// Event Model related classes
+#include "edm4hep/MCParticleCollection.h"
+#include "eicd/MCRecoParticleAssociationCollection.h"
+
+namespace Jug::Reco {
+
+/** Beams and scattered electron for the inclusive kinematics.
+ *
+ *  Finds the beams and the scattered electron, and indexes the particle associations, once per
+ *  event for the InclusiveKinematics algorithms (with useBeams) that would each find them again.
+ *  The events without beams or scattered electron are rejected (filter decision).
+ *
+ * \ingroup reco
+ */
+class InclusiveKinematicsBeams
+    : public Jug::Transformer<DISBeams, edm4hep::MCParticleCollection, eicd::MCRecoParticleAssociationCollection> {
+private:
+  Gaudi::Property<double> m_crossingAngle{this, "crossingAngle", -0.025 * Gaudi::Units::radian};
+
+  SmartIF<IParticleSvc> m_pidSvc;
+  DISBeamsConfig m_cfg;
+
+public:
+  InclusiveKinematicsBeams(const std::string& name, ISvcLocator* svcLoc)
+      : MultiTransformer(name, svcLoc,
+                         {KeyValue{"inputMCParticles", "MCParticles"},
+                          KeyValue{"inputParticleAssociations", "MCRecoParticleAssociation"}},
+                         {KeyValue{"outputBeams", "DISBeams"}}) {}
+
+  StatusCode initialize() override {
+    if (Gaudi::Algorithm::initialize().isFailure()) {
+      return StatusCode::FAILURE;
+    }
+    m_pidSvc = service("ParticleSvc");
+    if (!m_pidSvc) {
+      error() << "Unable to locate Particle Service. "
+              << "Make sure you have ParticleSvc in the configuration." << endmsg;
+      return StatusCode::FAILURE;
+    }
+    m_cfg = {m_pidSvc->particle(11).mass, m_pidSvc->particle(2212).mass, m_pidSvc->particle(2112).mass,
+             m_crossingAngle};
+    return StatusCode::SUCCESS;
+  }
+
+  void operator()(const edm4hep::MCParticleCollection& mcparts, const eicd::MCRecoParticleAssociationCollection& rcassoc,
+                  DISBeams& beams) const override {
+    beams = makeDISBeams(mcparts, rcassoc, m_cfg);
+    if (const char* missing = beams.missing()) {
+      Jug::Base::rejectEvent(*this, missing).ignore();
+    }
+  }
+};
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(InclusiveKinematicsBeams)
+
+} // namespace Jug::Reco
@@ -12,9 +12,10 @@
 
 #include "JugBase/IParticleSvc.h"
 #include "JugBase/DataHandle.h"
+#include "JugBase/EventFilter.h"
 
-#include "JugBase/Utilities/Beam.h"
 #include "JugBase/Utilities/Boost.h"
+#include "JugReco/DISBeams.h"
 
 #include "Math/Vector4D.h"
 using ROOT::Math::PxPyPzEVector;
@@ -46,7 +47,14 @@ private:
     Gaudi::DataHandle::Writer,
     this};
 
+  DataHandle<DISBeams> m_inputBeams{
+    "inputBeams",
+    Gaudi::DataHandle::Reader,
+    this};
+
   Gaudi::Property<double> m_crossingAngle{this, "crossingAngle", -0.025 * Gaudi::Units::radian};
+  // Read the beams and scattered electron of InclusiveKinematicsBeams instead of finding them
+  Gaudi::Property<bool> m_useBeams{this, "useBeams", false};
 
   SmartIF<IParticleSvc> m_pidSvc;
   double m_proton{0}, m_neutron{0}, m_electron{0};
@@ -57,6 +65,7 @@ public:
     declareProperty("inputMCParticles", m_inputMCParticleCollection, "MCParticles");
     declareProperty("inputReconstructedParticles", m_inputParticleCollection, "ReconstructedParticles");
     declareProperty("inputParticleAssociations", m_inputParticleAssociation, "MCRecoParticleAssociation");
+    declareProperty("inputBeams", m_inputBeams, "DISBeams");
     declareProperty("outputInclusiveKinematics", m_outputInclusiveKinematicsCollection, "InclusiveKinematicsSigma");
   }
 
@@ -80,71 +89,26 @@ public:
 
   StatusCode execute() override {
     // input collections
-    const auto& mcparts = *(m_inputMCParticleCollection.get());
     const auto& rcparts = *(m_inputParticleCollection.get());
-    const auto& rcassoc = *(m_inputParticleAssociation.get());
     // output collection
     auto& out_kinematics = *(m_outputInclusiveKinematicsCollection.createAndPut());
 
-    // Get incoming electron beam
-    const auto ei_coll = Jug::Base::Beam::find_first_beam_electron(mcparts);
-    if (ei_coll.size() == 0) {
-      if (msgLevel(MSG::DEBUG)) {
-        debug() << "No beam electron found" << endmsg;
-      }
-      return StatusCode::SUCCESS;
-    }
-    const PxPyPzEVector ei(
-      Jug::Base::Beam::round_beam_four_momentum(
-        ei_coll[0].getMomentum(),
-        m_electron,
-        {-5.0, -10.0, -18.0},
-        0.0)
-      );
-
-    // Get incoming hadron beam
-    const auto pi_coll = Jug::Base::Beam::find_first_beam_hadron(mcparts);
-    if (pi_coll.size() == 0) {
-      if (msgLevel(MSG::DEBUG)) {
-        debug() << "No beam hadron found" << endmsg;
-      }
-      return StatusCode::SUCCESS;
+    // Get the beams and the reconstructed scattered electron
+    DISBeams localBeams;
+    const DISBeams* beams = &localBeams;
+    if (m_useBeams) {
+      beams = m_inputBeams.get();
+    } else {
+      localBeams = makeDISBeams(*(m_inputMCParticleCollection.get()), *(m_inputParticleAssociation.get()),
+                                {m_electron, m_proton, m_neutron, m_crossingAngle});
     }
-    const PxPyPzEVector pi(
-      Jug::Base::Beam::round_beam_four_momentum(
-        pi_coll[0].getMomentum(),
-        pi_coll[0].getPDG() == 2212 ? m_proton : m_neutron,
-        {41.0, 100.0, 275.0},
-        m_crossingAngle)
-      );
-
-    // Get first scattered electron
-    const auto ef_coll = Jug::Base::Beam::find_first_scattered_electron(mcparts);
-    if (ef_coll.size() == 0) {
-      if (msgLevel(MSG::DEBUG)) {
-        debug() << "No truth scattered electron found" << endmsg;
-      }
-      return StatusCode::SUCCESS;
-    }
-    // Associate first scattered electron with reconstructed electrons
-    //const auto ef_assoc = std::find_if(
-    //  rcassoc.begin(),
-    //  rcassoc.end(),
-    //  [&ef_coll](const auto& a){ return a.getSimID() == ef_coll[0].getObjectID().index; });
-    auto ef_assoc = rcassoc.begin();
-    for (; ef_assoc != rcassoc.end(); ++ef_assoc) {
-      if (ef_assoc->getSimID() == (unsigned) ef_coll[0].getObjectID().index) {
-        break;
-      }
+    if (const char* missing = beams->missing()) {
+      return Jug::Base::rejectEvent(*this, missing);
     }
-    if (!(ef_assoc != rcassoc.end())) {
-      if (msgLevel(MSG::DEBUG)) {
-        debug() << "Truth scattered electron not in reconstructed particles" << endmsg;
-      }
-      return StatusCode::SUCCESS;
-    }
-    const auto ef_rc{ef_assoc->getRec()};
-    const auto ef_rc_id{ef_rc.getObjectID().index};
+    const PxPyPzEVector ei{*beams->ei};
+    const PxPyPzEVector pi{*beams->pi};
+    const auto ef_rc{*beams->ef_rc};
+    const auto ef_rc_id{beams->ef_rc_id};
 
     // Loop over reconstructed particles to get all outgoing particles
     // ----------------------------------------------------------------- 
@@ -200,10 +164,7 @@ public:
     auto sigma_tot = sigma_e + sigma_h;
 
     if (sigma_h <= 0) {
-      if (msgLevel(MSG::DEBUG)) {
-        debug() << "No scattered electron found or sigma zero or negative" << endmsg;
-      }
-      return StatusCode::SUCCESS;
+      return Jug::Base::rejectEvent(*this, "No scattered electron found or sigma zero or negative");
     }
 
     // Calculate kinematic variables
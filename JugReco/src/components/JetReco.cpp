@@ -0,0 +1,205 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "Gaudi/Property.h"
+#include "GaudiAlg/GaudiAlgorithm.h"
+#include "GaudiKernel/PhysicalConstants.h"
+
+#include "JugBase/DataHandle.h"
+#include "JugBase/Logging.h"
+#include "JugBase/Utilities/Boost.h"
+#include "JugReco/DISBeams.h"
+#include "JugReco/JetConstituents.h"
+
+#include "fastjet/ClusterSequence.hh"
+#include "fastjet/JetDefinition.hh"
+#include "fastjet/PseudoJet.hh"
+#if defined(JUGGLER_HAVE_CENTAURO)
+#include "fastjet/contrib/Centauro.hh"
+#endif
+
+// Event Model related classes
+#include "eicd/ReconstructedParticleCollection.h"
+
+namespace Jug::Reco {
+
+/** Jet reconstruction with FastJet.
+ *
+ *  The jets of the reconstructed particles (e.g. of ParticleCollector or MatchClusters), with
+ *  the anti-kT, kT or Cambridge/Aachen algorithms, or Centauro (with the Centauro plugin of
+ *  fastjet-contrib) for DIS. The particles are clustered in the lab frame, or in the Breit or
+ *  collinear (head-on) frame of the DISBeams of InclusiveKinematicsBeams (inputBeams), boosted
+ *  together with the batched boost; the scattered electron is then not clustered. The jets are
+ *  written in the frame of the clustering, with the indices of their constituents in the input
+ *  particles (outputJetConstituents, optional).
+ *
+ *  The clustering strategy is that of FastJet (Best: the N log N strategies for the large
+ *  multiplicities) unless set with strategy.
+ *
+ * \ingroup reco
+ */
+class JetReco : public GaudiAlgorithm {
+private:
+  DataHandle<eicd::ReconstructedParticleCollection> m_inputParticles{"inputParticles", Gaudi::DataHandle::Reader,
+                                                                     this};
+  DataHandle<eicd::ReconstructedParticleCollection> m_outputJets{"outputJets", Gaudi::DataHandle::Writer, this};
+
+  Gaudi::Property<std::string> m_algorithm{this, "algorithm", "antikt"}; // antikt, kt, cambridge or centauro
+  Gaudi::Property<double> m_radius{this, "radius", 1.0};
+  Gaudi::Property<double> m_minJetPt{this, "minJetPt", 1.0 * Gaudi::Units::GeV};
+  Gaudi::Property<std::string> m_strategy{this, "strategy", "best"}; // best, nlnn, n2tiled or n2plain
+  Gaudi::Property<std::string> m_frame{this, "frame", "lab"};        // lab, breit or collinear
+
+  // beams of the event, for the Breit and collinear frames
+  Gaudi::Property<std::string> m_inputBeams{this, "inputBeams", ""};
+  std::unique_ptr<DataHandle<DISBeams>> m_inputBeams_ptr;
+
+  // constituents of the jets as indices of the input particles
+  Gaudi::Property<std::string> m_outputConstituents{this, "outputJetConstituents", ""};
+  std::unique_ptr<DataHandle<JetConstituents>> m_outputConstituents_ptr;
+
+  std::unique_ptr<fastjet::JetDefinition> m_jetDef;
+#if defined(JUGGLER_HAVE_CENTAURO)
+  std::unique_ptr<fastjet::contrib::CentauroPlugin> m_centauro;
+#endif
+
+public:
+  JetReco(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
+    declareProperty("inputParticles", m_inputParticles, "");
+    declareProperty("outputJets", m_outputJets, "");
+  }
+
+  StatusCode initialize() override {
+    if (GaudiAlgorithm::initialize().isFailure()) {
+      return StatusCode::FAILURE;
+    }
+    if (m_frame.value() != "lab" && m_frame.value() != "breit" && m_frame.value() != "collinear") {
+      error() << "Unknown frame " << m_frame.value() << ", lab, breit or collinear" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    if (m_frame.value() != "lab") {
+      if (m_inputBeams.value().empty()) {
+        error() << "The " << m_frame.value() << " frame needs the DISBeams of inputBeams" << endmsg;
+        return StatusCode::FAILURE;
+      }
+      m_inputBeams_ptr = std::make_unique<DataHandle<DISBeams>>(m_inputBeams, Gaudi::DataHandle::Reader, this);
+    }
+    if (!m_outputConstituents.value().empty()) {
+      m_outputConstituents_ptr =
+          std::make_unique<DataHandle<JetConstituents>>(m_outputConstituents, Gaudi::DataHandle::Writer, this);
+    }
+
+    fastjet::Strategy strategy = fastjet::Best;
+    if (m_strategy.value() == "nlnn") {
+      strategy = fastjet::NlnN;
+    } else if (m_strategy.value() == "n2tiled") {
+      strategy = fastjet::N2Tiled;
+    } else if (m_strategy.value() == "n2plain") {
+      strategy = fastjet::N2Plain;
+    } else if (m_strategy.value() != "best") {
+      error() << "Unknown strategy " << m_strategy.value() << ", best, nlnn, n2tiled or n2plain" << endmsg;
+      return StatusCode::FAILURE;
+    }
+
+    if (m_algorithm.value() == "antikt") {
+      m_jetDef = std::make_unique<fastjet::JetDefinition>(fastjet::antikt_algorithm, m_radius, fastjet::E_scheme,
+                                                          strategy);
+    } else if (m_algorithm.value() == "kt") {
+      m_jetDef =
+          std::make_unique<fastjet::JetDefinition>(fastjet::kt_algorithm, m_radius, fastjet::E_scheme, strategy);
+    } else if (m_algorithm.value() == "cambridge") {
+      m_jetDef = std::make_unique<fastjet::JetDefinition>(fastjet::cambridge_algorithm, m_radius, fastjet::E_scheme,
+                                                          strategy);
+    } else if (m_algorithm.value() == "centauro") {
+#if defined(JUGGLER_HAVE_CENTAURO)
+      if (m_frame.value() != "breit") {
+        error() << "Centauro jets are defined in the Breit frame" << endmsg;
+        return StatusCode::FAILURE;
+      }
+      m_centauro = std::make_unique<fastjet::contrib::CentauroPlugin>(m_radius);
+      m_jetDef   = std::make_unique<fastjet::JetDefinition>(m_centauro.get());
+#else
+      error() << "Centauro needs the Centauro plugin of fastjet-contrib" << endmsg;
+      return StatusCode::FAILURE;
+#endif
+    } else {
+      error() << "Unknown algorithm " << m_algorithm.value() << ", antikt, kt, cambridge or centauro" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    info() << m_jetDef->description() << endmsg;
+    return StatusCode::SUCCESS;
+  }
+
+  StatusCode execute() override {
+    const auto& parts  = *m_inputParticles.get();
+    auto& jets         = *m_outputJets.createAndPut();
+    auto* constituents = m_outputConstituents_ptr ? m_outputConstituents_ptr->createAndPut() : nullptr;
+
+    // four-momenta of the particles to cluster, in the frame of the clustering
+    const DISBeams* beams = m_inputBeams_ptr ? m_inputBeams_ptr->get() : nullptr;
+    if (beams != nullptr && beams->missing() != nullptr) {
+      JUG_DEBUG("No jets without beams: " << beams->missing());
+      return StatusCode::SUCCESS;
+    }
+    Jug::Base::Boost::FourMomenta p4;
+    p4.reserve(parts.size());
+    std::vector<uint32_t> index;
+    index.reserve(parts.size());
+    for (size_t i = 0; i < parts.size(); ++i) {
+      // not the scattered electron
+      if (beams != nullptr && parts[i].getObjectID() == beams->ef_rc->getObjectID()) {
+        continue;
+      }
+      const auto p = parts[i].getMomentum();
+      p4.push_back(p.x, p.y, p.z, parts[i].getEnergy());
+      index.push_back(static_cast<uint32_t>(i));
+    }
+    if (beams != nullptr) {
+      const auto efp = beams->ef_rc->getMomentum();
+      const ROOT::Math::PxPyPzEVector ef{efp.x, efp.y, efp.z, beams->ef_rc->getEnergy()};
+      const auto tf = (m_frame.value() == "breit")
+                          ? Jug::Base::Boost::determine_breit_boost(*beams->ei, *beams->pi, ef)
+                          : Jug::Base::Boost::determine_boost(*beams->ei, *beams->pi);
+      Jug::Base::Boost::apply_boost(tf, p4);
+    }
+
+    std::vector<fastjet::PseudoJet> inputs;
+    inputs.reserve(p4.size());
+    for (size_t i = 0; i < p4.size(); ++i) {
+      inputs.emplace_back(p4.px[i], p4.py[i], p4.pz[i], p4.E[i]);
+      inputs.back().set_user_index(static_cast<int>(index[i]));
+    }
+    const fastjet::ClusterSequence sequence(inputs, *m_jetDef);
+    const auto found = fastjet::sorted_by_pt(sequence.inclusive_jets(m_minJetPt.value() / Gaudi::Units::GeV));
+
+    for (const auto& jet : found) {
+      auto out     = jets.create();
+      float charge = 0;
+      for (const auto& c : jet.constituents()) {
+        charge += parts[c.user_index()].getCharge();
+        if (constituents != nullptr) {
+          constituents->add(static_cast<uint32_t>(c.user_index()));
+        }
+      }
+      if (constituents != nullptr) {
+        constituents->close();
+      }
+      out.setMomentum({static_cast<float>(jet.px()), static_cast<float>(jet.py()), static_cast<float>(jet.pz())});
+      out.setEnergy(static_cast<float>(jet.E()));
+      out.setMass(static_cast<float>(jet.m()));
+      out.setCharge(charge);
+      out.setPDG(0);
+    }
+    JUG_DEBUG(jets.size() << " jets of " << inputs.size() << " particles");
+    return StatusCode::SUCCESS;
+  }
+};
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(JetReco)
+
+} // namespace Jug::Reco
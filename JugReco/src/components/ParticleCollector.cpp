@@ -8,6 +8,8 @@
 #include "GaudiAlg/Transformer.h"
 
 #include "JugBase/DataHandle.h"
+#include "JugBase/DataHandleArray.h"
+#include "JugBase/Logging.h"
 
 // Event Model related classes
 #include "eicd/ReconstructedParticleCollection.h"
@@ -19,48 +21,55 @@ namespace Jug::Reco {
  * \param inputParticles [in] vector of collection names
  * \param outputParticles [out] all particles into one collection.
  *
+ * With subsetCollection, the output is a subset collection referencing the input particles
+ * instead of copies (the particles keep the object IDs of their input collection).
+ *
  * \ingroup reco
  */
 class ParticleCollector : public GaudiAlgorithm {
 private:
-  Gaudi::Property<std::vector<std::string>> m_inputParticles{this, "inputParticles", {}, "Particles to be aggregated"};
+  Jug::Base::DataHandleArray<eicd::ReconstructedParticleCollection> m_particleCollections{this, "inputParticles",
+                                                                                         "Particles to be aggregated"};
   DataHandle<eicd::ReconstructedParticleCollection> m_outputParticles{"outputParticles", Gaudi::DataHandle::Writer,
                                                                      this};
-
-  std::vector<DataHandle<eicd::ReconstructedParticleCollection>*> m_particleCollections;
+  Gaudi::Property<bool> m_subsetCollection{this, "subsetCollection", false,
+                                           "Reference the input particles instead of copying them"};
 
 public:
   ParticleCollector(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
     declareProperty("outputParticles", m_outputParticles, "output particles combined into single collection");
   }
-  ~ParticleCollector() {
-    for (auto* col : m_particleCollections) {
-      delete col;
-    }
-  }
 
   StatusCode initialize() override {
     if (GaudiAlgorithm::initialize().isFailure()) {
       return StatusCode::FAILURE;
     }
-    for (auto colname : m_inputParticles) {
-      debug() << "initializing collection: " << colname << endmsg;
-      m_particleCollections.push_back(
-          new DataHandle<eicd::ReconstructedParticleCollection>{colname, Gaudi::DataHandle::Reader, this});
+    for (const auto& colname : m_particleCollections.keys()) {
+      JUG_DEBUG("initializing collection: " << colname);
     }
     return StatusCode::SUCCESS;
   }
 
   StatusCode execute() override {
-    auto* output = m_outputParticles.createAndPut();
+    const auto& collections = m_particleCollections.get();
+    auto* output            = m_outputParticles.createAndPut(m_particleCollections.totalSize());
+    if (m_subsetCollection.value()) {
+      output->setSubsetCollection();
+    }
     if (msgLevel(MSG::DEBUG)) {
       debug() << "execute collector" << endmsg;
     }
-    for (const auto& list : m_particleCollections) {
-      const auto& parts = *(list->get());
+    for (const auto* collection : collections) {
+      const auto& parts = *collection;
       if (msgLevel(MSG::DEBUG)) {
         debug() << "col n particles: " << parts.size() << endmsg;
       }
+      if (m_subsetCollection.value()) {
+        for (const auto& part : parts) {
+          output->push_back(part);
+        }
+        continue;
+      }
       for (const auto& part : parts) {
         output->push_back(part.clone());
       }
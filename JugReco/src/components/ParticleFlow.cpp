@@ -0,0 +1,241 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+// Gaudi
+#include "Gaudi/Property.h"
+#include "GaudiAlg/GaudiAlgorithm.h"
+
+#include "JugBase/DataHandle.h"
+#include "JugBase/DataHandleArray.h"
+#include "JugBase/Utilities/SpatialIndex.h"
+
+// Event Model related classes
+#include "eicd/ClusterCollection.h"
+#include "eicd/ReconstructedParticleCollection.h"
+#include "eicd/TrackSegmentCollection.h"
+#include "eicd/vector_utils.h"
+
+namespace Jug::Reco {
+
+/** Particle flow of the charged particles and the calorimeter clusters.
+ *
+ *  The charged particles (ParticlesFromTrackFit) are linked to the ECal and HCal clusters
+ *  (ClusterRecoCoG, ImagingClusterReco) near their projections to the calorimeter faces
+ *  (TrackSurfaceProjector, one track segment per particle in particle order): the clusters are
+ *  indexed by (eta, phi) cell, and every track point links the clusters within linkDeltaR. The
+ *  expected energy of every track (pion mass hypothesis) is then subtracted from its linked
+ *  clusters, the closest first and the ECal before the HCal, the tracks in decreasing momentum.
+ *  The clusters that keep more than nSigma times their resolution (stochastic term times
+ *  sqrt(E)) of their energy give neutrals of the remaining energy: photons for the ECal and
+ *  unidentified neutral hadrons (PDG 0) for the HCal. A cluster is added to the first charged
+ *  particle that subtracts from it.
+ *
+ *  The clusters and the links are structure of arrays, the link finding is linear in the track
+ *  points and the clusters at a given occupancy.
+ *
+ * \ingroup reco
+ */
+class ParticleFlow : public GaudiAlgorithm {
+private:
+  using ClusterHandles = Jug::Base::DataHandleArray<eicd::ClusterCollection>;
+
+  // Input
+  DataHandle<eicd::ReconstructedParticleCollection> m_inputParticles{"inputParticles", Gaudi::DataHandle::Reader,
+                                                                    this};
+  DataHandle<eicd::TrackSegmentCollection> m_inputTrackSegments{"inputTrackSegments", Gaudi::DataHandle::Reader,
+                                                                this};
+  ClusterHandles m_inputEcalClusters{this, "inputEcalClusters", "ECal clusters"};
+  ClusterHandles m_inputHcalClusters{this, "inputHcalClusters", "HCal clusters"};
+  // Output
+  DataHandle<eicd::ReconstructedParticleCollection> m_outputParticles{"outputParticles", Gaudi::DataHandle::Writer,
+                                                                     this};
+
+  Gaudi::Property<double> m_linkDeltaR{this, "linkDeltaR", 0.1, "Largest (eta, phi) distance of a linked cluster"};
+  Gaudi::Property<double> m_ecalResolution{this, "ecalResolution", 0.1, "ECal stochastic term (sqrt(GeV))"};
+  Gaudi::Property<double> m_hcalResolution{this, "hcalResolution", 0.5, "HCal stochastic term (sqrt(GeV))"};
+  Gaudi::Property<double> m_nSigma{this, "nSigma", 1.0, "Remaining energy of a neutral, in cluster resolutions"};
+  Gaudi::Property<double> m_chargedMass{this, "chargedMass", 0.13957018, "Mass hypothesis of the tracks (GeV)"};
+
+  /// The clusters of the event, ECal first
+  struct Clusters {
+    std::vector<double> eta;
+    std::vector<double> phi;
+    std::vector<double> energy;
+    std::vector<double> remaining;
+    std::vector<char> hcal;
+    std::vector<eicd::Cluster> cluster;
+
+    size_t size() const { return energy.size(); }
+  };
+
+  struct Link {
+    uint32_t track;
+    // ECal before HCal, then by distance
+    char hcal;
+    double dr2;
+    uint32_t cluster;
+  };
+
+public:
+  ParticleFlow(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
+    declareProperty("inputParticles", m_inputParticles, "Charged particles");
+    declareProperty("inputTrackSegments", m_inputTrackSegments, "Track projections to the calorimeters");
+    declareProperty("outputParticles", m_outputParticles, "");
+  }
+
+  StatusCode initialize() override {
+    if (GaudiAlgorithm::initialize().isFailure()) {
+      return StatusCode::FAILURE;
+    }
+    if (m_linkDeltaR.value() <= 0.) {
+      error() << "linkDeltaR must be positive" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    return StatusCode::SUCCESS;
+  }
+
+  StatusCode execute() override {
+    // input
+    const auto& inparts  = *(m_inputParticles.get());
+    const auto& segments = *(m_inputTrackSegments.get());
+    // output
+    auto& outparts = *(m_outputParticles.createAndPut());
+
+    Clusters clusters;
+    for (const auto* collection : m_inputEcalClusters.get()) {
+      addClusters(*collection, false, clusters);
+    }
+    for (const auto* collection : m_inputHcalClusters.get()) {
+      addClusters(*collection, true, clusters);
+    }
+    const size_t nclusters = clusters.size();
+
+    std::vector<eicd::MutableReconstructedParticle> charged;
+    charged.reserve(inparts.size());
+    for (const auto& inpart : inparts) {
+      charged.push_back(inpart.clone());
+      outparts.push_back(charged.back());
+    }
+    const bool paired = (segments.size() == inparts.size());
+    if (!paired) {
+      warning() << segments.size() << " track segments for " << inparts.size()
+                << " particles, the tracks are not linked" << endmsg;
+    }
+
+    // links of the track points to the clusters, by track then ECal first and closest first
+    const double linkDeltaR = m_linkDeltaR.value();
+    Jug::Base::SpatialPoints<2> points{{clusters.eta.data(), clusters.phi.data()}, nclusters, {0., 2 * M_PI}};
+    Jug::Base::CellList<2> index;
+    index.build(points, {linkDeltaR, linkDeltaR});
+    std::vector<Link> links;
+    for (uint32_t t = 0; paired && t < segments.size(); ++t) {
+      const auto segment = segments[t];
+      for (unsigned int k = 0; k < segment.points_size(); ++k) {
+        const auto position = segment.getPoints(k).position;
+        const std::array<double, 2> point{etaOf(position), std::atan2(position.y, position.x)};
+        index.forEachWithin(point, linkDeltaR,
+                            [&](uint32_t i, double d2) { links.push_back({t, clusters.hcal[i], d2, i}); });
+      }
+    }
+    std::sort(links.begin(), links.end(), [](const Link& a, const Link& b) {
+      return std::tie(a.track, a.hcal, a.dr2, a.cluster) < std::tie(b.track, b.hcal, b.dr2, b.cluster);
+    });
+    // the links of track t are [linkBegin[t], linkBegin[t + 1])
+    std::vector<uint32_t> linkBegin(charged.size() + 1, 0);
+    for (const auto& link : links) {
+      ++linkBegin[link.track + 1];
+    }
+    for (size_t t = 0; t < charged.size(); ++t) {
+      linkBegin[t + 1] += linkBegin[t];
+    }
+
+    // energy subtraction, the tracks of highest momentum first
+    std::vector<uint32_t> order(charged.size());
+    for (uint32_t t = 0; t < order.size(); ++t) {
+      order[t] = t;
+    }
+    std::vector<double> momentum(charged.size());
+    for (size_t t = 0; t < charged.size(); ++t) {
+      momentum[t] = eicd::magnitude(charged[t].getMomentum());
+    }
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return momentum[a] > momentum[b]; });
+    std::vector<char> used(nclusters, 0);
+    const double mass2 = m_chargedMass.value() * m_chargedMass.value();
+    for (const uint32_t t : order) {
+      double expected = std::sqrt(momentum[t] * momentum[t] + mass2);
+      for (uint32_t l = linkBegin[t]; l < linkBegin[t + 1] && expected > 0.; ++l) {
+        const uint32_t i = links[l].cluster;
+        if (clusters.remaining[i] <= 0.) {
+          continue;
+        }
+        const double subtracted = std::min(expected, clusters.remaining[i]);
+        clusters.remaining[i] -= subtracted;
+        expected -= subtracted;
+        if (used[i] == 0) {
+          charged[t].addToClusters(clusters.cluster[i]);
+          used[i] = 1;
+        }
+      }
+    }
+
+    // neutrals of the remaining energy
+    size_t nneutral = 0;
+    for (size_t i = 0; i < nclusters; ++i) {
+      const double resolution = (clusters.hcal[i] != 0) ? m_hcalResolution.value() : m_ecalResolution.value();
+      const double sigma      = resolution * std::sqrt(std::max(clusters.energy[i], 0.));
+      if (clusters.remaining[i] <= m_nSigma.value() * sigma || clusters.remaining[i] <= 0.) {
+        continue;
+      }
+      outparts.push_back(neutral(clusters.cluster[i], clusters.remaining[i], (clusters.hcal[i] != 0) ? 0 : 22));
+      ++nneutral;
+    }
+
+    if (msgLevel(MSG::DEBUG)) {
+      debug() << charged.size() << " charged particles with " << links.size() << " links to " << nclusters
+              << " clusters, " << nneutral << " neutrals" << endmsg;
+    }
+    return StatusCode::SUCCESS;
+  }
+
+private:
+  template <typename Vector> static double etaOf(const Vector& position) {
+    return std::asinh(position.z / std::hypot(position.x, position.y));
+  }
+
+  static void addClusters(const eicd::ClusterCollection& collection, bool hcal, Clusters& clusters) {
+    for (const auto& cluster : collection) {
+      const auto position = cluster.getPosition();
+      clusters.eta.push_back(etaOf(position));
+      clusters.phi.push_back(std::atan2(position.y, position.x));
+      clusters.energy.push_back(cluster.getEnergy());
+      clusters.remaining.push_back(cluster.getEnergy());
+      clusters.hcal.push_back(hcal ? 1 : 0);
+      clusters.cluster.push_back(cluster);
+    }
+  }
+
+  // massless neutral of the energy in the direction of the cluster, from the origin
+  static eicd::MutableReconstructedParticle neutral(const eicd::Cluster& cluster, double energy, int32_t pdg) {
+    const auto position = cluster.getPosition();
+    eicd::MutableReconstructedParticle part;
+    part.setMomentum(static_cast<float>(energy) * (position / eicd::magnitude(position)));
+    part.setPDG(pdg);
+    part.setCharge(0);
+    part.setEnergy(static_cast<float>(energy));
+    part.setMass(0);
+    part.addToClusters(cluster);
+    return part;
+  }
+};
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(ParticleFlow)
+
+} // namespace Jug::Reco
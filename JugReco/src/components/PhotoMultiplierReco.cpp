@@ -11,21 +11,23 @@
  */
 
 #include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include "fmt/format.h"
 
 #include "Gaudi/Property.h"
 #include "GaudiAlg/GaudiAlgorithm.h"
-#include "GaudiAlg/GaudiTool.h"
-#include "GaudiAlg/Transformer.h"
 #include "GaudiKernel/PhysicalConstants.h"
-#include "GaudiKernel/RndmGenerators.h"
-#include "GaudiKernel/ToolHandle.h"
 
-#include "DDRec/CellIDPositionConverter.h"
-#include "DDRec/Surface.h"
-#include "DDRec/SurfaceManager.h"
+#include "DD4hep/DD4hepUnits.h"
 
 #include "JugBase/DataHandle.h"
-#include "JugBase/IGeoSvc.h"
+#include "JugBase/ICalibrationSvc.h"
+#include "JugBase/ICellGeometrySvc.h"
+#include "JugBase/Utilities/FlatIndexMap.h"
 
 // Event Model related classes
 #include "eicd/PMTHitCollection.h"
@@ -40,6 +42,17 @@ namespace Jug::Reco {
  *  Estimate the number of photo-electrons and convert getTimeStamp to time
  *  Collect cell information
  *
+ *  The pedestal and single photo-electron mean of a pixel are those of calibrationFile if listed
+ *  there (lines of "cellID pedestal speMean", # for comments), pedMean and speMean otherwise.
+ *  They are kept in a table indexed by cellID, with the inverse of speMean, and the positions,
+ *  dimensions and sectors of the pixels are read from the cell geometry table of the readout
+ *  (CellGeometrySvc), so that the hits are converted in array loops without branches or geometry
+ *  lookups; the geometry is looked up once for the hits above minNpe.
+ *
+ *  With calibration, the pedMean and speMean constants of the pixels are those of the calibration
+ *  (CalibrationSvc) for the run instead, dense by channel, with pedMean and speMean for the pixels
+ *  and constants not in the calibration.
+ *
  * \ingroup reco
  */
 class PhotoMultiplierReco : public GaudiAlgorithm {
@@ -50,8 +63,43 @@ private:
   Gaudi::Property<double> m_minNpe{this, "minNpe", 0.0};
   Gaudi::Property<double> m_speMean{this, "speMean", 80.0};
   Gaudi::Property<double> m_pedMean{this, "pedMean", 200.0};
-  /// Pointer to the geometry service
-  SmartIF<IGeoSvc> m_geoSvc;
+  Gaudi::Property<std::string> m_calibrationFile{this, "calibrationFile", ""};
+  Gaudi::Property<double> m_lUnit{this, "lengthUnit", dd4hep::mm};
+
+  // cell geometry, the local frame as in CalorimeterHitReco
+  Gaudi::Property<std::string> m_cellGeoSvcName{this, "cellGeometryServiceName", "CellGeometrySvc"};
+  Gaudi::Property<std::string> m_readout{this, "readoutClass", ""};
+  Gaudi::Property<std::string> m_sectorField{this, "sectorField", ""};
+  Gaudi::Property<std::string> m_localDetElement{this, "localDetElement", ""};
+  Gaudi::Property<std::vector<std::string>> u_localDetFields{this, "localDetFields", {}};
+  SmartIF<ICellGeometrySvc> m_cellGeoSvc;
+  const Jug::Base::CellGeometryTable* m_cellGeometry{nullptr};
+
+  // per-channel constants for the run, instead of the calibration file
+  Gaudi::Property<std::string> m_calibSvcName{this, "calibrationServiceName", "CalibrationSvc"};
+  Gaudi::Property<std::string> m_calibrationName{this, "calibration", "", "Calibration of the pixels (optional)"};
+  SmartIF<ICalibrationSvc> m_calibSvc;
+  const Jug::Base::Calibration* m_calibration{nullptr};
+  int m_pedColumn{-1};
+  int m_speColumn{-1};
+
+  // calibration of the pixels, the first entry is the default one
+  Jug::Base::FlatIndexMap m_calibrationIndex;
+  std::vector<float> m_pedestals;
+  std::vector<float> m_invSpe;
+
+  // raw hits of the event and their conversion, kept to reuse their buffers
+  std::vector<uint64_t> m_cellIDs;
+  std::vector<float> m_integrals;
+  std::vector<float> m_timeStamps;
+  std::vector<uint32_t> m_slots;
+  std::vector<Jug::Base::Calibration::Channel> m_channels;
+  std::vector<float> m_hitPedestals;
+  std::vector<float> m_hitSpe;
+  std::vector<float> m_npe;
+  std::vector<uint32_t> m_selected;
+  std::vector<uint64_t> m_selectedIDs;
+  std::vector<const Jug::Base::CellGeometry*> m_geometries;
 
 public:
   // ill-formed: using GaudiAlgorithm::GaudiAlgorithm;
@@ -64,10 +112,41 @@ public:
     if (GaudiAlgorithm::initialize().isFailure()) {
       return StatusCode::FAILURE;
     }
-    m_geoSvc = service("GeoSvc");
-    if (!m_geoSvc) {
-      error() << "Unable to locate Geometry Service. "
-              << "Make sure you have GeoSvc and SimSvc in the right order in the configuration." << endmsg;
+    m_cellGeoSvc = service(m_cellGeoSvcName);
+    if (!m_cellGeoSvc) {
+      error() << "Unable to locate Cell Geometry Service " << m_cellGeoSvcName.value() << endmsg;
+      return StatusCode::FAILURE;
+    }
+    // local detector name has higher priority than the fields
+    m_cellGeometry = m_cellGeoSvc->geometryTable(
+        {m_readout.value(), m_localDetElement.value(),
+         m_localDetElement.value().empty() ? u_localDetFields.value() : std::vector<std::string>{}, "",
+         m_sectorField.value()});
+    if (m_cellGeometry == nullptr) {
+      error() << "Failed to set up the cell geometry of " << m_readout.value() << endmsg;
+      return StatusCode::FAILURE;
+    }
+
+    if (!(m_speMean.value() > 0.)) {
+      error() << "speMean has to be positive" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    m_pedestals = {static_cast<float>(m_pedMean.value())};
+    m_invSpe    = {static_cast<float>(1. / m_speMean.value())};
+    if (!m_calibrationName.value().empty()) {
+      m_calibSvc = service(m_calibSvcName);
+      if (!m_calibSvc) {
+        error() << "Unable to locate Calibration Service " << m_calibSvcName.value() << endmsg;
+        return StatusCode::FAILURE;
+      }
+      m_calibration = m_calibSvc->calibration(m_calibrationName.value());
+      if (m_calibration == nullptr) {
+        error() << "Failed to load the calibration " << m_calibrationName.value() << endmsg;
+        return StatusCode::FAILURE;
+      }
+      m_pedColumn = m_calibration->column("pedMean");
+      m_speColumn = m_calibration->column("speMean");
+    } else if (!m_calibrationFile.value().empty() && !readCalibration(m_calibrationFile.value())) {
       return StatusCode::FAILURE;
     }
     return StatusCode::SUCCESS;
@@ -77,34 +156,115 @@ public:
     // input collections
     const auto& rawhits = *m_inputHitCollection.get();
     // Create output collections
-    auto& hits = *m_outputHitCollection.createAndPut();
-
-    // reconstruct number of photo-electrons and time
-    for (const auto& rh : rawhits) {
-      float npe = (rh.getIntegral() - m_pedMean) / m_speMean;
-      if (npe >= m_minNpe) {
-        float time = rh.getTimeStamp() * (static_cast<float>(m_timeStep) / ns);
-        auto id    = rh.getCellID();
-        // global positions
-        auto gpos = m_geoSvc->cellIDPositionConverter()->position(id);
-        // local positions
-        auto pos = m_geoSvc->cellIDPositionConverter()->findContext(id)->volumePlacement().position();
-        // cell dimension
-        auto dim = m_geoSvc->cellIDPositionConverter()->cellDimensions(id);
-        hits.push_back(eicd::PMTHit{
-            rh.getCellID(),
-            npe,
-            time,
-            static_cast<float>(m_timeStep / ns),
-            {static_cast<float>(gpos.x()), static_cast<float>(gpos.y()), static_cast<float>(gpos.z())},
-            {static_cast<float>(dim[0] / mm), static_cast<float>(dim[1] / mm), static_cast<float>(dim[2] / mm)},
-            0, // @FIXME: Add sector similar to CalorimeterHit
-            {static_cast<float>(pos.x()), static_cast<float>(pos.y()), static_cast<float>(pos.z())}});
+    auto& hits = *m_outputHitCollection.createAndPut(rawhits.size());
+
+    const size_t n = rawhits.size();
+    m_cellIDs.resize(n);
+    m_integrals.resize(n);
+    m_timeStamps.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+      const auto rh   = rawhits[i];
+      m_cellIDs[i]    = rh.getCellID();
+      m_integrals[i]  = static_cast<float>(rh.getIntegral());
+      m_timeStamps[i] = static_cast<float>(rh.getTimeStamp());
+    }
+    // reconstruct number of photo-electrons
+    m_npe.resize(n);
+    const auto* table = (m_calibration != nullptr) ? m_calibration->table(m_calibSvc->run()) : nullptr;
+    if (table != nullptr) {
+      m_calibration->channels(m_cellIDs, m_channels);
+      table->values(m_pedColumn, m_channels, m_pedMean.value(), m_hitPedestals);
+      table->values(m_speColumn, m_channels, m_speMean.value(), m_hitSpe);
+      for (size_t i = 0; i < n; ++i) {
+        m_npe[i] = (m_integrals[i] - m_hitPedestals[i]) / m_hitSpe[i];
+      }
+    } else {
+      // calibration slots, the default one for the pixels without calibration
+      m_slots.assign(n, 0);
+      if (m_calibrationIndex.size() > 0) {
+        for (size_t i = 0; i < n; ++i) {
+          const auto index = m_calibrationIndex.find(m_cellIDs[i]);
+          m_slots[i]       = (index == Jug::Base::FlatIndexMap::kEmpty) ? 0 : index;
+        }
+      }
+      for (size_t i = 0; i < n; ++i) {
+        const auto slot = m_slots[i];
+        m_npe[i]        = (m_integrals[i] - m_pedestals[slot]) * m_invSpe[slot];
       }
     }
 
+    // select the hits above minNpe
+    m_selected.resize(n);
+    const float minNpe = m_minNpe.value();
+    size_t nselected   = 0;
+    for (size_t i = 0; i < n; ++i) {
+      m_selected[nselected] = i;
+      nselected += static_cast<size_t>(m_npe[i] >= minNpe);
+    }
+
+    m_selectedIDs.resize(nselected);
+    for (size_t k = 0; k < nselected; ++k) {
+      m_selectedIDs[k] = m_cellIDs[m_selected[k]];
+    }
+    m_cellGeometry->geometry(m_selectedIDs, m_geometries);
+
+    const float timeStep = static_cast<float>(m_timeStep / ns);
+    for (size_t k = 0; k < nselected; ++k) {
+      const auto i    = m_selected[k];
+      const auto& geo = *m_geometries[k];
+      hits.push_back(eicd::PMTHit{
+          m_cellIDs[i],
+          m_npe[i],
+          m_timeStamps[i] * timeStep,
+          timeStep,
+          {static_cast<float>(geo.global.x() / m_lUnit), static_cast<float>(geo.global.y() / m_lUnit),
+           static_cast<float>(geo.global.z() / m_lUnit)},
+          {static_cast<float>(geo.dimension[0] / m_lUnit), static_cast<float>(geo.dimension[1] / m_lUnit),
+           static_cast<float>(geo.dimension[2] / m_lUnit)},
+          static_cast<uint32_t>(std::max(geo.sector, 0)),
+          {static_cast<float>(geo.local.x() / m_lUnit), static_cast<float>(geo.local.y() / m_lUnit),
+           static_cast<float>(geo.local.z() / m_lUnit)}});
+    }
+
     return StatusCode::SUCCESS;
   }
+
+private:
+  // pixel pedestals and single photo-electron means, after the default one
+  bool readCalibration(const std::string& filename) {
+    std::ifstream is(filename);
+    if (!is) {
+      error() << "Cannot open the calibration file " << filename << endmsg;
+      return false;
+    }
+    std::string line;
+    for (size_t lineNumber = 1; std::getline(is, line); ++lineNumber) {
+      line = line.substr(0, line.find('#'));
+      if (line.find_first_not_of(" \t\r") == std::string::npos) {
+        continue;
+      }
+      std::istringstream fields(line);
+      uint64_t cellID = 0;
+      double pedestal = 0.;
+      double spe      = 0.;
+      if (!(fields >> cellID >> pedestal >> spe) || !(spe > 0.)) {
+        error() << fmt::format("Invalid calibration in {} line {}: {}", filename, lineNumber, line) << endmsg;
+        return false;
+      }
+      const auto [slot, inserted] = m_calibrationIndex.emplace(cellID, m_pedestals.size());
+      if (!inserted) {
+        warning() << fmt::format("Pixel {:#x} calibrated again in {} line {}", cellID, filename, lineNumber)
+                  << endmsg;
+        m_pedestals[slot] = pedestal;
+        m_invSpe[slot]    = 1. / spe;
+        continue;
+      }
+      m_pedestals.push_back(pedestal);
+      m_invSpe.push_back(1. / spe);
+    }
+    info() << fmt::format("Calibration of {} pixels from {}", m_calibrationIndex.size(), filename) << endmsg;
+    return true;
+  }
 };
 
 // NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
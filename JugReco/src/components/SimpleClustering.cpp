@@ -2,6 +2,9 @@
 // Copyright (C) 2022 Whitney Armstrong, Sylvester Joosten, Wouter Deconinck, Chao Peng
 
 #include <algorithm>
+#include <array>
+#include <numeric>
+#include <vector>
 
 #include "Gaudi/Property.h"
 #include "GaudiAlg/GaudiAlgorithm.h"
@@ -17,6 +20,8 @@
 
 #include "JugBase/DataHandle.h"
 #include "JugBase/IGeoSvc.h"
+#include "JugBase/Utilities/SpatialIndex.h"
+#include "JugReco/CalorimeterHitCache.h"
 
 // Event Model related classes
 #include "edm4hep/SimCalorimeterHitCollection.h"
@@ -31,6 +36,11 @@ using namespace Gaudi::Units;
 namespace Jug::Reco {
 
   /** Simple clustering algorithm.
+   *
+   * The highest energy hit that is not clustered yet seeds a cluster of the unclustered hits
+   * within maxDistance of it, until the seed is below minModuleEdep, maxClusters clusters are
+   * found or at most 5 hits are left. The hits are sorted by energy once and found with a cell
+   * list of maxDistance.
    *
    * \ingroup reco
    */
@@ -48,6 +58,7 @@ namespace Jug::Reco {
 
     Gaudi::Property<double>   m_minModuleEdep{this, "minModuleEdep", 5.0 * MeV};
     Gaudi::Property<double>   m_maxDistance{this, "maxDistance", 20.0 * cm};
+    Gaudi::Property<size_t>   m_maxClusters{this, "maxClusters", 10};
 
     /// Pointer to the geometry service
     SmartIF<IGeoSvc> m_geoSvc;
@@ -55,11 +66,18 @@ namespace Jug::Reco {
     // Optional handle to MC hits
     std::unique_ptr<DataHandle<edm4hep::SimCalorimeterHitCollection>> m_inputMC;
 
+    // hits of the event, kept to reuse their buffers
+    CalorimeterHitCache m_cache;
+    Jug::Base::CellList<3, float> m_cells;
+    std::vector<uint32_t> m_byEnergy;
+    std::vector<char> m_clustered;
+    std::vector<uint32_t> m_clusterHits;
+
   public:
     SimpleClustering(const std::string& name, ISvcLocator* svcLoc) 
       : GaudiAlgorithm(name, svcLoc) {
       declareProperty("inputHitCollection", m_inputHitCollection, "");
-      declareProperty("outputProtoClusterCollection", m_outputClusters, "Output proto clusters");
+      declareProperty("outputProtoClusterCollection", m_outputProtoClusters, "Output proto clusters");
       declareProperty("outputClusterCollection", m_outputClusters, "Output clusters");
     }
 
@@ -97,55 +115,58 @@ namespace Jug::Reco {
       //  mcHits = m_inputMC->get();
       //}
 
-      std::vector<std::pair<uint32_t, eicd::CalorimeterHit>> the_hits;
-      std::vector<std::pair<uint32_t, eicd::CalorimeterHit>> remaining_hits;
-
-      double max_dist   = m_maxDistance.value() / mm;
-      double min_energy = m_minModuleEdep.value() / GeV;
-
-      eicd::CalorimeterHit ref_hit;
-      bool have_ref = false;
-      // Collect all our hits, and get the highest energy hit
-      {
-        uint32_t idx  = 0;
-        for (const auto& h : hits) {
-          if (!have_ref || h.getEnergy() > ref_hit.getEnergy()) {
-            ref_hit  = h;
-            have_ref = true;
-          }
-          the_hits.emplace_back(idx, h);
-          idx += 1;
-        }
-      }
+      const double max_dist   = m_maxDistance.value() / mm;
+      const double min_energy = m_minModuleEdep.value() / GeV;
+
+      // hits in decreasing energy, the first one for equal energies
+      m_cache.fill(hits);
+      const size_t n = m_cache.size();
+      m_byEnergy.resize(n);
+      std::iota(m_byEnergy.begin(), m_byEnergy.end(), 0);
+      std::stable_sort(m_byEnergy.begin(), m_byEnergy.end(),
+                       [this](uint32_t a, uint32_t b) { return m_cache.energy[a] > m_cache.energy[b]; });
+      m_clustered.assign(n, 0);
+      m_cells.build({{m_cache.x.data(), m_cache.y.data(), m_cache.z.data()}, n, {}}, {max_dist, max_dist, max_dist});
 
       if (msgLevel(MSG::DEBUG)) {
         debug() << " max_dist = " << max_dist << endmsg;
       }
 
-      while (have_ref && ref_hit.getEnergy() > min_energy) {
-
-        std::vector<std::pair<uint32_t, eicd::CalorimeterHit>> cluster_hits;
+      size_t remaining = n;
+      for (size_t k = 0; k < n && remaining > 0; ++k) {
+        const auto ref = m_byEnergy[k];
+        if (m_clustered[ref] != 0) {
+          continue;
+        }
+        if (!(m_cache.energy[ref] > min_energy)) {
+          break;
+        }
 
-        for (const auto& [idx, h] : the_hits) {
-          if (eicd::magnitude(h.getPosition() - ref_hit.getPosition()) < max_dist) {
-            cluster_hits.emplace_back(idx, h);
-          } else {
-            remaining_hits.emplace_back(idx, h);
+        // unclustered hits within max_dist, in input order
+        m_clusterHits.clear();
+        const std::array<double, 3> position{m_cache.x[ref], m_cache.y[ref], m_cache.z[ref]};
+        m_cells.forEachWithin(position, max_dist, [&](uint32_t i, double d2) {
+          if (m_clustered[i] == 0 && d2 < max_dist * max_dist) {
+            m_clusterHits.push_back(i);
           }
+        });
+        std::sort(m_clusterHits.begin(), m_clusterHits.end());
+        double total_energy = 0.;
+        for (const auto i : m_clusterHits) {
+          total_energy += m_cache.energy[i];
+          m_clustered[i] = 1;
         }
-
-        double total_energy = std::accumulate(
-            std::begin(cluster_hits), std::end(cluster_hits), 0.0,
-            [](double t, const std::pair<uint32_t, eicd::CalorimeterHit>& h1) { return (t + h1.second.getEnergy()); });
+        remaining -= m_clusterHits.size();
 
         if (msgLevel(MSG::DEBUG)) {
           debug() << " total_energy = " << total_energy << endmsg;
-          debug() << " cluster size " << cluster_hits.size() << endmsg;
+          debug() << " cluster size " << m_clusterHits.size() << endmsg;
         }
         auto cl = clusters.create();
-        cl.setNhits(cluster_hits.size());
+        cl.setNhits(m_clusterHits.size());
         auto pcl = proto.create();
-        for (const auto& [idx, h] : cluster_hits) {
+        for (const auto i : m_clusterHits) {
+          const auto h = hits[i];
           cl.setEnergy(cl.getEnergy() + h.getEnergy());
           cl.setPosition(cl.getPosition() + (h.getPosition() * h.getEnergy() / total_energy));
           pcl.addToHits(h);
@@ -158,17 +179,8 @@ namespace Jug::Reco {
         //  cl.mcID({mc_hit.truth().trackID, m_kMonteCarloSource});
         //}
 
-        have_ref = false;
-        if ((remaining_hits.size() > 5) && (clusters.size() < 10)) {
-          for (const auto& [idx, h] : remaining_hits) {
-            if (!have_ref || h.getEnergy() > ref_hit.getEnergy()) {
-              ref_hit  = h;
-              have_ref = true;
-            }
-          }
-
-          std::swap(remaining_hits, the_hits);
-          remaining_hits.clear();
+        if ((remaining <= 5) || (clusters.size() >= m_maxClusters.value())) {
+          break;
         }
       }
       if (msgLevel(MSG::DEBUG)) {
@@ -2,6 +2,7 @@
 // Copyright (C) 2022 Whitney Armstrong, Sylvester Joosten, Wouter Deconinck
 
 #include <algorithm>
+#include <unordered_map>
 
 // Gaudi
 #include "GaudiAlg/GaudiAlgorithm.h"
@@ -12,12 +13,15 @@
 #include "GaudiKernel/RndmGenerators.h"
 
 #include "DD4hep/DD4hepUnits.h"
+#include "DD4hep/Detector.h"
+#include "DD4hep/Readout.h"
 #include "DDRec/CellIDPositionConverter.h"
 #include "DDRec/Surface.h"
 #include "DDRec/SurfaceManager.h"
 
 #include "JugBase/DataHandle.h"
 #include "JugBase/IGeoSvc.h"
+#include "JugBase/Logging.h"
 
 // Event Model related classes
 //#include "GaudiExamples/MyTrack.h"
@@ -40,6 +44,11 @@ inline double get_variance(const double pixel_size) {
 namespace Jug::Reco {
 
   /** Tracker hit reconstruction.
+   *
+   *  With cacheGeometry, the geometry lookups are cached across events: the position of every
+   *  cell, and the pitch variances of every sensor (the cellIDs with the same volume fields of
+   *  readoutClass, the pixels of a sensor all have the same pitch). Each one is looked up in
+   *  DD4hep once, on its first hit.
    *
    * \ingroup reco
    */
@@ -54,6 +63,13 @@ namespace Jug::Reco {
     /// Pointer to the geometry service
     SmartIF<IGeoSvc> m_geoSvc;
 
+    /// Geometry caches, the sensor of a cellID is its volume ID in the readout
+    Gaudi::Property<bool> m_cacheGeometry{this, "cacheGeometry", false, "Cache the cell positions and sensor pitches"};
+    Gaudi::Property<std::string> m_readout{this, "readoutClass", "", "Readout of the hits, for cacheGeometry"};
+    uint64_t m_sensorMask{0};
+    std::unordered_map<uint64_t, eicd::Vector3f> m_cellPositions;
+    std::unordered_map<uint64_t, eicd::Cov3f> m_sensorVariances;
+
   public:
     //  ill-formed: using GaudiAlgorithm::GaudiAlgorithm;
     TrackerHitReconstruction(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
@@ -71,6 +87,20 @@ namespace Jug::Reco {
                 << "Make sure you have GeoSvc and SimSvc in the right order in the configuration." << endmsg;
         return StatusCode::FAILURE;
       }
+      if (m_cacheGeometry) {
+        if (m_readout.value().empty()) {
+          error() << "readoutClass is not provided, it is needed to know the sensors of the cellIDs" << endmsg;
+          return StatusCode::FAILURE;
+        }
+        try {
+          // the volume ID zeroes the segmentation fields, that of all ones is the mask of the volume fields
+          const auto segmentation = m_geoSvc->detector()->readout(m_readout.value()).segmentation();
+          m_sensorMask            = segmentation.segmentation()->volumeID(~uint64_t{0});
+        } catch (...) {
+          error() << "Failed to load the segmentation of " << m_readout.value() << endmsg;
+          return StatusCode::FAILURE;
+        }
+      }
       return StatusCode::SUCCESS;
     }
 
@@ -79,9 +109,21 @@ namespace Jug::Reco {
       // input collection
       const auto* const rawhits = m_inputHitCollection.get();
       // Create output collections
-      auto* rec_hits = m_outputHitCollection.createAndPut();
-
-      debug() << " raw hits size : " << std::size(*rawhits) << endmsg;
+      auto* rec_hits = m_outputHitCollection.createAndPut(rawhits->size());
+
+      JUG_DEBUG(" raw hits size : " << std::size(*rawhits));
+      if (m_cacheGeometry) {
+        for (const auto& ahit : *rawhits) {
+          rec_hits->push_back(eicd::TrackerHit{ahit.getCellID(),
+                                               cellPosition(ahit.getCellID()),
+                                               sensorVariance(ahit.getCellID()),
+                                               static_cast<float>(ahit.getTimeStamp() / 1000), // ns
+                                               m_timeResolution,                               // in ns
+                                               static_cast<float>(ahit.getCharge() / 1.0e6),   // GeV
+                                               0.0F});
+        }
+        return StatusCode::SUCCESS;
+      }
       for (const auto& ahit : *rawhits) {
         // debug() << "cell ID : " << ahit.cellID() << endmsg;
         auto pos = m_geoSvc->cellIDPositionConverter()->position(ahit.getCellID());
@@ -119,6 +161,35 @@ namespace Jug::Reco {
       }
       return StatusCode::SUCCESS;
     }
+
+  private:
+    /// Position of the cell (mm), looked up on its first hit
+    const eicd::Vector3f& cellPosition(uint64_t cellID) {
+      auto it = m_cellPositions.find(cellID);
+      if (it == m_cellPositions.end()) {
+        constexpr auto mm = dd4hep::mm;
+        const auto pos    = m_geoSvc->cellIDPositionConverter()->position(cellID);
+        const eicd::Vector3f position{static_cast<float>(pos.x() / mm), static_cast<float>(pos.y() / mm),
+                                      static_cast<float>(pos.z() / mm)};
+        it = m_cellPositions.emplace(cellID, position).first;
+      }
+      return it->second;
+    }
+
+    /// Pitch variances of the sensor of the cell (mm^2, see the note on the variance), looked up on its first hit
+    const eicd::Cov3f& sensorVariance(uint64_t cellID) {
+      const uint64_t sensor = cellID & m_sensorMask;
+      auto it               = m_sensorVariances.find(sensor);
+      if (it == m_sensorVariances.end()) {
+        constexpr auto mm = dd4hep::mm;
+        const auto dim    = m_geoSvc->cellIDPositionConverter()->cellDimensions(cellID);
+        const eicd::Cov3f variance{static_cast<float>(get_variance(dim[0] / mm)),
+                                   static_cast<float>(get_variance(dim[1] / mm)),
+                                   std::size(dim) > 2 ? static_cast<float>(get_variance(dim[2] / mm)) : 0.F};
+        it = m_sensorVariances.emplace(sensor, variance).first;
+      }
+      return it->second;
+    }
   };
   // NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
   DECLARE_COMPONENT(TrackerHitReconstruction)
@@ -0,0 +1,251 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+/*
+ *  Connected-component clustering of the pixels of silicon tracker modules, between the
+ *  digitization and the TrackerSourceLinker: the adjacent fired pixels of a module (charge
+ *  sharing) give a single measurement, at their charge-weighted centroid.
+ */
+#include "fmt/format.h"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "Gaudi/Property.h"
+
+#include "DD4hep/DD4hepUnits.h"
+#include "DD4hep/Detector.h"
+#include "JugBase/CellIDDecoder.h"
+#include "JugBase/ICellGeometrySvc.h"
+#include "JugBase/IGeoSvc.h"
+#include "JugBase/Transformer.h"
+#include "JugBase/Utilities/FlatIndexMap.h"
+#include "JugBase/Utilities/UnionFind.h"
+
+// Event Model related classes
+#include "eicd/RawTrackerHitCollection.h"
+#include "eicd/TrackerHitCollection.h"
+
+namespace Jug::Reco {
+
+/** Tracker pixel clustering.
+ *
+ *  The fired pixels are joined with a union-find over the (module, row, column) grid of the
+ *  readout: pixels are neighbours if their cellIDs differ by one in the row and/or the column
+ *  field only, so that clusters never span modules. Each cluster is one TrackerHit, replacing
+ *  the TrackerHitReconstruction of each pixel:
+ *    - position: charge-weighted centroid of the pixel positions,
+ *    - variance: charge-weighted spread of the local pixel positions, plus the pitch^2/12 of
+ *      the pixels weighted by sum(q^2)/Q^2 (pitch^2/12 for a single pixel, as for the pixel hits),
+ *      in the segmentation coordinates expected by the TrackerSourceLinker,
+ *    - time: earliest pixel time, energy: summed charge,
+ *    - cellID: the pixel with the largest charge (same module and surface as all the pixels).
+ *
+ * \ingroup reco
+ */
+class TrackerPixelClustering : public Jug::Transformer<eicd::TrackerHitCollection, eicd::RawTrackerHitCollection> {
+private:
+  Gaudi::Property<float> m_timeResolution{this, "timeResolution", 10}; // in ns
+  // readout and the fields of the pixel grid within a module (all the other fields)
+  Gaudi::Property<std::string> m_readout{this, "readoutClass", ""};
+  Gaudi::Property<std::vector<std::string>> u_gridFields{this, "gridFields", {"x", "y"}};
+  // local axes (0: x, 1: y, 2: z) along the grid fields, for the variance in segmentation coordinates
+  Gaudi::Property<std::vector<int>> u_localAxes{this, "localAxes", {0, 1}};
+  // pixels touching by a corner are neighbours (8-connectivity), otherwise 4-connectivity
+  Gaudi::Property<bool> m_diagonalNeighbours{this, "diagonalNeighbours", true};
+
+  Gaudi::Property<std::string> m_geoSvcName{this, "geoServiceName", "GeoSvc"};
+  Gaudi::Property<std::string> m_cellGeoSvcName{this, "cellGeometryServiceName", "CellGeometrySvc"};
+  SmartIF<IGeoSvc> m_geoSvc;
+  SmartIF<ICellGeometrySvc> m_cellGeoSvc;
+  const Jug::Base::CellGeometryTable* m_cellGeometry{nullptr};
+
+  // grid fields of the cellIDs and their ranges
+  Jug::Base::CellIDField m_row, m_col;
+  int64_t m_rowMin{0}, m_rowMax{0}, m_colMin{0}, m_colMax{0};
+
+public:
+  TrackerPixelClustering(const std::string& name, ISvcLocator* svcLoc)
+      : MultiTransformer(name, svcLoc, {KeyValue{"inputHitCollection", "inputHitCollection"}},
+                         {KeyValue{"outputHitCollection", "outputHitCollection"}}) {}
+
+  StatusCode initialize() override {
+    if (Gaudi::Algorithm::initialize().isFailure()) {
+      return StatusCode::FAILURE;
+    }
+    m_geoSvc = service(m_geoSvcName);
+    if (!m_geoSvc) {
+      error() << "Unable to locate Geometry Service. "
+              << "Make sure you have GeoSvc and SimSvc in the right order in the configuration." << endmsg;
+      return StatusCode::FAILURE;
+    }
+    if (m_readout.value().empty()) {
+      error() << "readoutClass is not provided, it is needed to know the fields in readout ids" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    if (u_gridFields.size() != 2 || u_localAxes.size() != 2) {
+      error() << "Expected 2 values (row, column) for gridFields and localAxes" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    if (std::any_of(u_localAxes.begin(), u_localAxes.end(), [](int axis) { return axis < 0 || axis > 2; })) {
+      error() << "localAxes have to be 0 (x), 1 (y) or 2 (z)" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    try {
+      const auto decoder = Jug::Base::CellIDDecoder::readout(*m_geoSvc->detector(), m_readout);
+      m_row              = decoder->field(u_gridFields.value()[0]);
+      m_col              = decoder->field(u_gridFields.value()[1]);
+      m_rowMin           = m_row.minValue();
+      m_rowMax           = m_row.maxValue();
+      m_colMin           = m_col.minValue();
+      m_colMax           = m_col.maxValue();
+    } catch (...) {
+      error() << "Failed to load ID decoder for " << m_readout << endmsg;
+      return StatusCode::FAILURE;
+    }
+
+    // local frame of the sensor (the DetElement of the cellID), for the spread of the pixels
+    m_cellGeoSvc = service(m_cellGeoSvcName);
+    if (!m_cellGeoSvc) {
+      error() << "Unable to locate Cell Geometry Service " << m_cellGeoSvcName.value() << endmsg;
+      return StatusCode::FAILURE;
+    }
+    m_cellGeometry = m_cellGeoSvc->geometryTable({m_readout.value(), "", {}, "", ""});
+    if (m_cellGeometry == nullptr) {
+      error() << "Failed to set up the cell geometry of " << m_readout.value() << endmsg;
+      return StatusCode::FAILURE;
+    }
+    info() << fmt::format("Pixel clustering in {:s} over the fields ({:s}, {:s}), {:s} neighbours", m_readout.value(),
+                          u_gridFields.value()[0], u_gridFields.value()[1],
+                          m_diagonalNeighbours ? "8 (with diagonal)" : "4")
+           << endmsg;
+    return StatusCode::SUCCESS;
+  }
+
+  void operator()(const eicd::RawTrackerHitCollection& rawhits, eicd::TrackerHitCollection& hits) const override {
+    constexpr auto mm = dd4hep::mm;
+    const size_t n    = rawhits.size();
+
+    // pixel index of the cellIDs
+    Jug::Base::FlatIndexMap pixel_index(n);
+    std::vector<uint64_t> cellIDs(n);
+    for (size_t i = 0; i < n; ++i) {
+      cellIDs[i] = rawhits[i].getCellID();
+    }
+
+    // union-find, the root of a cluster is its first pixel
+    Jug::Base::UnionFind pixels;
+    pixels.reset(n);
+
+    // the neighbours preceding a pixel in the grid, the union with the others is made from them
+    std::vector<std::pair<int, int>> offsets{{-1, 0}, {0, -1}};
+    if (m_diagonalNeighbours) {
+      offsets.insert(offsets.end(), {{-1, -1}, {-1, 1}});
+    }
+    for (size_t i = 0; i < n; ++i) {
+      const auto [index, inserted] = pixel_index.emplace(cellIDs[i], static_cast<uint32_t>(i));
+      if (!inserted) {
+        // same pixel again, merged in its cluster
+        pixels.unite(index, static_cast<uint32_t>(i));
+      }
+    }
+    std::vector<int64_t> rows, cols;
+    Jug::Base::CellIDDecoder::values(m_row, cellIDs, rows);
+    Jug::Base::CellIDDecoder::values(m_col, cellIDs, cols);
+    for (size_t i = 0; i < n; ++i) {
+      const int64_t row = rows[i];
+      const int64_t col = cols[i];
+      for (const auto& [drow, dcol] : offsets) {
+        const int64_t nrow = row + drow;
+        const int64_t ncol = col + dcol;
+        if (nrow < m_rowMin || nrow > m_rowMax || ncol < m_colMin || ncol > m_colMax) {
+          continue;
+        }
+        const uint64_t neighbour = m_col.set(m_row.set(cellIDs[i], nrow), ncol);
+        const uint32_t j = pixel_index.find(neighbour);
+        if (j != Jug::Base::FlatIndexMap::kEmpty) {
+          pixels.unite(static_cast<uint32_t>(i), j);
+        }
+      }
+    }
+
+    // clusters in the order of their first pixel
+    constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> cluster(n, kNone);
+    uint32_t nclusters = 0;
+    for (size_t i = 0; i < n; ++i) {
+      const uint32_t root = pixels.find(static_cast<uint32_t>(i));
+      if (cluster[root] == kNone) {
+        cluster[root] = nclusters++;
+      }
+      cluster[i] = cluster[root];
+    }
+
+    // charge-weighted sums of the clusters
+    struct ClusterSums {
+      double charge{0.}, charge2{0.};
+      int64_t energy{0};
+      double global[3]{0., 0., 0.};
+      double local[3]{0., 0., 0.};
+      double local2[3]{0., 0., 0.};
+      double pitch2[3]{0., 0., 0.};
+      float time{std::numeric_limits<float>::max()};
+      int32_t maxCharge{std::numeric_limits<int32_t>::min()};
+      uint64_t cellID{0};
+    };
+    std::vector<ClusterSums> sums(nclusters);
+    std::vector<const Jug::Base::CellGeometry*> geometries;
+    m_cellGeometry->geometry(cellIDs, geometries);
+    for (size_t i = 0; i < n; ++i) {
+      const auto& geo   = *geometries[i];
+      auto& s           = sums[cluster[i]];
+      const int32_t q   = rawhits[i].getCharge();
+      const double w    = std::max(q, 1);
+      const double g[3] = {geo.global.x() / mm, geo.global.y() / mm, geo.global.z() / mm};
+      const double l[3] = {geo.local.x() / mm, geo.local.y() / mm, geo.local.z() / mm};
+      s.energy += q;
+      s.charge += w;
+      s.charge2 += w * w;
+      for (int k = 0; k < 3; ++k) {
+        s.global[k] += w * g[k];
+        s.local[k] += w * l[k];
+        s.local2[k] += w * l[k] * l[k];
+        s.pitch2[k] += w * w * (geo.dimension[k] / mm) * (geo.dimension[k] / mm);
+      }
+      s.time = std::min(s.time, static_cast<float>(rawhits[i].getTimeStamp() / 1000)); // ns
+      if (q > s.maxCharge) {
+        s.maxCharge = q;
+        s.cellID    = cellIDs[i];
+      }
+    }
+
+    // cluster hits, see TrackerHitReconstruction for the segmentation coordinates of the variance
+    const int axes[2] = {u_localAxes.value()[0], u_localAxes.value()[1]};
+    for (size_t c = 0; c < nclusters; ++c) {
+      const auto& s = sums[c];
+      auto variance = [&s](int k) {
+        const double mean   = s.local[k] / s.charge;
+        const double spread = std::max(s.local2[k] / s.charge - mean * mean, 0.);
+        return spread + s.pitch2[k] / (12. * s.charge * s.charge);
+      };
+      hits.push_back(eicd::TrackerHit{
+          s.cellID,
+          {static_cast<float>(s.global[0] / s.charge), static_cast<float>(s.global[1] / s.charge),
+           static_cast<float>(s.global[2] / s.charge)}, // mm
+          {static_cast<float>(variance(axes[0])), static_cast<float>(variance(axes[1])), 0.F},
+          s.time,                                      // ns
+          m_timeResolution,                            // in ns
+          static_cast<float>(s.energy / 1.0e6),        // Collected energy (GeV)
+          0.0F});                                      // Error on the energy
+    }
+    if (msgLevel(MSG::DEBUG)) {
+      debug() << fmt::format("{:d} pixels in {:d} clusters", n, nclusters) << endmsg;
+    }
+  }
+};
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(TrackerPixelClustering)
+
+} // namespace Jug::Reco
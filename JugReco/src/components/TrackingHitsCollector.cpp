@@ -15,6 +15,9 @@
 namespace Jug::Reco {
 
     /** Collect the tracking hits into a single collection.
+     *
+     * With subsetCollection, the output is a subset collection referencing the input hits instead
+     * of copies (the hits keep the object IDs of their input collection).
      *
      * \ingroup reco
      */
@@ -26,6 +29,8 @@ namespace Jug::Reco {
       DataHandle<eicd::TrackerHitCollection> m_vertexEndcapHits {"vertexEndcapHits" , Gaudi::DataHandle::Reader, this};
       DataHandle<eicd::TrackerHitCollection> m_gemEndcapHits {"gemEndcapHits" , Gaudi::DataHandle::Reader, this};
       DataHandle<eicd::TrackerHitCollection> m_outputHitCollection{"outputHitCollection", Gaudi::DataHandle::Writer, this};
+      Gaudi::Property<bool> m_subsetCollection{this, "subsetCollection", false,
+                                               "Reference the input hits instead of copying them"};
 
     public:
       TrackingHitsCollector(const std::string& name, ISvcLocator* svcLoc)
@@ -52,14 +57,28 @@ namespace Jug::Reco {
         const eicd::TrackerHitCollection* vtxBarrelHits = m_vertexBarrelHits .get();
         const eicd::TrackerHitCollection* vtxEndcapHits = m_vertexEndcapHits .get();
         const eicd::TrackerHitCollection* gemEndcapHits = m_gemEndcapHits .get();
-        auto* outputHits = m_outputHitCollection.createAndPut();
+        const auto inputs = {trkBarrelHits, trkEndcapHits, vtxBarrelHits, vtxEndcapHits, gemEndcapHits};
+        size_t nHits = 0;
+        for (const auto* hits : inputs) {
+          nHits += (hits != nullptr) ? hits->size() : 0;
+        }
+        auto* outputHits = m_outputHitCollection.createAndPut(nHits);
+        if (m_subsetCollection.value()) {
+          outputHits->setSubsetCollection();
+        }
 
-        for (const auto* hits : {trkBarrelHits, trkEndcapHits, vtxBarrelHits, vtxEndcapHits, gemEndcapHits}) {
-          if (hits != nullptr) {
+        for (const auto* hits : inputs) {
+          if (hits == nullptr) {
+            continue;
+          }
+          if (m_subsetCollection.value()) {
             for (const auto& ahit : *hits) {
-              auto new_hit = ahit.clone();
-              outputHits->push_back(ahit.clone());
+              outputHits->push_back(ahit);
             }
+            continue;
+          }
+          for (const auto& ahit : *hits) {
+            outputHits->push_back(ahit.clone());
           }
         }
 
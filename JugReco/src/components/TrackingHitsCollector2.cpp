@@ -8,6 +8,8 @@
 #include "GaudiAlg/Transformer.h"
 
 #include "JugBase/DataHandle.h"
+#include "JugBase/DataHandleArray.h"
+#include "JugBase/Logging.h"
 
 // Event Model related classes
 #include "eicd/TrackerHitCollection.h"
@@ -19,14 +21,18 @@ namespace Jug::Reco {
      * \param inputTrackingHits [in] vector of collection names
      * \param trackingHits [out] hits combined into one collection.
      *
+     * With subsetCollection, the output is a subset collection referencing the input hits instead
+     * of copies (the hits keep the object IDs of their input collection).
+     *
      * \ingroup reco
      */
     class TrackingHitsCollector2 : public GaudiAlgorithm {
     private:
-      Gaudi::Property<std::vector<std::string>> m_inputTrackingHits{this, "inputTrackingHits", {},"Tracker hits to be aggregated"};
+      Jug::Base::DataHandleArray<eicd::TrackerHitCollection> m_hitCollections{this, "inputTrackingHits",
+                                                                             "Tracker hits to be aggregated"};
       DataHandle<eicd::TrackerHitCollection> m_trackingHits{"trackingHits", Gaudi::DataHandle::Writer, this};
-
-      std::vector<DataHandle<eicd::TrackerHitCollection>*> m_hitCollections;
+      Gaudi::Property<bool> m_subsetCollection{this, "subsetCollection", false,
+                                               "Reference the input hits instead of copying them"};
 
     public:
       TrackingHitsCollector2(const std::string& name, ISvcLocator* svcLoc)
@@ -34,34 +40,37 @@ namespace Jug::Reco {
       {
         declareProperty("trackingHits", m_trackingHits, "output hits combined into single collection");
       }
-      ~TrackingHitsCollector2() {
-        for (auto* col : m_hitCollections) {
-          delete col;
-        }
-      }
 
       StatusCode initialize() override {
         if (GaudiAlgorithm::initialize().isFailure()) {
           return StatusCode::FAILURE;
         }
-        for (auto colname : m_inputTrackingHits) {
-          debug() << "initializing collection: " << colname  << endmsg;
-          m_hitCollections.push_back(new DataHandle<eicd::TrackerHitCollection>{colname, Gaudi::DataHandle::Reader, this});
+        for (const auto& colname : m_hitCollections.keys()) {
+          JUG_DEBUG("initializing collection: " << colname);
         }
         return StatusCode::SUCCESS;
       }
 
       StatusCode execute() override
       {
-        auto* outputHits = m_trackingHits.createAndPut();
+        const auto& collections = m_hitCollections.get();
+        auto* outputHits        = m_trackingHits.createAndPut(m_hitCollections.totalSize());
+        if (m_subsetCollection.value()) {
+          outputHits->setSubsetCollection();
+        }
         if (msgLevel(MSG::DEBUG)) {
           debug() << "execute collector" << endmsg;
         }
-        for(const auto& hits: m_hitCollections) {
-          const eicd::TrackerHitCollection* hitCol = hits->get();
+        for (const eicd::TrackerHitCollection* hitCol : collections) {
           if (msgLevel(MSG::DEBUG)) {
             debug() << "col n hits: " << hitCol->size() << endmsg;
           }
+          if (m_subsetCollection.value()) {
+            for (const auto& ahit : *hitCol) {
+              outputHits->push_back(ahit);
+            }
+            continue;
+          }
           for (const auto& ahit : *hitCol) {
             outputHits->push_back(ahit.clone());
           }
@@ -0,0 +1,144 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "JugReco/TopoNeighbours.h"
+
+#include <utility>
+
+#include <cuda_runtime.h>
+
+namespace {
+
+  __device__ uint32_t findRoot(volatile uint32_t* parent, uint32_t i) {
+    while (true) {
+      const uint32_t p = parent[i];
+      if (p == i) {
+        return i;
+      }
+      // path halving, a lost race only skips the shortcut
+      const uint32_t gp = parent[p];
+      if (gp != p) {
+        atomicCAS(const_cast<uint32_t*>(parent + i), p, gp);
+      }
+      i = gp;
+    }
+  }
+
+  // one thread per candidate pair, the larger root is linked to the smaller one if it still is a root
+  __global__ void linkKernel(Jug::Reco::TopoHitArrays<double> hits, Jug::Reco::TopoNeighbourParams params,
+                             const uint32_t* first, const uint32_t* second, size_t npairs, uint32_t* parent) {
+    const size_t k = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+    if (k >= npairs || !Jug::Reco::topoNeighbours(hits, params, first[k], second[k])) {
+      return;
+    }
+    uint32_t i = first[k];
+    uint32_t j = second[k];
+    while (true) {
+      i = findRoot(parent, i);
+      j = findRoot(parent, j);
+      if (i == j) {
+        return;
+      }
+      if (i < j) {
+        const uint32_t t = i;
+        i                = j;
+        j                = t;
+      }
+      if (atomicCAS(parent + i, i, j) == i) {
+        return;
+      }
+    }
+  }
+
+  __global__ void rootKernel(size_t nhits, uint32_t* parent) {
+    const size_t i = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+    if (i < nhits) {
+      parent[i] = findRoot(parent, static_cast<uint32_t>(i));
+    }
+  }
+
+  __global__ void initKernel(size_t nhits, uint32_t* parent) {
+    const size_t i = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+    if (i < nhits) {
+      parent[i] = static_cast<uint32_t>(i);
+    }
+  }
+
+  /// Device buffer, freed with the scope
+  template <typename T> struct DeviceBuffer {
+    T* data{nullptr};
+    bool ok{false};
+    explicit DeviceBuffer(size_t n) { ok = (cudaMalloc(&data, (n > 0 ? n : 1) * sizeof(T)) == cudaSuccess); }
+    ~DeviceBuffer() { cudaFree(data); }
+    DeviceBuffer(const DeviceBuffer&)            = delete;
+    DeviceBuffer& operator=(const DeviceBuffer&) = delete;
+
+    bool upload(const T* host, size_t n) {
+      return n == 0 || cudaMemcpy(data, host, n * sizeof(T), cudaMemcpyHostToDevice) == cudaSuccess;
+    }
+  };
+
+  constexpr unsigned kBlock = 256;
+  unsigned blocks(size_t n) { return static_cast<unsigned>((n + kBlock - 1) / kBlock); }
+
+} // namespace
+
+namespace Jug::Reco {
+
+  bool topoCUDAAvailable() {
+    int count = 0;
+    return cudaGetDeviceCount(&count) == cudaSuccess && count > 0;
+  }
+
+  bool topoComponentsCUDA(const TopoHitArrays<double>& hits, size_t nhits, const TopoNeighbourParams& params,
+                          const std::vector<uint32_t>& first, const std::vector<uint32_t>& second,
+                          std::vector<uint32_t>& root) {
+    const size_t npairs = first.size();
+    DeviceBuffer<float> dx(nhits);
+    DeviceBuffer<float> dy(nhits);
+    DeviceBuffer<float> dz(nhits);
+    DeviceBuffer<float> dlocalX(nhits);
+    DeviceBuffer<float> dlocalY(nhits);
+    DeviceBuffer<double> deta(nhits);
+    DeviceBuffer<double> dphi(nhits);
+    DeviceBuffer<float> dtime(nhits);
+    DeviceBuffer<int> dsector(nhits);
+    DeviceBuffer<int> dlayer(nhits);
+    DeviceBuffer<uint32_t> dfirst(npairs);
+    DeviceBuffer<uint32_t> dsecond(npairs);
+    DeviceBuffer<uint32_t> dparent(nhits);
+    if (!(dx.ok && dy.ok && dz.ok && dlocalX.ok && dlocalY.ok && deta.ok && dphi.ok && dtime.ok && dsector.ok &&
+          dlayer.ok && dfirst.ok && dsecond.ok && dparent.ok)) {
+      return false;
+    }
+    const bool ok = dx.upload(hits.x, nhits) && dy.upload(hits.y, nhits) && dz.upload(hits.z, nhits) &&
+                    dlocalX.upload(hits.localX, nhits) && dlocalY.upload(hits.localY, nhits) &&
+                    deta.upload(hits.eta, nhits) && dphi.upload(hits.phi, nhits) &&
+                    dtime.upload(hits.time, nhits) && dsector.upload(hits.sector, nhits) &&
+                    dlayer.upload(hits.layer, nhits) && dfirst.upload(first.data(), npairs) &&
+                    dsecond.upload(second.data(), npairs);
+    if (!ok) {
+      return false;
+    }
+
+    std::vector<uint32_t> result(nhits);
+    if (nhits > 0) {
+      const TopoHitArrays<double> device{dx.data,   dy.data,   dz.data,    dlocalX.data, dlocalY.data,
+                                         deta.data, dphi.data, dtime.data, dsector.data, dlayer.data};
+      initKernel<<<blocks(nhits), kBlock>>>(nhits, dparent.data);
+      if (npairs > 0) {
+        linkKernel<<<blocks(npairs), kBlock>>>(device, params, dfirst.data, dsecond.data, npairs, dparent.data);
+      }
+      rootKernel<<<blocks(nhits), kBlock>>>(nhits, dparent.data);
+      if (cudaGetLastError() != cudaSuccess || cudaDeviceSynchronize() != cudaSuccess) {
+        return false;
+      }
+      if (cudaMemcpy(result.data(), dparent.data, nhits * sizeof(uint32_t), cudaMemcpyDeviceToHost) != cudaSuccess) {
+        return false;
+      }
+    }
+    root = std::move(result);
+    return true;
+  }
+
+} // namespace Jug::Reco
@@ -0,0 +1,151 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <vector>
+
+#include "Acts/Definitions/Algebra.hpp"
+#include "Acts/MagneticField/MagneticFieldContext.hpp"
+#include "Acts/MagneticField/MagneticFieldProvider.hpp"
+
+namespace Jug::Reco {
+
+/** Fast charge estimate of the calorimeter seeds, shared by the TrackParam*Init algorithms.
+ *
+ *  A track from the origin of transverse momentum pT reaches the radius r at the azimuth
+ *  phi0 - q sign(Bz) asin(r / 2 rho), with rho = pT / |Bz|, so the azimuth of an inner tracker
+ *  hit is larger than that of the cluster for q sign(Bz) > 0. The charge is the sign of the
+ *  measured offset when it is above minBending and ambiguityFraction of the expected bending,
+ *  0 (both charges) otherwise. The solenoid field at the origin is taken as uniform.
+ *
+ *  \ingroup tracking
+ */
+class ChargeEstimator {
+public:
+  struct Config {
+    /// Field along z (ACTS units), no estimate without field
+    double fieldZ{0.};
+    /// Offsets below are ambiguous (azimuth resolution)
+    double minBending{0.002};
+    /// Offsets below this fraction of the expected bending are ambiguous
+    double ambiguityFraction{0.3};
+    /// Pseudorapidity window of the inner hits of a cluster
+    double maxDeltaEta{0.05};
+  };
+
+  ChargeEstimator() = default;
+  explicit ChargeEstimator(const Config& cfg) : m_cfg(cfg) {}
+
+  const Config& config() const { return m_cfg; }
+
+  /// Field along z at the origin, nullopt if it cannot be evaluated
+  static std::optional<double> fieldZ(const Acts::MagneticFieldProvider& field) {
+    Acts::MagneticFieldContext fieldContext;
+    auto cache          = field.makeCache(fieldContext);
+    const auto fieldRes = field.getField(Acts::Vector3::Zero(), cache);
+    if (!fieldRes.ok()) {
+      return std::nullopt;
+    }
+    return (*fieldRes)[2];
+  }
+
+  /// Difference of two azimuths in [-pi, pi)
+  static double deltaPhi(double phi1, double phi2) {
+    double d = std::fmod(phi1 - phi2 + M_PI, 2 * M_PI);
+    if (d < 0) {
+      d += 2 * M_PI;
+    }
+    return d - M_PI;
+  }
+
+  /// Azimuth bending of a unit charge of transverse momentum pT from the origin up to the radius r
+  double bending(double r, double pT) const {
+    const double rho = pT / std::abs(m_cfg.fieldZ);
+    return std::asin(std::min(1., r / (2 * rho)));
+  }
+
+  /** Charge from the azimuths of an inner hit and the cluster, at the transverse radii hitR and
+   *  clusterR, for a track of transverse momentum pT, 0 if ambiguous.
+   */
+  int charge(double hitPhi, double hitR, double clusterPhi, double clusterR, double pT) const {
+    if (m_cfg.fieldZ == 0. || pT <= 0.) {
+      return 0;
+    }
+    const double offset   = deltaPhi(hitPhi, clusterPhi);
+    const double expected = bending(clusterR, pT) - bending(hitR, pT);
+    if (std::abs(offset) < std::max(m_cfg.minBending, m_cfg.ambiguityFraction * expected)) {
+      return 0;
+    }
+    return ((offset > 0.) == (m_cfg.fieldZ > 0.)) ? 1 : -1;
+  }
+
+  /// Index the inner tracker hits of the event by azimuth
+  template <typename Hits> void setHits(const Hits& hits) {
+    m_hits.clear();
+    m_hits.reserve(hits.size());
+    for (const auto& hit : hits) {
+      const auto& pos = hit.getPosition();
+      const double r  = std::hypot(pos.x, pos.y);
+      m_hits.push_back({std::atan2(pos.y, pos.x), std::asinh(pos.z / r), r});
+    }
+    std::sort(m_hits.begin(), m_hits.end(), [](const Hit& a, const Hit& b) { return a.phi < b.phi; });
+  }
+
+  /** Charge of a track of transverse momentum pT to the cluster, from the inner hit (inside the
+   *  cluster radius and maxDeltaEta) with the offset closest to the expected bending, 0 if
+   *  ambiguous or without such a hit.
+   */
+  int charge(double clusterPhi, double clusterEta, double clusterR, double pT) const {
+    if (m_cfg.fieldZ == 0. || pT <= 0. || m_hits.empty()) {
+      return 0;
+    }
+    const double window = bending(clusterR, pT) + m_cfg.minBending;
+    const Hit* best     = nullptr;
+    double bestScore    = 0.;
+    auto visit          = [&](double from, double to) {
+      auto it = std::lower_bound(m_hits.begin(), m_hits.end(), from,
+                                 [](const Hit& h, double phi) { return h.phi < phi; });
+      for (; it != m_hits.end() && it->phi <= to; ++it) {
+        if (it->r >= clusterR || std::abs(it->eta - clusterEta) > m_cfg.maxDeltaEta) {
+          continue;
+        }
+        const double expected = bending(clusterR, pT) - bending(it->r, pT);
+        const double score    = std::abs(std::abs(deltaPhi(it->phi, clusterPhi)) - expected);
+        if (best == nullptr || score < bestScore) {
+          best      = &*it;
+          bestScore = score;
+        }
+      }
+    };
+    // the azimuth window, split in two at +-pi
+    const double lo = clusterPhi - window;
+    const double hi = clusterPhi + window;
+    if (window >= M_PI) {
+      visit(-M_PI, M_PI);
+    } else if (lo < -M_PI) {
+      visit(lo + 2 * M_PI, M_PI);
+      visit(-M_PI, hi);
+    } else if (hi > M_PI) {
+      visit(lo, M_PI);
+      visit(-M_PI, hi - 2 * M_PI);
+    } else {
+      visit(lo, hi);
+    }
+    return (best != nullptr) ? charge(best->phi, best->r, clusterPhi, clusterR, pT) : 0;
+  }
+
+private:
+  struct Hit {
+    double phi;
+    double eta;
+    double r;
+  };
+
+  Config m_cfg;
+  std::vector<Hit> m_hits;
+};
+
+} // namespace Jug::Reco
@@ -0,0 +1,193 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JugTrack_CompactTrajectories_HH
+#define JugTrack_CompactTrajectories_HH
+
+#include "Acts/Definitions/TrackParametrization.hpp"
+#include "Acts/Geometry/GeometryIdentifier.hpp"
+#include "JugBase/IndexSourceLink.hpp"
+#include "JugTrack/Track.hpp"
+#include "JugTrack/Trajectories.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace Jug {
+
+  /// Track state parameters kept in the compact trajectories
+  enum class CompactStateParameters { None, Predicted, Filtered, Smoothed };
+
+  /// Parameters of the name ("none", "predicted", "filtered" or "smoothed"), nullopt if unknown
+  inline std::optional<CompactStateParameters> compactStateParameters(const std::string& name) {
+    if (name == "none") {
+      return CompactStateParameters::None;
+    }
+    if (name == "predicted") {
+      return CompactStateParameters::Predicted;
+    }
+    if (name == "filtered") {
+      return CompactStateParameters::Filtered;
+    }
+    if (name == "smoothed") {
+      return CompactStateParameters::Smoothed;
+    }
+    return std::nullopt;
+  }
+
+  /// Components of the trajectories kept in the compact trajectories
+  struct CompactTrajectoriesConfig {
+    CompactStateParameters parameters{CompactStateParameters::Smoothed};
+    /// Covariances of the state parameters
+    bool covariance{true};
+    /// Only the states of the measurements (no outliers, holes or material states)
+    bool measurementsOnly{true};
+  };
+
+  /** Flat store of the trajectories of the track finding and fitting, with the components of
+   *  CompactTrajectoriesConfig only.
+   *
+   *  One track per trajectory with a tip (the first one), with its fitted parameters and fit
+   *  quality. The track states are stored as structure of arrays, those of track i are
+   *  [stateBegin[i], stateBegin[i + 1]) from the outermost to the innermost. The state
+   *  parameters and covariances are empty unless kept. Without the multi trajectory (all the
+   *  predicted, filtered and smoothed states, jacobians and covariances) this is several times
+   *  smaller than the TrajectoriesContainer.
+   */
+  struct CompactTrajectories {
+    static constexpr uint32_t kNoTrack = std::numeric_limits<uint32_t>::max();
+
+    CompactTrajectoriesConfig config;
+
+    // tracks
+    /// Index of the trajectory of the track in the TrajectoriesContainer
+    std::vector<uint32_t> trajectory;
+    /// Track of each trajectory, kNoTrack for the trajectories without tip
+    std::vector<uint32_t> trackOfTrajectory;
+    /// Fitted parameters, if any
+    std::vector<std::optional<TrackParameters>> parameters;
+    std::vector<uint32_t> nMeasurements;
+    std::vector<uint32_t> nOutliers;
+    std::vector<uint32_t> nHoles;
+    std::vector<float> chi2Sum;
+    std::vector<uint32_t> NDF;
+    std::vector<uint32_t> stateBegin{0};
+
+    // track states
+    std::vector<Acts::GeometryIdentifier> geometryId;
+    std::vector<float> pathLength;
+    /// Acts::TrackStateFlag bits
+    std::vector<uint16_t> typeFlags;
+    /// Measurement (and source link) index, kNoMeasurement for the states without one
+    std::vector<Index> measurementIndex;
+    std::vector<Acts::BoundVector> stateParameters;
+    std::vector<Acts::BoundSymMatrix> stateCovariance;
+
+    static constexpr Index kNoMeasurement = std::numeric_limits<Index>::max();
+
+    size_t size() const { return trajectory.size(); }
+    size_t nStates(size_t track) const { return stateBegin[track + 1] - stateBegin[track]; }
+
+    /// Track of the trajectory, kNoTrack if it has none
+    uint32_t track(size_t itraj) const {
+      return itraj < trackOfTrajectory.size() ? trackOfTrajectory[itraj] : kNoTrack;
+    }
+  };
+
+  /// Compact form of the first track tip of each trajectory
+  inline CompactTrajectories compactTrajectories(const TrajectoriesContainer& trajectories,
+                                                 const CompactTrajectoriesConfig& config) {
+    CompactTrajectories out;
+    out.config = config;
+    out.trackOfTrajectory.assign(trajectories.size(), CompactTrajectories::kNoTrack);
+    for (size_t itraj = 0; itraj < trajectories.size(); ++itraj) {
+      const auto& traj = trajectories[itraj];
+      if (traj.empty()) {
+        continue;
+      }
+      const size_t tip             = traj.tips().front();
+      out.trackOfTrajectory[itraj] = static_cast<uint32_t>(out.size());
+      out.trajectory.push_back(static_cast<uint32_t>(itraj));
+      if (traj.hasTrackParameters(tip)) {
+        out.parameters.emplace_back(traj.trackParameters(tip));
+      } else {
+        out.parameters.emplace_back(std::nullopt);
+      }
+
+      uint32_t nMeasurements = 0;
+      uint32_t nOutliers     = 0;
+      uint32_t nHoles        = 0;
+      double chi2Sum         = 0.;
+      uint32_t NDF           = 0;
+      traj.multiTrajectory().visitBackwards(tip, [&](const auto& state) {
+        const auto flags       = state.typeFlags();
+        const bool measurement = flags.test(Acts::TrackStateFlag::MeasurementFlag);
+        if (measurement) {
+          ++nMeasurements;
+          chi2Sum += state.chi2();
+          NDF += state.calibratedSize();
+        } else if (flags.test(Acts::TrackStateFlag::OutlierFlag)) {
+          ++nOutliers;
+        } else if (flags.test(Acts::TrackStateFlag::HoleFlag)) {
+          ++nHoles;
+        }
+        if (config.measurementsOnly && !measurement) {
+          return;
+        }
+        out.geometryId.push_back(state.referenceSurface().geometryId());
+        out.pathLength.push_back(static_cast<float>(state.pathLength()));
+        out.typeFlags.push_back(static_cast<uint16_t>(flags.to_ulong()));
+        out.measurementIndex.push_back(
+            state.hasUncalibrated() ? static_cast<const IndexSourceLink&>(state.uncalibrated()).index()
+                                    : CompactTrajectories::kNoMeasurement);
+        // the states without the kept parameters get zero parameters
+        auto keep = [&](const auto& pars, const auto& cov) {
+          out.stateParameters.push_back(pars);
+          if (config.covariance) {
+            out.stateCovariance.push_back(cov);
+          }
+        };
+        auto keepZero = [&]() { keep(Acts::BoundVector::Zero(), Acts::BoundSymMatrix::Zero()); };
+        switch (config.parameters) {
+        case CompactStateParameters::Predicted:
+          if (state.hasPredicted()) {
+            keep(state.predicted(), state.predictedCovariance());
+          } else {
+            keepZero();
+          }
+          break;
+        case CompactStateParameters::Filtered:
+          if (state.hasFiltered()) {
+            keep(state.filtered(), state.filteredCovariance());
+          } else {
+            keepZero();
+          }
+          break;
+        case CompactStateParameters::Smoothed:
+          if (state.hasSmoothed()) {
+            keep(state.smoothed(), state.smoothedCovariance());
+          } else {
+            keepZero();
+          }
+          break;
+        case CompactStateParameters::None:
+          break;
+        }
+      });
+      out.nMeasurements.push_back(nMeasurements);
+      out.nOutliers.push_back(nOutliers);
+      out.nHoles.push_back(nHoles);
+      out.chi2Sum.push_back(static_cast<float>(chi2Sum));
+      out.NDF.push_back(NDF);
+      out.stateBegin.push_back(static_cast<uint32_t>(out.geometryId.size()));
+    }
+    return out;
+  }
+
+} // namespace Jug
+
+#endif
@@ -0,0 +1,236 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JugTrack_HelixPreFit_HH
+#define JugTrack_HelixPreFit_HH
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "JugBase/Utilities/Dispatch.h"
+
+namespace Jug::Reco {
+
+  // chi2 of the hits (x, y, z) at arc lengths s from the origin, for the circle through the origin
+  // of normal (nx, ny) and distance d >= 0 of the conformal line, and the line z = z0 + t s: the
+  // transverse residual (d r^2 - p.n) / (|d p - n / 2| + 1 / 2) is the distance to the circle,
+  // also as d goes to 0 (straight line)
+  JUG_KERNEL_BODY void helix_chi2_body(const double* __restrict x, const double* __restrict y,
+                                       const double* __restrict z, const double* __restrict s, size_t n, double nx,
+                                       double ny, double d, double z0, double t, double wRPhi, double wZ,
+                                       double* __restrict chi2) {
+    for (size_t i = 0; i < n; ++i) {
+      const double ex   = d * x[i] - 0.5 * nx;
+      const double ey   = d * y[i] - 0.5 * ny;
+      const double rphi =
+          (d * (x[i] * x[i] + y[i] * y[i]) - (x[i] * nx + y[i] * ny)) / (std::sqrt(ex * ex + ey * ey) + 0.5);
+      const double dz   = z[i] - z0 - t * s[i];
+      chi2[i]           = wRPhi * rphi * rphi + wZ * dz * dz;
+    }
+  }
+  JUG_DISPATCH_KERNEL(helix_chi2,
+                      (const double* __restrict x, const double* __restrict y, const double* __restrict z,
+                       const double* __restrict s, size_t n, double nx, double ny, double d, double z0, double t,
+                       double wRPhi, double wZ, double* __restrict chi2),
+                      (x, y, z, s, n, nx, ny, d, z0, t, wRPhi, wZ, chi2))
+
+  /** Analytic helix pre-fit of the hits of a proto track, from the origin.
+   *
+   *  The circle through the origin is a straight line in the conformal plane (x, y) / r^2, fitted
+   *  by its principal axis, so that the straight tracks need no special case; z is then fitted as
+   *  a line of the arc length. The chi2 is that of the transverse and longitudinal residuals with
+   *  the resolutions sigmaRPhi and sigmaZ; while it is above maxChi2ndf the worst hit is removed, up
+   *  to maxOutliers hits and down to minHits hits. Closed form, no material and no field map: only
+   *  to reject and clean the proto tracks before the full fit.
+   *
+   *  \ingroup tracking
+   */
+  class HelixPreFit {
+  public:
+    struct Config {
+      double sigmaRPhi{0.1};
+      double sigmaZ{0.5};
+      double maxChi2ndf{10.};
+      size_t minHits{4};
+      size_t maxOutliers{2};
+    };
+
+    struct Result {
+      bool ok{false};
+      /// Signed curvature 1/R, positive for counterclockwise tracks
+      double curvature{0.};
+      /// Azimuth and polar angle of the direction at the origin
+      double phi{0.};
+      double theta{0.};
+      double z0{0.};
+      double chi2ndf{0.};
+      /// Indices (in the input) of the kept hits, in the input order
+      std::vector<size_t> hits;
+    };
+
+    HelixPreFit() = default;
+    explicit HelixPreFit(const Config& cfg) : m_cfg(cfg) {}
+
+    const Config& config() const { return m_cfg; }
+
+    /// Fit of the hits (x, y, z), the hits at the origin are not used
+    Result fit(const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z) const {
+      Result result;
+      for (size_t i = 0; i < x.size(); ++i) {
+        if (x[i] * x[i] + y[i] * y[i] > 0.) {
+          result.hits.push_back(i);
+        }
+      }
+      Hits h;
+      Result trial;
+      std::vector<size_t> others;
+      for (size_t outliers = 0; result.hits.size() >= std::max<size_t>(m_cfg.minHits, 3); ++outliers) {
+        const size_t n    = result.hits.size();
+        const double chi2 = fitHits(x, y, z, result.hits, h, result);
+        if (chi2 < 0.) {
+          break;
+        }
+        result.chi2ndf = chi2 / (2. * n - 4.);
+        if (result.chi2ndf <= m_cfg.maxChi2ndf) {
+          result.ok = true;
+          return result;
+        }
+        if (outliers == m_cfg.maxOutliers) {
+          break;
+        }
+        // the outlier is the hit without which the chi2 is the smallest: an outlier that pulls
+        // the fit is not always the hit of the largest residual
+        size_t outlier = n;
+        double best    = chi2;
+        for (size_t j = 0; j < n && n > 3; ++j) {
+          others = result.hits;
+          others.erase(others.begin() + j);
+          const double without = fitHits(x, y, z, others, h, trial);
+          if (without >= 0. && without < best) {
+            best    = without;
+            outlier = j;
+          }
+        }
+        if (outlier == n) {
+          break;
+        }
+        result.hits.erase(result.hits.begin() + outlier);
+      }
+      result.ok = false;
+      return result;
+    }
+
+  private:
+    /// Hits of a fit, with their arc lengths and chi2
+    struct Hits {
+      std::vector<double> x, y, z, s, chi2;
+      void resize(size_t n) {
+        x.resize(n);
+        y.resize(n);
+        z.resize(n);
+        s.resize(n);
+        chi2.resize(n);
+      }
+    };
+
+    /// chi2 of the fit of the hits, negative if the fit fails
+    double fitHits(const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z,
+                   const std::vector<size_t>& hits, Hits& h, Result& result) const {
+      const size_t n = hits.size();
+      h.resize(n);
+      for (size_t j = 0; j < n; ++j) {
+        h.x[j] = x[hits[j]];
+        h.y[j] = y[hits[j]];
+        h.z[j] = z[hits[j]];
+      }
+      // principal axis of the conformal points, of weights r^4 (a transverse residual e is e / r^2
+      // in the conformal plane)
+      double sw = 0.;
+      double su = 0.;
+      double sv = 0.;
+      for (size_t j = 0; j < n; ++j) {
+        const double r2 = h.x[j] * h.x[j] + h.y[j] * h.y[j];
+        sw += r2 * r2;
+        su += h.x[j] * r2;
+        sv += h.y[j] * r2;
+      }
+      su /= sw;
+      sv /= sw;
+      double suu = 0.;
+      double suv = 0.;
+      double svv = 0.;
+      for (size_t j = 0; j < n; ++j) {
+        const double r2 = h.x[j] * h.x[j] + h.y[j] * h.y[j];
+        const double u  = h.x[j] / r2 - su;
+        const double v  = h.y[j] / r2 - sv;
+        suu += r2 * r2 * u * u;
+        suv += r2 * r2 * u * v;
+        svv += r2 * r2 * v * v;
+      }
+      if (suu + svv == 0.) {
+        return -1.;
+      }
+      // the normal of the line is across the principal axis, at distance d >= 0 from the origin
+      const double axis = 0.5 * std::atan2(2. * suv, suu - svv);
+      double nx         = -std::sin(axis);
+      double ny         = std::cos(axis);
+      double d          = nx * su + ny * sv;
+      if (d < 0.) {
+        nx = -nx;
+        ny = -ny;
+        d  = -d;
+      }
+
+      // the hits are ahead of the direction at the origin, across the center n / (2 d)
+      double tx    = -ny;
+      double ty    = nx;
+      double ahead = 0.;
+      for (size_t j = 0; j < n; ++j) {
+        ahead += h.x[j] * tx + h.y[j] * ty;
+      }
+      if (ahead < 0.) {
+        tx = -tx;
+        ty = -ty;
+      }
+      // the center is on the left of the direction for the counterclockwise tracks
+      result.curvature = 2. * d * ((tx * ny - ty * nx) > 0. ? 1. : -1.);
+      result.phi       = std::atan2(ty, tx);
+
+      // z as a line of the arc length 2 R asin(r / 2 R), r / 2 R = r d
+      double ss  = 0.;
+      double sz  = 0.;
+      double sss = 0.;
+      double ssz = 0.;
+      for (size_t j = 0; j < n; ++j) {
+        const double r = std::hypot(h.x[j], h.y[j]);
+        h.s[j]         = (r * d > 1e-6) ? std::asin(std::min(r * d, 1.)) / d : r;
+        ss += h.s[j];
+        sz += h.z[j];
+        sss += h.s[j] * h.s[j];
+        ssz += h.s[j] * h.z[j];
+      }
+      const double det = n * sss - ss * ss;
+      if (det <= 0.) {
+        return -1.;
+      }
+      const double t = (n * ssz - ss * sz) / det;
+      result.z0      = (sz - t * ss) / n;
+      result.theta   = std::atan2(1., t);
+
+      helix_chi2(h.x.data(), h.y.data(), h.z.data(), h.s.data(), n, nx, ny, d, result.z0, t,
+                 1. / (m_cfg.sigmaRPhi * m_cfg.sigmaRPhi), 1. / (m_cfg.sigmaZ * m_cfg.sigmaZ), h.chi2.data());
+      double chi2 = 0.;
+      for (size_t j = 0; j < n; ++j) {
+        chi2 += h.chi2[j];
+      }
+      return chi2;
+    }
+
+    Config m_cfg;
+  };
+
+} // namespace Jug::Reco
+
+#endif
@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JugTrack_HitParticleIndex_HH
+#define JugTrack_HitParticleIndex_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Jug {
+
+  /** Truth particles of the measurements, in compressed rows.
+   *
+   *  Measurement i (the index of its source link, i.e. of its tracker hit) has the particles
+   *  particle[begin[i]] to particle[begin[i + 1] - 1], as indices of the MCParticles, each once.
+   */
+  struct HitParticleIndex {
+    std::vector<uint32_t> begin{0};
+    std::vector<int32_t> particle;
+    /// One past the largest particle index
+    int32_t nParticles{0};
+
+    size_t size() const { return begin.size() - 1; }
+    void add(int32_t p) {
+      particle.push_back(p);
+      nParticles = (p >= nParticles) ? p + 1 : nParticles;
+    }
+    /// Close the row of the next measurement
+    void close() { begin.push_back(static_cast<uint32_t>(particle.size())); }
+  };
+
+  /// Majority particle of the measurements of a track tip
+  struct TrackTruthMatch {
+    /// Index of the trajectory in its TrajectoriesContainer
+    size_t trajectory{0};
+    /// Entry index of the track tip in the multi trajectory
+    size_t trackTip{0};
+    /// Index of the MCParticle, -1 without truth
+    int32_t particle{-1};
+    /// Measurements of the particle, and of the track
+    uint32_t nMajority{0};
+    uint32_t nMeasurements{0};
+
+    double purity() const { return (nMeasurements > 0) ? static_cast<double>(nMajority) / nMeasurements : 0.; }
+  };
+
+  using TrackTruthMatchContainer = std::vector<TrackTruthMatch>;
+
+  /** Majority particle counter over the measurements of the tracks, one track at a time.
+   *
+   *  The counts are kept per particle in a table of the event, reset with the list of the
+   *  particles touched by the track, so that matching all the tracks costs their measurements.
+   */
+  class MajorityParticleCounter {
+  public:
+    explicit MajorityParticleCounter(const HitParticleIndex& index)
+        : m_index(index), m_count(static_cast<size_t>(index.nParticles), 0) {}
+
+    /// Count the particles of a measurement, unknown measurements count for no particle
+    void add(size_t measurement) {
+      ++m_nMeasurements;
+      if (measurement >= m_index.size()) {
+        return;
+      }
+      for (uint32_t k = m_index.begin[measurement]; k < m_index.begin[measurement + 1]; ++k) {
+        const int32_t p = m_index.particle[k];
+        if (m_count[p]++ == 0) {
+          m_touched.push_back(p);
+        }
+      }
+    }
+
+    /// Majority particle of the counted measurements (the smallest index on ties), then reset
+    void take(TrackTruthMatch& match) {
+      match.particle      = -1;
+      match.nMajority     = 0;
+      match.nMeasurements = m_nMeasurements;
+      for (const int32_t p : m_touched) {
+        if (m_count[p] > match.nMajority || (m_count[p] == match.nMajority && p < match.particle)) {
+          match.particle  = p;
+          match.nMajority = m_count[p];
+        }
+        m_count[p] = 0;
+      }
+      m_touched.clear();
+      m_nMeasurements = 0;
+    }
+
+  private:
+    const HitParticleIndex& m_index;
+    std::vector<uint32_t> m_count;
+    std::vector<int32_t> m_touched;
+    uint32_t m_nMeasurements{0};
+  };
+
+} // namespace Jug
+
+#endif
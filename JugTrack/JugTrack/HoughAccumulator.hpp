@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JugTrack_HoughAccumulator_HH
+#define JugTrack_HoughAccumulator_HH
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// the curve of a hit is shared by the host and the device implementations
+#if defined(__CUDACC__)
+#define JUG_HOST_DEVICE __host__ __device__
+#else
+#define JUG_HOST_DEVICE
+#endif
+
+namespace Jug::Reco {
+
+  /** (phi0, curvature) accumulator binning of HoughTransformProtoTracks.
+   *
+   *  The accumulator is phi0-major, with nPhi bins over [-pi, pi) and nCurvature bins over
+   *  [-maxCurvature, maxCurvature).
+   */
+  struct HoughBinning {
+    int nPhi{0};
+    int nCurvature{0};
+    double maxCurvature{0.};
+    /// cos and sin of the nPhi + 1 phi0 bin edges
+    std::vector<double> cosEdge;
+    std::vector<double> sinEdge;
+
+    HoughBinning() = default;
+    HoughBinning(int nphi, int ncurvature, double maxcurvature)
+        : nPhi(nphi), nCurvature(ncurvature), maxCurvature(maxcurvature), cosEdge(nphi + 1), sinEdge(nphi + 1) {
+      for (int i = 0; i <= nPhi; ++i) {
+        const double phi = -M_PI + i * 2. * M_PI / nPhi;
+        cosEdge[i]       = std::cos(phi);
+        sinEdge[i]       = std::sin(phi);
+      }
+    }
+
+    size_t size() const { return static_cast<size_t>(nPhi) * nCurvature; }
+  };
+
+  /** Curvature bins [first, last] of a hit in phi0 bin i, first > last if there are none.
+   *
+   *  A hit at (x, y) is on the circle from the origin of azimuth phi0 and curvature
+   *  kappa = 2 (y cos(phi0) - x sin(phi0)) / r^2, in the forward half plane of phi0. The bins are
+   *  those the curve crosses between the phi0 bin edges, on which it is monotonic.
+   */
+  JUG_HOST_DEVICE inline void houghCurvatureBins(const double* cosEdge, const double* sinEdge, int nCurvature,
+                                                 double maxCurvature, double x, double y, int i, int& first,
+                                                 int& last) {
+    first           = 0;
+    last            = -1;
+    const double r2 = x * x + y * y;
+    if (r2 == 0. || x * (cosEdge[i] + cosEdge[i + 1]) + y * (sinEdge[i] + sinEdge[i + 1]) <= 0.) {
+      return;
+    }
+    const double scale = nCurvature / (2. * maxCurvature);
+    const double b0    = floor(((2. * (y * cosEdge[i] - x * sinEdge[i]) / r2) + maxCurvature) * scale);
+    const double b1    = floor(((2. * (y * cosEdge[i + 1] - x * sinEdge[i + 1]) / r2) + maxCurvature) * scale);
+    first              = static_cast<int>(fmax(fmin(b0, b1), 0.));
+    last               = static_cast<int>(fmin(fmax(b0, b1), nCurvature - 1.));
+  }
+
+  /// Fill the accumulator (resized and zeroed) with the curves of the hits
+  inline void fillHoughAccumulator(const HoughBinning& binning, const std::vector<float>& x,
+                                   const std::vector<float>& y, std::vector<uint32_t>& acc) {
+    acc.assign(binning.size(), 0);
+    for (size_t ihit = 0; ihit < x.size(); ++ihit) {
+      for (int i = 0; i < binning.nPhi; ++i) {
+        int first = 0;
+        int last  = -1;
+        houghCurvatureBins(binning.cosEdge.data(), binning.sinEdge.data(), binning.nCurvature,
+                           binning.maxCurvature, x[ihit], y[ihit], i, first, last);
+        for (int k = first; k <= last; ++k) {
+          ++acc[static_cast<size_t>(i) * binning.nCurvature + k];
+        }
+      }
+    }
+  }
+
+#if defined(JUGGLER_HAVE_CUDA)
+  /// Whether a CUDA device is available for fillHoughAccumulatorCUDA
+  bool houghCUDAAvailable();
+  /// Fill the accumulator on the CUDA device, false (and acc unchanged) on failure
+  bool fillHoughAccumulatorCUDA(const HoughBinning& binning, const std::vector<float>& x,
+                                const std::vector<float>& y, std::vector<uint32_t>& acc);
+#endif
+
+} // namespace Jug::Reco
+
+#endif
@@ -7,7 +7,7 @@
 #include "Acts/EventData/Measurement.hpp"
 #include "Acts/EventData/MultiTrajectory.hpp"
 #include "Acts/EventData/SourceLink.hpp"
-#include "JugTrack/IndexSourceLink.hpp"
+#include "JugBase/IndexSourceLink.hpp"
 
 #include <cassert>
 #include <vector>
@@ -5,7 +5,7 @@
 #define JUG_RECO_SourceLinks_HH
 
 #include "Acts/EventData/Measurement.hpp"
-#include "JugTrack/GeometryContainers.hpp"
+#include "JugBase/GeometryContainers.hpp"
 
 #include <stdexcept>
 #include <string>
@@ -0,0 +1,34 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JugTrack_SpacePoint_HH
+#define JugTrack_SpacePoint_HH
+
+#include "Acts/Definitions/Algebra.hpp"
+#include "Acts/Geometry/GeometryIdentifier.hpp"
+#include "JugBase/Index.hpp"
+
+#include <vector>
+
+namespace Jug {
+
+  /// Global position of a measurement, for track seeding without a surface lookup per hit.
+  struct SpacePoint {
+    /// Global position (ACTS units)
+    Acts::Vector3 position;
+    /// Variances of the radial and z positions
+    Acts::Vector2 variance;
+    /// Index of the measurement (and source link) of the hit
+    Index measurementIndex;
+    /// Surface of the measurement
+    Acts::GeometryIdentifier geometryId;
+    /// Time of the hit (ns)
+    float time{0};
+  };
+
+  /// Container of space points, in the order of the measurements they are made from.
+  using SpacePointContainer = std::vector<SpacePoint>;
+
+} // namespace Jug
+
+#endif
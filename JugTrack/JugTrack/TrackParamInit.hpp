@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+#pragma once
+
+#include <memory>
+
+#include "Acts/Definitions/Common.hpp"
+#include "Acts/Definitions/TrackParametrization.hpp"
+#include "Acts/Definitions/Units.hpp"
+#include "Acts/Surfaces/PerigeeSurface.hpp"
+#include "Acts/Surfaces/Surface.hpp"
+
+#include "JugTrack/Track.hpp"
+
+namespace Jug::Reco {
+
+/** Initial track parameters at a perigee surface, shared by the TrackParam*Init algorithms.
+ *
+ *  The perigee surface at the origin is created once, the surfaces at other vertices are reused
+ *  while the vertex does not change (e.g. for the particles of the same truth vertex), so that the
+ *  seeds do not allocate a surface each.
+ *
+ *  \ingroup tracking
+ */
+class TrackParamInit {
+public:
+  TrackParamInit() : m_origin(Acts::Surface::makeShared<Acts::PerigeeSurface>(Acts::Vector3{0, 0, 0})) {}
+
+  const std::shared_ptr<const Acts::Surface>& origin() const { return m_origin; }
+
+  /// Perigee surface at the vertex, the one of the previous call if at the same vertex
+  const std::shared_ptr<const Acts::Surface>& surface(const Acts::Vector3& vertex) {
+    if ((vertex.array() == 0.).all()) {
+      return m_origin;
+    }
+    if (!m_last || vertex != m_lastVertex) {
+      m_last       = Acts::Surface::makeShared<Acts::PerigeeSurface>(vertex);
+      m_lastVertex = vertex;
+    }
+    return m_last;
+  }
+
+  /// Parameters at the perigee (zero impact parameters)
+  static Acts::BoundVector parameters(double phi, double theta, double qOverP, double time = 0.) {
+    Acts::BoundVector params;
+    params(Acts::eBoundLoc0)   = 0.0 * Acts::UnitConstants::mm;
+    params(Acts::eBoundLoc1)   = 0.0 * Acts::UnitConstants::mm;
+    params(Acts::eBoundPhi)    = phi;
+    params(Acts::eBoundTheta)  = theta;
+    params(Acts::eBoundQOverP) = qOverP;
+    params(Acts::eBoundTime)   = time;
+    return params;
+  }
+
+  /// Seed covariance of the truth initialization
+  static Acts::BoundSymMatrix covariance() {
+    using Acts::UnitConstants::GeV;
+    using Acts::UnitConstants::ns;
+    using Acts::UnitConstants::um;
+    Acts::BoundSymMatrix cov                    = Acts::BoundSymMatrix::Zero();
+    cov(Acts::eBoundLoc0, Acts::eBoundLoc0)     = 1000 * um * 1000 * um;
+    cov(Acts::eBoundLoc1, Acts::eBoundLoc1)     = 1000 * um * 1000 * um;
+    cov(Acts::eBoundPhi, Acts::eBoundPhi)       = 0.05 * 0.05;
+    cov(Acts::eBoundTheta, Acts::eBoundTheta)   = 0.01 * 0.01;
+    cov(Acts::eBoundQOverP, Acts::eBoundQOverP) = (0.1 * 0.1) / (GeV * GeV);
+    cov(Acts::eBoundTime, Acts::eBoundTime)     = 10.0e9 * ns * 10.0e9 * ns;
+    return cov;
+  }
+
+  /// Add the seed of charge q (+1 or -1) of momentum p at the origin, both charges for q = 0
+  template <typename Container> void add(Container& params, double phi, double theta, double p, int q) const {
+    if (q == 0) {
+      addBothCharges(params, phi, theta, p);
+    } else {
+      params.emplace_back(m_origin, parameters(phi, theta, q / p), q);
+    }
+  }
+
+  /// Add the seeds of both charge hypotheses (+1 then -1) of momentum p at the origin
+  template <typename Container> void addBothCharges(Container& params, double phi, double theta, double p) const {
+    params.emplace_back(m_origin, parameters(phi, theta, 1 / p), 1);
+    params.emplace_back(m_origin, parameters(phi, theta, -1 / p), -1);
+  }
+
+private:
+  std::shared_ptr<const Acts::Surface> m_origin;
+  std::shared_ptr<const Acts::Surface> m_last;
+  Acts::Vector3 m_lastVertex{Acts::Vector3::Zero()};
+};
+
+} // namespace Jug::Reco
@@ -5,7 +5,7 @@
 #define JugTrack_Trajectories_HH
 
 #include "Acts/EventData/MultiTrajectory.hpp"
-#include "JugTrack/IndexSourceLink.hpp"
+#include "JugBase/IndexSourceLink.hpp"
 #include "JugTrack/Track.hpp"
 
 #include <algorithm>
@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JugTrack_TrajectorySummary_HH
+#define JugTrack_TrajectorySummary_HH
+
+#include "Acts/Definitions/TrackParametrization.hpp"
+#include "Acts/Geometry/GeometryContext.hpp"
+#include "Acts/Geometry/GeometryIdentifier.hpp"
+#include "Acts/Surfaces/Surface.hpp"
+#include "JugTrack/Track.hpp"
+#include "JugTrack/Trajectories.hpp"
+
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace Jug {
+
+  /// Predicted state of a trajectory on one of its surfaces
+  struct TrajectoryStateSummary {
+    Acts::GeometryIdentifier geometryId;
+    double pathLength{0.};
+    bool calibrated{false};
+    /// Global position of the predicted parameters
+    Acts::Vector3 position;
+    Acts::BoundVector parameters;
+    Acts::BoundSymMatrix covariance;
+  };
+
+  /** Summary of the trajectory of a track tip, made in one pass over its track states.
+   *
+   *  Holds the fitted (perigee) parameters, the fit quality (as in
+   *  Acts::MultiTrajectoryHelpers::trajectoryState) and the predicted states from the outermost
+   *  to the innermost, so that the consumers do not walk the multi trajectory again.
+   */
+  struct TrajectorySummary {
+    /// Index of the trajectory in its TrajectoriesContainer
+    size_t trajectory{0};
+    /// Entry index of the track tip in the multi trajectory
+    size_t trackTip{0};
+    /// Fitted parameters of the track tip, if any
+    std::optional<TrackParameters> parameters;
+
+    size_t nStates{0};
+    size_t nMeasurements{0};
+    size_t nOutliers{0};
+    size_t nHoles{0};
+    double chi2Sum{0.};
+    size_t NDF{0};
+
+    std::vector<TrajectoryStateSummary> states;
+  };
+
+  /// Container of trajectory summaries, in the order of the trajectories and their tips
+  using TrajectorySummaryContainer = std::vector<TrajectorySummary>;
+
+  /// Summarize the first track tip of a trajectory, nullopt if it has none
+  inline std::optional<TrajectorySummary> summarizeTrajectory(const Trajectories& traj, size_t itraj,
+                                                              const Acts::GeometryContext& geoContext) {
+    const auto& trackTips = traj.tips();
+    if (trackTips.empty()) {
+      return std::nullopt;
+    }
+    TrajectorySummary summary;
+    summary.trajectory = itraj;
+    summary.trackTip   = trackTips.front();
+    if (traj.hasTrackParameters(summary.trackTip)) {
+      summary.parameters = traj.trackParameters(summary.trackTip);
+    }
+
+    traj.multiTrajectory().visitBackwards(summary.trackTip, [&](const auto& state) {
+      const auto flags = state.typeFlags();
+      ++summary.nStates;
+      if (flags.test(Acts::TrackStateFlag::MeasurementFlag)) {
+        ++summary.nMeasurements;
+        summary.chi2Sum += state.chi2();
+        summary.NDF += state.calibratedSize();
+      } else if (flags.test(Acts::TrackStateFlag::OutlierFlag)) {
+        ++summary.nOutliers;
+      } else if (flags.test(Acts::TrackStateFlag::HoleFlag)) {
+        ++summary.nHoles;
+      }
+      if (!state.hasPredicted()) {
+        return;
+      }
+
+      const auto& surface = state.referenceSurface();
+      const auto& pars    = state.predicted();
+      TrajectoryStateSummary s;
+      s.geometryId = surface.geometryId();
+      s.pathLength = state.pathLength();
+      s.calibrated = state.hasCalibrated();
+      s.position   = surface.localToGlobal(geoContext, {pars[Acts::eBoundLoc0], pars[Acts::eBoundLoc1]}, {0, 0, 0});
+      s.parameters = pars;
+      s.covariance = state.predictedCovariance();
+      summary.states.push_back(std::move(s));
+    });
+    return summary;
+  }
+
+  /// Summaries of the first track tips of the trajectories that have one
+  inline TrajectorySummaryContainer summarizeTrajectories(const TrajectoriesContainer& trajectories,
+                                                          const Acts::GeometryContext& geoContext) {
+    TrajectorySummaryContainer summaries;
+    summaries.reserve(trajectories.size());
+    for (size_t itraj = 0; itraj < trajectories.size(); ++itraj) {
+      if (auto summary = summarizeTrajectory(trajectories[itraj], itraj, geoContext)) {
+        summaries.push_back(std::move(*summary));
+      }
+    }
+    return summaries;
+  }
+
+} // namespace Jug
+
+#endif
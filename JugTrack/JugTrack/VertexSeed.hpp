@@ -0,0 +1,33 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+#pragma once
+
+#include <vector>
+
+namespace Jug {
+
+  /** Primary vertex z of the event, from the z scan of ZScanVertexSeeder.
+   *
+   *  Stored in the event in flat form (a vector of doubles), the consumers fall back to the
+   *  origin (and their fixed collision region) when it is not valid.
+   */
+  struct VertexSeed {
+    bool valid{false};
+    double z{0};
+    double zError{0};
+    /// Hit pairs in the peak
+    double entries{0};
+
+    /// Flat form, to be stored in the event as a vector of doubles
+    std::vector<double> encode() const { return {valid ? 1. : 0., z, zError, entries}; }
+    /// Vertex of the flat form, false if it is not one
+    static bool decode(const std::vector<double>& values, VertexSeed& vertex) {
+      if (values.size() != 4) {
+        return false;
+      }
+      vertex = {values[0] != 0., values[1], values[2], values[3]};
+      return true;
+    }
+  };
+
+} // namespace Jug
@@ -0,0 +1,21 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#ifndef JugTrack_Vertices_HH
+#define JugTrack_Vertices_HH
+
+#include "Acts/Vertexing/Vertex.hpp"
+#include "JugTrack/Track.hpp"
+
+#include <vector>
+
+namespace Jug {
+
+  /// Reconstructed vertex, its tracks refer to the track parameters of the input trajectories
+  using Vertex = ::Acts::Vertex<TrackParameters>;
+  /// Container of the reconstructed vertices of an event.
+  using VertexContainer = std::vector<Vertex>;
+
+} // namespace Jug
+
+#endif
@@ -0,0 +1,242 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "Gaudi/Accumulators.h"
+#include "Gaudi/Property.h"
+#include "GaudiAlg/GaudiAlgorithm.h"
+
+#include "Acts/Definitions/Units.hpp"
+#include "Acts/MagneticField/MagneticFieldContext.hpp"
+#include "Acts/Propagator/EigenStepper.hpp"
+#include "Acts/Propagator/Propagator.hpp"
+#include "Acts/Utilities/Logger.hpp"
+#include "Acts/Vertexing/AdaptiveMultiVertexFinder.hpp"
+#include "Acts/Vertexing/AdaptiveMultiVertexFitter.hpp"
+#include "Acts/Vertexing/HelicalTrackLinearizer.hpp"
+#include "Acts/Vertexing/ImpactPointEstimator.hpp"
+#include "Acts/Vertexing/LinearizedTrack.hpp"
+#include "Acts/Vertexing/VertexingOptions.hpp"
+#include "Acts/Vertexing/ZScanVertexFinder.hpp"
+
+#include "JugBase/ACTSLogger.h"
+#include "JugBase/DataHandle.h"
+#include "JugBase/IConcurrencySvc.h"
+#include "JugBase/IGeoSvc.h"
+#include "JugTrack/Track.hpp"
+#include "JugTrack/Trajectories.hpp"
+#include "JugTrack/Vertices.hpp"
+
+namespace Jug::Reco {
+
+/** Primary vertices of the fitted tracks, with the ACTS adaptive multi-vertex finder.
+ *
+ *  The vertices are seeded with the ACTS z-scan finder and fitted with the adaptive
+ *  multi-vertex fitter, the tracks are linearized by the helical track linearizer. The
+ *  propagator, linearizer, impact point estimator and finder are made once in initialize()
+ *  with the field of GeoSvc, and shared by the events and the tasks.
+ *
+ *  With groupGap, the tracks are split in groups separated by more than groupGap in z at the
+ *  reference surface; the groups are independent (no vertex shares tracks of two groups) and
+ *  are fitted in tasks of their own (numThreads), which also keeps the quadratic cost of the
+ *  multi-vertex fit of the high-multiplicity events down. The vertices are in group order.
+ *
+ *  The tracks are the fitted parameters of the trajectory tips, or with useTrackParameters the
+ *  track parameters of inputTrackParameters. The vertices refer to the input track parameters.
+ *
+ *  \ingroup tracking
+ */
+class AMVFVertexing : public GaudiAlgorithm {
+public:
+  using Propagator  = Acts::Propagator<Acts::EigenStepper<>>;
+  using IPEstimator = Acts::ImpactPointEstimator<TrackParameters, Propagator>;
+  using Linearizer  = Acts::HelicalTrackLinearizer<Propagator>;
+  using Fitter      = Acts::AdaptiveMultiVertexFitter<TrackParameters, Linearizer>;
+  using SeedFinder  = Acts::ZScanVertexFinder<Fitter>;
+  using Finder      = Acts::AdaptiveMultiVertexFinder<Fitter, SeedFinder>;
+  using Options     = Acts::VertexingOptions<TrackParameters>;
+
+private:
+  DataHandle<TrajectoriesContainer> m_inputTrajectories{"inputTrajectories", Gaudi::DataHandle::Reader, this};
+  DataHandle<TrackParametersContainer> m_inputTrackParameters{"inputTrackParameters", Gaudi::DataHandle::Reader,
+                                                              this};
+  DataHandle<VertexContainer> m_outputVertices{"outputVertices", Gaudi::DataHandle::Writer, this};
+
+  Gaudi::Property<bool> m_useTrackParameters{this, "useTrackParameters", false,
+                                             "Vertices of inputTrackParameters instead of inputTrajectories"};
+  Gaudi::Property<int> m_maxIterations{this, "maxIterations", 100, "Vertices searched at most per group"};
+  Gaudi::Property<double> m_minWeight{this, "minWeight", 0.001, "Weight of a track compatible with a vertex"};
+  Gaudi::Property<std::vector<double>> m_temperatures{
+      this, "temperatures", {8.0, 4.0, 2.0, 1.4142136, 1.2247449, 1.0}, "Annealing temperatures of the fit"};
+  Gaudi::Property<bool> m_doSmoothing{this, "doSmoothing", true, "Refit the tracks with the vertex constraint"};
+  Gaudi::Property<double> m_groupGap{this, "groupGap", 0., "Gap in z between two track groups (mm, 0: one group)"};
+
+  /// Intra-event parallelism: the track groups are fitted in tasks
+  Gaudi::Property<int> m_numThreads{this, "numThreads", 1,
+                                    "Track groups of an event in the ConcurrencySvc arena (1: serial)"};
+  SmartIF<IConcurrencySvc> m_concurrencySvc;
+
+  Gaudi::Accumulators::Counter<> m_trackCounter{this, "Tracks"};
+  Gaudi::Accumulators::Counter<> m_vertexCounter{this, "Vertices"};
+  Gaudi::Accumulators::Counter<> m_failedCounter{this, "Failed groups"};
+
+  SmartIF<IGeoSvc> m_geoSvc;
+  Acts::GeometryContext m_geoContext;
+  Acts::MagneticFieldContext m_fieldContext;
+  std::shared_ptr<const Acts::MagneticFieldProvider> m_BField;
+  std::shared_ptr<const Propagator> m_propagator;
+  std::unique_ptr<const Finder> m_finder;
+
+public:
+  AMVFVertexing(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
+    declareProperty("inputTrajectories", m_inputTrajectories, "");
+    declareProperty("inputTrackParameters", m_inputTrackParameters, "");
+    declareProperty("outputVertices", m_outputVertices, "");
+  }
+
+  StatusCode initialize() override {
+    if (GaudiAlgorithm::initialize().isFailure()) {
+      return StatusCode::FAILURE;
+    }
+    m_geoSvc = service("GeoSvc");
+    if (!m_geoSvc) {
+      error() << "Unable to locate Geometry Service. "
+              << "Make sure you have GeoSvc and SimSvc in the right order in the configuration." << endmsg;
+      return StatusCode::FAILURE;
+    }
+    if (m_temperatures.value().empty()) {
+      error() << "The annealing needs at least one temperature" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    if (m_numThreads.value() != 1) {
+      m_concurrencySvc = service("ConcurrencySvc");
+      if (!m_concurrencySvc) {
+        error() << "Unable to locate ConcurrencySvc for numThreads " << m_numThreads.value() << endmsg;
+        return StatusCode::FAILURE;
+      }
+    }
+
+    // the DD4hep field or the field map of GeoSvc, the field context is not used by either
+    m_BField     = m_geoSvc->getFieldProvider();
+    m_propagator = std::make_shared<Propagator>(Acts::EigenStepper<>(m_BField));
+
+    IPEstimator::Config ipEstimatorCfg(m_BField, m_propagator);
+    IPEstimator ipEstimator(ipEstimatorCfg);
+    Linearizer::Config linearizerCfg(m_BField, m_propagator);
+    Linearizer linearizer(linearizerCfg);
+
+    Acts::AnnealingUtility::Config annealingCfg(m_temperatures.value());
+    Fitter::Config fitterCfg(ipEstimator);
+    fitterCfg.annealingTool = Acts::AnnealingUtility(annealingCfg);
+    fitterCfg.minWeight     = m_minWeight;
+    fitterCfg.doSmoothing   = m_doSmoothing;
+    Fitter fitter(fitterCfg, Jug::makeActsLogger(name(), msgSvc(), msgLevel()));
+
+    SeedFinder::Config seedFinderCfg(ipEstimator);
+    SeedFinder seedFinder(seedFinderCfg);
+
+    Finder::Config finderCfg(std::move(fitter), seedFinder, ipEstimator, std::move(linearizer), m_BField);
+    finderCfg.maxIterations = m_maxIterations;
+    m_finder = std::make_unique<const Finder>(finderCfg, Jug::makeActsLogger(name(), msgSvc(), msgLevel()));
+    return StatusCode::SUCCESS;
+  }
+
+  StatusCode execute() override {
+    auto* vertices = m_outputVertices.createAndPut();
+
+    // the tracks, referring to the parameters in the event store
+    std::vector<const TrackParameters*> tracks;
+    if (m_useTrackParameters) {
+      const auto* parameters = m_inputTrackParameters.get();
+      tracks.reserve(parameters->size());
+      for (const auto& params : *parameters) {
+        tracks.push_back(&params);
+      }
+    } else {
+      for (const auto& traj : *m_inputTrajectories.get()) {
+        for (const size_t tip : traj.tips()) {
+          if (traj.hasTrackParameters(tip)) {
+            tracks.push_back(&traj.trackParameters(tip));
+          }
+        }
+      }
+    }
+
+    // the track groups [groupBegin[i], groupBegin[i + 1]) of the tracks in z order
+    std::vector<size_t> groupBegin{0};
+    if (m_groupGap.value() > 0.) {
+      std::vector<std::pair<double, const TrackParameters*>> ordered;
+      ordered.reserve(tracks.size());
+      for (const auto* track : tracks) {
+        ordered.emplace_back(track->position(m_geoContext).z(), track);
+      }
+      std::sort(ordered.begin(), ordered.end(),
+                [](const auto& a, const auto& b) { return a.first < b.first; });
+      for (size_t i = 0; i < ordered.size(); ++i) {
+        tracks[i] = ordered[i].second;
+        if (i > 0 && ordered[i].first - ordered[i - 1].first > m_groupGap.value()) {
+          groupBegin.push_back(i);
+        }
+      }
+    }
+    groupBegin.push_back(tracks.size());
+
+    const size_t ngroups = groupBegin.size() - 1;
+    std::vector<VertexContainer> groupVertices(ngroups);
+    std::vector<char> failed(ngroups, 0);
+    auto findGroup = [&](size_t group) {
+      const std::vector<const TrackParameters*> groupTracks(tracks.begin() + groupBegin[group],
+                                                            tracks.begin() + groupBegin[group + 1]);
+      if (groupTracks.empty()) {
+        return;
+      }
+      Options options(m_geoContext, m_fieldContext);
+      Finder::State state;
+      auto result = m_finder->find(groupTracks, options, state);
+      if (result.ok()) {
+        groupVertices[group] = std::move(result.value());
+      } else {
+        failed[group] = 1;
+      }
+    };
+    if (m_numThreads.value() == 1 || ngroups == 1) {
+      for (size_t group = 0; group < ngroups; ++group) {
+        findGroup(group);
+      }
+    } else {
+      m_concurrencySvc->parallelFor(ngroups, findGroup);
+    }
+
+    size_t nfailed = 0;
+    for (size_t group = 0; group < ngroups; ++group) {
+      nfailed += failed[group];
+      std::move(groupVertices[group].begin(), groupVertices[group].end(), std::back_inserter(*vertices));
+    }
+    if (nfailed > 0 && msgLevel(MSG::DEBUG)) {
+      debug() << nfailed << " of " << ngroups << " track groups without vertices (finder error)" << endmsg;
+    }
+
+    m_trackCounter += tracks.size();
+    m_vertexCounter += vertices->size();
+    m_failedCounter += nfailed;
+    if (msgLevel(MSG::DEBUG)) {
+      debug() << vertices->size() << " vertices of " << tracks.size() << " tracks in " << ngroups << " groups"
+              << endmsg;
+      for (const auto& vertex : *vertices) {
+        debug() << "  vertex at (" << vertex.position().x() << ", " << vertex.position().y() << ", "
+                << vertex.position().z() << ") mm with " << vertex.tracks().size() << " tracks" << endmsg;
+      }
+    }
+    return StatusCode::SUCCESS;
+  }
+};
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(AMVFVertexing)
+
+} // namespace Jug::Reco
@@ -25,23 +25,30 @@
 #include "Acts/Propagator/Navigator.hpp"
 #include "Acts/Propagator/Propagator.hpp"
 #include "Acts/Definitions/Common.hpp"
+#include "Acts/EventData/MultiTrajectoryHelpers.hpp"
 #include "Acts/Utilities/Helpers.hpp"
 #include "Acts/Utilities/Logger.hpp"
 #include "Acts/Definitions/Units.hpp"
 
+#include "JugBase/ACTSLogger.h"
 #include "JugBase/DataHandle.h"
 #include "JugBase/IGeoSvc.h"
 #include "JugBase/BField/DD4hepBField.h"
 
-#include "JugTrack/GeometryContainers.hpp"
+#include "JugBase/GeometryContainers.hpp"
 #include "JugTrack/Measurement.hpp"
-#include "JugTrack/Index.hpp"
-#include "JugTrack/IndexSourceLink.hpp"
+#include "JugBase/Index.hpp"
+#include "JugBase/IndexSourceLink.hpp"
+#include "JugBase/Profiling.h"
 #include "JugTrack/Track.hpp"
+#include "JugTrack/VertexSeed.hpp"
 
 
 #include "eicd/TrackerHitCollection.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <functional>
 #include <stdexcept>
 #include <vector>
@@ -49,15 +56,6 @@
 #include <stdexcept>
 
 
-static const std::map<int, Acts::Logging::Level> s_msgMap = {
-    {MSG::DEBUG, Acts::Logging::DEBUG},
-    {MSG::VERBOSE, Acts::Logging::VERBOSE},
-    {MSG::INFO, Acts::Logging::INFO},
-    {MSG::WARNING, Acts::Logging::WARNING},
-    {MSG::FATAL, Acts::Logging::FATAL},
-    {MSG::ERROR, Acts::Logging::ERROR},
-};
-
 namespace Jug::Reco {
 
   using namespace Acts::UnitLiterals;
@@ -69,6 +67,8 @@ namespace Jug::Reco {
     declareProperty("inputMeasurements", m_inputMeasurements, "");
     declareProperty("inputInitialTrackParameters", m_inputInitialTrackParameters, "");
     declareProperty("outputTrajectories", m_outputTrajectories, "");
+    declareProperty("outputCompactTrajectories", m_outputCompactTrajectories, "");
+    declareProperty("inputVertexSeed", m_inputVertexSeed, "");
   }
 
   StatusCode CKFTracking::initialize()
@@ -83,8 +83,8 @@ namespace Jug::Reco {
       return StatusCode::FAILURE;
     }
 
-    m_BField   = std::dynamic_pointer_cast<const Jug::BField::DD4hepBField>(m_geoSvc->getFieldProvider());
-    m_fieldctx = Jug::BField::BFieldVariant(m_BField);
+    // the DD4hep field or the field map of GeoSvc, the field context is not used by either
+    m_BField = m_geoSvc->getFieldProvider();
 
     // eta bins, chi2 and #sourclinks per surface cutoffs
     m_sourcelinkSelectorCfg = {
@@ -94,49 +94,63 @@ namespace Jug::Reco {
             }
         },
     };
-    m_trackFinderFunc = CKFTracking::makeCKFTrackingFunction(m_geoSvc->trackingGeometry(), m_BField);
-    auto im = s_msgMap.find(msgLevel());
-    if (im != s_msgMap.end()) {
-        m_actsLoggingLevel = im->second;
+    m_trackFinderFunc = CKFTracking::makeCKFTrackingFunction(m_geoSvc->trackingGeometry(), m_BField, m_stepper);
+    if (!m_trackFinderFunc) {
+      error() << "Unknown stepper " << m_stepper.value() << ", use eigen, atlas or straight" << endmsg;
+      return StatusCode::FAILURE;
     }
+    if (m_seedsPerTask.value() == 0) {
+      error() << "seedsPerTask must be positive" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    const auto compactStates = compactStateParameters(m_compactStates.value());
+    if (!compactStates) {
+      error() << "Unknown compactStates " << m_compactStates.value() << ", use none, predicted, filtered or smoothed"
+              << endmsg;
+      return StatusCode::FAILURE;
+    }
+    if (m_roi && !(m_roiDeltaEta.value() > 0 && m_roiDeltaPhi.value() > 0)) {
+      error() << "roiDeltaEta and roiDeltaPhi must be positive" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    m_compactConfig = {*compactStates, m_compactCovariance.value(), m_compactMeasurementsOnly.value()};
+    if (m_numThreads.value() != 1) {
+      m_concurrencySvc = service("ConcurrencySvc");
+      if (!m_concurrencySvc) {
+        error() << "Unable to locate ConcurrencySvc for numThreads " << m_numThreads.value() << endmsg;
+        return StatusCode::FAILURE;
+      }
+    }
+    // Construct a perigee surface as the target surface
+    m_targetSurface = Acts::Surface::makeShared<Acts::PerigeeSurface>(Acts::Vector3{0., 0., 0.});
+    m_actsLogger    = Jug::makeActsLogger(name(), msgSvc(), msgLevel());
+
+    m_propagatorOptions.maxSteps    = m_maxSteps;
+    m_propagatorOptions.pathLimit   = m_pathLimit;
+    m_propagatorOptions.maxStepSize = m_maxStepSize;
+    m_propagatorOptions.tolerance   = m_stepperTolerance;
+    m_propagatorOptions.mass        = m_mass * Acts::UnitConstants::GeV;
+
+    m_measSel.emplace(m_sourcelinkSelectorCfg);
+    m_extensions.updater.connect<&Acts::GainMatrixUpdater::operator()>(&m_kfUpdater);
+    m_extensions.smoother.connect<&Acts::GainMatrixSmoother::operator()>(&m_kfSmoother);
+    m_extensions.measurementSelector.connect<&Acts::MeasurementSelector::select>(&(*m_measSel));
     return StatusCode::SUCCESS;
   }
 
-  StatusCode CKFTracking::execute()
+  CKFTracking::TrackFinderResult CKFTracking::findTracks(const TrackParametersContainer& seeds,
+                                                         const MeasurementContainer& measurements,
+                                                         const IndexSourceLinkContainer& sourceLinks,
+                                                         const Acts::Surface& targetSurface) const
   {
-    // Read input data
-    const auto* const src_links       = m_inputSourceLinks.get();
-    const auto* const init_trk_params = m_inputInitialTrackParameters.get();
-    const auto* const measurements    = m_inputMeasurements.get();
-
-    //// Prepare the output data with MultiTrajectory
-    // TrajectoryContainer trajectories;
-    auto* trajectories = m_outputTrajectories.createAndPut();
-    trajectories->reserve(init_trk_params->size());
-
-    //// Construct a perigee surface as the target surface
-    auto pSurface = Acts::Surface::makeShared<Acts::PerigeeSurface>(Acts::Vector3{0., 0., 0.});
-
-    ACTS_LOCAL_LOGGER(Acts::getDefaultLogger("CKFTracking Logger", m_actsLoggingLevel));
-
-    Acts::PropagatorPlainOptions pOptions;
-    pOptions.maxSteps = 10000;
-
-    MeasurementCalibrator calibrator{*measurements};
-    Acts::GainMatrixUpdater kfUpdater;
-    Acts::GainMatrixSmoother kfSmoother;
-    Acts::MeasurementSelector measSel{m_sourcelinkSelectorCfg};
-
-    Acts::CombinatorialKalmanFilterExtensions extensions;
+    JUG_PROFILE_REGION("CKFTracking/findTracks");
+    // only the calibrator and the source link accessor depend on the event
+    auto extensions = m_extensions;
+    MeasurementCalibrator calibrator{measurements};
     extensions.calibrator.connect<&MeasurementCalibrator::calibrate>(&calibrator);
-    extensions.updater.connect<&Acts::GainMatrixUpdater::operator()>(&kfUpdater);
-    extensions.smoother.connect<&Acts::GainMatrixSmoother::operator()>(
-        &kfSmoother);
-    extensions.measurementSelector.connect<&Acts::MeasurementSelector::select>(
-        &measSel);
 
     IndexSourceLinkAccessor slAccessor;
-    slAccessor.container = src_links;
+    slAccessor.container = &sourceLinks;
     Acts::SourceLinkAccessorDelegate<IndexSourceLinkAccessor::Iterator>
         slAccessorDelegate;
     slAccessorDelegate.connect<&IndexSourceLinkAccessor::range>(&slAccessor);
@@ -144,26 +158,214 @@ namespace Jug::Reco {
     // Set the CombinatorialKalmanFilter options
     CKFTracking::TrackFinderOptions options(
         m_geoctx, m_fieldctx, m_calibctx, slAccessorDelegate,
-        extensions, Acts::LoggerWrapper{logger()}, pOptions, &(*pSurface));
+        extensions, Acts::LoggerWrapper{logger()}, m_propagatorOptions, &targetSurface);
+
+    // the stepper makes the field cache of each propagation
+    return (*m_trackFinderFunc)(seeds, options);
+  }
+
+  IndexSourceLinkContainer CKFTracking::roiSourceLinks(TrackParametersContainer::const_iterator begin,
+                                                       TrackParametersContainer::const_iterator end,
+                                                       const IndexSourceLinkContainer& sourceLinks,
+                                                       const std::vector<double>& eta,
+                                                       const std::vector<double>& phi) const
+  {
+    std::vector<std::pair<double, double>> directions;
+    for (auto it = begin; it != end; ++it) {
+      const auto direction = it->unitDirection();
+      directions.emplace_back(Acts::VectorHelpers::eta(direction), Acts::VectorHelpers::phi(direction));
+    }
+    const double deltaEta = m_roiDeltaEta.value();
+    const double deltaPhi = m_roiDeltaPhi.value();
+    std::vector<std::reference_wrapper<const IndexSourceLink>> links;
+    for (const auto& link : sourceLinks) {
+      const Index i = link.get().index();
+      const bool in = std::any_of(directions.begin(), directions.end(), [&](const auto& direction) {
+        return std::abs(eta[i] - direction.first) < deltaEta &&
+               std::abs(std::remainder(phi[i] - direction.second, 2 * M_PI)) < deltaPhi;
+      });
+      if (in) {
+        links.push_back(link);
+      }
+    }
+    // still in geometry order
+    IndexSourceLinkContainer roi;
+    roi.insert(links.begin(), links.end());
+    return roi;
+  }
+
+  std::vector<size_t> CKFTracking::selectBranches(const Acts::MultiTrajectory& trajectory,
+                                                  const std::vector<size_t>& tips)
+  {
+    const size_t maxBranches = m_maxBranchesPerSeed.value();
+    const int maxHoles       = m_maxHoles.value();
+    const int maxOutliers    = m_maxOutliers.value();
+    if (maxBranches == 0 && maxHoles < 0 && maxOutliers < 0) {
+      return tips;
+    }
+    struct Branch {
+      size_t tip;
+      size_t nMeasurements;
+      double chi2Sum;
+    };
+    std::vector<Branch> branches;
+    branches.reserve(tips.size());
+    for (const size_t tip : tips) {
+      const auto state = Acts::MultiTrajectoryHelpers::trajectoryState(trajectory, tip);
+      if ((maxHoles >= 0 && state.nHoles > static_cast<size_t>(maxHoles)) ||
+          (maxOutliers >= 0 && state.nOutliers > static_cast<size_t>(maxOutliers))) {
+        ++m_qualityCounter;
+        continue;
+      }
+      branches.push_back({tip, state.nMeasurements, state.chi2Sum});
+    }
+    // the best branches first, so that the first tip stays the best one
+    if (maxBranches > 0 && branches.size() > maxBranches) {
+      std::stable_sort(branches.begin(), branches.end(), [](const Branch& a, const Branch& b) {
+        return (a.nMeasurements != b.nMeasurements) ? a.nMeasurements > b.nMeasurements : a.chi2Sum < b.chi2Sum;
+      });
+      m_widthCounter += branches.size() - maxBranches;
+      branches.resize(maxBranches);
+    }
+    std::vector<size_t> kept;
+    kept.reserve(branches.size());
+    for (const auto& branch : branches) {
+      kept.push_back(branch.tip);
+    }
+    return kept;
+  }
 
-    auto results = (*m_trackFinderFunc)(*init_trk_params, options);
+  StatusCode CKFTracking::execute()
+  {
+    // Read input data
+    const auto* const src_links       = m_inputSourceLinks.get();
+    const auto* const init_trk_params = m_inputInitialTrackParameters.get();
+    const auto* const measurements    = m_inputMeasurements.get();
+
+    //// Prepare the output data with MultiTrajectory
+    // TrajectoryContainer trajectories;
+    auto* outputTrajectories = m_outputTrajectories.createAndPut();
+    auto* compact            = m_outputCompactTrajectories.createAndPut();
+    // with the compact output the trajectories are only kept until they are compacted
+    TrajectoriesContainer foundTrajectories;
+    auto* trajectories = m_compactOutput ? &foundTrajectories : outputTrajectories;
+    trajectories->reserve(init_trk_params->size());
 
-    for (std::size_t iseed = 0; iseed < init_trk_params->size(); ++iseed) {
+    // the perigee of the vertex seed, if valid
+    auto targetSurface = m_targetSurface;
+    double targetZ     = 0.;
+    if (m_useVertexSeed) {
+      VertexSeed vertex;
+      if (VertexSeed::decode(*m_inputVertexSeed.get(), vertex) && vertex.valid) {
+        targetSurface = Acts::Surface::makeShared<Acts::PerigeeSurface>(Acts::Vector3{0., 0., vertex.z});
+        targetZ       = vertex.z;
+      }
+    }
 
-      auto& result = results[iseed];
+    // directions of the measurements from the target perigee, for the regions of the seeds
+    std::vector<double> measurementEta;
+    std::vector<double> measurementPhi;
+    if (m_roi) {
+      JUG_PROFILE_REGION("CKFTracking/roi");
+      const auto& trackingGeometry = *m_geoSvc->trackingGeometry();
+      measurementEta.resize(measurements->size(), 0.);
+      measurementPhi.resize(measurements->size(), 0.);
+      for (const auto& link : *src_links) {
+        const auto* surface = trackingGeometry.findSurface(link.get().geometryId());
+        if (surface == nullptr) {
+          continue;
+        }
+        const Index i = link.get().index();
+        const Acts::BoundVector bound = std::visit(
+            [](const auto& meas) { return Acts::BoundVector(meas.projector().transpose() * meas.parameters()); },
+            (*measurements)[i]);
+        const Acts::Vector3 position =
+            surface->localToGlobal(m_geoctx, {bound[Acts::eBoundLoc0], bound[Acts::eBoundLoc1]}, {0, 0, 0}) -
+            Acts::Vector3{0., 0., targetZ};
+        measurementEta[i] = Acts::VectorHelpers::eta(position);
+        measurementPhi[i] = Acts::VectorHelpers::phi(position);
+      }
+    }
 
-      if (result.ok()) {
-        // Get the track finding output object
-        const auto& trackFindingOutput = result.value();
-        // Create a SimMultiTrajectory
-        trajectories->emplace_back(std::move(trackFindingOutput.fittedStates), 
-                                   std::move(trackFindingOutput.lastMeasurementIndices),
-                                   std::move(trackFindingOutput.fittedParameters));
+    // the seeds are independent, the tasks search consecutive seeds and their results
+    // are concatenated in seed order; with a candidate budget the seeds are searched in
+    // tasks also in serial, so that the search stops between two tasks
+    const size_t nseeds  = init_trk_params->size();
+    const size_t perTask = m_seedsPerTask.value();
+    const size_t budget  = m_maxCandidatesPerEvent.value();
+    const bool tasked    = m_numThreads.value() != 1 || budget > 0 || m_roi;
+    const size_t ntasks  = tasked ? std::max<size_t>((nseeds + perTask - 1) / perTask, 1) : 1;
+    std::vector<TrackFinderResult> results(ntasks);
+    std::vector<char> skipped(ntasks, 0);
+    std::atomic<size_t> candidates{0};
+    auto searchTask = [&](size_t task) {
+      // in parallel the tasks in flight may still go over the budget
+      if (budget > 0 && candidates.load(std::memory_order_relaxed) >= budget) {
+        skipped[task] = 1;
+        return;
+      }
+      if (ntasks == 1 && !m_roi) {
+        results[task] = findTracks(*init_trk_params, *measurements, *src_links, *targetSurface);
       } else {
-        if (msgLevel(MSG::DEBUG)) {
-          debug() << "Track finding failed for truth seed " << iseed << "with error: " << result.error() << endmsg;
+        const auto begin = init_trk_params->begin() + std::min(nseeds, task * perTask);
+        const auto end   = init_trk_params->begin() + std::min(nseeds, (task + 1) * perTask);
+        if (m_roi) {
+          const auto roi = roiSourceLinks(begin, end, *src_links, measurementEta, measurementPhi);
+          m_roiMeasurementCounter += roi.size();
+          results[task] = findTracks(TrackParametersContainer(begin, end), *measurements, roi, *targetSurface);
+        } else {
+          results[task] =
+              findTracks(TrackParametersContainer(begin, end), *measurements, *src_links, *targetSurface);
+        }
+      }
+      size_t found = 0;
+      for (const auto& result : results[task]) {
+        if (result.ok()) {
+          found += result.value().lastMeasurementIndices.size();
         }
       }
+      candidates.fetch_add(found, std::memory_order_relaxed);
+    };
+    if (m_numThreads.value() == 1) {
+      for (size_t task = 0; task < ntasks; ++task) {
+        searchTask(task);
+      }
+    } else {
+      m_concurrencySvc->parallelFor(ntasks, searchTask);
+    }
+
+    size_t nskipped = 0;
+    for (size_t task = 0; task < ntasks; ++task) {
+      if (skipped[task] != 0) {
+        nskipped += std::min(nseeds, (task + 1) * perTask) - task * perTask;
+        continue;
+      }
+      for (size_t i = 0; i < results[task].size(); ++i) {
+        auto& result = results[task][i];
+        if (result.ok()) {
+          // Get the track finding output object
+          auto& trackFindingOutput = result.value();
+          auto tips = selectBranches(trackFindingOutput.fittedStates, trackFindingOutput.lastMeasurementIndices);
+          // Create a SimMultiTrajectory
+          trajectories->emplace_back(std::move(trackFindingOutput.fittedStates), std::move(tips),
+                                     std::move(trackFindingOutput.fittedParameters));
+        } else {
+          if (msgLevel(MSG::DEBUG)) {
+            debug() << "Track finding failed for truth seed " << task * perTask + i << "with error: " << result.error()
+                    << endmsg;
+          }
+        }
+      }
+    }
+    m_seedCounter += nseeds;
+    m_measurementCounter += src_links->size();
+    m_skippedSeedCounter += nskipped;
+    m_branchCounter += candidates.load();
+    if (nskipped > 0 && msgLevel(MSG::DEBUG)) {
+      debug() << nskipped << " of " << nseeds << " seeds skipped after " << candidates.load() << " branches" << endmsg;
+    }
+    if (m_compactOutput) {
+      *compact = compactTrajectories(foundTrajectories, m_compactConfig);
     }
 
     return StatusCode::SUCCESS;
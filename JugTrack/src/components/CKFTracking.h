@@ -5,20 +5,24 @@
 #define JUGGLER_JUGRECO_CKFTracking_HH
 
 #include <functional>
+#include <limits>
 #include <random>
 #include <stdexcept>
 #include <vector>
 
+#include "Gaudi/Accumulators.h"
 #include "Gaudi/Property.h"
 #include "GaudiAlg/GaudiAlgorithm.h"
 #include "GaudiKernel/ToolHandle.h"
 
 #include "JugBase/DataHandle.h"
+#include "JugBase/IConcurrencySvc.h"
 #include "JugBase/IGeoSvc.h"
 #include "JugBase/BField/DD4hepBField.h"
-#include "JugTrack/GeometryContainers.hpp"
-#include "JugTrack/Index.hpp"
-#include "JugTrack/IndexSourceLink.hpp"
+#include "JugBase/GeometryContainers.hpp"
+#include "JugBase/Index.hpp"
+#include "JugBase/IndexSourceLink.hpp"
+#include "JugTrack/CompactTrajectories.hpp"
 #include "JugTrack/Measurement.hpp"
 #include "JugTrack/Track.hpp"
 #include "JugTrack/Trajectories.hpp"
@@ -29,6 +33,12 @@
 #include "Acts/Geometry/TrackingGeometry.hpp"
 #include "Acts/TrackFinding/CombinatorialKalmanFilter.hpp"
 #include "Acts/TrackFinding/MeasurementSelector.hpp"
+#include "Acts/TrackFitting/GainMatrixSmoother.hpp"
+#include "Acts/TrackFitting/GainMatrixUpdater.hpp"
+#include "Acts/Utilities/Logger.hpp"
+
+#include <memory>
+#include <optional>
 
 namespace Jug::Reco {
 
@@ -56,9 +66,12 @@ public:
   /// Create the track finder function implementation.
   /// The magnetic field is intentionally given by-value since the variant
   /// contains shared_ptr anyways.
+  /// The stepper is "eigen" (Runge-Kutta), "atlas" (Runge-Kutta) or "straight" (no field),
+  /// nullptr is returned for other steppers.
   static std::shared_ptr<CKFTrackingFunction> makeCKFTrackingFunction(
     std::shared_ptr<const Acts::TrackingGeometry> trackingGeometry,
-    std::shared_ptr<const Acts::MagneticFieldProvider> magneticField);
+    std::shared_ptr<const Acts::MagneticFieldProvider> magneticField,
+    const std::string& stepper = "eigen");
 
 public:
   DataHandle<IndexSourceLinkContainer> m_inputSourceLinks{"inputSourceLinks", Gaudi::DataHandle::Reader, this};
@@ -66,27 +79,113 @@ public:
   DataHandle<TrackParametersContainer> m_inputInitialTrackParameters{"inputInitialTrackParameters",
                                                                      Gaudi::DataHandle::Reader, this};
   DataHandle<TrajectoriesContainer> m_outputTrajectories{"outputTrajectories", Gaudi::DataHandle::Writer, this};
+  DataHandle<CompactTrajectories> m_outputCompactTrajectories{"outputCompactTrajectories", Gaudi::DataHandle::Writer,
+                                                              this};
+  DataHandle<std::vector<double>> m_inputVertexSeed{"inputVertexSeed", Gaudi::DataHandle::Reader, this};
 
   Gaudi::Property<std::vector<double>> m_etaBins{this, "etaBins", {}};
   Gaudi::Property<std::vector<double>> m_chi2CutOff{this, "chi2CutOff", {15.}};
   Gaudi::Property<std::vector<size_t>> m_numMeasurementsCutOff{this, "numMeasurementsCutOff", {10}};
 
+  /// Propagation: stepper, step and path limits; lengths in mm, mass in GeV
+  Gaudi::Property<std::string> m_stepper{this, "stepper", "eigen", "Stepper: eigen, atlas or straight (field-free)"};
+  Gaudi::Property<unsigned> m_maxSteps{this, "maxSteps", 10000, "Maximum number of steps per propagation"};
+  Gaudi::Property<double> m_pathLimit{this, "pathLimit", std::numeric_limits<double>::max(), "Maximum path length"};
+  Gaudi::Property<double> m_maxStepSize{this, "maxStepSize", std::numeric_limits<double>::max(), "Maximum step size"};
+  Gaudi::Property<double> m_stepperTolerance{this, "stepperTolerance", 1e-4, "Adaptive step size tolerance"};
+  Gaudi::Property<double> m_mass{this, "mass", 0.13957018, "Mass hypothesis for the propagation"};
+
+  /// Intra-event parallelism: the seeds are searched in tasks of seedsPerTask seeds
+  Gaudi::Property<int> m_numThreads{this, "numThreads", 1, "Seeds of an event in the ConcurrencySvc arena (1: serial)"};
+  Gaudi::Property<size_t> m_seedsPerTask{this, "seedsPerTask", 4, "Seeds per parallel task"};
+  SmartIF<IConcurrencySvc> m_concurrencySvc;
+
+  /// Compact output: the kept components of the trajectories (compactStates, compactCovariance,
+  /// compactMeasurementsOnly) in outputCompactTrajectories, outputTrajectories is then empty
+  Gaudi::Property<bool> m_compactOutput{this, "compactOutput", false,
+                                        "Write the compact trajectories instead of the trajectories"};
+  Gaudi::Property<std::string> m_compactStates{this, "compactStates", "smoothed",
+                                               "Compact state parameters: none, predicted, filtered or smoothed"};
+  Gaudi::Property<bool> m_compactCovariance{this, "compactCovariance", true, "Compact state covariances"};
+  Gaudi::Property<bool> m_compactMeasurementsOnly{this, "compactMeasurementsOnly", true,
+                                                  "Compact states of the measurements only"};
+  CompactTrajectoriesConfig m_compactConfig;
+
+  /// Vertex seed (ZScanVertexSeeder): the tracks are expressed at the perigee of the vertex z
+  /// instead of the origin, when the vertex seed of the event is valid
+  Gaudi::Property<bool> m_useVertexSeed{this, "useVertexSeed", false, "Target perigee at inputVertexSeed"};
+
+  /// Branching control for the high-occupancy events: the best maxBranchesPerSeed branches of a
+  /// seed (most measurements, then smallest chi2) without more than maxHoles holes or maxOutliers
+  /// outliers are kept, and once maxCandidatesPerEvent branches are found the remaining seeds of
+  /// the event are not searched (0 or -1: no limit)
+  Gaudi::Property<size_t> m_maxBranchesPerSeed{this, "maxBranchesPerSeed", 0, "Branches kept per seed (0: all)"};
+  Gaudi::Property<int> m_maxHoles{this, "maxHoles", -1, "Holes of a kept branch (-1: any)"};
+  Gaudi::Property<int> m_maxOutliers{this, "maxOutliers", -1, "Outliers of a kept branch (-1: any)"};
+  Gaudi::Property<size_t> m_maxCandidatesPerEvent{this, "maxCandidatesPerEvent", 0,
+                                                  "Branches found before the remaining seeds are skipped (0: all)"};
+
+  /// Region of interest (e.g. the seeds of TrackParamClusterInit for the electron and photon
+  /// triggers): the search of a task only sees the measurements within roiDeltaEta and roiDeltaPhi
+  /// of the directions of its seeds, seen from the target perigee, so that with a bounded
+  /// propagation (pathLimit, maxSteps) the cost scales with the number of seeds rather than of hits;
+  /// the seeds are searched in tasks of seedsPerTask seeds (e.g. 2, the charges of a cluster)
+  Gaudi::Property<bool> m_roi{this, "roi", false, "Measurements in the cones of the seeds only"};
+  Gaudi::Property<double> m_roiDeltaEta{this, "roiDeltaEta", 0.2, "Pseudorapidity half-width of a region"};
+  Gaudi::Property<double> m_roiDeltaPhi{this, "roiDeltaPhi", 0.3, "Azimuthal half-width (rad) of a region"};
+  Gaudi::Accumulators::Counter<> m_roiMeasurementCounter{this, "Measurements in the regions"};
+  Gaudi::Accumulators::Counter<> m_measurementCounter{this, "Measurements"};
+
+  Gaudi::Accumulators::Counter<> m_seedCounter{this, "Seeds"};
+  Gaudi::Accumulators::Counter<> m_skippedSeedCounter{this, "Seeds over maxCandidatesPerEvent"};
+  Gaudi::Accumulators::Counter<> m_branchCounter{this, "Branches"};
+  Gaudi::Accumulators::Counter<> m_widthCounter{this, "Branches over maxBranchesPerSeed"};
+  Gaudi::Accumulators::Counter<> m_qualityCounter{this, "Branches over maxHoles or maxOutliers"};
+
   std::shared_ptr<CKFTrackingFunction> m_trackFinderFunc;
   SmartIF<IGeoSvc> m_geoSvc;
 
-  std::shared_ptr<const Jug::BField::DD4hepBField> m_BField = nullptr;
+  std::shared_ptr<const Acts::MagneticFieldProvider> m_BField = nullptr;
   Acts::GeometryContext m_geoctx;
   Acts::CalibrationContext m_calibctx;
   Acts::MagneticFieldContext m_fieldctx;
 
   Acts::MeasurementSelector::Config m_sourcelinkSelectorCfg;
-  Acts::Logging::Level m_actsLoggingLevel = Acts::Logging::INFO;
+
+  /// Track finder pieces that do not depend on the event, made in initialize()
+  std::shared_ptr<const Acts::Surface> m_targetSurface;
+  std::unique_ptr<const Acts::Logger> m_actsLogger;
+  Acts::PropagatorPlainOptions m_propagatorOptions;
+  Acts::GainMatrixUpdater m_kfUpdater;
+  Acts::GainMatrixSmoother m_kfSmoother;
+  std::optional<Acts::MeasurementSelector> m_measSel;
+  /// Updater, smoother and selector connected, the calibrator is connected per event
+  Acts::CombinatorialKalmanFilterExtensions m_extensions;
 
   CKFTracking(const std::string& name, ISvcLocator* svcLoc);
 
   StatusCode initialize() override;
 
   StatusCode execute() override;
+
+private:
+  /// ACTS logger of the algorithm, for the ACTS_* logging macros
+  const Acts::Logger& logger() const { return *m_actsLogger; }
+
+  /// Run the track finder on the seeds, with calibrator and accessor of its own
+  TrackFinderResult findTracks(const TrackParametersContainer& seeds, const MeasurementContainer& measurements,
+                               const IndexSourceLinkContainer& sourceLinks,
+                               const Acts::Surface& targetSurface) const;
+
+  /// Source links of the measurements in the regions of the seeds, of pseudorapidities eta and
+  /// azimuths phi (by measurement index)
+  IndexSourceLinkContainer roiSourceLinks(TrackParametersContainer::const_iterator begin,
+                                          TrackParametersContainer::const_iterator end,
+                                          const IndexSourceLinkContainer& sourceLinks, const std::vector<double>& eta,
+                                          const std::vector<double>& phi) const;
+
+  /// Tips of the branches of a seed kept by maxBranchesPerSeed, maxHoles and maxOutliers
+  std::vector<size_t> selectBranches(const Acts::MultiTrajectory& trajectory, const std::vector<size_t>& tips);
 };
 
 } // namespace Jug::Reco
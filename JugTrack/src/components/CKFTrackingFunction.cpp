@@ -2,7 +2,9 @@
 // Copyright (C) 2022 Whitney Armstrong, Wouter Deconinck, Sylvester Joosten
 
 #include "Acts/MagneticField/MagneticFieldProvider.hpp"
+#include "Acts/Propagator/AtlasStepper.hpp"
 #include "Acts/Propagator/EigenStepper.hpp"
+#include "Acts/Propagator/StraightLineStepper.hpp"
 #include "Acts/Propagator/Navigator.hpp"
 #include "Acts/Propagator/Propagator.hpp"
 #include "Acts/TrackFitting/GainMatrixSmoother.hpp"
@@ -23,22 +25,24 @@
 
 #include <random>
 #include <stdexcept>
+#include <string>
 
 namespace {
   using Updater  = Acts::GainMatrixUpdater;
   using Smoother = Acts::GainMatrixSmoother;
 
-  using Stepper    = Acts::EigenStepper<>;
   using Navigator  = Acts::Navigator;
-  using Propagator = Acts::Propagator<Stepper, Navigator>;
-  using CKF        = Acts::CombinatorialKalmanFilter<Propagator>;
 
   /** Finder implmentation .
    *
    * \ingroup track
    */
+  template <typename stepper_t>
   struct CKFTrackingFunctionImpl
     : public Jug::Reco::CKFTracking::CKFTrackingFunction {
+    using Propagator = Acts::Propagator<stepper_t, Navigator>;
+    using CKF        = Acts::CombinatorialKalmanFilter<Propagator>;
+
     CKF trackFinder;
 
     CKFTrackingFunctionImpl(CKF&& f) : trackFinder(std::move(f)) {}
@@ -52,27 +56,46 @@ namespace {
     };
   };
 
-} // namespace
-
-namespace Jug::Reco {
-
-  std::shared_ptr<CKFTracking::CKFTrackingFunction>
-  CKFTracking::makeCKFTrackingFunction(
-      std::shared_ptr<const Acts::TrackingGeometry>      trackingGeometry,
-      std::shared_ptr<const Acts::MagneticFieldProvider> magneticField)
+  template <typename stepper_t>
+  std::shared_ptr<Jug::Reco::CKFTracking::CKFTrackingFunction>
+  makeFunction(std::shared_ptr<const Acts::TrackingGeometry> trackingGeometry, stepper_t&& stepper)
   {
-    Stepper   stepper(std::move(magneticField));
-    Navigator::Config cfg{trackingGeometry};
+    using Impl = CKFTrackingFunctionImpl<stepper_t>;
+
+    Navigator::Config cfg{std::move(trackingGeometry)};
     cfg.resolvePassive   = false;
     cfg.resolveMaterial  = true;
     cfg.resolveSensitive = true;
     Navigator navigator(cfg);
 
-    Propagator propagator(std::move(stepper), std::move(navigator));
-    CKF        trackFinder(std::move(propagator));
+    typename Impl::Propagator propagator(std::move(stepper), std::move(navigator));
+    typename Impl::CKF        trackFinder(std::move(propagator));
 
     // build the track finder functions. onws the track finder object.
-    return std::make_shared<CKFTrackingFunctionImpl>(std::move(trackFinder));
+    return std::make_shared<Impl>(std::move(trackFinder));
+  }
+
+} // namespace
+
+namespace Jug::Reco {
+
+  std::shared_ptr<CKFTracking::CKFTrackingFunction>
+  CKFTracking::makeCKFTrackingFunction(
+      std::shared_ptr<const Acts::TrackingGeometry>      trackingGeometry,
+      std::shared_ptr<const Acts::MagneticFieldProvider> magneticField,
+      const std::string&                                 stepper)
+  {
+    if (stepper == "eigen") {
+      return makeFunction(std::move(trackingGeometry), Acts::EigenStepper<>(std::move(magneticField)));
+    }
+    if (stepper == "atlas") {
+      return makeFunction(std::move(trackingGeometry), Acts::AtlasStepper(std::move(magneticField)));
+    }
+    if (stepper == "straight") {
+      // field-free propagation, the field is not used
+      return makeFunction(std::move(trackingGeometry), Acts::StraightLineStepper());
+    }
+    return nullptr;
   }
 
 } // namespace Jug::Reco
@@ -10,11 +10,12 @@
 #include "GaudiKernel/ToolHandle.h"
 
 #include "JugBase/DataHandle.h"
+#include "JugBase/EventParameter.h"
+#include "JugBase/Histograms.h"
 #include "JugBase/IGeoSvc.h"
 #include "JugTrack/ProtoTrack.hpp"
 #include "JugTrack/Track.hpp"
 
-#include "TH1F.h"
 #include "Math/Vector3D.h"
 #include "Math/Vector2D.h"
 
@@ -32,7 +33,7 @@ class ConformalXYPeakProtoTracks : public GaudiAlgorithm {
 private:
   DataHandle<eicd::TrackerHitCollection> m_inputTrackerHits{"inputTrackerHits", Gaudi::DataHandle::Reader, this};
   DataHandle<Jug::ProtoTrackContainer> m_outputProtoTracks{"outputProtoTracks", Gaudi::DataHandle::Writer, this};
-  DataHandle<int> m_nProtoTracks{"nProtoTracks", Gaudi::DataHandle::Writer, this};
+  Jug::Base::EventParameter<int> m_nProtoTracks{this, "nProtoTracks", "nProtoTracks", "number of proto tracks"};
 
   Gaudi::Property<int> m_nPhiBins{this, "nPhiBins", 100};
 
@@ -42,13 +43,13 @@ public:
   ConformalXYPeakProtoTracks(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
     declareProperty("inputTrackerHits", m_inputTrackerHits, "tracker hits whose indices are used in proto-tracks");
     declareProperty("outputProtoTracks", m_outputProtoTracks, "grouped hit indicies");
-    declareProperty("nProtoTracks", m_nProtoTracks, "number of proto tracks");
   }
 
   StatusCode initialize() override {
     if (GaudiAlgorithm::initialize().isFailure()) {
       return StatusCode::FAILURE;
     }
+    m_nProtoTracks.initialize(evtSvc().get());
     return StatusCode::SUCCESS;
   }
 
@@ -63,7 +64,8 @@ public:
 
     ConformalHit ref_hit(0.0,0.0); // future versions will improve on this.
 
-    TH1F h_phi("h_phi",";phi",m_nPhiBins.value(),-M_PI,M_PI);
+    // scratch histogram of the event, no ROOT object
+    Jug::Base::Hist1D h_phi(m_nPhiBins.value(),-M_PI,M_PI);
 
     // 1. conformal XY transform hits
     // 2. fill histogram with phi
@@ -72,18 +74,18 @@ public:
       double yc = ahit.getPosition().y - ref_hit.y();
       double r = std::hypot(xc, yc);
       conformal_hits.emplace_back(2.0*xc/r,2.0*yc/r);
-      h_phi.Fill(conformal_hits.back().phi());
+      h_phi.fill(conformal_hits.back().phi());
     }
     // 3. Get location of maxima
     std::vector<int> max_bins;
     while(max_bins.size() < 100) {
-      int    max_bin = h_phi.GetMaximumBin();
-      double max_val = h_phi.GetMaximum();
+      int    max_bin = h_phi.maximumBin();
+      double max_val = h_phi.maximum();
       if(max_val < 3)  {
         break;
       }
       max_bins.push_back(max_bin);
-      h_phi.SetBinContent(max_bin, 0.0); // zero bin and continue
+      h_phi.setContent(max_bin, 0.0); // zero bin and continue
     }
     n_proto_tracks = max_bins.size();
     if (msgLevel(MSG::DEBUG)) {
@@ -94,8 +96,8 @@ public:
       Jug::ProtoTrack proto_track; // this is just a std::vector<int>
       for(size_t ihit = 0 ; ihit< hits->size() ; ihit++) {
         double phi = conformal_hits[ihit].phi();
-        double bin_phi = h_phi.GetXaxis()->GetBinCenter(b);
-        double bin_width = h_phi.GetXaxis()->GetBinWidth(b); /// \todo make bin width an algo parameter
+        double bin_phi = h_phi.bins().center(b);
+        double bin_width = h_phi.bins().width(); /// \todo make bin width an algo parameter
         if (std::abs(phi - bin_phi) < bin_width/2.0) {
           proto_track.push_back(ihit);
         }
@@ -104,7 +106,7 @@ public:
         proto_tracks->push_back(proto_track);
       }
     }
-    m_nProtoTracks.put(new int{n_proto_tracks});
+    m_nProtoTracks.set(n_proto_tracks);
     // 5. profit!
 
     return StatusCode::SUCCESS;
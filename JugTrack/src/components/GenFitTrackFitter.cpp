@@ -17,8 +17,8 @@
 #include "JugBase/BField/DD4hepBField.h"
 #include "JugBase/DataHandle.h"
 #include "JugBase/IGeoSvc.h"
-#include "JugTrack/GeometryContainers.hpp"
-#include "JugTrack/IndexSourceLink.hpp"
+#include "JugBase/GeometryContainers.hpp"
+#include "JugBase/IndexSourceLink.hpp"
 #include "JugTrack/Measurement.hpp"
 #include "JugTrack/Track.hpp"
 
@@ -36,10 +36,8 @@
 #include "Exception.h"
 #include "FieldManager.h"
 #include "KalmanFitterRefTrack.h"
-#include "MaterialEffects.h"
 #include "RKTrackRep.h"
 #include "StateOnPlane.h"
-#include "TGeoMaterialInterface.h"
 #include "Track.h"
 #include "TrackPoint.h"
 //#include <EventDisplay.h>
@@ -65,6 +63,8 @@ GenFitTrackFitter::GenFitTrackFitter(const std::string& name, ISvcLocator* svcLo
   declareProperty("outputTrajectories", m_outputTrajectories, "");
 }
 
+GenFitTrackFitter::~GenFitTrackFitter() = default;
+
 StatusCode GenFitTrackFitter::initialize() {
   if (GaudiAlgorithm::initialize().isFailure()) {
     return StatusCode::FAILURE;
@@ -76,18 +76,38 @@ StatusCode GenFitTrackFitter::initialize() {
     return StatusCode::FAILURE;
   }
 
-  genfit::FieldManager::getInstance()->init(new FieldImp(m_geoSvc->detector()));
-  // 0., 0., m_geoSvc->centralMagneticField() * 10.0)); // gentfit uses kilo-Gauss
-  genfit::MaterialEffects::getInstance()->init(new genfit::TGeoMaterialInterface());
+  // the genfit material effects and field are set up by GeoSvc
+  m_surfaceIndex = &m_geoSvc->surfaceIndex();
+
+  if (m_pdgHypotheses.value().empty()) {
+    error() << "No particle hypotheses to fit" << endmsg;
+    return StatusCode::FAILURE;
+  }
+  for (int pdg : m_pdgHypotheses.value()) {
+    if (TDatabasePDG::Instance()->GetParticle(pdg) == nullptr) {
+      error() << "Unknown PDG code " << pdg << " in pdgHypotheses" << endmsg;
+      return StatusCode::FAILURE;
+    }
+  }
 
-  // copy the whole map to get around genfit's interface
-  // this should be returning a const&
-  m_detPlaneMap = m_geoSvc->getDetPlaneMap();
-  m_surfaceMap  = m_geoSvc->getDD4hepSurfaceMap();
+  // the track takes ownership of the representations, the seed is set per track
+  m_fitter = std::make_unique<genfit::DAF>();
+  m_track  = std::make_unique<genfit::Track>(new genfit::RKTrackRep(m_pdgHypotheses.value().front()), TVectorD(6),
+                                            TMatrixDSym(6));
+  for (size_t i = 1; i < m_pdgHypotheses.value().size(); ++i) {
+    m_track->addTrackRep(new genfit::RKTrackRep(m_pdgHypotheses.value()[i]));
+  }
 
   return StatusCode::SUCCESS;
 }
 
+StatusCode GenFitTrackFitter::finalize() {
+  // before the geometry and field go away
+  m_track.reset();
+  m_fitter.reset();
+  return GaudiAlgorithm::finalize();
+}
+
 StatusCode GenFitTrackFitter::execute() {
   // Read input data
   const eicd::TrackerHitCollection* hits            = m_inputHitCollection.get();
@@ -101,170 +121,168 @@ StatusCode GenFitTrackFitter::execute() {
 
   int n_tracks       = initialParameters->size();
   int n_proto_tracks = protoTracks->size();
-  // Unused variable
-  // int ID             = 0;
 
   // Assuming init track parameters have been match with proto tracks by index
   if (n_proto_tracks != n_tracks) {
     warning() << " Number of proto tracks does not match the initial track parameters." << endmsg;
   }
+  if (hits->size() < 2) {
+    return StatusCode::SUCCESS;
+  }
 
   for (int itrack = 0; itrack < std::min(n_tracks, n_proto_tracks); itrack++) {
-    const auto& track_param = (*initialParameters)[itrack];
-    const auto& proto_track = (*protoTracks)[itrack];
+    fitTrack(*hits, (*initialParameters)[itrack], (*protoTracks)[itrack]);
+  }
 
-    if (msgLevel(MSG::DEBUG)) {
-      debug() << "track mom : " << track_param.absoluteMomentum() << endmsg;
-    }
-    if (hits->size() < 2) {
-      return StatusCode::SUCCESS;
-    }
-    // init fitter
-    // genfit::KalmanFitterRefTrack fitter;
-    // fitter.setDebugLvl(1);
-    genfit::DAF fitter;
-    // genfit::AbsKalmanFitter* fitter = new genfit::KalmanFitterRefTrack();
-
-    ROOT::Math::XYZVector tp(track_param.momentum()[0], track_param.momentum()[1], track_param.momentum()[2]);
-    auto first_hit       = (*hits)[proto_track[0]];
-    auto first_hit_phi   = eicd::angleAzimuthal(first_hit.getPosition());
-    auto track_param_phi = tp.phi();
-    if (msgLevel(MSG::DEBUG)) {
-      debug() << " first hit phi:  " << first_hit_phi << endmsg;
-      debug() << "init track phi:  " << track_param_phi << endmsg;
-    }
-    if (std::fabs(first_hit_phi - track_param_phi) > 0.15) {
-      warning() << "Seed directions does not match first hit phi. " << endmsg;
-      continue;
-    }
+  return StatusCode::SUCCESS;
+}
 
-    // start values for the fit, e.g. from pattern recognition
-    TVector3 pos(0, 0, 0);
-    TVector3 mom(track_param.momentum()[0], track_param.momentum()[1], track_param.momentum()[2]);
-    TMatrixDSym covM(6);
-    covM(0, 0) = 0.001;
-    covM(1, 1) = 0.001;
-    covM(2, 2) = 1.0;
-    covM(3, 3) = 0.05 * track_param.momentum()[0] * 0.05 * track_param.momentum()[0];
-    covM(4, 4) = 0.05 * track_param.momentum()[1] * 0.05 * track_param.momentum()[1];
-    covM(5, 5) = 0.05 * track_param.momentum()[2] * 0.05 * track_param.momentum()[2];
+bool GenFitTrackFitter::fitTrack(const eicd::TrackerHitCollection& hits, const TrackParameters& track_param,
+                                 const ProtoTrack& proto_track) {
+  if (msgLevel(MSG::DEBUG)) {
+    debug() << "track mom : " << track_param.absoluteMomentum() << endmsg;
+  }
+  if (proto_track.empty()) {
+    return false;
+  }
 
-    if (msgLevel(MSG::DEBUG)) {
-      debug() << "covM = " << covM(0, 0) << "," << covM(1, 1) << "," << covM(2, 2) << "," << covM(3, 3) << ","
-              << covM(4, 4) << "," << covM(5, 5) << " " << endmsg;
-    }
+  ROOT::Math::XYZVector tp(track_param.momentum()[0], track_param.momentum()[1], track_param.momentum()[2]);
+  auto first_hit       = hits[proto_track[0]];
+  auto first_hit_phi   = eicd::angleAzimuthal(first_hit.getPosition());
+  auto track_param_phi = tp.phi();
+  if (msgLevel(MSG::DEBUG)) {
+    debug() << " first hit phi:  " << first_hit_phi << endmsg;
+    debug() << "init track phi:  " << track_param_phi << endmsg;
+  }
+  if (std::fabs(first_hit_phi - track_param_phi) > 0.15) {
+    warning() << "Seed directions does not match first hit phi. " << endmsg;
+    return false;
+  }
 
-    // trackrep
-    // @FIXME: raw new should be avoided, either place on the stack or use
-    // std::unique_ptr<>
-    genfit::AbsTrackRep* electron_rep = new genfit::RKTrackRep(11);
-    // unusud
-    // genfit::AbsTrackRep* positron_rep = new genfit::RKTrackRep(-11);
-    // genfit::AbsTrackRep* piplus_rep = new genfit::RKTrackRep(211);
-    // genfit::AbsTrackRep* piminus_rep = new genfit::RKTrackRep(-211);
-
-    // smeared start state
-    genfit::MeasuredStateOnPlane stateSmeared(electron_rep);
-    stateSmeared.setPosMomCov(pos, mom, covM);
-
-    // create track
-    TVectorD seedState(6);
-    TMatrixDSym seedCov(6);
-    stateSmeared.get6DStateCov(seedState, seedCov);
-    // genfit::Track fitTrack(rep, seedState, seedCov);
-
-    // create track
-    genfit::Track fitTrack(electron_rep, seedState, seedCov);
-    // genfit::Track fitTrack(electron_rep, pos, mom);
-    // fitTrack.addTrackRep(positron_rep);
-    // fitTrack.addTrackRep(piplus_rep );
-    // fitTrack.addTrackRep(piminus_rep);
+  // start values for the fit, e.g. from pattern recognition
+  TVector3 pos(0, 0, 0);
+  TVector3 mom(track_param.momentum()[0], track_param.momentum()[1], track_param.momentum()[2]);
+  TMatrixDSym covM(6);
+  covM(0, 0) = 0.001;
+  covM(1, 1) = 0.001;
+  covM(2, 2) = 1.0;
+  covM(3, 3) = 0.05 * track_param.momentum()[0] * 0.05 * track_param.momentum()[0];
+  covM(4, 4) = 0.05 * track_param.momentum()[1] * 0.05 * track_param.momentum()[1];
+  covM(5, 5) = 0.05 * track_param.momentum()[2] * 0.05 * track_param.momentum()[2];
+
+  if (msgLevel(MSG::DEBUG)) {
+    debug() << "covM = " << covM(0, 0) << "," << covM(1, 1) << "," << covM(2, 2) << "," << covM(3, 3) << ","
+            << covM(4, 4) << "," << covM(5, 5) << " " << endmsg;
+  }
 
-    if (msgLevel(MSG::DEBUG)) {
-      debug() << (*hits).size() << " hits " << endmsg;
+  // smeared start state
+  genfit::MeasuredStateOnPlane stateSmeared(m_track->getCardinalRep());
+  stateSmeared.setPosMomCov(pos, mom, covM);
+
+  // reseed the track, the points (and measurements) of the previous track are deleted
+  TVectorD seedState(6);
+  TMatrixDSym seedCov(6);
+  stateSmeared.get6DStateCov(seedState, seedCov);
+  genfit::Track& fitTrack = *m_track;
+  while (fitTrack.getNumPoints() > 0) {
+    fitTrack.deletePoint(-1);
+  }
+  fitTrack.setStateSeed(seedState);
+  fitTrack.setCovSeed(seedCov);
+
+  if (msgLevel(MSG::DEBUG)) {
+    debug() << hits.size() << " hits " << endmsg;
+  }
+
+  // the measurements copy the coordinates and covariance
+  TVectorD hitCoords(2);
+  TMatrixDSym hitCov(2);
+  int nhit = 0;
+  for (int ihit : proto_track) {
+    const auto& ahit = hits[ihit];
+
+    const auto* is = m_surfaceIndex->find(ahit.getCellID());
+    if (is == nullptr || is->dd4hepSurface == nullptr) {
+      error() << " cellID (" << ahit.getCellID() << ")  not found in the DD4hep surfaces." << endmsg;
+      continue;
     }
+    auto vol_id          = is->volumeID;
+    auto* surf           = is->dd4hepSurface;
+    auto local_position2 =
+        surf->globalToLocal({ahit.getPosition().x / 10.0, ahit.getPosition().y / 10.0, ahit.getPosition().z / 10.0});
 
-    int nhit = 0;
-    for (int ihit : proto_track) {
-      const auto& ahit = (*hits)[ihit];
+    hitCov.UnitMatrix();
+    hitCov(0, 0) = ahit.getPositionError().xx / (100.0); // go from mm^2 to  cm^2
+    hitCov(1, 1) = ahit.getPositionError().yy / (100.0); // go from mm^2 to  cm^2
 
-      const auto* vol_ctx        = m_geoSvc->cellIDPositionConverter()->findContext(ahit.getCellID());
-      auto vol_id         = vol_ctx->identifier;
+    if (msgLevel(MSG::DEBUG)) {
+      debug() << "------------------------------------ " << endmsg;
+      debug() << " hit position     : " << ahit.getPosition().x / 10 << " " << ahit.getPosition().y / 10 << " "
+              << ahit.getPosition().z / 10 << endmsg;
       auto volman         = m_geoSvc->detector()->volumeManager();
       auto alignment      = volman.lookupDetElement(vol_id).nominal();
       auto local_position = alignment.worldToLocal(
           {ahit.getPosition().x / 10.0, ahit.getPosition().y / 10.0, ahit.getPosition().z / 10.0});
-      auto* surf = m_surfaceMap[vol_id];
-      auto local_position2 =
-          surf->globalToLocal({ahit.getPosition().x / 10.0, ahit.getPosition().y / 10.0, ahit.getPosition().z / 10.0});
-
-      TMatrixDSym hitCov(2);
-      hitCov.UnitMatrix();
-      hitCov(0, 0) = ahit.getPositionError().xx / (100.0); // go from mm^2 to  cm^2
-      hitCov(1, 1) = ahit.getPositionError().yy / (100.0); // go from mm^2 to  cm^2
-
-      if (msgLevel(MSG::DEBUG)) {
-        debug() << "------------------------------------ " << endmsg;
-        debug() << " hit position     : " << ahit.getPosition().x / 10 << " " << ahit.getPosition().y / 10 << " "
-                << ahit.getPosition().z / 10 << endmsg;
-        debug() << " dd4hep loc  pos  : " << local_position.x() << " " << local_position.y() << " "
-                << local_position.z() << endmsg;
-        debug() << " dd4hep surf pos  : " << local_position2.u() << " " << local_position2.v() << endmsg;
-      }
+      debug() << " dd4hep loc  pos  : " << local_position.x() << " " << local_position.y() << " "
+              << local_position.z() << endmsg;
+      debug() << " dd4hep surf pos  : " << local_position2.u() << " " << local_position2.v() << endmsg;
+    }
 
-      /** \todo Add check for XZ segmentations to use the right local coordinates.
-       *  Unlike acts, the conversion to the local system isn't going from 3D -> 2D.
-       *  Thefore there is one coordinate that is zero. Which one depends on the the segmentation
-       *  type XY, XZ, etc. For XY the Z-coordinate is zero. For the XZ, the Y-coordinate is zero.
-       */
-      TVectorD hitCoords(2);
-      hitCoords[0] = local_position2.u();
-      hitCoords[1] = local_position2.v();
-      if (msgLevel(MSG::DEBUG)) {
-        debug() << "covariance matrix :  " << hitCov(0, 0) << " " << hitCov(1, 1) << " " << endmsg;
-        debug() << "  hit coordinates :  " << hitCoords[0] << " " << hitCoords[1] << " " << endmsg;
-      }
-      auto* measurement = new genfit::PlanarMeasurement(hitCoords, hitCov, 1 /** type **/, nhit, nullptr);
+    /** \todo Add check for XZ segmentations to use the right local coordinates.
+     *  Unlike acts, the conversion to the local system isn't going from 3D -> 2D.
+     *  Thefore there is one coordinate that is zero. Which one depends on the the segmentation
+     *  type XY, XZ, etc. For XY the Z-coordinate is zero. For the XZ, the Y-coordinate is zero.
+     */
+    hitCoords[0] = local_position2.u();
+    hitCoords[1] = local_position2.v();
+    if (msgLevel(MSG::DEBUG)) {
+      debug() << "covariance matrix :  " << hitCov(0, 0) << " " << hitCov(1, 1) << " " << endmsg;
+      debug() << "  hit coordinates :  " << hitCoords[0] << " " << hitCoords[1] << " " << endmsg;
+    }
+    auto* measurement = new genfit::PlanarMeasurement(hitCoords, hitCov, 1 /** type **/, nhit, nullptr);
+    measurement->setPlane(is->detPlane, vol_id);
+    fitTrack.insertPoint(new genfit::TrackPoint(measurement, &fitTrack));
 
-      // measurement->setPlane(genfit::SharedPlanePtr(new genfit::DetPlane(point, u_dir, v_dir)),
-      measurement->setPlane(m_detPlaneMap[vol_id], vol_id);
-      fitTrack.insertPoint(new genfit::TrackPoint(measurement, &fitTrack));
-      // positronFitTrack.insertPoint(new genfit::TrackPoint(measurement, &positronFitTrack));
+    nhit++;
+  }
+  if (nhit < 2) {
+    return false;
+  }
 
-      nhit++;
-    }
+  // do the fit of all the hypotheses, the unconverged ones are refitted
+  if (msgLevel(MSG::DEBUG)) {
+    fitTrack.checkConsistency();
+  }
+  try {
+    m_fitter->processTrack(&fitTrack, true);
+  } catch (genfit::Exception& e) {
+    warning() << e.what() << endmsg;
+    warning() << "Exception, next track" << endmsg;
+    return false;
+  }
 
-    // do the fit
+  bool anyFitted = false;
+  for (unsigned int irep = 0; irep < fitTrack.getNumReps(); ++irep) {
+    genfit::AbsTrackRep* rep = fitTrack.getTrackRep(irep);
     try {
-      if (msgLevel(MSG::DEBUG)) {
-        debug() << "Electron track: " << endmsg;
-        fitTrack.checkConsistency();
-      }
-      fitter.processTrack(&fitTrack, true);
-      bool isConverged = fitTrack.getFitStatus()->isFitConverged();
+      bool isConverged = fitTrack.getFitStatus(rep)->isFitConverged();
       if (!isConverged) {
-        fitter.processTrack(&fitTrack, true);
+        m_fitter->processTrackWithRep(&fitTrack, rep, true);
       }
-
-      isConverged = fitTrack.getFitStatus()->isFitConverged();
+      isConverged = fitTrack.getFitStatus(rep)->isFitConverged();
       if (!isConverged) {
-        fitter.processTrack(&fitTrack);
+        m_fitter->processTrackWithRep(&fitTrack, rep);
       }
 
-      // print fit result
-      fitTrack.getFittedState().Print();
-      // isConverged = fitTrack.getFitStatus()->isFitConverged();
-
-      bool isFitted = fitTrack.getFitStatus()->isFitted();
-      float chi2    = fitTrack.getFitStatus()->getChi2();
-      float ndf     = fitTrack.getFitStatus()->getNdf();
-      // unused
-      // float charge      = fitTrack.getFitStatus()->getCharge();
+      bool isFitted = fitTrack.getFitStatus(rep)->isFitted();
+      float chi2    = fitTrack.getFitStatus(rep)->getChi2();
+      float ndf     = fitTrack.getFitStatus(rep)->getNdf();
+      anyFitted     = anyFitted || isFitted;
 
       TVector3 vertexPos;
       TVector3 vertexMom;
       TMatrixDSym vertexCov;
-      genfit::MeasuredStateOnPlane state = fitTrack.getFittedState(); // copy
+      genfit::MeasuredStateOnPlane state = fitTrack.getFittedState(0, rep); // copy
       TVector3 vertex(0, 0, 0);
       TVector3 axis(0, 0, 1);
       // state.extrapolateToPoint(vertex);
@@ -273,8 +291,9 @@ StatusCode GenFitTrackFitter::execute() {
       state.getPosMomCov(vertexPos, vertexMom, vertexCov);
 
       if (msgLevel(MSG::DEBUG)) {
-        debug() << "Electron track: " << endmsg;
-        fitTrack.checkConsistency();
+        // print fit result
+        fitTrack.getFittedState(0, rep).Print();
+        debug() << "PDG " << rep->getPDG() << " track: " << endmsg;
         debug() << "vertex pos: " << vertexPos.x() << ", " << vertexPos.y() << ", " << vertexPos.z() << endmsg;
         debug() << "vertex mom: " << vertexMom.x() << ", " << vertexMom.y() << ", " << vertexMom.z() << endmsg;
         debug() << "track status: " << endmsg;
@@ -282,25 +301,18 @@ StatusCode GenFitTrackFitter::execute() {
         debug() << " converged =" << isConverged << endmsg;
         debug() << " chi2/ndf    = " << isFitted << "/" << ndf << " = " << chi2 / ndf << endmsg;
         debug() << " charge =" << isConverged << endmsg;
-        // debug() << "Positron track: " << endmsg;
-        // positronFitTrack.checkConsistency();
       }
     } catch (genfit::Exception& e) {
       warning() << e.what() << endmsg;
-      warning() << "Exception, next track" << endmsg;
-      continue;
+      warning() << "Exception for PDG " << rep->getPDG() << ", next hypothesis" << endmsg;
     }
-
-    // eicd::TrackParameters electron_track_params({ID++, algorithmID()}, {0.0,0.0},{0.0,0.0},{0.0,0.0},{0.0,0.0},
-
-    // TrackParameters(eicd::Index ID, eicd::FloatPair loc, eicd::FloatPair locError, eicd::Direction direction,
-    // eicd::Direction directionError, float qOverP, float qOverPError, float time, float timeError);
-    // tracks->push_back(electron_track_params);
-
-    // delete fitter;
   }
+  return anyFitted;
+  // eicd::TrackParameters electron_track_params({ID++, algorithmID()}, {0.0,0.0},{0.0,0.0},{0.0,0.0},{0.0,0.0},
 
-  return StatusCode::SUCCESS;
+  // TrackParameters(eicd::Index ID, eicd::FloatPair loc, eicd::FloatPair locError, eicd::Direction direction,
+  // eicd::Direction directionError, float qOverP, float qOverPError, float time, float timeError);
+  // tracks->push_back(electron_track_params);
 }
 
 // NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
@@ -5,6 +5,7 @@
 #define JUGGLER_JUGRECO_GenFitTrackFitter_HH
 
 #include <functional>
+#include <memory>
 #include <stdexcept>
 #include <vector>
 
@@ -15,9 +16,10 @@
 
 #include "JugBase/DataHandle.h"
 #include "JugBase/IGeoSvc.h"
+#include "JugBase/SurfaceIndex.h"
 #include "JugBase/BField/DD4hepBField.h"
-#include "JugTrack/GeometryContainers.hpp"
-#include "JugTrack/IndexSourceLink.hpp"
+#include "JugBase/GeometryContainers.hpp"
+#include "JugBase/IndexSourceLink.hpp"
 #include "JugTrack/Track.hpp"
 #include "JugTrack/Measurement.hpp"
 #include "JugTrack/Trajectories.hpp"
@@ -30,6 +32,11 @@
 //genfitk
 #include "FieldManager.h"
 
+namespace genfit {
+  class DAF;
+  class Track;
+} // namespace genfit
+
 #include <random>
 #include <stdexcept>
 
@@ -37,45 +44,17 @@ namespace Jug::Reco {
 
 
   /** Genfit based tracking algorithm.
+   *
+   *  The fitter and the track (with its representations) are made once in initialize and reused
+   *  for all tracks: per track, only the seed and the track points are replaced. The track has
+   *  one representation per particle hypothesis (pdgHypotheses), all fitted to the same
+   *  measurements, the first one is the cardinal representation. The genfit
+   *  material effects and field are the process-wide ones set up by GeoSvc, they keep stepping
+   *  state and are not thread-safe, therefore the tracks and hypotheses are fitted one after the other.
    *
    * \ingroup tracking
    */
   class GenFitTrackFitter : public GaudiAlgorithm {
-  public:
-
-  class FieldImp : public genfit::AbsBField {
-  protected:
-    dd4hep::Detector* m_detector;
-  public:
-    FieldImp(dd4hep::Detector* det): m_detector(det) {}
-    virtual ~FieldImp() {}
-
-    /** Get the magneticField [kGauss] at position.
-     *
-     *  Note that tgeo units are used. [cm] and [kGauss].
-     */
-    TVector3 get(const TVector3& position) const override {
-      double pos[3] = {position.x(), position.y(), position.z()};
-      double field[3];
-      this->get(pos[0], pos[1], pos[2], field[0], field[1], field[2]);
-      return {field[0], field[1], field[2]};
-    }
-
-    /** Get the magneticField [kGauss] at position.
-     *
-     *  Note that tgeo units are used. [cm] and [kGauss].
-     */
-    void get(const double& posX, const double& posY, const double& posZ,
-             double& Bx, double& By, double& Bz) const override {
-    dd4hep::Position pos(posX,posY,posZ);
-    auto field = m_detector->field().magneticField(pos) * (dd4hep::kilogauss / dd4hep::tesla);
-    Bx = field.x();
-    By = field.y();
-    Bz = field.z();
-    //return {field.x(), field.y(),field.z()};
-    }
-  };
-
 public:
   DataHandle<eicd::TrackerHitCollection> m_inputHitCollection{"inputHitCollection", Gaudi::DataHandle::Reader, this};
   DataHandle<TrackParametersContainer>  m_initialTrackParameters{"initialTrackParameters", Gaudi::DataHandle::Reader, this};
@@ -83,18 +62,32 @@ public:
   DataHandle<eicd::TrackParametersCollection> m_foundTracks{"trackParameters", Gaudi::DataHandle::Reader, this};
   DataHandle<eicd::TrajectoryCollection> m_outputTrajectories{"outputTrajectories", Gaudi::DataHandle::Writer, this};
 
+  Gaudi::Property<std::vector<int>> m_pdgHypotheses{this, "pdgHypotheses", {11},
+                                                    "PDG codes of the particle hypotheses of the track fits"};
+
   SmartIF<IGeoSvc> m_geoSvc;
   // Acts::GeometryContext                 m_geoctx;
   // Acts::CalibrationContext              m_calibctx;
   // Acts::MagneticFieldContext            m_fieldctx;
 
-  std::map<int64_t, std::shared_ptr<genfit::DetPlane>> m_detPlaneMap;
-  std::map<int64_t, dd4hep::rec::Surface*> m_surfaceMap;
+  const Jug::Base::SurfaceIndex* m_surfaceIndex{nullptr};
 
   GenFitTrackFitter(const std::string& name, ISvcLocator* svcLoc);
+  ~GenFitTrackFitter() override;
 
   StatusCode initialize() override;
   StatusCode execute() override;
+  StatusCode finalize() override;
+
+private:
+  /// Fit a proto track with its initial parameters, false if it is skipped or the fit failed
+  bool fitTrack(const eicd::TrackerHitCollection& hits, const TrackParameters& trackParam,
+                const ProtoTrack& protoTrack);
+
+  /// Reused for all tracks
+  std::unique_ptr<genfit::DAF> m_fitter;
+  /// Owns the track representations, emptied and reseeded per track
+  std::unique_ptr<genfit::Track> m_track;
   };
 
 
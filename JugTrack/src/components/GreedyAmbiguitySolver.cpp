@@ -0,0 +1,190 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include "Gaudi/Accumulators.h"
+#include "Gaudi/Property.h"
+
+#include "Acts/EventData/MultiTrajectory.hpp"
+
+#include "JugBase/IndexSourceLink.hpp"
+#include "JugBase/Transformer.h"
+#include "JugTrack/Trajectories.hpp"
+
+namespace Jug::Reco {
+
+/** Greedy ambiguity solver of the found trajectories.
+ *
+ *  The seeds of a track (several seeds, both charges) give duplicate trajectories in the track
+ *  finding. The track with the most shared measurements (then with the worst chi2 per
+ *  measurement) is removed, one at a time, until no track shares more than maximumSharedHits
+ *  measurements with the others. Tracks are the track tips of the trajectories, the tracks with
+ *  fewer than nMeasurementsMin measurements are removed first. The measurements are looked up in
+ *  a measurement to tracks index, so that only the tracks sharing the measurements of a removed
+ *  track are updated.
+ *
+ *  The output has the trajectories with at least one kept tip, in the input order, with only the
+ *  kept tips, for ParticlesFromTrackFit, TrackProjector and the output.
+ *
+ * \ingroup tracking
+ */
+class GreedyAmbiguitySolver : public Jug::Transformer<TrajectoriesContainer, TrajectoriesContainer> {
+private:
+  Gaudi::Property<size_t> m_maximumSharedHits{this, "maximumSharedHits", 1,
+                                              "Shared measurements of a kept track"};
+  Gaudi::Property<size_t> m_maximumIterations{this, "maximumIterations", 1000, "Tracks removed at most"};
+  Gaudi::Property<size_t> m_nMeasurementsMin{this, "nMeasurementsMin", 3, "Measurements of a kept track"};
+
+  mutable Gaudi::Accumulators::Counter<> m_trackCounter{this, "Tracks"};
+  mutable Gaudi::Accumulators::Counter<> m_removedCounter{this, "Removed tracks"};
+
+  struct Track {
+    uint32_t trajectory;
+    size_t tip;
+    uint32_t nMeasurements;
+    uint32_t nShared;
+    double chi2;
+  };
+
+public:
+  GreedyAmbiguitySolver(const std::string& name, ISvcLocator* svcLoc)
+      : MultiTransformer(name, svcLoc, {KeyValue{"inputTrajectories", "inputTrajectories"}},
+                         {KeyValue{"outputTrajectories", "outputTrajectories"}}) {}
+
+  void operator()(const TrajectoriesContainer& trajectories, TrajectoriesContainer& output) const override {
+    // the tracks, with their measurements in [measurementBegin[i], measurementBegin[i + 1])
+    std::vector<Track> tracks;
+    std::vector<Index> measurements;
+    std::vector<uint32_t> measurementBegin{0};
+    Index nIndex = 0;
+    for (size_t itraj = 0; itraj < trajectories.size(); ++itraj) {
+      const auto& traj = trajectories[itraj];
+      for (const size_t tip : traj.tips()) {
+        double chi2 = 0.;
+        traj.multiTrajectory().visitBackwards(tip, [&](const auto& state) {
+          if (state.typeFlags().test(Acts::TrackStateFlag::MeasurementFlag)) {
+            const Index index = static_cast<const IndexSourceLink&>(state.uncalibrated()).index();
+            measurements.push_back(index);
+            nIndex = std::max<Index>(nIndex, index + 1);
+            chi2 += state.chi2();
+          }
+        });
+        const auto nMeasurements = static_cast<uint32_t>(measurements.size() - measurementBegin.back());
+        tracks.push_back({static_cast<uint32_t>(itraj), tip, nMeasurements, 0, chi2});
+        measurementBegin.push_back(static_cast<uint32_t>(measurements.size()));
+      }
+    }
+
+    // measurement to tracks index (compressed rows), and the number of kept tracks of each measurement
+    std::vector<uint32_t> trackBegin(nIndex + 1, 0);
+    for (const Index m : measurements) {
+      ++trackBegin[m + 1];
+    }
+    for (Index m = 0; m < nIndex; ++m) {
+      trackBegin[m + 1] += trackBegin[m];
+    }
+    std::vector<uint32_t> trackOfMeasurement(measurements.size());
+    std::vector<uint32_t> fill(trackBegin.begin(), trackBegin.end() - 1);
+    for (uint32_t t = 0; t < tracks.size(); ++t) {
+      for (uint32_t k = measurementBegin[t]; k < measurementBegin[t + 1]; ++k) {
+        trackOfMeasurement[fill[measurements[k]]++] = t;
+      }
+    }
+    std::vector<uint32_t> nKept(nIndex);
+    for (Index m = 0; m < nIndex; ++m) {
+      nKept[m] = trackBegin[m + 1] - trackBegin[m];
+    }
+    for (uint32_t t = 0; t < tracks.size(); ++t) {
+      for (uint32_t k = measurementBegin[t]; k < measurementBegin[t + 1]; ++k) {
+        tracks[t].nShared += (nKept[measurements[k]] > 1) ? 1 : 0;
+      }
+    }
+
+    // kept tracks ordered from the first to be removed
+    auto order = [&tracks](uint32_t t) {
+      const auto& track = tracks[t];
+      const double chi2 = track.nMeasurements > 0 ? track.chi2 / track.nMeasurements : 0.;
+      return std::make_tuple(track.nShared, chi2, t);
+    };
+    std::set<std::tuple<uint32_t, double, uint32_t>> kept;
+    std::vector<char> removed(tracks.size(), 0);
+    auto remove = [&](uint32_t t) {
+      removed[t] = 1;
+      for (uint32_t k = measurementBegin[t]; k < measurementBegin[t + 1]; ++k) {
+        const Index m = measurements[k];
+        if (--nKept[m] != 1) {
+          continue;
+        }
+        // the last track of the measurement does not share it anymore
+        for (uint32_t j = trackBegin[m]; j < trackBegin[m + 1]; ++j) {
+          const uint32_t other = trackOfMeasurement[j];
+          if (removed[other] == 0) {
+            kept.erase(order(other));
+            --tracks[other].nShared;
+            kept.insert(order(other));
+          }
+        }
+      }
+    };
+    for (uint32_t t = 0; t < tracks.size(); ++t) {
+      kept.insert(order(t));
+    }
+    size_t nRemoved = 0;
+    for (uint32_t t = 0; t < tracks.size(); ++t) {
+      if (tracks[t].nMeasurements < m_nMeasurementsMin.value()) {
+        kept.erase(order(t));
+        remove(t);
+        ++nRemoved;
+      }
+    }
+    for (size_t iter = 0; iter < m_maximumIterations.value() && !kept.empty(); ++iter) {
+      const auto worst = std::prev(kept.end());
+      if (std::get<0>(*worst) <= m_maximumSharedHits.value()) {
+        break;
+      }
+      const uint32_t t = std::get<2>(*worst);
+      kept.erase(worst);
+      remove(t);
+      ++nRemoved;
+    }
+
+    // the trajectories with their kept tips
+    std::vector<std::vector<size_t>> tips(trajectories.size());
+    for (uint32_t t = 0; t < tracks.size(); ++t) {
+      if (removed[t] == 0) {
+        tips[tracks[t].trajectory].push_back(tracks[t].tip);
+      }
+    }
+    for (size_t itraj = 0; itraj < trajectories.size(); ++itraj) {
+      if (tips[itraj].empty()) {
+        continue;
+      }
+      const auto& traj = trajectories[itraj];
+      Trajectories::IndexedParameters parameters;
+      for (const size_t tip : tips[itraj]) {
+        if (traj.hasTrackParameters(tip)) {
+          parameters.emplace(tip, traj.trackParameters(tip));
+        }
+      }
+      output.emplace_back(traj.multiTrajectory(), tips[itraj], parameters);
+    }
+
+    m_trackCounter += tracks.size();
+    m_removedCounter += nRemoved;
+    if (msgLevel(MSG::DEBUG)) {
+      debug() << nRemoved << " of " << tracks.size() << " tracks removed, " << output.size() << " of "
+              << trajectories.size() << " trajectories kept" << endmsg;
+    }
+  }
+};
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(GreedyAmbiguitySolver)
+
+} // namespace Jug::Reco
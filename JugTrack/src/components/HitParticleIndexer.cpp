@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Gaudi/Property.h"
+#include "GaudiAlg/GaudiAlgorithm.h"
+
+#include "JugBase/DataHandle.h"
+#include "JugBase/DataHandleArray.h"
+#include "JugBase/Logging.h"
+#include "JugTrack/HitParticleIndex.hpp"
+
+// Event Model related classes
+#include "edm4hep/SimTrackerHitCollection.h"
+#include "eicd/TrackerHitCollection.h"
+
+namespace Jug::Reco {
+
+/** Truth particles of the tracker hits, built once per event for the truth matching.
+ *
+ *  The digitization makes one raw hit per cell of the sim hits, so the particles of a tracker hit
+ *  are those of the sim hits of its cellID. The (cellID, particle) pairs of the sim hits are
+ *  sorted and deduplicated once, hashed by cellID, and the particles of every tracker hit are
+ *  written as the row of its index (that of its source link) in a HitParticleIndex, for
+ *  TrackTruthMatcher and the performance writers.
+ *
+ * \ingroup tracking
+ */
+class HitParticleIndexer : public GaudiAlgorithm {
+private:
+  DataHandle<eicd::TrackerHitCollection> m_inputHits{"inputTrackerHits", Gaudi::DataHandle::Reader, this};
+  Jug::Base::DataHandleArray<edm4hep::SimTrackerHitCollection> m_simHits{this, "inputSimTrackerHits",
+                                                                        "Sim hits of the tracker hits"};
+  DataHandle<HitParticleIndex> m_outputIndex{"outputHitParticleIndex", Gaudi::DataHandle::Writer, this};
+
+  std::vector<std::pair<uint64_t, int32_t>> m_pairs;
+  std::unordered_map<uint64_t, std::pair<uint32_t, uint32_t>> m_cells;
+
+public:
+  HitParticleIndexer(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
+    declareProperty("inputTrackerHits", m_inputHits, "");
+    declareProperty("outputHitParticleIndex", m_outputIndex, "");
+  }
+
+  StatusCode initialize() override {
+    if (GaudiAlgorithm::initialize().isFailure()) {
+      return StatusCode::FAILURE;
+    }
+    if (m_simHits.empty()) {
+      error() << "No inputSimTrackerHits" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    return StatusCode::SUCCESS;
+  }
+
+  StatusCode execute() override {
+    const auto& hits        = *m_inputHits.get();
+    const auto& collections = m_simHits.get();
+    auto& index             = *m_outputIndex.createAndPut();
+
+    m_pairs.clear();
+    m_pairs.reserve(m_simHits.totalSize());
+    for (const auto* collection : collections) {
+      for (const auto& sim : *collection) {
+        const auto part = sim.getMCParticle();
+        if (part.isAvailable()) {
+          m_pairs.emplace_back(sim.getCellID(), static_cast<int32_t>(part.getObjectID().index));
+        }
+      }
+    }
+    std::sort(m_pairs.begin(), m_pairs.end());
+    m_pairs.erase(std::unique(m_pairs.begin(), m_pairs.end()), m_pairs.end());
+
+    m_cells.clear();
+    m_cells.reserve(m_pairs.size());
+    for (uint32_t k = 0; k < m_pairs.size();) {
+      uint32_t end = k + 1;
+      while (end < m_pairs.size() && m_pairs[end].first == m_pairs[k].first) {
+        ++end;
+      }
+      m_cells.emplace(m_pairs[k].first, std::make_pair(k, end));
+      k = end;
+    }
+
+    index.begin.reserve(hits.size() + 1);
+    for (const auto& hit : hits) {
+      const auto it = m_cells.find(hit.getCellID());
+      if (it != m_cells.end()) {
+        for (uint32_t k = it->second.first; k < it->second.second; ++k) {
+          index.add(m_pairs[k].second);
+        }
+      }
+      index.close();
+    }
+    JUG_DEBUG(index.particle.size() << " particles of " << hits.size() << " hits, " << m_pairs.size()
+                                    << " sim hit cells");
+    return StatusCode::SUCCESS;
+  }
+};
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(HitParticleIndexer)
+
+} // namespace Jug::Reco
@@ -1,53 +1,216 @@
 // SPDX-License-Identifier: LGPL-3.0-or-later
-// Copyright (C) 2022 Whitney Armstrong
+// Copyright (C) 2022 Whitney Armstrong, Wouter Deconinck
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <utility>
+#include <string>
+#include <vector>
+
 // Gaudi
 #include "Gaudi/Property.h"
-#include "GaudiAlg/GaudiAlgorithm.h"
-#include "GaudiAlg/GaudiTool.h"
-#include "GaudiAlg/Transformer.h"
-#include "GaudiKernel/ToolHandle.h"
+#include "GaudiKernel/PhysicalConstants.h"
 
-#include "JugBase/DataHandle.h"
-#include "JugBase/IGeoSvc.h"
+#include "JugBase/Transformer.h"
+#include "JugTrack/HoughAccumulator.hpp"
 #include "JugTrack/ProtoTrack.hpp"
-#include "JugTrack/Track.hpp"
-
-#include "Math/Vector3D.h"
 
 #include "eicd/TrackerHitCollection.h"
 
+using namespace Gaudi::Units;
+
 namespace Jug::Reco {
 
 /** Hough transform proto track finder.
+ *
+ *  Tracks from the origin are found as peaks in the (phi0, curvature) plane of their transverse
+ *  circles: a hit at (x, y) lies on the circle of azimuth phi0 and signed curvature kappa for
+ *  kappa = 2 (y cos(phi0) - x sin(phi0)) / r^2. In each phi0 bin of its forward half plane, a hit
+ *  fills the curvature bins its curve crosses between the bin edges (so that the steep curves of
+ *  the inner hits are not undersampled), the peaks are the local maxima with at least minHits
+ *  hits, and the hits are assigned to the peaks by looking up the bins they fill in a peak map.
+ *  Drop-in replacement of ConformalXYPeakProtoTracks, a hit can be on several proto tracks but
+ *  the secondary peaks of a track are dropped.
+ *
+ *  The accumulator can be filled on a CUDA device (backend "cuda", in builds with
+ *  JUGGLER_ENABLE_CUDA), the peak finding and hit assignment stay on the CPU. Without a device,
+ *  or if the device fill fails, the CPU fill is used.
  *
  *  \ingroup tracking
  */
-class HoughTransformProtoTracks : public GaudiAlgorithm {
+class HoughTransformProtoTracks : public Jug::Transformer<Jug::ProtoTrackContainer, eicd::TrackerHitCollection> {
 private:
-  DataHandle<eicd::TrackerHitCollection> m_inputTrackerHits{"inputTrackerHits", Gaudi::DataHandle::Reader, this};
-  DataHandle<Jug::ProtoTrackContainer> m_outputProtoTracks{"outputProtoTracks", Gaudi::DataHandle::Writer, this};
+  Gaudi::Property<int> m_nPhiBins{this, "nPhiBins", 256};
+  Gaudi::Property<int> m_nCurvatureBins{this, "nCurvatureBins", 64};
+  /// Largest |curvature|, 1/R = 0.3 B/pT: 1/(200 mm) for 0.2 GeV in 1.7 T
+  Gaudi::Property<double> m_maxCurvature{this, "maxCurvature", 1. / (200. * mm)};
+  Gaudi::Property<int> m_minHits{this, "minHits", 4, "Minimum number of hits of a peak and a proto track"};
+  Gaudi::Property<int> m_maxProtoTracks{this, "maxProtoTracks", 100};
+  /// Secondary peaks of a track (on the ridge of its bins) share most of its hits
+  Gaudi::Property<double> m_maxSharedFraction{this, "maxSharedFraction", 0.5,
+                                              "Largest fraction of hits shared with stronger proto tracks"};
+
+  Gaudi::Property<std::string> m_backend{this, "backend", "cpu", "Accumulator fill: cpu or cuda"};
+
+  HoughBinning m_binning;
+  /// Fill on the device, decided in initialize
+  bool m_useDevice{false};
 
 public:
-  HoughTransformProtoTracks(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
-    declareProperty("inputTrackerHits", m_inputTrackerHits, "tracker hits whose indices are used in proto-tracks");
-    declareProperty("outputProtoTracks", m_outputProtoTracks, "grouped hit indicies");
-  }
+  HoughTransformProtoTracks(const std::string& name, ISvcLocator* svcLoc)
+      : MultiTransformer(name, svcLoc, {KeyValue{"inputTrackerHits", "inputTrackerHits"}},
+                         {KeyValue{"outputProtoTracks", "outputProtoTracks"}}) {}
 
   StatusCode initialize() override {
-    if (GaudiAlgorithm::initialize().isFailure())
+    if (Gaudi::Algorithm::initialize().isFailure()) {
       return StatusCode::FAILURE;
+    }
+    if (m_nPhiBins.value() < 3 || m_nCurvatureBins.value() < 1 || m_maxCurvature.value() <= 0. ||
+        m_minHits.value() < 1) {
+      error() << "Invalid Hough accumulator binning or threshold" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    m_binning = HoughBinning(m_nPhiBins.value(), m_nCurvatureBins.value(), m_maxCurvature.value());
+
+    if (m_backend.value() == "cuda") {
+#if defined(JUGGLER_HAVE_CUDA)
+      m_useDevice = houghCUDAAvailable();
+      if (!m_useDevice) {
+        warning() << "No CUDA device available, the Hough accumulator is filled on the CPU" << endmsg;
+      }
+#else
+      warning() << "Built without CUDA (JUGGLER_ENABLE_CUDA), the Hough accumulator is filled on the CPU" << endmsg;
+#endif
+    } else if (m_backend.value() != "cpu") {
+      error() << "Unknown backend " << m_backend.value() << ", use cpu or cuda" << endmsg;
+      return StatusCode::FAILURE;
+    }
     return StatusCode::SUCCESS;
   }
 
-  StatusCode execute() override {
-    // input collection
-    //const eicd::TrackerHitCollection* hits = m_inputTrackerHits.get();
-    // Create output collections
-    //auto proto_tracks = m_outputProtoTracks.createAndPut();
+  void operator()(const eicd::TrackerHitCollection& hits, Jug::ProtoTrackContainer& protoTracks) const override {
+    const int nPhi = m_binning.nPhi;
+    const int nK   = m_binning.nCurvature;
 
-    return StatusCode::SUCCESS;
+    // transverse hit positions relative to the origin
+    std::vector<float> x(hits.size());
+    std::vector<float> y(hits.size());
+    for (size_t ihit = 0; ihit < hits.size(); ++ihit) {
+      x[ihit] = hits[ihit].getPosition().x;
+      y[ihit] = hits[ihit].getPosition().y;
+    }
+    // curvature bins [first, last] of a hit for phi0 bin i, empty if first > last
+    auto curvatureBins = [&](size_t ihit, int i) -> std::pair<int, int> {
+      int first = 0;
+      int last  = -1;
+      houghCurvatureBins(m_binning.cosEdge.data(), m_binning.sinEdge.data(), nK, m_binning.maxCurvature, x[ihit],
+                         y[ihit], i, first, last);
+      return {first, last};
+    };
+
+    // 1. fill the accumulator, phi0-major
+    std::vector<uint32_t> acc;
+    bool filled = false;
+#if defined(JUGGLER_HAVE_CUDA)
+    if (m_useDevice) {
+      filled = fillHoughAccumulatorCUDA(m_binning, x, y, acc);
+      if (!filled) {
+        warning() << "Hough accumulator fill on the CUDA device failed, filled on the CPU" << endmsg;
+      }
+    }
+#endif
+    if (!filled) {
+      fillHoughAccumulator(m_binning, x, y, acc);
+    }
+
+    // 2. local maxima in one pass, phi0 is periodic; equal neighbours are resolved by bin order
+    struct Peak {
+      uint32_t count;
+      int bin;
+    };
+    std::vector<Peak> peaks;
+    for (int i = 0; i < nPhi; ++i) {
+      for (int k = 0; k < nK; ++k) {
+        const int bin      = i * nK + k;
+        const uint32_t val = acc[bin];
+        if (val < static_cast<uint32_t>(m_minHits.value())) {
+          continue;
+        }
+        bool isMax = true;
+        for (int di = -1; di <= 1 && isMax; ++di) {
+          const int ni = (i + di + nPhi) % nPhi;
+          for (int dk = -1; dk <= 1 && isMax; ++dk) {
+            const int nk = k + dk;
+            if ((di == 0 && dk == 0) || nk < 0 || nk >= nK) {
+              continue;
+            }
+            const int nbin = ni * nK + nk;
+            isMax          = (nbin < bin) ? val > acc[nbin] : val >= acc[nbin];
+          }
+        }
+        if (isMax) {
+          peaks.push_back({val, bin});
+        }
+      }
+    }
+    // strongest first, in bin order for equal counts
+    std::sort(peaks.begin(), peaks.end(),
+              [](const Peak& a, const Peak& b) { return a.count != b.count ? a.count > b.count : a.bin < b.bin; });
+    if (peaks.size() > static_cast<size_t>(m_maxProtoTracks.value())) {
+      peaks.resize(m_maxProtoTracks.value());
+    }
+    if (msgLevel(MSG::DEBUG)) {
+      debug() << " Found " << peaks.size() << " Hough peaks." << endmsg;
+    }
+
+    // 3. map the peak bins and their neighbours to the peaks, the stronger peak owns shared bins
+    std::vector<int> peakOf(acc.size(), -1);
+    for (size_t ipeak = 0; ipeak < peaks.size(); ++ipeak) {
+      const int i = peaks[ipeak].bin / nK;
+      const int k = peaks[ipeak].bin % nK;
+      for (int di = -1; di <= 1; ++di) {
+        for (int dk = -1; dk <= 1; ++dk) {
+          const int nk = k + dk;
+          if (nk < 0 || nk >= nK) {
+            continue;
+          }
+          auto& owner = peakOf[((i + di + nPhi) % nPhi) * nK + nk];
+          if (owner < 0) {
+            owner = static_cast<int>(ipeak);
+          }
+        }
+      }
+    }
+
+    // 4. assign the hits to the peaks of the bins they fill
+    std::vector<Jug::ProtoTrack> tracks(peaks.size());
+    for (size_t ihit = 0; ihit < hits.size() && !peaks.empty(); ++ihit) {
+      for (int i = 0; i < nPhi; ++i) {
+        const auto [first, last] = curvatureBins(ihit, i);
+        for (int k = first; k <= last; ++k) {
+          const int ipeak = peakOf[i * nK + k];
+          if (ipeak >= 0 && (tracks[ipeak].empty() || tracks[ipeak].back() != ihit)) {
+            tracks[ipeak].push_back(ihit);
+          }
+        }
+      }
+    }
+    // 5. keep the proto tracks in peak order that do not mostly share the hits of stronger ones
+    std::vector<char> used(hits.size(), 0);
+    for (auto& track : tracks) {
+      if (track.size() < static_cast<size_t>(m_minHits.value())) {
+        continue;
+      }
+      const auto shared = std::count_if(track.begin(), track.end(), [&](size_t ihit) { return used[ihit] != 0; });
+      if (shared > m_maxSharedFraction.value() * track.size()) {
+        continue;
+      }
+      for (auto ihit : track) {
+        used[ihit] = 1;
+      }
+      protoTracks.push_back(std::move(track));
+    }
   }
 };
 // NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
@@ -25,9 +25,10 @@
 #include "eicd/ReconstructedParticleCollection.h"
 #include "eicd/TrackerHitCollection.h"
 #include "eicd/TrackParametersCollection.h"
-#include "JugTrack/IndexSourceLink.hpp"
+#include "JugBase/IndexSourceLink.hpp"
 #include "JugTrack/Track.hpp"
 #include "JugTrack/Trajectories.hpp"
+#include "JugTrack/TrajectorySummary.hpp"
 
 #include "Acts/Utilities/Helpers.hpp"
 
@@ -38,6 +39,9 @@
 namespace Jug::Reco {
 
   /** Extract the particles form fit trajectories.
+   *
+   *  With useSummaries, the trajectories are read from the summaries of TrajectorySummarizer
+   *  instead of being walked again.
    *
    * \ingroup tracking
    */
@@ -46,6 +50,11 @@ namespace Jug::Reco {
     DataHandle<TrajectoriesContainer>     m_inputTrajectories{"inputTrajectories", Gaudi::DataHandle::Reader, this};
     DataHandle<eicd::ReconstructedParticleCollection> m_outputParticles{"outputParticles", Gaudi::DataHandle::Writer, this};
     DataHandle<eicd::TrackParametersCollection> m_outputTrackParameters{"outputTrackParameters", Gaudi::DataHandle::Writer, this};
+    DataHandle<TrajectorySummaryContainer> m_inputTrajectorySummaries{"inputTrajectorySummaries", Gaudi::DataHandle::Reader, this};
+
+    Gaudi::Property<bool> m_useSummaries{this, "useSummaries", false, "Read the trajectory summaries of TrajectorySummarizer"};
+
+    Acts::GeometryContext m_geoContext;
 
    public:
     //  ill-formed: using GaudiAlgorithm::GaudiAlgorithm;
@@ -54,6 +63,7 @@ namespace Jug::Reco {
           declareProperty("inputTrajectories", m_inputTrajectories,"");
           declareProperty("outputParticles", m_outputParticles, "");
           declareProperty("outputTrackParameters", m_outputTrackParameters, "Acts Track Parameters");
+          declareProperty("inputTrajectorySummaries", m_inputTrajectorySummaries, "");
         }
 
     StatusCode initialize() override {
@@ -64,122 +74,102 @@ namespace Jug::Reco {
     }
 
     StatusCode execute() override {
-      // input collection
-      const auto* const trajectories = m_inputTrajectories.get();
       // create output collections
       auto* rec_parts = m_outputParticles.createAndPut();
       auto* track_pars = m_outputTrackParameters.createAndPut();
 
+      // one pass over the track states of every trajectory, unless already summarized
+      TrajectorySummaryContainer localSummaries;
+      const TrajectorySummaryContainer* summaries = &localSummaries;
+      if (m_useSummaries) {
+        summaries = m_inputTrajectorySummaries.get();
+      } else {
+        localSummaries = summarizeTrajectories(*m_inputTrajectories.get(), m_geoContext);
+      }
+
       if (msgLevel(MSG::DEBUG)) {
-        debug() << std::size(*trajectories) << " trajectories " << endmsg;
+        debug() << std::size(*summaries) << " trajectories " << endmsg;
       }
 
       // Loop over the trajectories
-        for (const auto& traj : *trajectories) {
-
-          // Get the entry index for the single trajectory
-          // The trajectory entry indices and the multiTrajectory
-          const auto& mj        = traj.multiTrajectory();
-          const auto& trackTips = traj.tips();
-          if (trackTips.empty()) {
-            if (msgLevel(MSG::DEBUG)) {
-              debug() << "Empty multiTrajectory." << endmsg;
-            }
-            continue;
+      for (const auto& summary : *summaries) {
+        // Get the fitted track parameter
+        //
+        if (summary.parameters) {
+          const auto& boundParam = *summary.parameters;
+          const auto& parameter  = boundParam.parameters();
+          const auto& covariance = *boundParam.covariance();
+          if (msgLevel(MSG::DEBUG)) {
+            debug() << "loc 0 = " << parameter[Acts::eBoundLoc0] << endmsg;
+            debug() << "loc 1 = " << parameter[Acts::eBoundLoc1] << endmsg;
+            debug() << "phi   = " << parameter[Acts::eBoundPhi] << endmsg;
+            debug() << "theta = " << parameter[Acts::eBoundTheta] << endmsg;
+            debug() << "q/p   = " << parameter[Acts::eBoundQOverP] << endmsg;
+            debug() << "p     = " << 1.0 / parameter[Acts::eBoundQOverP] << endmsg;
+
+            debug() << "err phi = " << sqrt(covariance(Acts::eBoundPhi, Acts::eBoundPhi)) << endmsg;
+            debug() << "err th  = " << sqrt(covariance(Acts::eBoundTheta, Acts::eBoundTheta)) << endmsg;
+            debug() << "err q/p = " << sqrt(covariance(Acts::eBoundQOverP, Acts::eBoundQOverP)) << endmsg;
+
+            debug() << " chi2 = " << summary.chi2Sum << endmsg;
           }
 
-          const auto& trackTip = trackTips.front();
-
-          // Collect the trajectory summary info
-          auto trajState       = Acts::MultiTrajectoryHelpers::trajectoryState(mj, trackTip);
-          //int  m_nMeasurements = trajState.nMeasurements;
-          //int  m_nStates       = trajState.nStates;
-
-          // Get the fitted track parameter
-          //
-          if (traj.hasTrackParameters(trackTip)) {
-            const auto& boundParam = traj.trackParameters(trackTip);
-            const auto& parameter  = boundParam.parameters();
-            const auto& covariance = *boundParam.covariance();
-            if (msgLevel(MSG::DEBUG)) {
-              debug() << "loc 0 = " << parameter[Acts::eBoundLoc0] << endmsg;
-              debug() << "loc 1 = " << parameter[Acts::eBoundLoc1] << endmsg;
-              debug() << "phi   = " << parameter[Acts::eBoundPhi] << endmsg;
-              debug() << "theta = " << parameter[Acts::eBoundTheta] << endmsg;
-              debug() << "q/p   = " << parameter[Acts::eBoundQOverP] << endmsg;
-              debug() << "p     = " << 1.0 / parameter[Acts::eBoundQOverP] << endmsg;
-
-              debug() << "err phi = " << sqrt(covariance(Acts::eBoundPhi, Acts::eBoundPhi)) << endmsg;
-              debug() << "err th  = " << sqrt(covariance(Acts::eBoundTheta, Acts::eBoundTheta)) << endmsg;
-              debug() << "err q/p = " << sqrt(covariance(Acts::eBoundQOverP, Acts::eBoundQOverP)) << endmsg;
-
-              debug() << " chi2 = " << trajState.chi2Sum << endmsg;
-            }
-
-            const eicd::Vector2f loc {
-              parameter[Acts::eBoundLoc0],
-              parameter[Acts::eBoundLoc1]
-            };
-            const eicd::Cov3f covMomentum {
-              static_cast<float>(covariance(Acts::eBoundTheta, Acts::eBoundTheta)),
-              static_cast<float>(covariance(Acts::eBoundPhi, Acts::eBoundPhi)),
-              static_cast<float>(covariance(Acts::eBoundQOverP, Acts::eBoundQOverP)),
-              static_cast<float>(covariance(Acts::eBoundTheta, Acts::eBoundPhi)),
-              static_cast<float>(covariance(Acts::eBoundTheta, Acts::eBoundQOverP)),
-              static_cast<float>(covariance(Acts::eBoundPhi, Acts::eBoundQOverP))};
-            const eicd::Cov2f covPos {
-              static_cast<float>(covariance(Acts::eBoundLoc0, Acts::eBoundLoc0)),
-              static_cast<float>(covariance(Acts::eBoundLoc1, Acts::eBoundLoc1)),
-              static_cast<float>(covariance(Acts::eBoundLoc0, Acts::eBoundLoc1))};
-            const float timeError{sqrt(static_cast<float>(covariance(Acts::eBoundTime, Acts::eBoundTime)))};
-
-            eicd::TrackParameters pars{
-              0, // type: track head --> 0
-              loc,
-              covPos,
-              static_cast<float>(parameter[Acts::eBoundTheta]),
-              static_cast<float>(parameter[Acts::eBoundPhi]),
-              static_cast<float>(parameter[Acts::eBoundQOverP]),
-              covMomentum,
-              static_cast<float>(parameter[Acts::eBoundTime]),
-              timeError,
-              static_cast<float>(boundParam.charge())};
-            track_pars->push_back(pars);
-          }
+          const eicd::Vector2f loc {
+            parameter[Acts::eBoundLoc0],
+            parameter[Acts::eBoundLoc1]
+          };
+          const eicd::Cov3f covMomentum {
+            static_cast<float>(covariance(Acts::eBoundTheta, Acts::eBoundTheta)),
+            static_cast<float>(covariance(Acts::eBoundPhi, Acts::eBoundPhi)),
+            static_cast<float>(covariance(Acts::eBoundQOverP, Acts::eBoundQOverP)),
+            static_cast<float>(covariance(Acts::eBoundTheta, Acts::eBoundPhi)),
+            static_cast<float>(covariance(Acts::eBoundTheta, Acts::eBoundQOverP)),
+            static_cast<float>(covariance(Acts::eBoundPhi, Acts::eBoundQOverP))};
+          const eicd::Cov2f covPos {
+            static_cast<float>(covariance(Acts::eBoundLoc0, Acts::eBoundLoc0)),
+            static_cast<float>(covariance(Acts::eBoundLoc1, Acts::eBoundLoc1)),
+            static_cast<float>(covariance(Acts::eBoundLoc0, Acts::eBoundLoc1))};
+          const float timeError{sqrt(static_cast<float>(covariance(Acts::eBoundTime, Acts::eBoundTime)))};
+
+          eicd::TrackParameters pars{
+            0, // type: track head --> 0
+            loc,
+            covPos,
+            static_cast<float>(parameter[Acts::eBoundTheta]),
+            static_cast<float>(parameter[Acts::eBoundPhi]),
+            static_cast<float>(parameter[Acts::eBoundQOverP]),
+            covMomentum,
+            static_cast<float>(parameter[Acts::eBoundTime]),
+            timeError,
+            static_cast<float>(boundParam.charge())};
+          track_pars->push_back(pars);
+        }
+
+        // the particle is made from the predicted parameters of the innermost state
+        if (summary.states.empty()) {
+          continue;
+        }
+        const auto& params = summary.states.back().parameters;
 
-          auto tsize = trackTips.size();
+        double p0 = (1.0 / params[Acts::eBoundQOverP]) / Acts::UnitConstants::GeV;
+        if (msgLevel(MSG::DEBUG)) {
+          debug() << "track predicted p = " << p0 << " GeV" << endmsg;
+        }
+        if (std::abs(p0) > 500) {
           if (msgLevel(MSG::DEBUG)) {
-            debug() << "# fitted parameters : " << tsize << endmsg;
-          }
-          if (tsize == 0) {
-            continue;
+            debug() << "skipping" << endmsg;
           }
+          continue;
+        }
 
-          mj.visitBackwards(tsize - 1, [&](auto&& trackstate) {
-            // debug() << trackstate.hasPredicted() << endmsg;
-            // debug() << trackstate.predicted() << endmsg;
-            auto params = trackstate.predicted(); //<< endmsg;
-
-            double p0 = (1.0 / params[Acts::eBoundQOverP]) / Acts::UnitConstants::GeV;
-            if (msgLevel(MSG::DEBUG)) {
-              debug() << "track predicted p = " << p0 << " GeV" << endmsg;
-            }
-            if (std::abs(p0) > 500) {
-              if (msgLevel(MSG::DEBUG)) {
-                debug() << "skipping" << endmsg;
-              }
-              return;
-            }
-
-            auto rec_part = rec_parts->create();
-            rec_part.setMomentum(
-              eicd::sphericalToVector(
-                1.0 / std::abs(params[Acts::eBoundQOverP]),
-                params[Acts::eBoundTheta],
-                params[Acts::eBoundPhi])
-            );
-            rec_part.setCharge(static_cast<int16_t>(std::copysign(1., params[Acts::eBoundQOverP])));
-          });
+        auto rec_part = rec_parts->create();
+        rec_part.setMomentum(
+          eicd::sphericalToVector(
+            1.0 / std::abs(params[Acts::eBoundQOverP]),
+            params[Acts::eBoundTheta],
+            params[Acts::eBoundPhi])
+        );
+        rec_part.setCharge(static_cast<int16_t>(std::copysign(1., params[Acts::eBoundQOverP])));
       }
 
       return StatusCode::SUCCESS;
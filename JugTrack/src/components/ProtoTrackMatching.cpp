@@ -1,7 +1,12 @@
 // SPDX-License-Identifier: LGPL-3.0-or-later
 // Copyright (C) 2022 Whitney Armstrong
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
 // Gaudi
 #include "Gaudi/Property.h"
 #include "GaudiAlg/GaudiAlgorithm.h"
@@ -17,10 +22,18 @@
 #include "Math/Vector3D.h"
 
 #include "eicd/TrackerHitCollection.h"
+#include "eicd/vector_utils.h"
 
 namespace Jug::Reco {
 
-/** Template finder.
+/** Matching of the proto tracks to the initial track parameters (seeds).
+ *
+ *  The default matchingMode "index" pairs them by index. With "angular", the mean hit direction
+ *  (eta, phi) of every proto track is computed once and the proto tracks are bucketed in an
+ *  eta-phi grid of cells of maxDeltaEta by maxDeltaPhi, so that every seed only compares its
+ *  direction with the proto tracks of the neighbouring cells, and gets the closest one in the
+ *  window (an empty proto track, i.e. no fit, without). The matching is then linear in the seeds
+ *  and the proto tracks, e.g. for the Hough or conformal proto tracks and calorimeter seeds.
  *
  *  \ingroup tracking
  */
@@ -31,6 +44,16 @@ private:
   DataHandle<ProtoTrackContainer> m_inputProtoTracks{"inputProtoTracks", Gaudi::DataHandle::Reader, this};
   DataHandle<ProtoTrackContainer> m_outputProtoTracks{"matchedProtoTracks", Gaudi::DataHandle::Writer, this};
 
+  Gaudi::Property<std::string> m_matchingMode{this, "matchingMode", "index"}; // index or angular
+  Gaudi::Property<double> m_maxDeltaEta{this, "maxDeltaEta", 0.2};
+  Gaudi::Property<double> m_maxDeltaPhi{this, "maxDeltaPhi", 0.2}; // rad
+
+  // mean directions of the proto tracks, and the grid cells of the proto tracks (compressed rows)
+  std::vector<double> m_eta;
+  std::vector<double> m_phi;
+  std::vector<uint32_t> m_cellBegin;
+  std::vector<uint32_t> m_cellProtos;
+
 public:
   ProtoTrackMatching(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
     declareProperty("inputTrackerHits",     m_inputTrackerHits,     "");
@@ -43,10 +66,23 @@ public:
     if (GaudiAlgorithm::initialize().isFailure()) {
       return StatusCode::FAILURE;
     }
+    if (m_matchingMode.value() != "index" && m_matchingMode.value() != "angular") {
+      error() << "Unknown matchingMode " << m_matchingMode.value() << ", index or angular" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    if (m_maxDeltaEta.value() <= 0. || m_maxDeltaPhi.value() <= 0.) {
+      error() << "maxDeltaEta and maxDeltaPhi must be positive" << endmsg;
+      return StatusCode::FAILURE;
+    }
     return StatusCode::SUCCESS;
   }
 
   StatusCode execute() override {
+    if (m_matchingMode.value() == "angular") {
+      matchAngular(*m_inputTrackerHits.get(), *m_inputProtoTracks.get(), *m_initialTrackParameters.get(),
+                   *m_outputProtoTracks.createAndPut());
+      return StatusCode::SUCCESS;
+    }
     // input collection
     
     // hits is unused, commented out for now to avoid compiler warning
@@ -98,6 +134,107 @@ public:
     }
     return StatusCode::SUCCESS;
   }
+
+private:
+  void matchAngular(const eicd::TrackerHitCollection& hits, const ProtoTrackContainer& protoTracks,
+                    const TrackParametersContainer& initialParameters, ProtoTrackContainer& matched) {
+    const size_t nproto = protoTracks.size();
+    m_eta.assign(nproto, 0.);
+    m_phi.assign(nproto, 0.);
+    double etaMin = std::numeric_limits<double>::max();
+    double etaMax = std::numeric_limits<double>::lowest();
+    for (size_t i = 0; i < nproto; ++i) {
+      // mean eta, and the circular mean of phi
+      double eta  = 0.;
+      double sinp = 0.;
+      double cosp = 0.;
+      size_t n    = 0;
+      for (const auto ihit : protoTracks[i]) {
+        if (ihit < hits.size()) {
+          const auto pos = hits[ihit].getPosition();
+          const double p = eicd::angleAzimuthal(pos);
+          eta += eicd::eta(pos);
+          sinp += std::sin(p);
+          cosp += std::cos(p);
+          ++n;
+        }
+      }
+      m_eta[i] = (n > 0) ? eta / n : std::numeric_limits<double>::quiet_NaN();
+      m_phi[i] = std::atan2(sinp, cosp);
+      if (n > 0) {
+        etaMin = std::min(etaMin, m_eta[i]);
+        etaMax = std::max(etaMax, m_eta[i]);
+      }
+    }
+
+    // eta-phi grid of the proto tracks with directions
+    const double deta = m_maxDeltaEta.value();
+    const double dphi = m_maxDeltaPhi.value();
+    const size_t neta = (etaMax >= etaMin) ? static_cast<size_t>((etaMax - etaMin) / deta) + 1 : 0;
+    const auto nphi   = std::max<size_t>(static_cast<size_t>(2. * M_PI / dphi), 1);
+    auto phiCell      = [&](double phi) {
+      return std::min(static_cast<size_t>((phi + M_PI) / (2. * M_PI) * nphi), nphi - 1);
+    };
+    m_cellBegin.assign(neta * nphi + 1, 0);
+    std::vector<size_t> cell(nproto, neta * nphi);
+    for (size_t i = 0; i < nproto; ++i) {
+      if (!std::isnan(m_eta[i])) {
+        cell[i] = static_cast<size_t>((m_eta[i] - etaMin) / deta) * nphi + phiCell(m_phi[i]);
+        ++m_cellBegin[cell[i] + 1];
+      }
+    }
+    for (size_t c = 0; c < neta * nphi; ++c) {
+      m_cellBegin[c + 1] += m_cellBegin[c];
+    }
+    m_cellProtos.resize(m_cellBegin.back());
+    std::vector<uint32_t> fill(m_cellBegin.begin(), m_cellBegin.end() - 1);
+    for (size_t i = 0; i < nproto; ++i) {
+      if (cell[i] < neta * nphi) {
+        m_cellProtos[fill[cell[i]]++] = static_cast<uint32_t>(i);
+      }
+    }
+
+    // closest proto track in the window of every seed, in the neighbouring cells
+    size_t nmatched = 0;
+    matched.reserve(initialParameters.size());
+    for (const auto& seed : initialParameters) {
+      const auto& par    = seed.parameters();
+      const double eta   = -std::log(std::tan(0.5 * par[Acts::eBoundTheta]));
+      const double phi   = par[Acts::eBoundPhi];
+      const double ceta  = std::floor((eta - etaMin) / deta);
+      const size_t cphi  = phiCell(std::remainder(phi, 2. * M_PI));
+      double best        = 0.;
+      size_t ibest       = nproto;
+      for (double e = ceta - 1.; e <= ceta + 1.; e += 1.) {
+        if (e < 0. || e >= static_cast<double>(neta)) {
+          continue;
+        }
+        for (size_t k = 0; k < std::min<size_t>(nphi, 3); ++k) {
+          const size_t c = static_cast<size_t>(e) * nphi + (cphi + nphi - 1 + k) % nphi;
+          for (uint32_t j = m_cellBegin[c]; j < m_cellBegin[c + 1]; ++j) {
+            const uint32_t i = m_cellProtos[j];
+            const double de  = (m_eta[i] - eta) / deta;
+            const double dp  = std::remainder(m_phi[i] - phi, 2. * M_PI) / dphi;
+            const double d2  = de * de + dp * dp;
+            if (std::abs(de) <= 1. && std::abs(dp) <= 1. && (ibest == nproto || d2 < best)) {
+              best  = d2;
+              ibest = i;
+            }
+          }
+        }
+      }
+      if (ibest < nproto) {
+        matched.push_back(protoTracks[ibest]);
+        ++nmatched;
+      } else {
+        matched.emplace_back();
+      }
+    }
+    if (msgLevel(MSG::DEBUG)) {
+      debug() << nmatched << " of " << initialParameters.size() << " seeds matched to " << nproto << " proto tracks"
+              << endmsg;
+    }
+  }
 };
 // NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
 DECLARE_COMPONENT(ProtoTrackMatching)
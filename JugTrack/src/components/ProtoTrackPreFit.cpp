@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include <cmath>
+#include <vector>
+
+#include "Gaudi/Accumulators.h"
+#include "Gaudi/Property.h"
+#include "GaudiAlg/GaudiAlgorithm.h"
+
+#include "Acts/Definitions/Units.hpp"
+
+#include "JugBase/DataHandle.h"
+#include "JugBase/IGeoSvc.h"
+#include "JugTrack/ChargeEstimator.hpp"
+#include "JugTrack/HelixPreFit.hpp"
+#include "JugTrack/ProtoTrack.hpp"
+#include "JugTrack/Track.hpp"
+#include "JugTrack/TrackParamInit.hpp"
+
+#include "eicd/TrackerHitCollection.h"
+
+namespace Jug::Reco {
+
+/** Helix pre-fit of the proto tracks, before the full fit.
+ *
+ *  The proto tracks of the conformal and Hough proto-trackers are fitted with the analytic helix
+ *  pre-fit (HelixPreFit): the inconsistent ones are dropped, the outlier hits of the others are
+ *  removed. The kept proto tracks are written with their pre-fit parameters (one per proto track,
+ *  at the perigee of z0, the charge from the bending in the solenoid), the inputs of
+ *  TrackFittingAlgorithm or GenFitTrackFitter, so that the full fits are only run on the viable
+ *  candidates.
+ *
+ *  \ingroup tracking
+ */
+class ProtoTrackPreFit : public GaudiAlgorithm {
+private:
+  DataHandle<eicd::TrackerHitCollection> m_inputTrackerHits{"inputTrackerHits", Gaudi::DataHandle::Reader, this};
+  DataHandle<Jug::ProtoTrackContainer> m_inputProtoTracks{"inputProtoTracks", Gaudi::DataHandle::Reader, this};
+  DataHandle<Jug::ProtoTrackContainer> m_outputProtoTracks{"outputProtoTracks", Gaudi::DataHandle::Writer, this};
+  DataHandle<TrackParametersContainer> m_outputInitialTrackParameters{"outputInitialTrackParameters",
+                                                                      Gaudi::DataHandle::Writer, this};
+
+  Gaudi::Property<double> m_sigmaRPhi{this, "sigmaRPhi", 0.1, "Transverse hit resolution (mm)"};
+  Gaudi::Property<double> m_sigmaZ{this, "sigmaZ", 0.5, "Longitudinal hit resolution (mm)"};
+  Gaudi::Property<double> m_maxChi2ndf{this, "maxChi2ndf", 10., "Largest chi2/ndf of a kept proto track"};
+  Gaudi::Property<size_t> m_minHits{this, "minHits", 4, "Fewest hits of a kept proto track (at least 3)"};
+  Gaudi::Property<size_t> m_maxOutliers{this, "maxOutliers", 2, "Outlier hits removed from a proto track"};
+  /// Momentum of the straight tracks (or without field)
+  Gaudi::Property<double> m_maxMomentum{this, "maxMomentum", 100., "Largest transverse momentum (GeV)"};
+
+  Gaudi::Accumulators::Counter<> m_protoTrackCounter{this, "Proto tracks"};
+  Gaudi::Accumulators::Counter<> m_rejectedCounter{this, "Rejected proto tracks"};
+  Gaudi::Accumulators::Counter<> m_outlierCounter{this, "Outlier hits"};
+
+  HelixPreFit m_preFit;
+  TrackParamInit m_init;
+  double m_fieldZ{0.};
+
+public:
+  ProtoTrackPreFit(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
+    declareProperty("inputTrackerHits", m_inputTrackerHits, "tracker hits whose indices are used in proto-tracks");
+    declareProperty("inputProtoTracks", m_inputProtoTracks, "");
+    declareProperty("outputProtoTracks", m_outputProtoTracks, "kept proto tracks without their outliers");
+    declareProperty("outputInitialTrackParameters", m_outputInitialTrackParameters, "pre-fit parameters");
+  }
+
+  StatusCode initialize() override {
+    if (GaudiAlgorithm::initialize().isFailure()) {
+      return StatusCode::FAILURE;
+    }
+    if (m_minHits.value() < 3 || !(m_sigmaRPhi.value() > 0) || !(m_sigmaZ.value() > 0)) {
+      error() << "minHits must be at least 3 and the resolutions positive" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    auto geoSvc = service<IGeoSvc>("GeoSvc");
+    if (!geoSvc) {
+      error() << "Unable to locate Geometry Service for the field" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    const auto fieldZ = ChargeEstimator::fieldZ(*geoSvc->getFieldProvider());
+    if (!fieldZ) {
+      error() << "Cannot evaluate the field at the origin" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    m_fieldZ = *fieldZ;
+    m_preFit = HelixPreFit({m_sigmaRPhi.value(), m_sigmaZ.value(), m_maxChi2ndf.value(), m_minHits.value(),
+                            m_maxOutliers.value()});
+    return StatusCode::SUCCESS;
+  }
+
+  StatusCode execute() override {
+    using Acts::UnitConstants::GeV;
+    // input collections
+    const auto* const hits        = m_inputTrackerHits.get();
+    const auto* const protoTracks = m_inputProtoTracks.get();
+    // Create output collections
+    auto* keptProtoTracks = m_outputProtoTracks.createAndPut();
+    auto* init_trk_params = m_outputInitialTrackParameters.createAndPut();
+
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> z;
+    for (const auto& protoTrack : *protoTracks) {
+      x.clear();
+      y.clear();
+      z.clear();
+      for (const auto ihit : protoTrack) {
+        const auto& position = (*hits)[ihit].getPosition();
+        x.push_back(position.x);
+        y.push_back(position.y);
+        z.push_back(position.z);
+      }
+      const auto result = m_preFit.fit(x, y, z);
+      if (!result.ok) {
+        ++m_rejectedCounter;
+        if (msgLevel(MSG::DEBUG)) {
+          debug() << "Proto track of " << protoTrack.size() << " hits rejected, chi2/ndf " << result.chi2ndf
+                  << endmsg;
+        }
+        continue;
+      }
+      m_outlierCounter += protoTrack.size() - result.hits.size();
+
+      auto& kept = keptProtoTracks->emplace_back();
+      for (const auto i : result.hits) {
+        kept.push_back(protoTrack[i]);
+      }
+      // pT = |B| R, counterclockwise for the negative charges in a field along +z
+      const double kappa = std::abs(result.curvature);
+      const double pt    = (kappa * m_maxMomentum.value() * GeV > std::abs(m_fieldZ))
+                               ? std::abs(m_fieldZ) / kappa
+                               : m_maxMomentum.value() * GeV;
+      const double p     = pt / std::sin(result.theta);
+      const int charge   = (result.curvature * m_fieldZ > 0) ? -1 : 1;
+      init_trk_params->emplace_back(m_init.surface(Acts::Vector3{0., 0., result.z0}),
+                                    TrackParamInit::parameters(result.phi, result.theta, charge / p), charge);
+    }
+    m_protoTrackCounter += protoTracks->size();
+    return StatusCode::SUCCESS;
+  }
+};
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(ProtoTrackPreFit)
+
+} // namespace Jug::Reco
@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include <cmath>
+#include <limits>
+#include <unordered_set>
+
+#include "Gaudi/Property.h"
+#include "GaudiKernel/PhysicalConstants.h"
+
+#include "JugBase/Transformer.h"
+
+// Event Model related classes
+#include "eicd/TrackerHitCollection.h"
+
+using namespace Gaudi::Units;
+
+namespace Jug::Reco {
+
+/** Candidate hits for track seeding.
+ *
+ *  Keeps the tracker hits inside the seeding envelope (r < rMax, zMin < z < zMax, the defaults of
+ *  TrackParamACTSSeeding) and the time window, and drops the repeated cellIDs of merged hit
+ *  collections (e.g. from TrackingHitsCollector2), so that the combinatorial seeding only sees
+ *  the hits that can make seeds.
+ *
+ * \ingroup tracking
+ */
+class SeedingHitFilter : public Jug::Transformer<eicd::TrackerHitCollection, eicd::TrackerHitCollection> {
+private:
+  Gaudi::Property<double> m_rMax{this, "rMax", 440. * mm};
+  Gaudi::Property<double> m_zMin{this, "zMin", -1500. * mm};
+  Gaudi::Property<double> m_zMax{this, "zMax", 1700. * mm};
+  Gaudi::Property<double> m_timeMin{this, "timeMin", -std::numeric_limits<double>::infinity()};
+  Gaudi::Property<double> m_timeMax{this, "timeMax", std::numeric_limits<double>::infinity()};
+  Gaudi::Property<bool> m_deduplicate{this, "deduplicate", true, "Keep only the first hit of a cellID"};
+
+public:
+  SeedingHitFilter(const std::string& name, ISvcLocator* svcLoc)
+      : MultiTransformer(name, svcLoc, {KeyValue{"inputHitCollection", "inputHitCollection"}},
+                         {KeyValue{"outputHitCollection", "outputHitCollection"}}) {}
+
+  StatusCode initialize() override {
+    if (Gaudi::Algorithm::initialize().isFailure()) {
+      return StatusCode::FAILURE;
+    }
+    if (m_rMax.value() <= 0. || m_zMax.value() <= m_zMin.value() || m_timeMax.value() < m_timeMin.value()) {
+      error() << "Empty seeding envelope or time window" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    return StatusCode::SUCCESS;
+  }
+
+  void operator()(const eicd::TrackerHitCollection& hits, eicd::TrackerHitCollection& selected) const override {
+    const double rMax2   = m_rMax.value() * m_rMax.value();
+    const double zMin    = m_zMin.value();
+    const double zMax    = m_zMax.value();
+    const double timeMin = m_timeMin.value();
+    const double timeMax = m_timeMax.value();
+    std::unordered_set<uint64_t> cells;
+    if (m_deduplicate) {
+      cells.reserve(hits.size());
+    }
+
+    size_t outside    = 0;
+    size_t duplicates = 0;
+    for (const auto& hit : hits) {
+      const auto& pos = hit.getPosition();
+      const double r2 = pos.x * pos.x + pos.y * pos.y;
+      if (!(r2 < rMax2 && pos.z > zMin && pos.z < zMax && hit.getTime() >= timeMin && hit.getTime() <= timeMax)) {
+        ++outside;
+        continue;
+      }
+      if (m_deduplicate && !cells.insert(hit.getCellID()).second) {
+        ++duplicates;
+        continue;
+      }
+      selected.push_back(hit.clone());
+    }
+
+    if (msgLevel(MSG::DEBUG)) {
+      debug() << selected.size() << " of " << hits.size() << " hits selected, " << outside
+              << " outside of the envelope, " << duplicates << " duplicates" << endmsg;
+    }
+  }
+};
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(SeedingHitFilter)
+
+} // namespace Jug::Reco
@@ -11,6 +11,7 @@
 
 #include "JugBase/DataHandle.h"
 #include "JugBase/IGeoSvc.h"
+#include "JugBase/SurfaceIndex.h"
 
 #include "DD4hep/DD4hepUnits.h"
 #include "DD4hep/Volumes.h"
@@ -24,9 +25,9 @@
 #include "Acts/Plugins/DD4hep/DD4hepDetectorElement.hpp"
 #include "Acts/Surfaces/Surface.hpp"
 
-#include "JugTrack/GeometryContainers.hpp"
-#include "JugTrack/Index.hpp"
-#include "JugTrack/IndexSourceLink.hpp"
+#include "JugBase/GeometryContainers.hpp"
+#include "JugBase/Index.hpp"
+#include "JugBase/IndexSourceLink.hpp"
 #include "JugTrack/Measurement.hpp"
 #include "JugTrack/ProtoTrack.hpp"
 
@@ -43,7 +44,7 @@ namespace Jug::Reco {
 class SingleTrackSourceLinker : public GaudiAlgorithm {
 private:
   DataHandle<eicd::TrackerHitCollection> m_inputHitCollection{"inputHitCollection", Gaudi::DataHandle::Reader, this};
-  DataHandle<std::list<IndexSourceLink>> m_sourceLinkStorage{"sourceLinkStorage", Gaudi::DataHandle::Writer, this};
+  DataHandle<IndexSourceLinkStorage> m_sourceLinkStorage{"sourceLinkStorage", Gaudi::DataHandle::Writer, this};
   DataHandle<IndexSourceLinkContainer> m_outputSourceLinks{"outputSourceLinks", Gaudi::DataHandle::Writer, this};
   DataHandle<MeasurementContainer> m_outputMeasurements{"outputMeasurements", Gaudi::DataHandle::Writer, this};
   DataHandle<ProtoTrackContainer> m_outputProtoTracks{"outputProtoTracks", Gaudi::DataHandle::Writer, this};
@@ -82,6 +83,8 @@ public:
     auto* protoTracks  = m_outputProtoTracks.createAndPut();
     // IndexMultimap<ActsFatras::Barcode> hitParticlesMap;
     // IndexMultimap<Index> hitSimHitsMap;
+    // the source links and measurements reference the storage, so it must not reallocate
+    linkStorage->reserve(hits->size());
     sourceLinks->reserve(hits->size());
     measurements->reserve(hits->size());
 
@@ -97,16 +100,15 @@ public:
 
       track.emplace_back(ihit);
 
-      const auto* vol_ctx = m_geoSvc->cellIDPositionConverter()->findContext(ahit.getCellID());
-      auto vol_id   = vol_ctx->identifier;
-      const auto is = m_geoSvc->surfaceMap().find(vol_id);
-      if (is == m_geoSvc->surfaceMap().end()) {
+      const auto* is = m_geoSvc->surfaceIndex().find(ahit.getCellID());
+      if (is == nullptr || is->surface == nullptr) {
         if (msgLevel(MSG::DEBUG)) {
-          debug() << " vol_id (" << vol_id << ")  not found in m_surfaces!!!!" << endmsg;
+          debug() << " cellID (" << ahit.getCellID() << ")  not found in m_surfaces!!!!" << endmsg;
         }
         continue;
       }
-      const Acts::Surface* surface = is->second;
+      const auto vol_id            = is->volumeID;
+      const Acts::Surface* surface = is->surface;
 
       // NOTE
       // Here is where the important hit and tracking geometry is connected.
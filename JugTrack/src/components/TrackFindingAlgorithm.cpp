@@ -29,14 +29,15 @@
 #include "Acts/Utilities/Logger.hpp"
 #include "Acts/Definitions/Units.hpp"
 
+#include "JugBase/ACTSLogger.h"
 #include "JugBase/DataHandle.h"
 #include "JugBase/IGeoSvc.h"
 #include "JugBase/BField/DD4hepBField.h"
 
-#include "JugTrack/GeometryContainers.hpp"
+#include "JugBase/GeometryContainers.hpp"
 #include "JugTrack/Measurement.hpp"
-#include "JugTrack/Index.hpp"
-#include "JugTrack/IndexSourceLink.hpp"
+#include "JugBase/Index.hpp"
+#include "JugBase/IndexSourceLink.hpp"
 #include "JugTrack/Track.hpp"
 
 
@@ -49,15 +50,6 @@
 #include <stdexcept>
 
 
-static const std::map<int, Acts::Logging::Level> s_msgMap = {
-    {MSG::DEBUG, Acts::Logging::DEBUG},
-    {MSG::VERBOSE, Acts::Logging::VERBOSE},
-    {MSG::INFO, Acts::Logging::INFO},
-    {MSG::WARNING, Acts::Logging::WARNING},
-    {MSG::FATAL, Acts::Logging::FATAL},
-    {MSG::ERROR, Acts::Logging::ERROR},
-};
-
 namespace Jug::Reco {
 
   using namespace Acts::UnitLiterals;
@@ -84,8 +76,8 @@ namespace Jug::Reco {
       return StatusCode::FAILURE;
     }
 
-    m_BField   = std::dynamic_pointer_cast<const Jug::BField::DD4hepBField>(m_geoSvc->getFieldProvider());
-    m_fieldctx = Jug::BField::BFieldVariant(m_BField);
+    // the DD4hep field or the field map of GeoSvc, the field context is not used by either
+    m_BField = m_geoSvc->getFieldProvider();
 
     // eta bins, chi2 and #sourclinks per surface cutoffs
     m_sourcelinkSelectorCfg = {
@@ -96,10 +88,16 @@ namespace Jug::Reco {
         },
     };
     m_trackFinderFunc = TrackFindingAlgorithm::makeTrackFinderFunction(m_geoSvc->trackingGeometry(), m_BField);
-    auto im = s_msgMap.find(msgLevel());
-    if (im != s_msgMap.end()) {
-        m_actsLoggingLevel = im->second;
-    }
+    // Construct a perigee surface as the target surface
+    m_targetSurface = Acts::Surface::makeShared<Acts::PerigeeSurface>(Acts::Vector3{0., 0., 0.});
+    m_actsLogger    = Jug::makeActsLogger(name(), msgSvc(), msgLevel());
+
+    m_propagatorOptions.maxSteps = 10000;
+
+    m_measSel.emplace(m_sourcelinkSelectorCfg);
+    m_extensions.updater.connect<&Acts::GainMatrixUpdater::operator()>(&m_kfUpdater);
+    m_extensions.smoother.connect<&Acts::GainMatrixSmoother::operator()>(&m_kfSmoother);
+    m_extensions.measurementSelector.connect<&Acts::MeasurementSelector::select>(&(*m_measSel));
     return StatusCode::SUCCESS;
   }
 
@@ -115,26 +113,10 @@ namespace Jug::Reco {
     auto* trajectories = m_outputTrajectories.createAndPut();
     trajectories->reserve(init_trk_params->size());
 
-    //// Construct a perigee surface as the target surface
-    auto pSurface = Acts::Surface::makeShared<Acts::PerigeeSurface>(Acts::Vector3{0., 0., 0.});
-
-    ACTS_LOCAL_LOGGER(Acts::getDefaultLogger("TrackFindingAlgorithm Logger", m_actsLoggingLevel));
-
-    Acts::PropagatorPlainOptions pOptions;
-    pOptions.maxSteps = 10000;
-
+    // only the calibrator and the source link accessor depend on the event
+    auto extensions = m_extensions;
     MeasurementCalibrator calibrator{*measurements};
-    Acts::GainMatrixUpdater kfUpdater;
-    Acts::GainMatrixSmoother kfSmoother;
-    Acts::MeasurementSelector measSel{m_sourcelinkSelectorCfg};
-
-    Acts::CombinatorialKalmanFilterExtensions extensions;
     extensions.calibrator.connect<&MeasurementCalibrator::calibrate>(&calibrator);
-    extensions.updater.connect<&Acts::GainMatrixUpdater::operator()>(&kfUpdater);
-    extensions.smoother.connect<&Acts::GainMatrixSmoother::operator()>(
-        &kfSmoother);
-    extensions.measurementSelector.connect<&Acts::MeasurementSelector::select>(
-        &measSel);
 
     IndexSourceLinkAccessor slAccessor;
     slAccessor.container = src_links;
@@ -145,7 +127,7 @@ namespace Jug::Reco {
     // Set the CombinatorialKalmanFilter options
     TrackFindingAlgorithm::TrackFinderOptions options(
         m_geoctx, m_fieldctx, m_calibctx, slAccessorDelegate,
-        extensions, Acts::LoggerWrapper{logger()}, pOptions, &(*pSurface));
+        extensions, Acts::LoggerWrapper{logger()}, m_propagatorOptions, m_targetSurface.get());
 
     auto results = (*m_trackFinderFunc)(*init_trk_params, options);
 
@@ -16,9 +16,9 @@
 #include "JugBase/DataHandle.h"
 #include "JugBase/IGeoSvc.h"
 #include "JugBase/BField/DD4hepBField.h"
-#include "JugTrack/GeometryContainers.hpp"
-#include "JugTrack/Index.hpp"
-#include "JugTrack/IndexSourceLink.hpp"
+#include "JugBase/GeometryContainers.hpp"
+#include "JugBase/Index.hpp"
+#include "JugBase/IndexSourceLink.hpp"
 #include "JugTrack/Measurement.hpp"
 #include "JugTrack/Track.hpp"
 #include "JugTrack/Trajectories.hpp"
@@ -29,6 +29,12 @@
 #include "Acts/Geometry/TrackingGeometry.hpp"
 #include "Acts/TrackFinding/CombinatorialKalmanFilter.hpp"
 #include "Acts/TrackFinding/MeasurementSelector.hpp"
+#include "Acts/TrackFitting/GainMatrixSmoother.hpp"
+#include "Acts/TrackFitting/GainMatrixUpdater.hpp"
+#include "Acts/Utilities/Logger.hpp"
+
+#include <memory>
+#include <optional>
 
 namespace Jug::Reco {
 
@@ -74,19 +80,32 @@ public:
   std::shared_ptr<TrackFinderFunction> m_trackFinderFunc;
   SmartIF<IGeoSvc> m_geoSvc;
 
-  std::shared_ptr<const Jug::BField::DD4hepBField> m_BField = nullptr;
+  std::shared_ptr<const Acts::MagneticFieldProvider> m_BField = nullptr;
   Acts::GeometryContext m_geoctx;
   Acts::CalibrationContext m_calibctx;
   Acts::MagneticFieldContext m_fieldctx;
 
   Acts::MeasurementSelector::Config m_sourcelinkSelectorCfg;
-  Acts::Logging::Level m_actsLoggingLevel = Acts::Logging::INFO;
+
+  /// Track finder pieces that do not depend on the event, made in initialize()
+  std::shared_ptr<const Acts::Surface> m_targetSurface;
+  std::unique_ptr<const Acts::Logger> m_actsLogger;
+  Acts::PropagatorPlainOptions m_propagatorOptions;
+  Acts::GainMatrixUpdater m_kfUpdater;
+  Acts::GainMatrixSmoother m_kfSmoother;
+  std::optional<Acts::MeasurementSelector> m_measSel;
+  /// Updater, smoother and selector connected, the calibrator is connected per event
+  Acts::CombinatorialKalmanFilterExtensions m_extensions;
 
   TrackFindingAlgorithm(const std::string& name, ISvcLocator* svcLoc);
 
   StatusCode initialize() override;
 
   StatusCode execute() override;
+
+private:
+  /// ACTS logger of the algorithm, for the ACTS_* logging macros
+  const Acts::Logger& logger() const { return *m_actsLogger; }
 };
 
 } // namespace Jug::Reco
@@ -27,19 +27,22 @@
 #include "Acts/Utilities/Logger.hpp"
 #include "Acts/Definitions/Units.hpp"
 
+#include "JugBase/ACTSLogger.h"
 #include "JugBase/DataHandle.h"
 #include "JugBase/IGeoSvc.h"
 #include "JugBase/BField/DD4hepBField.h"
 
-#include "JugTrack/GeometryContainers.hpp"
-#include "JugTrack/IndexSourceLink.hpp"
+#include "JugBase/GeometryContainers.hpp"
+#include "JugBase/IndexSourceLink.hpp"
 #include "JugTrack/Track.hpp"
 #include "JugTrack/Measurement.hpp"
 
 #include "eicd/TrackerHitCollection.h"
 
+#include <algorithm>
 #include <functional>
 #include <stdexcept>
+#include <system_error>
 #include <vector>
 #include <random>
 #include <stdexcept>
@@ -57,6 +60,7 @@ namespace Jug::Reco {
     declareProperty("inputProtoTracks", m_inputProtoTracks, "");
     declareProperty("foundTracks", m_foundTracks, "");
     declareProperty("outputTrajectories", m_outputTrajectories, "");
+    declareProperty("outputCompactTrajectories", m_outputCompactTrajectories, "");
   }
 
   StatusCode TrackFittingAlgorithm::initialize()
@@ -70,120 +74,91 @@ namespace Jug::Reco {
               << "Make sure you have GeoSvc and SimSvc in the right order in the configuration." << endmsg;
       return StatusCode::FAILURE;
     }
-    m_BField   = std::dynamic_pointer_cast<const Jug::BField::DD4hepBField>(m_geoSvc->getFieldProvider());
-    m_fieldctx = Jug::BField::BFieldVariant(m_BField);
+    // the DD4hep field or the field map of GeoSvc, the field context is not used by either
+    m_BField = m_geoSvc->getFieldProvider();
 
     // chi2 and #sourclinks per surface cutoffs
     //m_sourcelinkSelectorCfg = {
     //    {Acts::GeometryIdentifier(), {15, 10}},
     //};
     m_trackFittingFunc = makeTrackFittingFunction(m_geoSvc->trackingGeometry(), m_BField);
-    return StatusCode::SUCCESS;
-  }
-
-  StatusCode TrackFittingAlgorithm::execute()
-  {
-    // Read input data
-    const auto* const sourceLinks       = m_inputSourceLinks.get();
-    const auto* const initialParameters = m_initialTrackParameters.get();
-    const auto* const measurements      = m_inputMeasurements.get();
-    const auto* const protoTracks       = m_inputProtoTracks.get();
-    ACTS_LOCAL_LOGGER(Acts::getDefaultLogger("TrackFittingAlgorithm Logger", Acts::Logging::INFO));
-
-    // Consistency cross checks
-    if (protoTracks->size() != initialParameters->size()) {
-      ACTS_FATAL("Inconsistent number of proto tracks and initial parameters");
+    if (m_tracksPerTask.value() == 0) {
+      error() << "tracksPerTask must be positive" << endmsg;
       return StatusCode::FAILURE;
     }
-
-    // TrajectoryContainer trajectories;
-    auto* trajectories = m_outputTrajectories.createAndPut();
-    trajectories->reserve(initialParameters->size());
+    const auto compactStates = compactStateParameters(m_compactStates.value());
+    if (!compactStates) {
+      error() << "Unknown compactStates " << m_compactStates.value() << ", use none, predicted, filtered or smoothed"
+              << endmsg;
+      return StatusCode::FAILURE;
+    }
+    m_compactConfig = {*compactStates, m_compactCovariance.value(), m_compactMeasurementsOnly.value()};
+    if (m_numThreads.value() != 1) {
+      m_concurrencySvc = service("ConcurrencySvc");
+      if (!m_concurrencySvc) {
+        error() << "Unable to locate ConcurrencySvc for numThreads " << m_numThreads.value() << endmsg;
+        return StatusCode::FAILURE;
+      }
+    }
 
     // Construct a perigee surface as the target surface
-    auto pSurface = Acts::Surface::makeShared<Acts::PerigeeSurface>(Acts::Vector3{0., 0., 0.});
+    m_targetSurface = Acts::Surface::makeShared<Acts::PerigeeSurface>(Acts::Vector3{0., 0., 0.});
+    m_actsLogger    = Jug::makeActsLogger(name(), msgSvc(), msgLevel());
 
-    Acts::PropagatorPlainOptions pOptions;
-    pOptions.maxSteps = 10000;
+    m_propagatorOptions.maxSteps    = m_maxSteps;
+    m_propagatorOptions.pathLimit   = m_pathLimit;
+    m_propagatorOptions.maxStepSize = m_maxStepSize;
+    m_propagatorOptions.tolerance   = m_stepperTolerance;
+    m_propagatorOptions.mass        = m_mass * Acts::UnitConstants::GeV;
+
+    m_extensions.updater.connect<&Acts::GainMatrixUpdater::operator()>(&m_kfUpdater);
+    m_extensions.smoother.connect<&Acts::GainMatrixSmoother::operator()>(&m_kfSmoother);
+    return StatusCode::SUCCESS;
+  }
+
+  void TrackFittingAlgorithm::fitTracks(size_t begin, size_t end, const IndexSourceLinkContainer& sourceLinks,
+                                        const TrackParametersContainer& initialParameters,
+                                        const MeasurementContainer& measurements,
+                                        const ProtoTrackContainer& protoTracks, TrajectoriesContainer& trajectories,
+                                        std::vector<std::error_code>& errors, std::vector<char>& invalid) const
+  {
     // kfOptions.multipleScattering = m_cfg.multipleScattering;
     // kfOptions.energyLoss         = m_cfg.energyLoss;
 
-    Acts::KalmanFitterExtensions extensions;
-    MeasurementCalibrator calibrator{*measurements};
+    // only the calibrator depends on the event
+    auto extensions = m_extensions;
+    MeasurementCalibrator calibrator{measurements};
     extensions.calibrator.connect<&MeasurementCalibrator::calibrate>(&calibrator);
-    Acts::GainMatrixUpdater kfUpdater;
-    Acts::GainMatrixSmoother kfSmoother;
-    extensions.updater.connect<&Acts::GainMatrixUpdater::operator()>(&kfUpdater);
-    extensions.smoother.connect<&Acts::GainMatrixSmoother::operator()>(
-        &kfSmoother);
 
+    // the stepper makes the field cache of each propagation
     Acts::KalmanFitterOptions kfOptions(
         m_geoctx, m_fieldctx, m_calibctx, extensions,
-        Acts::LoggerWrapper{logger()}, Acts::PropagatorPlainOptions(),
-        &(*pSurface));
+        Acts::LoggerWrapper{logger()}, m_propagatorOptions,
+        m_targetSurface.get());
 
-    // used for processing the data
-    std::vector<IndexSourceLink>      trackSourceLinks;
-    std::vector<const Acts::Surface*> surfSequence;
+    // used for processing the data, reused by the tracks of this range
+    std::vector<IndexSourceLink> trackSourceLinks;
 
-    if (msgLevel(MSG::DEBUG)) {
-      debug() << "initialParams size:  " << initialParameters->size() << endmsg;
-      debug() << "measurements size:  " << measurements->size() << endmsg;
-    }
-
-    // Perform the track finding for each starting parameter
-    // @TODO: use seeds from track seeding algorithm as starting parameter
-    // initial track params and proto tracks might likely have the same size.
-    //for (std::size_t iseed = 0; iseed < init_trk_params->size(); ++iseed) {
-    for (std::size_t itrack = 0; itrack < (*protoTracks).size(); ++itrack) {
-
-      const auto& protoTrack    = (*protoTracks)[itrack];
-      const auto& initialParams = (*initialParameters)[itrack];
-
-      if (msgLevel(MSG::DEBUG)) {
-        debug() << "protoTrack size:  " << protoTrack.size() << endmsg;
-        debug() << "sourceLinks size:  " << sourceLinks->size() << endmsg;
-      }
+    for (std::size_t itrack = begin; itrack < end; ++itrack) {
+      const auto& protoTrack    = protoTracks[itrack];
+      const auto& initialParams = initialParameters[itrack];
 
       trackSourceLinks.clear();
       trackSourceLinks.reserve(protoTrack.size());
-
       for (auto hitIndex : protoTrack) {
-        if (auto it = sourceLinks->nth(hitIndex); it != sourceLinks->end()) {
-          const IndexSourceLink& sourceLink = *it;
-          trackSourceLinks.push_back(std::cref(sourceLink));
-          //auto geoId = sourceLink.geometryId();
-          //surfSequence.push_back(m_cfg.trackingGeometry->findSurface(geoId));
+        if (auto it = sourceLinks.nth(hitIndex); it != sourceLinks.end()) {
+          trackSourceLinks.push_back(*it);
         } else {
-          ACTS_FATAL("Proto track " << itrack << " contains invalid hit index"
-                                    << hitIndex);
-          return StatusCode::FAILURE;
+          invalid[itrack] = 1;
+          break;
         }
       }
-
-      if (msgLevel(MSG::DEBUG)) {
-        debug() << "Invoke track fitting ...  " << itrack << endmsg;
+      if (invalid[itrack] != 0) {
+        continue;
       }
+
       auto result = fitTrack(trackSourceLinks, initialParams, kfOptions);
-      if (msgLevel(MSG::DEBUG)) {
-        debug() << "fitting done." << endmsg;
-      }
-      // if (result.ok()) {
-      //  // Get the track finding output object
-      //  const auto& trackFindingOutput = result.value();
-      //  // Create a SimMultiTrajectory
-      //  trajectories->emplace_back(std::move(trackFindingOutput.fittedStates),
-      //  std::move(trackFindingOutput.lastMeasurementIndices),
-      //                             std::move(trackFindingOutput.fittedParameters));
-      //} else {
-      //  debug() << "Track finding failed for truth seed " << iseed << endmsg;
-      //  ACTS_WARNING("Track finding failed for truth seed " << iseed << " with error" <<
-      //  result.error());
-      //  // Track finding failed, but still create an empty SimMultiTrajectory
-      //  // trajectories->push_back(SimMultiTrajectory());
-      //}
-      if (result.ok())
-      {
+      if (result.ok()) {
         // Get the fit output object
         const auto& fitOutput = result.value();
         // The track entry indices container. One element here.
@@ -192,25 +167,76 @@ namespace Jug::Reco {
         trackTips.emplace_back(fitOutput.lastMeasurementIndex);
         // The fitted parameters container. One element (at most) here.
         Trajectories::IndexedParameters indexedParams;
-        //if (fitOutput.fittedParameters) {
-        //  const auto& params = fitOutput.fittedParameters.value();
-        //  ACTS_VERBOSE("Fitted paramemeters for track " << itrack);
-        //  ACTS_VERBOSE("  " << params.parameters().transpose());
-        //  // Push the fitted parameters to the container
-        //  indexedParams.emplace(fitOutput.lastMeasurementIndex, std::move(params));
-        //} else {
-        //  ACTS_DEBUG("No fitted paramemeters for track " << itrack);
-        //}
         // store the result
-        trajectories->emplace_back(std::move(fitOutput.fittedStates), std::move(trackTips),
-                                  std::move(indexedParams));
+        trajectories[itrack] = Trajectories(std::move(fitOutput.fittedStates), std::move(trackTips),
+                                            std::move(indexedParams));
       } else {
-        ACTS_WARNING("Fit failed for track " << itrack << " with error" << result.error());
-        // Fit failed. Add an empty result so the output container has
+        errors[itrack] = result.error();
+      }
+    }
+  }
+
+  StatusCode TrackFittingAlgorithm::execute()
+  {
+    // Read input data
+    const auto* const sourceLinks       = m_inputSourceLinks.get();
+    const auto* const initialParameters = m_initialTrackParameters.get();
+    const auto* const measurements      = m_inputMeasurements.get();
+    const auto* const protoTracks       = m_inputProtoTracks.get();
+
+    // Consistency cross checks
+    if (protoTracks->size() != initialParameters->size()) {
+      ACTS_FATAL("Inconsistent number of proto tracks and initial parameters");
+      return StatusCode::FAILURE;
+    }
+
+    // TrajectoryContainer trajectories;
+    // one slot per track, so that the fits can fill them in any order
+    auto* outputTrajectories = m_outputTrajectories.createAndPut();
+    auto* compact            = m_outputCompactTrajectories.createAndPut();
+    // with the compact output the trajectories are only kept until they are compacted
+    TrajectoriesContainer fittedTrajectories;
+    auto* trajectories = m_compactOutput ? &fittedTrajectories : outputTrajectories;
+    trajectories->resize(protoTracks->size());
+
+    if (msgLevel(MSG::DEBUG)) {
+      debug() << "initialParams size:  " << initialParameters->size() << endmsg;
+      debug() << "measurements size:  " << measurements->size() << endmsg;
+      debug() << "sourceLinks size:  " << sourceLinks->size() << endmsg;
+    }
+
+    // Perform the track fitting for each proto track, the fits are independent
+    // @TODO: use seeds from track seeding algorithm as starting parameter
+    const size_t ntracks = protoTracks->size();
+    const size_t perTask = m_tracksPerTask.value();
+    const size_t ntasks  = (m_numThreads.value() == 1) ? 1 : std::max<size_t>((ntracks + perTask - 1) / perTask, 1);
+    // fit errors and invalid proto tracks, reported after the fits in track order
+    std::vector<std::error_code> errors(ntracks);
+    std::vector<char> invalid(ntracks, 0);
+    if (ntasks == 1) {
+      fitTracks(0, ntracks, *sourceLinks, *initialParameters, *measurements, *protoTracks, *trajectories, errors,
+                invalid);
+    } else {
+      m_concurrencySvc->parallelFor(ntasks, [&](size_t task) {
+        fitTracks(task * perTask, std::min(ntracks, (task + 1) * perTask), *sourceLinks, *initialParameters,
+                  *measurements, *protoTracks, *trajectories, errors, invalid);
+      });
+    }
+
+    for (std::size_t itrack = 0; itrack < ntracks; ++itrack) {
+      if (invalid[itrack] != 0) {
+        ACTS_FATAL("Proto track " << itrack << " contains invalid hit index");
+        return StatusCode::FAILURE;
+      }
+      if (errors[itrack]) {
+        // Fit failed, the output keeps an empty result so that it has
         // the same number of entries as the input.
-        trajectories->push_back(Trajectories());
+        ACTS_WARNING("Fit failed for track " << itrack << " with error" << errors[itrack]);
       }
     }
+    if (m_compactOutput) {
+      *compact = compactTrajectories(fittedTrajectories, m_compactConfig);
+    }
 
     // ctx.eventStore.add(m_cfg.outputTrajectories, std::move(trajectories));
     return StatusCode::SUCCESS;
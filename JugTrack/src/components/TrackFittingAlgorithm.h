@@ -5,6 +5,7 @@
 #define JUGGLER_JUGRECO_TrackFittingAlgorithm_HH 1
 
 #include <functional>
+#include <limits>
 #include <stdexcept>
 #include <vector>
 #include <random>
@@ -15,10 +16,12 @@
 #include "Gaudi/Property.h"
 
 #include "JugBase/DataHandle.h"
+#include "JugBase/IConcurrencySvc.h"
 #include "JugBase/IGeoSvc.h"
 #include "JugBase/BField/DD4hepBField.h"
-#include "JugTrack/GeometryContainers.hpp"
-#include "JugTrack/IndexSourceLink.hpp"
+#include "JugBase/GeometryContainers.hpp"
+#include "JugBase/IndexSourceLink.hpp"
+#include "JugTrack/CompactTrajectories.hpp"
 #include "JugTrack/Track.hpp"
 #include "JugTrack/Measurement.hpp"
 #include "JugTrack/Trajectories.hpp"
@@ -32,9 +35,12 @@
 #include "Acts/TrackFitting/KalmanFitter.hpp"
 #include "Acts/TrackFitting/GainMatrixSmoother.hpp"
 #include "Acts/TrackFitting/GainMatrixUpdater.hpp"
+#include "Acts/Utilities/Logger.hpp"
 #include "Acts/Geometry/TrackingGeometry.hpp"
 #include "Acts/Definitions/Common.hpp"
 
+#include <system_error>
+
 
 namespace Jug::Reco {
 
@@ -63,16 +69,49 @@ namespace Jug::Reco {
     DataHandle<ProtoTrackContainer>      m_inputProtoTracks{"inputProtoTracks", Gaudi::DataHandle::Reader, this};
     DataHandle<TrajectoriesContainer>    m_foundTracks{"foundTracks", Gaudi::DataHandle::Reader, this};
     DataHandle<TrajectoriesContainer>    m_outputTrajectories{"outputTrajectories", Gaudi::DataHandle::Writer, this};
+    DataHandle<CompactTrajectories>      m_outputCompactTrajectories{"outputCompactTrajectories", Gaudi::DataHandle::Writer, this};
 
     FitterFunction                        m_trackFittingFunc;
     SmartIF<IGeoSvc>                      m_geoSvc;
-    std::shared_ptr<const Jug::BField::DD4hepBField> m_BField = nullptr;
+    std::shared_ptr<const Acts::MagneticFieldProvider> m_BField = nullptr;
     Acts::GeometryContext                 m_geoctx;
     Acts::CalibrationContext              m_calibctx;
     Acts::MagneticFieldContext            m_fieldctx;
 
     //Acts::CKFSourceLinkSelector::Config m_sourcelinkSelectorCfg;
 
+    /// Propagation step and path limits; lengths in mm, mass in GeV
+    Gaudi::Property<unsigned> m_maxSteps{this, "maxSteps", 1000, "Maximum number of steps per propagation"};
+    Gaudi::Property<double> m_pathLimit{this, "pathLimit", std::numeric_limits<double>::max(), "Maximum path length"};
+    Gaudi::Property<double> m_maxStepSize{this, "maxStepSize", std::numeric_limits<double>::max(), "Maximum step size"};
+    Gaudi::Property<double> m_stepperTolerance{this, "stepperTolerance", 1e-4, "Adaptive step size tolerance"};
+    Gaudi::Property<double> m_mass{this, "mass", 0.13957018, "Mass hypothesis for the propagation"};
+
+    /// Intra-event parallelism: the proto tracks are fitted in tasks of tracksPerTask tracks
+    Gaudi::Property<int> m_numThreads{this, "numThreads", 1, "Tracks of an event in the ConcurrencySvc arena (1: serial)"};
+    Gaudi::Property<size_t> m_tracksPerTask{this, "tracksPerTask", 8, "Minimum number of tracks per parallel task"};
+    SmartIF<IConcurrencySvc> m_concurrencySvc;
+
+    /// Compact output: the kept components of the trajectories (compactStates, compactCovariance,
+    /// compactMeasurementsOnly) in outputCompactTrajectories, outputTrajectories is then empty
+    Gaudi::Property<bool> m_compactOutput{this, "compactOutput", false,
+                                          "Write the compact trajectories instead of the trajectories"};
+    Gaudi::Property<std::string> m_compactStates{this, "compactStates", "smoothed",
+                                                 "Compact state parameters: none, predicted, filtered or smoothed"};
+    Gaudi::Property<bool> m_compactCovariance{this, "compactCovariance", true, "Compact state covariances"};
+    Gaudi::Property<bool> m_compactMeasurementsOnly{this, "compactMeasurementsOnly", true,
+                                                    "Compact states of the measurements only"};
+    CompactTrajectoriesConfig m_compactConfig;
+
+    /// Fitter pieces that do not depend on the event, made in initialize()
+    std::shared_ptr<const Acts::Surface> m_targetSurface;
+    std::unique_ptr<const Acts::Logger> m_actsLogger;
+    Acts::PropagatorPlainOptions m_propagatorOptions;
+    Acts::GainMatrixUpdater m_kfUpdater;
+    Acts::GainMatrixSmoother m_kfSmoother;
+    /// Updater and smoother connected, the calibrator is connected per event
+    Acts::KalmanFitterExtensions m_extensions;
+
     TrackFittingAlgorithm(const std::string& name, ISvcLocator* svcLoc);
 
     /** Create the track finder function implementation.
@@ -88,6 +127,9 @@ namespace Jug::Reco {
 
     StatusCode execute() override;
    private:
+    /// ACTS logger of the algorithm, for the ACTS_* logging macros
+    const Acts::Logger& logger() const { return *m_actsLogger; }
+
     /// Helper function to call correct FitterFunction
     FitterResult fitTrack(
         const std::vector<IndexSourceLink>& sourceLinks,
@@ -95,6 +137,12 @@ namespace Jug::Reco {
         const TrackFitterOptions& options
         ) const;
         //, const std::vector<const Acts::Surface*>& surfSequence) const;
+
+    /// Fit the proto tracks [begin, end) into their trajectory slots, with a calibrator of its own
+    void fitTracks(size_t begin, size_t end, const IndexSourceLinkContainer& sourceLinks,
+                   const TrackParametersContainer& initialParameters, const MeasurementContainer& measurements,
+                   const ProtoTrackContainer& protoTracks, TrajectoriesContainer& trajectories,
+                   std::vector<std::error_code>& errors, std::vector<char>& invalid) const;
   };
 
   inline TrackFittingAlgorithm::FitterResult
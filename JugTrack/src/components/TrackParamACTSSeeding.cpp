@@ -1,10 +1,16 @@
 #include <cmath>
 #include <algorithm>
+#include <memory>
+#include <optional>
+#include <type_traits>
 #include <unordered_map>
+#include <vector>
 
 #include "Acts/ActsVersion.hpp"
 #include "Acts/Definitions/Units.hpp"
 #include "Acts/Definitions/Common.hpp"
+#include "Acts/Geometry/Extent.hpp"
+#include "Acts/Geometry/Polyhedron.hpp"
 #include "Acts/Geometry/TrackingGeometry.hpp"
 
 #include "Acts/Seeding/BinFinder.hpp"
@@ -25,11 +31,18 @@
 #include "Gaudi/Property.h"
 
 #include "JugBase/DataHandle.h"
+#include "JugBase/IConcurrencySvc.h"
 #include "JugBase/IGeoSvc.h"
 #include "JugBase/BField/DD4hepBField.h"
-#include "JugTrack/IndexSourceLink.hpp"
+#include "JugBase/IndexSourceLink.hpp"
+#include "JugBase/Logging.h"
+#include "JugBase/Profiling.h"
+#include "JugBase/Utilities/TimeIndex.h"
+#include "JugTrack/ChargeEstimator.hpp"
 #include "JugTrack/Measurement.hpp"
+#include "JugTrack/SpacePoint.hpp"
 #include "JugTrack/Track.hpp"
+#include "JugTrack/VertexSeed.hpp"
 
 #include "eicd/TrackerHitCollection.h"
 
@@ -66,6 +79,12 @@ namespace Jug::Reco {
         DataHandle<eicd::TrackerHitCollection>
         m_inputHitCollection { "inputHitCollection",
             Gaudi::DataHandle::Reader, this };
+        DataHandle<::Jug::SpacePointContainer>
+        m_inputSpacePoints { "inputSpacePoints",
+            Gaudi::DataHandle::Reader, this };
+        DataHandle<std::vector<double>>
+        m_inputVertexSeed { "inputVertexSeed",
+            Gaudi::DataHandle::Reader, this };
         DataHandle<TrackParametersContainer>
         m_outputInitialTrackParameters {
             "outputInitialTrackParameters",
@@ -73,10 +92,43 @@ namespace Jug::Reco {
 
         SmartIF<IGeoSvc> m_geoSvc;
         Acts::GeometryContext m_geoContext;
-        std::shared_ptr<const Jug::BField::DD4hepBField> m_BField =
+        std::shared_ptr<const Acts::MagneticFieldProvider> m_BField =
             nullptr;
         Acts::MagneticFieldContext m_fieldContext;
 
+        /// Space point grid and seed finder extent (mm, T). The values
+        /// not set (0) are derived in initialize from the extent of the
+        /// surfaces of the tracking geometry (with geometryEnvelope) and
+        /// the field at the origin, so that the grid is tight for every
+        /// detector configuration
+        Gaudi::Property<double> m_rMax{this, "rMax", 0.,
+            "Largest space point radius (0: from the geometry)"};
+        Gaudi::Property<double> m_zMin{this, "zMin", 0.,
+            "Smallest space point z (zMin = zMax = 0: from the geometry)"};
+        Gaudi::Property<double> m_zMax{this, "zMax", 0.,
+            "Largest space point z (zMin = zMax = 0: from the geometry)"};
+        Gaudi::Property<double> m_deltaRMax{this, "deltaRMax", 0.,
+            "Largest radial distance of the space points of a seed (0: from the geometry)"};
+        Gaudi::Property<double> m_bFieldInZ{this, "bFieldInZ", 0.,
+            "Field along z of the seed finder (0: from the field at the origin)"};
+        Gaudi::Property<double> m_geometryEnvelope{this, "geometryEnvelope",
+            10 * Acts::UnitConstants::mm,
+            "Margin of the extent derived from the geometry"};
+        Gaudi::Property<std::vector<std::pair<int, int>>> m_zBinNeighborsTop{
+            this, "zBinNeighborsTop", {},
+            "Top space point z bin neighbours of every z bin (empty: the Acts default)"};
+        Gaudi::Property<std::vector<std::pair<int, int>>> m_zBinNeighborsBottom{
+            this, "zBinNeighborsBottom", {},
+            "Bottom space point z bin neighbours of every z bin (empty: the Acts default)"};
+        Gaudi::Property<int> m_numPhiNeighbors{this, "numPhiNeighbors", 1,
+            "Space point phi bin neighbours on each side"};
+
+        /// Seed from the space points of the source linker
+        /// (writeSpacePoints) instead of the hits, which also gives the
+        /// surfaces of the seeds without a geometry search
+        Gaudi::Property<bool> m_useSpacePoints{this, "useSpacePoints",
+            false, "Seed from inputSpacePoints instead of the hits"};
+
         /// Index type to reference elements in a container.
         ///
         /// We do not expect to have more than 2^32 elements in any
@@ -89,6 +141,7 @@ namespace Jug::Reco {
         class SpacePoint : eicd::TrackerHitData {
         public:
             int32_t _measurementIndex;
+            Acts::GeometryIdentifier _geometryId;
             // Constructor to circumvent the fact that eic::TrackerHit
             // and associated classes are all non-polymorphic
             SpacePoint(const eicd::TrackerHit h,
@@ -97,6 +150,20 @@ namespace Jug::Reco {
             {
                 position = h.getPosition();
                 positionError = h.getPositionError();
+                time = h.getTime();
+            }
+            // From the space point of a measurement, its radial
+            // variance is stored as the x and y variances
+            SpacePoint(const ::Jug::SpacePoint& sp)
+                : _measurementIndex(static_cast<int32_t>(sp.measurementIndex)),
+                  _geometryId(sp.geometryId)
+            {
+                position = eicd::Vector3f(sp.position.x(), sp.position.y(),
+                                          sp.position.z());
+                positionError = eicd::CovDiag3f(sp.variance[0],
+                                                sp.variance[0],
+                                                sp.variance[1]);
+                time = sp.time;
             }
             constexpr float x() const { return position.x; }
             constexpr float y() const { return position.y; }
@@ -109,8 +176,12 @@ namespace Jug::Reco {
                     (std::pow(x(), 2) + std::pow(y(), 2));
             }
             constexpr float varianceZ() const { return positionError.zz; }
+            constexpr float t() const { return time; }
             constexpr uint32_t measurementIndex() const {
                 return _measurementIndex; }
+            /// Surface of the measurement, invalid for hits
+            Acts::GeometryIdentifier geometryId() const {
+                return _geometryId; }
         };
 
         static bool spCompare(SpacePoint r, SpacePoint s)
@@ -189,6 +260,30 @@ namespace Jug::Reco {
         } m_cfg;
         Acts::SpacePointGridConfig m_gridCfg;
         Acts::SeedfinderConfig<SpacePoint> m_finderCfg;
+        /// Bin finders and seed finder, made once in initialize(); the
+        /// per-event state is passed to findSeed
+        std::shared_ptr<Acts::BinFinder<SpacePoint>> m_bottomBinFinder;
+        std::shared_ptr<Acts::BinFinder<SpacePoint>> m_topBinFinder;
+        std::optional<Acts::Seedfinder<SpacePoint>> m_finder;
+
+        /// Intra-event parallelism: the space point groups are seeded in
+        /// tasks of groupsPerTask groups, each with its own finder state
+        Gaudi::Property<int> m_numThreads{this, "numThreads", 1,
+            "Space point groups of an event in the ConcurrencySvc arena (1: serial)"};
+        Gaudi::Property<size_t> m_groupsPerTask{this, "groupsPerTask", 2,
+            "Space point groups per parallel task"};
+        SmartIF<IConcurrencySvc> m_concurrencySvc;
+        /// Time selection: the space points are split in groups separated
+        /// by more than timeWindow, seeded independently (0: no selection)
+        Gaudi::Property<double> m_timeWindow{this, "timeWindow", 0.,
+            "Largest time gap in a group of space points (ns, 0: off)"};
+        /// Vertex seed (ZScanVertexSeeder): the collision region of the
+        /// event is the vertex z +- vertexWindow instead of the fixed one
+        Gaudi::Property<bool> m_useVertexSeed{this, "useVertexSeed", false,
+            "Collision region around inputVertexSeed"};
+        Gaudi::Property<double> m_vertexWindow{this, "vertexWindow",
+            10 * Acts::UnitConstants::mm,
+            "Half length of the collision region around the vertex seed"};
         /// The track parameters covariance (assumed to be the same
         /// for all estimated track parameters for the moment)
         Acts::BoundSymMatrix m_covariance =
@@ -204,18 +299,36 @@ namespace Jug::Reco {
                             m_inputMeasurements, "");
             declareProperty("inputHitCollection",
                             m_inputHitCollection, "");
+            declareProperty("inputSpacePoints",
+                            m_inputSpacePoints, "");
+            declareProperty("inputVertexSeed",
+                            m_inputVertexSeed, "");
             declareProperty("outputInitialTrackParameters",
                             m_outputInitialTrackParameters, "");
         }
 
         StatusCode initialize() override;
 
+        /// Set the extent and field of m_cfg from the properties or the
+        /// geometry
+        void configureExtent();
+
         void
         findSeed(SeedContainer &seeds,
                  const eicd::TrackerHitCollection *hits,
                  const IndexSourceLinkContainer *sourceLinks,
                  const MeasurementContainer *measurements,
-                 Acts::Seedfinder<SpacePoint>::State &state);
+                 const ::Jug::SpacePointContainer *spacePoints,
+                 const Acts::Seedfinder<SpacePoint> &finder,
+                 Acts::Seedfinder<SpacePoint>::State &state) const;
+
+        /// Seeds of a set of space points, appended to seeds
+        void
+        seedSpacePoints(SeedContainer &seeds,
+                        const std::vector<const SpacePoint *> &spacePointPtrs,
+                        const Acts::Extent &rRangeSPExtent,
+                        const Acts::Seedfinder<SpacePoint> &finder,
+                        Acts::Seedfinder<SpacePoint>::State &state) const;
 
         StatusCode execute() override;
     };
@@ -233,10 +346,9 @@ namespace Jug::Reco {
             return StatusCode::FAILURE;
         }
 
-        m_BField = std::dynamic_pointer_cast<
-            const Jug::BField::DD4hepBField>(
-                m_geoSvc->getFieldProvider());
-        m_fieldContext = Jug::BField::BFieldVariant(m_BField);
+        // the DD4hep field or the field map of GeoSvc, the field context is not used by either
+        m_BField = m_geoSvc->getFieldProvider();
+        configureExtent();
 
         m_gridCfg.bFieldInZ = m_cfg.bFieldInZ;
         m_gridCfg.minPt = m_cfg.minPt;
@@ -271,6 +383,29 @@ namespace Jug::Reco {
             Acts::Vector2(m_cfg.beamPosX, m_cfg.beamPosY);
         m_finderCfg.impactMax = m_cfg.impactMax;
 
+        m_bottomBinFinder =
+            std::make_shared<Acts::BinFinder<SpacePoint>>(
+                Acts::BinFinder<SpacePoint>(m_cfg.zBinNeighborsBottom,
+                                            m_cfg.numPhiNeighbors));
+        m_topBinFinder =
+            std::make_shared<Acts::BinFinder<SpacePoint>>(
+                Acts::BinFinder<SpacePoint>(m_cfg.zBinNeighborsTop,
+                                            m_cfg.numPhiNeighbors));
+        m_finder.emplace(m_finderCfg);
+
+        if (m_groupsPerTask.value() == 0) {
+            error() << "groupsPerTask must be positive" << endmsg;
+            return StatusCode::FAILURE;
+        }
+        if (m_numThreads.value() != 1) {
+            m_concurrencySvc = service("ConcurrencySvc");
+            if (!m_concurrencySvc) {
+                error() << "Unable to locate ConcurrencySvc for numThreads "
+                        << m_numThreads.value() << endmsg;
+                return StatusCode::FAILURE;
+            }
+        }
+
         // Set up the track parameters covariance (the same for all
         // tracks)
         m_covariance(Acts::eBoundLoc0, Acts::eBoundLoc0) =
@@ -289,12 +424,78 @@ namespace Jug::Reco {
         return StatusCode::SUCCESS;
     }
 
+    void TrackParamACTSSeeding::configureExtent()
+    {
+        // extent of the surfaces of the tracking geometry
+        Acts::Extent extent;
+        size_t nSurfaces = 0;
+        if (const auto trackingGeometry = m_geoSvc->trackingGeometry()) {
+            trackingGeometry->visitSurfaces(
+                [&](const Acts::Surface *surface) {
+                    if (surface != nullptr) {
+                        extent.extend(surface->polyhedronRepresentation(
+                                m_geoContext, 1).extent());
+                        ++nSurfaces;
+                    }
+                });
+        }
+        const double envelope = m_geometryEnvelope.value();
+        if (nSurfaces > 0) {
+            if (m_rMax.value() <= 0.) {
+                m_cfg.rMax = extent.max(Acts::binR) + envelope;
+            }
+            if (m_zMin.value() == 0. && m_zMax.value() == 0.) {
+                m_cfg.zMin = extent.min(Acts::binZ) - envelope;
+                m_cfg.zMax = extent.max(Acts::binZ) + envelope;
+            }
+            if (m_deltaRMax.value() <= 0.) {
+                m_cfg.deltaRMax = extent.max(Acts::binR) -
+                    extent.min(Acts::binR) + envelope;
+            }
+        } else {
+            warning() << "No tracking surfaces, the default seeding extent is used" << endmsg;
+        }
+        if (m_rMax.value() > 0.) {
+            m_cfg.rMax = m_rMax.value();
+        }
+        if (m_zMin.value() != 0. || m_zMax.value() != 0.) {
+            m_cfg.zMin = m_zMin.value();
+            m_cfg.zMax = m_zMax.value();
+        }
+        if (m_deltaRMax.value() > 0.) {
+            m_cfg.deltaRMax = m_deltaRMax.value();
+        }
+
+        if (m_bFieldInZ.value() != 0.) {
+            m_cfg.bFieldInZ = m_bFieldInZ.value();
+        } else if (const auto fieldZ = ChargeEstimator::fieldZ(*m_BField);
+                   fieldZ && std::abs(*fieldZ) >= m_cfg.bFieldMin) {
+            m_cfg.bFieldInZ = std::abs(*fieldZ);
+        } else {
+            warning() << "No field at the origin, the default field of "
+                      << m_cfg.bFieldInZ / Acts::UnitConstants::T
+                      << " T is used for the seeding" << endmsg;
+        }
+
+        m_cfg.zBinNeighborsTop = m_zBinNeighborsTop.value();
+        m_cfg.zBinNeighborsBottom = m_zBinNeighborsBottom.value();
+        m_cfg.numPhiNeighbors = m_numPhiNeighbors.value();
+
+        info() << "Seeding extent: rMax " << m_cfg.rMax
+               << " mm, z [" << m_cfg.zMin << ", " << m_cfg.zMax
+               << "] mm, deltaRMax " << m_cfg.deltaRMax
+               << " mm, field " << m_cfg.bFieldInZ / Acts::UnitConstants::T
+               << " T" << endmsg;
+    }
+
     void TrackParamACTSSeeding::
     findSeed(SeedContainer &seeds,
              const eicd::TrackerHitCollection *hits,
              const IndexSourceLinkContainer *sourceLinks,
              const MeasurementContainer *measurements,
-             Acts::Seedfinder<SpacePoint>::State &state)
+             const ::Jug::SpacePointContainer *spacePoints,
+             const Acts::Seedfinder<SpacePoint> &finder,
+             Acts::Seedfinder<SpacePoint>::State &state) const
     {
         // Sadly, eic::TrackerHit and eic::TrackerHitData are
 	// non-polymorphic
@@ -312,31 +513,72 @@ namespace Jug::Reco {
                     << measurements->size() << ' '
                     << hits->size() << endmsg;
         }
-        auto its = sourceLinks->begin();
-        auto itm = measurements->begin();
-        for (; its != sourceLinks->end() &&
-                 itm != measurements->end();
-             its++, itm++) {
-            const Acts::Surface *surface = trackingGeometry->findSurface(its->get().geometryId());
-            if (surface != nullptr) {
-                Acts::Vector3 v = surface->localToGlobal(m_geoContext, {std::get<Acts::Measurement<Acts::BoundIndices, 2>>(*itm).parameters()[0], std::get<Acts::Measurement<Acts::BoundIndices, 2>>(*itm).parameters()[1]}, {0, 0, 0});
+        if (spacePoints != nullptr) {
+            // global positions from the source linker, no transforms
+            spacePoint.reserve(spacePoints->size());
+            spacePointPtrs.reserve(spacePoints->size());
+            for (const auto &sp : *spacePoints) {
+                spacePoint.emplace_back(sp);
+                spacePointPtrs.push_back(&spacePoint.back());
+                rRangeSPExtent.check({ spacePoint.back().x(),
+                                       spacePoint.back().y(),
+                                       spacePoint.back().z() });
+            }
+        } else {
+            // the space points are stored by value and referenced, so the
+            // storage must not reallocate
+            spacePoint.reserve(sourceLinks->size() + hits->size());
+            spacePointPtrs.reserve(sourceLinks->size() + hits->size());
+            auto its = sourceLinks->begin();
+            auto itm = measurements->begin();
+            for (; its != sourceLinks->end() &&
+                     itm != measurements->end();
+                 its++, itm++) {
+                const Acts::Surface *surface = trackingGeometry->findSurface(its->get().geometryId());
+                if (surface != nullptr) {
+                    Acts::Vector3 v = surface->localToGlobal(m_geoContext, {std::get<Acts::Measurement<Acts::BoundIndices, 2>>(*itm).parameters()[0], std::get<Acts::Measurement<Acts::BoundIndices, 2>>(*itm).parameters()[1]}, {0, 0, 0});
+                    if (msgLevel(MSG::DEBUG)) {
+                        debug() << __FILE__ << ':' << __LINE__ << ": "
+                                << its - sourceLinks->begin() << ' '
+                            // << itm - measurements->begin() << ' '
+                                << v[0] << ' ' << v[1] << ' ' << v[2]
+                                << endmsg;
+                    }
+#ifdef USE_LOCAL_COORD
+                    spacePoint.push_back(
+                        SpacePoint(
+                            eicd::TrackerHit(
+                                static_cast<uint64_t>(spacePoint.size()),
+                                eicd::Vector3f(v[0], v[1], v[2]),
+                                eicd::CovDiag3f(25.0e-6 / 3.0,
+                                                25.0e-6 / 3.0, 0.0),
+                                0.0, 10.0, 0.05, 0.0),
+                            static_cast<int32_t>(spacePoint.size())));
+                    spacePointPtrs.push_back(&spacePoint.back());
+                    rRangeSPExtent.check({ spacePoint.back().x(),
+                                           spacePoint.back().y(),
+                                           spacePoint.back().z() });
+#endif // USE_LOCAL_COORD
+                }
+            }
+
+            for(const auto &h : *hits) {
                 if (msgLevel(MSG::DEBUG)) {
                     debug() << __FILE__ << ':' << __LINE__ << ": "
-                            << its - sourceLinks->begin() << ' '
-                        // << itm - measurements->begin() << ' '
-                            << v[0] << ' ' << v[1] << ' ' << v[2]
+                            << ' ' << h.getPosition().x
+                            << ' ' << h.getPosition().y
+                            << ' ' << h.getPosition().z
+                            << ' ' << h.getPositionError().xx
+                            << ' ' << h.getPositionError().yy
+                            << ' ' << h.getPositionError().zz
+                            << ' ' << h.getTime()
+                            << ' ' << h.getTimeError()
+                            << ' ' << h.getEdep()
+                            << ' ' << h.getEdepError()
                             << endmsg;
                 }
-#ifdef USE_LOCAL_COORD
-                spacePoint.push_back(
-                    SpacePoint(
-                        eicd::TrackerHit(
-                            static_cast<uint64_t>(spacePoint.size()),
-                            eicd::Vector3f(v[0], v[1], v[2]),
-                            eicd::CovDiag3f(25.0e-6 / 3.0,
-                                            25.0e-6 / 3.0, 0.0),
-                            0.0, 10.0, 0.05, 0.0),
-                        static_cast<int32_t>(spacePoint.size())));
+#ifndef USE_LOCAL_COORD
+                spacePoint.push_back(SpacePoint(h, static_cast<int32_t>(spacePoint.size())));
                 spacePointPtrs.push_back(&spacePoint.back());
                 rRangeSPExtent.check({ spacePoint.back().x(),
                                        spacePoint.back().y(),
@@ -344,34 +586,45 @@ namespace Jug::Reco {
 #endif // USE_LOCAL_COORD
             }
         }
+        if (msgLevel(MSG::DEBUG)) {
+            debug() << __FILE__ << ':' << __LINE__ << ": " << endmsg;
+        }
 
-        for(const auto &h : *hits) {
-            if (msgLevel(MSG::DEBUG)) {
-                debug() << __FILE__ << ':' << __LINE__ << ": "
-                        << ' ' << h.getPosition().x
-                        << ' ' << h.getPosition().y
-                        << ' ' << h.getPosition().z
-                        << ' ' << h.getPositionError().xx
-                        << ' ' << h.getPositionError().yy
-                        << ' ' << h.getPositionError().zz
-                        << ' ' << h.getTime()
-                        << ' ' << h.getTimeError()
-                        << ' ' << h.getEdep()
-                        << ' ' << h.getEdepError()
-                        << endmsg;
+        // Run the seeding
+        seeds.clear();
+        if (m_timeWindow.value() <= 0.) {
+            seedSpacePoints(seeds, spacePointPtrs, rRangeSPExtent, finder,
+                            state);
+        } else {
+            // seeds only combine space points of the same time group
+            ::Jug::Base::TimeIndex timeIndex;
+            timeIndex.build(spacePointPtrs.size(), [&](size_t i) {
+                return spacePointPtrs[i]->t(); });
+            std::vector<const SpacePoint *> groupPtrs;
+            for (const auto &[first, last] :
+                 timeIndex.groups(m_timeWindow.value())) {
+                groupPtrs.clear();
+                for (size_t k = first; k < last; ++k) {
+                    groupPtrs.push_back(spacePointPtrs[timeIndex.order()[k]]);
+                }
+                seedSpacePoints(seeds, groupPtrs, rRangeSPExtent, finder,
+                                state);
             }
-#ifndef USE_LOCAL_COORD
-            spacePoint.push_back(SpacePoint(h, static_cast<int32_t>(spacePoint.size())));
-            spacePointPtrs.push_back(&spacePoint.back());
-            rRangeSPExtent.check({ spacePoint.back().x(),
-                                   spacePoint.back().y(),
-                                   spacePoint.back().z() });
-#endif // USE_LOCAL_COORD
         }
+
         if (msgLevel(MSG::DEBUG)) {
-            debug() << __FILE__ << ':' << __LINE__ << ": " << endmsg;
+            debug() << "seeds.size() = " << seeds.size() << endmsg;
         }
+    }
 
+    void TrackParamACTSSeeding::
+    seedSpacePoints(SeedContainer &seeds,
+                    const std::vector<const SpacePoint *> &spacePointPtrs,
+                    const Acts::Extent &rRangeSPExtent,
+                    const Acts::Seedfinder<SpacePoint> &finder,
+                    Acts::Seedfinder<SpacePoint>::State &state) const
+    {
+        JUG_PROFILE_REGION("TrackParamACTSSeeding/seedSpacePoints");
         auto extractGlobalQuantities =
             [=](const SpacePoint& sp, float, float, float) ->
             std::pair<Acts::Vector3, Acts::Vector2> {
@@ -384,21 +637,8 @@ namespace Jug::Reco {
             debug() << __FILE__ << ':' << __LINE__ << ": " << endmsg;
         }
 
-        auto bottomBinFinder =
-            std::make_shared<Acts::BinFinder<SpacePoint>>(
-                Acts::BinFinder<SpacePoint>(m_cfg.zBinNeighborsBottom,
-                                            m_cfg.numPhiNeighbors));
-        if (msgLevel(MSG::DEBUG)) {
-            debug() << __FILE__ << ':' << __LINE__ << ": " << endmsg;
-        }
-        auto topBinFinder =
-            std::make_shared<Acts::BinFinder<SpacePoint>>(
-                Acts::BinFinder<SpacePoint>(m_cfg.zBinNeighborsTop,
-                                            m_cfg.numPhiNeighbors));
-        if (msgLevel(MSG::DEBUG)) {
-            debug() << __FILE__ << ':' << __LINE__ << ": " << endmsg;
-        }
-
+        // the grid is filled (and owned) by the space point grouping,
+        // so it is made for each set of space points
         auto grid =
             Acts::SpacePointGridCreator::createGrid<SpacePoint>(
                 m_gridCfg);
@@ -409,35 +649,59 @@ namespace Jug::Reco {
         auto spacePointsGrouping =
             Acts::BinnedSPGroup<SpacePoint>(
                 spacePointPtrs.begin(), spacePointPtrs.end(),
-                extractGlobalQuantities, bottomBinFinder,
-                topBinFinder, std::move(grid), m_finderCfg);
-        auto finder = Acts::Seedfinder<SpacePoint>(m_finderCfg);
+                extractGlobalQuantities, m_bottomBinFinder,
+                m_topBinFinder, std::move(grid), m_finderCfg);
 
         if (msgLevel(MSG::DEBUG)) {
             debug() << __FILE__ << ':' << __LINE__
                     << ": spacePointsGrouping.size() = "
                     << spacePointsGrouping.size() << endmsg;
         }
-#if 0
-        topBinFinder.get();
-        bottomBinFinder.get();
-#endif
-        // Run the seeding
-        seeds.clear();
-
         auto group = spacePointsGrouping.begin();
         auto groupEnd = spacePointsGrouping.end();
-#if 1
-        for (; !(group == groupEnd); ++group) {
-            finder.createSeedsForGroup(
-                state, std::back_inserter(seeds),
-                group.bottom(), group.middle(), group.top(),
-                rRangeSPExtent);
-        }
-#endif
-
-        if (msgLevel(MSG::DEBUG)) {
-            debug() << "seeds.size() = " << seeds.size() << endmsg;
+        if (m_numThreads.value() == 1) {
+            for (; !(group == groupEnd); ++group) {
+                finder.createSeedsForGroup(
+                    state, std::back_inserter(seeds),
+                    group.bottom(), group.middle(), group.top(),
+                    rRangeSPExtent);
+            }
+        } else {
+            // the groups are independent: they are collected first, seeded
+            // in tasks with a finder state each, and their seeds are
+            // concatenated in group order
+            using Range = std::decay_t<decltype(group.bottom())>;
+            struct Group {
+                Range bottom;
+                Range middle;
+                Range top;
+            };
+            std::vector<Group> groups;
+            for (; !(group == groupEnd); ++group) {
+                groups.push_back({group.bottom(), group.middle(), group.top()});
+            }
+            const size_t ngroups = groups.size();
+            const size_t perTask = m_groupsPerTask.value();
+            const size_t ntasks = (ngroups + perTask - 1) / perTask;
+            std::vector<SeedContainer> groupSeeds(ngroups);
+            m_concurrencySvc->parallelFor(ntasks, [&](size_t task) {
+                Acts::Seedfinder<SpacePoint>::State taskState;
+                const size_t end = std::min(ngroups, (task + 1) * perTask);
+                for (size_t i = task * perTask; i < end; ++i) {
+                    finder.createSeedsForGroup(
+                        taskState, std::back_inserter(groupSeeds[i]),
+                        groups[i].bottom, groups[i].middle, groups[i].top,
+                        rRangeSPExtent);
+                }
+            });
+            size_t nseeds = 0;
+            for (const auto &s : groupSeeds) {
+                nseeds += s.size();
+            }
+            seeds.reserve(seeds.size() + nseeds);
+            for (auto &s : groupSeeds) {
+                std::move(s.begin(), s.end(), std::back_inserter(seeds));
+            }
         }
     }
 
@@ -453,10 +717,29 @@ namespace Jug::Reco {
         auto initTrackParameters =
             m_outputInitialTrackParameters.createAndPut();
 
-        static thread_local SeedContainer seeds;
-        static thread_local Acts::Seedfinder<SpacePoint>::State state;
+        // per-event seeding state, so that events can be seeded concurrently
+        SeedContainer seeds;
+        Acts::Seedfinder<SpacePoint>::State state;
+
+        const ::Jug::SpacePointContainer *spacePoints =
+            m_useSpacePoints ? m_inputSpacePoints.get() : nullptr;
+
+        // the collision region of the event, around the vertex seed if valid
+        std::optional<Acts::Seedfinder<SpacePoint>> vertexFinder;
+        if (m_useVertexSeed) {
+            ::Jug::VertexSeed vertex;
+            if (::Jug::VertexSeed::decode(*m_inputVertexSeed.get(), vertex) &&
+                vertex.valid) {
+                auto finderCfg = m_finderCfg;
+                finderCfg.collisionRegionMin = vertex.z - m_vertexWindow.value();
+                finderCfg.collisionRegionMax = vertex.z + m_vertexWindow.value();
+                vertexFinder.emplace(finderCfg);
+            }
+        }
+        const auto &finder = vertexFinder ? *vertexFinder : *m_finder;
 
-        findSeed(seeds, hits, sourceLinks, measurements, state);
+        findSeed(seeds, hits, sourceLinks, measurements, spacePoints,
+                 finder, state);
 
         TrackParametersContainer trackParameters;
         ProtoTrackContainer tracks;
@@ -488,14 +771,20 @@ namespace Jug::Reco {
             hitIdx = std::min(hitIdx, static_cast<uint32_t>(
                 sourceLinks->size() - 1));
             const Acts::Surface *surface = nullptr;
-            for (auto &s : *sourceLinks) {
-                surface = trackingGeometry->findSurface(s.get().geometryId());
-                if (surface != nullptr &&
-                    surface->isOnSurface(
-                        m_geoContext,
-                        {bottomSP->x(), bottomSP->y(), bottomSP->z()},
-                        {0, 0, 0})) {
-                    break;
+            if (spacePoints != nullptr) {
+                // the space points know their surface
+                surface = trackingGeometry->findSurface(
+                    bottomSP->geometryId());
+            } else {
+                for (auto &s : *sourceLinks) {
+                    surface = trackingGeometry->findSurface(s.get().geometryId());
+                    if (surface != nullptr &&
+                        surface->isOnSurface(
+                            m_geoContext,
+                            {bottomSP->x(), bottomSP->y(), bottomSP->z()},
+                            {0, 0, 0})) {
+                        break;
+                    }
                 }
             }
             if (surface == nullptr && msgLevel(MSG::DEBUG)) {
@@ -519,15 +808,14 @@ namespace Jug::Reco {
             auto fieldRes = magneticField->getField(
                 {bottomSP->x(), bottomSP->y(), bottomSP->z()},
                 bCache);
-            if (msgLevel(MSG::DEBUG)) { debug() << __FILE__ << ':' << __LINE__ << ": " << endmsg; }
+            JUG_DEBUG(__FILE__ << ':' << __LINE__ << ": ");
             // Estimate the track parameters from seed
             auto optParams = Acts::estimateTrackParamsFromSeed(
                 m_geoContext, seed.sp().begin(), seed.sp().end(),
                 *surface, *fieldRes, m_cfg.bFieldMin);
-            if (msgLevel(MSG::DEBUG)) { debug() << __FILE__ << ':' << __LINE__ << ": " << endmsg; }
+            JUG_DEBUG(__FILE__ << ':' << __LINE__ << ": ");
             if (not optParams.has_value()) {
-                debug() << "Estimation of track parameters for seed "
-                        << iseed << " failed." << endmsg;
+                JUG_DEBUG("Estimation of track parameters for seed " << iseed << " failed.");
                 continue;
             }
             else if (!(spTaken[seed.sp()[0]->measurementIndex()] ||
@@ -546,7 +834,7 @@ namespace Jug::Reco {
                 spTaken[seed.sp()[2]->measurementIndex()] = true;
 #endif
             }
-            if (msgLevel(MSG::DEBUG)) { debug() << __FILE__ << ':' << __LINE__ << ": " << endmsg; }
+            JUG_DEBUG(__FILE__ << ':' << __LINE__ << ": ");
         }
 
         return StatusCode::SUCCESS;
@@ -14,13 +14,14 @@
 #include "Acts/Definitions/Units.hpp"
 #include "JugBase/DataHandle.h"
 #include "JugBase/IGeoSvc.h"
+#include "JugTrack/ChargeEstimator.hpp"
 #include "JugTrack/Track.hpp"
+#include "JugTrack/TrackParamInit.hpp"
 
 #include "eicd/ClusterCollection.h"
 #include "eicd/TrackerHitCollection.h"
 #include "eicd/vector_utils.h"
 
-#include "Acts/Surfaces/PerigeeSurface.hpp"
 
 ///// (Reconstructed) track parameters e.g. close to the vertex.
 // using TrackParameters = Acts::CurvilinearTrackParameters;
@@ -49,11 +50,23 @@ private:
   DataHandle<Clusters> m_inputClusters{"inputClusters", Gaudi::DataHandle::Reader, this};
   DataHandle<TrackParametersContainer> m_outputInitialTrackParameters{"outputInitialTrackParameters",
                                                                       Gaudi::DataHandle::Writer, this};
+  // shared perigee surface at the origin
+  TrackParamInit m_init;
+  // optional charge estimate from the inner tracker hits (ChargeEstimator), both charges otherwise
+  DataHandle<eicd::TrackerHitCollection> m_inputInnerHits{"inputInnerHits", Gaudi::DataHandle::Reader, this};
+  Gaudi::Property<bool> m_estimateCharge{this, "estimateCharge", false, "Charge from the bending in the solenoid"};
+  Gaudi::Property<double> m_minBendingAngle{this, "minBendingAngle", 0.002,
+                                            "Bending (rad) below which both charges are seeded"};
+  Gaudi::Property<double> m_ambiguityFraction{this, "ambiguityFraction", 0.3,
+                                              "Fraction of the expected bending below which both charges are seeded"};
+  Gaudi::Property<double> m_maxDeltaEta{this, "maxDeltaEta", 0.05, "Pseudorapidity window of the inner hits"};
+  ChargeEstimator m_charge;
 
 public:
   TrackParamClusterInit(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
     declareProperty("inputClusters", m_inputClusters, "Input clusters");
     declareProperty("outputInitialTrackParameters", m_outputInitialTrackParameters, "");
+    declareProperty("inputInnerHits", m_inputInnerHits, "Inner tracker hits for the charge estimate");
   }
 
   StatusCode initialize() override {
@@ -64,6 +77,20 @@ public:
     if (randSvc == nullptr) {
       return StatusCode::FAILURE;
     }
+    if (m_estimateCharge) {
+      auto geoSvc = service<IGeoSvc>("GeoSvc");
+      if (!geoSvc) {
+        error() << "estimateCharge needs the GeoSvc for the field" << endmsg;
+        return StatusCode::FAILURE;
+      }
+      const auto fieldZ = ChargeEstimator::fieldZ(*geoSvc->getFieldProvider());
+      if (!fieldZ || *fieldZ == 0.) {
+        error() << "No solenoid field at the origin to estimate the charge" << endmsg;
+        return StatusCode::FAILURE;
+      }
+      m_charge = ChargeEstimator(
+          {*fieldZ, m_minBendingAngle.value(), m_ambiguityFraction.value(), m_maxDeltaEta.value()});
+    }
     return StatusCode::SUCCESS;
   }
 
@@ -71,7 +98,10 @@ public:
     // input collection
     const auto* const clusters = m_inputClusters.get();
     // Create output collections
-    auto* init_trk_params = m_outputInitialTrackParameters.createAndPut();
+    auto* init_trk_params = m_outputInitialTrackParameters.createAndPut(2 * clusters->size());
+    if (m_estimateCharge) {
+      m_charge.setHits(*m_inputInnerHits.get());
+    }
 
     for (const auto& c : *clusters) {
 
@@ -87,31 +117,18 @@ public:
       double len    = eicd::magnitude(c.getPosition());
       auto momentum = c.getPosition() * p / len;
 
-      Acts::BoundVector params;
-      params(Acts::eBoundLoc0)   = 0.0 * mm;
-      params(Acts::eBoundLoc1)   = 0.0 * mm;
-      params(Acts::eBoundPhi)    = eicd::angleAzimuthal(momentum);
-      params(Acts::eBoundTheta)  = eicd::anglePolar(momentum);
-      params(Acts::eBoundQOverP) = 1 / p;
-      params(Acts::eBoundTime)   = 0 * ns;
-
-      auto pSurface = Acts::Surface::makeShared<Acts::PerigeeSurface>(Acts::Vector3{0, 0, 0});
-
       if (msgLevel(MSG::DEBUG)) {
         debug() << "Invoke track finding seeded by truth particle with p = " << p / GeV << " GeV" << endmsg;
       }
 
-      // add both charges to the track candidate...
-      init_trk_params->push_back({pSurface, params, 1});
-
-      Acts::BoundVector params2;
-      params2(Acts::eBoundLoc0)   = 0.0 * mm;
-      params2(Acts::eBoundLoc1)   = 0.0 * mm;
-      params2(Acts::eBoundPhi)    = eicd::angleAzimuthal(momentum);
-      params2(Acts::eBoundTheta)  = eicd::anglePolar(momentum);
-      params2(Acts::eBoundQOverP) = -1 / p;
-      params2(Acts::eBoundTime)   = 0 * ns;
-      init_trk_params->push_back({pSurface, params2, -1});
+      // one charge if it is estimated, both charges otherwise
+      const double phi   = eicd::angleAzimuthal(momentum);
+      const double theta = eicd::anglePolar(momentum);
+      const int charge   = m_estimateCharge ? m_charge.charge(phi, eicd::eta(c.getPosition()),
+                                                              std::hypot(c.getPosition().x, c.getPosition().y),
+                                                              p * std::sin(theta))
+                                            : 0;
+      m_init.add(*init_trk_params, phi, theta, p, charge);
 
       // acts v1.2.0:
       // init_trk_params->emplace_back(Acts::Vector4(0 * mm, 0 * mm, 0 * mm, 0),
@@ -12,7 +12,10 @@
 
 #include "JugBase/DataHandle.h"
 #include "JugBase/IGeoSvc.h"
+#include "JugBase/Logging.h"
+#include "JugTrack/ChargeEstimator.hpp"
 #include "JugTrack/Track.hpp"
+#include "JugTrack/TrackParamInit.hpp"
 #include "Acts/Definitions/Units.hpp"
 #include "Acts/Definitions/Common.hpp"
 
@@ -20,7 +23,6 @@
 #include "eicd/ClusterCollection.h"
 #include "eicd/vector_utils.h"
 
-#include "Acts/Surfaces/PerigeeSurface.hpp"
 
   ///// (Reconstructed) track parameters e.g. close to the vertex.
   //using TrackParameters = Acts::CurvilinearTrackParameters;
@@ -49,12 +51,24 @@ namespace Jug::Reco {
     DataHandle<ImagingClusters>          m_inputClusters{"inputClusters", Gaudi::DataHandle::Reader, this};
     DataHandle<TrackParametersContainer> m_outputInitialTrackParameters{"outputInitialTrackParameters",
                                                                         Gaudi::DataHandle::Writer, this};
+    // shared perigee surface at the origin
+    TrackParamInit m_init;
+    // optional charge estimate from the inner tracker hits (ChargeEstimator), both charges otherwise
+    DataHandle<eicd::TrackerHitCollection> m_inputInnerHits{"inputInnerHits", Gaudi::DataHandle::Reader, this};
+    Gaudi::Property<bool> m_estimateCharge{this, "estimateCharge", false, "Charge from the bending in the solenoid"};
+    Gaudi::Property<double> m_minBendingAngle{this, "minBendingAngle", 0.002,
+                                              "Bending (rad) below which both charges are seeded"};
+    Gaudi::Property<double> m_ambiguityFraction{this, "ambiguityFraction", 0.3,
+                                                "Fraction of the expected bending below which both charges are seeded"};
+    Gaudi::Property<double> m_maxDeltaEta{this, "maxDeltaEta", 0.05, "Pseudorapidity window of the inner hits"};
+    ChargeEstimator m_charge;
 
   public:
     TrackParamImagingClusterInit(const std::string& name, ISvcLocator* svcLoc)
         : GaudiAlgorithm(name, svcLoc) {
       declareProperty("inputClusters", m_inputClusters, "Input clusters");
       declareProperty("outputInitialTrackParameters", m_outputInitialTrackParameters, "");
+      declareProperty("inputInnerHits", m_inputInnerHits, "Inner tracker hits for the charge estimate");
     }
 
     StatusCode initialize() override {
@@ -65,6 +79,20 @@ namespace Jug::Reco {
       if (randSvc == nullptr) {
         return StatusCode::FAILURE;
       }
+      if (m_estimateCharge) {
+        auto geoSvc = service<IGeoSvc>("GeoSvc");
+        if (!geoSvc) {
+          error() << "estimateCharge needs the GeoSvc for the field" << endmsg;
+          return StatusCode::FAILURE;
+        }
+        const auto fieldZ = ChargeEstimator::fieldZ(*geoSvc->getFieldProvider());
+        if (!fieldZ || *fieldZ == 0.) {
+          error() << "No solenoid field at the origin to estimate the charge" << endmsg;
+          return StatusCode::FAILURE;
+        }
+        m_charge = ChargeEstimator(
+            {*fieldZ, m_minBendingAngle.value(), m_ambiguityFraction.value(), m_maxDeltaEta.value()});
+      }
       return StatusCode::SUCCESS;
     }
 
@@ -72,7 +100,10 @@ namespace Jug::Reco {
       // input collection
       const auto* const clusters = m_inputClusters.get();
       // Create output collections
-      auto* init_trk_params = m_outputInitialTrackParameters.createAndPut();
+      auto* init_trk_params = m_outputInitialTrackParameters.createAndPut(2 * clusters->size());
+      if (m_estimateCharge) {
+        m_charge.setHits(*m_inputInnerHits.get());
+      }
 
       for(const auto& c : *clusters) {
 
@@ -89,30 +120,14 @@ namespace Jug::Reco {
         const double theta = eicd::anglePolar(c.getPosition());
         const double phi = eicd::angleAzimuthal(c.getPosition());
 
-        Acts::BoundVector  params;
-        params(Acts::eBoundLoc0)   = 0.0 * mm ;
-        params(Acts::eBoundLoc1)   = 0.0 * mm ;
-        params(Acts::eBoundPhi)    = phi;
-        params(Acts::eBoundTheta)  = theta;
-        params(Acts::eBoundQOverP) = 1/p;
-        params(Acts::eBoundTime)   = 0 * ns;
-
-        auto pSurface = Acts::Surface::makeShared<Acts::PerigeeSurface>(Acts::Vector3{0,0,0});
-
-        debug() << "Invoke track finding seeded by truth particle with p = " << p/GeV  << " GeV" << endmsg;
-
-        // add both charges to the track candidate...
-        init_trk_params->push_back({pSurface, params,  1});
-
-        Acts::BoundVector  params2;
-        params2(Acts::eBoundLoc0)   = 0.0 * mm ;
-        params2(Acts::eBoundLoc1)   = 0.0 * mm ;
-        params2(Acts::eBoundPhi)    = phi;
-        params2(Acts::eBoundTheta)  = theta;
-        params2(Acts::eBoundQOverP) = -1/p;
-        params2(Acts::eBoundTime)   = 0 * ns;
-        init_trk_params->push_back({pSurface, params2, -1});
+        JUG_DEBUG("Invoke track finding seeded by truth particle with p = " << p / GeV << " GeV");
 
+        // one charge if it is estimated, both charges otherwise
+        const int charge = m_estimateCharge ? m_charge.charge(phi, eicd::eta(c.getPosition()),
+                                                              std::hypot(c.getPosition().x, c.getPosition().y),
+                                                              p * std::sin(theta))
+                                            : 0;
+        m_init.add(*init_trk_params, phi, theta, p, charge);
       }
       return StatusCode::SUCCESS;
     }
@@ -2,6 +2,7 @@
 // Copyright (C) 2022 Whitney Armstrong, Wouter Deconinck, Sylvester Joosten
 
 #include <cmath>
+#include <memory>
 // Gaudi
 #include "Gaudi/Property.h"
 #include "GaudiAlg/GaudiAlgorithm.h"
@@ -14,14 +15,15 @@
 #include "JugBase/DataHandle.h"
 #include "JugBase/IGeoSvc.h"
 #include "JugBase/IParticleSvc.h"
+#include "JugBase/TruthParticleIndex.h"
 #include "JugTrack/Track.hpp"
+#include "JugTrack/TrackParamInit.hpp"
 #include "Acts/Definitions/Units.hpp"
 #include "Acts/Definitions/Common.hpp"
 
 #include "eicd/TrackerHitCollection.h"
 #include "edm4hep/MCParticleCollection.h"
 #include "Math/Vector3D.h"
-#include "Acts/Surfaces/PerigeeSurface.hpp"
 
 
   ///// (Reconstructed) track parameters e.g. close to the vertex.
@@ -57,9 +59,17 @@ namespace Jug::Reco {
     Gaudi::Property<double> m_minMomentum{this, "minMomentum", 100. * Gaudi::Units::MeV};
     Gaudi::Property<double> m_maxEtaForward{this, "maxEtaForward", 4.0};
     Gaudi::Property<double> m_maxEtaBackward{this, "maxEtaBackward", 4.1};
+    // Charged primaries and their momenta from the truth index of the event (TruthParticleIndexer),
+    // instead of scanning the MCParticles
+    Gaudi::Property<std::string> m_inputTruthIndex{this, "inputTruthIndex", ""};
+    std::unique_ptr<DataHandle<TruthParticleIndex>> m_truthIndex_ptr;
 
     SmartIF<IParticleSvc> m_pidSvc;
 
+    // perigee surfaces and seed covariance, shared by the seeds
+    TrackParamInit m_init;
+    const Acts::BoundSymMatrix m_covariance{TrackParamInit::covariance()};
+
   public:
     TrackParamTruthInit(const std::string& name, ISvcLocator* svcLoc)
         : GaudiAlgorithm(name, svcLoc) {
@@ -82,6 +92,10 @@ namespace Jug::Reco {
                 << endmsg;
         return StatusCode::FAILURE;
       }
+      if (!m_inputTruthIndex.value().empty()) {
+        m_truthIndex_ptr = std::make_unique<DataHandle<TruthParticleIndex>>(m_inputTruthIndex,
+                                                                            Gaudi::DataHandle::Reader, this);
+      }
       return StatusCode::SUCCESS;
     }
 
@@ -89,9 +103,14 @@ namespace Jug::Reco {
       // input collection
       const auto* const mcparts = m_inputMCParticles.get();
       // Create output collections
-      auto* init_trk_params = m_outputInitialTrackParameters.createAndPut();
+      auto* init_trk_params = m_outputInitialTrackParameters.createAndPut(mcparts->size());
+      // only the charged primaries with the truth index
+      const TruthParticleIndex* truth = m_truthIndex_ptr ? m_truthIndex_ptr->get() : nullptr;
+      const size_t ncandidates        = (truth != nullptr) ? truth->chargedPrimaries.size() : mcparts->size();
 
-      for(const auto& part : *mcparts) {
+      for (size_t k = 0; k < ncandidates; ++k) {
+        const size_t i   = (truth != nullptr) ? truth->chargedPrimaries[k] : k;
+        const auto& part = (*mcparts)[i];
 
         // getGeneratorStatus = 1 means thrown G4Primary, but dd4gun uses getGeneratorStatus == 0
         if (part.getGeneratorStatus() > 1 ) {
@@ -113,7 +132,7 @@ namespace Jug::Reco {
 
         // require minimum momentum
         const auto& p = part.getMomentum();
-        const auto pmag = std::hypot(p.x, p.y, p.z);
+        const auto pmag = (truth != nullptr) ? truth->p[i] : std::hypot(p.x, p.y, p.z);
         if (pmag * Gaudi::Units::GeV < m_minMomentum) {
           if (msgLevel(MSG::DEBUG)) {
             debug() << "ignoring particle with p = " << pmag << " GeV" << endmsg;
@@ -122,9 +141,9 @@ namespace Jug::Reco {
         }
 
         // require minimum pseudorapidity
-        const auto phi   = std::atan2(p.y, p.x);
-        const auto theta = std::atan2(std::hypot(p.x, p.y), p.z);
-        const auto eta   = -std::log(std::tan(theta/2));
+        const auto phi   = (truth != nullptr) ? truth->phi[i] : std::atan2(p.y, p.x);
+        const auto theta = (truth != nullptr) ? truth->theta[i] : std::atan2(std::hypot(p.x, p.y), p.z);
+        const auto eta   = (truth != nullptr) ? truth->eta[i] : -std::log(std::tan(theta/2));
         if (eta > m_maxEtaForward || eta < -std::abs(m_maxEtaBackward)) {
           if (msgLevel(MSG::DEBUG)) {
             debug() << "ignoring particle with Eta = " << eta << endmsg;
@@ -135,7 +154,7 @@ namespace Jug::Reco {
         // get the particle charge
         // note that we cannot trust the mcparticles charge, as DD4hep
         // sets this value to zero! let's lookup by PDGID instead
-        const double charge = m_pidSvc->particle(part.getPDG()).charge;
+        const double charge = (truth != nullptr) ? truth->charge[i] : m_pidSvc->particle(part.getPDG()).charge;
         if (abs(charge) < std::numeric_limits<double>::epsilon()) {
           if (msgLevel(MSG::DEBUG)) {
             debug() << "ignoring neutral particle" << endmsg;
@@ -149,30 +168,13 @@ namespace Jug::Reco {
         using Acts::UnitConstants::um;
         using Acts::UnitConstants::ns;
 
-        // build some track cov matrix
-        Acts::BoundSymMatrix cov                    = Acts::BoundSymMatrix::Zero();
-        cov(Acts::eBoundLoc0, Acts::eBoundLoc0)     = 1000*um*1000*um;
-        cov(Acts::eBoundLoc1, Acts::eBoundLoc1)     = 1000*um*1000*um;
-        cov(Acts::eBoundPhi, Acts::eBoundPhi)       = 0.05*0.05;
-        cov(Acts::eBoundTheta, Acts::eBoundTheta)   = 0.01*0.01;
-        cov(Acts::eBoundQOverP, Acts::eBoundQOverP) = (0.1*0.1) / (GeV*GeV);
-        cov(Acts::eBoundTime, Acts::eBoundTime)     = 10.0e9*ns*10.0e9*ns;
-
-        Acts::BoundVector  params;
-        params(Acts::eBoundLoc0)   = 0.0 * mm ;  // cylinder radius
-        params(Acts::eBoundLoc1)   = 0.0 * mm ; // cylinder length
-        params(Acts::eBoundPhi)    = phi;
-        params(Acts::eBoundTheta)  = theta;
-        params(Acts::eBoundQOverP) = charge / (pmag * GeV);
-        params(Acts::eBoundTime)   = part.getTime() * ns;
-
-        //// Construct a perigee surface as the target surface
-        auto pSurface = Acts::Surface::makeShared<Acts::PerigeeSurface>(
-            Acts::Vector3{part.getVertex().x * mm, part.getVertex().y * mm, part.getVertex().z * mm});
-
-        //params(Acts::eBoundQOverP) = charge/p;
-        init_trk_params->push_back({pSurface, params, charge,cov});
-        // std::make_optional(std::move(cov))
+        const auto params = TrackParamInit::parameters(phi, theta, charge / (pmag * GeV), part.getTime() * ns);
+
+        //// Perigee surface at the vertex as the target surface, shared by the particles of the same vertex
+        const auto& pSurface =
+            m_init.surface(Acts::Vector3{part.getVertex().x * mm, part.getVertex().y * mm, part.getVertex().z * mm});
+
+        init_trk_params->emplace_back(pSurface, params, charge, m_covariance);
 
         if (msgLevel(MSG::DEBUG)) {
           debug() << "Invoke track finding seeded by truth particle with p = " << pmag << " GeV" << endmsg;
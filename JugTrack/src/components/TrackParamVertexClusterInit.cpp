@@ -1,7 +1,10 @@
 // SPDX-License-Identifier: LGPL-3.0-or-later
 // Copyright (C) 2022 Whitney Armstrong, Sylvester Joosten
 
+#include <algorithm>
 #include <cmath>
+#include <utility>
+#include <vector>
 
 // Gaudi
 #include "Gaudi/Property.h"
@@ -16,9 +19,10 @@
 #include "Acts/Definitions/Units.hpp"
 #include "JugBase/DataHandle.h"
 #include "JugBase/IGeoSvc.h"
+#include "JugTrack/ChargeEstimator.hpp"
 #include "JugTrack/Track.hpp"
+#include "JugTrack/TrackParamInit.hpp"
 
-#include "Acts/Surfaces/PerigeeSurface.hpp"
 #include "eicd/ClusterCollection.h"
 #include "eicd/TrackerHitCollection.h"
 #include "eicd/vector_utils.h"
@@ -33,6 +37,14 @@ namespace Jug::Reco {
  * The momentum of the initial track is estimated from the cluster  energy and
  * the direction is set using the vertex hits.
  *
+ * The vertex hits within maxHitRadius are indexed by azimuth once per event. With maxDeltaPhi
+ * (and maxDeltaEta) a cluster is only paired with the hits in that window around its direction,
+ * instead of all of them. The directions of a cluster within mergeAngle of a previous one (in
+ * eta and phi) are merged into it, e.g. those of the hits of a track in consecutive layers. With
+ * estimateCharge the charge follows from the bending between the azimuths of the hit and the
+ * cluster in the solenoid field (ChargeEstimator), and one seed replaces the pair of both
+ * charges unless it is ambiguous. Everything is off by default: all the hits, both charges.
+ *
  * \ingroup tracking
  */
 class TrackParamVertexClusterInit : public GaudiAlgorithm {
@@ -45,6 +57,25 @@ private:
   DataHandle<TrackParametersContainer> m_outputInitialTrackParameters{"outputInitialTrackParameters",
                                                                       Gaudi::DataHandle::Writer, this};
   Gaudi::Property<double> m_maxHitRadius{this, "maxHitRadius", 40.0 * mm};
+  Gaudi::Property<double> m_maxDeltaPhi{this, "maxDeltaPhi", 0. * rad, "Azimuth window of the hits (0: all)"};
+  Gaudi::Property<double> m_maxDeltaEta{this, "maxDeltaEta", 0., "Pseudorapidity window of the hits (0: all)"};
+  Gaudi::Property<double> m_mergeAngle{this, "mergeAngle", 0. * rad, "Merged directions of a cluster (0: none)"};
+  Gaudi::Property<bool> m_estimateCharge{this, "estimateCharge", false, "Charge from the bending in the solenoid"};
+  Gaudi::Property<double> m_minBendingAngle{this, "minBendingAngle", 0.002 * rad,
+                                            "Bending below which both charges are seeded"};
+  Gaudi::Property<double> m_ambiguityFraction{this, "ambiguityFraction", 0.3,
+                                              "Fraction of the expected bending below which both charges are seeded"};
+  // shared perigee surface at the origin
+  TrackParamInit m_init;
+  ChargeEstimator m_charge;
+
+  struct VertexHit {
+    double phi;
+    double eta;
+    double len;
+    double r;
+    eicd::Vector3f position;
+  };
 
 public:
   TrackParamVertexClusterInit(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
@@ -61,6 +92,19 @@ public:
     if (randSvc == nullptr) {
       return StatusCode::FAILURE;
     }
+    if (m_estimateCharge) {
+      auto geoSvc = service<IGeoSvc>("GeoSvc");
+      if (!geoSvc) {
+        error() << "estimateCharge needs the GeoSvc for the field" << endmsg;
+        return StatusCode::FAILURE;
+      }
+      const auto fieldZ = ChargeEstimator::fieldZ(*geoSvc->getFieldProvider());
+      if (!fieldZ || *fieldZ == 0.) {
+        error() << "No solenoid field at the origin to estimate the charge" << endmsg;
+        return StatusCode::FAILURE;
+      }
+      m_charge = ChargeEstimator({*fieldZ, m_minBendingAngle.value(), m_ambiguityFraction.value()});
+    }
     return StatusCode::SUCCESS;
   }
 
@@ -69,10 +113,28 @@ public:
     const auto* const clusters = m_inputClusters.get();
     const auto* const vtx_hits = m_inputVertexHits.get();
     // Create output collections
-    auto* init_trk_params = m_outputInitialTrackParameters.createAndPut();
+    auto* init_trk_params = m_outputInitialTrackParameters.createAndPut(2 * clusters->size());
 
     double max_radius = m_maxHitRadius.value();
 
+    // the hits within the radius, sorted by azimuth (in their order without window)
+    std::vector<VertexHit> hits;
+    hits.reserve(vtx_hits->size());
+    for (const auto& t : *vtx_hits) {
+      const double len = std::hypot(t.getPosition().x, t.getPosition().y, t.getPosition().z);
+      if (len > max_radius) {
+        continue;
+      }
+      hits.push_back({eicd::angleAzimuthal(t.getPosition()), eicd::eta(t.getPosition()), len,
+                      std::hypot(t.getPosition().x, t.getPosition().y), t.getPosition()});
+    }
+    const bool window = m_maxDeltaPhi.value() > 0. && m_maxDeltaPhi.value() < M_PI;
+    if (window) {
+      std::sort(hits.begin(), hits.end(), [](const VertexHit& a, const VertexHit& b) { return a.phi < b.phi; });
+    }
+
+    // directions of the seeds of the cluster, for the merging
+    std::vector<std::pair<double, double>> directions;
     for (const auto& c : *clusters) {
 
       using Acts::UnitConstants::GeV;
@@ -87,46 +149,61 @@ public:
         }
         continue;
       }
+      const double c_phi = eicd::angleAzimuthal(c.getPosition());
+      const double c_eta = eicd::eta(c.getPosition());
+      const double c_r   = std::hypot(c.getPosition().x, c.getPosition().y);
+
+      directions.clear();
+      auto seed = [&](const VertexHit& t) {
+        if (m_maxDeltaEta.value() > 0. && std::abs(t.eta - c_eta) > m_maxDeltaEta.value()) {
+          return;
+        }
+        for (const auto& [phi, eta] : directions) {
+          if (std::abs(ChargeEstimator::deltaPhi(t.phi, phi)) < m_mergeAngle.value() &&
+              std::abs(t.eta - eta) < m_mergeAngle.value()) {
+            return;
+          }
+        }
+        if (m_mergeAngle.value() > 0.) {
+          directions.emplace_back(t.phi, t.eta);
+        }
 
-      auto pSurface = Acts::Surface::makeShared<Acts::PerigeeSurface>(Acts::Vector3{0, 0, 0});
-      for (const auto& t : *vtx_hits) {
+        auto momentum = t.position * p_cluster / t.len;
+        // one charge if it is estimated, both charges otherwise
+        const int charge =
+            m_estimateCharge ? m_charge.charge(t.phi, t.r, c_phi, c_r, p_cluster * t.r / t.len) : 0;
+        m_init.add(*init_trk_params, eicd::angleAzimuthal(momentum), eicd::anglePolar(momentum), p_cluster, charge);
+      };
 
-        double len = std::hypot(t.getPosition().x, t.getPosition().y, t.getPosition().z);
-        if (len > max_radius) {
-          continue;
+      if (!window) {
+        for (const auto& t : hits) {
+          seed(t);
         }
-
-        auto momentum = t.getPosition() * p_cluster / len;
-
-        Acts::BoundVector params;
-        params(Acts::eBoundLoc0)   = 0.0 * mm;
-        params(Acts::eBoundLoc1)   = 0.0 * mm;
-        params(Acts::eBoundPhi)    = eicd::angleAzimuthal(momentum);
-        params(Acts::eBoundTheta)  = eicd::anglePolar(momentum);
-        params(Acts::eBoundQOverP) = 1 / p_cluster;
-        params(Acts::eBoundTime)   = 0 * ns;
-
-        // debug() << "Invoke track finding seeded by truth particle with p = " << p / GeV << " GeV" << endmsg;
-
-        // add both charges to the track candidate...
-        init_trk_params->push_back({pSurface, params, 1});
-
-        Acts::BoundVector params2;
-        params2(Acts::eBoundLoc0)   = 0.0 * mm;
-        params2(Acts::eBoundLoc1)   = 0.0 * mm;
-        params2(Acts::eBoundPhi)    = eicd::angleAzimuthal(momentum);
-        params2(Acts::eBoundTheta)  = eicd::anglePolar(momentum);
-        params2(Acts::eBoundQOverP) = -1 / p_cluster;
-        params2(Acts::eBoundTime)   = 0 * ns;
-        init_trk_params->push_back({pSurface, params2, -1});
+        continue;
+      }
+      // the azimuth window, split in two at +-pi
+      const double lo = c_phi - m_maxDeltaPhi.value();
+      const double hi = c_phi + m_maxDeltaPhi.value();
+      auto seedRange  = [&](double from, double to) {
+        auto it = std::lower_bound(hits.begin(), hits.end(), from,
+                                   [](const VertexHit& h, double phi) { return h.phi < phi; });
+        for (; it != hits.end() && it->phi <= to; ++it) {
+          seed(*it);
+        }
+      };
+      if (lo < -M_PI) {
+        seedRange(lo + 2 * M_PI, M_PI);
+        seedRange(-M_PI, hi);
+      } else if (hi > M_PI) {
+        seedRange(lo, M_PI);
+        seedRange(-M_PI, hi - 2 * M_PI);
+      } else {
+        seedRange(lo, hi);
       }
-      // init_trk_params->emplace_back(Acts::Vector4(0 * mm, 0 * mm, 0 * mm, 0),
-      //                              Acts::Vector3(c.x() * p / len, c.y() * p / len, c.z() * p / len), p, 1,
-      //                              std::make_optional(cov));
-      // init_trk_params->emplace_back(Acts::Vector4(0 * mm, 0 * mm, 0 * mm, 0),
-      //                              Acts::Vector3(c.x() * p / len, c.y() * p / len, c.z() * p / len), p, 0,
-      //                              std::make_optional(cov));
-      // debug() << "Invoke track finding seeded by truth particle with p = " << p_cluster/GeV  << " GeV" << endmsg;
+    }
+    if (msgLevel(MSG::DEBUG)) {
+      debug() << init_trk_params->size() << " seeds from " << clusters->size() << " clusters and " << hits.size()
+              << " vertex hits" << endmsg;
     }
     return StatusCode::SUCCESS;
   }
@@ -26,9 +26,10 @@
 #include "eicd/TrackParametersCollection.h"
 #include "eicd/TrajectoryCollection.h"
 #include "eicd/TrackSegmentCollection.h"
-#include "JugTrack/IndexSourceLink.hpp"
+#include "JugBase/IndexSourceLink.hpp"
 #include "JugTrack/Track.hpp"
 #include "JugTrack/Trajectories.hpp"
+#include "JugTrack/TrajectorySummary.hpp"
 
 #include "Acts/Utilities/Helpers.hpp"
 #include "Acts/Geometry/GeometryIdentifier.hpp"
@@ -45,6 +46,9 @@
 namespace Jug::Reco {
 
   /** Extrac the particles form fit trajectories.
+   *
+   *  With useSummaries, the track states are read from the summaries of TrajectorySummarizer
+   *  instead of being walked again.
    *
    * \ingroup tracking
    */
@@ -52,6 +56,9 @@ namespace Jug::Reco {
    private:
     DataHandle<TrajectoriesContainer>        m_inputTrajectories{"inputTrajectories", Gaudi::DataHandle::Reader, this};
     DataHandle<eicd::TrackSegmentCollection> m_outputTrackSegments{"outputTrackSegments", Gaudi::DataHandle::Writer, this};
+    DataHandle<TrajectorySummaryContainer>   m_inputTrajectorySummaries{"inputTrajectorySummaries", Gaudi::DataHandle::Reader, this};
+
+    Gaudi::Property<bool> m_useSummaries{this, "useSummaries", false, "Read the trajectory summaries of TrajectorySummarizer"};
 
     Gaudi::Property<unsigned int> m_firstInVolumeID{this, "firstInVolumeID", 0};
     Gaudi::Property<std::string> m_firstInVolumeName{this, "firstInVolumeName", ""};
@@ -67,6 +74,7 @@ namespace Jug::Reco {
         : GaudiAlgorithm(name, svcLoc) {
           declareProperty("inputTrajectories", m_inputTrajectories,"");
           declareProperty("outputTrackSegments", m_outputTrackSegments, "");
+          declareProperty("inputTrajectorySummaries", m_inputTrajectorySummaries, "");
         }
 
     StatusCode initialize() override {
@@ -76,85 +84,55 @@ namespace Jug::Reco {
     }
 
     StatusCode execute() override {
-      // input collection
-      const auto* const trajectories = m_inputTrajectories.get();
       // create output collections
       auto* track_segments = m_outputTrackSegments.createAndPut();
 
+      // one pass over the track states of every trajectory, unless already summarized
+      TrajectorySummaryContainer localSummaries;
+      const TrajectorySummaryContainer* summaries = &localSummaries;
+      if (m_useSummaries) {
+        summaries = m_inputTrajectorySummaries.get();
+      } else {
+        localSummaries = summarizeTrajectories(*m_inputTrajectories.get(), m_geoContext);
+      }
+
       if (msgLevel(MSG::DEBUG)) {
-        debug() << std::size(*trajectories) << " trajectories " << endmsg;
+        debug() << std::size(*summaries) << " trajectories " << endmsg;
       }
 
       // Loop over the trajectories
-      for (const auto& traj : *trajectories) {
-        // Get the entry index for the single trajectory
-        // The trajectory entry indices and the multiTrajectory
-        const auto& mj        = traj.multiTrajectory();
-        const auto& trackTips = traj.tips();
-        if (msgLevel(MSG::DEBUG)) {
-          debug() << "# of elements in trackTips " <<trackTips.size() << endmsg;
-        }
-
-        // Skip empty
-        if (trackTips.empty()) {
-          if (msgLevel(MSG::DEBUG)) {
-            debug() << "Empty multiTrajectory." << endmsg;
-          }
-          continue;
-        }
-        auto& trackTip = trackTips.front();
-
-        // Collect the trajectory summary info
-        auto trajState       = Acts::MultiTrajectoryHelpers::trajectoryState(mj, trackTip);
-        int  m_nMeasurements = trajState.nMeasurements;
-        int  m_nStates       = trajState.nStates;
-        int  m_nCalibrated   = 0;
+      for (const auto& summary : *summaries) {
         if (msgLevel(MSG::DEBUG)) {
-          debug() << "n measurement in trajectory " << m_nMeasurements << endmsg;
-          debug() << "n state in trajectory " << m_nStates << endmsg;
+          debug() << "n measurement in trajectory " << summary.nMeasurements << endmsg;
+          debug() << "n state in trajectory " << summary.nStates << endmsg;
         }
+        int m_nCalibrated = 0;
 
         eicd::MutableTrackSegment track_segment;
 
-        // visit the track points
-        mj.visitBackwards(trackTip, [&](auto&& trackstate) {
-          auto pathLength = trackstate.pathLength();
+        // the track points, from the outermost
+        for (const auto& trackstate : summary.states) {
+          auto pathLength = trackstate.pathLength;
 
           // get volume info
-          auto geoID = trackstate.referenceSurface().geometryId();
+          auto geoID = trackstate.geometryId;
           auto volume = geoID.volume();
           auto layer = geoID.layer();
-          if (trackstate.hasCalibrated()) {
+          if (trackstate.calibrated) {
             m_nCalibrated++;
           }
 
           // get track state parameters and their covariances
-          const auto& parameter = trackstate.predicted();
-          const auto& covariance = trackstate.predictedCovariance();
-
-          // convert local to global
-          auto global = trackstate.referenceSurface().localToGlobal(
-            m_geoContext,
-            {parameter[Acts::eBoundLoc0], parameter[Acts::eBoundLoc1]},
-            {0, 0, 0}
-          );
+          const auto& parameter = trackstate.parameters;
+          const auto& covariance = trackstate.covariance;
+
           // global position
           const eicd::Vector3f position {
-            global.x(),
-            global.y(),
-            global.z()
+            static_cast<float>(trackstate.position.x()),
+            static_cast<float>(trackstate.position.y()),
+            static_cast<float>(trackstate.position.z())
           };
 
-          // local position
-          const eicd::Vector2f loc {
-            parameter[Acts::eBoundLoc0],
-            parameter[Acts::eBoundLoc1]
-          };
-          const eicd::Cov2f covLoc {
-            static_cast<float>(covariance(Acts::eBoundLoc0, Acts::eBoundLoc0)),
-            static_cast<float>(covariance(Acts::eBoundLoc1, Acts::eBoundLoc1)),
-            static_cast<float>(covariance(Acts::eBoundLoc0, Acts::eBoundLoc1))
-          };
           const eicd::Cov3f positionError{0, 0, 0};
           const eicd::Vector3f momentum = eicd::sphericalToVector(
             1.0 / std::abs(parameter[Acts::eBoundQOverP]),
@@ -197,14 +175,14 @@ namespace Jug::Reco {
 
           if (msgLevel(MSG::DEBUG)) {
             debug() << "******************************" << endmsg;
-            debug() << "predicted variables: \n" << trackstate.predicted() << endmsg;
+            debug() << "predicted variables: \n" << parameter << endmsg;
             debug() << "geoID = " << geoID << endmsg;
             debug() << "volume = " << volume << ", layer = " << layer << endmsg;
             debug() << "pathlength = " << pathLength << endmsg;
-            debug() << "hasCalibrated = " << trackstate.hasCalibrated() << endmsg;
+            debug() << "hasCalibrated = " << trackstate.calibrated << endmsg;
             debug() << "******************************" << endmsg;
           }
-        });
+        }
 
         if (msgLevel(MSG::DEBUG)) {
           debug() << "n calibrated state in trajectory " << m_nCalibrated << endmsg;
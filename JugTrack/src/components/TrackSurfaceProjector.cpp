@@ -0,0 +1,278 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <vector>
+
+// Gaudi
+#include "Gaudi/Property.h"
+
+#include "Acts/Definitions/Units.hpp"
+#include "Acts/Geometry/GeometryContext.hpp"
+#include "Acts/MagneticField/MagneticFieldContext.hpp"
+#include "Acts/MagneticField/MagneticFieldProvider.hpp"
+#include "Acts/Propagator/EigenStepper.hpp"
+#include "Acts/Propagator/Propagator.hpp"
+#include "Acts/Propagator/StraightLineStepper.hpp"
+#include "Acts/Surfaces/CylinderSurface.hpp"
+#include "Acts/Surfaces/DiscSurface.hpp"
+#include "Acts/Utilities/Logger.hpp"
+
+#include "JugBase/ACTSLogger.h"
+#include "JugBase/IConcurrencySvc.h"
+#include "JugBase/IGeoSvc.h"
+#include "JugBase/Transformer.h"
+#include "JugTrack/Track.hpp"
+#include "JugTrack/Trajectories.hpp"
+
+// Event Model related classes
+#include "eicd/TrackSegmentCollection.h"
+#include "eicd/vector_utils.h"
+
+namespace Jug::Reco {
+
+/** Projection of the fitted tracks to reference surfaces.
+ *
+ *  The fitted parameters of the first tip of every trajectory are propagated to each of the
+ *  configured cylinders (centered on the beam line) and discs (perpendicular to it), e.g. the
+ *  calorimeter front faces or the RICH aerogel and mirror planes, for the cluster matching and
+ *  the RICH reconstruction. Unlike TrackProjector, which only reports the fitted states, the
+ *  surfaces need not be on the trajectory. Every track gives a segment with a point for each
+ *  surface it reaches, in the configured order (cylinders first).
+ *
+ *  With fieldRadius and fieldHalfLength set, the field propagation stops at the boundary of the
+ *  field region and the surfaces outside of it are reached on straight lines from there.
+ *  The tracks are projected in parallel tasks of tracksPerTask tracks in the ConcurrencySvc arena.
+ *
+ * \ingroup tracking
+ */
+class TrackSurfaceProjector : public Jug::Transformer<eicd::TrackSegmentCollection, TrajectoriesContainer> {
+private:
+  Gaudi::Property<std::vector<double>> m_cylinderRadii{this, "cylinderRadii", {}};
+  Gaudi::Property<std::vector<double>> m_cylinderHalfLengths{this, "cylinderHalfLengths", {}};
+  Gaudi::Property<std::vector<double>> m_discZ{this, "discZ", {}};
+  Gaudi::Property<std::vector<double>> m_discRMin{this, "discRMin", {}};
+  Gaudi::Property<std::vector<double>> m_discRMax{this, "discRMax", {}};
+
+  /// Straight lines beyond the field region, disabled if not positive
+  Gaudi::Property<double> m_fieldRadius{this, "fieldRadius", 0., "Radius of the field region"};
+  Gaudi::Property<double> m_fieldHalfLength{this, "fieldHalfLength", 0., "Half length of the field region"};
+
+  Gaudi::Property<int> m_maxSteps{this, "maxSteps", 1000, "Maximum number of propagation steps"};
+  Gaudi::Property<double> m_mass{this, "mass", 0.13957018, "Mass hypothesis for the propagation (GeV)"};
+
+  Gaudi::Property<int> m_numThreads{this, "numThreads", 1, "Tracks of an event in the ConcurrencySvc arena (1: serial)"};
+  Gaudi::Property<size_t> m_tracksPerTask{this, "tracksPerTask", 8, "Minimum number of tracks per parallel task"};
+  SmartIF<IConcurrencySvc> m_concurrencySvc;
+
+  using FieldPropagator    = Acts::Propagator<Acts::EigenStepper<>>;
+  using StraightPropagator = Acts::Propagator<Acts::StraightLineStepper>;
+
+  /// Parameters on a surface and the path length to it
+  struct Projection {
+    Acts::BoundTrackParameters parameters;
+    double pathLength;
+  };
+
+  SmartIF<IGeoSvc> m_geoSvc;
+  std::optional<FieldPropagator> m_fieldPropagator;
+  std::optional<StraightPropagator> m_straightPropagator;
+  std::vector<std::shared_ptr<const Acts::Surface>> m_surfaces;
+  /// Whether the surface is outside of the field region
+  std::vector<char> m_outside;
+  /// Boundary of the field region: barrel, forward and backward end caps
+  std::shared_ptr<const Acts::Surface> m_fieldBarrel;
+  std::shared_ptr<const Acts::Surface> m_fieldForward;
+  std::shared_ptr<const Acts::Surface> m_fieldBackward;
+
+  Acts::GeometryContext m_geoContext;
+  Acts::MagneticFieldContext m_fieldContext;
+  Acts::PropagatorPlainOptions m_propagatorOptions;
+  std::unique_ptr<const Acts::Logger> m_actsLogger;
+
+public:
+  TrackSurfaceProjector(const std::string& name, ISvcLocator* svcLoc)
+      : MultiTransformer(name, svcLoc, {KeyValue{"inputTrajectories", "inputTrajectories"}},
+                         {KeyValue{"outputTrackSegments", "outputTrackSegments"}}) {}
+
+  StatusCode initialize() override {
+    if (Gaudi::Algorithm::initialize().isFailure()) {
+      return StatusCode::FAILURE;
+    }
+    m_geoSvc = service("GeoSvc");
+    if (!m_geoSvc) {
+      error() << "Unable to locate Geometry Service. "
+              << "Make sure you have GeoSvc and SimSvc in the right order in the configuration." << endmsg;
+      return StatusCode::FAILURE;
+    }
+    if (m_cylinderRadii.size() != m_cylinderHalfLengths.size() || m_discZ.size() != m_discRMin.size() ||
+        m_discZ.size() != m_discRMax.size()) {
+      error() << "Inconsistent cylinder or disc dimensions" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    if (m_tracksPerTask.value() == 0) {
+      error() << "tracksPerTask must be positive" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    if (m_numThreads.value() != 1) {
+      m_concurrencySvc = service("ConcurrencySvc");
+      if (!m_concurrencySvc) {
+        error() << "Unable to locate ConcurrencySvc for numThreads " << m_numThreads.value() << endmsg;
+        return StatusCode::FAILURE;
+      }
+    }
+
+    const bool straightLines = m_fieldRadius.value() > 0. && m_fieldHalfLength.value() > 0.;
+    for (size_t i = 0; i < m_cylinderRadii.size(); ++i) {
+      m_surfaces.push_back(Acts::Surface::makeShared<Acts::CylinderSurface>(
+          Acts::Transform3::Identity(), m_cylinderRadii[i], m_cylinderHalfLengths[i]));
+      m_outside.push_back(straightLines && m_cylinderRadii[i] > m_fieldRadius.value());
+    }
+    for (size_t i = 0; i < m_discZ.size(); ++i) {
+      m_surfaces.push_back(Acts::Surface::makeShared<Acts::DiscSurface>(
+          Acts::Transform3(Acts::Translation3(0., 0., m_discZ[i])), m_discRMin[i], m_discRMax[i]));
+      m_outside.push_back(straightLines && std::abs(m_discZ[i]) > m_fieldHalfLength.value());
+    }
+    if (m_surfaces.empty()) {
+      warning() << "No surfaces to project the tracks to" << endmsg;
+    }
+    if (straightLines) {
+      m_fieldBarrel   = Acts::Surface::makeShared<Acts::CylinderSurface>(Acts::Transform3::Identity(),
+                                                                       m_fieldRadius.value(), m_fieldHalfLength.value());
+      m_fieldForward  = Acts::Surface::makeShared<Acts::DiscSurface>(
+          Acts::Transform3(Acts::Translation3(0., 0., m_fieldHalfLength.value())), 0., m_fieldRadius.value());
+      m_fieldBackward = Acts::Surface::makeShared<Acts::DiscSurface>(
+          Acts::Transform3(Acts::Translation3(0., 0., -m_fieldHalfLength.value())), 0., m_fieldRadius.value());
+    }
+
+    m_fieldPropagator.emplace(Acts::EigenStepper<>(m_geoSvc->getFieldProvider()));
+    m_straightPropagator.emplace(Acts::StraightLineStepper());
+    m_propagatorOptions.maxSteps = m_maxSteps;
+    m_propagatorOptions.mass     = m_mass * Acts::UnitConstants::GeV;
+    m_actsLogger = Jug::makeActsLogger(name(), msgSvc(), msgLevel());
+    return StatusCode::SUCCESS;
+  }
+
+  void operator()(const TrajectoriesContainer& trajectories, eicd::TrackSegmentCollection& segments) const override {
+    // the fitted parameters of the first tip of the trajectories
+    std::vector<const TrackParameters*> tracks;
+    tracks.reserve(trajectories.size());
+    for (const auto& traj : trajectories) {
+      if (!traj.empty() && traj.hasTrackParameters(traj.tips().front())) {
+        tracks.push_back(&traj.trackParameters(traj.tips().front()));
+      }
+    }
+
+    // projections per track and surface, filled in parallel and stored in track order
+    const size_t ntracks = tracks.size();
+    const size_t perTask = m_tracksPerTask.value();
+    const size_t ntasks  = (m_numThreads.value() == 1) ? 1 : std::max<size_t>((ntracks + perTask - 1) / perTask, 1);
+    std::vector<std::vector<std::optional<Projection>>> projections(ntracks);
+    auto project = [&](size_t begin, size_t end) {
+      for (size_t itrack = begin; itrack < end; ++itrack) {
+        projections[itrack] = projectTrack(*tracks[itrack]);
+      }
+    };
+    if (ntasks == 1) {
+      project(0, ntracks);
+    } else {
+      m_concurrencySvc->parallelFor(
+          ntasks, [&](size_t task) { project(task * perTask, std::min(ntracks, (task + 1) * perTask)); });
+    }
+
+    size_t npoints = 0;
+    for (const auto& projection : projections) {
+      auto segment = segments.create();
+      for (const auto& proj : projection) {
+        if (proj) {
+          segment.addToPoints(trackPoint(*proj));
+          ++npoints;
+        }
+      }
+    }
+    if (msgLevel(MSG::DEBUG)) {
+      debug() << ntracks << " tracks projected to " << npoints << " of " << ntracks * m_surfaces.size()
+              << " surfaces" << endmsg;
+    }
+  }
+
+private:
+  const Acts::Logger& logger() const { return *m_actsLogger; }
+
+  template <typename propagator_t>
+  std::optional<Projection> propagate(const propagator_t& propagator, const Acts::BoundTrackParameters& start,
+                                      const Acts::Surface& target) const {
+    Acts::PropagatorOptions<> options(m_geoContext, m_fieldContext, Acts::LoggerWrapper{logger()});
+    options.setPlainOptions(m_propagatorOptions);
+    auto result = propagator.propagate(start, target, options);
+    if (!result.ok() || !result.value().endParameters) {
+      return std::nullopt;
+    }
+    return Projection{std::move(*result.value().endParameters), result.value().pathLength};
+  }
+
+  /// Projections to the surfaces, nullopt for those not reached
+  std::vector<std::optional<Projection>> projectTrack(const TrackParameters& start) const {
+    std::vector<std::optional<Projection>> projection(m_surfaces.size());
+
+    // the exit point of the field region, through the barrel or the end cap of the track direction
+    std::optional<Projection> exit;
+    if (std::find(m_outside.begin(), m_outside.end(), 1) != m_outside.end()) {
+      exit = propagate(*m_fieldPropagator, start, *m_fieldBarrel);
+      if (!exit) {
+        exit = propagate(*m_fieldPropagator, start,
+                         start.momentum().z() > 0. ? *m_fieldForward : *m_fieldBackward);
+      }
+    }
+
+    for (size_t isurf = 0; isurf < m_surfaces.size(); ++isurf) {
+      if (m_outside[isurf] != 0) {
+        if (exit) {
+          projection[isurf] = propagate(*m_straightPropagator, exit->parameters, *m_surfaces[isurf]);
+          if (projection[isurf]) {
+            projection[isurf]->pathLength += exit->pathLength;
+          }
+        }
+      } else {
+        projection[isurf] = propagate(*m_fieldPropagator, start, *m_surfaces[isurf]);
+      }
+    }
+    return projection;
+  }
+
+  eicd::TrackPoint trackPoint(const Projection& proj) const {
+    const auto& pars      = proj.parameters;
+    const auto& parameter = pars.parameters();
+    const auto global     = pars.position(m_geoContext);
+    const auto covariance = pars.covariance().value_or(Acts::BoundSymMatrix::Zero());
+    const eicd::Vector3f position{static_cast<float>(global.x()), static_cast<float>(global.y()),
+                                  static_cast<float>(global.z())};
+    const eicd::Cov3f positionError{0, 0, 0};
+    const eicd::Vector3f momentum = eicd::sphericalToVector(
+        1.0 / std::abs(parameter[Acts::eBoundQOverP]), parameter[Acts::eBoundTheta], parameter[Acts::eBoundPhi]);
+    const eicd::Cov3f covMomentum{static_cast<float>(covariance(Acts::eBoundTheta, Acts::eBoundTheta)),
+                                  static_cast<float>(covariance(Acts::eBoundPhi, Acts::eBoundPhi)),
+                                  static_cast<float>(covariance(Acts::eBoundQOverP, Acts::eBoundQOverP)),
+                                  static_cast<float>(covariance(Acts::eBoundTheta, Acts::eBoundPhi)),
+                                  static_cast<float>(covariance(Acts::eBoundTheta, Acts::eBoundQOverP)),
+                                  static_cast<float>(covariance(Acts::eBoundPhi, Acts::eBoundQOverP))};
+    const float time{static_cast<float>(parameter(Acts::eBoundTime))};
+    const float timeError{std::sqrt(static_cast<float>(covariance(Acts::eBoundTime, Acts::eBoundTime)))};
+    const float theta(parameter[Acts::eBoundTheta]);
+    const float phi(parameter[Acts::eBoundPhi]);
+    const eicd::Cov2f directionError{static_cast<float>(covariance(Acts::eBoundTheta, Acts::eBoundTheta)),
+                                     static_cast<float>(covariance(Acts::eBoundPhi, Acts::eBoundPhi)),
+                                     static_cast<float>(covariance(Acts::eBoundTheta, Acts::eBoundPhi))};
+    const float pathLength      = proj.pathLength;
+    const float pathLengthError = 0;
+    return {position, positionError, momentum, covMomentum, time, timeError, theta, phi, directionError, pathLength,
+            pathLengthError};
+  }
+};
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(TrackSurfaceProjector)
+
+} // namespace Jug::Reco
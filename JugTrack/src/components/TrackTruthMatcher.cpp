@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "Gaudi/Accumulators.h"
+
+#include "Acts/EventData/MultiTrajectory.hpp"
+
+#include "JugBase/IndexSourceLink.hpp"
+#include "JugBase/Transformer.h"
+#include "JugTrack/HitParticleIndex.hpp"
+#include "JugTrack/Trajectories.hpp"
+
+namespace Jug::Reco {
+
+/** Majority truth particle of every track tip of the trajectories.
+ *
+ *  The measurements of the tips are looked up in the HitParticleIndex of HitParticleIndexer and
+ *  counted per particle, in one pass over the track states of the event, for the efficiency and
+ *  fake rate of the tracking (the purity of the matches) in the performance outputs.
+ *
+ * \ingroup tracking
+ */
+class TrackTruthMatcher
+    : public Jug::Transformer<TrackTruthMatchContainer, TrajectoriesContainer, HitParticleIndex> {
+private:
+  mutable Gaudi::Accumulators::Counter<> m_trackCounter{this, "Tracks"};
+  mutable Gaudi::Accumulators::Counter<> m_matchedCounter{this, "Tracks with truth"};
+
+public:
+  TrackTruthMatcher(const std::string& name, ISvcLocator* svcLoc)
+      : MultiTransformer(name, svcLoc,
+                         {KeyValue{"inputTrajectories", "inputTrajectories"},
+                          KeyValue{"inputHitParticleIndex", "inputHitParticleIndex"}},
+                         {KeyValue{"outputTrackTruthMatches", "outputTrackTruthMatches"}}) {}
+
+  void operator()(const TrajectoriesContainer& trajectories, const HitParticleIndex& index,
+                  TrackTruthMatchContainer& matches) const override {
+    MajorityParticleCounter counter(index);
+    for (size_t itraj = 0; itraj < trajectories.size(); ++itraj) {
+      const auto& traj = trajectories[itraj];
+      for (const size_t tip : traj.tips()) {
+        traj.multiTrajectory().visitBackwards(tip, [&](const auto& state) {
+          if (state.typeFlags().test(Acts::TrackStateFlag::MeasurementFlag)) {
+            counter.add(static_cast<const IndexSourceLink&>(state.uncalibrated()).index());
+          }
+        });
+        auto& match      = matches.emplace_back();
+        match.trajectory = itraj;
+        match.trackTip   = tip;
+        counter.take(match);
+        if (match.particle >= 0) {
+          ++m_matchedCounter;
+        }
+      }
+    }
+    m_trackCounter += matches.size();
+    if (msgLevel(MSG::DEBUG)) {
+      debug() << matches.size() << " tracks of " << trajectories.size() << " trajectories matched" << endmsg;
+    }
+  }
+};
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(TrackTruthMatcher)
+
+} // namespace Jug::Reco
@@ -1,18 +1,14 @@
 // SPDX-License-Identifier: LGPL-3.0-or-later
 // Copyright (C) 2022 Whitney Armstrong, Sylvester Joosten, Wouter Deconinck
 
-#include "JugTrack/GeometryContainers.hpp"
+#include "JugBase/GeometryContainers.hpp"
 
 // Gaudi
 #include "Gaudi/Property.h"
-#include "GaudiAlg/GaudiAlgorithm.h"
-#include "GaudiAlg/GaudiTool.h"
-#include "GaudiAlg/Transformer.h"
-#include "GaudiKernel/RndmGenerators.h"
-#include "GaudiKernel/ToolHandle.h"
 
-#include "JugBase/DataHandle.h"
 #include "JugBase/IGeoSvc.h"
+#include "JugBase/SurfaceIndex.h"
+#include "JugBase/Transformer.h"
 
 #include "DD4hep/DD4hepUnits.h"
 #include "DD4hep/Volumes.h"
@@ -26,12 +22,16 @@
 #include "Acts/Plugins/DD4hep/DD4hepDetectorElement.hpp"
 #include "Acts/Surfaces/Surface.hpp"
 
-#include "JugTrack/Index.hpp"
-#include "JugTrack/IndexSourceLink.hpp"
+#include "JugBase/Index.hpp"
+#include "JugBase/IndexSourceLink.hpp"
 #include "JugTrack/Measurement.hpp"
+#include "JugTrack/SpacePoint.hpp"
 
 #include "eicd/TrackerHitCollection.h"
 
+#include <utility>
+#include <vector>
+
 namespace Jug::Reco {
 
 /** Source source Linker.
@@ -39,28 +39,32 @@ namespace Jug::Reco {
  * The source linker creates "source links" which map the hit to the tracking surface.
  * It also creates "measurements" which take the hit information and creates a corresponding
  * "measurement" which contains the covariance matrix and other geometry related hit information.
+ * Optionally (writeSpacePoints) it also writes the global positions of the measurements as space
+ * points, so that seeding does not need to transform the measurements back.
  *
  * \ingroup tracking
  */
-class TrackerSourceLinker : public GaudiAlgorithm {
+class TrackerSourceLinker
+    : public Jug::MultiTransformer<std::tuple<eicd::TrackerHitCollection>,
+                                   std::tuple<IndexSourceLinkStorage, IndexSourceLinkContainer,
+                                              MeasurementContainer, SpacePointContainer>> {
 private:
-  DataHandle<eicd::TrackerHitCollection> m_inputHitCollection{"inputHitCollection", Gaudi::DataHandle::Reader, this};
-  DataHandle<std::list<IndexSourceLink>> m_sourceLinkStorage{"sourceLinkStorage", Gaudi::DataHandle::Writer, this};
-  DataHandle<IndexSourceLinkContainer> m_outputSourceLinks{"outputSourceLinks", Gaudi::DataHandle::Writer, this};
-  DataHandle<MeasurementContainer> m_outputMeasurements{"outputMeasurements", Gaudi::DataHandle::Writer, this};
   /// Pointer to the geometry service
   SmartIF<IGeoSvc> m_geoSvc;
 
+  Gaudi::Property<bool> m_writeSpacePoints{this, "writeSpacePoints", false,
+                                           "Write the space points of the measurements (empty otherwise)"};
+
 public:
-  TrackerSourceLinker(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
-    declareProperty("inputHitCollection", m_inputHitCollection, "");
-    declareProperty("sourceLinkStorage", m_sourceLinkStorage, "");
-    declareProperty("outputSourceLinks", m_outputSourceLinks, "");
-    declareProperty("outputMeasurements", m_outputMeasurements, "");
-  }
+  TrackerSourceLinker(const std::string& name, ISvcLocator* svcLoc)
+      : MultiTransformer(name, svcLoc, {KeyValue{"inputHitCollection", "inputHitCollection"}},
+                         {KeyValue{"sourceLinkStorage", "sourceLinkStorage"},
+                          KeyValue{"outputSourceLinks", "outputSourceLinks"},
+                          KeyValue{"outputMeasurements", "outputMeasurements"},
+                          KeyValue{"outputSpacePoints", "outputSpacePoints"}}) {}
 
   StatusCode initialize() override {
-    if (GaudiAlgorithm::initialize().isFailure()) {
+    if (Gaudi::Algorithm::initialize().isFailure()) {
       return StatusCode::FAILURE;
     }
     m_geoSvc = service("GeoSvc");
@@ -73,88 +77,119 @@ public:
     return StatusCode::SUCCESS;
   }
 
-  StatusCode execute() override {
+  void operator()(const eicd::TrackerHitCollection& hits, IndexSourceLinkStorage& linkStorage,
+                  IndexSourceLinkContainer& sourceLinks, MeasurementContainer& measurements,
+                  SpacePointContainer& spacePoints) const override {
     constexpr double mm_acts = Acts::UnitConstants::mm;
     constexpr double mm_conv = mm_acts / dd4hep::mm; // = 1/0.1
-
-    // input collection
-    const eicd::TrackerHitCollection* hits = m_inputHitCollection.get();
-    // Create output collections
-    auto* linkStorage  = m_sourceLinkStorage.createAndPut();
-    auto* sourceLinks  = m_outputSourceLinks.createAndPut();
-    auto* measurements = m_outputMeasurements.createAndPut();
-    sourceLinks->reserve(hits->size());
-    measurements->reserve(hits->size());
+    // geometry context contains nothing here
+    const Acts::GeometryContext gctx;
 
     if (msgLevel(MSG::DEBUG)) {
-      debug() << (*hits).size() << " hits " << endmsg;
+      debug() << hits.size() << " hits " << endmsg;
     }
-    int ihit = 0;
-    for (const auto& ahit : *hits) {
-
-      Acts::SymMatrix2 cov = Acts::SymMatrix2::Zero();
-      cov(0, 0)            = ahit.getPositionError().xx * mm_acts * mm_acts; // note mm = 1 (Acts)
-      cov(1, 1)            = ahit.getPositionError().yy * mm_acts * mm_acts;
-      if (msgLevel(MSG::DEBUG)) {
-        debug() << "cov matrix:\n" << cov << endmsg;
-      }
-
-      const auto* vol_ctx = m_geoSvc->cellIDPositionConverter()->findContext(ahit.getCellID());
-      auto vol_id = vol_ctx->identifier;
 
-      const auto is = m_geoSvc->surfaceMap().find(vol_id);
-      if (is == m_geoSvc->surfaceMap().end()) {
-        error() << " vol_id (" << vol_id << ")  not found in m_surfaces." << endmsg;
+    // hits with their surfaces, the geometry-ordered hits of a surface are consecutive
+    std::vector<std::pair<size_t, const Jug::Base::SurfaceIndex::Entry*>> onSurface;
+    onSurface.reserve(hits.size());
+    for (size_t i = 0; i < hits.size(); ++i) {
+      const auto* is = m_geoSvc->surfaceIndex().find(hits[i].getCellID());
+      if (is == nullptr || is->surface == nullptr) {
+        error() << " cellID (" << hits[i].getCellID() << ")  not found in m_surfaces." << endmsg;
         continue;
       }
-      const Acts::Surface* surface = is->second;
-      // variable surf_center not used anywhere;
-      // auto surf_center = surface->center(Acts::GeometryContext());
-
-      // transform global position into local coordinates
-      // geometry context contains nothing here
-      Acts::Vector2 pos =
-          surface
-              ->globalToLocal(Acts::GeometryContext(),
-                              {ahit.getPosition().x, ahit.getPosition().y, ahit.getPosition().z}, {0, 0, 0})
-              .value();
-
-      Acts::Vector2 loc     = Acts::Vector2::Zero();
-      loc[Acts::eBoundLoc0] = pos[0];
-      loc[Acts::eBoundLoc1] = pos[1];
-
-      if (msgLevel(MSG::DEBUG)) {
-        auto volman         = m_geoSvc->detector()->volumeManager();
-        auto alignment      = volman.lookupDetElement(vol_id).nominal();
-        auto local_position = (alignment.worldToLocal({ahit.getPosition().x / mm_conv, ahit.getPosition().y / mm_conv,
-                                                       ahit.getPosition().z / mm_conv})) *
-                              mm_conv;
-        debug() << " hit position     : " << ahit.getPosition().x << " " << ahit.getPosition().y << " "
-                << ahit.getPosition().z << endmsg;
-        debug() << " dd4hep loc pos   : " << local_position.x() << " " << local_position.y() << " "
-                << local_position.z() << endmsg;
-        debug() << " surface center   :" << surface->center(Acts::GeometryContext()).transpose() << endmsg;
-        debug() << " acts local center:" << pos.transpose() << endmsg;
-        debug() << " acts loc pos     : " << loc[Acts::eBoundLoc0] << ", " << loc[Acts::eBoundLoc1] << endmsg;
+      onSurface.emplace_back(i, is);
+    }
+
+    // the source link container references the links, so the storage must not reallocate
+    linkStorage.reserve(onSurface.size());
+    measurements.reserve(onSurface.size());
+    if (m_writeSpacePoints) {
+      spacePoints.reserve(onSurface.size());
+    }
+    std::vector<std::reference_wrapper<const IndexSourceLink>> links;
+    links.reserve(onSurface.size());
+
+    // global and local positions of the hits of a surface, one column per hit
+    Eigen::Matrix<double, 3, Eigen::Dynamic> global;
+    Eigen::Matrix<double, 3, Eigen::Dynamic> local;
+    for (size_t begin = 0; begin < onSurface.size();) {
+      const auto* is = onSurface[begin].second;
+      size_t end     = begin + 1;
+      while (end < onSurface.size() && onSurface[end].second == is) {
+        ++end;
+      }
+      const auto n = static_cast<Eigen::Index>(end - begin);
+      global.resize(3, n);
+      for (Eigen::Index j = 0; j < n; ++j) {
+        const auto& p = hits[onSurface[begin + j].first].getPosition();
+        global.col(j) << p.x, p.y, p.z;
+      }
+
+      // transform global positions into local coordinates
+      const Acts::Surface* surface = is->surface;
+      if (surface->type() == Acts::Surface::Plane) {
+        // the local coordinates of a plane are those of its frame, one inverse transform for all hits
+        const Acts::Transform3 toLocal = surface->transform(gctx).inverse();
+        local.noalias()                = toLocal.linear() * global;
+        local.colwise() += toLocal.translation();
+      } else {
+        local.setZero(3, n);
+        for (Eigen::Index j = 0; j < n; ++j) {
+          local.col(j).head<2>() = surface->globalToLocal(gctx, global.col(j), {0, 0, 0}).value();
+        }
       }
 
-      // the measurement container is unordered and the index under which the
-      // measurement will be stored is known before adding it.
-      //
-      // variable hitIdx not used anywhere
-      // Index hitIdx = measurements->size();
-      linkStorage->emplace_back(surface->geometryId(), ihit);
-      IndexSourceLink& sourceLink = linkStorage->back();
-      auto meas                   = Acts::makeMeasurement(sourceLink, loc, cov, Acts::eBoundLoc0, Acts::eBoundLoc1);
-
-      // add to output containers. since the input is already geometry-order,
-      // new elements in geometry containers can just be appended at the end.
-      sourceLinks->emplace_hint(sourceLinks->end(), sourceLink);
-      measurements->emplace_back(std::move(meas));
-
-      ihit++;
+      const auto geoId = surface->geometryId();
+      for (Eigen::Index j = 0; j < n; ++j) {
+        const auto& ahit = hits[onSurface[begin + j].first];
+
+        Acts::SymMatrix2 cov = Acts::SymMatrix2::Zero();
+        cov(0, 0)            = ahit.getPositionError().xx * mm_acts * mm_acts; // note mm = 1 (Acts)
+        cov(1, 1)            = ahit.getPositionError().yy * mm_acts * mm_acts;
+
+        Acts::Vector2 loc     = Acts::Vector2::Zero();
+        loc[Acts::eBoundLoc0] = local(0, j);
+        loc[Acts::eBoundLoc1] = local(1, j);
+
+        if (msgLevel(MSG::DEBUG)) {
+          auto volman         = m_geoSvc->detector()->volumeManager();
+          auto alignment      = volman.lookupDetElement(is->volumeID).nominal();
+          auto local_position = (alignment.worldToLocal({ahit.getPosition().x / mm_conv, ahit.getPosition().y / mm_conv,
+                                                         ahit.getPosition().z / mm_conv})) *
+                                mm_conv;
+          debug() << "cov matrix:\n" << cov << endmsg;
+          debug() << " hit position     : " << ahit.getPosition().x << " " << ahit.getPosition().y << " "
+                  << ahit.getPosition().z << endmsg;
+          debug() << " dd4hep loc pos   : " << local_position.x() << " " << local_position.y() << " "
+                  << local_position.z() << endmsg;
+          debug() << " surface center   :" << surface->center(gctx).transpose() << endmsg;
+          debug() << " acts loc pos     : " << loc[Acts::eBoundLoc0] << ", " << loc[Acts::eBoundLoc1] << endmsg;
+        }
+
+        // the measurement container is unordered and the index under which the
+        // measurement will be stored is known before adding it.
+        const auto& sourceLink = linkStorage.emplace_back(geoId, measurements.size());
+        measurements.emplace_back(Acts::makeMeasurement(sourceLink, loc, cov, Acts::eBoundLoc0, Acts::eBoundLoc1));
+        links.emplace_back(sourceLink);
+
+        if (m_writeSpacePoints) {
+          // variance of r from those of x and y
+          const auto& err   = ahit.getPositionError();
+          const double x2   = global(0, j) * global(0, j);
+          const double y2   = global(1, j) * global(1, j);
+          const double r2   = x2 + y2;
+          const double varR = (r2 > 0.) ? (x2 * err.xx + y2 * err.yy) / r2 : 0.5 * (err.xx + err.yy);
+          spacePoints.push_back({global.col(j) * mm_acts,
+                                 Acts::Vector2(varR * mm_acts * mm_acts, err.zz * mm_acts * mm_acts),
+                                 sourceLink.index(), geoId, ahit.getTime()});
+        }
+      }
+      begin = end;
     }
-    return StatusCode::SUCCESS;
+
+    // since the input is already geometry-ordered this is an ordered range, otherwise it is sorted
+    sourceLinks.insert(links.begin(), links.end());
   }
 };
 // NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "Acts/Geometry/GeometryContext.hpp"
+
+#include "JugBase/Transformer.h"
+#include "JugTrack/Trajectories.hpp"
+#include "JugTrack/TrajectorySummary.hpp"
+
+namespace Jug::Reco {
+
+/** Summaries of the fitted trajectories.
+ *
+ *  Walks the track states of the first tip of every trajectory once, for ParticlesFromTrackFit,
+ *  TrackProjector and the matchers (with useSummaries) that would each walk them again.
+ *
+ * \ingroup tracking
+ */
+class TrajectorySummarizer : public Jug::Transformer<TrajectorySummaryContainer, TrajectoriesContainer> {
+private:
+  Acts::GeometryContext m_geoContext;
+
+public:
+  TrajectorySummarizer(const std::string& name, ISvcLocator* svcLoc)
+      : MultiTransformer(name, svcLoc, {KeyValue{"inputTrajectories", "inputTrajectories"}},
+                         {KeyValue{"outputTrajectorySummaries", "outputTrajectorySummaries"}}) {}
+
+  void operator()(const TrajectoriesContainer& trajectories, TrajectorySummaryContainer& summaries) const override {
+    summaries = summarizeTrajectories(trajectories, m_geoContext);
+    if (msgLevel(MSG::DEBUG)) {
+      debug() << summaries.size() << " of " << trajectories.size() << " trajectories summarized" << endmsg;
+    }
+  }
+};
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(TrajectorySummarizer)
+
+} // namespace Jug::Reco
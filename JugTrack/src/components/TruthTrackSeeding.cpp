@@ -2,6 +2,7 @@
 // Copyright (C) 2022 Whitney Armstrong, Wouter Deconinck, Sylvester Joosten
 
 #include <cmath>
+#include <memory>
 // Gaudi
 #include "GaudiAlg/GaudiAlgorithm.h"
 #include "GaudiKernel/ToolHandle.h"
@@ -13,6 +14,7 @@
 #include "JugBase/DataHandle.h"
 #include "JugBase/IGeoSvc.h"
 #include "JugBase/IParticleSvc.h"
+#include "JugBase/TruthParticleIndex.h"
 #include "JugTrack/Track.hpp"
 
 //#include "Acts/Definitions/Units.hpp"
@@ -39,6 +41,10 @@ namespace Jug::Reco {
                                                                     this};
     DataHandle<eicd::TrackParametersCollection> m_outputTrackParameters{"outputTrackParameters",
                                                                        Gaudi::DataHandle::Writer, this};
+    // Final-state particles and their momenta from the truth index of the event (TruthParticleIndexer),
+    // instead of scanning the MCParticles
+    Gaudi::Property<std::string> m_inputTruthIndex{this, "inputTruthIndex", ""};
+    std::unique_ptr<DataHandle<TruthParticleIndex>> m_truthIndex_ptr;
     SmartIF<IParticleSvc> m_pidSvc;
 
   public:
@@ -62,6 +68,10 @@ namespace Jug::Reco {
                 << endmsg;
         return StatusCode::FAILURE;
       }
+      if (!m_inputTruthIndex.value().empty()) {
+        m_truthIndex_ptr = std::make_unique<DataHandle<TruthParticleIndex>>(m_inputTruthIndex,
+                                                                            Gaudi::DataHandle::Reader, this);
+      }
       return StatusCode::SUCCESS;
     }
 
@@ -70,8 +80,13 @@ namespace Jug::Reco {
       const auto* const mcparts = m_inputMCParticles.get();
       // Create output collections
       auto* init_trk_params = m_outputTrackParameters.createAndPut();
+      // only the final state with the truth index
+      const TruthParticleIndex* truth = m_truthIndex_ptr ? m_truthIndex_ptr->get() : nullptr;
+      const size_t ncandidates        = (truth != nullptr) ? truth->finalState.size() : mcparts->size();
 
-      for(const auto& part : *mcparts) {
+      for (size_t k = 0; k < ncandidates; ++k) {
+        const size_t i   = (truth != nullptr) ? truth->finalState[k] : k;
+        const auto& part = (*mcparts)[i];
 
         // getGeneratorStatus = 1 means thrown G4Primary 
         if(part.getGeneratorStatus() != 1 ) {
@@ -79,14 +94,16 @@ namespace Jug::Reco {
         }
 
         const auto& pvec = part.getMomentum();
-        const auto p = std::hypot(pvec.x, pvec.y, pvec.z);
-        const auto phi = std::atan2(pvec.x, pvec.y);
-        const auto theta = std::atan2(std::hypot(pvec.x, pvec.y), pvec.z);
+        const auto p     = (truth != nullptr) ? static_cast<float>(truth->p[i]) : std::hypot(pvec.x, pvec.y, pvec.z);
+        const auto phi   = (truth != nullptr) ? static_cast<float>(truth->phi[i]) : std::atan2(pvec.y, pvec.x);
+        const auto theta = (truth != nullptr) ? static_cast<float>(truth->theta[i])
+                                              : std::atan2(std::hypot(pvec.x, pvec.y), pvec.z);
 
         // get the particle charge
         // note that we cannot trust the mcparticles charge, as DD4hep
         // sets this value to zero! let's lookup by PDGID instead
-        const auto charge = static_cast<float>(m_pidSvc->particle(part.getPDG()).charge);
+        const auto charge =
+            (truth != nullptr) ? truth->charge[i] : static_cast<float>(m_pidSvc->particle(part.getPDG()).charge);
         if (abs(charge) < std::numeric_limits<double>::epsilon()) {
           continue;
         }
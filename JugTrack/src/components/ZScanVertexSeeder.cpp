@@ -0,0 +1,163 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "Gaudi/Property.h"
+#include "GaudiAlg/GaudiAlgorithm.h"
+#include "GaudiKernel/PhysicalConstants.h"
+
+#include "JugBase/DataHandle.h"
+#include "JugTrack/VertexSeed.hpp"
+
+#include "eicd/TrackerHitCollection.h"
+
+using namespace Gaudi::Units;
+
+namespace Jug::Reco {
+
+/** Primary vertex z from a histogram of the hit pair extrapolations to the beam line.
+ *
+ *  The hits of an inner and an outer tracker layer are paired in azimuth (within maxDeltaPhi,
+ *  the outer hits are indexed by azimuth so that the pairing is linear in the hits at a given
+ *  occupancy). Each pair is extrapolated as a straight line in (r, z) to r = 0, the z of the
+ *  pairs are histogrammed in [zMin, zMax) by binWidth and the vertex is the mean z of the pairs
+ *  in the peak bin and its neighbours. The vertex is not valid with fewer than minEntries pairs
+ *  in the peak, the consumers (TrackParamACTSSeeding, CKFTracking) then keep the origin.
+ *
+ *  \ingroup tracking
+ */
+class ZScanVertexSeeder : public GaudiAlgorithm {
+private:
+  DataHandle<eicd::TrackerHitCollection> m_inputInnerHits{"inputInnerHitCollection", Gaudi::DataHandle::Reader,
+                                                           this};
+  DataHandle<eicd::TrackerHitCollection> m_inputOuterHits{"inputOuterHitCollection", Gaudi::DataHandle::Reader,
+                                                           this};
+  DataHandle<std::vector<double>> m_outputVertex{"outputVertexSeed", Gaudi::DataHandle::Writer, this};
+
+  Gaudi::Property<double> m_zMin{this, "zMin", -250. * mm, "Lower edge of the scan"};
+  Gaudi::Property<double> m_zMax{this, "zMax", 250. * mm, "Upper edge of the scan"};
+  Gaudi::Property<double> m_binWidth{this, "binWidth", 2. * mm, "Bin width of the scan"};
+  Gaudi::Property<double> m_maxDeltaPhi{this, "maxDeltaPhi", 0.02 * rad, "Azimuth window of the hit pairs"};
+  Gaudi::Property<double> m_minEntries{this, "minEntries", 3, "Hit pairs in the peak of a valid vertex"};
+
+  struct Hit {
+    double phi;
+    double r;
+    double z;
+  };
+
+public:
+  ZScanVertexSeeder(const std::string& name, ISvcLocator* svcLoc) : GaudiAlgorithm(name, svcLoc) {
+    declareProperty("inputInnerHitCollection", m_inputInnerHits, "Hits of the inner layer");
+    declareProperty("inputOuterHitCollection", m_inputOuterHits, "Hits of the outer layer");
+    declareProperty("outputVertexSeed", m_outputVertex, "Vertex seed (VertexSeed::encode)");
+  }
+
+  StatusCode initialize() override {
+    if (GaudiAlgorithm::initialize().isFailure()) {
+      return StatusCode::FAILURE;
+    }
+    if (m_zMax.value() <= m_zMin.value() || m_binWidth.value() <= 0.) {
+      error() << "The scan needs zMin < zMax and a positive binWidth" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    return StatusCode::SUCCESS;
+  }
+
+  StatusCode execute() override {
+    const auto inner = hits(*m_inputInnerHits.get());
+    const auto outer = hits(*m_inputOuterHits.get());
+
+    // z at the beam line of the pairs, in the scan range
+    const double zMin = m_zMin.value();
+    const double zMax = m_zMax.value();
+    const double dphi = m_maxDeltaPhi.value();
+    std::vector<double> z0;
+    auto pair = [&](const Hit& h1, double from, double to) {
+      auto it =
+          std::lower_bound(outer.begin(), outer.end(), from, [](const Hit& h, double phi) { return h.phi < phi; });
+      for (; it != outer.end() && it->phi <= to; ++it) {
+        if (it->r <= h1.r) {
+          continue;
+        }
+        const double z = h1.z - h1.r * (it->z - h1.z) / (it->r - h1.r);
+        if (z >= zMin && z < zMax) {
+          z0.push_back(z);
+        }
+      }
+    };
+    for (const auto& h1 : inner) {
+      // the azimuth window, split in two at +-pi
+      const double lo = h1.phi - dphi;
+      const double hi = h1.phi + dphi;
+      if (lo < -M_PI) {
+        pair(h1, lo + 2 * M_PI, M_PI);
+        pair(h1, -M_PI, hi);
+      } else if (hi > M_PI) {
+        pair(h1, lo, M_PI);
+        pair(h1, -M_PI, hi - 2 * M_PI);
+      } else {
+        pair(h1, lo, hi);
+      }
+    }
+
+    const double width = m_binWidth.value();
+    const auto nbins   = static_cast<size_t>(std::ceil((zMax - zMin) / width));
+    std::vector<uint32_t> histogram(nbins, 0);
+    for (const double z : z0) {
+      ++histogram[std::min(nbins - 1, static_cast<size_t>((z - zMin) / width))];
+    }
+
+    VertexSeed vertex;
+    if (!z0.empty()) {
+      const auto peak = static_cast<size_t>(std::max_element(histogram.begin(), histogram.end()) - histogram.begin());
+      // mean of the pairs in the peak and its neighbours
+      const double lo = zMin + (static_cast<double>(peak) - 1.) * width;
+      const double hi = zMin + (static_cast<double>(peak) + 2.) * width;
+      double sum      = 0.;
+      double sum2     = 0.;
+      size_t n        = 0;
+      for (const double z : z0) {
+        if (z >= lo && z < hi) {
+          sum += z;
+          sum2 += z * z;
+          ++n;
+        }
+      }
+      const double mean = sum / n;
+      vertex.z          = mean;
+      vertex.zError     = std::sqrt(std::max(0., sum2 / n - mean * mean) / n);
+      vertex.entries    = static_cast<double>(n);
+      vertex.valid      = (vertex.entries >= m_minEntries.value());
+    }
+    m_outputVertex.put(new std::vector<double>(vertex.encode()));
+
+    if (msgLevel(MSG::DEBUG)) {
+      debug() << "Vertex z = " << vertex.z << " +- " << vertex.zError << " mm from " << vertex.entries << " of "
+              << z0.size() << " hit pairs" << (vertex.valid ? "" : " (not valid)") << endmsg;
+    }
+    return StatusCode::SUCCESS;
+  }
+
+private:
+  /// Cylindrical coordinates of the hits, sorted by azimuth
+  static std::vector<Hit> hits(const eicd::TrackerHitCollection& collection) {
+    std::vector<Hit> out;
+    out.reserve(collection.size());
+    for (const auto& h : collection) {
+      const auto& pos = h.getPosition();
+      out.push_back({std::atan2(pos.y, pos.x), std::hypot(pos.x, pos.y), pos.z});
+    }
+    std::sort(out.begin(), out.end(), [](const Hit& a, const Hit& b) { return a.phi < b.phi; });
+    return out;
+  }
+};
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+DECLARE_COMPONENT(ZScanVertexSeeder)
+
+} // namespace Jug::Reco
@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// Copyright (C) 2022 Wouter Deconinck
+
+#include "JugTrack/HoughAccumulator.hpp"
+
+#include <utility>
+
+#include <cuda_runtime.h>
+
+namespace {
+
+  // one thread per (hit, phi0 bin), the bins are shared by the hits
+  __global__ void fillKernel(const float* x, const float* y, size_t nhits, const double* cosEdge,
+                             const double* sinEdge, int nPhi, int nCurvature, double maxCurvature,
+                             unsigned int* acc) {
+    const size_t n = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+    if (n >= nhits * nPhi) {
+      return;
+    }
+    const size_t ihit = n / nPhi;
+    const int i       = static_cast<int>(n % nPhi);
+    int first         = 0;
+    int last          = -1;
+    Jug::Reco::houghCurvatureBins(cosEdge, sinEdge, nCurvature, maxCurvature, x[ihit], y[ihit], i, first, last);
+    for (int k = first; k <= last; ++k) {
+      atomicAdd(&acc[static_cast<size_t>(i) * nCurvature + k], 1U);
+    }
+  }
+
+  /// Device buffer, freed with the scope
+  template <typename T> struct DeviceBuffer {
+    T* data{nullptr};
+    bool ok{false};
+    explicit DeviceBuffer(size_t n) { ok = (cudaMalloc(&data, (n > 0 ? n : 1) * sizeof(T)) == cudaSuccess); }
+    ~DeviceBuffer() { cudaFree(data); }
+    DeviceBuffer(const DeviceBuffer&)            = delete;
+    DeviceBuffer& operator=(const DeviceBuffer&) = delete;
+  };
+
+} // namespace
+
+namespace Jug::Reco {
+
+  bool houghCUDAAvailable() {
+    int count = 0;
+    return cudaGetDeviceCount(&count) == cudaSuccess && count > 0;
+  }
+
+  bool fillHoughAccumulatorCUDA(const HoughBinning& binning, const std::vector<float>& x, const std::vector<float>& y,
+                                std::vector<uint32_t>& acc) {
+    static_assert(sizeof(unsigned int) == sizeof(uint32_t));
+    const size_t nhits = x.size();
+    DeviceBuffer<float> dx(nhits);
+    DeviceBuffer<float> dy(nhits);
+    DeviceBuffer<double> dcos(binning.cosEdge.size());
+    DeviceBuffer<double> dsin(binning.sinEdge.size());
+    DeviceBuffer<unsigned int> dacc(binning.size());
+    if (!(dx.ok && dy.ok && dcos.ok && dsin.ok && dacc.ok)) {
+      return false;
+    }
+    bool ok = cudaMemcpy(dx.data, x.data(), nhits * sizeof(float), cudaMemcpyHostToDevice) == cudaSuccess &&
+              cudaMemcpy(dy.data, y.data(), nhits * sizeof(float), cudaMemcpyHostToDevice) == cudaSuccess &&
+              cudaMemcpy(dcos.data, binning.cosEdge.data(), binning.cosEdge.size() * sizeof(double),
+                         cudaMemcpyHostToDevice) == cudaSuccess &&
+              cudaMemcpy(dsin.data, binning.sinEdge.data(), binning.sinEdge.size() * sizeof(double),
+                         cudaMemcpyHostToDevice) == cudaSuccess &&
+              cudaMemset(dacc.data, 0, binning.size() * sizeof(unsigned int)) == cudaSuccess;
+    if (!ok) {
+      return false;
+    }
+
+    const size_t nthreads = nhits * binning.nPhi;
+    if (nthreads > 0) {
+      constexpr unsigned block = 256;
+      const auto grid          = static_cast<unsigned>((nthreads + block - 1) / block);
+      fillKernel<<<grid, block>>>(dx.data, dy.data, nhits, dcos.data, dsin.data, binning.nPhi, binning.nCurvature,
+                                  binning.maxCurvature, dacc.data);
+      if (cudaGetLastError() != cudaSuccess || cudaDeviceSynchronize() != cudaSuccess) {
+        return false;
+      }
+    }
+
+    std::vector<uint32_t> result(binning.size());
+    if (cudaMemcpy(result.data(), dacc.data, binning.size() * sizeof(unsigned int), cudaMemcpyDeviceToHost) !=
+        cudaSuccess) {
+      return false;
+    }
+    acc = std::move(result);
+    return true;
+  }
+
+} // namespace Jug::Reco